@@ -0,0 +1,219 @@
+// Measures how fast the source MAC addresses of captured frames can be checked
+// against a large address list: the old way, formatting each address as a
+// string and looking it up in a std::set, a std::set of numeric keys, and
+// AddressSet with and without its Bloom filter, one address at a time and in
+// batches.  Each case is run twice, once with most addresses on the list, as
+// with an allow list, and once with few of them on it, as with a deny list.
+//
+// Usage: AddressFilter_benchmark [list size]
+
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "AddressSet.hpp"
+#include "MacAddress.hpp"
+#include "PosixSocketCommon.hpp"
+
+// Addresses checked per case, each case run this many times
+static const unsigned int LOOKUPS = 1 << 21;
+static const unsigned int PASSES  = 3;
+
+// Bloom filter bits per address
+static const unsigned int FILTER_BITS = 8;
+
+// String lookups are slow, so only this many of them are done
+static const unsigned int STRING_LOOKUPS = 1 << 17;
+
+//==============================================================================
+// Returns a random key the size of a MAC address
+//==============================================================================
+static std::uint64_t randomKey()
+{
+    std::uint64_t key = static_cast<std::uint64_t>(rand()) << 31 ^ rand();
+    return key & 0xffffffffffffULL;
+}
+
+//==============================================================================
+// Prints one line of results
+//==============================================================================
+static void report(const std::string& name,
+                   unsigned int       operations,
+                   double             elapsed,
+                   unsigned long      found)
+{
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::fixed << std::setprecision(2)
+              << std::setw(14) << operations / elapsed / 1.0e6
+              << std::setw(14) << elapsed / operations * 1.0e9
+              << std::setw(12) << found << "\n";
+}
+
+//==============================================================================
+// Times single lookups in 'set' of every address in 'frames', six bytes
+// apart, keeping the best of several passes
+//==============================================================================
+static void runSingle(const std::string&               name,
+                      const AddressSet&                set,
+                      const std::vector<std::uint8_t>& frames)
+{
+    double best = 0.0;
+    unsigned long found = 0;
+    for (unsigned int pass = 0; pass < PASSES; ++pass)
+    {
+        found = 0;
+        double start = PosixSocketCommon::getMonotonicSeconds();
+        for (unsigned int i = 0; i < LOOKUPS; ++i)
+        {
+            found += set.contains(
+                AddressSet::makeMacKey(&frames[i * MacAddress::LENGTH_BYTES]));
+        }
+
+        double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+        best = pass == 0 || elapsed < best ? elapsed : best;
+    }
+    report(name, LOOKUPS, best, found);
+}
+
+//==============================================================================
+// Same as above but gathering keys and looking them up a batch at a time
+//==============================================================================
+static void runBatched(const std::string&               name,
+                       const AddressSet&                set,
+                       const std::vector<std::uint8_t>& frames)
+{
+    static const unsigned int BATCH = 64;
+
+    std::uint64_t keys[BATCH];
+    bool          results[BATCH];
+
+    double best = 0.0;
+    unsigned long found = 0;
+    for (unsigned int pass = 0; pass < PASSES; ++pass)
+    {
+        found = 0;
+        double start = PosixSocketCommon::getMonotonicSeconds();
+        for (unsigned int i = 0; i < LOOKUPS; i += BATCH)
+        {
+            for (unsigned int j = 0; j < BATCH; ++j)
+            {
+                keys[j] = AddressSet::makeMacKey(
+                    &frames[(i + j) * MacAddress::LENGTH_BYTES]);
+            }
+
+            found += set.contains(keys, results, BATCH);
+        }
+
+        double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+        best = pass == 0 || elapsed < best ? elapsed : best;
+    }
+    report(name, LOOKUPS, best, found);
+}
+
+//==============================================================================
+// Runs every case with 'hit_percent' percent of lookups on a list of 'count'
+// addresses
+//==============================================================================
+static void run(unsigned int count, unsigned int hit_percent)
+{
+    srand(46);
+
+    std::vector<std::uint64_t> listed;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        listed.push_back(randomKey());
+    }
+
+    // Addresses as they'd sit in a run of captured frames
+    std::vector<std::uint8_t> frames(LOOKUPS * MacAddress::LENGTH_BYTES);
+    for (unsigned int i = 0; i < LOOKUPS; ++i)
+    {
+        std::uint64_t key = static_cast<unsigned int>(rand() % 100) <
+            hit_percent ? listed[rand() % count] : randomKey();
+        for (unsigned int j = 0; j < MacAddress::LENGTH_BYTES; ++j)
+        {
+            frames[i * MacAddress::LENGTH_BYTES + j] =
+                key >> (8 * (MacAddress::LENGTH_BYTES - 1 - j));
+        }
+    }
+
+    std::cout << "\n" << count << " addresses, " << hit_percent
+              << "% listed\n";
+
+    std::set<std::string> strings;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        std::uint8_t bytes[MacAddress::LENGTH_BYTES];
+        for (unsigned int j = 0; j < MacAddress::LENGTH_BYTES; ++j)
+        {
+            bytes[j] = listed[i] >> (8 * (MacAddress::LENGTH_BYTES - 1 - j));
+        }
+        strings.insert(static_cast<std::string>(MacAddress(bytes)));
+    }
+
+    unsigned long found = 0;
+    double start = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < STRING_LOOKUPS; ++i)
+    {
+        std::uint8_t* bytes = &frames[i * MacAddress::LENGTH_BYTES];
+        found += strings.count(static_cast<std::string>(MacAddress(bytes)));
+    }
+    report("string set",
+           STRING_LOOKUPS,
+           PosixSocketCommon::getMonotonicSeconds() - start,
+           found);
+
+    std::set<std::uint64_t> numbers(listed.begin(), listed.end());
+    found = 0;
+    start = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < LOOKUPS; ++i)
+    {
+        found += numbers.count(
+            AddressSet::makeMacKey(&frames[i * MacAddress::LENGTH_BYTES]));
+    }
+    report("number set",
+           LOOKUPS,
+           PosixSocketCommon::getMonotonicSeconds() - start,
+           found);
+
+    AddressSet plain(count);
+    AddressSet filtered(count, FILTER_BITS);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        plain.insert(listed[i]);
+        filtered.insert(listed[i]);
+    }
+
+    runSingle("AddressSet", plain, frames);
+    runBatched("batched", plain, frames);
+    runSingle("filtered", filtered, frames);
+    runBatched("filtered batch", filtered, frames);
+}
+
+//==============================================================================
+// Runs the benchmark
+//==============================================================================
+int main(int argc, char** argv)
+{
+    if (argc > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [list size]\n";
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(16) << "case" << std::right
+              << std::setw(14) << "Mops/s"
+              << std::setw(14) << "ns/op"
+              << std::setw(12) << "found" << "\n";
+
+    unsigned int count = argc == 2 ? atoi(argv[1]) : 500000;
+
+    run(count, 90);
+    run(count, 1);
+
+    return 0;
+}
@@ -0,0 +1,25 @@
+#if !defined ADDRESS_RESOLVE_HANDLER_HPP
+#define ADDRESS_RESOLVE_HANDLER_HPP
+
+#include <netinet/in.h>
+#include <string>
+
+// Receives the results of lookups an AddressResolver made in the background.
+// Implementations are called from the resolver's worker thread, so anything
+// shared with other threads must be protected accordingly.
+class AddressResolveHandler
+{
+public:
+
+    virtual ~AddressResolveHandler() {}
+
+    // Called once for every resolveAsync() call that had to wait for a
+    // lookup.  If 'resolved' is true, 'address' is the IPv4 address
+    // 'hostname' resolved to; otherwise it couldn't be resolved.  The
+    // resolver's lock isn't held, so calling back into it is fine.
+    virtual void handleResolved(const std::string& hostname,
+                                bool               resolved,
+                                const in_addr&     address) = 0;
+};
+
+#endif
@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+#if defined DEBUG
+#include <iostream>
+#endif
+
+#include "AddressResolver.hpp"
+
+#include "AddressResolveHandler.hpp"
+#include "PosixSocketCommon.hpp"
+
+const double AddressResolver::TTL_DEFAULT          = 60.0;
+const double AddressResolver::NEGATIVE_TTL_DEFAULT = 5.0;
+
+//==============================================================================
+// Starts out knowing nothing; the worker thread isn't started until it's needed
+//==============================================================================
+AddressResolver::AddressResolver(double ttl, double negative_ttl) :
+    ttl(ttl),
+    negative_ttl(negative_ttl),
+    stopping(false),
+    lookup_count(0),
+    hit_count(0)
+{
+}
+
+//==============================================================================
+// Stops the worker thread
+//==============================================================================
+AddressResolver::~AddressResolver()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    queued.notify_one();
+
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+//==============================================================================
+// Resolves a name, looking it up on this thread if need be
+//==============================================================================
+bool AddressResolver::resolve(const std::string& hostname, in_addr& address)
+{
+    if (parseLiteral(hostname, address))
+    {
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        bool resolved = false;
+        if (findCached(hostname, resolved, address))
+        {
+            return resolved;
+        }
+
+        ++lookup_count;
+    }
+
+    // Several threads may end up looking the same name up at once; that's
+    // no worse than before there was a cache, and it's better than making
+    // them all wait on one lookup while holding the lock
+    bool resolved = lookup(hostname, address);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    store(hostname, resolved, address);
+
+    return resolved;
+}
+
+//==============================================================================
+// Resolves a name if that can be done without waiting, and otherwise has the
+// worker thread look it up
+//==============================================================================
+bool AddressResolver::resolveAsync(const std::string&     hostname,
+                                   in_addr&               address,
+                                   AddressResolveHandler* handler)
+{
+    if (parseLiteral(hostname, address))
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    bool resolved = false;
+    if (findCached(hostname, resolved, address))
+    {
+        // A remembered failure is an answer too, just not a useful one
+        return resolved;
+    }
+
+    Cache::iterator entry = cache.find(hostname);
+    if (entry == cache.end())
+    {
+        makeRoom();
+
+        Entry fresh;
+        fresh.resolved       = false;
+        fresh.address.s_addr = INADDR_ANY;
+        fresh.expires        = 0.0;
+        fresh.pending        = false;
+        entry = cache.insert(Cache::value_type(hostname, fresh)).first;
+    }
+
+    if (handler)
+    {
+        entry->second.handlers.push_back(handler);
+    }
+
+    if (!entry->second.pending)
+    {
+        entry->second.pending = true;
+        queue.push_back(hostname);
+
+        if (!worker.joinable())
+        {
+            worker = std::thread(&AddressResolver::lookupLoop, this);
+        }
+
+        queued.notify_one();
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Stops calling a handler
+//==============================================================================
+void AddressResolver::cancel(AddressResolveHandler* handler)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (Cache::iterator i = cache.begin(); i != cache.end(); ++i)
+    {
+        std::vector<AddressResolveHandler*>& handlers = i->second.handlers;
+        for (unsigned int j = 0; j < handlers.size();)
+        {
+            if (handlers[j] == handler)
+            {
+                handlers.erase(handlers.begin() + j);
+            }
+            else
+            {
+                ++j;
+            }
+        }
+    }
+
+    while (std::find(calling.begin(), calling.end(), handler) != calling.end())
+    {
+        handled.wait(lock);
+    }
+}
+
+//==============================================================================
+// Forgets everything that isn't waiting on a lookup
+//==============================================================================
+void AddressResolver::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (Cache::iterator i = cache.begin(); i != cache.end();)
+    {
+        if (i->second.pending)
+        {
+            ++i;
+        }
+        else
+        {
+            i = cache.erase(i);
+        }
+    }
+}
+
+//==============================================================================
+// Returns the number of lookups made
+//==============================================================================
+unsigned long AddressResolver::getLookupCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return lookup_count;
+}
+
+//==============================================================================
+// Returns the number of requests answered from the cache
+//==============================================================================
+unsigned long AddressResolver::getHitCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hit_count;
+}
+
+//==============================================================================
+// Returns the resolver the sockets share, creating it on first use
+//==============================================================================
+AddressResolver& AddressResolver::getShared()
+{
+    static AddressResolver shared;
+    return shared;
+}
+
+//==============================================================================
+// Parses a dotted IPv4 address
+//==============================================================================
+bool AddressResolver::parseLiteral(const std::string& hostname,
+                                   in_addr&           address)
+{
+    return inet_pton(AF_INET, hostname.c_str(), &address) == 1;
+}
+
+//==============================================================================
+// Looks for an unexpired answer
+//==============================================================================
+bool AddressResolver::findCached(const std::string& hostname,
+                                 bool&              resolved,
+                                 in_addr&           address)
+{
+    Cache::const_iterator entry = cache.find(hostname);
+    if (entry == cache.end() ||
+        entry->second.expires <= PosixSocketCommon::getMonotonicSeconds())
+    {
+        return false;
+    }
+
+    ++hit_count;
+
+    resolved = entry->second.resolved;
+    address  = entry->second.address;
+    return true;
+}
+
+//==============================================================================
+// Remembers an answer
+//==============================================================================
+void AddressResolver::store(const std::string& hostname,
+                            bool               resolved,
+                            const in_addr&     address)
+{
+    double expires = PosixSocketCommon::getMonotonicSeconds() +
+        (resolved ? ttl : negative_ttl);
+
+    Cache::iterator entry = cache.find(hostname);
+    if (entry == cache.end())
+    {
+        makeRoom();
+
+        Entry fresh;
+        fresh.resolved = resolved;
+        fresh.address  = address;
+        fresh.expires  = expires;
+        fresh.pending  = false;
+        cache.insert(Cache::value_type(hostname, fresh));
+        return;
+    }
+
+    entry->second.resolved = resolved;
+    entry->second.address  = address;
+    entry->second.expires  = expires;
+}
+
+//==============================================================================
+// Drops expired entries, or everything not waiting on a lookup if there are
+// still too many
+//==============================================================================
+void AddressResolver::makeRoom()
+{
+    if (cache.size() < ENTRIES_MAX)
+    {
+        return;
+    }
+
+    double now = PosixSocketCommon::getMonotonicSeconds();
+    for (Cache::iterator i = cache.begin(); i != cache.end();)
+    {
+        if (!i->second.pending && i->second.expires <= now)
+        {
+            i = cache.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    if (cache.size() >= ENTRIES_MAX)
+    {
+        for (Cache::iterator i = cache.begin(); i != cache.end();)
+        {
+            if (i->second.pending)
+            {
+                ++i;
+            }
+            else
+            {
+                i = cache.erase(i);
+            }
+        }
+    }
+}
+
+//==============================================================================
+// Looks queued names up one at a time until told to stop
+//==============================================================================
+void AddressResolver::lookupLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        while (queue.empty() && !stopping)
+        {
+            queued.wait(lock);
+        }
+
+        if (stopping)
+        {
+            return;
+        }
+
+        std::string hostname = queue.front();
+        queue.pop_front();
+
+        // resolve() may have looked the name up while it sat in the queue
+        Entry&  entry    = cache[hostname];
+        bool    resolved = entry.resolved;
+        in_addr address  = entry.address;
+        if (entry.expires <= PosixSocketCommon::getMonotonicSeconds())
+        {
+            ++lookup_count;
+
+            lock.unlock();
+            resolved = lookup(hostname, address);
+            lock.lock();
+
+            store(hostname, resolved, address);
+        }
+
+        // The entry may have moved while the lock was released
+        Entry& done = cache[hostname];
+        done.pending = false;
+
+        std::vector<AddressResolveHandler*> handlers;
+        handlers.swap(done.handlers);
+        calling = handlers;
+
+        lock.unlock();
+
+        for (unsigned int i = 0; i < handlers.size(); ++i)
+        {
+            handlers[i]->handleResolved(hostname, resolved, address);
+        }
+
+        lock.lock();
+
+        calling.clear();
+        handled.notify_all();
+    }
+}
+
+//==============================================================================
+// Looks a name up
+//==============================================================================
+bool AddressResolver::lookup(const std::string& hostname, in_addr& address)
+{
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+
+    addrinfo* results = 0;
+    int ret = getaddrinfo(hostname.c_str(), 0, &hints, &results);
+    if (ret != 0 || !results)
+    {
+#if defined DEBUG
+        std::cerr << "AddressResolver::lookup: " << gai_strerror(ret) << "\n";
+#endif
+        address.s_addr = INADDR_ANY;
+        return false;
+    }
+
+    address = reinterpret_cast<const sockaddr_in*>(results->ai_addr)->sin_addr;
+
+    freeaddrinfo(results);
+
+    return true;
+}
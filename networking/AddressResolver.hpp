@@ -0,0 +1,167 @@
+#if !defined ADDRESS_RESOLVER_HPP
+#define ADDRESS_RESOLVER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class AddressResolveHandler;
+
+// Resolves host names to IPv4 addresses and remembers the answers, so sockets
+// sending to or connecting to the same hosts over and over pay for a lookup
+// once rather than every time.  Dotted addresses ("10.0.0.1") are parsed
+// directly and never looked up or cached.
+//
+// Answers are kept for a fixed time-to-live, after which the next request
+// looks the name up again.  getaddrinfo() doesn't say how long the records it
+// returns are good for, so the TTL is set here rather than taken from DNS.
+// Names that couldn't be resolved are remembered too, for a shorter time, so
+// a missing host doesn't cost a lookup on every request either.
+//
+// resolve() looks names up on the calling thread when it has to, blocking
+// until the lookup is done.  resolveAsync() never blocks: names not already
+// known are handed to a worker thread, started on first use, and the answer
+// is given to a handler once it's in.
+//
+// The sockets all share the one resolver getShared() returns.  Every member
+// function is thread-safe.
+class AddressResolver
+{
+public:
+
+    // Keeps answers for 'ttl' seconds, and failures for 'negative_ttl'
+    // seconds
+    explicit AddressResolver(double ttl          = TTL_DEFAULT,
+                             double negative_ttl = NEGATIVE_TTL_DEFAULT);
+
+    // Stops the worker thread, waiting for any lookup it's in the middle of.
+    // Handlers waiting on lookups not yet made are never called.
+    ~AddressResolver();
+
+    // Fills in 'address' with the address 'hostname' resolves to, looking it
+    // up if it isn't a dotted address and isn't remembered.  Returns false if
+    // it couldn't be resolved.
+    bool resolve(const std::string& hostname, in_addr& address);
+
+    // Fills in 'address' and returns true if 'hostname' is a dotted address
+    // or its answer is remembered.  Otherwise returns false straight away and
+    // has the worker thread look it up, after which 'handler', if given, is
+    // called with the result; a request with no handler just gets the answer
+    // remembered for later.  'handler' must stay alive until it's been called
+    // or passed to cancel().
+    bool resolveAsync(const std::string&     hostname,
+                      in_addr&               address,
+                      AddressResolveHandler* handler = 0);
+
+    // Makes sure 'handler' won't be called for any lookup still waiting.  If
+    // it's being called right now, waits for it to return, so it mustn't be
+    // called from the handler itself.
+    void cancel(AddressResolveHandler* handler);
+
+    // Forgets every remembered answer
+    void clear();
+
+    // Returns the number of names looked up, whether on a caller's thread or
+    // the worker's
+    unsigned long getLookupCount() const;
+
+    // Returns the number of requests answered from what was remembered
+    unsigned long getHitCount() const;
+
+    // Returns the resolver the sockets use
+    static AddressResolver& getShared();
+
+    // Parses a dotted IPv4 address.  Returns false if 'hostname' isn't one.
+    static bool parseLiteral(const std::string& hostname, in_addr& address);
+
+    // Seconds answers and failures are remembered for by default
+    static const double TTL_DEFAULT;
+    static const double NEGATIVE_TTL_DEFAULT;
+
+    // Most names remembered at once; expired ones are dropped to make room,
+    // and if that isn't enough everything is
+    static const unsigned int ENTRIES_MAX = 4096;
+
+private:
+
+    // What's known about one name
+    struct Entry
+    {
+        bool resolved;
+
+        in_addr address;
+
+        // When this answer stops being good, on the monotonic clock
+        double expires;
+
+        // Whether the worker thread has it queued or is looking it up
+        bool pending;
+
+        // Handlers to call once the worker thread has looked it up
+        std::vector<AddressResolveHandler*> handlers;
+    };
+
+    typedef std::unordered_map<std::string, Entry> Cache;
+
+    // Looks for an unexpired answer.  Must be called with 'mutex' held.
+    // Returns false if there isn't one.
+    bool findCached(const std::string& hostname,
+                    bool&              resolved,
+                    in_addr&           address);
+
+    // Remembers an answer.  Must be called with 'mutex' held.
+    void store(const std::string& hostname,
+               bool               resolved,
+               const in_addr&     address);
+
+    // Makes room for another entry.  Must be called with 'mutex' held.
+    void makeRoom();
+
+    // Body of the worker thread
+    void lookupLoop();
+
+    // Looks a name up with getaddrinfo(), without touching the cache
+    static bool lookup(const std::string& hostname, in_addr& address);
+
+    double ttl;
+
+    double negative_ttl;
+
+    // Guards everything below, the counters included
+    mutable std::mutex mutex;
+
+    Cache cache;
+
+    // Names waiting for the worker thread, oldest first
+    std::deque<std::string> queue;
+
+    // Signalled when a name is queued or the worker should stop
+    std::condition_variable queued;
+
+    // Signalled whenever the worker finishes calling a batch of handlers
+    std::condition_variable handled;
+
+    // The handlers the worker thread is calling right now
+    std::vector<AddressResolveHandler*> calling;
+
+    std::thread worker;
+
+    bool stopping;
+
+    unsigned long lookup_count;
+
+    unsigned long hit_count;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    AddressResolver(const AddressResolver&);
+    AddressResolver& operator=(const AddressResolver&);
+};
+
+#endif
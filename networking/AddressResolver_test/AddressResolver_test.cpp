@@ -0,0 +1,239 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+
+#include "AddressResolver_test.hpp"
+
+#include "AddressResolveHandler.hpp"
+#include "AddressResolver.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+#include "UDPSocket.hpp"
+
+TEST_PROGRAM_MAIN(AddressResolver_test);
+
+// Counts the answers the worker thread hands back
+class AnswerCounter : public AddressResolveHandler
+{
+public:
+
+    AnswerCounter() :
+        answers(0),
+        resolved(0)
+    {
+    }
+
+    virtual void handleResolved(const std::string& /* hostname */,
+                                bool               resolved,
+                                const in_addr&     address)
+    {
+        if (resolved && address.s_addr == htonl(INADDR_LOOPBACK))
+        {
+            ++this->resolved;
+        }
+
+        ++answers;
+    }
+
+    std::atomic<unsigned int> answers;
+
+    std::atomic<unsigned int> resolved;
+};
+
+//==============================================================================
+void AddressResolver_test::addTestCases()
+{
+    ADD_TEST_CASE(Literal);
+    ADD_TEST_CASE(Caching);
+    ADD_TEST_CASE(Expiry);
+    ADD_TEST_CASE(Unresolvable);
+    ADD_TEST_CASE(Async);
+    ADD_TEST_CASE(SendTo);
+}
+
+//==============================================================================
+// Waits up to five seconds for 'counter' to have 'count' answers
+//==============================================================================
+static void waitForAnswers(AnswerCounter& counter, unsigned int count)
+{
+    for (unsigned int i = 0; i < 500 && counter.answers < count; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+//==============================================================================
+Test::Result AddressResolver_test::Literal::body()
+{
+    AddressResolver resolver;
+    AnswerCounter   counter;
+
+    in_addr address;
+    MUST_BE_TRUE(resolver.resolve("10.1.2.3", address));
+    MUST_BE_TRUE(address.s_addr == inet_addr("10.1.2.3"));
+
+    MUST_BE_TRUE(resolver.resolveAsync("192.168.0.1", address, &counter));
+    MUST_BE_TRUE(address.s_addr == inet_addr("192.168.0.1"));
+
+    // Dotted addresses are parsed, not looked up or remembered
+    MUST_BE_TRUE(resolver.getLookupCount() == 0);
+    MUST_BE_TRUE(resolver.getHitCount() == 0);
+    MUST_BE_TRUE(counter.answers == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressResolver_test::Caching::body()
+{
+    AddressResolver resolver;
+
+    in_addr address;
+    MUST_BE_TRUE(resolver.resolve("localhost", address));
+    MUST_BE_TRUE(address.s_addr == htonl(INADDR_LOOPBACK));
+    MUST_BE_TRUE(resolver.getLookupCount() == 1);
+
+    for (unsigned int i = 0; i < 100; ++i)
+    {
+        address.s_addr = 0;
+        MUST_BE_TRUE(resolver.resolve("localhost", address));
+        MUST_BE_TRUE(address.s_addr == htonl(INADDR_LOOPBACK));
+    }
+
+    MUST_BE_TRUE(resolver.getLookupCount() == 1);
+    MUST_BE_TRUE(resolver.getHitCount() == 100);
+
+    // Remembered answers are given out without waiting too
+    MUST_BE_TRUE(resolver.resolveAsync("localhost", address));
+    MUST_BE_TRUE(resolver.getLookupCount() == 1);
+
+    resolver.clear();
+    MUST_BE_TRUE(resolver.resolve("localhost", address));
+    MUST_BE_TRUE(resolver.getLookupCount() == 2);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressResolver_test::Expiry::body()
+{
+    AddressResolver resolver(0.05);
+
+    in_addr address;
+    MUST_BE_TRUE(resolver.resolve("localhost", address));
+    MUST_BE_TRUE(resolver.resolve("localhost", address));
+    MUST_BE_TRUE(resolver.getLookupCount() == 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    MUST_BE_TRUE(resolver.resolve("localhost", address));
+    MUST_BE_TRUE(address.s_addr == htonl(INADDR_LOOPBACK));
+    MUST_BE_TRUE(resolver.getLookupCount() == 2);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressResolver_test::Unresolvable::body()
+{
+    AddressResolver resolver(60.0, 0.05);
+
+    // Failures are remembered too, for their own, shorter time
+    in_addr address;
+    MUST_BE_FALSE(resolver.resolve("no-such-host.invalid", address));
+    MUST_BE_FALSE(resolver.resolve("no-such-host.invalid", address));
+    MUST_BE_TRUE(resolver.getLookupCount() == 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    MUST_BE_FALSE(resolver.resolve("no-such-host.invalid", address));
+    MUST_BE_TRUE(resolver.getLookupCount() == 2);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressResolver_test::Async::body()
+{
+    AddressResolver resolver;
+    AnswerCounter   counter;
+    AnswerCounter   cancelled;
+
+    // Nothing's known yet, so these go to the worker thread.  The repeated
+    // request shares the first one's lookup, unless that's already done.
+    in_addr address;
+    MUST_BE_FALSE(resolver.resolveAsync("localhost", address, &counter));
+    unsigned int waiting =
+        resolver.resolveAsync("localhost", address, &counter) ? 1 : 2;
+    MUST_BE_FALSE(resolver.resolveAsync("no-such-host.invalid",
+                                        address,
+                                        &counter));
+
+    waitForAnswers(counter, waiting + 1);
+    MUST_BE_TRUE(counter.answers == waiting + 1);
+    MUST_BE_TRUE(counter.resolved == waiting);
+    MUST_BE_TRUE(resolver.getLookupCount() == 2);
+
+    // Now the answers are remembered
+    MUST_BE_TRUE(resolver.resolveAsync("localhost", address, &counter));
+    MUST_BE_TRUE(address.s_addr == htonl(INADDR_LOOPBACK));
+    MUST_BE_FALSE(resolver.resolveAsync("no-such-host.invalid", address));
+    MUST_BE_TRUE(resolver.getLookupCount() == 2);
+
+    // A cancelled handler isn't called afterwards, though the lookup still
+    // happens.  The worker may beat the cancel to it, in which case the
+    // cancel waits for the call to finish.
+    resolver.clear();
+    resolver.resolveAsync("localhost", address, &cancelled);
+    resolver.cancel(&cancelled);
+    unsigned int answers_at_cancel = cancelled.answers;
+    if (!resolver.resolveAsync("localhost", address, &counter))
+    {
+        ++waiting;
+    }
+
+    waitForAnswers(counter, waiting + 1);
+    MUST_BE_TRUE(counter.answers == waiting + 1);
+    MUST_BE_TRUE(cancelled.answers == answers_at_cancel);
+    MUST_BE_TRUE(resolver.resolve("localhost", address));
+    MUST_BE_TRUE(resolver.getLookupCount() == 3);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressResolver_test::SendTo::body()
+{
+    unsigned int port = 0;  // Use whatever port is available
+    UDPSocket receiver;
+    MUST_BE_TRUE(receiver.bind(port));
+
+    UDPSocket sender;
+    MUST_BE_TRUE(sender.sendTo("localhost", port));
+
+    // Sending to the same host again, from any socket, doesn't look it up
+    AddressResolver& shared  = AddressResolver::getShared();
+    unsigned long    lookups = shared.getLookupCount();
+
+    UDPSocket other;
+    for (unsigned int i = 0; i < 100; ++i)
+    {
+        MUST_BE_TRUE(sender.sendTo("localhost", port));
+        MUST_BE_TRUE(other.sendTo("localhost", port));
+        MUST_BE_TRUE(sender.sendTo("127.0.0.1", port));
+    }
+
+    MUST_BE_TRUE(shared.getLookupCount() == lookups);
+
+    unsigned char message = 'x';
+    MUST_BE_TRUE(sender.write(&message, 1) == 1);
+    unsigned char received = 0;
+    MUST_BE_TRUE(receiver.read(&received, 1) == 1);
+    MUST_BE_TRUE(received == 'x');
+
+    return Test::PASSED;
+}
@@ -0,0 +1,19 @@
+#if !defined ADDRESS_RESOLVER_TEST
+#define ADDRESS_RESOLVER_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(AddressResolver_test)
+
+    TEST(Literal)
+    TEST(Caching)
+    TEST(Expiry)
+    TEST(Unresolvable)
+    TEST(Async)
+    TEST(SendTo)
+
+TEST_CASES_END(AddressResolver_test)
+
+#endif
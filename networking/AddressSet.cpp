@@ -0,0 +1,379 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "AddressSet.hpp"
+
+#include "Ipv4Address.hpp"
+#include "MacAddress.hpp"
+#include "SlotTags.hpp"
+
+const unsigned int  AddressSet::GROUP_SIZE;
+const std::uint64_t AddressSet::IPV4_KEY;
+
+// Bits each key sets in its filter word.  They're taken six at a time from
+// the top of the hash, clear of the bits picking the word.
+static const unsigned int FILTER_PROBES = 5;
+
+// Batched lookups hash and prefetch this many keys ahead of probing them
+static const unsigned int BATCH_SIZE = 16;
+
+//==============================================================================
+// Allocates every slot, and the filter if there is one, up front
+//==============================================================================
+AddressSet::AddressSet(unsigned int capacity, unsigned int filter_bits) :
+    capacity(capacity),
+    tags(capacity),
+    size(0),
+    filter_mask(0),
+    filter_stale(0)
+{
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("Address set capacity must be at least 1");
+    }
+
+    keys.assign(tags.getSlotCount(), 0);
+
+    if (filter_bits != 0)
+    {
+        unsigned long needed =
+            (static_cast<unsigned long>(capacity) * filter_bits + 63) / 64;
+        unsigned long words = 1;
+        while (words < needed)
+        {
+            words *= 2;
+        }
+
+        filter.assign(words, 0);
+        filter_mask = words - 1;
+    }
+}
+
+//==============================================================================
+AddressSet::~AddressSet()
+{
+}
+
+//==============================================================================
+// Converts the address and calls the key version
+//==============================================================================
+bool AddressSet::insert(const MacAddress& address)
+{
+    return insert(makeKey(address));
+}
+
+//==============================================================================
+// Converts the address and calls the key version
+//==============================================================================
+bool AddressSet::insert(const Ipv4Address& address)
+{
+    return insert(makeKey(address));
+}
+
+//==============================================================================
+// Puts the key in the first free slot on its probe sequence
+//==============================================================================
+bool AddressSet::insert(std::uint64_t key)
+{
+    std::uint64_t hash = hashKey(key);
+
+    if (findSlot(hash, key) != -1)
+    {
+        return true;
+    }
+
+    if (size >= capacity)
+    {
+        return false;
+    }
+
+    // Too many deleted slots make for long probes; clear them out before they
+    // can crowd out the empty ones
+    if (tags.isCrowded(size))
+    {
+        rehash();
+    }
+
+    unsigned int index = tags.findFree(hash);
+    tags.fill(index, hash);
+    keys[index] = key;
+    size++;
+
+    if (!filter.empty())
+    {
+        addToFilter(hash);
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Converts the address and calls the key version
+//==============================================================================
+bool AddressSet::remove(const MacAddress& address)
+{
+    return remove(makeKey(address));
+}
+
+//==============================================================================
+// Converts the address and calls the key version
+//==============================================================================
+bool AddressSet::remove(const Ipv4Address& address)
+{
+    return remove(makeKey(address));
+}
+
+//==============================================================================
+// Frees the key's slot; its filter bits stay set until the next rehash
+//==============================================================================
+bool AddressSet::remove(std::uint64_t key)
+{
+    int index = findSlot(hashKey(key), key);
+    if (index == -1)
+    {
+        return false;
+    }
+
+    tags.erase(index);
+    size--;
+
+    // Once removed keys outnumber the ones left the filter is turning away
+    // too little to be worth having, so start it over
+    if (!filter.empty() && ++filter_stale > size)
+    {
+        rehash();
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Converts the address and calls the key version
+//==============================================================================
+bool AddressSet::contains(const MacAddress& address) const
+{
+    return contains(makeKey(address));
+}
+
+//==============================================================================
+// Converts the address and calls the key version
+//==============================================================================
+bool AddressSet::contains(const Ipv4Address& address) const
+{
+    return contains(makeKey(address));
+}
+
+//==============================================================================
+// Asks the filter first, if there is one, and then the table
+//==============================================================================
+bool AddressSet::contains(std::uint64_t key) const
+{
+    std::uint64_t hash = hashKey(key);
+
+    if (!filter.empty() && !checkFilter(hash))
+    {
+        return false;
+    }
+
+    return findSlot(hash, key) != -1;
+}
+
+//==============================================================================
+// Hashes a batch of keys, prefetching the filter words they'll check, then
+// checks them, prefetching the first group of those that pass, and only then
+// looks those up.  Each stage's cache misses overlap one another rather than
+// each lookup waiting on its own.
+//==============================================================================
+unsigned int AddressSet::contains(const std::uint64_t* keys,
+                                  bool*                results,
+                                  unsigned int         count) const
+{
+    std::uint64_t hashes[BATCH_SIZE];
+    unsigned int  found = 0;
+
+    for (unsigned int first = 0; first < count; first += BATCH_SIZE)
+    {
+        unsigned int batch =
+            count - first < BATCH_SIZE ? count - first : BATCH_SIZE;
+        bool* passed = results + first;
+
+        for (unsigned int i = 0; i < batch; ++i)
+        {
+            hashes[i] = hashKey(keys[first + i]);
+            if (!filter.empty())
+            {
+                __builtin_prefetch(&filter[(hashes[i] >> 7) & filter_mask]);
+            }
+        }
+
+        for (unsigned int i = 0; i < batch; ++i)
+        {
+            passed[i] = filter.empty() || checkFilter(hashes[i]);
+            if (passed[i])
+            {
+                unsigned int group = tags.getFirstGroup(hashes[i]);
+                tags.prefetchGroup(group);
+                __builtin_prefetch(&this->keys[group * GROUP_SIZE]);
+            }
+        }
+
+        for (unsigned int i = 0; i < batch; ++i)
+        {
+            passed[i] = passed[i] && findSlot(hashes[i], keys[first + i]) != -1;
+            found += passed[i];
+        }
+    }
+
+    return found;
+}
+
+//==============================================================================
+// Marks every slot empty and clears the filter
+//==============================================================================
+void AddressSet::clear()
+{
+    tags.clear();
+    filter.assign(filter.size(), 0);
+
+    size         = 0;
+    filter_stale = 0;
+}
+
+//==============================================================================
+// Reads the bytes out of the address
+//==============================================================================
+std::uint64_t AddressSet::makeKey(const MacAddress& address)
+{
+    std::uint64_t key = 0;
+    for (unsigned int i = 0; i < MacAddress::LENGTH_BYTES; ++i)
+    {
+        key = key << 8 | address.getByte(i);
+    }
+
+    return key;
+}
+
+//==============================================================================
+// Marks the address's number as an IPv4 key
+//==============================================================================
+std::uint64_t AddressSet::makeKey(const Ipv4Address& address)
+{
+    return IPV4_KEY | address.toUint32();
+}
+
+//==============================================================================
+// Reads the bytes in network order
+//==============================================================================
+std::uint64_t AddressSet::makeMacKey(const std::uint8_t* bytes)
+{
+    std::uint64_t key = 0;
+    for (unsigned int i = 0; i < MacAddress::LENGTH_BYTES; ++i)
+    {
+        key = key << 8 | bytes[i];
+    }
+
+    return key;
+}
+
+//==============================================================================
+// Reads the bytes in network order and marks the result as an IPv4 key
+//==============================================================================
+std::uint64_t AddressSet::makeIpv4Key(const std::uint8_t* bytes)
+{
+    std::uint64_t key = 0;
+    for (unsigned int i = 0; i < Ipv4Address::LENGTH_BYTES; ++i)
+    {
+        key = key << 8 | bytes[i];
+    }
+
+    return IPV4_KEY | key;
+}
+
+//==============================================================================
+// Walks the probe sequence comparing keys only where tags match
+//==============================================================================
+int AddressSet::findSlot(std::uint64_t hash, std::uint64_t key) const
+{
+    SlotTags::Probe probe(tags, hash);
+    unsigned int    index;
+    while (probe.next(index))
+    {
+        if (keys[index] == key)
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+//==============================================================================
+// Takes every key out and puts it back.  Keys are only eight bytes, so unlike
+// FlowTable this just copies them aside rather than moving them in place.
+//==============================================================================
+void AddressSet::rehash()
+{
+    std::vector<std::uint64_t> live;
+    live.reserve(size);
+    for (unsigned int i = 0; i < keys.size(); ++i)
+    {
+        if (tags.isFull(i))
+        {
+            live.push_back(keys[i]);
+        }
+    }
+
+    clear();
+
+    for (unsigned int i = 0; i < live.size(); ++i)
+    {
+        insert(live[i]);
+    }
+}
+
+//==============================================================================
+// Sets the key's bits in its word
+//==============================================================================
+void AddressSet::addToFilter(std::uint64_t hash)
+{
+    filter[(hash >> 7) & filter_mask] |= getFilterMask(hash);
+}
+
+//==============================================================================
+// Checks the key's bits in its word are all set
+//==============================================================================
+bool AddressSet::checkFilter(std::uint64_t hash) const
+{
+    std::uint64_t mask = getFilterMask(hash);
+    return (filter[(hash >> 7) & filter_mask] & mask) == mask;
+}
+
+//==============================================================================
+// Builds a mask from six-bit bit numbers taken from the top of the hash
+//==============================================================================
+std::uint64_t AddressSet::getFilterMask(std::uint64_t hash)
+{
+    std::uint64_t mask = 0;
+    for (unsigned int i = 0; i < FILTER_PROBES; ++i)
+    {
+        mask |= 1ULL << (hash >> (58 - 6 * i) & 63);
+    }
+
+    return mask;
+}
+
+//==============================================================================
+// Multiplies and folds, as FlowTable does, so every key bit reaches the tag
+// and group bits
+//==============================================================================
+std::uint64_t AddressSet::hashKey(std::uint64_t key)
+{
+    std::uint64_t hash = key * 0x9e3779b97f4a7c15ULL;
+
+    hash ^= hash >> 29;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 32;
+
+    return hash;
+}
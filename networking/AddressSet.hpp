@@ -0,0 +1,170 @@
+#if !defined ADDRESS_SET_HPP
+#define ADDRESS_SET_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "Ipv4Address.hpp"
+#include "MacAddress.hpp"
+#include "SlotTags.hpp"
+
+// A set of MAC and IPv4 addresses, for checking the addresses in captured
+// frames against allow or deny lists of hundreds of thousands of entries.
+//
+// Addresses are kept as 64-bit keys made straight from their raw bytes, so
+// no strings are involved; makeKey() builds keys from MacAddress and
+// Ipv4Address objects, and makeMacKey() and makeIpv4Key() from addresses
+// sitting in a frame.  MAC and IPv4 keys never collide, so one set can hold
+// both kinds.
+//
+// Keys are kept in a fixed-capacity open-addressing table allocated up front,
+// with the same SlotTags bookkeeping as FlowTable: an array of one-byte tags,
+// part hash and part slot state, is searched sixteen slots at a time before
+// any key is compared.  Optionally a Bloom filter sits in front of the
+// table.  It's a small fraction of the table's size, so it stays in cache
+// where the table doesn't, and it turns most addresses that aren't in the set
+// away with one load; it pays for itself when most lookups miss, as with a
+// deny list.
+//
+// Only one thread may change the set at a time, and not while any other
+// thread is looking addresses up.  Any number of threads may look addresses
+// up at once otherwise.
+class AddressSet
+{
+public:
+
+    // Makes room for 'capacity' addresses.  If 'filter_bits' isn't 0 lookups
+    // go through a Bloom filter of about that many bits per address first;
+    // 8 bits turns away all but a few percent of misses.  Throws
+    // std::invalid_argument if 'capacity' is 0.
+    explicit AddressSet(unsigned int capacity, unsigned int filter_bits = 0);
+
+    // Does nothing
+    ~AddressSet();
+
+    // Adds the address or key.  Returns false if the set is full; adding
+    // something already in the set succeeds and changes nothing.
+    bool insert(const MacAddress& address);
+    bool insert(const Ipv4Address& address);
+    bool insert(std::uint64_t key);
+
+    // Removes the address or key.  Returns false if it isn't in the set.
+    bool remove(const MacAddress& address);
+    bool remove(const Ipv4Address& address);
+    bool remove(std::uint64_t key);
+
+    // Returns true if the address or key is in the set
+    bool contains(const MacAddress& address) const;
+    bool contains(const Ipv4Address& address) const;
+    bool contains(std::uint64_t key) const;
+
+    // Looks up 'count' keys at once, storing whether each one is in the set
+    // in 'results'.  Returns the number found.  Hashing runs ahead of the
+    // lookups, fetching what each one will need, so a batch is faster than
+    // the same lookups one at a time when the set doesn't fit in cache.
+    unsigned int contains(const std::uint64_t* keys,
+                          bool*                results,
+                          unsigned int         count) const;
+
+    // Removes every address
+    void clear();
+
+    // Returns the key for an address
+    static std::uint64_t makeKey(const MacAddress& address);
+    static std::uint64_t makeKey(const Ipv4Address& address);
+
+    // Returns the key for the six-byte MAC address or four-byte IPv4 address
+    // at 'bytes', in network byte order as it appears in a frame
+    static std::uint64_t makeMacKey(const std::uint8_t* bytes);
+    static std::uint64_t makeIpv4Key(const std::uint8_t* bytes);
+
+    // Returns the number of addresses in the set
+    unsigned int getSize() const;
+
+    // Returns the number of addresses the set can hold
+    unsigned int getCapacity() const;
+
+    // Returns the number of slots there are, which is more than the capacity
+    // to keep probe sequences short
+    unsigned int getSlotCount() const;
+
+    // Returns the number of bits in the Bloom filter, or 0 if there isn't one
+    unsigned long getFilterBits() const;
+
+    // Tags are searched this many at a time
+    static const unsigned int GROUP_SIZE = SlotTags::GROUP_SIZE;
+
+    // Keys made from IPv4 addresses have this bit set, which keys made from
+    // MAC addresses never do
+    static const std::uint64_t IPV4_KEY = 1ULL << 48;
+
+private:
+
+    // Returns the slot holding the key with the given hash, or -1
+    int findSlot(std::uint64_t hash, std::uint64_t key) const;
+
+    // Puts every key back where a fresh insert would, which clears out all
+    // deleted slots, and rebuilds the filter without any removed keys
+    void rehash();
+
+    // Sets the key's bits in the filter
+    void addToFilter(std::uint64_t hash);
+
+    // Returns false if the key is certainly not in the set
+    bool checkFilter(std::uint64_t hash) const;
+
+    // Returns the filter bits a key sets, all within one word
+    static std::uint64_t getFilterMask(std::uint64_t hash);
+
+    // Mixes a key into a hash; the low bits make the tag
+    static std::uint64_t hashKey(std::uint64_t key);
+
+    unsigned int capacity;
+
+    // Which slots hold keys, and part of each one's hash
+    SlotTags tags;
+
+    std::vector<std::uint64_t> keys;
+
+    unsigned int size;
+
+    // Bloom filter words, empty if there's no filter.  Removed keys stay in
+    // the filter until the next rehash.
+    std::vector<std::uint64_t> filter;
+
+    unsigned int filter_mask;
+
+    // Keys removed since the filter was last built
+    unsigned int filter_stale;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    AddressSet(const AddressSet&);
+    AddressSet& operator=(const AddressSet&);
+};
+
+//==============================================================================
+inline unsigned int AddressSet::getSize() const
+{
+    return size;
+}
+
+//==============================================================================
+inline unsigned int AddressSet::getCapacity() const
+{
+    return capacity;
+}
+
+//==============================================================================
+inline unsigned int AddressSet::getSlotCount() const
+{
+    return tags.getSlotCount();
+}
+
+//==============================================================================
+inline unsigned long AddressSet::getFilterBits() const
+{
+    return filter.size() * 64UL;
+}
+
+#endif
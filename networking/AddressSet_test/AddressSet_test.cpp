@@ -0,0 +1,273 @@
+#include <cstdint>
+#include <cstdlib>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "AddressSet_test.hpp"
+
+#include "AddressSet.hpp"
+#include "Ipv4Address.hpp"
+#include "MacAddress.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(AddressSet_test);
+
+//==============================================================================
+void AddressSet_test::addTestCases()
+{
+    ADD_TEST_CASE(Membership);
+    ADD_TEST_CASE(Keys);
+    ADD_TEST_CASE(Removal);
+    ADD_TEST_CASE(Capacity);
+    ADD_TEST_CASE(Filter);
+    ADD_TEST_CASE(Batch);
+}
+
+//==============================================================================
+// Returns a random key the size of a MAC address
+//==============================================================================
+static std::uint64_t randomKey()
+{
+    std::uint64_t key = static_cast<std::uint64_t>(rand()) << 31 ^ rand();
+    return key & 0xffffffffffffULL;
+}
+
+//==============================================================================
+// Adds and removes random keys in both the set and a std::set, checking the
+// two agree on everything added along the way
+//==============================================================================
+static bool churn(AddressSet& set, unsigned int rounds)
+{
+    std::set<std::uint64_t>    reference;
+    std::vector<std::uint64_t> seen;
+
+    for (unsigned int i = 0; i < rounds; ++i)
+    {
+        if (reference.size() < set.getCapacity() && rand() % 3 != 0)
+        {
+            std::uint64_t key = randomKey();
+            if (!set.insert(key))
+            {
+                return false;
+            }
+
+            reference.insert(key);
+            seen.push_back(key);
+        }
+        else if (!seen.empty())
+        {
+            std::uint64_t key = seen[rand() % seen.size()];
+            if (set.remove(key) != (reference.erase(key) == 1))
+            {
+                return false;
+            }
+        }
+    }
+
+    if (set.getSize() != reference.size())
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < seen.size(); ++i)
+    {
+        if (set.contains(seen[i]) != (reference.count(seen[i]) == 1))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+Test::Result AddressSet_test::Membership::body()
+{
+    AddressSet set(16);
+
+    MUST_BE_TRUE(set.insert(MacAddress("00:1b:21:3a:4f:01")));
+    MUST_BE_TRUE(set.insert(Ipv4Address("192.168.1.20")));
+    MUST_BE_TRUE(set.getSize() == 2);
+
+    MUST_BE_TRUE(set.contains(MacAddress("00:1b:21:3a:4f:01")));
+    MUST_BE_TRUE(set.contains(Ipv4Address("192.168.1.20")));
+    MUST_BE_FALSE(set.contains(MacAddress("00:1b:21:3a:4f:02")));
+    MUST_BE_FALSE(set.contains(Ipv4Address("192.168.1.21")));
+
+    // Adding something twice is fine and only keeps one copy
+    MUST_BE_TRUE(set.insert(Ipv4Address("192.168.1.20")));
+    MUST_BE_TRUE(set.getSize() == 2);
+
+    set.clear();
+    MUST_BE_TRUE(set.getSize() == 0);
+    MUST_BE_FALSE(set.contains(MacAddress("00:1b:21:3a:4f:01")));
+    MUST_BE_FALSE(set.contains(Ipv4Address("192.168.1.20")));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressSet_test::Keys::body()
+{
+    const std::uint8_t frame[] = {0x00, 0x1b, 0x21, 0x3a, 0x4f, 0x01,
+                                  0x0a, 0x00, 0x00, 0x01};
+
+    MUST_BE_TRUE(AddressSet::makeKey(MacAddress("00:1b:21:3a:4f:01")) ==
+                 0x001b213a4f01ULL);
+    MUST_BE_TRUE(AddressSet::makeMacKey(frame) == 0x001b213a4f01ULL);
+
+    MUST_BE_TRUE(AddressSet::makeKey(Ipv4Address("10.0.0.1")) ==
+                 (AddressSet::IPV4_KEY | 0x0a000001));
+    MUST_BE_TRUE(AddressSet::makeIpv4Key(frame + 6) ==
+                 AddressSet::makeKey(Ipv4Address("10.0.0.1")));
+
+    // A MAC address ending in the same bytes as an IPv4 address is a
+    // different key
+    AddressSet set(16);
+    set.insert(Ipv4Address("10.0.0.1"));
+    MUST_BE_FALSE(set.contains(MacAddress("00:00:0a:00:00:01")));
+    MUST_BE_TRUE(set.contains(AddressSet::makeIpv4Key(frame + 6)));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressSet_test::Removal::body()
+{
+    srand(46);
+
+    AddressSet set(1000);
+
+    MUST_BE_TRUE(set.insert(0x1234));
+    MUST_BE_TRUE(set.remove(0x1234));
+    MUST_BE_FALSE(set.remove(0x1234));
+    MUST_BE_FALSE(set.contains(0x1234));
+    MUST_BE_TRUE(set.getSize() == 0);
+
+    // Enough churn to fill the table with deleted slots several times over
+    MUST_BE_TRUE(churn(set, 50000));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressSet_test::Capacity::body()
+{
+    AddressSet set(100);
+    MUST_BE_TRUE(set.getCapacity() == 100);
+    MUST_BE_TRUE(set.getSlotCount() >= 100);
+    MUST_BE_TRUE(set.getSlotCount() % AddressSet::GROUP_SIZE == 0);
+    MUST_BE_TRUE(set.getFilterBits() == 0);
+
+    for (std::uint64_t key = 0; key < 100; ++key)
+    {
+        MUST_BE_TRUE(set.insert(key));
+    }
+
+    MUST_BE_FALSE(set.insert(100));
+    MUST_BE_TRUE(set.insert(99));
+    MUST_BE_TRUE(set.remove(0));
+    MUST_BE_TRUE(set.insert(100));
+    MUST_BE_TRUE(set.getSize() == 100);
+
+    bool thrown = false;
+    try
+    {
+        AddressSet empty(0);
+    }
+    catch (std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    MUST_BE_TRUE(thrown);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressSet_test::Filter::body()
+{
+    srand(46);
+
+    AddressSet set(100000, 8);
+    MUST_BE_TRUE(set.getFilterBits() >= 800000);
+
+    // The filter never turns away anything in the set
+    std::vector<std::uint64_t> keys;
+    for (unsigned int i = 0; i < 100000; ++i)
+    {
+        keys.push_back(randomKey());
+        MUST_BE_TRUE(set.insert(keys.back()));
+    }
+
+    for (unsigned int i = 0; i < keys.size(); ++i)
+    {
+        MUST_BE_TRUE(set.contains(keys[i]));
+    }
+
+    // Removing most of the keys rebuilds the filter without them
+    for (unsigned int i = 0; i < 90000; ++i)
+    {
+        MUST_BE_TRUE(set.remove(keys[i]));
+    }
+
+    for (unsigned int i = 0; i < keys.size(); ++i)
+    {
+        MUST_BE_TRUE(set.contains(keys[i]) == (i >= 90000));
+    }
+
+    set.clear();
+    MUST_BE_TRUE(churn(set, 50000));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result AddressSet_test::Batch::body()
+{
+    srand(46);
+
+    AddressSet plain(5000);
+    AddressSet filtered(5000, 8);
+
+    std::vector<std::uint64_t> keys;
+    for (unsigned int i = 0; i < 5000; ++i)
+    {
+        keys.push_back(randomKey());
+        plain.insert(keys.back());
+        filtered.insert(keys.back());
+    }
+
+    // Half in the set and half not, and not a whole number of batches
+    std::vector<std::uint64_t> queries;
+    for (unsigned int i = 0; i < 2003; ++i)
+    {
+        queries.push_back(i % 2 ? keys[rand() % keys.size()] : randomKey());
+    }
+
+    bool results[2003];
+    unsigned int expected = 0;
+    for (unsigned int i = 0; i < queries.size(); ++i)
+    {
+        expected += plain.contains(queries[i]);
+    }
+
+    MUST_BE_TRUE(plain.contains(&queries[0], results, queries.size()) ==
+                 expected);
+    for (unsigned int i = 0; i < queries.size(); ++i)
+    {
+        MUST_BE_TRUE(results[i] == plain.contains(queries[i]));
+    }
+
+    MUST_BE_TRUE(filtered.contains(&queries[0], results, queries.size()) ==
+                 expected);
+    for (unsigned int i = 0; i < queries.size(); ++i)
+    {
+        MUST_BE_TRUE(results[i] == plain.contains(queries[i]));
+    }
+
+    MUST_BE_TRUE(plain.contains(&queries[0], results, 0) == 0);
+
+    return Test::PASSED;
+}
@@ -0,0 +1,19 @@
+#if !defined ADDRESS_SET_TEST
+#define ADDRESS_SET_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(AddressSet_test)
+
+    TEST(Membership)
+    TEST(Keys)
+    TEST(Removal)
+    TEST(Capacity)
+    TEST(Filter)
+    TEST(Batch)
+
+TEST_CASES_END(AddressSet_test)
+
+#endif
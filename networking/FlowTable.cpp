@@ -0,0 +1,525 @@
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "FlowTable.hpp"
+
+#include "EthernetIIHeader.hpp"
+#include "Ipv4Header.hpp"
+#include "Ipv4HeaderView.hpp"
+#include "PosixTimespec.hpp"
+#include "SlotTags.hpp"
+#include "TcpHeader.hpp"
+#include "TcpHeaderView.hpp"
+#include "UdpHeader.hpp"
+#include "UdpHeaderView.hpp"
+
+const unsigned int FlowTable::GROUP_SIZE;
+
+//==============================================================================
+// Converts a timestamp to nanoseconds since the epoch
+//==============================================================================
+static std::int64_t toNanoseconds(const PosixTimespec& timestamp)
+{
+    return static_cast<std::int64_t>(timestamp.getSeconds()) * 1000000000 +
+        timestamp.getNanoseconds();
+}
+
+//==============================================================================
+// Converts nanoseconds since the epoch to a timestamp
+//==============================================================================
+static PosixTimespec toTimespec(std::int64_t nanoseconds)
+{
+    return PosixTimespec(static_cast<time_t>(nanoseconds / 1000000000),
+                         static_cast<long>(nanoseconds % 1000000000));
+}
+
+//==============================================================================
+// Allocates every slot up front
+//==============================================================================
+FlowTable::FlowTable(unsigned int capacity) :
+    capacity(capacity),
+    tags(capacity),
+    flow_count(0),
+    rehash_sequence(0),
+    sweep_position(0),
+    rejected_count(0)
+{
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("Flow table capacity must be at least 1");
+    }
+
+    unsigned int slot_count = tags.getSlotCount();
+    std::vector<Slot>(slot_count).swap(slots);
+    for (unsigned int i = 0; i < slot_count; ++i)
+    {
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+        slots[i].live.store(false, std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================
+FlowTable::~FlowTable()
+{
+}
+
+//==============================================================================
+// Finds the IPv4 packet in an Ethernet II frame
+//==============================================================================
+bool FlowTable::update(const std::uint8_t*  frame,
+                       unsigned int         size,
+                       const PosixTimespec& timestamp)
+{
+    if (size < EthernetIIHeader::LENGTH_BYTES ||
+        (frame[12] << 8 | frame[13]) != EthernetIIHeader::IPV4)
+    {
+        return false;
+    }
+
+    return updateIpv4(frame + EthernetIIHeader::LENGTH_BYTES,
+                      size - EthernetIIHeader::LENGTH_BYTES,
+                      timestamp);
+}
+
+//==============================================================================
+// Pulls the flow out of an IPv4 packet
+//==============================================================================
+bool FlowTable::updateIpv4(const std::uint8_t*  packet,
+                           unsigned int         size,
+                           const PosixTimespec& timestamp)
+{
+    if (size < Ipv4Header::LENGTH_BYTES)
+    {
+        return false;
+    }
+
+    Ipv4HeaderView ipv4(packet);
+    unsigned int header_length = ipv4.getHeaderLengthBytes();
+    unsigned int total_length  = ipv4.getTotalLength();
+
+    if (ipv4.getVersion() != 4 ||
+        header_length < Ipv4Header::LENGTH_BYTES ||
+        header_length > size ||
+        total_length < header_length)
+    {
+        return false;
+    }
+
+    std::uint16_t source_port      = 0;
+    std::uint16_t destination_port = 0;
+    std::uint16_t tcp_flags        = 0;
+
+    // Captures may be cut short, so look only as far as what's there
+    unsigned int payload_size =
+        (total_length < size ? total_length : size) - header_length;
+
+    if (ipv4.getFragmentOffset() == 0)
+    {
+        if (ipv4.getProtocol() == Ipv4Header::TCP &&
+            payload_size >= TcpHeader::LENGTH_BYTES)
+        {
+            TcpHeaderView tcp(ipv4.getPayload());
+            source_port      = tcp.getSourcePort();
+            destination_port = tcp.getDestinationPort();
+            tcp_flags        = tcp.getFlags();
+        }
+        else if (ipv4.getProtocol() == Ipv4Header::UDP &&
+                 payload_size >= UdpHeader::LENGTH_BYTES)
+        {
+            UdpHeaderView udp(ipv4.getPayload());
+            source_port      = udp.getSourcePort();
+            destination_port = udp.getDestinationPort();
+        }
+    }
+
+    return update(ipv4.getSource(),
+                  ipv4.getDestination(),
+                  source_port,
+                  destination_port,
+                  ipv4.getProtocol(),
+                  total_length,
+                  tcp_flags,
+                  timestamp);
+}
+
+//==============================================================================
+// Counts a packet against its flow, adding the flow if it's new
+//==============================================================================
+bool FlowTable::update(std::uint32_t        source,
+                       std::uint32_t        destination,
+                       std::uint16_t        source_port,
+                       std::uint16_t        destination_port,
+                       std::uint8_t         protocol,
+                       unsigned int         bytes,
+                       std::uint16_t        tcp_flags,
+                       const PosixTimespec& timestamp)
+{
+    std::uint32_t ports = static_cast<std::uint32_t>(source_port) << 16 |
+        destination_port;
+    std::uint64_t hash  = hashKey(source, destination, ports, protocol);
+    std::int64_t  now   = toNanoseconds(timestamp);
+
+    int index = findSlot(hash, source, destination, ports, protocol);
+    if (index != -1)
+    {
+        // Only this thread writes, so plain loads of the current values are
+        // fine; readers are kept out by the odd sequence number
+        Slot& slot = slots[index];
+        std::uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.protocol_flags.store(
+            slot.protocol_flags.load(std::memory_order_relaxed) | tcp_flags,
+            std::memory_order_relaxed);
+        slot.packets.store(slot.packets.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+        slot.bytes.store(slot.bytes.load(std::memory_order_relaxed) + bytes,
+                         std::memory_order_relaxed);
+        slot.last_seen.store(now, std::memory_order_relaxed);
+
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        return true;
+    }
+
+    if (flow_count.load(std::memory_order_relaxed) >= capacity)
+    {
+        rejected_count++;
+        return false;
+    }
+
+    // Too many deleted slots make for long probes; clear them out before they
+    // can crowd out the empty ones
+    if (tags.isCrowded(flow_count.load(std::memory_order_relaxed)))
+    {
+        rehash();
+    }
+
+    unsigned int free_index = tags.findFree(hash);
+
+    Flow flow;
+    flow.source           = source;
+    flow.destination      = destination;
+    flow.source_port      = source_port;
+    flow.destination_port = destination_port;
+    flow.protocol         = protocol;
+    flow.tcp_flags        = tcp_flags;
+    flow.packets          = 1;
+    flow.bytes            = bytes;
+    flow.first_seen       = timestamp;
+    flow.last_seen        = timestamp;
+
+    writeSlot(slots[free_index], flow);
+    tags.fill(free_index, hash);
+
+    flow_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+//==============================================================================
+// Looks up a flow
+//==============================================================================
+bool FlowTable::find(std::uint32_t source,
+                     std::uint32_t destination,
+                     std::uint16_t source_port,
+                     std::uint16_t destination_port,
+                     std::uint8_t  protocol,
+                     Flow&         flow) const
+{
+    std::uint32_t ports = static_cast<std::uint32_t>(source_port) << 16 |
+        destination_port;
+
+    int index = findSlot(hashKey(source, destination, ports, protocol),
+                         source,
+                         destination,
+                         ports,
+                         protocol);
+    if (index == -1)
+    {
+        return false;
+    }
+
+    readSlot(slots[index], flow);
+    return true;
+}
+
+//==============================================================================
+// Expires idle flows from the next stretch of the table
+//==============================================================================
+unsigned int FlowTable::sweep(const PosixTimespec& now,
+                              double               idle_timeout,
+                              unsigned int         count)
+{
+    std::int64_t now_ns  = toNanoseconds(now);
+    std::int64_t idle_ns = static_cast<std::int64_t>(idle_timeout * 1e9);
+
+    unsigned int removed = 0;
+    for (unsigned int i = 0; i < count && i < slots.size(); ++i)
+    {
+        unsigned int index = sweep_position;
+        sweep_position = (sweep_position + 1) % slots.size();
+
+        if (tags.isFull(index) &&
+            now_ns - slots[index].last_seen.load(std::memory_order_relaxed) >
+                idle_ns)
+        {
+            eraseSlot(index);
+            removed++;
+        }
+    }
+
+    return removed;
+}
+
+//==============================================================================
+// Copies out every flow
+//==============================================================================
+void FlowTable::snapshot(std::vector<Flow>& flows) const
+{
+    while (true)
+    {
+        // A rehash takes a while, so let the updating thread get on with it
+        std::uint32_t sequence =
+            rehash_sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        flows.clear();
+        flows.reserve(getFlowCount());
+
+        Flow flow;
+        for (unsigned int i = 0; i < slots.size(); ++i)
+        {
+            if (readSlot(slots[i], flow))
+            {
+                flows.push_back(flow);
+            }
+        }
+
+        // Flows moved while the copy was under way may have been passed over
+        // or copied twice
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (rehash_sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return;
+        }
+    }
+}
+
+//==============================================================================
+// Walks a probe sequence looking for a flow
+//==============================================================================
+int FlowTable::findSlot(std::uint64_t hash,
+                        std::uint32_t source,
+                        std::uint32_t destination,
+                        std::uint32_t ports,
+                        std::uint8_t  protocol) const
+{
+    SlotTags::Probe probe(tags, hash);
+    unsigned int    index;
+    while (probe.next(index))
+    {
+        const Slot& slot = slots[index];
+        if (slot.source.load(std::memory_order_relaxed) == source &&
+            slot.destination.load(std::memory_order_relaxed) == destination &&
+            slot.ports.load(std::memory_order_relaxed) == ports &&
+            slot.protocol_flags.load(std::memory_order_relaxed) >> 16 ==
+                protocol)
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+//==============================================================================
+// Puts every flow back where a fresh insert would, in place
+//==============================================================================
+void FlowTable::rehash()
+{
+    std::uint32_t sequence = rehash_sequence.load(std::memory_order_relaxed);
+    rehash_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // From here on DELETED marks a flow that hasn't been put back yet, and
+    // everything else is free
+    tags.beginRehash();
+
+    Flow flow;
+    Flow displaced;
+    unsigned int i = 0;
+    while (i < slots.size())
+    {
+        if (tags.get(i) != SlotTags::DELETED)
+        {
+            ++i;
+            continue;
+        }
+
+        readSlot(slots[i], flow);
+        std::uint64_t hash = hashKey(
+            flow.source,
+            flow.destination,
+            static_cast<std::uint32_t>(flow.source_port) << 16 |
+                flow.destination_port,
+            flow.protocol);
+        std::uint8_t tag    = hash & 0x7f;
+        unsigned int target = tags.findFree(hash);
+
+        // Already in the first group with room for it
+        if (target / GROUP_SIZE == i / GROUP_SIZE)
+        {
+            tags.set(i, tag);
+            ++i;
+            continue;
+        }
+
+        if (tags.get(target) == SlotTags::EMPTY)
+        {
+            writeSlot(slots[target], flow);
+            tags.set(target, tag);
+            clearSlot(slots[i]);
+            tags.set(i, SlotTags::EMPTY);
+            ++i;
+        }
+        else
+        {
+            // The target holds another flow waiting to be put back; swap and
+            // deal with that one next without moving on
+            readSlot(slots[target], displaced);
+            writeSlot(slots[target], flow);
+            tags.set(target, tag);
+            writeSlot(slots[i], displaced);
+        }
+    }
+
+    tags.endRehash();
+
+    rehash_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//==============================================================================
+// Writes a whole flow under its sequence counter
+//==============================================================================
+void FlowTable::writeSlot(Slot& slot, const Flow& flow)
+{
+    std::uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.source.store(flow.source, std::memory_order_relaxed);
+    slot.destination.store(flow.destination, std::memory_order_relaxed);
+    slot.ports.store(static_cast<std::uint32_t>(flow.source_port) << 16 |
+                         flow.destination_port,
+                     std::memory_order_relaxed);
+    slot.protocol_flags.store(static_cast<std::uint32_t>(flow.protocol) << 16 |
+                                  flow.tcp_flags,
+                              std::memory_order_relaxed);
+    slot.packets.store(flow.packets, std::memory_order_relaxed);
+    slot.bytes.store(flow.bytes, std::memory_order_relaxed);
+    slot.first_seen.store(toNanoseconds(flow.first_seen),
+                          std::memory_order_relaxed);
+    slot.last_seen.store(toNanoseconds(flow.last_seen),
+                         std::memory_order_relaxed);
+    slot.live.store(true, std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//==============================================================================
+// Marks a slot as holding no flow, under its sequence counter
+//==============================================================================
+void FlowTable::clearSlot(Slot& slot)
+{
+    std::uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.live.store(false, std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//==============================================================================
+// Reads a whole flow, retrying until it gets a copy no write overlapped
+//==============================================================================
+bool FlowTable::readSlot(const Slot& slot, Flow& flow) const
+{
+    while (true)
+    {
+        std::uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            continue;
+        }
+
+        bool live = slot.live.load(std::memory_order_relaxed);
+
+        std::uint32_t ports = slot.ports.load(std::memory_order_relaxed);
+        std::uint32_t protocol_flags =
+            slot.protocol_flags.load(std::memory_order_relaxed);
+
+        std::int64_t first_seen =
+            slot.first_seen.load(std::memory_order_relaxed);
+        std::int64_t last_seen =
+            slot.last_seen.load(std::memory_order_relaxed);
+
+        flow.source      = slot.source.load(std::memory_order_relaxed);
+        flow.destination = slot.destination.load(std::memory_order_relaxed);
+        flow.packets     = slot.packets.load(std::memory_order_relaxed);
+        flow.bytes       = slot.bytes.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+        {
+            continue;
+        }
+
+        flow.source_port      = ports >> 16;
+        flow.destination_port = ports & 0xffff;
+        flow.protocol         = protocol_flags >> 16;
+        flow.tcp_flags        = protocol_flags & 0xffff;
+        flow.first_seen       = toTimespec(first_seen);
+        flow.last_seen        = toTimespec(last_seen);
+        return live;
+    }
+}
+
+//==============================================================================
+// Takes a flow out of the table
+//==============================================================================
+void FlowTable::eraseSlot(unsigned int index)
+{
+    clearSlot(slots[index]);
+    tags.erase(index);
+
+    flow_count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+// Mixes the key into 64 bits
+//==============================================================================
+std::uint64_t FlowTable::hashKey(std::uint32_t source,
+                                 std::uint32_t destination,
+                                 std::uint32_t ports,
+                                 std::uint8_t  protocol)
+{
+    std::uint64_t hash =
+        (static_cast<std::uint64_t>(source) << 32 | destination) *
+        0x9e3779b97f4a7c15ULL;
+    hash ^= (static_cast<std::uint64_t>(ports) << 8 | protocol) *
+        0xc2b2ae3d27d4eb4fULL;
+
+    hash ^= hash >> 29;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 32;
+
+    return hash;
+}
@@ -0,0 +1,221 @@
+#if !defined FLOW_TABLE_HPP
+#define FLOW_TABLE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "PosixTimespec.hpp"
+#include "SlotTags.hpp"
+
+// Keeps packet and byte counts, first and last seen times and the TCP flags
+// seen for every IPv4 flow (source and destination address and port, and
+// protocol) in the traffic it's given, typically frames from a RawSocket.
+//
+// Flows are kept in a fixed-capacity open-addressing table allocated up front.
+// Alongside the flows is a SlotTags array of one-byte tags, part hash and part
+// slot state, which lookups search sixteen at a time before touching any
+// flow, so a lookup usually costs one tag load and one flow comparison.  Flows that have gone idle are removed by sweep(), which
+// works through a bounded number of slots per call.
+//
+// Only one thread may call update(), find() and sweep().  Any number of other
+// threads may call snapshot() at the same time; each flow is guarded by a
+// sequence counter so readers never block the updating thread and never see a
+// flow half-updated.  Now and then update() moves every flow to clear out
+// slots left by removed flows; a whole-table sequence counter around that
+// makes any snapshot() overlapping it start again, so a snapshot never has a
+// flow twice or misses one that was in the table throughout.
+class FlowTable
+{
+public:
+
+    // Everything known about one flow.  Addresses are in host byte order.
+    struct Flow
+    {
+        std::uint32_t source;
+        std::uint32_t destination;
+        std::uint16_t source_port;
+        std::uint16_t destination_port;
+        std::uint8_t  protocol;
+
+        // Every TCP flag seen on the flow, as TcpHeader::Flag bits
+        std::uint16_t tcp_flags;
+
+        std::uint64_t packets;
+
+        // IPv4 bytes, headers included
+        std::uint64_t bytes;
+
+        PosixTimespec first_seen;
+        PosixTimespec last_seen;
+    };
+
+    // Makes room for 'capacity' flows at once
+    explicit FlowTable(unsigned int capacity);
+
+    // Does nothing
+    ~FlowTable();
+
+    // Accounts for an Ethernet II frame seen at 'timestamp'.  Returns false if
+    // it isn't IPv4, is malformed or belongs to a new flow the table has no
+    // room for.
+    bool update(const std::uint8_t*  frame,
+                unsigned int         size,
+                const PosixTimespec& timestamp);
+
+    // Same as above for a packet starting with its IPv4 header.  Fragments
+    // other than the first carry no ports and are counted against a flow
+    // with both ports set to zero.
+    bool updateIpv4(const std::uint8_t*  packet,
+                    unsigned int         size,
+                    const PosixTimespec& timestamp);
+
+    // Accounts for one packet of the given flow directly
+    bool update(std::uint32_t        source,
+                std::uint32_t        destination,
+                std::uint16_t        source_port,
+                std::uint16_t        destination_port,
+                std::uint8_t         protocol,
+                unsigned int         bytes,
+                std::uint16_t        tcp_flags,
+                const PosixTimespec& timestamp);
+
+    // Copies out the given flow; returns false if it isn't in the table
+    bool find(std::uint32_t source,
+              std::uint32_t destination,
+              std::uint16_t source_port,
+              std::uint16_t destination_port,
+              std::uint8_t  protocol,
+              Flow&         flow) const;
+
+    // Removes flows not seen for 'idle_timeout' seconds as of 'now' from the
+    // next 'count' slots of the table, carrying on from where the last call
+    // left off, so that calling this regularly with a small count spreads the
+    // cost of expiry evenly.  Returns the number of flows removed.
+    unsigned int sweep(const PosixTimespec& now,
+                       double               idle_timeout,
+                       unsigned int         count = GROUP_SIZE * 4);
+
+    // Replaces the contents of 'flows' with a copy of every flow in the table.
+    // Safe to call from any thread at any time.
+    void snapshot(std::vector<Flow>& flows) const;
+
+    // Returns the number of flows in the table
+    unsigned int getFlowCount() const;
+
+    // Returns the number of flows the table can hold
+    unsigned int getCapacity() const;
+
+    // Returns the number of packets turned away for want of room
+    unsigned long getRejectedCount() const;
+
+    // Returns the number of slots there are, which is more than the capacity
+    // to keep probe sequences short
+    unsigned int getSlotCount() const;
+
+    // Tags are searched this many at a time
+    static const unsigned int GROUP_SIZE = SlotTags::GROUP_SIZE;
+
+private:
+
+    // One flow, laid out so sequence-counted reads from other threads are
+    // well defined.  Ports are packed source high, destination low, and the
+    // protocol sits above the TCP flags.
+    struct Slot
+    {
+        // Odd while the flow is being written
+        std::atomic<std::uint32_t> sequence;
+
+        std::atomic<std::uint32_t> source;
+        std::atomic<std::uint32_t> destination;
+        std::atomic<std::uint32_t> ports;
+        std::atomic<std::uint32_t> protocol_flags;
+        std::atomic<bool>          live;
+
+        std::atomic<std::uint64_t> packets;
+        std::atomic<std::uint64_t> bytes;
+
+        // Nanoseconds since the epoch
+        std::atomic<std::int64_t> first_seen;
+        std::atomic<std::int64_t> last_seen;
+    };
+
+    // Returns the slot holding the given flow, or -1
+    int findSlot(std::uint64_t hash,
+                 std::uint32_t source,
+                 std::uint32_t destination,
+                 std::uint32_t ports,
+                 std::uint8_t  protocol) const;
+
+    // Moves every flow back to where a fresh insert would put it, which clears
+    // out all deleted slots.  'rehash_sequence' is odd while it's at it.
+    void rehash();
+
+    // Writes a whole flow under the slot's sequence counter, for inserting
+    // and moving flows
+    void writeSlot(Slot& slot, const Flow& flow);
+
+    // Marks a slot as holding no flow, under its sequence counter
+    void clearSlot(Slot& slot);
+
+    // Reads a whole flow, retrying until no write overlapped the read;
+    // returns false if the slot holds no flow
+    bool readSlot(const Slot& slot, Flow& flow) const;
+
+    // Takes the flow in the given slot out of the table
+    void eraseSlot(unsigned int index);
+
+    // Mixes a flow's key into a hash; the low bits make the tag
+    static std::uint64_t hashKey(std::uint32_t source,
+                                 std::uint32_t destination,
+                                 std::uint32_t ports,
+                                 std::uint8_t  protocol);
+
+    unsigned int capacity;
+
+    // Which slots hold flows, and part of each one's hash
+    SlotTags tags;
+
+    std::vector<Slot> slots;
+
+    std::atomic<unsigned int> flow_count;
+
+    // Odd while rehash() is moving flows around; snapshots overlapping a
+    // change in it are retried
+    std::atomic<std::uint32_t> rehash_sequence;
+
+    unsigned int sweep_position;
+
+    unsigned long rejected_count;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    FlowTable(const FlowTable&);
+    FlowTable& operator=(const FlowTable&);
+};
+
+//==============================================================================
+inline unsigned int FlowTable::getFlowCount() const
+{
+    return flow_count.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+inline unsigned int FlowTable::getCapacity() const
+{
+    return capacity;
+}
+
+//==============================================================================
+inline unsigned long FlowTable::getRejectedCount() const
+{
+    return rejected_count;
+}
+
+//==============================================================================
+inline unsigned int FlowTable::getSlotCount() const
+{
+    return tags.getSlotCount();
+}
+
+#endif
@@ -0,0 +1,418 @@
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "FlowTable_test.hpp"
+
+#include "EthernetIIHeader.hpp"
+#include "FlowTable.hpp"
+#include "Ipv4Header.hpp"
+#include "PosixTimespec.hpp"
+#include "TcpHeader.hpp"
+#include "UdpHeader.hpp"
+
+#include "TestMacros.hpp"
+#include "misc.hpp"
+
+TEST_PROGRAM_MAIN(FlowTable_test);
+
+//==============================================================================
+void FlowTable_test::addTestCases()
+{
+    ADD_TEST_CASE(Counts);
+    ADD_TEST_CASE(Frames);
+    ADD_TEST_CASE(Sweep);
+    ADD_TEST_CASE(Capacity);
+    ADD_TEST_CASE(Snapshot);
+    ADD_TEST_CASE(SnapshotDuringRehash);
+}
+
+//==============================================================================
+// Builds an Ethernet II frame holding an IPv4 packet from 10.0.0.1 to
+// 10.0.0.2 with the given transport header and 'payload' bytes after it
+//==============================================================================
+static std::vector<std::uint8_t> makeFrame(std::uint8_t      protocol,
+                                           const DataPacket& transport,
+                                           unsigned int      payload)
+{
+    unsigned int ipv4_length =
+        Ipv4Header::LENGTH_BYTES + transport.getLengthBytes() + payload;
+
+    EthernetIIHeader ethernet(EthernetIIHeader::IPV4);
+
+    Ipv4Header ipv4(protocol);
+    ipv4.setTotalLength(ipv4_length);
+    *ipv4.getSource()      = "10.0.0.1";
+    *ipv4.getDestination() = "10.0.0.2";
+
+    std::vector<std::uint8_t> frame(EthernetIIHeader::LENGTH_BYTES +
+                                    ipv4_length);
+    std::uint8_t* position = &frame[0];
+    position += ethernet.writeRaw(position, misc::ENDIAN_BIG) / BITS_PER_BYTE;
+    position += ipv4.writeRaw(position, misc::ENDIAN_BIG) / BITS_PER_BYTE;
+    transport.writeRaw(position, misc::ENDIAN_BIG);
+
+    return frame;
+}
+
+//==============================================================================
+Test::Result FlowTable_test::Counts::body()
+{
+    const unsigned int FLOWS = 1000;
+
+    FlowTable table(FLOWS);
+    MUST_BE_TRUE(table.getCapacity() == FLOWS);
+    MUST_BE_TRUE(table.getSlotCount() > FLOWS);
+
+    // Flow i gets i % 5 + 1 packets of 100 bytes, one a second
+    for (unsigned int round = 0; round < 5; ++round)
+    {
+        for (unsigned int i = 0; i < FLOWS; ++i)
+        {
+            if (round <= i % 5)
+            {
+                std::uint16_t flags = round == 0 ? TcpHeader::SYN :
+                    TcpHeader::ACK;
+                MUST_BE_TRUE(table.update(0x0a000000 + i, 0x0a0000ff,
+                                          40000 + i, 80, Ipv4Header::TCP,
+                                          100, flags,
+                                          PosixTimespec(round, 0)));
+            }
+        }
+    }
+
+    MUST_BE_TRUE(table.getFlowCount() == FLOWS);
+
+    for (unsigned int i = 0; i < FLOWS; ++i)
+    {
+        FlowTable::Flow flow;
+        MUST_BE_TRUE(table.find(0x0a000000 + i, 0x0a0000ff, 40000 + i, 80,
+                                Ipv4Header::TCP, flow));
+
+        unsigned int packets = i % 5 + 1;
+        MUST_BE_TRUE(flow.packets == packets);
+        MUST_BE_TRUE(flow.bytes == packets * 100);
+        MUST_BE_TRUE(flow.first_seen == PosixTimespec(0, 0));
+        MUST_BE_TRUE(flow.last_seen == PosixTimespec(packets - 1, 0));
+        MUST_BE_TRUE(flow.source_port == 40000 + i);
+        MUST_BE_TRUE(flow.destination_port == 80);
+
+        std::uint16_t flags = packets > 1 ? TcpHeader::SYN | TcpHeader::ACK :
+            TcpHeader::SYN;
+        MUST_BE_TRUE(flow.tcp_flags == flags);
+    }
+
+    // Any part of the key being different makes it a different flow
+    FlowTable::Flow flow;
+    MUST_BE_FALSE(table.find(0x0a000000, 0x0a0000ff, 40000, 80,
+                             Ipv4Header::UDP, flow));
+    MUST_BE_FALSE(table.find(0x0a000000, 0x0a0000ff, 80, 40000,
+                             Ipv4Header::TCP, flow));
+    MUST_BE_FALSE(table.find(0x0a0000ff, 0x0a000000, 40000, 80,
+                             Ipv4Header::TCP, flow));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result FlowTable_test::Frames::body()
+{
+    FlowTable table(16);
+    PosixTimespec now(100, 0);
+
+    TcpHeader tcp(50000, 443);
+    tcp.setFlags(TcpHeader::SYN | TcpHeader::ECE | TcpHeader::CWR);
+    std::vector<std::uint8_t> tcp_frame = makeFrame(Ipv4Header::TCP, tcp, 0);
+    MUST_BE_TRUE(table.update(&tcp_frame[0], tcp_frame.size(), now));
+
+    UdpHeader udp(5353, 53);
+    std::vector<std::uint8_t> udp_frame = makeFrame(Ipv4Header::UDP, udp, 32);
+    MUST_BE_TRUE(table.update(&udp_frame[0], udp_frame.size(), now));
+    MUST_BE_TRUE(table.update(&udp_frame[0], udp_frame.size(), now));
+
+    FlowTable::Flow flow;
+    MUST_BE_TRUE(table.find(0x0a000001, 0x0a000002, 50000, 443,
+                            Ipv4Header::TCP, flow));
+    MUST_BE_TRUE(flow.tcp_flags ==
+                 (TcpHeader::SYN | TcpHeader::ECE | TcpHeader::CWR));
+    MUST_BE_TRUE(flow.bytes == Ipv4Header::LENGTH_BYTES +
+                 TcpHeader::LENGTH_BYTES);
+
+    MUST_BE_TRUE(table.find(0x0a000001, 0x0a000002, 5353, 53,
+                            Ipv4Header::UDP, flow));
+    MUST_BE_TRUE(flow.packets == 2);
+    MUST_BE_TRUE(flow.bytes == 2 * (Ipv4Header::LENGTH_BYTES +
+                                    UdpHeader::LENGTH_BYTES + 32));
+
+    // A capture cut short still counts every byte the packet had, and the
+    // ports are still there to be read
+    MUST_BE_TRUE(table.update(&udp_frame[0], udp_frame.size() - 32, now));
+    MUST_BE_TRUE(table.find(0x0a000001, 0x0a000002, 5353, 53,
+                            Ipv4Header::UDP, flow));
+    MUST_BE_TRUE(flow.packets == 3);
+
+    // Later fragments have no ports
+    std::vector<std::uint8_t> fragment = udp_frame;
+    fragment[EthernetIIHeader::LENGTH_BYTES + 7] = 5;
+    MUST_BE_TRUE(table.update(&fragment[0], fragment.size(), now));
+    MUST_BE_TRUE(table.find(0x0a000001, 0x0a000002, 0, 0,
+                            Ipv4Header::UDP, flow));
+
+    // Things that aren't IPv4 or aren't whole aren't counted
+    EthernetIIHeader arp(EthernetIIHeader::ARP);
+    std::uint8_t arp_frame[64] = {0};
+    arp.writeRaw(arp_frame, misc::ENDIAN_BIG);
+    MUST_BE_FALSE(table.update(arp_frame, sizeof(arp_frame), now));
+    MUST_BE_FALSE(table.update(&udp_frame[0], 20, now));
+    MUST_BE_FALSE(table.update(&udp_frame[0], 33, now));
+
+    MUST_BE_TRUE(table.getFlowCount() == 3);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result FlowTable_test::Sweep::body()
+{
+    FlowTable table(200);
+
+    // Half the flows go quiet at 0 seconds, the others at 5
+    for (unsigned int i = 0; i < 200; ++i)
+    {
+        MUST_BE_TRUE(table.update(i, 0, 1, 2, Ipv4Header::UDP, 64, 0,
+                                  PosixTimespec(i % 2 * 5, 0)));
+    }
+
+    // Sweeping a few slots at a time gets around the whole table eventually
+    unsigned int removed = 0;
+    for (unsigned int i = 0; i < table.getSlotCount(); i += 8)
+    {
+        removed += table.sweep(PosixTimespec(8, 0), 7.0, 8);
+    }
+
+    MUST_BE_TRUE(removed == 100);
+    MUST_BE_TRUE(table.getFlowCount() == 100);
+
+    FlowTable::Flow flow;
+    for (unsigned int i = 0; i < 200; ++i)
+    {
+        MUST_BE_TRUE(table.find(i, 0, 1, 2, Ipv4Header::UDP, flow) ==
+                     (i % 2 == 1));
+    }
+
+    // A flow that's heard from again stays
+    MUST_BE_TRUE(table.update(1, 0, 1, 2, Ipv4Header::UDP, 64, 0,
+                              PosixTimespec(14, 0)));
+    MUST_BE_TRUE(table.sweep(PosixTimespec(15, 0), 7.0,
+                             table.getSlotCount()) == 99);
+    MUST_BE_TRUE(table.find(1, 0, 1, 2, Ipv4Header::UDP, flow));
+    MUST_BE_TRUE(flow.packets == 2);
+    MUST_BE_TRUE(table.getFlowCount() == 1);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result FlowTable_test::Capacity::body()
+{
+    const unsigned int FLOWS  = 100;
+    const unsigned int ROUNDS = 50;
+
+    FlowTable table(FLOWS);
+
+    // The table holds exactly what it was asked to
+    for (unsigned int i = 0; i < FLOWS; ++i)
+    {
+        MUST_BE_TRUE(table.update(i, 0, 0, 0, Ipv4Header::TCP, 40, 0,
+                                  PosixTimespec(0, 0)));
+    }
+
+    MUST_BE_FALSE(table.update(FLOWS, 0, 0, 0, Ipv4Header::TCP, 40, 0,
+                               PosixTimespec(0, 0)));
+    MUST_BE_TRUE(table.getRejectedCount() == 1);
+
+    // Existing flows still update when it's full
+    MUST_BE_TRUE(table.update(0, 0, 0, 0, Ipv4Header::TCP, 40, 0,
+                              PosixTimespec(0, 0)));
+
+    // Churn through generations of flows, which leaves deleted slots behind
+    // for the table to clean up; every flow should still be found
+    for (unsigned int round = 1; round <= ROUNDS; ++round)
+    {
+        table.sweep(PosixTimespec(round, 0), 0.5, table.getSlotCount());
+        MUST_BE_TRUE(table.getFlowCount() == 0);
+
+        for (unsigned int i = 0; i < FLOWS; ++i)
+        {
+            MUST_BE_TRUE(table.update(round * FLOWS + i, 0, 0, 0,
+                                      Ipv4Header::TCP, 40, 0,
+                                      PosixTimespec(round, 0)));
+        }
+
+        FlowTable::Flow flow;
+        for (unsigned int i = 0; i < FLOWS; ++i)
+        {
+            MUST_BE_TRUE(table.find(round * FLOWS + i, 0, 0, 0,
+                                    Ipv4Header::TCP, flow));
+            MUST_BE_TRUE(flow.packets == 1);
+        }
+
+        MUST_BE_FALSE(table.find((round - 1) * FLOWS, 0, 0, 0,
+                                 Ipv4Header::TCP, flow));
+    }
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result FlowTable_test::Snapshot::body()
+{
+    const unsigned int FLOWS  = 1000;
+    const unsigned int ROUNDS = 200;
+
+    FlowTable table(FLOWS * 2);
+
+    std::atomic<bool> done(false);
+    std::atomic<bool> consistent(true);
+    std::atomic<unsigned int> snapshots(0);
+
+    // Every packet is 100 bytes, so bytes is always 100 times packets in any
+    // copy of a flow that wasn't torn by an update
+    std::thread exporter([&]()
+    {
+        std::vector<FlowTable::Flow> flows;
+        while (!done)
+        {
+            table.snapshot(flows);
+            for (unsigned int i = 0; i < flows.size(); ++i)
+            {
+                if (flows[i].bytes != flows[i].packets * 100 ||
+                    flows[i].last_seen < flows[i].first_seen ||
+                    flows[i].destination != flows[i].source + 1)
+                {
+                    consistent = false;
+                }
+            }
+
+            snapshots++;
+        }
+    });
+
+    for (unsigned int round = 0; round < ROUNDS; ++round)
+    {
+        for (unsigned int i = 0; i < FLOWS; ++i)
+        {
+            // Keys shift now and then so flows come and go
+            std::uint32_t source = i + round / 20 * FLOWS;
+            table.update(source, source + 1, 1, 2, Ipv4Header::UDP, 100, 0,
+                         PosixTimespec(round, i));
+        }
+
+        table.sweep(PosixTimespec(round, 0), 5.0, table.getSlotCount() / 4);
+    }
+
+    // Make sure the exporter had a go at least once while updates were going
+    // on and once after
+    while (snapshots < 2)
+    {
+        std::this_thread::yield();
+    }
+
+    done = true;
+    exporter.join();
+
+    std::cout << snapshots << " snapshots taken\n";
+    MUST_BE_TRUE(consistent);
+
+    std::vector<FlowTable::Flow> flows;
+    table.snapshot(flows);
+    MUST_BE_TRUE(flows.size() == table.getFlowCount());
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result FlowTable_test::SnapshotDuringRehash::body()
+{
+    const unsigned int STEADY = 1000;
+    const unsigned int CHURN  = 1000;
+    const unsigned int ROUNDS = 500;
+
+    // Full enough that removed flows leave deleted slots behind, so the table
+    // is rehashed every few rounds, moving the steady flows around
+    FlowTable table(STEADY + CHURN);
+
+    std::atomic<bool> done(false);
+    std::atomic<bool> complete(true);
+    std::atomic<unsigned int> snapshots(0);
+
+    // The steady flows, sources 0 to STEADY - 1, are in the table from the
+    // first round on, so every snapshot after that has each of them once
+    std::thread exporter([&]()
+    {
+        std::vector<FlowTable::Flow> flows;
+        std::vector<unsigned int>    seen(STEADY);
+        while (!done)
+        {
+            table.snapshot(flows);
+
+            seen.assign(STEADY, 0);
+            for (unsigned int i = 0; i < flows.size(); ++i)
+            {
+                if (flows[i].source < STEADY)
+                {
+                    seen[flows[i].source]++;
+                }
+            }
+
+            for (unsigned int i = 0; i < STEADY; ++i)
+            {
+                if (seen[i] != 1)
+                {
+                    complete = false;
+                }
+            }
+
+            snapshots++;
+        }
+    });
+
+    for (unsigned int i = 0; i < STEADY; ++i)
+    {
+        table.update(i, 0, 1, 2, Ipv4Header::UDP, 100, 0, PosixTimespec(0, 0));
+    }
+
+    for (unsigned int round = 1; round < ROUNDS; ++round)
+    {
+        for (unsigned int i = 0; i < STEADY; ++i)
+        {
+            table.update(i, 0, 1, 2, Ipv4Header::UDP, 100, 0,
+                         PosixTimespec(round, 0));
+        }
+
+        // A new set of short-lived flows each round, replacing the last
+        // round's
+        table.sweep(PosixTimespec(round, 0), 0.5, table.getSlotCount());
+        for (unsigned int i = 0; i < CHURN; ++i)
+        {
+            table.update(STEADY + round * CHURN + i, 0, 1, 2,
+                         Ipv4Header::UDP, 100, 0, PosixTimespec(round, 0));
+        }
+    }
+
+    while (snapshots < 2)
+    {
+        std::this_thread::yield();
+    }
+
+    done = true;
+    exporter.join();
+
+    std::cout << snapshots << " snapshots taken\n";
+    MUST_BE_TRUE(complete);
+    MUST_BE_TRUE(table.getRejectedCount() == 0);
+
+    return Test::PASSED;
+}
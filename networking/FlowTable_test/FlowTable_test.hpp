@@ -0,0 +1,19 @@
+#if !defined FLOW_TABLE_TEST
+#define FLOW_TABLE_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(FlowTable_test)
+
+    TEST(Counts)
+    TEST(Frames)
+    TEST(Sweep)
+    TEST(Capacity)
+    TEST(Snapshot)
+    TEST(SnapshotDuringRehash)
+
+TEST_CASES_END(FlowTable_test)
+
+#endif
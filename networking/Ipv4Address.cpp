@@ -75,6 +75,28 @@ Ipv4Address& Ipv4Address::operator=(const Ipv4Address& ipv4_address)
     return *this;
 }
 
+//==============================================================================
+std::uint32_t Ipv4Address::toUint32() const
+{
+    std::uint32_t address = 0;
+    for (unsigned int i = 0; i < LENGTH_BYTES; i++)
+    {
+        address = address << 8 | getByte(i);
+    }
+
+    return address;
+}
+
+//==============================================================================
+void Ipv4Address::fromUint32(std::uint32_t address)
+{
+    for (unsigned int i = 0; i < LENGTH_BYTES; i++)
+    {
+        setByte(LENGTH_BYTES - 1 - i, static_cast<std::uint8_t>(address));
+        address >>= 8;
+    }
+}
+
 //==============================================================================
 std::ostream& operator<<(std::ostream& os, const Ipv4Address& ipv4_address)
 {
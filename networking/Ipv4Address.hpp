@@ -1,6 +1,7 @@
 #if !defined IPV4_ADDRESS_HPP
 #define IPV4_ADDRESS_HPP
 
+#include <cstdint>
 #include <istream>
 #include <ostream>
 #include <string>
@@ -35,6 +36,11 @@ public:
     Ipv4Address& operator=(const std::string& ipv4_address_str);
     Ipv4Address& operator=(const Ipv4Address&);
 
+    // Conversion to and from a 32-bit number in host byte order, so that
+    // "1.2.3.4" is 0x01020304
+    std::uint32_t toUint32() const;
+    void fromUint32(std::uint32_t address);
+
     // IPv4 addresses are this many bytes long
     static const unsigned short LENGTH_BYTES = 4;
 
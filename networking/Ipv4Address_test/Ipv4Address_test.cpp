@@ -16,6 +16,7 @@ TEST_PROGRAM_MAIN(Ipv4Address_test);
 void Ipv4Address_test::addTestCases()
 {
     ADD_TEST_CASE(Operators);
+    ADD_TEST_CASE(Conversion);
 }
 
 //==============================================================================
@@ -82,3 +83,16 @@ Test::Result Ipv4Address_test::Operators::NotEqualTo::body()
 
     return Test::PASSED;
 }
+
+//==============================================================================
+Test::Result Ipv4Address_test::Conversion::body()
+{
+    Ipv4Address ipv4_address("1.2.200.210");
+    MUST_BE_TRUE(ipv4_address.toUint32() == 0x0102c8d2);
+
+    ipv4_address.fromUint32(0xc0a80001);
+    MUST_BE_TRUE(ipv4_address == "192.168.0.1");
+    MUST_BE_TRUE(ipv4_address.toUint32() == 0xc0a80001);
+
+    return Test::PASSED;
+}
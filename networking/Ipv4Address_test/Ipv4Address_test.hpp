@@ -14,6 +14,8 @@ TEST_CASES_BEGIN(Ipv4Address_test)
 
     TEST_CASES_END(Operators)
 
+    TEST(Conversion)
+
 TEST_CASES_END(Ipv4Address_test)
 
 #endif
@@ -0,0 +1,61 @@
+#include <cstdint>
+
+#include "Ipv4Header.hpp"
+#include "misc.hpp"
+
+//==============================================================================
+// Initializes version to 4 and header length to 5 (no options), everything else
+// to 0
+//==============================================================================
+Ipv4Header::Ipv4Header() :
+    DataPacket(1), // always aligned on 1 byte (no alignment)
+    version_header_length(0x45),
+    dscp_ecn(0),
+    total_length(0),
+    identification(0),
+    flags_fragment_offset(0),
+    ttl(0),
+    protocol(0),
+    checksum(0)
+{
+    addDataFields();
+}
+
+//==============================================================================
+// Initializes protocol, defaults for the rest
+//==============================================================================
+Ipv4Header::Ipv4Header(std::uint8_t protocol) :
+    Ipv4Header()
+{
+    this->protocol = protocol;
+}
+
+//==============================================================================
+// Constructs an Ipv4Header by calling readRaw() on the provided buffer.
+// Byteswapping is performed if needed.
+//==============================================================================
+Ipv4Header::Ipv4Header(const std::uint8_t* buffer) :
+    Ipv4Header()
+{
+    readRaw(buffer, misc::ENDIAN_BIG);
+}
+
+//==============================================================================
+Ipv4Header::~Ipv4Header()
+{
+}
+
+//==============================================================================
+void Ipv4Header::addDataFields()
+{
+    addDataField(&version_header_length);
+    addDataField(&dscp_ecn);
+    addDataField(&total_length);
+    addDataField(&identification);
+    addDataField(&flags_fragment_offset);
+    addDataField(&ttl);
+    addDataField(&protocol);
+    addDataField(&checksum);
+    addDataField(&source);
+    addDataField(&destination);
+}
@@ -0,0 +1,283 @@
+#if !defined IPV4_HEADER_HPP
+#define IPV4_HEADER_HPP
+
+#include <cstdint>
+
+#include "DataPacket.hpp"
+
+#include "Ipv4Address.hpp"
+#include "SimpleDataField.hpp"
+#include "misc.hpp"
+
+// Represents an IPv4 header up to and including the destination address.
+// Options aren't represented; getHeaderLength() says how far past the start of
+// the header the payload begins when there are any.  Fields that share a byte
+// or two on the wire (version and header length, DSCP and ECN, flags and
+// fragment offset) are stored together as they are on the wire and split apart
+// with masks and shifts by the accessors.  See Ipv4HeaderView for reading
+// headers in place in a receive buffer without copying them.
+class Ipv4Header : public DataPacket
+{
+public:
+
+    // Shorthand textual ways of referencing some protocol numbers
+    enum Protocol
+    {
+        ICMP = 1,
+        TCP  = 6,
+        UDP  = 17
+    };
+
+    // Initializes version to 4 and header length to 5 (no options), everything
+    // else to 0
+    Ipv4Header();
+
+    // Initializes protocol, defaults for the rest
+    // cppcheck-suppress noExplicitConstructor
+    Ipv4Header(std::uint8_t protocol);
+
+    // Constructs an Ipv4Header by calling readRaw() on the provided buffer.
+    // IPv4 headers are big endian on the wire so byteswapping is performed if
+    // needed.
+    explicit Ipv4Header(const std::uint8_t* buffer);
+
+    // Does nothing
+    virtual ~Ipv4Header();
+
+    // Bits 0-3 of the first byte
+    std::uint8_t getVersion() const;
+    void setVersion(std::uint8_t version);
+
+    // Header length in 32-bit words; bits 4-7 of the first byte
+    std::uint8_t getHeaderLength() const;
+    void setHeaderLength(std::uint8_t header_length);
+
+    // Header length in bytes
+    unsigned int getHeaderLengthBytes() const;
+
+    // Differentiated Services Code Point; bits 0-5 of the second byte
+    std::uint8_t getDscp() const;
+    void setDscp(std::uint8_t dscp);
+
+    // Explicit Congestion Notification; bits 6-7 of the second byte
+    std::uint8_t getEcn() const;
+    void setEcn(std::uint8_t ecn);
+
+    // Length of the whole datagram, header included, in bytes
+    std::uint16_t getTotalLength() const;
+    void setTotalLength(std::uint16_t total_length);
+
+    std::uint16_t getIdentification() const;
+    void setIdentification(std::uint16_t identification);
+
+    // Don't fragment flag
+    bool getDontFragment() const;
+    void setDontFragment(bool dont_fragment);
+
+    // More fragments flag
+    bool getMoreFragments() const;
+    void setMoreFragments(bool more_fragments);
+
+    // Fragment offset in 8-byte units
+    std::uint16_t getFragmentOffset() const;
+    void setFragmentOffset(std::uint16_t fragment_offset);
+
+    // True if this is any fragment of a larger datagram, first or otherwise
+    bool isFragment() const;
+
+    std::uint8_t getTtl() const;
+    void setTtl(std::uint8_t ttl);
+
+    std::uint8_t getProtocol() const;
+    void setProtocol(std::uint8_t protocol);
+
+    std::uint16_t getChecksum() const;
+    void setChecksum(std::uint16_t checksum);
+
+    Ipv4Address* getSource();
+    const Ipv4Address* getSource() const;
+
+    Ipv4Address* getDestination();
+    const Ipv4Address* getDestination() const;
+
+    // IPv4 headers without options are always exactly this size
+    static const unsigned short LENGTH_BYTES = 20;
+
+private:
+
+    void addDataFields();
+
+    SimpleDataField<std::uint8_t>  version_header_length;
+    SimpleDataField<std::uint8_t>  dscp_ecn;
+    SimpleDataField<std::uint16_t> total_length;
+    SimpleDataField<std::uint16_t> identification;
+    SimpleDataField<std::uint16_t> flags_fragment_offset;
+    SimpleDataField<std::uint8_t>  ttl;
+    SimpleDataField<std::uint8_t>  protocol;
+    SimpleDataField<std::uint16_t> checksum;
+    Ipv4Address                    source;
+    Ipv4Address                    destination;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    Ipv4Header(const Ipv4Header&);
+    Ipv4Header& operator=(const Ipv4Header&);
+};
+
+inline std::uint8_t Ipv4Header::getVersion() const
+{
+    return version_header_length >> 4;
+}
+
+inline void Ipv4Header::setVersion(std::uint8_t version)
+{
+    version_header_length =
+        (version_header_length & 0x0f) | ((version & 0x0f) << 4);
+}
+
+inline std::uint8_t Ipv4Header::getHeaderLength() const
+{
+    return version_header_length & 0x0f;
+}
+
+inline void Ipv4Header::setHeaderLength(std::uint8_t header_length)
+{
+    version_header_length =
+        (version_header_length & 0xf0) | (header_length & 0x0f);
+}
+
+inline unsigned int Ipv4Header::getHeaderLengthBytes() const
+{
+    return getHeaderLength() * 4;
+}
+
+inline std::uint8_t Ipv4Header::getDscp() const
+{
+    return dscp_ecn >> 2;
+}
+
+inline void Ipv4Header::setDscp(std::uint8_t dscp)
+{
+    dscp_ecn = (dscp_ecn & 0x03) | ((dscp & 0x3f) << 2);
+}
+
+inline std::uint8_t Ipv4Header::getEcn() const
+{
+    return dscp_ecn & 0x03;
+}
+
+inline void Ipv4Header::setEcn(std::uint8_t ecn)
+{
+    dscp_ecn = (dscp_ecn & 0xfc) | (ecn & 0x03);
+}
+
+inline std::uint16_t Ipv4Header::getTotalLength() const
+{
+    return total_length;
+}
+
+inline void Ipv4Header::setTotalLength(std::uint16_t total_length)
+{
+    this->total_length = total_length;
+}
+
+inline std::uint16_t Ipv4Header::getIdentification() const
+{
+    return identification;
+}
+
+inline void Ipv4Header::setIdentification(std::uint16_t identification)
+{
+    this->identification = identification;
+}
+
+inline bool Ipv4Header::getDontFragment() const
+{
+    return (flags_fragment_offset & 0x4000) != 0;
+}
+
+inline void Ipv4Header::setDontFragment(bool dont_fragment)
+{
+    flags_fragment_offset =
+        (flags_fragment_offset & 0xbfff) | (dont_fragment ? 0x4000 : 0);
+}
+
+inline bool Ipv4Header::getMoreFragments() const
+{
+    return (flags_fragment_offset & 0x2000) != 0;
+}
+
+inline void Ipv4Header::setMoreFragments(bool more_fragments)
+{
+    flags_fragment_offset =
+        (flags_fragment_offset & 0xdfff) | (more_fragments ? 0x2000 : 0);
+}
+
+inline std::uint16_t Ipv4Header::getFragmentOffset() const
+{
+    return flags_fragment_offset & 0x1fff;
+}
+
+inline void Ipv4Header::setFragmentOffset(std::uint16_t fragment_offset)
+{
+    flags_fragment_offset =
+        (flags_fragment_offset & 0xe000) | (fragment_offset & 0x1fff);
+}
+
+inline bool Ipv4Header::isFragment() const
+{
+    // Either more fragments follow or there's a nonzero offset
+    return (flags_fragment_offset & 0x3fff) != 0;
+}
+
+inline std::uint8_t Ipv4Header::getTtl() const
+{
+    return ttl;
+}
+
+inline void Ipv4Header::setTtl(std::uint8_t ttl)
+{
+    this->ttl = ttl;
+}
+
+inline std::uint8_t Ipv4Header::getProtocol() const
+{
+    return protocol;
+}
+
+inline void Ipv4Header::setProtocol(std::uint8_t protocol)
+{
+    this->protocol = protocol;
+}
+
+inline std::uint16_t Ipv4Header::getChecksum() const
+{
+    return checksum;
+}
+
+inline void Ipv4Header::setChecksum(std::uint16_t checksum)
+{
+    this->checksum = checksum;
+}
+
+inline Ipv4Address* Ipv4Header::getSource()
+{
+    return &source;
+}
+
+inline const Ipv4Address* Ipv4Header::getSource() const
+{
+    return &source;
+}
+
+inline Ipv4Address* Ipv4Header::getDestination()
+{
+    return &destination;
+}
+
+inline const Ipv4Address* Ipv4Header::getDestination() const
+{
+    return &destination;
+}
+
+#endif
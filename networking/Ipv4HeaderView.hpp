@@ -0,0 +1,175 @@
+#if !defined IPV4_HEADER_VIEW_HPP
+#define IPV4_HEADER_VIEW_HPP
+
+#include <cstdint>
+
+// Reads the fields of an IPv4 header in place, straight out of a receive
+// buffer.  Nothing is copied or byteswapped up front; each accessor reads its
+// bytes from a fixed offset and assembles them big endian, so looking at one
+// or two fields of a header costs only those fields.  The buffer must hold at
+// least Ipv4Header::LENGTH_BYTES bytes and outlive the view.  Use Ipv4Header
+// instead for building headers or keeping them around.
+class Ipv4HeaderView
+{
+public:
+
+    // Views the header starting at 'buffer'
+    explicit Ipv4HeaderView(const std::uint8_t* buffer);
+
+    std::uint8_t  getVersion() const;
+    std::uint8_t  getHeaderLength() const;
+    unsigned int  getHeaderLengthBytes() const;
+    std::uint8_t  getDscp() const;
+    std::uint8_t  getEcn() const;
+    std::uint16_t getTotalLength() const;
+    std::uint16_t getIdentification() const;
+    bool          getDontFragment() const;
+    bool          getMoreFragments() const;
+    std::uint16_t getFragmentOffset() const;
+    bool          isFragment() const;
+    std::uint8_t  getTtl() const;
+    std::uint8_t  getProtocol() const;
+    std::uint16_t getChecksum() const;
+
+    // Addresses in host byte order, handy as keys
+    std::uint32_t getSource() const;
+    std::uint32_t getDestination() const;
+
+    // Where the raw source and destination addresses are
+    const std::uint8_t* getSourceRaw() const;
+    const std::uint8_t* getDestinationRaw() const;
+
+    // Where the header starts
+    const std::uint8_t* getBuffer() const;
+
+    // Where the payload starts, going by the header length field
+    const std::uint8_t* getPayload() const;
+
+private:
+
+    std::uint16_t read16(unsigned int offset) const;
+    std::uint32_t read32(unsigned int offset) const;
+
+    const std::uint8_t* buffer;
+};
+
+inline Ipv4HeaderView::Ipv4HeaderView(const std::uint8_t* buffer) :
+    buffer(buffer)
+{
+}
+
+inline std::uint8_t Ipv4HeaderView::getVersion() const
+{
+    return buffer[0] >> 4;
+}
+
+inline std::uint8_t Ipv4HeaderView::getHeaderLength() const
+{
+    return buffer[0] & 0x0f;
+}
+
+inline unsigned int Ipv4HeaderView::getHeaderLengthBytes() const
+{
+    return getHeaderLength() * 4;
+}
+
+inline std::uint8_t Ipv4HeaderView::getDscp() const
+{
+    return buffer[1] >> 2;
+}
+
+inline std::uint8_t Ipv4HeaderView::getEcn() const
+{
+    return buffer[1] & 0x03;
+}
+
+inline std::uint16_t Ipv4HeaderView::getTotalLength() const
+{
+    return read16(2);
+}
+
+inline std::uint16_t Ipv4HeaderView::getIdentification() const
+{
+    return read16(4);
+}
+
+inline bool Ipv4HeaderView::getDontFragment() const
+{
+    return (buffer[6] & 0x40) != 0;
+}
+
+inline bool Ipv4HeaderView::getMoreFragments() const
+{
+    return (buffer[6] & 0x20) != 0;
+}
+
+inline std::uint16_t Ipv4HeaderView::getFragmentOffset() const
+{
+    return read16(6) & 0x1fff;
+}
+
+inline bool Ipv4HeaderView::isFragment() const
+{
+    // Either more fragments follow or there's a nonzero offset
+    return (read16(6) & 0x3fff) != 0;
+}
+
+inline std::uint8_t Ipv4HeaderView::getTtl() const
+{
+    return buffer[8];
+}
+
+inline std::uint8_t Ipv4HeaderView::getProtocol() const
+{
+    return buffer[9];
+}
+
+inline std::uint16_t Ipv4HeaderView::getChecksum() const
+{
+    return read16(10);
+}
+
+inline std::uint32_t Ipv4HeaderView::getSource() const
+{
+    return read32(12);
+}
+
+inline std::uint32_t Ipv4HeaderView::getDestination() const
+{
+    return read32(16);
+}
+
+inline const std::uint8_t* Ipv4HeaderView::getSourceRaw() const
+{
+    return buffer + 12;
+}
+
+inline const std::uint8_t* Ipv4HeaderView::getDestinationRaw() const
+{
+    return buffer + 16;
+}
+
+inline const std::uint8_t* Ipv4HeaderView::getBuffer() const
+{
+    return buffer;
+}
+
+inline const std::uint8_t* Ipv4HeaderView::getPayload() const
+{
+    return buffer + getHeaderLengthBytes();
+}
+
+inline std::uint16_t Ipv4HeaderView::read16(unsigned int offset) const
+{
+    return static_cast<std::uint16_t>(buffer[offset] << 8 | buffer[offset + 1]);
+}
+
+inline std::uint32_t Ipv4HeaderView::read32(unsigned int offset) const
+{
+    return static_cast<std::uint32_t>(buffer[offset])     << 24 |
+           static_cast<std::uint32_t>(buffer[offset + 1]) << 16 |
+           static_cast<std::uint32_t>(buffer[offset + 2]) << 8  |
+           static_cast<std::uint32_t>(buffer[offset + 3]);
+}
+
+#endif
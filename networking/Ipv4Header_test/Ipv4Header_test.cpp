@@ -0,0 +1,163 @@
+#include <cstdint>
+
+#include "Ipv4Header_test.hpp"
+
+#include "Ipv4Header.hpp"
+#include "Ipv4HeaderView.hpp"
+
+#include "TestMacros.hpp"
+#include "misc.hpp"
+
+TEST_PROGRAM_MAIN(Ipv4Header_test);
+
+// A TCP SYN's IPv4 header, from 172.16.10.99 to 172.16.10.12 with don't
+// fragment set, DSCP 46 (expedited forwarding) and ECN 1
+static const std::uint8_t HEADER_RAW[Ipv4Header::LENGTH_BYTES] =
+{
+    0x45, 0xb9, 0x00, 0x3c, 0x1c, 0x46, 0x40, 0x00, 0x40, 0x06,
+    0xb1, 0xe6, 0xac, 0x10, 0x0a, 0x63, 0xac, 0x10, 0x0a, 0x0c
+};
+
+//==============================================================================
+void Ipv4Header_test::addTestCases()
+{
+    ADD_TEST_CASE(Length);
+    ADD_TEST_CASE(ReadRaw);
+    ADD_TEST_CASE(PackedFields);
+    ADD_TEST_CASE(View);
+}
+
+//==============================================================================
+Test::Result Ipv4Header_test::Length::body()
+{
+    Ipv4Header ipv4_header(Ipv4Header::UDP);
+    MUST_BE_TRUE(ipv4_header.getLengthBytes() == Ipv4Header::LENGTH_BYTES);
+
+    MUST_BE_TRUE(ipv4_header.getVersion() == 4);
+    MUST_BE_TRUE(ipv4_header.getHeaderLength() == 5);
+    MUST_BE_TRUE(ipv4_header.getHeaderLengthBytes() ==
+                 Ipv4Header::LENGTH_BYTES);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Header_test::ReadRaw::body()
+{
+    Ipv4Header ipv4_header(HEADER_RAW);
+
+    MUST_BE_TRUE(ipv4_header.getVersion() == 4);
+    MUST_BE_TRUE(ipv4_header.getHeaderLength() == 5);
+    MUST_BE_TRUE(ipv4_header.getDscp() == 46);
+    MUST_BE_TRUE(ipv4_header.getEcn() == 1);
+    MUST_BE_TRUE(ipv4_header.getTotalLength() == 60);
+    MUST_BE_TRUE(ipv4_header.getIdentification() == 0x1c46);
+    MUST_BE_TRUE(ipv4_header.getDontFragment());
+    MUST_BE_FALSE(ipv4_header.getMoreFragments());
+    MUST_BE_TRUE(ipv4_header.getFragmentOffset() == 0);
+    MUST_BE_FALSE(ipv4_header.isFragment());
+    MUST_BE_TRUE(ipv4_header.getTtl() == 64);
+    MUST_BE_TRUE(ipv4_header.getProtocol() == Ipv4Header::TCP);
+    MUST_BE_TRUE(ipv4_header.getChecksum() == 0xb1e6);
+    MUST_BE_TRUE(*ipv4_header.getSource() == "172.16.10.99");
+    MUST_BE_TRUE(*ipv4_header.getDestination() == "172.16.10.12");
+
+    // Should come back out exactly as it went in
+    std::uint8_t header_raw[Ipv4Header::LENGTH_BYTES];
+    ipv4_header.writeRaw(header_raw, misc::ENDIAN_BIG);
+    for (unsigned int i = 0; i < Ipv4Header::LENGTH_BYTES; ++i)
+    {
+        MUST_BE_TRUE(header_raw[i] == HEADER_RAW[i]);
+    }
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Header_test::PackedFields::body()
+{
+    Ipv4Header ipv4_header;
+
+    // Setting each field of a shared byte shouldn't disturb the other
+    ipv4_header.setHeaderLength(15);
+    ipv4_header.setVersion(6);
+    MUST_BE_TRUE(ipv4_header.getVersion() == 6);
+    MUST_BE_TRUE(ipv4_header.getHeaderLength() == 15);
+    MUST_BE_TRUE(ipv4_header.getHeaderLengthBytes() == 60);
+
+    ipv4_header.setDscp(0x3f);
+    ipv4_header.setEcn(2);
+    ipv4_header.setDscp(10);
+    MUST_BE_TRUE(ipv4_header.getDscp() == 10);
+    MUST_BE_TRUE(ipv4_header.getEcn() == 2);
+
+    ipv4_header.setFragmentOffset(0x1fff);
+    ipv4_header.setMoreFragments(true);
+    MUST_BE_TRUE(ipv4_header.isFragment());
+    MUST_BE_FALSE(ipv4_header.getDontFragment());
+    ipv4_header.setDontFragment(true);
+    ipv4_header.setMoreFragments(false);
+    MUST_BE_TRUE(ipv4_header.getDontFragment());
+    MUST_BE_FALSE(ipv4_header.getMoreFragments());
+    MUST_BE_TRUE(ipv4_header.getFragmentOffset() == 0x1fff);
+    MUST_BE_TRUE(ipv4_header.isFragment());
+
+    // Values too wide for their fields are cut down to size
+    ipv4_header.setFragmentOffset(0xffff);
+    MUST_BE_TRUE(ipv4_header.getFragmentOffset() == 0x1fff);
+    MUST_BE_TRUE(ipv4_header.getDontFragment());
+    MUST_BE_FALSE(ipv4_header.getMoreFragments());
+
+    std::uint8_t header_raw[Ipv4Header::LENGTH_BYTES];
+    ipv4_header.writeRaw(header_raw, misc::ENDIAN_BIG);
+    MUST_BE_TRUE(header_raw[0] == 0x6f);
+    MUST_BE_TRUE(header_raw[1] == 0x2a);
+    MUST_BE_TRUE(header_raw[6] == 0x5f);
+    MUST_BE_TRUE(header_raw[7] == 0xff);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Header_test::View::body()
+{
+    Ipv4HeaderView view(HEADER_RAW);
+
+    MUST_BE_TRUE(view.getVersion() == 4);
+    MUST_BE_TRUE(view.getHeaderLength() == 5);
+    MUST_BE_TRUE(view.getDscp() == 46);
+    MUST_BE_TRUE(view.getEcn() == 1);
+    MUST_BE_TRUE(view.getTotalLength() == 60);
+    MUST_BE_TRUE(view.getIdentification() == 0x1c46);
+    MUST_BE_TRUE(view.getDontFragment());
+    MUST_BE_FALSE(view.getMoreFragments());
+    MUST_BE_TRUE(view.getFragmentOffset() == 0);
+    MUST_BE_FALSE(view.isFragment());
+    MUST_BE_TRUE(view.getTtl() == 64);
+    MUST_BE_TRUE(view.getProtocol() == Ipv4Header::TCP);
+    MUST_BE_TRUE(view.getChecksum() == 0xb1e6);
+    MUST_BE_TRUE(view.getSource() == 0xac100a63);
+    MUST_BE_TRUE(view.getDestination() == 0xac100a0c);
+    MUST_BE_TRUE(view.getSourceRaw() == HEADER_RAW + 12);
+    MUST_BE_TRUE(view.getPayload() == HEADER_RAW + Ipv4Header::LENGTH_BYTES);
+
+    // A middle fragment with options
+    Ipv4Header ipv4_header(Ipv4Header::UDP);
+    ipv4_header.setHeaderLength(6);
+    ipv4_header.setMoreFragments(true);
+    ipv4_header.setFragmentOffset(185);
+
+    std::uint8_t header_raw[Ipv4Header::LENGTH_BYTES];
+    ipv4_header.writeRaw(header_raw, misc::ENDIAN_BIG);
+
+    Ipv4HeaderView fragment_view(header_raw);
+    MUST_BE_TRUE(fragment_view.getHeaderLengthBytes() == 24);
+    MUST_BE_TRUE(fragment_view.getPayload() == header_raw + 24);
+    MUST_BE_TRUE(fragment_view.getMoreFragments());
+    MUST_BE_FALSE(fragment_view.getDontFragment());
+    MUST_BE_TRUE(fragment_view.getFragmentOffset() == 185);
+    MUST_BE_TRUE(fragment_view.isFragment());
+    MUST_BE_TRUE(fragment_view.getProtocol() == Ipv4Header::UDP);
+
+    return Test::PASSED;
+}
@@ -0,0 +1,17 @@
+#if !defined IPV4_HEADER_TEST
+#define IPV4_HEADER_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(Ipv4Header_test)
+
+    TEST(Length)
+    TEST(ReadRaw)
+    TEST(PackedFields)
+    TEST(View)
+
+TEST_CASES_END(Ipv4Header_test)
+
+#endif
@@ -0,0 +1,141 @@
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "Ipv4Prefix.hpp"
+
+#include "Ipv4Address.hpp"
+
+//==============================================================================
+Ipv4Prefix::Ipv4Prefix() :
+    address(0),
+    length(0)
+{
+}
+
+//==============================================================================
+Ipv4Prefix::Ipv4Prefix(std::uint32_t address, unsigned int length) :
+    address(0),
+    length(length)
+{
+    if (length > 32)
+    {
+        throw std::invalid_argument("IPv4 prefixes are at most 32 bits long");
+    }
+
+    this->address = address & getMask();
+}
+
+//==============================================================================
+Ipv4Prefix::Ipv4Prefix(const Ipv4Address& address, unsigned int length) :
+    Ipv4Prefix(address.toUint32(), length)
+{
+}
+
+//==============================================================================
+Ipv4Prefix::Ipv4Prefix(const std::string& prefix_str) :
+    address(0),
+    length(32)
+{
+    unsigned int bytes[Ipv4Address::LENGTH_BYTES];
+    int          address_end = 0;
+
+    if (sscanf(prefix_str.c_str(),
+               "%u.%u.%u.%u%n",
+               &bytes[0],
+               &bytes[1],
+               &bytes[2],
+               &bytes[3],
+               &address_end) != 4)
+    {
+        throw std::invalid_argument("Not an IPv4 prefix: " + prefix_str);
+    }
+
+    // The length is optional, but anything left over after the address and
+    // length fails the parse
+    std::string::size_type end = address_end;
+    if (end < prefix_str.size() && prefix_str[end] == '/')
+    {
+        const char* length_str = prefix_str.c_str() + end;
+        int         length_end = 0;
+        if (sscanf(length_str, "/%u%n", &length, &length_end) != 1)
+        {
+            throw std::invalid_argument("Not an IPv4 prefix: " + prefix_str);
+        }
+
+        end += length_end;
+    }
+
+    if (end != prefix_str.size() || length > 32)
+    {
+        throw std::invalid_argument("Not an IPv4 prefix: " + prefix_str);
+    }
+
+    for (unsigned int i = 0; i < Ipv4Address::LENGTH_BYTES; i++)
+    {
+        if (bytes[i] > 255)
+        {
+            throw std::invalid_argument("Not an IPv4 prefix: " + prefix_str);
+        }
+
+        address = address << 8 | bytes[i];
+    }
+
+    address &= getMask();
+}
+
+//==============================================================================
+Ipv4Prefix::~Ipv4Prefix()
+{
+}
+
+//==============================================================================
+void Ipv4Prefix::getAddress(Ipv4Address& address) const
+{
+    address.fromUint32(this->address);
+}
+
+//==============================================================================
+bool Ipv4Prefix::contains(const Ipv4Address& address) const
+{
+    return contains(address.toUint32());
+}
+
+//==============================================================================
+bool Ipv4Prefix::contains(const Ipv4Prefix& prefix) const
+{
+    return prefix.length >= length && contains(prefix.address);
+}
+
+//==============================================================================
+Ipv4Prefix::operator std::string() const
+{
+    std::ostringstream tempstream;
+    tempstream << *this;
+    return tempstream.str();
+}
+
+//==============================================================================
+std::ostream& operator<<(std::ostream& os, const Ipv4Prefix& ipv4_prefix)
+{
+    Ipv4Address address;
+    ipv4_prefix.getAddress(address);
+
+    return os << address << "/" << ipv4_prefix.getLength();
+}
+
+//==============================================================================
+bool operator==(const Ipv4Prefix& lhs, const Ipv4Prefix& rhs)
+{
+    return lhs.getAddress() == rhs.getAddress() &&
+        lhs.getLength() == rhs.getLength();
+}
+
+//==============================================================================
+bool operator!=(const Ipv4Prefix& lhs, const Ipv4Prefix& rhs)
+{
+    return !(lhs == rhs);
+}
@@ -0,0 +1,99 @@
+#if !defined IPV4_PREFIX_HPP
+#define IPV4_PREFIX_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "Ipv4Address.hpp"
+
+// An IPv4 network prefix such as 10.1.0.0/16: an address and how many of its
+// leading bits are significant.  Bits past the prefix length are always zero,
+// whatever the prefix was constructed from.  Addresses are numbers in host
+// byte order, as from Ipv4Address::toUint32().
+class Ipv4Prefix
+{
+public:
+
+    // Constructs 0.0.0.0/0, which contains every address
+    Ipv4Prefix();
+
+    // Constructs the prefix of the given length containing 'address'.  Throws
+    // std::invalid_argument if 'length' is more than 32.
+    Ipv4Prefix(std::uint32_t address, unsigned int length);
+    Ipv4Prefix(const Ipv4Address& address, unsigned int length);
+
+    // Constructs a prefix from its "a.b.c.d/n" string representation; a bare
+    // address is taken as a /32.  Throws std::invalid_argument if the string
+    // isn't one.
+    explicit Ipv4Prefix(const std::string& prefix_str);
+
+    // Does nothing
+    ~Ipv4Prefix();
+
+    // Returns the first address in the prefix
+    std::uint32_t getAddress() const;
+    void getAddress(Ipv4Address& address) const;
+
+    // Returns how many leading bits are significant
+    unsigned int getLength() const;
+
+    // Returns the netmask, with the leading 'length' bits set
+    std::uint32_t getMask() const;
+
+    // Returns true if 'address' falls within this prefix
+    bool contains(std::uint32_t address) const;
+    bool contains(const Ipv4Address& address) const;
+
+    // Returns true if every address in 'prefix' falls within this prefix
+    bool contains(const Ipv4Prefix& prefix) const;
+
+    // Defines how to convert a Ipv4Prefix to a std::string
+    operator std::string() const;
+
+    // Returns the netmask for a prefix of the given length
+    static std::uint32_t getMask(unsigned int length);
+
+private:
+
+    std::uint32_t address;
+    unsigned int  length;
+};
+
+std::ostream& operator<<(std::ostream& os, const Ipv4Prefix& ipv4_prefix);
+
+bool operator==(const Ipv4Prefix& lhs, const Ipv4Prefix& rhs);
+bool operator!=(const Ipv4Prefix& lhs, const Ipv4Prefix& rhs);
+
+//==============================================================================
+inline std::uint32_t Ipv4Prefix::getAddress() const
+{
+    return address;
+}
+
+//==============================================================================
+inline unsigned int Ipv4Prefix::getLength() const
+{
+    return length;
+}
+
+//==============================================================================
+inline std::uint32_t Ipv4Prefix::getMask() const
+{
+    return getMask(length);
+}
+
+//==============================================================================
+inline bool Ipv4Prefix::contains(std::uint32_t address) const
+{
+    return (address & getMask()) == this->address;
+}
+
+//==============================================================================
+inline std::uint32_t Ipv4Prefix::getMask(unsigned int length)
+{
+    // Shifting a 32-bit value by 32 is undefined, hence the special case
+    return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "Ipv4Prefix_test.hpp"
+
+#include "Ipv4Address.hpp"
+#include "Ipv4Prefix.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(Ipv4Prefix_test);
+
+//==============================================================================
+void Ipv4Prefix_test::addTestCases()
+{
+    ADD_TEST_CASE(Construction);
+    ADD_TEST_CASE(Parsing);
+    ADD_TEST_CASE(Contains);
+}
+
+//==============================================================================
+// Returns true if constructing a prefix from 'prefix_str' throws
+//==============================================================================
+static bool rejects(const std::string& prefix_str)
+{
+    try
+    {
+        Ipv4Prefix prefix(prefix_str);
+    }
+    catch (std::invalid_argument&)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+Test::Result Ipv4Prefix_test::Construction::body()
+{
+    Ipv4Prefix everything;
+    MUST_BE_TRUE(everything.getAddress() == 0);
+    MUST_BE_TRUE(everything.getLength() == 0);
+    MUST_BE_TRUE(everything.getMask() == 0);
+
+    // Host bits are cleared
+    Ipv4Prefix prefix(0x0a0102ff, 20);
+    MUST_BE_TRUE(prefix.getAddress() == 0x0a010000);
+    MUST_BE_TRUE(prefix.getMask() == 0xfffff000);
+
+    Ipv4Prefix host(Ipv4Address("192.168.7.9"), 32);
+    MUST_BE_TRUE(host.getAddress() == 0xc0a80709);
+    MUST_BE_TRUE(host.getMask() == 0xffffffff);
+
+    Ipv4Address address;
+    host.getAddress(address);
+    MUST_BE_TRUE(address == "192.168.7.9");
+
+    bool thrown = false;
+    try
+    {
+        Ipv4Prefix too_long(0, 33);
+    }
+    catch (std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    MUST_BE_TRUE(thrown);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Prefix_test::Parsing::body()
+{
+    MUST_BE_TRUE(Ipv4Prefix("10.1.0.0/16") == Ipv4Prefix(0x0a010000, 16));
+    MUST_BE_TRUE(Ipv4Prefix("10.1.2.3/16") == Ipv4Prefix(0x0a010000, 16));
+    MUST_BE_TRUE(Ipv4Prefix("10.1.2.3") == Ipv4Prefix(0x0a010203, 32));
+    MUST_BE_TRUE(Ipv4Prefix("0.0.0.0/0") == Ipv4Prefix());
+    MUST_BE_TRUE(Ipv4Prefix("10.1.0.0/16") != Ipv4Prefix(0x0a010000, 17));
+
+    MUST_BE_TRUE(static_cast<std::string>(Ipv4Prefix("172.16.5.4/12")) ==
+                 "172.16.0.0/12");
+
+    MUST_BE_TRUE(rejects(""));
+    MUST_BE_TRUE(rejects("10.1.0/16"));
+    MUST_BE_TRUE(rejects("10.1.0.0/"));
+    MUST_BE_TRUE(rejects("10.1.0.0/33"));
+    MUST_BE_TRUE(rejects("10.1.0.256/24"));
+    MUST_BE_TRUE(rejects("10.1.0.0/24x"));
+    MUST_BE_TRUE(rejects("10.0.0.1junk"));
+    MUST_BE_TRUE(rejects("10.0.0.1 x"));
+    MUST_BE_TRUE(rejects("10.0.0.1/"));
+    MUST_BE_TRUE(rejects("10.0.0.1."));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Prefix_test::Contains::body()
+{
+    Ipv4Prefix prefix("10.1.0.0/16");
+    MUST_BE_TRUE(prefix.contains(0x0a010000));
+    MUST_BE_TRUE(prefix.contains(0x0a01ffff));
+    MUST_BE_FALSE(prefix.contains(0x0a020000));
+    MUST_BE_TRUE(prefix.contains(Ipv4Address("10.1.200.7")));
+    MUST_BE_FALSE(prefix.contains(Ipv4Address("10.0.255.255")));
+
+    MUST_BE_TRUE(prefix.contains(prefix));
+    MUST_BE_TRUE(prefix.contains(Ipv4Prefix("10.1.128.0/17")));
+    MUST_BE_FALSE(prefix.contains(Ipv4Prefix("10.0.0.0/15")));
+    MUST_BE_FALSE(prefix.contains(Ipv4Prefix("10.2.0.0/24")));
+
+    MUST_BE_TRUE(Ipv4Prefix().contains(0xffffffff));
+    MUST_BE_TRUE(Ipv4Prefix().contains(prefix));
+
+    return Test::PASSED;
+}
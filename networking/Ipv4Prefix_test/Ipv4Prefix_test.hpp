@@ -0,0 +1,16 @@
+#if !defined IPV4_PREFIX_TEST
+#define IPV4_PREFIX_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(Ipv4Prefix_test)
+
+    TEST(Construction)
+    TEST(Parsing)
+    TEST(Contains)
+
+TEST_CASES_END(Ipv4Prefix_test)
+
+#endif
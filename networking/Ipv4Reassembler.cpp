@@ -0,0 +1,542 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "Ipv4Reassembler.hpp"
+
+#include "Ipv4Header.hpp"
+#include "Ipv4HeaderView.hpp"
+
+const unsigned int Ipv4Reassembler::MEMORY_MAX_DEFAULT;
+const unsigned int Ipv4Reassembler::DATAGRAMS_MAX_DEFAULT;
+const unsigned int Ipv4Reassembler::SLAB_SIZE;
+const unsigned int Ipv4Reassembler::HOLES_MAX;
+const unsigned int Ipv4Reassembler::TIMER_TICKS;
+
+// Timer wheel slots; twice the ticks in a timeout so a new deadline never
+// lands in the slot currently being expired
+static const unsigned int TIMER_SLOTS = Ipv4Reassembler::TIMER_TICKS * 2;
+
+// Stands in for the end of a datagram before its last fragment has arrived
+static const unsigned int LENGTH_UNKNOWN = 65536;
+
+// Payloads can't run past this, since the whole datagram has to fit in an
+// IPv4 total length field alongside at least a minimal header
+static const unsigned int PAYLOAD_END_MAX = 65535 - Ipv4Header::LENGTH_BYTES;
+
+//==============================================================================
+// Allocates everything up front
+//==============================================================================
+Ipv4Reassembler::Ipv4Reassembler(unsigned int memory_max,
+                                 unsigned int datagrams_max,
+                                 double       timeout) :
+    free_datagrams(-1),
+    tick_length(timeout / TIMER_TICKS),
+    tick(0),
+    ticking(false),
+    output(65535),
+    output_length(0),
+    pending_count(0),
+    completed_count(0),
+    expired_count(0),
+    evicted_count(0),
+    rejected_count(0)
+{
+    if (memory_max < SLAB_SIZE || datagrams_max == 0 || !(timeout > 0.0))
+    {
+        throw std::invalid_argument(
+            "Reassembler limits must leave room for at least one fragment");
+    }
+
+    unsigned int slab_count = memory_max / SLAB_SIZE;
+    slab_memory.resize(slab_count * SLAB_SIZE);
+    free_slabs.reserve(slab_count);
+    for (unsigned int i = slab_count; i > 0; --i)
+    {
+        free_slabs.push_back(i - 1);
+    }
+
+    datagrams.resize(datagrams_max);
+    for (unsigned int i = datagrams_max; i > 0; --i)
+    {
+        datagrams[i - 1].timer_next = free_datagrams;
+        free_datagrams = i - 1;
+    }
+
+    // Keep chains short even when every datagram is in use
+    unsigned int bucket_count = 1;
+    while (bucket_count < datagrams_max * 2)
+    {
+        bucket_count *= 2;
+    }
+
+    buckets.assign(bucket_count, -1);
+    timer_heads.assign(TIMER_SLOTS, -1);
+    timer_tails.assign(TIMER_SLOTS, -1);
+}
+
+//==============================================================================
+Ipv4Reassembler::~Ipv4Reassembler()
+{
+}
+
+//==============================================================================
+// Handles one packet
+//==============================================================================
+Ipv4Reassembler::Result Ipv4Reassembler::addFragment(
+    const std::uint8_t* packet,
+    unsigned int        size,
+    double              now)
+{
+    expire(now);
+
+    if (size < Ipv4Header::LENGTH_BYTES)
+    {
+        rejected_count++;
+        return INVALID;
+    }
+
+    Ipv4HeaderView header(packet);
+    unsigned int header_length = header.getHeaderLengthBytes();
+    unsigned int total_length  = header.getTotalLength();
+
+    if (header.getVersion() != 4 ||
+        header_length < Ipv4Header::LENGTH_BYTES ||
+        total_length < header_length ||
+        total_length > size)
+    {
+        rejected_count++;
+        return INVALID;
+    }
+
+    if (!header.isFragment())
+    {
+        return NOT_FRAGMENT;
+    }
+
+    unsigned int first = header.getFragmentOffset() * 8;
+    unsigned int end   = first + total_length - header_length;
+    bool         last  = !header.getMoreFragments();
+
+    // Every fragment but the last carries a multiple of 8 bytes, since that's
+    // what the offsets count in
+    if (end == first || end > PAYLOAD_END_MAX || (!last && (end - first) % 8))
+    {
+        rejected_count++;
+        return INVALID;
+    }
+
+    std::int32_t index = find(header.getSource(),
+                              header.getDestination(),
+                              header.getIdentification(),
+                              header.getProtocol());
+    if (index == -1)
+    {
+        rejected_count++;
+        return DROPPED;
+    }
+
+    // The first fragment's header becomes the reassembled datagram's header
+    if (first == 0)
+    {
+        memcpy(datagrams[index].header, packet, header_length);
+        datagrams[index].header_length = header_length;
+    }
+
+    if (!fill(index, packet + header_length, first, end, last))
+    {
+        rejected_count++;
+        return DROPPED;
+    }
+
+    const Datagram& datagram = datagrams[index];
+    if (datagram.length == LENGTH_UNKNOWN || datagram.hole_count > 0)
+    {
+        return INCOMPLETE;
+    }
+
+    // Options in the first fragment could push a full-sized payload over
+    if (datagram.header_length + datagram.length > 65535)
+    {
+        release(index);
+        rejected_count++;
+        return DROPPED;
+    }
+
+    assemble(datagram);
+    release(index);
+    completed_count++;
+    return COMPLETE;
+}
+
+//==============================================================================
+// Handles one packet, timed by the steady clock
+//==============================================================================
+Ipv4Reassembler::Result Ipv4Reassembler::addFragment(
+    const std::uint8_t* packet,
+    unsigned int        size)
+{
+    return addFragment(
+        packet,
+        size,
+        std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+//==============================================================================
+// Drops everything that's timed out
+//==============================================================================
+void Ipv4Reassembler::expire(double now)
+{
+    std::uint64_t now_tick =
+        static_cast<std::uint64_t>(std::max(now, 0.0) / tick_length);
+
+    if (!ticking)
+    {
+        tick    = now_tick;
+        ticking = true;
+    }
+    else if (now_tick > tick)
+    {
+        advance(now_tick);
+    }
+}
+
+//==============================================================================
+// Finds or starts the datagram a fragment belongs to
+//==============================================================================
+std::int32_t Ipv4Reassembler::find(std::uint32_t source,
+                                   std::uint32_t destination,
+                                   std::uint16_t identification,
+                                   std::uint8_t  protocol)
+{
+    unsigned int bucket =
+        getBucket(source, destination, identification, protocol);
+
+    for (std::int32_t i = buckets[bucket]; i != -1;
+         i = datagrams[i].bucket_next)
+    {
+        const Datagram& datagram = datagrams[i];
+        if (datagram.source == source &&
+            datagram.destination == destination &&
+            datagram.identification == identification &&
+            datagram.protocol == protocol)
+        {
+            return i;
+        }
+    }
+
+    if (free_datagrams == -1 && !evictOldest(-1))
+    {
+        return -1;
+    }
+
+    std::int32_t index = free_datagrams;
+    Datagram&    datagram = datagrams[index];
+    free_datagrams = datagram.timer_next;
+
+    datagram.source         = source;
+    datagram.destination    = destination;
+    datagram.identification = identification;
+    datagram.protocol       = protocol;
+    datagram.header_length  = 0;
+    datagram.length         = LENGTH_UNKNOWN;
+    datagram.end_max        = 0;
+    datagram.holes[0].first = 0;
+    datagram.holes[0].end   = LENGTH_UNKNOWN;
+    datagram.hole_count     = 1;
+
+    for (unsigned int i = 0; i < sizeof(datagram.slabs) / sizeof(std::int32_t);
+         ++i)
+    {
+        datagram.slabs[i] = -1;
+    }
+
+    datagram.bucket_next = buckets[bucket];
+    buckets[bucket] = index;
+
+    // Deadlines only ever increase, so appending keeps each slot oldest first
+    datagram.deadline = tick + TIMER_TICKS;
+    unsigned int slot = datagram.deadline % TIMER_SLOTS;
+    datagram.timer_previous = timer_tails[slot];
+    datagram.timer_next     = -1;
+    if (timer_tails[slot] == -1)
+    {
+        timer_heads[slot] = index;
+    }
+    else
+    {
+        datagrams[timer_tails[slot]].timer_next = index;
+    }
+    timer_tails[slot] = index;
+
+    pending_count++;
+    return index;
+}
+
+//==============================================================================
+// Stores a fragment's payload and updates the holes it fills
+//==============================================================================
+bool Ipv4Reassembler::fill(std::int32_t        index,
+                           const std::uint8_t* payload,
+                           unsigned int        first,
+                           unsigned int        end,
+                           bool                last)
+{
+    Datagram& datagram = datagrams[index];
+
+    // Everything has to agree on where the datagram ends
+    if (last)
+    {
+        if ((datagram.length != LENGTH_UNKNOWN && datagram.length != end) ||
+            end < datagram.end_max)
+        {
+            release(index);
+            return false;
+        }
+
+        datagram.length = end;
+    }
+    else if (end > datagram.length)
+    {
+        release(index);
+        return false;
+    }
+
+    // Cut the fragment out of every hole it overlaps; each hole leaves at most
+    // a piece either side
+    Hole         holes[HOLES_MAX * 2];
+    unsigned int hole_count = 0;
+    for (unsigned int i = 0; i < datagram.hole_count; ++i)
+    {
+        Hole hole = datagram.holes[i];
+        if (last && hole.end > end)
+        {
+            hole.end = end;
+        }
+
+        if (hole.first >= hole.end)
+        {
+            continue;
+        }
+
+        if (end <= hole.first || first >= hole.end)
+        {
+            holes[hole_count++] = hole;
+            continue;
+        }
+
+        if (first > hole.first)
+        {
+            holes[hole_count].first = hole.first;
+            holes[hole_count].end   = first;
+            hole_count++;
+        }
+
+        if (end < hole.end)
+        {
+            holes[hole_count].first = end;
+            holes[hole_count].end   = hole.end;
+            hole_count++;
+        }
+    }
+
+    if (hole_count > HOLES_MAX)
+    {
+        release(index);
+        return false;
+    }
+
+    std::copy(holes, holes + hole_count, datagram.holes);
+    datagram.hole_count = hole_count;
+    datagram.end_max    = std::max(datagram.end_max, end);
+
+    // Copy the payload in a slab at a time, taking slabs as needed
+    for (unsigned int position = first; position < end;)
+    {
+        unsigned int slab = position / SLAB_SIZE;
+        if (datagram.slabs[slab] == -1)
+        {
+            if (free_slabs.empty() && !evictOldest(index))
+            {
+                release(index);
+                return false;
+            }
+
+            datagram.slabs[slab] = free_slabs.back();
+            free_slabs.pop_back();
+        }
+
+        unsigned int copy_end = std::min(end, (slab + 1) * SLAB_SIZE);
+        memcpy(&slab_memory[datagram.slabs[slab] * SLAB_SIZE +
+                            position % SLAB_SIZE],
+               payload + position - first,
+               copy_end - position);
+        position = copy_end;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Builds the finished datagram in 'output'
+//==============================================================================
+void Ipv4Reassembler::assemble(const Datagram& datagram)
+{
+    unsigned int header_length = datagram.header_length;
+    output_length = header_length + datagram.length;
+
+    std::uint8_t* header = &output[0];
+    memcpy(header, datagram.header, header_length);
+
+    // Fix up the total length, clear more fragments and the fragment offset
+    // (leaving don't fragment and the reserved bit alone) and recompute the
+    // checksum to match
+    header[2] = static_cast<std::uint8_t>(output_length >> 8);
+    header[3] = static_cast<std::uint8_t>(output_length);
+    header[6] &= 0xc0;
+    header[7] = 0;
+    header[10] = 0;
+    header[11] = 0;
+
+    std::uint32_t sum = 0;
+    for (unsigned int i = 0; i < header_length; i += 2)
+    {
+        sum += header[i] << 8 | header[i + 1];
+    }
+
+    while (sum >> 16)
+    {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    header[10] = static_cast<std::uint8_t>(~sum >> 8);
+    header[11] = static_cast<std::uint8_t>(~sum);
+
+    for (unsigned int position = 0; position < datagram.length;
+         position += SLAB_SIZE)
+    {
+        memcpy(header + header_length + position,
+               &slab_memory[datagram.slabs[position / SLAB_SIZE] * SLAB_SIZE],
+               std::min(SLAB_SIZE, datagram.length - position));
+    }
+}
+
+//==============================================================================
+// Unlinks a datagram from everything and returns its memory
+//==============================================================================
+void Ipv4Reassembler::release(std::int32_t index)
+{
+    Datagram& datagram = datagrams[index];
+
+    // No slab lies wholly past the furthest anything has reached
+    unsigned int slab_end = (datagram.end_max + SLAB_SIZE - 1) / SLAB_SIZE;
+    for (unsigned int i = 0; i < slab_end; ++i)
+    {
+        if (datagram.slabs[i] != -1)
+        {
+            free_slabs.push_back(datagram.slabs[i]);
+        }
+    }
+
+    std::int32_t* link = &buckets[getBucket(datagram.source,
+                                            datagram.destination,
+                                            datagram.identification,
+                                            datagram.protocol)];
+    while (*link != index)
+    {
+        link = &datagrams[*link].bucket_next;
+    }
+    *link = datagram.bucket_next;
+
+    unsigned int slot = datagram.deadline % TIMER_SLOTS;
+    if (datagram.timer_previous == -1)
+    {
+        timer_heads[slot] = datagram.timer_next;
+    }
+    else
+    {
+        datagrams[datagram.timer_previous].timer_next = datagram.timer_next;
+    }
+
+    if (datagram.timer_next == -1)
+    {
+        timer_tails[slot] = datagram.timer_previous;
+    }
+    else
+    {
+        datagrams[datagram.timer_next].timer_previous = datagram.timer_previous;
+    }
+
+    datagram.timer_next = free_datagrams;
+    free_datagrams = index;
+
+    pending_count--;
+}
+
+//==============================================================================
+// Makes room by dropping the oldest partial datagram
+//==============================================================================
+bool Ipv4Reassembler::evictOldest(std::int32_t keep)
+{
+    // Pending deadlines all lie within the next TIMER_TICKS ticks, so the
+    // first one found going forward from now is the oldest
+    for (unsigned int i = 1; i <= TIMER_TICKS; ++i)
+    {
+        unsigned int slot = (tick + i) % TIMER_SLOTS;
+        for (std::int32_t j = timer_heads[slot]; j != -1;
+             j = datagrams[j].timer_next)
+        {
+            if (j != keep)
+            {
+                release(j);
+                evicted_count++;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Moves the timer wheel forward, expiring whatever it passes over
+//==============================================================================
+void Ipv4Reassembler::advance(std::uint64_t now_tick)
+{
+    // Past a full turn of the wheel everything has expired anyway
+    std::uint64_t steps = std::min<std::uint64_t>(now_tick - tick, TIMER_SLOTS);
+    for (std::uint64_t i = 1; i <= steps; ++i)
+    {
+        unsigned int slot = (tick + i) % TIMER_SLOTS;
+        while (timer_heads[slot] != -1)
+        {
+            release(timer_heads[slot]);
+            expired_count++;
+        }
+    }
+
+    tick = now_tick;
+}
+
+//==============================================================================
+// Mixes the key into a bucket index
+//==============================================================================
+unsigned int Ipv4Reassembler::getBucket(std::uint32_t source,
+                                        std::uint32_t destination,
+                                        std::uint16_t identification,
+                                        std::uint8_t  protocol) const
+{
+    std::uint32_t hash = source ^ destination * 0x9e3779b1 ^
+        (static_cast<std::uint32_t>(identification) << 8 | protocol) *
+        0x85ebca6b;
+
+    hash ^= hash >> 16;
+    hash *= 0x7feb352d;
+    hash ^= hash >> 15;
+
+    return hash & (buckets.size() - 1);
+}
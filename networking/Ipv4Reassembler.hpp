@@ -0,0 +1,270 @@
+#if !defined IPV4_REASSEMBLER_HPP
+#define IPV4_REASSEMBLER_HPP
+
+#include <cstdint>
+#include <vector>
+
+// Puts fragmented IPv4 datagrams back together.  Fragments are matched up by
+// source, destination, identification and protocol, and their payloads are
+// copied into fixed-size slabs taken from a pool allocated up front; what's
+// still missing from each datagram is tracked as a short list of holes.  The
+// slab pool is the memory limit: when it or the table of datagrams runs out,
+// the oldest partial datagram is thrown away to make room.  Partial datagrams
+// that haven't been completed within the timeout are thrown away too, using a
+// timer wheel so expiry costs the same however many are pending.  Nothing is
+// allocated after construction, so the work done for each fragment has a fixed
+// upper bound however hostile the traffic.
+//
+// Overlapping fragments are accepted, with later data overwriting earlier.
+// Fragments that disagree about where the datagram ends cause the datagram to
+// be dropped.
+class Ipv4Reassembler
+{
+public:
+
+    // What became of a packet given to addFragment()
+    enum Result
+    {
+        // The packet wasn't a fragment and can be used as it is
+        NOT_FRAGMENT,
+
+        // The fragment was stored; the datagram isn't complete yet
+        INCOMPLETE,
+
+        // The fragment completed its datagram, which is available from
+        // getDatagram() until the next call
+        COMPLETE,
+
+        // The packet wasn't a well-formed IPv4 packet
+        INVALID,
+
+        // The fragment's datagram was dropped, because it was inconsistent or
+        // there was no room left for it
+        DROPPED
+    };
+
+    // Allocates a slab pool of 'memory_max' bytes and room for
+    // 'datagrams_max' partial datagrams at once.  Partial datagrams are
+    // dropped 'timeout' seconds after their first fragment arrived.  Throws
+    // std::invalid_argument if any of these leave no room for anything.
+    explicit Ipv4Reassembler(unsigned int memory_max = MEMORY_MAX_DEFAULT,
+                             unsigned int datagrams_max = DATAGRAMS_MAX_DEFAULT,
+                             double       timeout = 30.0);
+
+    // Does nothing
+    ~Ipv4Reassembler();
+
+    // Handles a packet starting with its IPv4 header, 'size' bytes of which
+    // are available at 'packet'.  'now' is the time in seconds on whatever
+    // monotonic clock the caller likes, as long as it's the same one every
+    // call; partial datagrams that have timed out as of 'now' are dropped
+    // first.
+    Result addFragment(const std::uint8_t* packet,
+                       unsigned int        size,
+                       double              now);
+
+    // Same as above but reads the time from std::chrono::steady_clock
+    Result addFragment(const std::uint8_t* packet, unsigned int size);
+
+    // Drops partial datagrams that have timed out as of 'now', for callers
+    // that want them gone even when no fragments are arriving
+    void expire(double now);
+
+    // After addFragment() returns COMPLETE, the reassembled datagram, header
+    // and all, with the fragmentation fields cleared and the length and
+    // checksum fixed up to match
+    const std::uint8_t* getDatagram() const;
+    unsigned int getDatagramLength() const;
+
+    // Returns the number of partial datagrams being held
+    unsigned int getPendingCount() const;
+
+    // Returns the number of datagrams completed
+    unsigned long getCompletedCount() const;
+
+    // Returns the number of partial datagrams dropped because they timed out
+    unsigned long getExpiredCount() const;
+
+    // Returns the number of partial datagrams dropped to make room for others
+    unsigned long getEvictedCount() const;
+
+    // Returns the number of packets addFragment() returned INVALID or DROPPED
+    // for
+    unsigned long getRejectedCount() const;
+
+    static const unsigned int MEMORY_MAX_DEFAULT    = 4 * 1024 * 1024;
+    static const unsigned int DATAGRAMS_MAX_DEFAULT = 1024;
+
+    // Fragment payloads are stored in pieces of this size; the memory limit
+    // is rounded down to a multiple of it
+    static const unsigned int SLAB_SIZE = 2048;
+
+    // Most holes a partial datagram can have before it's dropped; this bounds
+    // the work done per fragment
+    static const unsigned int HOLES_MAX = 16;
+
+    // Timeouts are tracked in ticks of this fraction of the timeout, so
+    // partial datagrams last between (TIMER_TICKS - 1) / TIMER_TICKS of the
+    // timeout and the full timeout
+    static const unsigned int TIMER_TICKS = 32;
+
+private:
+
+    // Offsets into a datagram's payload still waiting for data, from 'first'
+    // up to but not including 'end'
+    struct Hole
+    {
+        unsigned int first;
+        unsigned int end;
+    };
+
+    // One partial datagram.  Datagrams are chained together through indices
+    // into 'datagrams' rather than pointers: one chain per hash bucket, one
+    // per timer wheel slot, and one of unused datagrams.
+    struct Datagram
+    {
+        std::uint32_t source;
+        std::uint32_t destination;
+        std::uint16_t identification;
+        std::uint8_t  protocol;
+
+        // The first fragment's header, once it has arrived
+        std::uint8_t header[60];
+        unsigned int header_length;
+
+        // Payload length, once the last fragment has arrived
+        unsigned int length;
+
+        // Furthest into the payload any fragment has reached
+        unsigned int end_max;
+
+        Hole         holes[HOLES_MAX];
+        unsigned int hole_count;
+
+        // Index of the slab holding each SLAB_SIZE piece of the payload, or -1
+        std::int32_t slabs[65536 / SLAB_SIZE];
+
+        // Tick the datagram times out on
+        std::uint64_t deadline;
+
+        std::int32_t bucket_next;
+        std::int32_t timer_previous;
+        std::int32_t timer_next;
+    };
+
+    // Finds the datagram for a fragment, starting one if there isn't one yet;
+    // returns -1 if there's no room
+    std::int32_t find(std::uint32_t source,
+                      std::uint32_t destination,
+                      std::uint16_t identification,
+                      std::uint8_t  protocol);
+
+    // Adds a fragment's payload to a datagram; returns false if the datagram
+    // had to be dropped
+    bool fill(std::int32_t        index,
+              const std::uint8_t* payload,
+              unsigned int        first,
+              unsigned int        end,
+              bool                last);
+
+    // Copies a complete datagram into 'output'
+    void assemble(const Datagram& datagram);
+
+    // Returns a datagram and its slabs to the unused pools
+    void release(std::int32_t index);
+
+    // Drops the datagram that will time out soonest, other than 'keep';
+    // returns false if there isn't one
+    bool evictOldest(std::int32_t keep);
+
+    // Expires everything due up to the given tick
+    void advance(std::uint64_t tick);
+
+    // Returns the hash bucket for the given key
+    unsigned int getBucket(std::uint32_t source,
+                           std::uint32_t destination,
+                           std::uint16_t identification,
+                           std::uint8_t  protocol) const;
+
+    std::vector<Datagram> datagrams;
+
+    std::vector<std::uint8_t> slab_memory;
+
+    // Indices of unused slabs
+    std::vector<std::int32_t> free_slabs;
+
+    // Head of the chain of unused datagrams
+    std::int32_t free_datagrams;
+
+    // Head of each bucket's chain
+    std::vector<std::int32_t> buckets;
+
+    // Head and tail of each timer wheel slot's chain, oldest first
+    std::vector<std::int32_t> timer_heads;
+    std::vector<std::int32_t> timer_tails;
+
+    double tick_length;
+
+    std::uint64_t tick;
+
+    bool ticking;
+
+    std::vector<std::uint8_t> output;
+    unsigned int              output_length;
+
+    unsigned int pending_count;
+
+    unsigned long completed_count;
+    unsigned long expired_count;
+    unsigned long evicted_count;
+    unsigned long rejected_count;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    Ipv4Reassembler(const Ipv4Reassembler&);
+    Ipv4Reassembler& operator=(const Ipv4Reassembler&);
+};
+
+//==============================================================================
+inline const std::uint8_t* Ipv4Reassembler::getDatagram() const
+{
+    return &output[0];
+}
+
+//==============================================================================
+inline unsigned int Ipv4Reassembler::getDatagramLength() const
+{
+    return output_length;
+}
+
+//==============================================================================
+inline unsigned int Ipv4Reassembler::getPendingCount() const
+{
+    return pending_count;
+}
+
+//==============================================================================
+inline unsigned long Ipv4Reassembler::getCompletedCount() const
+{
+    return completed_count;
+}
+
+//==============================================================================
+inline unsigned long Ipv4Reassembler::getExpiredCount() const
+{
+    return expired_count;
+}
+
+//==============================================================================
+inline unsigned long Ipv4Reassembler::getEvictedCount() const
+{
+    return evicted_count;
+}
+
+//==============================================================================
+inline unsigned long Ipv4Reassembler::getRejectedCount() const
+{
+    return rejected_count;
+}
+
+#endif
@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Ipv4Reassembler_test.hpp"
+
+#include "Ipv4Header.hpp"
+#include "Ipv4HeaderView.hpp"
+#include "Ipv4Reassembler.hpp"
+
+#include "TestMacros.hpp"
+#include "misc.hpp"
+
+TEST_PROGRAM_MAIN(Ipv4Reassembler_test);
+
+//==============================================================================
+void Ipv4Reassembler_test::addTestCases()
+{
+    ADD_TEST_CASE(InOrder);
+    ADD_TEST_CASE(OutOfOrder);
+    ADD_TEST_CASE(Malformed);
+    ADD_TEST_CASE(Inconsistent);
+    ADD_TEST_CASE(Expiry);
+    ADD_TEST_CASE(MemoryLimit);
+    ADD_TEST_CASE(Flood);
+}
+
+//==============================================================================
+// Returns a payload of the given size that's unlikely to be mistaken for any
+// other
+//==============================================================================
+static std::vector<std::uint8_t> makePayload(unsigned int size,
+                                             unsigned int seed)
+{
+    std::vector<std::uint8_t> payload(size);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        payload[i] = static_cast<std::uint8_t>(i * 7 + seed);
+    }
+
+    return payload;
+}
+
+//==============================================================================
+// Builds the fragment of a UDP datagram carrying bytes 'first' up to 'end' of
+// its payload
+//==============================================================================
+static std::vector<std::uint8_t> makeFragment(
+    const std::vector<std::uint8_t>& payload,
+    unsigned int                     first,
+    unsigned int                     end,
+    bool                             more,
+    std::uint16_t                    identification,
+    const std::string&               source = "10.0.0.1")
+{
+    Ipv4Header header(Ipv4Header::UDP);
+    header.setTotalLength(Ipv4Header::LENGTH_BYTES + end - first);
+    header.setIdentification(identification);
+    header.setDontFragment(false);
+    header.setMoreFragments(more);
+    header.setFragmentOffset(first / 8);
+    header.setTtl(64);
+    *header.getSource()      = source;
+    *header.getDestination() = "10.0.0.2";
+
+    std::vector<std::uint8_t> packet(Ipv4Header::LENGTH_BYTES + end - first);
+    header.writeRaw(&packet[0], misc::ENDIAN_BIG);
+    std::copy(payload.begin() + first,
+              payload.begin() + end,
+              packet.begin() + Ipv4Header::LENGTH_BYTES);
+
+    return packet;
+}
+
+//==============================================================================
+// Feeds a fragment to the reassembler
+//==============================================================================
+static Ipv4Reassembler::Result add(Ipv4Reassembler&                 reassembler,
+                                   const std::vector<std::uint8_t>& fragment,
+                                   double                           now = 0.0)
+{
+    return reassembler.addFragment(&fragment[0], fragment.size(), now);
+}
+
+//==============================================================================
+// Returns true if the reassembler's last datagram is 'payload' behind a sound,
+// unfragmented header
+//==============================================================================
+static bool checkDatagram(const Ipv4Reassembler&           reassembler,
+                          const std::vector<std::uint8_t>& payload,
+                          std::uint16_t                    identification)
+{
+    const std::uint8_t* datagram = reassembler.getDatagram();
+    Ipv4HeaderView      header(datagram);
+
+    if (reassembler.getDatagramLength() !=
+            Ipv4Header::LENGTH_BYTES + payload.size() ||
+        header.getTotalLength() != reassembler.getDatagramLength() ||
+        header.isFragment() ||
+        header.getIdentification() != identification ||
+        header.getProtocol() != Ipv4Header::UDP)
+    {
+        return false;
+    }
+
+    // A header with a correct checksum sums to all ones
+    std::uint32_t sum = 0;
+    for (unsigned int i = 0; i < Ipv4Header::LENGTH_BYTES; i += 2)
+    {
+        sum += datagram[i] << 8 | datagram[i + 1];
+    }
+
+    while (sum >> 16)
+    {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    return sum == 0xffff &&
+           memcmp(header.getPayload(), &payload[0], payload.size()) == 0;
+}
+
+//==============================================================================
+Test::Result Ipv4Reassembler_test::InOrder::body()
+{
+    Ipv4Reassembler reassembler;
+
+    // Three fragments as they'd be cut for a 1500 byte MTU
+    std::vector<std::uint8_t> payload = makePayload(4000, 1);
+
+    MUST_BE_TRUE(add(reassembler, makeFragment(payload, 0, 1480, true, 1)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 1480, 2960, true, 1)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(reassembler.getPendingCount() == 1);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 2960, 4000, false, 1)) ==
+                 Ipv4Reassembler::COMPLETE);
+
+    MUST_BE_TRUE(checkDatagram(reassembler, payload, 1));
+    MUST_BE_TRUE(reassembler.getPendingCount() == 0);
+    MUST_BE_TRUE(reassembler.getCompletedCount() == 1);
+
+    // Unfragmented packets are left alone
+    Ipv4Header header(Ipv4Header::UDP);
+    header.setTotalLength(Ipv4Header::LENGTH_BYTES);
+    std::vector<std::uint8_t> packet(Ipv4Header::LENGTH_BYTES);
+    header.writeRaw(&packet[0], misc::ENDIAN_BIG);
+    MUST_BE_TRUE(add(reassembler, packet) == Ipv4Reassembler::NOT_FRAGMENT);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Reassembler_test::OutOfOrder::body()
+{
+    Ipv4Reassembler reassembler;
+
+    std::vector<std::uint8_t> payload1 = makePayload(5000, 1);
+    std::vector<std::uint8_t> payload2 = makePayload(3000, 2);
+
+    // Two datagrams interleaved, each arriving last fragment first, with
+    // duplicates and overlaps thrown in
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload1, 4000, 5000, false, 7)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload2, 2000, 3000, false, 7, "10.0.0.3"))
+                 == Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload1, 1000, 2000, true, 7)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload1, 1000, 2000, true, 7)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload2, 0, 2400, true, 7, "10.0.0.3")) ==
+                 Ipv4Reassembler::COMPLETE);
+    MUST_BE_TRUE(checkDatagram(reassembler, payload2, 7));
+
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload1, 1600, 4400, true, 7)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler, makeFragment(payload1, 0, 1000, true, 7)) ==
+                 Ipv4Reassembler::COMPLETE);
+    MUST_BE_TRUE(checkDatagram(reassembler, payload1, 7));
+
+    MUST_BE_TRUE(reassembler.getCompletedCount() == 2);
+    MUST_BE_TRUE(reassembler.getPendingCount() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Reassembler_test::Malformed::body()
+{
+    Ipv4Reassembler reassembler;
+
+    std::vector<std::uint8_t> payload = makePayload(2000, 3);
+
+    // Too short to hold a header
+    std::vector<std::uint8_t> fragment = makeFragment(payload, 0, 8, true, 1);
+    MUST_BE_TRUE(reassembler.addFragment(&fragment[0], 10, 0.0) ==
+                 Ipv4Reassembler::INVALID);
+
+    // Total length runs past the end of the buffer
+    MUST_BE_TRUE(reassembler.addFragment(&fragment[0], 24, 0.0) ==
+                 Ipv4Reassembler::INVALID);
+
+    // Not IPv4
+    fragment[0] = 0x65;
+    MUST_BE_TRUE(add(reassembler, fragment) == Ipv4Reassembler::INVALID);
+
+    // Fragments other than the last must carry a multiple of 8 bytes
+    MUST_BE_TRUE(add(reassembler, makeFragment(payload, 0, 1001, true, 1)) ==
+                 Ipv4Reassembler::INVALID);
+
+    // Nothing past where a datagram could possibly end
+    payload.resize(65535);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 65528, 65535, false, 1)) ==
+                 Ipv4Reassembler::INVALID);
+
+    MUST_BE_TRUE(reassembler.getPendingCount() == 0);
+    MUST_BE_TRUE(reassembler.getRejectedCount() == 5);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Reassembler_test::Inconsistent::body()
+{
+    Ipv4Reassembler reassembler;
+
+    std::vector<std::uint8_t> payload = makePayload(4000, 4);
+
+    // Two last fragments that disagree on the length
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 2000, 3000, false, 1)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 3000, 4000, false, 1)) ==
+                 Ipv4Reassembler::DROPPED);
+    MUST_BE_TRUE(reassembler.getPendingCount() == 0);
+
+    // Data past the end given by the last fragment
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 2000, 3000, false, 2)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 2400, 3200, true, 2)) ==
+                 Ipv4Reassembler::DROPPED);
+
+    // A last fragment ending short of data already seen
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 2000, 3200, true, 3)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 1000, 3000, false, 3)) ==
+                 Ipv4Reassembler::DROPPED);
+
+    MUST_BE_TRUE(reassembler.getPendingCount() == 0);
+    MUST_BE_TRUE(reassembler.getRejectedCount() == 3);
+
+    // Starting over after a drop works as normal
+    MUST_BE_TRUE(add(reassembler, makeFragment(payload, 0, 2000, true, 1)) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 2000, 4000, false, 1)) ==
+                 Ipv4Reassembler::COMPLETE);
+    MUST_BE_TRUE(checkDatagram(reassembler, payload, 1));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Reassembler_test::Expiry::body()
+{
+    Ipv4Reassembler reassembler(Ipv4Reassembler::MEMORY_MAX_DEFAULT,
+                                Ipv4Reassembler::DATAGRAMS_MAX_DEFAULT,
+                                1.0);
+
+    std::vector<std::uint8_t> payload = makePayload(2000, 5);
+
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 0, 1000, true, 1),
+                     100.0) == Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 0, 1000, true, 2),
+                     100.5) == Ipv4Reassembler::INCOMPLETE);
+
+    // Nothing goes before its time
+    reassembler.expire(100.9);
+    MUST_BE_TRUE(reassembler.getPendingCount() == 2);
+
+    // Datagrams go one by one as their timeouts pass, even if more of them
+    // turns up
+    reassembler.expire(101.1);
+    MUST_BE_TRUE(reassembler.getPendingCount() == 1);
+    MUST_BE_TRUE(reassembler.getExpiredCount() == 1);
+
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 1000, 2000, false, 1),
+                     101.2) == Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(reassembler.getPendingCount() == 2);
+
+    // A long gap clears out everything
+    reassembler.expire(1000.0);
+    MUST_BE_TRUE(reassembler.getPendingCount() == 0);
+    MUST_BE_TRUE(reassembler.getExpiredCount() == 3);
+
+    // Time going backwards doesn't upset anything
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 0, 1000, true, 3),
+                     500.0) == Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 1000, 2000, false, 3),
+                     1000.5) == Ipv4Reassembler::COMPLETE);
+    MUST_BE_TRUE(checkDatagram(reassembler, payload, 3));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Reassembler_test::MemoryLimit::body()
+{
+    // Not enough room in the table for a fourth datagram, or in the slabs for
+    // more than four slabs' worth
+    Ipv4Reassembler reassembler(Ipv4Reassembler::SLAB_SIZE * 4, 3);
+
+    std::vector<std::uint8_t> payload = makePayload(8000, 6);
+
+    for (std::uint16_t i = 1; i <= 4; ++i)
+    {
+        MUST_BE_TRUE(add(reassembler,
+                         makeFragment(payload, 0, 1000, true, i),
+                         i) == Ipv4Reassembler::INCOMPLETE);
+    }
+
+    // The oldest went to make room
+    MUST_BE_TRUE(reassembler.getPendingCount() == 3);
+    MUST_BE_TRUE(reassembler.getEvictedCount() == 1);
+
+    // Datagram 1 is gone, so this starts it over rather than completing it
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 1000, 2000, false, 1), 5.0) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(reassembler.getEvictedCount() == 2);
+
+    // A datagram that needs every slab pushes everything else out
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 0, 4096, true, 5), 6.0) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 4096, 8000, false, 5), 6.0) ==
+                 Ipv4Reassembler::COMPLETE);
+    MUST_BE_TRUE(checkDatagram(reassembler, payload, 5));
+
+    // One that needs more than every slab can never complete
+    payload.resize(10000);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 0, 8192, true, 6), 7.0) ==
+                 Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(payload, 8192, 10000, false, 6), 7.0) ==
+                 Ipv4Reassembler::DROPPED);
+    MUST_BE_TRUE(reassembler.getPendingCount() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4Reassembler_test::Flood::body()
+{
+    const unsigned int DATAGRAMS_MAX = 64;
+    const unsigned int FRAGMENTS     = 100000;
+
+    Ipv4Reassembler reassembler(Ipv4Reassembler::SLAB_SIZE * 32,
+                                DATAGRAMS_MAX,
+                                1.0);
+
+    std::vector<std::uint8_t> payload = makePayload(65000, 7);
+
+    // Random fragments of random datagrams, most of which will never complete;
+    // none of it should get the reassembler into trouble
+    srand(1);
+    for (unsigned int i = 0; i < FRAGMENTS; ++i)
+    {
+        unsigned int first = (rand() % 8000) * 8;
+        unsigned int end   = first + (rand() % 180 + 1) * 8;
+        bool         more  = rand() % 4 != 0;
+
+        std::vector<std::uint8_t> fragment =
+            makeFragment(payload, first, std::min(end, 65000u), more,
+                         rand() % 1000);
+        add(reassembler, fragment, i * 0.0001);
+
+        MUST_BE_TRUE(reassembler.getPendingCount() <= DATAGRAMS_MAX);
+    }
+
+    // Everything still works afterwards, once the leftovers have timed out
+    std::vector<std::uint8_t> small = makePayload(3000, 8);
+    MUST_BE_TRUE(add(reassembler, makeFragment(small, 0, 1504, true, 2000),
+                     20.0) == Ipv4Reassembler::INCOMPLETE);
+    MUST_BE_TRUE(add(reassembler,
+                     makeFragment(small, 1504, 3000, false, 2000),
+                     20.0) == Ipv4Reassembler::COMPLETE);
+    MUST_BE_TRUE(checkDatagram(reassembler, small, 2000));
+    MUST_BE_TRUE(reassembler.getPendingCount() == 0);
+
+    return Test::PASSED;
+}
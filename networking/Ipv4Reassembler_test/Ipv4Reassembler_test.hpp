@@ -0,0 +1,20 @@
+#if !defined IPV4_REASSEMBLER_TEST
+#define IPV4_REASSEMBLER_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(Ipv4Reassembler_test)
+
+    TEST(InOrder)
+    TEST(OutOfOrder)
+    TEST(Malformed)
+    TEST(Inconsistent)
+    TEST(Expiry)
+    TEST(MemoryLimit)
+    TEST(Flood)
+
+TEST_CASES_END(Ipv4Reassembler_test)
+
+#endif
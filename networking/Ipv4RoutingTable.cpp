@@ -0,0 +1,360 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#if defined LINUX
+#include <sys/mman.h>
+#endif
+
+#include "Ipv4RoutingTable.hpp"
+
+#include "Ipv4Address.hpp"
+#include "Ipv4Prefix.hpp"
+
+const std::uint32_t Ipv4RoutingTable::VALUE_MAX;
+const unsigned int  Ipv4RoutingTable::GROUPS_MAX;
+const std::uint32_t Ipv4RoutingTable::VALID;
+const std::uint32_t Ipv4RoutingTable::GROUP;
+const unsigned int  Ipv4RoutingTable::GROUP_SIZE;
+const std::size_t   Ipv4RoutingTable::TBL24_SIZE;
+
+// Where the prefix length sits in an entry
+static const unsigned int LENGTH_SHIFT = 24;
+
+//==============================================================================
+// Allocates both levels, every entry invalid and every group free
+//==============================================================================
+Ipv4RoutingTable::Ipv4RoutingTable(unsigned int groups_max) :
+    tbl24(0),
+    groups_max(groups_max),
+    prefix_count(0)
+{
+    if (groups_max == 0 || groups_max > GROUPS_MAX)
+    {
+        throw std::invalid_argument("Routing tables need between 1 and "
+                                    "GROUPS_MAX second-level groups");
+    }
+
+    std::vector<std::atomic<std::uint32_t>>(groups_max * GROUP_SIZE).swap(
+        tbl8);
+
+#if defined LINUX
+    // Anonymous memory comes zeroed, which is every entry invalid.  Huge
+    // pages are only a hint; the table works the same without them.
+    std::size_t size = TBL24_SIZE * sizeof(std::atomic<std::uint32_t>);
+    void* memory = mmap(0,
+                        size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1,
+                        0);
+    if (memory == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+
+    madvise(memory, size, MADV_HUGEPAGE);
+    tbl24 = static_cast<std::atomic<std::uint32_t>*>(memory);
+#else
+    tbl24 = new std::atomic<std::uint32_t>[TBL24_SIZE]();
+#endif
+
+    // Handed out lowest first
+    free_groups.reserve(groups_max);
+    for (unsigned int i = groups_max; i > 0; --i)
+    {
+        free_groups.push_back(i - 1);
+    }
+}
+
+//==============================================================================
+Ipv4RoutingTable::~Ipv4RoutingTable()
+{
+#if defined LINUX
+    munmap(tbl24, TBL24_SIZE * sizeof(std::atomic<std::uint32_t>));
+#else
+    delete[] tbl24;
+#endif
+}
+
+//==============================================================================
+// Expands the prefix over every entry it's now the longest match for
+//==============================================================================
+bool Ipv4RoutingTable::insert(const Ipv4Prefix& prefix, std::uint32_t value)
+{
+    if (value > VALUE_MAX)
+    {
+        return false;
+    }
+
+    std::uint32_t address = prefix.getAddress();
+    unsigned int  length  = prefix.getLength();
+    std::uint32_t entry   = makeEntry(length, value);
+
+    if (length <= 24)
+    {
+        unsigned int first = address >> 8;
+        unsigned int count = 1 << (24 - length);
+
+        for (unsigned int i = first; i < first + count; ++i)
+        {
+            std::uint32_t current = tbl24[i].load(std::memory_order_relaxed);
+            if (current & GROUP)
+            {
+                overwrite((current & VALUE_MAX) * GROUP_SIZE,
+                          GROUP_SIZE,
+                          entry,
+                          length);
+            }
+            else if (getLength(current) <= length)
+            {
+                tbl24[i].store(entry, std::memory_order_release);
+            }
+        }
+    }
+    else
+    {
+        std::atomic<std::uint32_t>& parent = tbl24[address >> 8];
+        std::uint32_t current = parent.load(std::memory_order_relaxed);
+
+        // A /24 getting its first long prefix needs a group, filled in with
+        // what the whole /24 looked up as before, and only then linked in
+        if (!(current & GROUP))
+        {
+            if (free_groups.empty())
+            {
+                return false;
+            }
+
+            unsigned int group = free_groups.back();
+            free_groups.pop_back();
+
+            for (unsigned int i = 0; i < GROUP_SIZE; ++i)
+            {
+                tbl8[group * GROUP_SIZE + i].store(current,
+                                                   std::memory_order_relaxed);
+            }
+
+            current = GROUP | group;
+            parent.store(current, std::memory_order_release);
+        }
+
+        overwrite((current & VALUE_MAX) * GROUP_SIZE + (address & 0xff),
+                  1 << (32 - length),
+                  entry,
+                  length);
+    }
+
+    std::pair<std::unordered_map<std::uint32_t, std::uint32_t>::iterator,
+              bool> inserted = prefixes[length].insert(
+                  std::make_pair(address, value));
+    if (inserted.second)
+    {
+        prefix_count++;
+    }
+    else
+    {
+        inserted.first->second = value;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Hands the prefix's entries back to the next longest prefix, retiring a
+// group if it no longer holds anything longer than a /24
+//==============================================================================
+bool Ipv4RoutingTable::remove(const Ipv4Prefix& prefix)
+{
+    std::uint32_t address = prefix.getAddress();
+    unsigned int  length  = prefix.getLength();
+
+    if (prefixes[length].erase(address) == 0)
+    {
+        return false;
+    }
+
+    prefix_count--;
+
+    std::uint32_t replacement = findParent(address, length);
+
+    if (length <= 24)
+    {
+        unsigned int first = address >> 8;
+        unsigned int count = 1 << (24 - length);
+
+        for (unsigned int i = first; i < first + count; ++i)
+        {
+            std::uint32_t current = tbl24[i].load(std::memory_order_relaxed);
+            if (current & GROUP)
+            {
+                replace((current & VALUE_MAX) * GROUP_SIZE,
+                        GROUP_SIZE,
+                        replacement,
+                        length);
+            }
+            else if ((current & VALID) && getLength(current) == length)
+            {
+                tbl24[i].store(replacement, std::memory_order_release);
+            }
+        }
+
+        return true;
+    }
+
+    std::atomic<std::uint32_t>& parent = tbl24[address >> 8];
+    unsigned int group = parent.load(std::memory_order_relaxed) & VALUE_MAX;
+    unsigned int base  = group * GROUP_SIZE;
+
+    replace(base + (address & 0xff), 1 << (32 - length), replacement, length);
+
+    // With no long prefixes left every entry in the group came from the same
+    // prefix (or none), so the group can go and its first-level entry take
+    // that prefix's value directly
+    for (unsigned int i = 0; i < GROUP_SIZE; ++i)
+    {
+        if (getLength(tbl8[base + i].load(std::memory_order_relaxed)) > 24)
+        {
+            return true;
+        }
+    }
+
+    parent.store(tbl8[base].load(std::memory_order_relaxed),
+                 std::memory_order_release);
+    retired_groups.push_back(group);
+
+    return true;
+}
+
+//==============================================================================
+// Looks the prefix up in the per-length maps
+//==============================================================================
+bool Ipv4RoutingTable::find(const Ipv4Prefix& prefix,
+                            std::uint32_t&    value) const
+{
+    std::unordered_map<std::uint32_t, std::uint32_t>::const_iterator i =
+        prefixes[prefix.getLength()].find(prefix.getAddress());
+    if (i == prefixes[prefix.getLength()].end())
+    {
+        return false;
+    }
+
+    value = i->second;
+    return true;
+}
+
+//==============================================================================
+// Converts the address and calls the other lookup
+//==============================================================================
+bool Ipv4RoutingTable::lookup(const Ipv4Address& address,
+                              std::uint32_t&     value) const
+{
+    return lookup(address.toUint32(), value);
+}
+
+//==============================================================================
+// Looks every address up in turn; no lookup depends on another, so the
+// processor overlaps their cache misses without help
+//==============================================================================
+unsigned int Ipv4RoutingTable::lookup(const std::uint32_t* addresses,
+                                      std::uint32_t*       values,
+                                      unsigned int         count,
+                                      std::uint32_t        miss_value) const
+{
+    unsigned int found = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        std::uint32_t value;
+        bool hit = lookup(addresses[i], value);
+        values[i] = hit ? value : miss_value;
+        found += hit;
+    }
+
+    return found;
+}
+
+//==============================================================================
+// Moves every retired group to the free list
+//==============================================================================
+void Ipv4RoutingTable::reclaim()
+{
+    free_groups.insert(free_groups.end(),
+                       retired_groups.begin(),
+                       retired_groups.end());
+    retired_groups.clear();
+}
+
+//==============================================================================
+// Packs a prefix length and value into an entry
+//==============================================================================
+std::uint32_t Ipv4RoutingTable::makeEntry(unsigned int  length,
+                                          std::uint32_t value)
+{
+    return VALID | length << LENGTH_SHIFT | value;
+}
+
+//==============================================================================
+// Unpacks the prefix length from an entry
+//==============================================================================
+unsigned int Ipv4RoutingTable::getLength(std::uint32_t entry)
+{
+    return entry >> LENGTH_SHIFT & 0x3f;
+}
+
+//==============================================================================
+// Tries every shorter prefix length, longest first
+//==============================================================================
+std::uint32_t Ipv4RoutingTable::findParent(std::uint32_t address,
+                                           unsigned int  length) const
+{
+    for (unsigned int i = length; i > 0; --i)
+    {
+        std::unordered_map<std::uint32_t, std::uint32_t>::const_iterator
+            parent = prefixes[i - 1].find(address & Ipv4Prefix::getMask(i - 1));
+        if (parent != prefixes[i - 1].end())
+        {
+            return makeEntry(i - 1, parent->second);
+        }
+    }
+
+    return 0;
+}
+
+//==============================================================================
+// Overwrites second-level entries no more specific than the new prefix
+//==============================================================================
+void Ipv4RoutingTable::overwrite(unsigned int  first,
+                                 unsigned int  count,
+                                 std::uint32_t entry,
+                                 unsigned int  length)
+{
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+        if (getLength(tbl8[i].load(std::memory_order_relaxed)) <= length)
+        {
+            tbl8[i].store(entry, std::memory_order_relaxed);
+        }
+    }
+}
+
+//==============================================================================
+// Replaces second-level entries that came from the removed prefix
+//==============================================================================
+void Ipv4RoutingTable::replace(unsigned int  first,
+                               unsigned int  count,
+                               std::uint32_t replacement,
+                               unsigned int  length)
+{
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+        std::uint32_t current = tbl8[i].load(std::memory_order_relaxed);
+        if ((current & VALID) && getLength(current) == length)
+        {
+            tbl8[i].store(replacement, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,193 @@
+#if !defined IPV4_ROUTING_TABLE_HPP
+#define IPV4_ROUTING_TABLE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Ipv4Address.hpp"
+#include "Ipv4Prefix.hpp"
+
+// Maps IPv4 prefixes to values (route, subnet or class numbers, say) and
+// finds the value of the longest prefix containing a given address.
+//
+// Prefixes are expanded into a DIR-24-8 layout.  A first-level array has an
+// entry for every /24, holding the value of the longest prefix of 24 bits or
+// fewer covering it, or else pointing to a group of 256 second-level entries,
+// one per address in the /24, for /24s that longer prefixes fall in.  A lookup
+// is one or two array loads whatever the number of prefixes; the price is
+// 64 MiB for the first level, plus 1 KiB for each second-level group.  On
+// Linux the first level asks for transparent huge pages, so random lookups
+// don't miss in the TLB as well as the cache.
+// Addresses are numbers in host byte order, as from Ipv4Address::toUint32().
+//
+// Only one thread may change the table at a time.  Any number of other threads
+// may look addresses up at the same time without locking: every entry is
+// written atomically, so while a prefix is being added or removed a lookup
+// gets either the value from before the change or the value from after it.
+// A group that's no longer needed once a prefix is removed is retired rather
+// than freed, since lookups that started before the removal may still be
+// reading it.  Retired groups are only reused after reclaim().
+class Ipv4RoutingTable
+{
+public:
+
+    // Allocates the first level and 'groups_max' second-level groups, which
+    // limits how many /24s may hold prefixes longer than 24 bits at once.
+    // Throws std::invalid_argument if 'groups_max' is 0 or more than
+    // GROUPS_MAX.
+    explicit Ipv4RoutingTable(unsigned int groups_max = 1024);
+
+    // Frees both levels
+    ~Ipv4RoutingTable();
+
+    // Adds 'prefix' with the given value, or changes its value if it's
+    // already in the table.  Returns false, changing nothing, if 'value' is
+    // more than VALUE_MAX or the prefix needs a second-level group and there
+    // are none free.
+    bool insert(const Ipv4Prefix& prefix, std::uint32_t value);
+
+    // Removes 'prefix'; addresses in it go back to the value of the next
+    // longest prefix containing them.  Returns false if it isn't in the
+    // table.
+    bool remove(const Ipv4Prefix& prefix);
+
+    // Copies out the value 'prefix' itself (and not some shorter prefix
+    // containing it) was added with; returns false if it isn't in the table.
+    // Must be called from the thread changing the table.
+    bool find(const Ipv4Prefix& prefix, std::uint32_t& value) const;
+
+    // Copies out the value of the longest prefix containing 'address';
+    // returns false if no prefix contains it.  Safe to call from any thread.
+    bool lookup(std::uint32_t address, std::uint32_t& value) const;
+    bool lookup(const Ipv4Address& address, std::uint32_t& value) const;
+
+    // Looks up 'count' addresses at once, storing each one's value in
+    // 'values' or 'miss_value' for those no prefix contains.  Returns the
+    // number of addresses found.  Safe to call from any thread.
+    unsigned int lookup(const std::uint32_t* addresses,
+                        std::uint32_t*       values,
+                        unsigned int         count,
+                        std::uint32_t        miss_value) const;
+
+    // Makes groups retired by remove() available again.  Must only be called
+    // once every lookup that was under way when they were retired has
+    // finished; a lookup still reading a group when it's reused could return
+    // a value belonging to some other /24.
+    void reclaim();
+
+    // Returns the number of prefixes in the table
+    unsigned int getPrefixCount() const;
+
+    // Returns the number of second-level groups holding entries, retired
+    // ones not included
+    unsigned int getGroupCount() const;
+
+    // Returns the number of groups retired and waiting for reclaim()
+    unsigned int getRetiredCount() const;
+
+    // Largest value a prefix can have
+    static const std::uint32_t VALUE_MAX = 0xffffff;
+
+    // Most second-level groups a table can have
+    static const unsigned int GROUPS_MAX = 0x1000000;
+
+private:
+
+    // Entries are a valid bit, a bit saying the entry points to a group, six
+    // bits of prefix length and 24 bits of value or group number
+    static const std::uint32_t VALID = 0x80000000;
+    static const std::uint32_t GROUP = 0x40000000;
+
+    // Second-level entries per group, one per address in a /24
+    static const unsigned int GROUP_SIZE = 256;
+
+    // First-level entries, one per /24
+    static const std::size_t TBL24_SIZE = 1 << 24;
+
+    // Returns the entry for a prefix of the given length and value
+    static std::uint32_t makeEntry(unsigned int length, std::uint32_t value);
+
+    // Returns the length of the prefix an entry came from, or 0 if it's
+    // invalid
+    static unsigned int getLength(std::uint32_t entry);
+
+    // Returns the entry for the longest prefix in the table shorter than
+    // 'length' that contains 'address', or an invalid entry if there isn't
+    // one
+    std::uint32_t findParent(std::uint32_t address, unsigned int length) const;
+
+    // Writes 'entry', from a prefix of length 'length', over every one of
+    // 'count' second-level entries starting at 'first' that came from a
+    // prefix no longer than it, or from no prefix
+    void overwrite(unsigned int  first,
+                   unsigned int  count,
+                   std::uint32_t entry,
+                   unsigned int  length);
+
+    // Writes 'replacement' over every one of 'count' second-level entries
+    // starting at 'first' that came from a prefix of length 'length'
+    void replace(unsigned int  first,
+                 unsigned int  count,
+                 std::uint32_t replacement,
+                 unsigned int  length);
+
+    // One entry per /24, TBL24_SIZE in all
+    std::atomic<std::uint32_t>* tbl24;
+
+    // GROUP_SIZE entries per group
+    std::vector<std::atomic<std::uint32_t>> tbl8;
+
+    // Groups ready for use, and groups waiting for reclaim()
+    std::vector<unsigned int> free_groups;
+    std::vector<unsigned int> retired_groups;
+
+    unsigned int groups_max;
+
+    // Every prefix's value, by prefix length and then prefix address
+    std::unordered_map<std::uint32_t, std::uint32_t> prefixes[33];
+
+    unsigned int prefix_count;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    Ipv4RoutingTable(const Ipv4RoutingTable&);
+    Ipv4RoutingTable& operator=(const Ipv4RoutingTable&);
+};
+
+//==============================================================================
+inline bool Ipv4RoutingTable::lookup(std::uint32_t  address,
+                                     std::uint32_t& value) const
+{
+    std::uint32_t entry = tbl24[address >> 8].load(std::memory_order_acquire);
+    if (entry & GROUP)
+    {
+        entry = tbl8[(entry & VALUE_MAX) * GROUP_SIZE + (address & 0xff)].load(
+            std::memory_order_relaxed);
+    }
+
+    value = entry & VALUE_MAX;
+    return entry & VALID;
+}
+
+//==============================================================================
+inline unsigned int Ipv4RoutingTable::getPrefixCount() const
+{
+    return prefix_count;
+}
+
+//==============================================================================
+inline unsigned int Ipv4RoutingTable::getGroupCount() const
+{
+    return groups_max - free_groups.size() - retired_groups.size();
+}
+
+//==============================================================================
+inline unsigned int Ipv4RoutingTable::getRetiredCount() const
+{
+    return retired_groups.size();
+}
+
+#endif
@@ -0,0 +1,411 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Ipv4RoutingTable_test.hpp"
+
+#include "Ipv4Address.hpp"
+#include "Ipv4Prefix.hpp"
+#include "Ipv4RoutingTable.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(Ipv4RoutingTable_test);
+
+// Prefixes by length and address, as the table being checked should hold them
+typedef std::map<std::pair<unsigned int, std::uint32_t>, std::uint32_t>
+Reference;
+
+//==============================================================================
+void Ipv4RoutingTable_test::addTestCases()
+{
+    ADD_TEST_CASE(LongestMatch);
+    ADD_TEST_CASE(Remove);
+    ADD_TEST_CASE(Groups);
+    ADD_TEST_CASE(Batch);
+    ADD_TEST_CASE(Random);
+    ADD_TEST_CASE(Concurrent);
+}
+
+//==============================================================================
+// Returns the value a lookup of 'address' gives, or -1 if there isn't one
+//==============================================================================
+static long lookup(const Ipv4RoutingTable& table, const std::string& address)
+{
+    std::uint32_t value = 0;
+    if (!table.lookup(Ipv4Address(address), value))
+    {
+        return -1;
+    }
+
+    return value;
+}
+
+//==============================================================================
+// Finds the longest match for 'address' the slow way
+//==============================================================================
+static long lookup(const Reference& reference, std::uint32_t address)
+{
+    for (unsigned int length = 33; length > 0; --length)
+    {
+        Ipv4Prefix prefix(address, length - 1);
+        Reference::const_iterator i = reference.find(
+            std::make_pair(length - 1, prefix.getAddress()));
+        if (i != reference.end())
+        {
+            return i->second;
+        }
+    }
+
+    return -1;
+}
+
+//==============================================================================
+Test::Result Ipv4RoutingTable_test::LongestMatch::body()
+{
+    Ipv4RoutingTable table;
+    MUST_BE_TRUE(lookup(table, "10.1.2.3") == -1);
+
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.0.0/8"), 8));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.0.0/16"), 16));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.2.0/24"), 24));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.2.128/25"), 25));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.2.200/32"), 32));
+    MUST_BE_TRUE(table.getPrefixCount() == 5);
+
+    MUST_BE_TRUE(lookup(table, "10.200.0.1") == 8);
+    MUST_BE_TRUE(lookup(table, "10.1.3.1") == 16);
+    MUST_BE_TRUE(lookup(table, "10.1.2.127") == 24);
+    MUST_BE_TRUE(lookup(table, "10.1.2.128") == 25);
+    MUST_BE_TRUE(lookup(table, "10.1.2.200") == 32);
+    MUST_BE_TRUE(lookup(table, "10.1.2.201") == 25);
+    MUST_BE_TRUE(lookup(table, "11.0.0.0") == -1);
+
+    // Shorter prefixes added afterwards don't hide longer ones, and the
+    // default route catches everything else
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.0.0/15"), 15));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("0.0.0.0/0"), 0));
+    MUST_BE_TRUE(lookup(table, "10.1.2.200") == 32);
+    MUST_BE_TRUE(lookup(table, "10.1.3.1") == 16);
+    MUST_BE_TRUE(lookup(table, "10.0.0.1") == 15);
+    MUST_BE_TRUE(lookup(table, "11.0.0.0") == 0);
+
+    // Inserting again changes the value
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.2.0/24"), 99));
+    MUST_BE_TRUE(table.getPrefixCount() == 7);
+    MUST_BE_TRUE(lookup(table, "10.1.2.127") == 99);
+    MUST_BE_TRUE(lookup(table, "10.1.2.128") == 25);
+
+    std::uint32_t value = 0;
+    MUST_BE_TRUE(table.find(Ipv4Prefix("10.1.2.0/24"), value));
+    MUST_BE_TRUE(value == 99);
+    MUST_BE_FALSE(table.find(Ipv4Prefix("10.1.2.0/23"), value));
+
+    MUST_BE_FALSE(table.insert(Ipv4Prefix("10.9.0.0/16"),
+                               Ipv4RoutingTable::VALUE_MAX + 1));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("255.255.255.255/32"),
+                              Ipv4RoutingTable::VALUE_MAX));
+    MUST_BE_TRUE(lookup(table, "255.255.255.255") ==
+                 Ipv4RoutingTable::VALUE_MAX);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4RoutingTable_test::Remove::body()
+{
+    Ipv4RoutingTable table;
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.0.0/8"), 8));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.2.0/24"), 24));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.2.0/30"), 30));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.2.2/32"), 32));
+
+    MUST_BE_FALSE(table.remove(Ipv4Prefix("10.1.0.0/16")));
+    MUST_BE_FALSE(table.remove(Ipv4Prefix("10.1.2.0/31")));
+
+    // Addresses fall back to the next longest prefix, whichever level it's in
+    MUST_BE_TRUE(table.remove(Ipv4Prefix("10.1.2.0/30")));
+    MUST_BE_TRUE(lookup(table, "10.1.2.1") == 24);
+    MUST_BE_TRUE(lookup(table, "10.1.2.2") == 32);
+    MUST_BE_TRUE(table.getGroupCount() == 1);
+
+    MUST_BE_TRUE(table.remove(Ipv4Prefix("10.1.2.0/24")));
+    MUST_BE_TRUE(lookup(table, "10.1.2.1") == 8);
+    MUST_BE_TRUE(lookup(table, "10.1.2.2") == 32);
+
+    // The last long prefix in a /24 takes its group with it
+    MUST_BE_TRUE(table.remove(Ipv4Prefix("10.1.2.2/32")));
+    MUST_BE_TRUE(lookup(table, "10.1.2.2") == 8);
+    MUST_BE_TRUE(table.getGroupCount() == 0);
+    MUST_BE_TRUE(table.getRetiredCount() == 1);
+
+    MUST_BE_TRUE(table.remove(Ipv4Prefix("10.0.0.0/8")));
+    MUST_BE_TRUE(lookup(table, "10.1.2.2") == -1);
+    MUST_BE_TRUE(table.getPrefixCount() == 0);
+
+    // The default route comes out like any other
+    MUST_BE_TRUE(table.insert(Ipv4Prefix(), 1));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.1.2.3/32"), 32));
+    MUST_BE_TRUE(table.remove(Ipv4Prefix()));
+    MUST_BE_TRUE(lookup(table, "10.1.2.4") == -1);
+    MUST_BE_TRUE(lookup(table, "10.1.2.3") == 32);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4RoutingTable_test::Groups::body()
+{
+    bool thrown = false;
+    try
+    {
+        Ipv4RoutingTable table(0);
+    }
+    catch (std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    MUST_BE_TRUE(thrown);
+
+    Ipv4RoutingTable table(2);
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.0.0/8"), 8));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.1.0/25"), 1));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.2.0/25"), 2));
+    MUST_BE_TRUE(table.getGroupCount() == 2);
+
+    // A third /24 with a long prefix doesn't fit, and nothing changes
+    MUST_BE_FALSE(table.insert(Ipv4Prefix("10.0.3.0/25"), 3));
+    MUST_BE_TRUE(table.getPrefixCount() == 3);
+    MUST_BE_TRUE(lookup(table, "10.0.3.1") == 8);
+
+    // Short prefixes and long ones in /24s that already have a group still go
+    // in
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.1.128/25"), 4));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.0.0/16"), 16));
+    MUST_BE_TRUE(lookup(table, "10.0.1.129") == 4);
+    MUST_BE_TRUE(lookup(table, "10.0.2.200") == 16);
+
+    // A retired group can't be used again until it's reclaimed
+    MUST_BE_TRUE(table.remove(Ipv4Prefix("10.0.1.0/25")));
+    MUST_BE_TRUE(table.remove(Ipv4Prefix("10.0.1.128/25")));
+    MUST_BE_TRUE(table.getGroupCount() == 1);
+    MUST_BE_TRUE(table.getRetiredCount() == 1);
+    MUST_BE_TRUE(lookup(table, "10.0.1.129") == 16);
+    MUST_BE_FALSE(table.insert(Ipv4Prefix("10.0.3.0/25"), 3));
+
+    table.reclaim();
+    MUST_BE_TRUE(table.getRetiredCount() == 0);
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.3.0/25"), 3));
+    MUST_BE_TRUE(lookup(table, "10.0.3.1") == 3);
+    MUST_BE_TRUE(lookup(table, "10.0.3.129") == 16);
+    MUST_BE_TRUE(table.getGroupCount() == 2);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4RoutingTable_test::Batch::body()
+{
+    Ipv4RoutingTable table;
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.0.0/9"), 9));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.5.0/24"), 24));
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.5.64/26"), 26));
+
+    const unsigned int COUNT = 1000;
+    const std::uint32_t MISS = 0xffffffff;
+
+    srand(45);
+    std::vector<std::uint32_t> addresses(COUNT);
+    for (unsigned int i = 0; i < COUNT; ++i)
+    {
+        // Mostly in 10.0.5.0/24, some elsewhere in 10/8
+        addresses[i] = 0x0a000500 | (rand() & 0xff);
+        if (i % 3 == 0)
+        {
+            addresses[i] ^= static_cast<std::uint32_t>(rand() & 0xff) << 16;
+        }
+    }
+
+    std::vector<std::uint32_t> values(COUNT);
+    unsigned int found = table.lookup(&addresses[0], &values[0], COUNT, MISS);
+
+    unsigned int expected_found = 0;
+    for (unsigned int i = 0; i < COUNT; ++i)
+    {
+        std::uint32_t value = 0;
+        if (table.lookup(addresses[i], value))
+        {
+            expected_found++;
+            MUST_BE_TRUE(values[i] == value);
+        }
+        else
+        {
+            MUST_BE_TRUE(values[i] == MISS);
+        }
+    }
+
+    MUST_BE_TRUE(found == expected_found);
+    MUST_BE_TRUE(found > 0 && found < COUNT);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4RoutingTable_test::Random::body()
+{
+    // Prefixes are kept to 10.0.0.0/14 so they pile up on each other
+    const std::uint32_t BASE = 0x0a000000;
+    const unsigned int  ROUNDS = 20000;
+
+    Ipv4RoutingTable table(1024);
+    Reference        reference;
+
+    srand(4545);
+    for (unsigned int round = 0; round < ROUNDS; ++round)
+    {
+        // Now and then a prefix covering the whole region, or more
+        unsigned int length = 14 + rand() % 19;
+        if (rand() % 64 == 0)
+        {
+            length = 8 + rand() % 6;
+        }
+
+        std::uint32_t address = BASE | (static_cast<std::uint32_t>(rand()) &
+                                        0x3ffff);
+        Ipv4Prefix prefix(address, length);
+        std::pair<unsigned int, std::uint32_t> key(length,
+                                                   prefix.getAddress());
+
+        // Removing and adding about as often keeps the table a steady size
+        if (rand() % 2 == 0 && !reference.empty())
+        {
+            bool present = reference.erase(key) > 0;
+            MUST_BE_TRUE(table.remove(prefix) == present);
+        }
+        else
+        {
+            std::uint32_t value = rand() & Ipv4RoutingTable::VALUE_MAX;
+            MUST_BE_TRUE(table.insert(prefix, value));
+            reference[key] = value;
+        }
+
+        // Nothing reads the table here, so retired groups can go straight
+        // back
+        table.reclaim();
+
+        MUST_BE_TRUE(table.getPrefixCount() == reference.size());
+
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            std::uint32_t probe = i < 4 ? BASE | (rand() & 0x3ffff) :
+                                          prefix.getAddress() + rand() % 300;
+
+            std::uint32_t value = 0;
+            long expected = lookup(reference, probe);
+            MUST_BE_TRUE(table.lookup(probe, value) == (expected >= 0));
+            MUST_BE_TRUE(expected < 0 || value == expected);
+        }
+    }
+
+    // Taking everything out leaves nothing behind
+    for (Reference::const_iterator i = reference.begin();
+         i != reference.end();
+         ++i)
+    {
+        MUST_BE_TRUE(table.remove(Ipv4Prefix(i->first.second, i->first.first)));
+    }
+
+    MUST_BE_TRUE(table.getPrefixCount() == 0);
+    MUST_BE_TRUE(table.getGroupCount() == 0);
+    for (std::uint32_t address = BASE; address < BASE + 0x40000; address += 97)
+    {
+        std::uint32_t value = 0;
+        MUST_BE_FALSE(table.lookup(address, value));
+    }
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result Ipv4RoutingTable_test::Concurrent::body()
+{
+    // 10.0.0.0/16 is always there.  Every /24 in it keeps a /25 in its upper
+    // half, so its group never goes away, while a /26 and a /32 in its lower
+    // half and a /20 over the first sixteen come and go.
+    const unsigned int ROUNDS = 200;
+
+    Ipv4RoutingTable table(256);
+    MUST_BE_TRUE(table.insert(Ipv4Prefix("10.0.0.0/16"), 1));
+    for (std::uint32_t k = 0; k < 256; ++k)
+    {
+        MUST_BE_TRUE(table.insert(Ipv4Prefix(0x0a000080 | k << 8, 25),
+                                  200 + k));
+    }
+
+    std::atomic<bool>          done(false);
+    std::atomic<bool>          consistent(true);
+    std::atomic<unsigned long> lookups(0);
+
+    std::thread reader([&]()
+    {
+        unsigned int seed = 1;
+        while (!done)
+        {
+            seed = seed * 1103515245 + 12345;
+            std::uint32_t k = seed >> 8 & 0xff;
+            std::uint32_t x = seed >> 16 & 0xff;
+
+            std::uint32_t value = 0;
+            bool found = table.lookup(0x0a000000 | k << 8 | x, value);
+
+            bool expected = value == 1 || (k < 16 && value == 2);
+            if (x >= 128)
+            {
+                expected = value == 200 + k;
+            }
+            else if (x < 64)
+            {
+                expected = expected || value == 100 + k ||
+                    (x == 5 && value == 1000 + k);
+            }
+
+            if (!found || !expected)
+            {
+                consistent = false;
+            }
+
+            lookups++;
+        }
+    });
+
+    for (unsigned int round = 0; round < ROUNDS; ++round)
+    {
+        table.insert(Ipv4Prefix("10.0.0.0/20"), 2);
+        for (std::uint32_t k = 0; k < 256; ++k)
+        {
+            table.insert(Ipv4Prefix(0x0a000000 | k << 8, 26), 100 + k);
+            table.insert(Ipv4Prefix(0x0a000005 | k << 8, 32), 1000 + k);
+        }
+
+        table.remove(Ipv4Prefix("10.0.0.0/20"));
+        for (std::uint32_t k = 0; k < 256; ++k)
+        {
+            table.remove(Ipv4Prefix(0x0a000000 | k << 8, 26));
+            table.remove(Ipv4Prefix(0x0a000005 | k << 8, 32));
+        }
+    }
+
+    done = true;
+    reader.join();
+
+    MUST_BE_TRUE(consistent);
+    MUST_BE_TRUE(lookups > 0);
+    MUST_BE_TRUE(table.getRetiredCount() == 0);
+
+    return Test::PASSED;
+}
@@ -0,0 +1,19 @@
+#if !defined IPV4_ROUTING_TABLE_TEST
+#define IPV4_ROUTING_TABLE_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(Ipv4RoutingTable_test)
+
+    TEST(LongestMatch)
+    TEST(Remove)
+    TEST(Groups)
+    TEST(Batch)
+    TEST(Random)
+    TEST(Concurrent)
+
+TEST_CASES_END(Ipv4RoutingTable_test)
+
+#endif
@@ -17,13 +17,16 @@
 #include "LinuxRawSocketImpl.hpp"
 
 #include "PosixSocketCommon.hpp"
+#include "SocketKernelStatistics.hpp"
 #include "PosixTimespec.hpp"
 
 //==============================================================================
 // Creates a Linux raw socket
 //==============================================================================
 LinuxRawSocketImpl::LinuxRawSocketImpl() :
-    blocking_timeout(0.0)
+    blocking_timeout(0.0),
+    is_blocking(true),
+    spin_time(0.0)
 {
     // Zero out input and output interface structures
     memset(&input_interface,  0, sizeof(sockaddr_ll));
@@ -47,6 +50,9 @@ LinuxRawSocketImpl::LinuxRawSocketImpl() :
     {
         throw std::runtime_error(strerror(errno));
     }
+
+    // Have the kernel tell us about frames it drops on our behalf
+    PosixSocketCommon::enableDropReporting(socket_fd);
 }
 
 //==============================================================================
@@ -62,7 +68,13 @@ LinuxRawSocketImpl::~LinuxRawSocketImpl()
 //==============================================================================
 bool LinuxRawSocketImpl::enableBlocking()
 {
-    return PosixSocketCommon::enableBlocking(socket_fd);
+    if (!PosixSocketCommon::enableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = true;
+    return true;
 }
 
 //==============================================================================
@@ -70,7 +82,13 @@ bool LinuxRawSocketImpl::enableBlocking()
 //==============================================================================
 bool LinuxRawSocketImpl::disableBlocking()
 {
-    return PosixSocketCommon::disableBlocking(socket_fd);
+    if (!PosixSocketCommon::disableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = false;
+    return true;
 }
 
 //==============================================================================
@@ -78,7 +96,16 @@ bool LinuxRawSocketImpl::disableBlocking()
 //==============================================================================
 bool LinuxRawSocketImpl::isBlockingEnabled()
 {
-    return PosixSocketCommon::isBlockingEnabled(socket_fd);
+    return is_blocking;
+}
+
+//==============================================================================
+// Has the kernel time out blocking reads and writes
+//==============================================================================
+void LinuxRawSocketImpl::setBlockingTimeout(double blocking_timeout)
+{
+    this->blocking_timeout = blocking_timeout;
+    PosixSocketCommon::setBlockingTimeout(socket_fd, blocking_timeout);
 }
 
 //==============================================================================
@@ -138,13 +165,100 @@ bool LinuxRawSocketImpl::setOutputInterface(const std::string& interface_name)
 //==============================================================================
 int LinuxRawSocketImpl::read(unsigned char* buffer, unsigned int size)
 {
-    return PosixSocketCommon::read(
+    return PosixSocketCommon::spinRead(
         socket_fd,
         buffer,
         size,
+        is_blocking,
         blocking_timeout,
+        spin_time,
         reinterpret_cast<sockaddr*>(&input_interface),
-        sizeof(sockaddr_ll));
+        sizeof(sockaddr_ll),
+        statistics,
+        &last_timestamp,
+        0);
+}
+
+//==============================================================================
+// Reads as many frames as are available, up to 'count'
+//==============================================================================
+int LinuxRawSocketImpl::readBatch(unsigned char** buffers,
+                                  unsigned int*   sizes,
+                                  unsigned int    count,
+                                  PosixTimespec*  timestamps,
+                                  unsigned int*   wire_sizes)
+{
+    int ret = PosixSocketCommon::spinReadBatch(
+        socket_fd,
+        buffers,
+        sizes,
+        count,
+        is_blocking,
+        blocking_timeout,
+        spin_time,
+        reinterpret_cast<sockaddr*>(&input_interface),
+        sizeof(sockaddr_ll),
+        statistics,
+        timestamps,
+        0,
+        wire_sizes);
+
+    // Keep getLastTimestamp() consistent with single reads
+    if (ret > 0 && timestamps)
+    {
+        last_timestamp = timestamps[ret - 1];
+    }
+
+    return ret;
+}
+
+//==============================================================================
+// Pins the calling thread, then turns on everything spinning reads use
+//==============================================================================
+bool LinuxRawSocketImpl::enableBusyPoll(double spin_time, int core)
+{
+    if (spin_time <= 0.0 ||
+        (core >= 0 && !PosixSocketCommon::pinThread(core)))
+    {
+        return false;
+    }
+
+    // Neither of these is essential.  Spinning still works without the kernel
+    // busy polling, and without timestamps only the delivery latency goes
+    // unmeasured.
+    PosixSocketCommon::enableBusyPoll(socket_fd, spin_time);
+    PosixSocketCommon::enableTimestamps(socket_fd);
+
+    this->spin_time = spin_time;
+    return true;
+}
+
+//==============================================================================
+// Leaves the thread pinned and timestamps on; only the spinning stops
+//==============================================================================
+bool LinuxRawSocketImpl::disableBusyPoll()
+{
+    spin_time = 0.0;
+    return PosixSocketCommon::disableBusyPoll(socket_fd);
+}
+
+//==============================================================================
+// Writes several frames at once
+//==============================================================================
+int LinuxRawSocketImpl::writeBatch(const unsigned char* const* buffers,
+                                   const unsigned int*         sizes,
+                                   unsigned int                count)
+{
+    return PosixSocketCommon::writeBatch(
+        socket_fd,
+        buffers,
+        sizes,
+        count,
+        is_blocking,
+        blocking_timeout,
+        reinterpret_cast<sockaddr*>(&output_interface),
+        sizeof(sockaddr_ll),
+        statistics);
 }
 
 //==============================================================================
@@ -156,9 +270,12 @@ int LinuxRawSocketImpl::write(const unsigned char* buffer, unsigned int size)
         socket_fd,
         buffer,
         size,
+        is_blocking,
         blocking_timeout,
         reinterpret_cast<sockaddr*>(&output_interface),
-        sizeof(sockaddr_ll));
+        sizeof(sockaddr_ll),
+        statistics,
+        0);
 }
 
 //==============================================================================
@@ -166,10 +283,19 @@ int LinuxRawSocketImpl::write(const unsigned char* buffer, unsigned int size)
 //==============================================================================
 void LinuxRawSocketImpl::clearBuffer()
 {
-    PosixSocketCommon::clearBuffer(
-        socket_fd,
-        reinterpret_cast<sockaddr*>(&input_interface),
-        sizeof(sockaddr_ll));
+    PosixSocketCommon::clearBuffer(socket_fd, statistics);
+}
+
+//==============================================================================
+// Retrieves queue depths and drop counts from the kernel
+//==============================================================================
+bool LinuxRawSocketImpl::getKernelStatistics(
+    SocketKernelStatistics& kernel_statistics)
+{
+    kernel_statistics.reset();
+
+    return PosixSocketCommon::getKernelStatistics(
+        socket_fd, statistics, kernel_statistics);
 }
 
 //==============================================================================
@@ -187,3 +313,11 @@ int LinuxRawSocketImpl::getInterfaceIndex(const std::string& interface_name)
     // Return interface #
     return iface.ifr_ifindex;
 }
+
+//==============================================================================
+// Has the kernel timestamp received frames
+//==============================================================================
+bool LinuxRawSocketImpl::enableTimestamps()
+{
+    return PosixSocketCommon::enableTimestamps(socket_fd);
+}
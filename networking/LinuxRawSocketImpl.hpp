@@ -5,6 +5,8 @@
 
 #include "RawSocketImpl.hpp"
 
+#include "PosixTimespec.hpp"
+
 // Defines a socket implementation specific to Linux.  Raw sockets on Linux
 // require root priviledges to create and use.
 class LinuxRawSocketImpl : public RawSocketImpl
@@ -47,6 +49,33 @@ public:
     // Retrieves the name of the interface data will be sent from
     virtual void getOutputInterface(std::string& interface_name);
 
+    // Has the kernel timestamp every frame as it's received.
+    virtual bool enableTimestamps();
+
+    // Gets the kernel receive timestamp of the last frame read.
+    virtual void getLastTimestamp(PosixTimespec& timestamp) const;
+
+    // Reads up to 'count' frames, waiting only for the first.  See
+    // PosixSocketCommon::readBatch for details.
+    virtual int readBatch(unsigned char** buffers,
+                          unsigned int*   sizes,
+                          unsigned int    count,
+                          PosixTimespec*  timestamps,
+                          unsigned int*   wire_sizes);
+
+    // Sets up spinning reads, SO_BUSY_POLL and receive timestamps.  See
+    // RawSocket::enableBusyPoll for details.
+    virtual bool enableBusyPoll(double spin_time, int core);
+
+    // Stops spinning and clears SO_BUSY_POLL
+    virtual bool disableBusyPoll();
+
+    // Writes frames with sendmmsg().  See PosixSocketCommon::writeBatch for
+    // details.
+    virtual int writeBatch(const unsigned char* const* buffers,
+                           const unsigned int*         sizes,
+                           unsigned int                count);
+
     // Reads the specified amount of data from this socket into the specified
     // buffer.
     virtual int read(unsigned char* buffer, unsigned int size);
@@ -58,6 +87,14 @@ public:
     // Forces this socket to discard any received data.
     virtual void clearBuffer();
 
+    // Asks the kernel for its view of this socket (queue depths, drops).
+    // Returns false if none of this information could be retrieved.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics);
+
+    // Returns the descriptor for this socket
+    virtual int getDescriptor() const;
+
 private:
 
     // Retrieves the number corresponding to an interface, given its name
@@ -76,17 +113,22 @@ private:
 
     double blocking_timeout;
 
+    // Whether or not this socket is in blocking mode; kept here so reads and
+    // writes don't have to ask the kernel
+    bool is_blocking;
+
+    // How long reads spin before blocking; 0 when not busy polling
+    double spin_time;
+
+    // Kernel receive timestamp of the last frame read
+    PosixTimespec last_timestamp;
+
     // Disallow these for now; maybe these could be meaningfully implemented but
     // we'll save that for later
     LinuxRawSocketImpl(const LinuxRawSocketImpl&);
     LinuxRawSocketImpl& operator=(const LinuxRawSocketImpl&);
 };
 
-inline void LinuxRawSocketImpl::setBlockingTimeout(double blocking_timeout)
-{
-    this->blocking_timeout = blocking_timeout;
-}
-
 inline double LinuxRawSocketImpl::getBlockingTimeout() const
 {
     return this->blocking_timeout;
@@ -103,4 +145,14 @@ inline void LinuxRawSocketImpl::getOutputInterface(std::string& interface_name)
     interface_name = output_interface_name;
 }
 
+inline void LinuxRawSocketImpl::getLastTimestamp(PosixTimespec& timestamp) const
+{
+    timestamp = last_timestamp;
+}
+
+inline int LinuxRawSocketImpl::getDescriptor() const
+{
+    return socket_fd;
+}
+
 #endif
@@ -0,0 +1,665 @@
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "LinuxSharedMemorySocketImpl.hpp"
+
+#include "PosixSocketCommon.hpp"
+#include "SocketKernelStatistics.hpp"
+
+// Starts every segment so open() can tell it found one made by create()
+static const std::uint32_t SEGMENT_MAGIC = 0x534d5347;
+
+// Every message is stored as its length followed by its contents
+static const std::uint32_t LENGTH_SIZE = sizeof(std::uint32_t);
+
+// Messages are stored starting on multiples of this, so lengths are always
+// aligned and there's always room for one at the end of a ring
+static const std::uint32_t MESSAGE_ALIGNMENT = 8;
+
+// Stored in place of a message length to say the rest of the ring is unused
+// and the next message is back at the start
+static const std::uint32_t PADDING_LENGTH = 0xffffffff;
+
+// Rings are never made smaller than this
+static const std::uint32_t MINIMUM_CAPACITY = 4096;
+
+// Rings are never made larger than this
+static const std::uint32_t MAXIMUM_CAPACITY = 0x80000000;
+
+// One direction of the connection.  The producer is the only one to write
+// 'head' and the consumer the only one to write 'tail', and they're kept on
+// separate cache lines so neither side's writes slow the other's reads.  Both
+// count bytes from the start of the connection; they're taken modulo the
+// capacity to find positions in the ring.
+struct LinuxSharedMemorySocketImpl::Ring
+{
+    // One past the last byte of the newest message
+    alignas(64) std::atomic<std::uint64_t> head;
+
+    // First byte of the oldest message not yet read
+    alignas(64) std::atomic<std::uint64_t> tail;
+
+    // Futex words; bumped when data is added or room is made, but only when
+    // the matching flag says the other side is (about to be) asleep
+    alignas(64) std::atomic<std::uint32_t> data_sequence;
+    std::atomic<std::uint32_t>             consumer_waiting;
+    std::atomic<std::uint32_t>             space_sequence;
+    std::atomic<std::uint32_t>             producer_waiting;
+
+    // Set when either side detaches
+    std::atomic<std::uint32_t> closed;
+};
+
+// Layout of the start of the shared memory segment.  The data of rings[0]
+// and then rings[1] follows immediately.
+struct LinuxSharedMemorySocketImpl::Segment
+{
+    // SEGMENT_MAGIC once the creator has finished setting up
+    std::atomic<std::uint32_t> magic;
+
+    // Bytes of data in each ring
+    std::uint32_t capacity;
+
+    // Set by the side that opened the segment
+    std::atomic<std::uint32_t> attached;
+
+    // rings[0] carries messages from the creator to the opener, rings[1] the
+    // other way
+    Ring rings[2];
+};
+
+//==============================================================================
+// Makes a futex system call on a word in shared memory
+//==============================================================================
+static long futex(std::atomic<std::uint32_t>& word,
+                  int                         operation,
+                  std::uint32_t               value,
+                  const timespec*             timeout)
+{
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+                  "Futex words must be plain 32-bit integers");
+
+    // Not FUTEX_PRIVATE_FLAG; the other side may be another process
+    return syscall(SYS_futex,
+                   reinterpret_cast<std::uint32_t*>(&word),
+                   operation,
+                   value,
+                   timeout,
+                   0,
+                   0);
+}
+
+//==============================================================================
+// Returns how much ring space a message of the given size takes up
+//==============================================================================
+static std::uint32_t getRecordSize(unsigned int size)
+{
+    return (LENGTH_SIZE + size + MESSAGE_ALIGNMENT - 1) &
+        ~(MESSAGE_ALIGNMENT - 1);
+}
+
+//==============================================================================
+// Starts out detached
+//==============================================================================
+LinuxSharedMemorySocketImpl::LinuxSharedMemorySocketImpl() :
+    SharedMemorySocketImpl(),
+    segment(0),
+    segment_size(0),
+    send_ring(0),
+    receive_ring(0),
+    send_data(0),
+    receive_data(0),
+    capacity(0),
+    send_tail_cache(0),
+    receive_head_cache(0),
+    blocking_timeout(0.0),
+    is_blocking(true)
+{
+}
+
+//==============================================================================
+// Detaches from the segment, if attached
+//==============================================================================
+LinuxSharedMemorySocketImpl::~LinuxSharedMemorySocketImpl()
+{
+    detach();
+}
+
+//==============================================================================
+// Enables blocking
+//==============================================================================
+bool LinuxSharedMemorySocketImpl::enableBlocking()
+{
+    is_blocking = true;
+    return true;
+}
+
+//==============================================================================
+// Disables blocking
+//==============================================================================
+bool LinuxSharedMemorySocketImpl::disableBlocking()
+{
+    is_blocking = false;
+    return true;
+}
+
+//==============================================================================
+// Sets the blocking timeout
+//==============================================================================
+void LinuxSharedMemorySocketImpl::setBlockingTimeout(double blocking_timeout)
+{
+    this->blocking_timeout = blocking_timeout;
+}
+
+//==============================================================================
+// Reads one message out of the receive ring
+//==============================================================================
+int LinuxSharedMemorySocketImpl::read(unsigned char* buffer, unsigned int size)
+{
+    if (!segment)
+    {
+        errno = ENOTCONN;
+        statistics.recordRead(-1);
+        return -1;
+    }
+
+    std::uint64_t tail = receive_ring->tail.load(std::memory_order_relaxed);
+
+    double wait_start = 0.0;
+
+    while (tail == receive_head_cache)
+    {
+        receive_head_cache =
+            receive_ring->head.load(std::memory_order_acquire);
+
+        if (tail != receive_head_cache)
+        {
+            break;
+        }
+
+        // Anything written before the peer left was published before it set
+        // this, so one more look at the head settles whether there's more
+        if (receive_ring->closed.load(std::memory_order_acquire))
+        {
+            receive_head_cache =
+                receive_ring->head.load(std::memory_order_acquire);
+
+            if (tail != receive_head_cache)
+            {
+                break;
+            }
+
+            return 0;
+        }
+
+        if (!is_blocking)
+        {
+            errno = EAGAIN;
+            statistics.recordRead(-1);
+            return -1;
+        }
+
+        if (wait_start == 0.0)
+        {
+            wait_start = PosixSocketCommon::getMonotonicSeconds();
+        }
+
+        // Say we're going to sleep, then check once more; either the producer
+        // sees the flag and wakes us, or we see its data here
+        std::uint32_t seen =
+            receive_ring->data_sequence.load(std::memory_order_acquire);
+        receive_ring->consumer_waiting.store(1, std::memory_order_seq_cst);
+        receive_head_cache =
+            receive_ring->head.load(std::memory_order_seq_cst);
+
+        if (tail != receive_head_cache ||
+            receive_ring->closed.load(std::memory_order_acquire))
+        {
+            receive_ring->consumer_waiting.store(
+                0, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (!wait(receive_ring->data_sequence, seen, wait_start))
+        {
+            receive_ring->consumer_waiting.store(
+                0, std::memory_order_relaxed);
+            statistics.recordTimeout();
+            return 0;
+        }
+    }
+
+    if (wait_start > 0.0)
+    {
+        statistics.recordPollLatency(
+            PosixSocketCommon::getMonotonicSeconds() - wait_start);
+    }
+
+    std::uint32_t index = tail & (capacity - 1);
+
+    std::uint32_t length;
+    memcpy(&length, receive_data + index, LENGTH_SIZE);
+
+    if (length == PADDING_LENGTH)
+    {
+        // The message is at the start of the ring
+        tail += capacity - index;
+        index = 0;
+        memcpy(&length, receive_data, LENGTH_SIZE);
+    }
+
+    // Like a datagram, whatever doesn't fit is lost
+    unsigned int copied = length < size ? length : size;
+    memcpy(buffer, receive_data + index + LENGTH_SIZE, copied);
+
+    receive_ring->tail.store(tail + getRecordSize(length),
+                             std::memory_order_release);
+
+    wake(receive_ring->space_sequence, receive_ring->producer_waiting);
+
+    statistics.recordRead(copied);
+
+    return copied;
+}
+
+//==============================================================================
+// Writes one message into the send ring
+//==============================================================================
+int LinuxSharedMemorySocketImpl::write(const unsigned char* buffer,
+                                       unsigned int         size)
+{
+    if (!segment)
+    {
+        errno = ENOTCONN;
+        statistics.recordWrite(-1);
+        return -1;
+    }
+
+    if (size > getMaxMessageSize())
+    {
+        errno = EMSGSIZE;
+        statistics.recordWrite(-1);
+        return -1;
+    }
+
+    if (send_ring->closed.load(std::memory_order_relaxed))
+    {
+        errno = EPIPE;
+        statistics.recordWrite(-1);
+        return -1;
+    }
+
+    std::uint64_t head   = send_ring->head.load(std::memory_order_relaxed);
+    std::uint32_t index  = head & (capacity - 1);
+    std::uint32_t record = getRecordSize(size);
+
+    // A message that won't fit before the end of the ring goes at the start,
+    // and the space skipped over has to be free as well
+    std::uint32_t contiguous = capacity - index;
+    std::uint64_t needed = record <= contiguous ? record : contiguous + record;
+
+    double wait_start = 0.0;
+
+    while (head + needed - send_tail_cache > capacity)
+    {
+        send_tail_cache = send_ring->tail.load(std::memory_order_acquire);
+
+        if (head + needed - send_tail_cache <= capacity)
+        {
+            break;
+        }
+
+        if (send_ring->closed.load(std::memory_order_acquire))
+        {
+            errno = EPIPE;
+            statistics.recordWrite(-1);
+            return -1;
+        }
+
+        if (!is_blocking)
+        {
+            errno = EAGAIN;
+            statistics.recordWrite(-1);
+            return -1;
+        }
+
+        if (wait_start == 0.0)
+        {
+            wait_start = PosixSocketCommon::getMonotonicSeconds();
+        }
+
+        std::uint32_t seen =
+            send_ring->space_sequence.load(std::memory_order_acquire);
+        send_ring->producer_waiting.store(1, std::memory_order_seq_cst);
+        send_tail_cache = send_ring->tail.load(std::memory_order_seq_cst);
+
+        if (head + needed - send_tail_cache <= capacity ||
+            send_ring->closed.load(std::memory_order_acquire))
+        {
+            send_ring->producer_waiting.store(0, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (!wait(send_ring->space_sequence, seen, wait_start))
+        {
+            send_ring->producer_waiting.store(0, std::memory_order_relaxed);
+            statistics.recordTimeout();
+            return 0;
+        }
+    }
+
+    if (needed != record)
+    {
+        memcpy(send_data + index, &PADDING_LENGTH, LENGTH_SIZE);
+        head += contiguous;
+        index = 0;
+    }
+
+    std::uint32_t length = size;
+    memcpy(send_data + index, &length, LENGTH_SIZE);
+    memcpy(send_data + index + LENGTH_SIZE, buffer, size);
+
+    send_ring->head.store(head + record, std::memory_order_release);
+
+    wake(send_ring->data_sequence, send_ring->consumer_waiting);
+
+    statistics.recordWrite(size);
+
+    return size;
+}
+
+//==============================================================================
+// Throws away everything in the receive ring
+//==============================================================================
+void LinuxSharedMemorySocketImpl::clearBuffer()
+{
+    if (!segment)
+    {
+        return;
+    }
+
+    receive_head_cache = receive_ring->head.load(std::memory_order_acquire);
+    receive_ring->tail.store(receive_head_cache, std::memory_order_release);
+
+    wake(receive_ring->space_sequence, receive_ring->producer_waiting);
+}
+
+//==============================================================================
+// Reports the fill level of both rings
+//==============================================================================
+bool LinuxSharedMemorySocketImpl::getKernelStatistics(
+    SocketKernelStatistics& kernel_statistics)
+{
+    kernel_statistics.reset();
+
+    if (!segment)
+    {
+        return false;
+    }
+
+    // Includes space taken by lengths and padding
+    kernel_statistics.setReceiveQueueBytes(
+        receive_ring->head.load(std::memory_order_acquire) -
+        receive_ring->tail.load(std::memory_order_acquire));
+    kernel_statistics.setSendQueueBytes(
+        send_ring->head.load(std::memory_order_acquire) -
+        send_ring->tail.load(std::memory_order_acquire));
+
+    return true;
+}
+
+//==============================================================================
+// Creates and attaches to a new segment
+//==============================================================================
+bool LinuxSharedMemorySocketImpl::create(const std::string& name,
+                                         unsigned int       capacity)
+{
+    if (segment)
+    {
+        return false;
+    }
+
+    std::uint32_t rounded = MINIMUM_CAPACITY;
+    while (rounded < capacity && rounded < MAXIMUM_CAPACITY)
+    {
+        rounded *= 2;
+    }
+
+    // shm_open() wants names that start with a slash
+    std::string shm_name = !name.empty() && name[0] == '/' ? name : "/" + name;
+
+    int fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1)
+    {
+#if defined DEBUG
+        perror("LinuxSharedMemorySocketImpl::create");
+#endif
+        return false;
+    }
+
+    // The new segment reads as all zeros, which is how the rings start out
+    std::size_t size = sizeof(Segment) + 2 * static_cast<std::size_t>(rounded);
+    if (ftruncate(fd, size) == -1 || !map(fd, size, true))
+    {
+#if defined DEBUG
+        perror("LinuxSharedMemorySocketImpl::create");
+#endif
+        close(fd);
+        shm_unlink(shm_name.c_str());
+        return false;
+    }
+
+    // The mapping stays valid without the descriptor
+    close(fd);
+
+    segment->capacity = rounded;
+    this->capacity    = rounded;
+
+    segment->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+
+    created_name = shm_name;
+
+    return true;
+}
+
+//==============================================================================
+// Attaches to an existing segment
+//==============================================================================
+bool LinuxSharedMemorySocketImpl::open(const std::string& name)
+{
+    if (segment)
+    {
+        return false;
+    }
+
+    std::string shm_name = !name.empty() && name[0] == '/' ? name : "/" + name;
+
+    int fd = shm_open(shm_name.c_str(), O_RDWR, 0);
+    if (fd == -1)
+    {
+#if defined DEBUG
+        perror("LinuxSharedMemorySocketImpl::open");
+#endif
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) == -1 ||
+        static_cast<std::size_t>(status.st_size) < sizeof(Segment) ||
+        !map(fd, status.st_size, false))
+    {
+#if defined DEBUG
+        perror("LinuxSharedMemorySocketImpl::open");
+#endif
+        close(fd);
+        return false;
+    }
+
+    close(fd);
+
+    // Check the creator is done setting up, the sizes agree, and no one else
+    // got here first
+    if (segment->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC ||
+        sizeof(Segment) + 2 * static_cast<std::size_t>(segment->capacity) !=
+            segment_size ||
+        segment->attached.exchange(1) != 0)
+    {
+        munmap(segment, segment_size);
+        segment = 0;
+        return false;
+    }
+
+    capacity = segment->capacity;
+
+    return true;
+}
+
+//==============================================================================
+// Returns the largest message that can be written
+//==============================================================================
+unsigned int LinuxSharedMemorySocketImpl::getMaxMessageSize() const
+{
+    // Limiting messages to half the ring (length included) guarantees any
+    // message fits either before the end of the ring or at its start once the
+    // ring empties
+    return capacity == 0 ? 0 : capacity / 2 - LENGTH_SIZE;
+}
+
+//==============================================================================
+// Maps the segment and finds the rings in it
+//==============================================================================
+bool LinuxSharedMemorySocketImpl::map(int fd, std::size_t size, bool creator)
+{
+    void* address = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        return false;
+    }
+
+    segment      = static_cast<Segment*>(address);
+    segment_size = size;
+
+    // The ring data comes in the same order as the rings
+    unsigned char* data =
+        static_cast<unsigned char*>(address) + sizeof(Segment);
+    std::size_t ring_data_size = (size - sizeof(Segment)) / 2;
+
+    unsigned int send_index = creator ? 0 : 1;
+
+    send_ring    = &segment->rings[send_index];
+    receive_ring = &segment->rings[1 - send_index];
+    send_data    = data + send_index * ring_data_size;
+    receive_data = data + (1 - send_index) * ring_data_size;
+
+    send_tail_cache    = send_ring->tail.load(std::memory_order_acquire);
+    receive_head_cache = receive_ring->head.load(std::memory_order_acquire);
+
+    return true;
+}
+
+//==============================================================================
+// Lets the peer know we're gone and unmaps the segment
+//==============================================================================
+void LinuxSharedMemorySocketImpl::detach()
+{
+    if (!segment)
+    {
+        return;
+    }
+
+    // Whichever way the peer is waiting, it has to wake up to notice
+    Ring* rings[] = {send_ring, receive_ring};
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        rings[i]->closed.store(1, std::memory_order_release);
+
+        rings[i]->data_sequence.fetch_add(1, std::memory_order_release);
+        futex(rings[i]->data_sequence, FUTEX_WAKE, INT_MAX, 0);
+
+        rings[i]->space_sequence.fetch_add(1, std::memory_order_release);
+        futex(rings[i]->space_sequence, FUTEX_WAKE, INT_MAX, 0);
+    }
+
+    munmap(segment, segment_size);
+    segment = 0;
+
+    if (!created_name.empty())
+    {
+        shm_unlink(created_name.c_str());
+        created_name.clear();
+    }
+}
+
+//==============================================================================
+// Sleeps on a futex word until it changes or the blocking timeout runs out
+//==============================================================================
+bool LinuxSharedMemorySocketImpl::wait(std::atomic<std::uint32_t>& sequence,
+                                       std::uint32_t               seen,
+                                       double                      start)
+{
+    timespec  timeout;
+    timespec* timeout_ptr = 0;
+
+    if (blocking_timeout > 0.0)
+    {
+        double remaining = blocking_timeout -
+            (PosixSocketCommon::getMonotonicSeconds() - start);
+
+        if (remaining <= 0.0)
+        {
+            return false;
+        }
+
+        double seconds = std::floor(remaining);
+        timeout.tv_sec  = seconds;
+        timeout.tv_nsec = (remaining - seconds) * 1.0e9;
+        timeout_ptr = &timeout;
+    }
+
+    long ret = futex(sequence, FUTEX_WAIT, seen, timeout_ptr);
+    statistics.recordSyscalls();
+
+    // EAGAIN means the word had already changed, and EINTR is just a spurious
+    // wakeup; either way the caller looks again
+    if (ret == -1 && errno == ETIMEDOUT)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Wakes the other side if it's asleep waiting on us
+//==============================================================================
+void LinuxSharedMemorySocketImpl::wake(std::atomic<std::uint32_t>& sequence,
+                                       std::atomic<std::uint32_t>& waiting)
+{
+    // Pairs with the sleeper setting its flag before its last look at our
+    // position: either it sees what we just published or we see its flag
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (waiting.load(std::memory_order_relaxed) == 0 ||
+        waiting.exchange(0) == 0)
+    {
+        return;
+    }
+
+    sequence.fetch_add(1, std::memory_order_release);
+    futex(sequence, FUTEX_WAKE, INT_MAX, 0);
+    statistics.recordSyscalls();
+}
@@ -0,0 +1,137 @@
+#if !defined LINUX_SHARED_MEMORY_SOCKET_IMPL_HPP
+#define LINUX_SHARED_MEMORY_SOCKET_IMPL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SharedMemorySocketImpl.hpp"
+
+// Shared memory socket built on a POSIX shared memory segment holding two
+// single-producer single-consumer ring buffers, one per direction.  Each side
+// only ever writes to one ring and reads from the other, so neither needs a
+// lock; positions are published with release stores and picked up with acquire
+// loads.  A side that has to wait (for data, or for room) sleeps on a futex in
+// the segment, and the other side only makes the futex wake call when it knows
+// someone is sleeping.
+class LinuxSharedMemorySocketImpl : public SharedMemorySocketImpl
+{
+public:
+
+    // Does nothing; nothing is attached until create() or open()
+    LinuxSharedMemorySocketImpl();
+
+    // Marks both rings closed so the peer notices, then detaches
+    virtual ~LinuxSharedMemorySocketImpl();
+
+    // Enables blocking on reads and writes.
+    virtual bool enableBlocking();
+
+    // Disable blocking on reads and writes.
+    virtual bool disableBlocking();
+
+    // Returns whether or not this socket blocks.
+    virtual bool isBlockingEnabled();
+
+    // Enables a timeout of the given length (seconds) on blocking operations.
+    // A non-positive timeout value disables the blocking timeout.
+    virtual void setBlockingTimeout(double blocking_timeout);
+
+    // Returns the current blocking timeout (seconds).
+    virtual double getBlockingTimeout() const;
+
+    // Takes the next message out of the receive ring.  Returns the number of
+    // bytes read, 0 if the blocking timeout expired or the peer has gone away
+    // and everything it wrote has been read, or -1 on error.
+    virtual int read(unsigned char* buffer, unsigned int size);
+
+    // Puts a message into the send ring.  Returns the number of bytes written,
+    // 0 if the blocking timeout expired before there was room, or -1 on error.
+    virtual int write(const unsigned char* buffer, unsigned int size);
+
+    // Discards everything in the receive ring
+    virtual void clearBuffer();
+
+    // Reports how many bytes are waiting in each ring.  Returns false if not
+    // attached to a segment.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics);
+
+    // Creates the named segment with shm_open() and attaches to it
+    virtual bool create(const std::string& name, unsigned int capacity);
+
+    // Attaches to the named segment
+    virtual bool open(const std::string& name);
+
+    // Returns the size of the largest message that can be written
+    virtual unsigned int getMaxMessageSize() const;
+
+private:
+
+    struct Ring;
+    struct Segment;
+
+    // Maps the segment open on 'fd' and points the ring members into it
+    bool map(int fd, std::size_t size, bool creator);
+
+    // Marks the rings closed, wakes the peer and unmaps the segment
+    void detach();
+
+    // Sleeps until 'sequence' no longer holds 'seen' or the blocking timeout
+    // (measured from 'start') runs out.  Returns false on timeout.
+    bool wait(std::atomic<std::uint32_t>& sequence,
+              std::uint32_t               seen,
+              double                      start);
+
+    // Bumps 'sequence' and wakes whoever is sleeping on it, if 'waiting' says
+    // anyone is
+    void wake(std::atomic<std::uint32_t>& sequence,
+              std::atomic<std::uint32_t>& waiting);
+
+    // The whole mapping, and its size
+    Segment*    segment;
+    std::size_t segment_size;
+
+    // Ring this side writes to and ring this side reads from, and where their
+    // data lives
+    Ring*          send_ring;
+    Ring*          receive_ring;
+    unsigned char* send_data;
+    unsigned char* receive_data;
+
+    // Bytes of data in each ring; a power of two
+    std::uint32_t capacity;
+
+    // Local copies of the other side's positions.  They're only refreshed
+    // from shared memory when they say the ring is full or empty, which keeps
+    // the two sides from fighting over the same cache lines on every message.
+    std::uint64_t send_tail_cache;
+    std::uint64_t receive_head_cache;
+
+    // Name of the segment if this side created it, so it can be removed
+    std::string created_name;
+
+    double blocking_timeout;
+
+    bool is_blocking;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    LinuxSharedMemorySocketImpl(const LinuxSharedMemorySocketImpl&);
+    LinuxSharedMemorySocketImpl& operator=(const LinuxSharedMemorySocketImpl&);
+};
+
+//==============================================================================
+inline bool LinuxSharedMemorySocketImpl::isBlockingEnabled()
+{
+    return is_blocking;
+}
+
+//==============================================================================
+inline double LinuxSharedMemorySocketImpl::getBlockingTimeout() const
+{
+    return blocking_timeout;
+}
+
+#endif
@@ -0,0 +1,677 @@
+// Generates traffic at a steady packet rate for load-testing receivers.  Each
+// kind of packet is built once as a PacketTemplate, copied into a batch of send
+// buffers, and from then on only the fields that vary (sequence numbers, IP
+// identification, addresses, ports and the checksums covering them) are
+// rewritten before each batch goes out in one writeBatch() call.  Frames go out
+// of a raw socket on an interface, or datagrams out of a UDP socket to a host
+// and port.  Every second, and at the end, the rate achieved and any send
+// errors are reported.
+//
+// Packet types for raw sockets:
+//   ethernet  Ethernet II frames of an experimental ethertype (0x88b5) carrying
+//             a sequence number and then the payload
+//   arp       ARP requests asking after successive target addresses
+//   udp       IPv4 UDP packets carrying a sequence number and then the
+//             payload, from successive source ports (one per flow)
+// Datagrams sent with -u carry the sequence number and payload only.
+//
+// Usage: PacketGenerator (-i <interface> [-t ethernet|arp|udp] [-m <mac>]
+//                         [-a <source ip>] [-A <destination ip>] [-p <port>]
+//                         | -u <host>:<port>)
+//                        [-s <payload size> | -f <payload file>]
+//                        [--flows <count>] [-r <packets per second>]
+//                        [-n <packet count>] [-T <seconds>] [-b <batch size>]
+//
+// Rates and counts of 0 mean unlimited.  Raw sockets need CAP_NET_RAW.  To try
+// it out without touching a real network, send across a veth pair into a
+// network namespace and count what arrives there:
+//
+//   ip netns add sink
+//   ip link add gen0 type veth peer name sink0 netns sink
+//   ip addr add 10.9.0.1/24 dev gen0 && ip link set gen0 up
+//   ip -n sink addr add 10.9.0.2/24 dev sink0 && ip -n sink link set sink0 up
+//   PacketGenerator -i gen0 -t udp -A 10.9.0.2 -r 100000 -T 10
+//   ip -n sink -s link show sink0
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <signal.h>
+#include <stdexcept>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#include "ArpPacketEthernetIpv4.hpp"
+#include "EthernetIIHeader.hpp"
+#include "Ipv4Address.hpp"
+#include "Ipv4Header.hpp"
+#include "MacAddress.hpp"
+#include "PacketTemplate.hpp"
+#include "PosixSocketCommon.hpp"
+#include "RawSocket.hpp"
+#include "SignalManager.hpp"
+#include "UDPSocket.hpp"
+#include "UdpHeader.hpp"
+#include "miscNetworking.hpp"
+#include "misc.hpp"
+
+// Ethertype reserved for local experiments, so nothing else claims the frames
+static const std::uint16_t RAW_ETHERTYPE = 0x88b5;
+
+// Shortest Ethernet frame, not counting the frame check sequence the interface
+// adds; shorter frames are padded out to this
+static const unsigned int FRAME_SIZE_MIN = 60;
+
+// Size of the sequence number at the start of every payload
+static const unsigned int SEQUENCE_SIZE = 4;
+
+// Sleeping is only trusted to get within this many seconds of when the next
+// batch is due; the rest is waited out spinning
+static const double SLEEP_MARGIN = 100.0e-6;
+
+// How far behind schedule sending may fall (seconds) before the schedule gives
+// up on catching up, so a stall isn't followed by a burst far over the rate
+static const double LAG_MAX = 10.0e-3;
+
+// What the user asked for
+struct Options
+{
+    std::string interface_name;
+    std::string type;
+    std::string destination_mac;
+    std::string source_ip;
+    std::string destination_ip;
+    unsigned int port;
+
+    std::string udp_host;
+    unsigned int udp_port;
+
+    unsigned int payload_size;
+    std::string  payload_file;
+    unsigned int flows;
+    double       rate;
+    std::uint64_t count;
+    double       duration;
+    unsigned int batch;
+};
+
+// What's been sent so far
+struct Totals
+{
+    std::uint64_t packets;
+    std::uint64_t bytes;
+    std::uint64_t errors;
+    std::uint64_t short_batches;
+};
+
+//==============================================================================
+// Waits until monotonic time 'until', sleeping for most of it and spinning for
+// the rest
+//==============================================================================
+static void waitUntil(double until)
+{
+    double remaining = until - PosixSocketCommon::getMonotonicSeconds();
+    if (remaining > 2.0 * SLEEP_MARGIN)
+    {
+        remaining -= SLEEP_MARGIN;
+
+        timespec ts;
+        ts.tv_sec  = static_cast<time_t>(remaining);
+        ts.tv_nsec = static_cast<long>((remaining - ts.tv_sec) * 1.0e9);
+        nanosleep(&ts, 0);
+    }
+
+    while (PosixSocketCommon::getMonotonicSeconds() < until)
+    {
+    }
+}
+
+//==============================================================================
+// Reads a 32-bit big-endian value
+//==============================================================================
+static std::uint32_t readBig(const std::uint8_t* buffer)
+{
+    return static_cast<std::uint32_t>(buffer[0]) << 24 | buffer[1] << 16 |
+        buffer[2] << 8 | buffer[3];
+}
+
+//==============================================================================
+// Builds the payload, a sequence number followed by the contents of the
+// payload file if there is one or a byte pattern otherwise; returns false if
+// the file can't be read
+//==============================================================================
+static bool buildPayload(const Options&             options,
+                         std::vector<std::uint8_t>& payload)
+{
+    if (!options.payload_file.empty())
+    {
+        std::ifstream file(options.payload_file.c_str(), std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        payload.assign(SEQUENCE_SIZE, 0);
+        payload.insert(payload.end(),
+                       std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    payload.resize(SEQUENCE_SIZE + options.payload_size);
+    for (unsigned int i = 0; i < payload.size(); ++i)
+    {
+        payload[i] = i < SEQUENCE_SIZE ? 0 : static_cast<std::uint8_t>(i);
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Builds the template for frames sent from a raw socket; returns 0 and says
+// why if it can't be built
+//==============================================================================
+static PacketTemplate* buildFrameTemplate(const Options& options)
+{
+    MacAddress source_mac;
+    if (!miscNetworking::getMacAddress(options.interface_name, source_mac))
+    {
+        std::cerr << "Couldn't get the MAC address of "
+                  << options.interface_name << "\n";
+        return 0;
+    }
+
+    // Without a source address given, use the interface's, or zeros if it
+    // hasn't got one (ARP probes are sent from zeros anyway)
+    Ipv4Address source_ip;
+    if (!options.source_ip.empty())
+    {
+        source_ip = options.source_ip;
+    }
+    else
+    {
+        miscNetworking::getIpv4Address(options.interface_name, source_ip);
+    }
+
+    Ipv4Address destination_ip(options.destination_ip);
+
+    MacAddress destination_mac;
+    destination_mac = options.destination_mac;
+
+    std::vector<std::uint8_t> payload;
+    if (!buildPayload(options, payload))
+    {
+        std::cerr << "Couldn't read " << options.payload_file << "\n";
+        return 0;
+    }
+
+    std::vector<std::uint8_t> frame;
+    PacketTemplate*           packet_template = 0;
+
+    if (options.type == "ethernet")
+    {
+        EthernetIIHeader ethernet(destination_mac, source_mac, RAW_ETHERTYPE);
+
+        frame.resize(EthernetIIHeader::LENGTH_BYTES + payload.size());
+        ethernet.writeRaw(&frame[0], misc::ENDIAN_BIG);
+        memcpy(&frame[EthernetIIHeader::LENGTH_BYTES], &payload[0],
+               payload.size());
+        if (frame.size() < FRAME_SIZE_MIN)
+        {
+            frame.resize(FRAME_SIZE_MIN);
+        }
+
+        packet_template = new PacketTemplate(&frame[0], frame.size());
+        packet_template->addCounter(EthernetIIHeader::LENGTH_BYTES,
+                                    SEQUENCE_SIZE,
+                                    0);
+    }
+    else if (options.type == "arp")
+    {
+        EthernetIIHeader ethernet(destination_mac,
+                                  source_mac,
+                                  EthernetIIHeader::ARP);
+
+        MacAddress target_mac;
+        ArpPacketEthernetIpv4 arp(1, source_mac, source_ip, target_mac,
+                                  destination_ip);
+
+        unsigned int arp_size = arp.getLengthBits() / 8;
+        frame.resize(EthernetIIHeader::LENGTH_BYTES + arp_size);
+        ethernet.writeRaw(&frame[0], misc::ENDIAN_BIG);
+        arp.writeRaw(&frame[EthernetIIHeader::LENGTH_BYTES], misc::ENDIAN_BIG);
+        if (frame.size() < FRAME_SIZE_MIN)
+        {
+            frame.resize(FRAME_SIZE_MIN);
+        }
+
+        // The target address is the last thing in the request, and steps
+        // through one address per flow
+        unsigned int tpa_offset = EthernetIIHeader::LENGTH_BYTES + arp_size - 4;
+
+        packet_template = new PacketTemplate(&frame[0], frame.size());
+        packet_template->addCounter(tpa_offset,
+                                    4,
+                                    readBig(&frame[tpa_offset]),
+                                    1,
+                                    options.flows);
+    }
+    else if (options.type == "udp")
+    {
+        static const unsigned int IP_OFFSET  = EthernetIIHeader::LENGTH_BYTES;
+        static const unsigned int UDP_OFFSET =
+            IP_OFFSET + Ipv4Header::LENGTH_BYTES;
+        static const unsigned int DATA_OFFSET =
+            UDP_OFFSET + UdpHeader::LENGTH_BYTES;
+
+        if (DATA_OFFSET + payload.size() > 0xffff)
+        {
+            std::cerr << "The payload doesn't fit in an IPv4 packet\n";
+            return 0;
+        }
+
+        unsigned int size = DATA_OFFSET + payload.size();
+
+        EthernetIIHeader ethernet(destination_mac,
+                                  source_mac,
+                                  EthernetIIHeader::IPV4);
+
+        Ipv4Header ip(Ipv4Header::UDP);
+        ip.setTotalLength(size - IP_OFFSET);
+        ip.setTtl(64);
+        *ip.getSource()      = source_ip;
+        *ip.getDestination() = destination_ip;
+
+        const std::uint16_t SOURCE_PORT = 49152;
+        UdpHeader udp(SOURCE_PORT, options.port);
+        udp.setLength(size - UDP_OFFSET);
+
+        frame.resize(size);
+        ethernet.writeRaw(&frame[0], misc::ENDIAN_BIG);
+        ip.writeRaw(&frame[IP_OFFSET], misc::ENDIAN_BIG);
+        udp.writeRaw(&frame[UDP_OFFSET], misc::ENDIAN_BIG);
+        memcpy(&frame[DATA_OFFSET], &payload[0], payload.size());
+
+        // Checksums are worked out once here and only patched from then on.
+        // The UDP checksum's pseudo-header is the addresses, which sit just
+        // before the UDP header, plus the protocol and UDP length.
+        std::uint16_t checksum = PacketTemplate::computeChecksum(
+            &frame[IP_OFFSET], Ipv4Header::LENGTH_BYTES);
+        frame[IP_OFFSET + 10] = static_cast<std::uint8_t>(checksum >> 8);
+        frame[IP_OFFSET + 11] = static_cast<std::uint8_t>(checksum);
+
+        unsigned int addresses_offset = IP_OFFSET + 12;
+        checksum = PacketTemplate::computeChecksum(
+            &frame[addresses_offset],
+            size - addresses_offset,
+            Ipv4Header::UDP + size - UDP_OFFSET);
+        frame[UDP_OFFSET + 6] = static_cast<std::uint8_t>(checksum >> 8);
+        frame[UDP_OFFSET + 7] = static_cast<std::uint8_t>(checksum);
+
+        if (frame.size() < FRAME_SIZE_MIN)
+        {
+            frame.resize(FRAME_SIZE_MIN);
+        }
+
+        // Identification, source port (one per flow) and sequence number vary
+        packet_template = new PacketTemplate(&frame[0], frame.size());
+        packet_template->addCounter(IP_OFFSET + 4, 2, 0);
+        packet_template->addCounter(UDP_OFFSET, 2, SOURCE_PORT, 1,
+                                    options.flows);
+        packet_template->addCounter(DATA_OFFSET, SEQUENCE_SIZE, 0);
+        packet_template->addChecksum(IP_OFFSET + 10,
+                                     IP_OFFSET,
+                                     UDP_OFFSET);
+        packet_template->addChecksum(UDP_OFFSET + 6,
+                                     addresses_offset,
+                                     size);
+    }
+    else
+    {
+        std::cerr << "Unknown packet type " << options.type << "\n";
+    }
+
+    return packet_template;
+}
+
+//==============================================================================
+// Builds the template for datagrams sent from a UDP socket
+//==============================================================================
+static PacketTemplate* buildDatagramTemplate(const Options& options)
+{
+    std::vector<std::uint8_t> payload;
+    if (!buildPayload(options, payload))
+    {
+        std::cerr << "Couldn't read " << options.payload_file << "\n";
+        return 0;
+    }
+
+    PacketTemplate* packet_template =
+        new PacketTemplate(&payload[0], payload.size());
+    packet_template->addCounter(0, SEQUENCE_SIZE, 0);
+
+    return packet_template;
+}
+
+//==============================================================================
+// Prints one line of results covering 'elapsed' seconds
+//==============================================================================
+static void report(const std::string& name,
+                   const Totals&      totals,
+                   double             elapsed)
+{
+    std::cout << std::left << std::setw(8) << name << std::right
+              << std::setw(14) << totals.packets
+              << std::fixed << std::setprecision(0)
+              << std::setw(14) << totals.packets / elapsed
+              << std::setprecision(1)
+              << std::setw(12) << totals.bytes * 8 / elapsed / 1.0e6
+              << std::setw(10) << totals.errors
+              << std::setw(10) << totals.short_batches << std::endl;
+}
+
+//==============================================================================
+// Sends until the count or duration is reached or SIGINT arrives
+//==============================================================================
+template <class SocketType>
+static void run(const Options&        options,
+                const PacketTemplate& packet_template,
+                SocketType&           socket)
+{
+    SignalManager signal_manager;
+    signal_manager.registerSignal(SIGINT);
+
+    // Every buffer gets the whole template once; only the varying fields are
+    // rewritten from then on
+    unsigned int size = packet_template.getSize();
+    std::vector<std::uint8_t>   storage(options.batch * size);
+    std::vector<std::uint8_t*>  buffers(options.batch);
+    std::vector<unsigned int>   sizes(options.batch, size);
+    for (unsigned int i = 0; i < options.batch; ++i)
+    {
+        packet_template.copy(&storage[i * size]);
+        buffers[i] = &storage[i * size];
+    }
+
+    std::cout << std::left << std::setw(8) << "time" << std::right
+              << std::setw(14) << "packets"
+              << std::setw(14) << "packets/s"
+              << std::setw(12) << "Mbit/s"
+              << std::setw(10) << "errors"
+              << std::setw(10) << "short" << std::endl;
+
+    Totals totals = {0, 0, 0, 0};
+    Totals second = totals;
+
+    double interval = options.rate > 0.0 ? 1.0 / options.rate : 0.0;
+    double start    = PosixSocketCommon::getMonotonicSeconds();
+    double next     = start;
+    double tick     = start + 1.0;
+    unsigned int seconds = 0;
+
+    while (!signal_manager.isSignalDelivered(SIGINT))
+    {
+        double time = PosixSocketCommon::getMonotonicSeconds();
+        if (options.duration > 0.0 && time - start >= options.duration)
+        {
+            break;
+        }
+
+        if (time >= tick)
+        {
+            report(std::to_string(++seconds) + "s", second, time - tick + 1.0);
+            second = Totals();
+            tick += 1.0;
+        }
+
+        // Send whatever is due, up to a batch
+        std::uint64_t count = options.batch;
+        if (options.count > 0 && options.count - totals.packets < count)
+        {
+            count = options.count - totals.packets;
+            if (count == 0)
+            {
+                break;
+            }
+        }
+
+        if (interval > 0.0)
+        {
+            if (time < next)
+            {
+                waitUntil(next);
+                time = next;
+            }
+            else if (time - next > LAG_MAX)
+            {
+                next = time - LAG_MAX;
+            }
+
+            std::uint64_t due = 1 + static_cast<std::uint64_t>(
+                (time - next) / interval);
+            if (due < count)
+            {
+                count = due;
+            }
+        }
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            packet_template.fill(buffers[i], totals.packets + i);
+        }
+
+        int sent = socket.writeBatch(&buffers[0], &sizes[0],
+                                     static_cast<unsigned int>(count));
+        if (sent < 0)
+        {
+            totals.errors++;
+            second.errors++;
+            continue;
+        }
+
+        if (static_cast<std::uint64_t>(sent) < count)
+        {
+            totals.short_batches++;
+            second.short_batches++;
+        }
+
+        totals.packets += sent;
+        totals.bytes   += static_cast<std::uint64_t>(sent) * size;
+        second.packets += sent;
+        second.bytes   += static_cast<std::uint64_t>(sent) * size;
+        next           += sent * interval;
+    }
+
+    double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+    report("total", totals, elapsed);
+}
+
+//==============================================================================
+// Prints how to run this
+//==============================================================================
+static void usage(const char* name)
+{
+    std::cerr << "Usage: " << name
+              << " (-i <interface> [-t ethernet|arp|udp] [-m <mac>]"
+                 " [-a <source ip>] [-A <destination ip>] [-p <port>]"
+                 " | -u <host>:<port>)"
+                 " [-s <payload size> | -f <payload file>]"
+                 " [--flows <count>] [-r <packets per second>]"
+                 " [-n <packet count>] [-T <seconds>] [-b <batch size>]\n";
+}
+
+//==============================================================================
+// Parses arguments, sets up the socket and sends
+//==============================================================================
+int main(int argc, char** argv)
+{
+    Options options;
+    options.type            = "udp";
+    options.destination_mac = "ff:ff:ff:ff:ff:ff";
+    options.destination_ip  = "255.255.255.255";
+    options.port            = 9;
+    options.udp_port        = 0;
+    options.payload_size    = 14;
+    options.flows           = 1;
+    options.rate            = 0.0;
+    options.count           = 0;
+    options.duration        = 0.0;
+    options.batch           = 64;
+
+    // Parse arguments
+    for (int arg = 1; arg < argc; arg++)
+    {
+        bool has_value = arg + 1 < argc;
+
+        // Argument -i sends frames out of a raw socket on this interface
+        if (strcmp(argv[arg], "-i") == 0 && has_value)
+        {
+            options.interface_name = argv[++arg];
+        }
+        // Argument -t picks the kind of frame
+        else if (strcmp(argv[arg], "-t") == 0 && has_value)
+        {
+            options.type = argv[++arg];
+        }
+        // Argument -m sets the destination MAC address
+        else if (strcmp(argv[arg], "-m") == 0 && has_value)
+        {
+            options.destination_mac = argv[++arg];
+        }
+        // Argument -a sets the source IP address
+        else if (strcmp(argv[arg], "-a") == 0 && has_value)
+        {
+            options.source_ip = argv[++arg];
+        }
+        // Argument -A sets the destination IP address (the first ARP target)
+        else if (strcmp(argv[arg], "-A") == 0 && has_value)
+        {
+            options.destination_ip = argv[++arg];
+        }
+        // Argument -p sets the destination UDP port of raw UDP packets
+        else if (strcmp(argv[arg], "-p") == 0 && has_value)
+        {
+            options.port = atoi(argv[++arg]);
+        }
+        // Argument -u sends datagrams from a UDP socket to this host and port
+        else if (strcmp(argv[arg], "-u") == 0 && has_value)
+        {
+            std::string destination = argv[++arg];
+            std::string::size_type colon = destination.rfind(':');
+            if (colon == std::string::npos)
+            {
+                usage(argv[0]);
+                return 1;
+            }
+
+            options.udp_host = destination.substr(0, colon);
+            options.udp_port = atoi(destination.c_str() + colon + 1);
+        }
+        // Argument -s sets the payload size after the sequence number
+        else if (strcmp(argv[arg], "-s") == 0 && has_value)
+        {
+            options.payload_size = atoi(argv[++arg]);
+        }
+        // Argument -f takes the payload after the sequence number from a file
+        else if (strcmp(argv[arg], "-f") == 0 && has_value)
+        {
+            options.payload_file = argv[++arg];
+        }
+        // Argument --flows sets how many source ports or ARP targets to cycle
+        // through
+        else if (strcmp(argv[arg], "--flows") == 0 && has_value)
+        {
+            options.flows = atoi(argv[++arg]);
+        }
+        // Argument -r sets the target rate in packets per second
+        else if (strcmp(argv[arg], "-r") == 0 && has_value)
+        {
+            options.rate = atof(argv[++arg]);
+        }
+        // Argument -n sets how many packets to send
+        else if (strcmp(argv[arg], "-n") == 0 && has_value)
+        {
+            options.count = strtoull(argv[++arg], 0, 10);
+        }
+        // Argument -T sets how long to send for
+        else if (strcmp(argv[arg], "-T") == 0 && has_value)
+        {
+            options.duration = atof(argv[++arg]);
+        }
+        // Argument -b sets how many packets go in each writeBatch() call
+        else if (strcmp(argv[arg], "-b") == 0 && has_value)
+        {
+            options.batch = atoi(argv[++arg]);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.interface_name.empty() == options.udp_host.empty() ||
+        options.batch == 0 || options.flows == 0 || options.rate < 0.0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bool raw = !options.interface_name.empty();
+    PacketTemplate* packet_template = raw ? buildFrameTemplate(options) :
+                                            buildDatagramTemplate(options);
+    if (!packet_template)
+    {
+        return 1;
+    }
+
+    int status = 0;
+    try
+    {
+        if (raw)
+        {
+            RawSocket socket;
+            if (socket.setOutputInterface(options.interface_name))
+            {
+                socket.enableBlocking();
+                socket.setBlockingTimeout(1.0);
+                run(options, *packet_template, socket);
+            }
+            else
+            {
+                std::cerr << "Couldn't send on " << options.interface_name
+                          << "\n";
+                status = 1;
+            }
+        }
+        else
+        {
+            UDPSocket socket;
+            if (socket.sendTo(options.udp_host, options.udp_port))
+            {
+                socket.enableBlocking();
+                socket.setBlockingTimeout(1.0);
+                run(options, *packet_template, socket);
+            }
+            else
+            {
+                std::cerr << "Couldn't send to " << options.udp_host << ":"
+                          << options.udp_port << "\n";
+                status = 1;
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        status = 1;
+    }
+
+    delete packet_template;
+    return status;
+}
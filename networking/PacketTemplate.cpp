@@ -0,0 +1,222 @@
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "PacketTemplate.hpp"
+
+const unsigned int PacketTemplate::FIELDS_MAX;
+
+//==============================================================================
+// Folds a ones' complement sum down to 16 bits
+//==============================================================================
+static std::uint16_t fold(std::uint32_t sum)
+{
+    while (sum >> 16)
+    {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    return static_cast<std::uint16_t>(sum);
+}
+
+//==============================================================================
+// Copies the template
+//==============================================================================
+PacketTemplate::PacketTemplate(const std::uint8_t* packet, unsigned int size) :
+    data(packet, packet + size),
+    counter_count(0),
+    checksum_count(0)
+{
+    if (size == 0)
+    {
+        throw std::invalid_argument("Packet templates can't be empty");
+    }
+}
+
+//==============================================================================
+PacketTemplate::~PacketTemplate()
+{
+}
+
+//==============================================================================
+// Adds a field that counts up from packet to packet
+//==============================================================================
+bool PacketTemplate::addCounter(unsigned int  offset,
+                                unsigned int  width,
+                                std::uint32_t start,
+                                std::uint32_t step,
+                                std::uint32_t count)
+{
+    if (counter_count == FIELDS_MAX ||
+        (width != 1 && width != 2 && width != 4) ||
+        offset > data.size() || width > data.size() - offset)
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < counter_count; ++i)
+    {
+        if (offset < counters[i].offset + counters[i].width &&
+            counters[i].offset < offset + width)
+        {
+            return false;
+        }
+    }
+
+    Counter& counter = counters[counter_count];
+    counter.offset  = offset;
+    counter.width   = width;
+    counter.start   = start;
+    counter.step    = step;
+    counter.count   = count;
+    counter.initial = 0;
+    for (unsigned int i = 0; i < width; ++i)
+    {
+        counter.initial = counter.initial << 8 | data[offset + i];
+    }
+
+    counter_count++;
+    return true;
+}
+
+//==============================================================================
+// Adds a checksum to keep up to date
+//==============================================================================
+bool PacketTemplate::addChecksum(unsigned int checksum_offset,
+                                 unsigned int first,
+                                 unsigned int end)
+{
+    if (checksum_count == FIELDS_MAX ||
+        checksum_offset > data.size() || data.size() - checksum_offset < 2 ||
+        first > end || end > data.size())
+    {
+        return false;
+    }
+
+    Checksum& checksum = checksums[checksum_count];
+    checksum.offset      = checksum_offset;
+    checksum.first       = first;
+    checksum.end         = end;
+    checksum.initial_sum = ~(data[checksum_offset] << 8 |
+                             data[checksum_offset + 1]);
+
+    checksum_count++;
+    return true;
+}
+
+//==============================================================================
+// Copies the template out
+//==============================================================================
+void PacketTemplate::copy(std::uint8_t* buffer) const
+{
+    memcpy(buffer, &data[0], data.size());
+}
+
+//==============================================================================
+// Rewrites the fields that vary
+//==============================================================================
+void PacketTemplate::fill(std::uint8_t* buffer, std::uint64_t index) const
+{
+    std::uint32_t values[FIELDS_MAX];
+
+    for (unsigned int i = 0; i < counter_count; ++i)
+    {
+        const Counter& counter = counters[i];
+        values[i] = getValue(counter, index);
+
+        for (unsigned int j = 0; j < counter.width; ++j)
+        {
+            buffer[counter.offset + j] = static_cast<std::uint8_t>(
+                values[i] >> (counter.width - 1 - j) * 8);
+        }
+    }
+
+    // Each counter's change is added to the template's sum: the new value in
+    // and the template's value out, which in ones' complement arithmetic is
+    // adding its complement
+    for (unsigned int i = 0; i < checksum_count; ++i)
+    {
+        const Checksum& checksum = checksums[i];
+        std::uint32_t   sum      = checksum.initial_sum;
+
+        for (unsigned int j = 0; j < counter_count; ++j)
+        {
+            sum += fold(getContribution(values[j], counters[j], checksum));
+            sum += static_cast<std::uint16_t>(~fold(getContribution(
+                counters[j].initial, counters[j], checksum)));
+        }
+
+        // A result of zero is written as all ones, its equivalent in ones'
+        // complement; UDP reserves zero to mean there's no checksum at all
+        std::uint16_t result = ~fold(sum);
+        if (result == 0)
+        {
+            result = 0xffff;
+        }
+
+        buffer[checksum.offset]     = static_cast<std::uint8_t>(result >> 8);
+        buffer[checksum.offset + 1] = static_cast<std::uint8_t>(result);
+    }
+}
+
+//==============================================================================
+// Computes an Internet checksum
+//==============================================================================
+std::uint16_t PacketTemplate::computeChecksum(const std::uint8_t* data,
+                                              unsigned int        size,
+                                              std::uint32_t       sum)
+{
+    for (unsigned int i = 0; i + 1 < size; i += 2)
+    {
+        sum = fold(sum) + (data[i] << 8 | data[i + 1]);
+    }
+
+    // An odd byte out is padded with zero
+    if (size % 2)
+    {
+        sum = fold(sum) + (data[size - 1] << 8);
+    }
+
+    return ~fold(sum);
+}
+
+//==============================================================================
+// Works out a counter's value for a given packet
+//==============================================================================
+std::uint32_t PacketTemplate::getValue(const Counter& counter,
+                                       std::uint64_t  index)
+{
+    if (counter.count != 0)
+    {
+        index %= counter.count;
+    }
+
+    return counter.start + counter.step * static_cast<std::uint32_t>(index);
+}
+
+//==============================================================================
+// Works out what a counter adds to a checksum's sum
+//==============================================================================
+std::uint32_t PacketTemplate::getContribution(std::uint32_t   value,
+                                              const Counter&  counter,
+                                              const Checksum& checksum)
+{
+    std::uint32_t sum = 0;
+
+    for (unsigned int i = 0; i < counter.width; ++i)
+    {
+        unsigned int position = counter.offset + i;
+        if (position < checksum.first || position >= checksum.end)
+        {
+            continue;
+        }
+
+        // Bytes an even distance into the range are the high halves of the
+        // 16-bit words the sum is made of
+        std::uint32_t byte = value >> (counter.width - 1 - i) * 8 & 0xff;
+        sum += (position - checksum.first) % 2 ? byte : byte << 8;
+    }
+
+    return sum;
+}
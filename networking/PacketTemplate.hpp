@@ -0,0 +1,131 @@
+#if !defined PACKET_TEMPLATE_HPP
+#define PACKET_TEMPLATE_HPP
+
+#include <cstdint>
+#include <vector>
+
+// A packet built once and stamped out many times, for generating traffic at
+// high rates.  The template is copied into each send buffer once; after that,
+// getting a buffer ready for the next packet only rewrites the fields that
+// vary from packet to packet.  Varying fields are counters (sequence numbers,
+// addresses, ports) that step by a fixed amount every packet, and Internet
+// checksums covering them, which are updated incrementally (RFC 1624) from how
+// each counter differs from its value in the template rather than summed over
+// the whole packet again.
+class PacketTemplate
+{
+public:
+
+    // Copies the 'size' bytes at 'packet' as the template.  Any checksums to
+    // be kept up to date must already be right for these bytes.  Throws
+    // std::invalid_argument if 'size' is zero.
+    PacketTemplate(const std::uint8_t* packet, unsigned int size);
+
+    // Does nothing
+    ~PacketTemplate();
+
+    // Adds a big-endian field of 'width' bytes (1, 2 or 4) at 'offset' that
+    // reads 'start', 'start' + 'step' and so on for successive packets, going
+    // back to 'start' after 'count' packets (0 means never; the field just
+    // wraps at its width).  Returns false if the field doesn't fit in the
+    // template or overlaps one already added, or there are already
+    // FIELDS_MAX fields.
+    bool addCounter(unsigned int  offset,
+                    unsigned int  width,
+                    std::uint32_t start,
+                    std::uint32_t step = 1,
+                    std::uint32_t count = 0);
+
+    // Keeps the 16-bit Internet checksum at 'checksum_offset' right as
+    // counters change, given that it covers template bytes 'first' up to
+    // 'end'.  Whatever else it covers (a pseudo-header, say) mustn't vary.
+    // Returns false if the checksum or range doesn't fit in the template, or
+    // there are already FIELDS_MAX checksums.
+    bool addChecksum(unsigned int checksum_offset,
+                     unsigned int first,
+                     unsigned int end);
+
+    // Copies the whole template into 'buffer', which must have room for
+    // getSize() bytes
+    void copy(std::uint8_t* buffer) const;
+
+    // Rewrites the counters and checksums in 'buffer', which must hold a copy
+    // of the template, to make it packet number 'index'.  Nothing else in
+    // 'buffer' is touched, and what it held before doesn't matter.
+    void fill(std::uint8_t* buffer, std::uint64_t index) const;
+
+    // Returns the template
+    const std::uint8_t* getData() const;
+    unsigned int getSize() const;
+
+    // Returns the Internet checksum of 'size' bytes at 'data', carrying on
+    // from the ones' complement sum 'sum' of anything before them (a
+    // pseudo-header, say)
+    static std::uint16_t computeChecksum(const std::uint8_t* data,
+                                         unsigned int        size,
+                                         std::uint32_t       sum = 0);
+
+    // Most counters, and most checksums, a template can have
+    static const unsigned int FIELDS_MAX = 8;
+
+private:
+
+    struct Counter
+    {
+        unsigned int  offset;
+        unsigned int  width;
+        std::uint32_t start;
+        std::uint32_t step;
+        std::uint32_t count;
+
+        // What the template holds there
+        std::uint32_t initial;
+    };
+
+    struct Checksum
+    {
+        unsigned int offset;
+        unsigned int first;
+        unsigned int end;
+
+        // What the template holds there, complemented, so counters' changes
+        // can be added straight to it
+        std::uint16_t initial_sum;
+    };
+
+    // Returns what 'counter' holds for packet 'index'
+    static std::uint32_t getValue(const Counter& counter, std::uint64_t index);
+
+    // Returns what 'counter' holding 'value' adds to the sum behind
+    // 'checksum', counting only the bytes the checksum covers
+    static std::uint32_t getContribution(std::uint32_t   value,
+                                         const Counter&  counter,
+                                         const Checksum& checksum);
+
+    std::vector<std::uint8_t> data;
+
+    Counter      counters[FIELDS_MAX];
+    unsigned int counter_count;
+
+    Checksum     checksums[FIELDS_MAX];
+    unsigned int checksum_count;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    PacketTemplate(const PacketTemplate&);
+    PacketTemplate& operator=(const PacketTemplate&);
+};
+
+//==============================================================================
+inline const std::uint8_t* PacketTemplate::getData() const
+{
+    return &data[0];
+}
+
+//==============================================================================
+inline unsigned int PacketTemplate::getSize() const
+{
+    return data.size();
+}
+
+#endif
@@ -0,0 +1,204 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "PacketTemplate_test.hpp"
+
+#include "Ipv4Header.hpp"
+#include "PacketTemplate.hpp"
+#include "UdpHeader.hpp"
+
+#include "TestMacros.hpp"
+#include "misc.hpp"
+
+TEST_PROGRAM_MAIN(PacketTemplate_test);
+
+//==============================================================================
+void PacketTemplate_test::addTestCases()
+{
+    ADD_TEST_CASE(Counters);
+    ADD_TEST_CASE(Checksums);
+    ADD_TEST_CASE(Limits);
+}
+
+//==============================================================================
+// Reads a big-endian field
+//==============================================================================
+static std::uint32_t read(const std::vector<std::uint8_t>& buffer,
+                          unsigned int                     offset,
+                          unsigned int                     width)
+{
+    std::uint32_t value = 0;
+    for (unsigned int i = 0; i < width; ++i)
+    {
+        value = value << 8 | buffer[offset + i];
+    }
+
+    return value;
+}
+
+//==============================================================================
+Test::Result PacketTemplate_test::Counters::body()
+{
+    std::vector<std::uint8_t> packet(16);
+    for (unsigned int i = 0; i < packet.size(); ++i)
+    {
+        packet[i] = static_cast<std::uint8_t>(0xa0 + i);
+    }
+
+    PacketTemplate packet_template(&packet[0], packet.size());
+    MUST_BE_TRUE(packet_template.addCounter(0, 4, 1000));
+    MUST_BE_TRUE(packet_template.addCounter(4, 2, 0xfffe, 1));
+    MUST_BE_TRUE(packet_template.addCounter(7, 1, 10, 5, 3));
+
+    std::vector<std::uint8_t> buffer(packet.size());
+    packet_template.copy(&buffer[0]);
+    MUST_BE_TRUE(buffer == packet);
+
+    packet_template.fill(&buffer[0], 0);
+    MUST_BE_TRUE(read(buffer, 0, 4) == 1000);
+    MUST_BE_TRUE(read(buffer, 4, 2) == 0xfffe);
+    MUST_BE_TRUE(buffer[7] == 10);
+
+    // Counters wrap at their width, or after their count
+    packet_template.fill(&buffer[0], 2);
+    MUST_BE_TRUE(read(buffer, 0, 4) == 1002);
+    MUST_BE_TRUE(read(buffer, 4, 2) == 0);
+    MUST_BE_TRUE(buffer[7] == 20);
+
+    packet_template.fill(&buffer[0], 3);
+    MUST_BE_TRUE(buffer[7] == 10);
+
+    // Packets needn't be filled in order, and nothing else is touched
+    packet_template.fill(&buffer[0], 1000001);
+    MUST_BE_TRUE(read(buffer, 0, 4) == 1001001);
+    MUST_BE_TRUE(buffer[7] == 20);
+    MUST_BE_TRUE(buffer[6] == packet[6]);
+    for (unsigned int i = 8; i < packet.size(); ++i)
+    {
+        MUST_BE_TRUE(buffer[i] == packet[i]);
+    }
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result PacketTemplate_test::Checksums::body()
+{
+    // An IPv4 UDP packet with an odd-sized payload
+    const unsigned int PAYLOAD_SIZE = 37;
+    const unsigned int UDP_OFFSET   = Ipv4Header::LENGTH_BYTES;
+    const unsigned int DATA_OFFSET  = UDP_OFFSET + UdpHeader::LENGTH_BYTES;
+    const unsigned int SIZE         = DATA_OFFSET + PAYLOAD_SIZE;
+
+    Ipv4Header ip(Ipv4Header::UDP);
+    ip.setTotalLength(SIZE);
+    ip.setTtl(64);
+    *ip.getSource()      = "10.1.2.3";
+    *ip.getDestination() = "10.4.5.6";
+
+    UdpHeader udp(5000, 6000);
+    udp.setLength(SIZE - UDP_OFFSET);
+
+    std::vector<std::uint8_t> packet(SIZE);
+    ip.writeRaw(&packet[0], misc::ENDIAN_BIG);
+    udp.writeRaw(&packet[UDP_OFFSET], misc::ENDIAN_BIG);
+    for (unsigned int i = DATA_OFFSET; i < SIZE; ++i)
+    {
+        packet[i] = static_cast<std::uint8_t>(i * 13);
+    }
+
+    std::uint16_t ip_checksum =
+        PacketTemplate::computeChecksum(&packet[0], Ipv4Header::LENGTH_BYTES);
+    packet[10] = static_cast<std::uint8_t>(ip_checksum >> 8);
+    packet[11] = static_cast<std::uint8_t>(ip_checksum);
+
+    // The UDP checksum covers the addresses, the protocol and the UDP length
+    // as a pseudo-header; the addresses sit just before the UDP header, so
+    // summing from them on and adding the rest covers everything
+    std::uint32_t pseudo = Ipv4Header::UDP + SIZE - UDP_OFFSET;
+    std::uint16_t udp_checksum =
+        PacketTemplate::computeChecksum(&packet[12], SIZE - 12, pseudo);
+    packet[UDP_OFFSET + 6] = static_cast<std::uint8_t>(udp_checksum >> 8);
+    packet[UDP_OFFSET + 7] = static_cast<std::uint8_t>(udp_checksum);
+
+    PacketTemplate packet_template(&packet[0], SIZE);
+
+    // Identification, source address, source port, a sequence number and a
+    // counter at an odd offset into the payload
+    MUST_BE_TRUE(packet_template.addCounter(4, 2, 0x1234, 77));
+    MUST_BE_TRUE(packet_template.addCounter(12, 4, 0x0a010203, 1, 250));
+    MUST_BE_TRUE(packet_template.addCounter(UDP_OFFSET, 2, 5000, 1, 64));
+    MUST_BE_TRUE(packet_template.addCounter(DATA_OFFSET, 4, 0, 1));
+    MUST_BE_TRUE(packet_template.addCounter(DATA_OFFSET + 5, 2, 3, 0x4321));
+    MUST_BE_TRUE(packet_template.addCounter(SIZE - 1, 1, 0, 3));
+
+    MUST_BE_TRUE(packet_template.addChecksum(10, 0, Ipv4Header::LENGTH_BYTES));
+    MUST_BE_TRUE(packet_template.addChecksum(UDP_OFFSET + 6, 12, SIZE));
+
+    std::vector<std::uint8_t> buffer(SIZE);
+    packet_template.copy(&buffer[0]);
+
+    // Every packet's checksums must come out as a full recomputation would
+    // have them, whatever order packets are filled in
+    for (std::uint64_t index = 0; index < 100000; index += 37)
+    {
+        packet_template.fill(&buffer[0], index * 7919 % 1000003);
+
+        // Summing over a correct checksum gives zero (or its equivalent all
+        // ones)
+        std::uint16_t ip_sum = PacketTemplate::computeChecksum(
+            &buffer[0], Ipv4Header::LENGTH_BYTES);
+        std::uint16_t udp_sum =
+            PacketTemplate::computeChecksum(&buffer[12], SIZE - 12, pseudo);
+
+        if ((ip_sum != 0 && ip_sum != 0xffff) ||
+            (udp_sum != 0 && udp_sum != 0xffff) ||
+            read(buffer, UDP_OFFSET + 6, 2) == 0)
+        {
+            return Test::FAILED;
+        }
+    }
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result PacketTemplate_test::Limits::body()
+{
+    std::vector<std::uint8_t> packet(8);
+
+    bool thrown = false;
+    try
+    {
+        PacketTemplate empty(&packet[0], 0);
+    }
+    catch (std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    MUST_BE_TRUE(thrown);
+
+    PacketTemplate packet_template(&packet[0], packet.size());
+
+    // Fields have to fit, be a sensible width and not overlap
+    MUST_BE_FALSE(packet_template.addCounter(6, 4, 0));
+    MUST_BE_FALSE(packet_template.addCounter(0, 3, 0));
+    MUST_BE_FALSE(packet_template.addCounter(9, 1, 0));
+    MUST_BE_TRUE(packet_template.addCounter(2, 2, 0));
+    MUST_BE_FALSE(packet_template.addCounter(3, 1, 0));
+    MUST_BE_FALSE(packet_template.addCounter(0, 4, 0));
+
+    MUST_BE_FALSE(packet_template.addChecksum(7, 0, 8));
+    MUST_BE_FALSE(packet_template.addChecksum(0, 4, 2));
+    MUST_BE_FALSE(packet_template.addChecksum(0, 0, 9));
+
+    // There's only room for so many of each
+    for (unsigned int i = 0; i < PacketTemplate::FIELDS_MAX; ++i)
+    {
+        MUST_BE_TRUE(packet_template.addChecksum(0, 0, 8));
+    }
+    MUST_BE_FALSE(packet_template.addChecksum(0, 0, 8));
+
+    return Test::PASSED;
+}
@@ -0,0 +1,16 @@
+#if !defined PACKET_TEMPLATE_TEST
+#define PACKET_TEMPLATE_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(PacketTemplate_test)
+
+    TEST(Counters)
+    TEST(Checksums)
+    TEST(Limits)
+
+TEST_CASES_END(PacketTemplate_test)
+
+#endif
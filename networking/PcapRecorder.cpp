@@ -0,0 +1,484 @@
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "PcapRecorder.hpp"
+
+#include "PosixSocketCommon.hpp"
+#include "PosixTimespec.hpp"
+#include "RawSocket.hpp"
+
+const std::uint64_t PcapRecorder::FILE_SIZE_MAX_DEFAULT;
+const unsigned int  PcapRecorder::BLOCK_SIZE_DEFAULT;
+const unsigned int  PcapRecorder::BLOCKS_DEFAULT;
+const unsigned int  PcapRecorder::SNAP_LENGTH_DEFAULT;
+const unsigned int  PcapRecorder::READ_BATCH_SIZE;
+
+// The pcap file header; the magic number marks timestamps as nanoseconds
+static const std::uint32_t PCAP_MAGIC_NANOSECONDS = 0xa1b23c4d;
+static const std::uint16_t PCAP_VERSION_MAJOR     = 2;
+static const std::uint16_t PCAP_VERSION_MINOR     = 4;
+static const std::uint32_t PCAP_LINKTYPE_ETHERNET = 1;
+static const unsigned int  PCAP_FILE_HEADER_SIZE  = 24;
+
+// Each record is this header followed by the frame
+static const unsigned int PCAP_RECORD_HEADER_SIZE = 16;
+
+// How long the reader waits for a frame before checking whether it's been
+// told to stop (seconds)
+static const double RECEIVE_TIMEOUT = 0.1;
+
+// How long a partly-filled block may sit before it's written anyway, so that
+// a slow trickle of frames still reaches the disk (seconds)
+static const double FLUSH_INTERVAL = 0.5;
+
+//==============================================================================
+// Appends a value to a buffer in host byte order, which pcap readers detect
+// from the magic number
+//==============================================================================
+template <typename T>
+static void append(unsigned char* buffer, unsigned int& offset, T value)
+{
+    memcpy(buffer + offset, &value, sizeof(value));
+    offset += sizeof(value);
+}
+
+//==============================================================================
+// Writes the whole buffer to a descriptor
+//==============================================================================
+static bool writeAll(int fd, const unsigned char* buffer, std::uint64_t size)
+{
+    while (size > 0)
+    {
+        ssize_t ret = ::write(fd, buffer, size);
+
+        if (ret == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+#if defined DEBUG
+            perror("PcapRecorder::writeAll");
+#endif
+            return false;
+        }
+
+        buffer += ret;
+        size   -= ret;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Saves the socket; nothing is read until start()
+//==============================================================================
+PcapRecorder::PcapRecorder(RawSocket& socket) :
+    socket(socket),
+    file_size_max(0),
+    snap_length(0),
+    receive_done(false),
+    file_fd(-1),
+    file_size(0),
+    stopping(false),
+    frame_count(0),
+    drop_count(0),
+    file_count(0),
+    bytes_written(0),
+    socket_was_blocking(true),
+    socket_blocking_timeout(0.0),
+    running(false)
+{
+}
+
+//==============================================================================
+// Stops everything
+//==============================================================================
+PcapRecorder::~PcapRecorder()
+{
+    stop();
+}
+
+//==============================================================================
+// Sets up the blocks, opens the first file and starts both threads
+//==============================================================================
+bool PcapRecorder::start(const std::string& path_prefix,
+                         std::uint64_t      file_size_max,
+                         unsigned int       block_size,
+                         unsigned int       blocks,
+                         unsigned int       snap_length)
+{
+    // Every block and every file must hold at least one frame
+    unsigned int record_size_max = PCAP_RECORD_HEADER_SIZE + snap_length;
+    if (running || blocks == 0 || snap_length == 0 ||
+        block_size < record_size_max ||
+        (file_size_max != 0 &&
+         file_size_max < PCAP_FILE_HEADER_SIZE + record_size_max))
+    {
+        return false;
+    }
+
+    this->path_prefix   = path_prefix;
+    this->file_size_max = file_size_max;
+    this->snap_length   = snap_length;
+
+    frame_count   = 0;
+    drop_count    = 0;
+    file_count    = 0;
+    bytes_written = 0;
+
+    if (!openNextFile())
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < blocks; ++i)
+    {
+        Block* block = new Block();
+        block->data.resize(block_size);
+        block->used   = 0;
+        block->frames = 0;
+
+        this->blocks.push_back(block);
+        free_blocks.push_back(block);
+    }
+
+    // The reader needs to wake up now and then to check whether it's been
+    // told to stop; kernel timestamps are used if they're available
+    socket_was_blocking     = socket.isBlockingEnabled();
+    socket_blocking_timeout = socket.getBlockingTimeout();
+    socket.enableBlocking();
+    socket.setBlockingTimeout(RECEIVE_TIMEOUT);
+    socket.enableTimestamps();
+
+    receive_done = false;
+    stopping     = false;
+    running      = true;
+
+    receiver = std::thread(&PcapRecorder::receiveLoop, this);
+    writer   = std::thread(&PcapRecorder::writeLoop, this);
+
+    return true;
+}
+
+//==============================================================================
+// Stops reading, finishes writing and cleans up
+//==============================================================================
+void PcapRecorder::stop()
+{
+    // The reader notices within one receive timeout and queues what it has;
+    // the writer finishes the queue and then exits
+    stopping = true;
+
+    if (receiver.joinable())
+    {
+        receiver.join();
+    }
+
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+
+    if (file_fd != -1)
+    {
+        close(file_fd);
+        file_fd = -1;
+    }
+
+    for (unsigned int i = 0; i < blocks.size(); ++i)
+    {
+        delete blocks[i];
+    }
+
+    blocks.clear();
+    free_blocks.clear();
+    full_blocks.clear();
+
+    if (running)
+    {
+        socket.setBlockingTimeout(socket_blocking_timeout);
+        if (!socket_was_blocking)
+        {
+            socket.disableBlocking();
+        }
+    }
+
+    running = false;
+}
+
+//==============================================================================
+// Reads frames into blocks until told to stop
+//==============================================================================
+void PcapRecorder::receiveLoop()
+{
+    std::vector<unsigned char> storage(READ_BATCH_SIZE * snap_length);
+    unsigned char*             buffers[READ_BATCH_SIZE];
+    unsigned int               sizes[READ_BATCH_SIZE];
+    unsigned int               wire_sizes[READ_BATCH_SIZE];
+    PosixTimespec              timestamps[READ_BATCH_SIZE];
+
+    for (unsigned int i = 0; i < READ_BATCH_SIZE; ++i)
+    {
+        buffers[i] = &storage[i * snap_length];
+    }
+
+    Block* block       = takeFreeBlock();
+    double block_start = 0.0;
+
+    while (!stopping)
+    {
+        // Stands in for the kernel's timestamp if it doesn't give one
+        timespec read_time;
+        clock_gettime(CLOCK_REALTIME, &read_time);
+
+        for (unsigned int i = 0; i < READ_BATCH_SIZE; ++i)
+        {
+            sizes[i]      = snap_length;
+            timestamps[i] = read_time;
+        }
+
+        int frames = socket.readBatch(buffers, sizes, READ_BATCH_SIZE,
+                                      timestamps, wire_sizes);
+
+        for (int i = 0; i < frames; ++i)
+        {
+            unsigned int record_size = PCAP_RECORD_HEADER_SIZE + sizes[i];
+
+            if (block && block->used + record_size > block->data.size())
+            {
+                handOff(block);
+                block = 0;
+            }
+
+            if (!block)
+            {
+                block = takeFreeBlock();
+            }
+
+            // The writer is behind and every block is waiting on it
+            if (!block)
+            {
+                drop_count.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (block->used == 0)
+            {
+                block_start = PosixSocketCommon::getMonotonicSeconds();
+            }
+
+            unsigned char* data   = &block->data[0];
+            unsigned int&  offset = block->used;
+
+            append<std::uint32_t>(data, offset, timestamps[i].getSeconds());
+            append<std::uint32_t>(data, offset, timestamps[i].getNanoseconds());
+            // Frames cut at the snap length keep their length on the wire
+            // so readers can tell they're incomplete
+            append<std::uint32_t>(data, offset, sizes[i]);
+            append<std::uint32_t>(data, offset, wire_sizes[i]);
+            memcpy(data + offset, buffers[i], sizes[i]);
+            offset += sizes[i];
+
+            block->frames++;
+            frame_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (block && block->used > 0 &&
+            PosixSocketCommon::getMonotonicSeconds() - block_start >=
+                FLUSH_INTERVAL)
+        {
+            handOff(block);
+            block = 0;
+        }
+    }
+
+    if (block && block->used > 0)
+    {
+        handOff(block);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    receive_done = true;
+    queued.notify_one();
+}
+
+//==============================================================================
+// Writes full blocks until the reader is done and nothing's left
+//==============================================================================
+void PcapRecorder::writeLoop()
+{
+    while (true)
+    {
+        Block* block = 0;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (full_blocks.empty() && !receive_done)
+            {
+                queued.wait(lock);
+            }
+
+            if (full_blocks.empty())
+            {
+                return;
+            }
+
+            block = full_blocks.front();
+            full_blocks.pop_front();
+        }
+
+        // Frames that can't be written are as lost as ones never read
+        if (!writeBlock(*block))
+        {
+            drop_count.fetch_add(block->frames, std::memory_order_relaxed);
+        }
+
+        block->used   = 0;
+        block->frames = 0;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        free_blocks.push_back(block);
+    }
+}
+
+//==============================================================================
+// Takes an empty block, if any
+//==============================================================================
+PcapRecorder::Block* PcapRecorder::takeFreeBlock()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (free_blocks.empty())
+    {
+        return 0;
+    }
+
+    Block* block = free_blocks.front();
+    free_blocks.pop_front();
+    return block;
+}
+
+//==============================================================================
+// Queues a block for the writer
+//==============================================================================
+void PcapRecorder::handOff(Block* block)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    full_blocks.push_back(block);
+    queued.notify_one();
+}
+
+//==============================================================================
+// Writes a block's records, splitting them across files at the size limit
+//==============================================================================
+bool PcapRecorder::writeBlock(const Block& block)
+{
+    const unsigned char* data = &block.data[0];
+
+    unsigned int start = 0;
+    while (start < block.used)
+    {
+        // Take as many whole records as fit in what's left of this file
+        unsigned int end = start;
+        while (end < block.used)
+        {
+            std::uint32_t length;
+            memcpy(&length, data + end + 8, sizeof(length));
+            unsigned int record_size = PCAP_RECORD_HEADER_SIZE + length;
+
+            if (file_size_max != 0 &&
+                file_size + (end - start) + record_size > file_size_max)
+            {
+                break;
+            }
+
+            end += record_size;
+        }
+
+        if (end > start)
+        {
+            if (file_fd == -1 || !writeAll(file_fd, data + start, end - start))
+            {
+                return false;
+            }
+
+            file_size += end - start;
+            bytes_written.fetch_add(end - start, std::memory_order_relaxed);
+            start = end;
+        }
+
+        if (start < block.used && !openNextFile())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Moves on to a new file
+//==============================================================================
+bool PcapRecorder::openNextFile()
+{
+    if (file_fd != -1)
+    {
+        close(file_fd);
+        file_fd = -1;
+    }
+
+    std::ostringstream path;
+    path << path_prefix << "_" << std::setw(5) << std::setfill('0')
+         << file_count.load(std::memory_order_relaxed) << ".pcap";
+
+    file_fd = open(path.str().c_str(),
+                   O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    if (file_fd == -1)
+    {
+#if defined DEBUG
+        perror("PcapRecorder::openNextFile");
+#endif
+        return false;
+    }
+
+    file_count.fetch_add(1, std::memory_order_relaxed);
+
+    unsigned char header[PCAP_FILE_HEADER_SIZE];
+    unsigned int  offset = 0;
+    append<std::uint32_t>(header, offset, PCAP_MAGIC_NANOSECONDS);
+    append<std::uint16_t>(header, offset, PCAP_VERSION_MAJOR);
+    append<std::uint16_t>(header, offset, PCAP_VERSION_MINOR);
+    append<std::int32_t>(header, offset, 0);   // Timezone offset, always UTC
+    append<std::uint32_t>(header, offset, 0);  // Timestamp accuracy, unused
+    append<std::uint32_t>(header, offset, snap_length);
+    append<std::uint32_t>(header, offset, PCAP_LINKTYPE_ETHERNET);
+
+    if (!writeAll(file_fd, header, sizeof(header)))
+    {
+        close(file_fd);
+        file_fd = -1;
+        return false;
+    }
+
+    file_size = sizeof(header);
+    bytes_written.fetch_add(sizeof(header), std::memory_order_relaxed);
+
+    return true;
+}
@@ -0,0 +1,191 @@
+#if !defined PCAP_RECORDER_HPP
+#define PCAP_RECORDER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class RawSocket;
+
+// Records everything a RawSocket receives to pcap files, at rates where frames
+// can't wait on the disk.  One thread reads frames in batches and packs them,
+// as pcap records, into large blocks of memory; whenever a block fills up
+// it's handed to a second thread that writes it out while the first carries on
+// filling another.  If the writer falls so far behind that no empty block is
+// left, frames are dropped and counted rather than the reader stalling.
+//
+// Files use the nanosecond-resolution pcap format and are named
+// <prefix>_00000.pcap, <prefix>_00001.pcap and so on; a new file is started
+// whenever the current one would otherwise grow past the size limit.
+// Frames are timestamped by the kernel when the socket supports it and when
+// they're read otherwise.  Linux only.
+class PcapRecorder
+{
+public:
+
+    // Records from 'socket', which must outlive this object.  Nothing is read
+    // until start().
+    explicit PcapRecorder(RawSocket& socket);
+
+    // Calls stop()
+    ~PcapRecorder();
+
+    // Opens the first file and starts recording.  'file_size_max' is the
+    // largest any file may grow (0 for no limit), 'block_size' the size of
+    // each block and 'blocks' how many there are; more blocks ride out longer
+    // disk stalls.  Frames longer than 'snap_length' are cut short, with
+    // their full length kept in the record header.  The socket is switched to
+    // blocking with a short timeout while recording, and put back how it was
+    // by stop().  Returns false if the sizes don't leave room for at least
+    // one frame or the file can't be opened.
+    bool start(const std::string& path_prefix,
+               std::uint64_t      file_size_max = FILE_SIZE_MAX_DEFAULT,
+               unsigned int       block_size    = BLOCK_SIZE_DEFAULT,
+               unsigned int       blocks        = BLOCKS_DEFAULT,
+               unsigned int       snap_length   = SNAP_LENGTH_DEFAULT);
+
+    // Stops reading, waits for everything recorded so far to be written and
+    // closes the file.  Blocks for as long as the disk does.
+    void stop();
+
+    // Returns true between a successful start() and the following stop()
+    bool isRunning() const;
+
+    // Returns the number of frames recorded since the last start()
+    unsigned long getFrameCount() const;
+
+    // Returns the number of frames lost since the last start(), either
+    // because no block was free or because writing them failed.  Frames the
+    // kernel dropped before they could be read show up in the socket's own
+    // statistics instead.
+    unsigned long getDropCount() const;
+
+    // Returns the number of files opened since the last start()
+    unsigned long getFileCount() const;
+
+    // Returns the number of bytes written to files since the last start()
+    std::uint64_t getBytesWritten() const;
+
+    static const std::uint64_t FILE_SIZE_MAX_DEFAULT = 1024 * 1024 * 1024;
+    static const unsigned int  BLOCK_SIZE_DEFAULT    = 4 * 1024 * 1024;
+    static const unsigned int  BLOCKS_DEFAULT        = 2;
+    static const unsigned int  SNAP_LENGTH_DEFAULT   = 65535;
+
+    // Most frames read by the reader in one go
+    static const unsigned int READ_BATCH_SIZE = 32;
+
+private:
+
+    // A run of pcap records, without the file header
+    struct Block
+    {
+        std::vector<unsigned char> data;
+
+        unsigned int used;
+
+        unsigned long frames;
+    };
+
+    // Body of the reading thread
+    void receiveLoop();
+
+    // Body of the writing thread
+    void writeLoop();
+
+    // Takes an empty block if there is one; returns 0 otherwise
+    Block* takeFreeBlock();
+
+    // Queues a block for writing
+    void handOff(Block* block);
+
+    // Writes the records in a block, starting new files as needed
+    bool writeBlock(const Block& block);
+
+    // Closes the current file, if any, and opens the next with its header
+    bool openNextFile();
+
+    RawSocket& socket;
+
+    std::string path_prefix;
+
+    std::uint64_t file_size_max;
+
+    unsigned int snap_length;
+
+    // Every block, whether empty, being filled or being written
+    std::vector<Block*> blocks;
+
+    // Guards the two queues and 'receive_done'
+    std::mutex mutex;
+
+    // Signalled when a block is queued for writing or the reader finishes
+    std::condition_variable queued;
+
+    std::deque<Block*> free_blocks;
+    std::deque<Block*> full_blocks;
+
+    // Set by the reader once it has queued its last block
+    bool receive_done;
+
+    std::thread receiver;
+    std::thread writer;
+
+    int file_fd;
+
+    std::uint64_t file_size;
+
+    std::atomic<bool> stopping;
+
+    std::atomic<unsigned long> frame_count;
+    std::atomic<unsigned long> drop_count;
+    std::atomic<unsigned long> file_count;
+    std::atomic<std::uint64_t> bytes_written;
+
+    // How the socket was set up before start(), to be put back by stop()
+    bool   socket_was_blocking;
+    double socket_blocking_timeout;
+
+    bool running;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    PcapRecorder(const PcapRecorder&);
+    PcapRecorder& operator=(const PcapRecorder&);
+};
+
+//==============================================================================
+inline bool PcapRecorder::isRunning() const
+{
+    return running;
+}
+
+//==============================================================================
+inline unsigned long PcapRecorder::getFrameCount() const
+{
+    return frame_count.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+inline unsigned long PcapRecorder::getDropCount() const
+{
+    return drop_count.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+inline unsigned long PcapRecorder::getFileCount() const
+{
+    return file_count.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+inline std::uint64_t PcapRecorder::getBytesWritten() const
+{
+    return bytes_written.load(std::memory_order_relaxed);
+}
+
+#endif
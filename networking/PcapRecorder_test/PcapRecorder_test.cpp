@@ -0,0 +1,430 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "PcapRecorder_test.hpp"
+
+#include "PcapRecorder.hpp"
+#include "RawSocket.hpp"
+#include "SocketStatistics.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+#include "UDPSocket.hpp"
+
+TEST_PROGRAM_MAIN(PcapRecorder_test);
+
+//==============================================================================
+void PcapRecorder_test::addTestCases()
+{
+    ADD_TEST_CASE(Record);
+    ADD_TEST_CASE(Rotation);
+    ADD_TEST_CASE(SnapLength);
+    ADD_TEST_CASE(DiskStall);
+}
+
+// What a pcap file held, as far as these tests care
+struct PcapContents
+{
+    bool valid;
+
+    std::uint64_t size;
+
+    // Records holding UDP datagrams sent to the port being looked for
+    unsigned int matched;
+
+    unsigned int records;
+
+    // Records cut short at the snap length
+    unsigned int truncated;
+
+    // Longest length on the wire of any record
+    unsigned int wire_max;
+};
+
+//==============================================================================
+// Returns a file name prefix no other test (or test run) is using
+//==============================================================================
+static std::string getPrefix(const std::string& test_name)
+{
+    std::ostringstream name;
+    name << "/tmp/PcapRecorder_test_" << getpid() << "_" << test_name;
+    return name.str();
+}
+
+//==============================================================================
+// Returns the name of the given file in a recording
+//==============================================================================
+static std::string getPath(const std::string& prefix, unsigned int index)
+{
+    std::ostringstream path;
+    path << prefix << "_" << std::setw(5) << std::setfill('0') << index
+         << ".pcap";
+    return path.str();
+}
+
+//==============================================================================
+// Returns true if raw sockets can be opened here
+//==============================================================================
+static bool rawSocketsPermitted()
+{
+    try
+    {
+        RawSocket raw_socket;
+    }
+    catch (std::runtime_error&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Reads back a pcap file, checking its header and the timestamp of every
+// record, and counts records carrying UDP datagrams sent to 'port'
+//==============================================================================
+static PcapContents readPcap(const std::string& path, unsigned int port)
+{
+    PcapContents contents;
+    contents.valid   = false;
+    contents.size    = 0;
+    contents.matched = 0;
+    contents.records = 0;
+
+    contents.truncated = 0;
+    contents.wire_max  = 0;
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)),
+                                    std::istreambuf_iterator<char>());
+    contents.size = data.size();
+
+    std::uint32_t header[6];
+    if (data.size() < sizeof(header))
+    {
+        return contents;
+    }
+
+    memcpy(header, &data[0], sizeof(header));
+    if (header[0] != 0xa1b23c4d || header[5] != 1)
+    {
+        return contents;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    unsigned int offset = sizeof(header);
+    while (offset + 16 <= data.size())
+    {
+        std::uint32_t record[4];
+        memcpy(record, &data[offset], sizeof(record));
+        offset += sizeof(record);
+
+        // Timestamps are recent and in nanoseconds; lengths fit the file,
+        // and only frames longer than the snap length are cut short
+        if (record[0] + 60 < static_cast<std::uint32_t>(now.tv_sec) ||
+            record[0] > static_cast<std::uint32_t>(now.tv_sec) ||
+            record[1] >= 1000000000 || record[2] > header[4] ||
+            record[2] != std::min(record[3], header[4]) ||
+            offset + record[2] > data.size())
+        {
+            return contents;
+        }
+
+        if (record[2] < record[3])
+        {
+            contents.truncated++;
+        }
+
+        contents.wire_max = std::max(contents.wire_max, record[3]);
+
+        const unsigned char* frame = &data[offset];
+        offset += record[2];
+        contents.records++;
+
+        // IPv4 carrying UDP behind a loopback Ethernet header
+        if (record[2] >= 42 && frame[12] == 0x08 && frame[13] == 0x00 &&
+            frame[23] == 17)
+        {
+            unsigned int udp = 14 + (frame[14] & 0x0f) * 4;
+            if (record[2] >= udp + 8 &&
+                static_cast<unsigned int>(frame[udp + 2] << 8 |
+                                          frame[udp + 3]) == port)
+            {
+                contents.matched++;
+            }
+        }
+    }
+
+    contents.valid = offset == data.size();
+    return contents;
+}
+
+//==============================================================================
+// Sends 'count' datagrams of the given size to 'port' over loopback.  Unless
+// 'burst' is set they're paced so the raw socket's receive queue never
+// overflows.
+//==============================================================================
+static bool sendDatagrams(unsigned int port,
+                          unsigned int count,
+                          unsigned int size,
+                          bool         burst = false)
+{
+    unsigned int sender_port = 0;
+    UDPSocket sender;
+    if (!sender.bind(sender_port) || !sender.sendTo("127.0.0.1", port))
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> buffer(size);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (sender.write(&buffer[0], size) != static_cast<int>(size))
+        {
+            return false;
+        }
+
+        if (!burst && i % 10 == 9)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Waits up to two seconds for 'recorder' to have seen 'count' frames
+//==============================================================================
+static void waitForFrames(PcapRecorder& recorder, unsigned long count)
+{
+    for (unsigned int i = 0;
+         i < 200 && recorder.getFrameCount() + recorder.getDropCount() < count;
+         ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+//==============================================================================
+Test::Result PcapRecorder_test::Record::body()
+{
+    // Capturing needs CAP_NET_RAW
+    SKIP_IF_FALSE(rawSocketsPermitted());
+
+    const unsigned int DATAGRAMS = 100;
+
+    std::string prefix = getPrefix("Record");
+
+    unsigned int port = 0;
+    UDPSocket receiver;
+    MUST_BE_TRUE(receiver.bind(port));
+
+    RawSocket socket;
+    MUST_BE_TRUE(socket.setInputInterface("lo"));
+    MUST_BE_TRUE(socket.isBlockingEnabled());
+
+    PcapRecorder recorder(socket);
+
+    // Sizes that leave no room for a frame are refused
+    MUST_BE_FALSE(recorder.start(prefix, 0, 1024, 2, 2048));
+    MUST_BE_FALSE(recorder.start(prefix, 100, 65536, 2, 2048));
+    MUST_BE_FALSE(recorder.start(prefix, 0, 65536, 0, 2048));
+    MUST_BE_FALSE(recorder.isRunning());
+
+    MUST_BE_TRUE(recorder.start(prefix));
+    MUST_BE_TRUE(recorder.isRunning());
+    MUST_BE_FALSE(recorder.start(prefix));
+
+    MUST_BE_TRUE(sendDatagrams(port, DATAGRAMS, 100));
+
+    // Loopback frames are seen once going out and once coming back in
+    waitForFrames(recorder, DATAGRAMS * 2);
+
+    recorder.stop();
+    MUST_BE_FALSE(recorder.isRunning());
+
+    // The socket is back the way it was
+    MUST_BE_TRUE(socket.isBlockingEnabled());
+    MUST_BE_TRUE(socket.getBlockingTimeout() == 0.0);
+
+    MUST_BE_TRUE(recorder.getFileCount() == 1);
+    MUST_BE_TRUE(recorder.getDropCount() == 0);
+
+    PcapContents contents = readPcap(getPath(prefix, 0), port);
+    unlink(getPath(prefix, 0).c_str());
+
+    MUST_BE_TRUE(contents.valid);
+    MUST_BE_TRUE(contents.matched == DATAGRAMS * 2);
+    MUST_BE_TRUE(contents.records == recorder.getFrameCount());
+    MUST_BE_TRUE(contents.size == recorder.getBytesWritten());
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result PcapRecorder_test::Rotation::body()
+{
+    SKIP_IF_FALSE(rawSocketsPermitted());
+
+    const unsigned int  DATAGRAMS     = 100;
+    const std::uint64_t FILE_SIZE_MAX = 8192;
+
+    std::string prefix = getPrefix("Rotation");
+
+    unsigned int port = 0;
+    UDPSocket receiver;
+    MUST_BE_TRUE(receiver.bind(port));
+
+    RawSocket socket;
+    MUST_BE_TRUE(socket.setInputInterface("lo"));
+
+    PcapRecorder recorder(socket);
+    MUST_BE_TRUE(recorder.start(prefix, FILE_SIZE_MAX, 65536, 2, 2048));
+
+    MUST_BE_TRUE(sendDatagrams(port, DATAGRAMS, 200));
+    waitForFrames(recorder, DATAGRAMS * 2);
+
+    recorder.stop();
+
+    // Around 50 KB of records
+    std::cout << "Wrote " << recorder.getFileCount() << " files\n";
+    MUST_BE_TRUE(recorder.getFileCount() > 5);
+
+    unsigned int  matched = 0;
+    unsigned int  records = 0;
+    std::uint64_t size    = 0;
+    for (unsigned int i = 0; i < recorder.getFileCount(); ++i)
+    {
+        PcapContents contents = readPcap(getPath(prefix, i), port);
+        unlink(getPath(prefix, i).c_str());
+
+        MUST_BE_TRUE(contents.valid);
+        MUST_BE_TRUE(contents.size <= FILE_SIZE_MAX);
+        matched += contents.matched;
+        records += contents.records;
+        size    += contents.size;
+    }
+
+    MUST_BE_TRUE(matched == DATAGRAMS * 2);
+    MUST_BE_TRUE(records == recorder.getFrameCount());
+    MUST_BE_TRUE(size == recorder.getBytesWritten());
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result PcapRecorder_test::SnapLength::body()
+{
+    SKIP_IF_FALSE(rawSocketsPermitted());
+
+    const unsigned int DATAGRAMS   = 20;
+    const unsigned int SNAP_LENGTH = 64;
+
+    std::string prefix = getPrefix("SnapLength");
+
+    unsigned int port = 0;
+    UDPSocket receiver;
+    MUST_BE_TRUE(receiver.bind(port));
+
+    RawSocket socket;
+    MUST_BE_TRUE(socket.setInputInterface("lo"));
+
+    PcapRecorder recorder(socket);
+    MUST_BE_TRUE(recorder.start(prefix, 0, 65536, 2, SNAP_LENGTH));
+
+    MUST_BE_TRUE(sendDatagrams(port, DATAGRAMS, 200));
+    waitForFrames(recorder, DATAGRAMS * 2);
+
+    recorder.stop();
+
+    PcapContents contents = readPcap(getPath(prefix, 0), port);
+    unlink(getPath(prefix, 0).c_str());
+
+    // The headers still say how long the frames really were: Ethernet, IPv4
+    // and UDP headers plus the payload
+    MUST_BE_TRUE(contents.valid);
+    MUST_BE_TRUE(contents.matched == DATAGRAMS * 2);
+    MUST_BE_TRUE(contents.truncated >= DATAGRAMS * 2);
+    MUST_BE_TRUE(contents.wire_max >= 14 + 20 + 8 + 200);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result PcapRecorder_test::DiskStall::body()
+{
+    SKIP_IF_FALSE(rawSocketsPermitted());
+
+    const unsigned int DATAGRAMS = 2000;
+
+    std::string prefix = getPrefix("DiskStall");
+    std::string path   = getPath(prefix, 0);
+
+    // A pipe nobody reads from stands in for a stalled disk; once its buffer
+    // fills, every write to it blocks
+    MUST_BE_TRUE(mkfifo(path.c_str(), S_IRUSR | S_IWUSR) == 0);
+    int reader_fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    MUST_BE_TRUE(reader_fd != -1);
+
+    unsigned int port = 0;
+    UDPSocket receiver;
+    MUST_BE_TRUE(receiver.bind(port));
+
+    RawSocket socket;
+    MUST_BE_TRUE(socket.setInputInterface("lo"));
+
+    PcapRecorder recorder(socket);
+    MUST_BE_TRUE(recorder.start(prefix, 0, 65536, 2, 2048));
+
+    // Far more than the pipe and both blocks can hold
+    MUST_BE_TRUE(sendDatagrams(port, DATAGRAMS, 1000, true));
+    waitForFrames(recorder, DATAGRAMS * 2);
+
+    // Unblock the writer so stop() can finish
+    std::thread drain([reader_fd]()
+    {
+        fcntl(reader_fd, F_SETFL, 0);
+        char buffer[65536];
+        while (read(reader_fd, buffer, sizeof(buffer)) > 0)
+        {
+        }
+    });
+
+    recorder.stop();
+    drain.join();
+    close(reader_fd);
+    unlink(path.c_str());
+
+    // Frames the kernel dropped never got as far as the recorder
+    SocketStatistics statistics;
+    socket.getStatistics(statistics);
+
+    std::cout << "Recorded " << recorder.getFrameCount() << " frames, dropped "
+              << recorder.getDropCount() << ", kernel dropped "
+              << statistics.getReceiveDrops() << "\n";
+
+    // Only a reader that kept going while the writer was stuck could have
+    // dropped anything
+    MUST_BE_TRUE(recorder.getFrameCount() > 0);
+    MUST_BE_TRUE(recorder.getDropCount() > 0);
+
+    return Test::PASSED;
+}
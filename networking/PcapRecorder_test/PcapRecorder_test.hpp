@@ -0,0 +1,17 @@
+#if !defined PCAP_RECORDER_TEST
+#define PCAP_RECORDER_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(PcapRecorder_test)
+
+    TEST(Record)
+    TEST(Rotation)
+    TEST(SnapLength)
+    TEST(DiskStall)
+
+TEST_CASES_END(PcapRecorder_test)
+
+#endif
@@ -1,17 +1,231 @@
 // Common POSIX socket operations live here
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <errno.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <poll.h>
 #include <stdio.h>
+#include <string>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 
+#if defined LINUX
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#endif
+
 #include "PosixSocketCommon.hpp"
 
+#include "PosixTimespec.hpp"
+#include "SocketKernelStatistics.hpp"
+#include "SocketStatistics.hpp"
+
+// Room for every kind of control message the receive paths ask for: a drop
+// count, a receive timestamp and a UDP GRO segment size
+union ControlBuffer
+{
+    char    buf[CMSG_SPACE(sizeof(std::uint32_t)) +
+                CMSG_SPACE(sizeof(timespec)) +
+                CMSG_SPACE(sizeof(int))];
+    cmsghdr align;
+};
+
+// Returns when a read or write that might block should start its clock for
+// the poll latency statistic, or 0 if there's nothing to measure
+static double getWaitStart(bool class_blocking, double class_ts_bt)
+{
+    return class_blocking && class_ts_bt > 0.0 ?
+        PosixSocketCommon::getMonotonicSeconds() : 0.0;
+}
+
+// Returns true if a failed receive or send on a blocking socket failed because
+// its blocking timeout (SO_RCVTIMEO or SO_SNDTIMEO) expired, and accounts for
+// it if so.  The kernel reports this exactly as it does a non-blocking
+// operation that would have blocked.
+static bool checkTimeout(int               ret,
+                         bool              class_blocking,
+                         double            class_ts_bt,
+                         SocketStatistics& class_stats)
+{
+    if (ret == -1 &&
+        class_blocking &&
+        class_ts_bt > 0.0 &&
+        (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        class_stats.recordTimeout();
+        return true;
+    }
+
+    return false;
+}
+
+// Returns true if a non-blocking read failed only because nothing was queued
+static bool isWouldBlock(int ret)
+{
+    return ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+// Spins until something is queued to read or 'deadline' passes, returning
+// true if something is.  Each check only peeks, and is counted as a spin probe
+// rather than as a syscall and a would-block.  An error also ends the spin, so
+// the read that follows can report it.
+static bool spinForData(int               socket_fd,
+                        double            deadline,
+                        SocketStatistics& class_stats)
+{
+    char byte;
+    do
+    {
+        class_stats.recordSpinProbe();
+
+        int ret = recv(socket_fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (!isWouldBlock(ret))
+        {
+            return true;
+        }
+    }
+    while (PosixSocketCommon::getMonotonicSeconds() < deadline);
+
+    return false;
+}
+
+// Returns true if the kernel filled in a receive timestamp, which spinning
+// reads start out as zero
+static bool isTimestamped(const PosixTimespec& timestamp)
+{
+    return timestamp.getSeconds() != 0 || timestamp.getNanoseconds() != 0;
+}
+
+// Accounts for how long after arriving each of the given datagrams was handed
+// over, skipping any the kernel didn't timestamp.  Kernel receive timestamps
+// are taken from CLOCK_REALTIME, so that's the clock read here, once for the
+// whole batch.
+static void recordDeliveryLatency(const PosixTimespec* timestamps,
+                                  unsigned int         count,
+                                  SocketStatistics&    class_stats)
+{
+    timespec now_ts;
+    clock_gettime(CLOCK_REALTIME, &now_ts);
+    PosixTimespec now(now_ts);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (isTimestamped(timestamps[i]))
+        {
+            class_stats.recordDeliveryLatency((now - timestamps[i]).toDouble());
+        }
+    }
+}
+
+// Zeroes whatever part of an address buffer the kernel didn't write, since
+// some addresses (Unix domain socket paths) are shorter than their buffers
+static void clearAddressTail(sockaddr* address,
+                             socklen_t address_size,
+                             socklen_t written)
+{
+    if (address && written < address_size)
+    {
+        memset(reinterpret_cast<char*>(address) + written,
+               0,
+               address_size - written);
+    }
+}
+
+// Copies the file descriptors in an SCM_RIGHTS control message into 'fds', up
+// to 'room' of them, and closes any others.  Returns the number copied.
+static unsigned int takeDescriptors(cmsghdr* cmsg, int* fds, unsigned int room)
+{
+    unsigned int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    unsigned int taken = 0;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+
+        if (taken < room)
+        {
+            fds[taken++] = fd;
+        }
+        else
+        {
+            close(fd);
+        }
+    }
+
+    return taken;
+}
+
+// Picks the drop count, receive timestamp and GRO segment size out of a
+// received message's control data, if they're there
+static void readControlMessages(msghdr&           msg,
+                                SocketStatistics& class_stats,
+                                PosixTimespec*    class_rxts,
+                                unsigned int*     class_rxss)
+{
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+         cmsg != 0;
+         cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+#if defined UDP_GRO
+        if (cmsg->cmsg_level == IPPROTO_UDP &&
+            cmsg->cmsg_type  == UDP_GRO &&
+            class_rxss)
+        {
+            int segment_size;
+            memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+            *class_rxss = segment_size;
+            continue;
+        }
+#endif
+
+        if (cmsg->cmsg_level != SOL_SOCKET)
+        {
+            continue;
+        }
+
+        // Nobody asked for these; closing them is all that can be done
+        if (cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            takeDescriptors(cmsg, 0, 0);
+            continue;
+        }
+
+#if defined SO_RXQ_OVFL
+        if (cmsg->cmsg_type == SO_RXQ_OVFL)
+        {
+            std::uint32_t drops;
+            memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            class_stats.setReceiveDrops(drops);
+        }
+#endif
+
+#if defined SCM_TIMESTAMPNS
+        if (cmsg->cmsg_type == SCM_TIMESTAMPNS && class_rxts)
+        {
+            timespec rxts;
+            memcpy(&rxts, CMSG_DATA(cmsg), sizeof(rxts));
+            class_rxts->setTimespec(rxts);
+        }
+#endif
+    }
+}
+
 //==============================================================================
 // Enables blocking on a file descriptor
 //==============================================================================
@@ -128,36 +342,510 @@ bool PosixSocketCommon::bind(int           socket_fd,
     return true;
 }
 
+//==============================================================================
+// Builds a Unix domain socket address
+//==============================================================================
+bool PosixSocketCommon::setLocalAddress(const std::string& path,
+                                        sockaddr_un&       address,
+                                        socklen_t&         address_size)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    // Filesystem paths need room for a terminating null; abstract names don't
+    // have one, but their leading null takes up the same space
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        errno = ENAMETOOLONG;
+#if defined DEBUG
+        perror("PosixSocketCommon::setLocalAddress");
+#endif
+        return false;
+    }
+
+    memcpy(address.sun_path, path.data(), path.size());
+    address_size = offsetof(sockaddr_un, sun_path) + path.size();
+
+#if defined LINUX
+    if (path[0] == '@')
+    {
+        // Abstract names are exactly as long as the address says
+        address.sun_path[0] = '\0';
+        return true;
+    }
+#endif
+
+    address_size += 1;
+    return true;
+}
+
+//==============================================================================
+// Gets the path out of a Unix domain socket address
+//==============================================================================
+std::string PosixSocketCommon::getLocalPath(const sockaddr_un& address)
+{
+    const std::size_t max = sizeof(address.sun_path);
+
+#if defined LINUX
+    if (address.sun_path[0] == '\0' && address.sun_path[1] != '\0')
+    {
+        // Abstract name; assumes the name itself contains no nulls
+        return "@" + std::string(address.sun_path + 1,
+                                 strnlen(address.sun_path + 1, max - 1));
+    }
+#endif
+
+    return std::string(address.sun_path, strnlen(address.sun_path, max));
+}
+
 //==============================================================================
 // Reads socket data into buffer
 //==============================================================================
-int PosixSocketCommon::read(int            socket_fd,
-                            unsigned char* buffer,
-                            unsigned int   size,
-                            double         class_ts_bt,
-                            sockaddr*      class_rfa,
-                            socklen_t      class_rfa_size)
+int PosixSocketCommon::read(int               socket_fd,
+                            unsigned char*    buffer,
+                            unsigned int      size,
+                            bool              class_blocking,
+                            double            class_ts_bt,
+                            sockaddr*         class_rfa,
+                            socklen_t         class_rfa_size,
+                            SocketStatistics& class_stats,
+                            PosixTimespec*    class_rxts,
+                            unsigned int*     class_rxss)
 {
-    // Is a valid timeout set?
-    if (isBlockingEnabled(socket_fd) && class_ts_bt > 0.0)
+    iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len  = size;
+
+    ControlBuffer control;
+
+    msghdr msg;
+    msg.msg_name       = class_rfa;
+    msg.msg_namelen    = class_rfa_size;
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    msg.msg_flags      = 0;
+
+    double wait_start = getWaitStart(class_blocking, class_ts_bt);
+
+    // Read data.  Any blocking timeout is handled by the kernel.
+    int ret = recvmsg(socket_fd, &msg, class_blocking ? 0 : MSG_DONTWAIT);
+    class_stats.recordSyscalls();
+
+    if (checkTimeout(ret, class_blocking, class_ts_bt, class_stats))
+    {
+        // No data is ready to read
+        return 0;
+    }
+
+    class_stats.recordRead(ret);
+
+    if (ret == -1)
     {
-        // Perform the blocking timeout and check if the POLLIN event occurred
-        if (doBlockingTimeout(socket_fd, POLLIN, class_ts_bt) == 0)
+#if defined DEBUG
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
         {
-            // No data is ready to read, just return
-            return 0;
+            perror("PosixSocketCommon::read");
         }
+#endif
+        return ret;
+    }
+
+    if (wait_start > 0.0)
+    {
+        class_stats.recordPollLatency(getMonotonicSeconds() - wait_start);
+    }
+
+    clearAddressTail(class_rfa, class_rfa_size, msg.msg_namelen);
+
+    // Anything not coalesced is a single segment
+    if (class_rxss)
+    {
+        *class_rxss = ret;
+    }
+
+    readControlMessages(msg, class_stats, class_rxts, class_rxss);
+
+    return ret;
+}
+
+//==============================================================================
+// Reads as many datagrams as are available, up to a limit
+//==============================================================================
+int PosixSocketCommon::readBatch(int               socket_fd,
+                                 unsigned char**   buffers,
+                                 unsigned int*     sizes,
+                                 unsigned int      count,
+                                 bool              class_blocking,
+                                 double            class_ts_bt,
+                                 sockaddr*         class_rfa,
+                                 socklen_t         class_rfa_size,
+                                 SocketStatistics& class_stats,
+                                 PosixTimespec*    timestamps,
+                                 unsigned int*     segment_sizes,
+                                 unsigned int*     wire_sizes)
+{
+    if (count == 0)
+    {
+        return 0;
     }
 
-    // Read data
-    int ret = recvfrom(socket_fd, buffer, size, 0, class_rfa, &class_rfa_size);
+#if defined LINUX
+    mmsghdr          msgs[READ_BATCH_MAX];
+    iovec            iovs[READ_BATCH_MAX];
+    sockaddr_storage names[READ_BATCH_MAX];
+    ControlBuffer    controls[READ_BATCH_MAX];
+
+    unsigned int total = 0;
+
+    double wait_start = getWaitStart(class_blocking, class_ts_bt);
+
+    // The first call waits for at least one datagram (if the socket blocks);
+    // later calls only pick up whatever else is already queued
+    int flags = class_blocking ? MSG_WAITFORONE : MSG_DONTWAIT;
+
+    // MSG_TRUNC has the kernel report each datagram's full length, even
+    // when only part of it fits in the buffer
+    int trunc_flag = wire_sizes ? MSG_TRUNC : 0;
+
+    while (total < count)
+    {
+        unsigned int chunk = count - total;
+        if (chunk > READ_BATCH_MAX)
+        {
+            chunk = READ_BATCH_MAX;
+        }
+
+        for (unsigned int i = 0; i < chunk; ++i)
+        {
+            iovs[i].iov_base = buffers[total + i];
+            iovs[i].iov_len  = sizes[total + i];
+
+            msgs[i].msg_hdr.msg_name       = class_rfa ? &names[i] : 0;
+            msgs[i].msg_hdr.msg_namelen    = class_rfa ? class_rfa_size : 0;
+            msgs[i].msg_hdr.msg_iov        = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen     = 1;
+            msgs[i].msg_hdr.msg_control    = controls[i].buf;
+            msgs[i].msg_hdr.msg_controllen = sizeof(controls[i].buf);
+            msgs[i].msg_hdr.msg_flags      = 0;
+            msgs[i].msg_len                = 0;
+        }
+
+        int ret = recvmmsg(socket_fd, msgs, chunk, flags | trunc_flag, 0);
+        class_stats.recordSyscalls();
+
+        if (ret == -1)
+        {
+            // Running out of data after the first chunk isn't an error
+            if (total > 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+
+            if (checkTimeout(ret, class_blocking, class_ts_bt, class_stats))
+            {
+                return 0;
+            }
+
+            class_stats.recordRead(ret);
 
 #if defined DEBUG
-    if (ret == -1)
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                perror("PosixSocketCommon::readBatch");
+            }
+#endif
+            return total > 0 ? static_cast<int>(total) : -1;
+        }
+
+        for (int i = 0; i < ret; ++i)
+        {
+            unsigned int length = msgs[i].msg_len;
+            if (length > iovs[i].iov_len)
+            {
+                length = iovs[i].iov_len;
+            }
+
+            sizes[total + i] = length;
+            class_stats.recordRead(length);
+
+            if (segment_sizes)
+            {
+                segment_sizes[total + i] = length;
+            }
+
+            if (wire_sizes)
+            {
+                wire_sizes[total + i] = msgs[i].msg_len;
+            }
+
+            readControlMessages(msgs[i].msg_hdr,
+                                class_stats,
+                                timestamps ? &timestamps[total + i] : 0,
+                                segment_sizes ? &segment_sizes[total + i] : 0);
+        }
+
+        // Only the source of the last datagram is kept
+        if (class_rfa && ret > 0)
+        {
+            socklen_t written = msgs[ret - 1].msg_hdr.msg_namelen;
+            if (written > class_rfa_size)
+            {
+                written = class_rfa_size;
+            }
+
+            memcpy(class_rfa, &names[ret - 1], written);
+            clearAddressTail(class_rfa, class_rfa_size, written);
+        }
+
+        if (total == 0 && wait_start > 0.0)
+        {
+            class_stats.recordPollLatency(getMonotonicSeconds() - wait_start);
+        }
+
+        total += ret;
+
+        // A short chunk means the queue is empty
+        if (static_cast<unsigned int>(ret) < chunk)
+        {
+            break;
+        }
+
+        flags = MSG_DONTWAIT;
+    }
+
+    return total;
+#else
+    // No recvmmsg here; read one at a time, only waiting for the first
+    int ret = read(socket_fd,
+                   buffers[0],
+                   sizes[0],
+                   class_blocking,
+                   class_ts_bt,
+                   class_rfa,
+                   class_rfa_size,
+                   class_stats,
+                   timestamps,
+                   segment_sizes);
+
+    if (ret <= 0)
+    {
+        return ret;
+    }
+
+    sizes[0] = ret;
+
+    unsigned int total = 1;
+    for (; total < count; ++total)
+    {
+        ret = read(socket_fd,
+                   buffers[total],
+                   sizes[total],
+                   false,
+                   0.0,
+                   class_rfa,
+                   class_rfa_size,
+                   class_stats,
+                   timestamps ? &timestamps[total] : 0,
+                   segment_sizes ? &segment_sizes[total] : 0);
+
+        if (ret <= 0)
+        {
+            break;
+        }
+
+        sizes[total] = ret;
+    }
+
+    // The full lengths aren't known here, so report what was read
+    if (wire_sizes)
     {
-        perror("PosixSocketCommon::read");
+        for (unsigned int i = 0; i < total; ++i)
+        {
+            wire_sizes[i] = sizes[i];
+        }
     }
+
+    return total;
 #endif
+}
+
+//==============================================================================
+// Reads without blocking until data arrives or the spin runs out, then blocks
+//==============================================================================
+int PosixSocketCommon::spinRead(int               socket_fd,
+                                unsigned char*    buffer,
+                                unsigned int      size,
+                                bool              class_blocking,
+                                double            class_ts_bt,
+                                double            spin_time,
+                                sockaddr*         class_rfa,
+                                socklen_t         class_rfa_size,
+                                SocketStatistics& class_stats,
+                                PosixTimespec*    class_rxts,
+                                unsigned int*     class_rxss)
+{
+    if (!class_blocking || spin_time <= 0.0)
+    {
+        return read(socket_fd,
+                    buffer,
+                    size,
+                    class_blocking,
+                    class_ts_bt,
+                    class_rfa,
+                    class_rfa_size,
+                    class_stats,
+                    class_rxts,
+                    class_rxss);
+    }
+
+    PosixTimespec rxts;
+
+    bool found = spinForData(socket_fd,
+                             getMonotonicSeconds() + spin_time,
+                             class_stats);
+
+    // Something else may have taken the data since, in which case block as
+    // if the spin had found nothing
+    int ret = -1;
+    if (found)
+    {
+        ret = read(socket_fd,
+                   buffer,
+                   size,
+                   false,
+                   0.0,
+                   class_rfa,
+                   class_rfa_size,
+                   class_stats,
+                   &rxts,
+                   class_rxss);
+    }
+
+    if (!found || isWouldBlock(ret))
+    {
+        class_stats.recordSpin(false);
+
+        ret = read(socket_fd,
+                   buffer,
+                   size,
+                   true,
+                   class_ts_bt,
+                   class_rfa,
+                   class_rfa_size,
+                   class_stats,
+                   &rxts,
+                   class_rxss);
+    }
+    else if (ret != -1)
+    {
+        class_stats.recordSpin(true);
+    }
+
+    if (isTimestamped(rxts))
+    {
+        recordDeliveryLatency(&rxts, 1, class_stats);
+
+        if (class_rxts)
+        {
+            *class_rxts = rxts;
+        }
+    }
+
+    return ret;
+}
+
+//==============================================================================
+// Spins for the first datagram as spinRead does, then reads the rest of the
+// batch without waiting
+//==============================================================================
+int PosixSocketCommon::spinReadBatch(int               socket_fd,
+                                     unsigned char**   buffers,
+                                     unsigned int*     sizes,
+                                     unsigned int      count,
+                                     bool              class_blocking,
+                                     double            class_ts_bt,
+                                     double            spin_time,
+                                     sockaddr*         class_rfa,
+                                     socklen_t         class_rfa_size,
+                                     SocketStatistics& class_stats,
+                                     PosixTimespec*    timestamps,
+                                     unsigned int*     segment_sizes,
+                                     unsigned int*     wire_sizes)
+{
+    if (!class_blocking || spin_time <= 0.0 || count == 0)
+    {
+        return readBatch(socket_fd,
+                         buffers,
+                         sizes,
+                         count,
+                         class_blocking,
+                         class_ts_bt,
+                         class_rfa,
+                         class_rfa_size,
+                         class_stats,
+                         timestamps,
+                         segment_sizes,
+                         wire_sizes);
+    }
+
+    // So datagrams the kernel didn't timestamp can be told apart
+    if (timestamps)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            timestamps[i] = PosixTimespec();
+        }
+    }
+
+    bool found = spinForData(socket_fd,
+                             getMonotonicSeconds() + spin_time,
+                             class_stats);
+
+    int ret = -1;
+    if (found)
+    {
+        ret = readBatch(socket_fd,
+                        buffers,
+                        sizes,
+                        count,
+                        false,
+                        0.0,
+                        class_rfa,
+                        class_rfa_size,
+                        class_stats,
+                        timestamps,
+                        segment_sizes,
+                        wire_sizes);
+    }
+
+    if (!found || isWouldBlock(ret))
+    {
+        class_stats.recordSpin(false);
+
+        ret = readBatch(socket_fd,
+                        buffers,
+                        sizes,
+                        count,
+                        true,
+                        class_ts_bt,
+                        class_rfa,
+                        class_rfa_size,
+                        class_stats,
+                        timestamps,
+                        segment_sizes,
+                        wire_sizes);
+    }
+    else if (ret != -1)
+    {
+        class_stats.recordSpin(true);
+    }
+
+    if (ret > 0 && timestamps)
+    {
+        recordDeliveryLatency(timestamps, ret, class_stats);
+    }
 
     return ret;
 }
@@ -168,23 +856,39 @@ int PosixSocketCommon::read(int            socket_fd,
 int PosixSocketCommon::write(int                  socket_fd,
                              const unsigned char* buffer,
                              unsigned int         size,
+                             bool                 class_blocking,
                              double               class_ts_bt,
                              sockaddr*            class_sta,
-                             socklen_t            class_sta_size)
+                             socklen_t            class_sta_size,
+                             SocketStatistics&    class_stats,
+                             int                  flags)
 {
-    // Is a valid timeout set?
-    if (isBlockingEnabled(socket_fd) && class_ts_bt > 0.0)
+    if (!class_blocking)
     {
-        // Perform the blocking timeout and check if the POLLOUT event occurred
-        if (doBlockingTimeout(socket_fd, POLLOUT, class_ts_bt) == 0)
-        {
-            // No data is ready to read, just return
-            return 0;
-        }
+        flags |= MSG_DONTWAIT;
+    }
+
+    // Write data.  Any blocking timeout is handled by the kernel.
+    int ret =
+        sendto(socket_fd, buffer, size, flags, class_sta, class_sta_size);
+    class_stats.recordSyscalls();
+
+    if (checkTimeout(ret, class_blocking, class_ts_bt, class_stats))
+    {
+        // No room to write, just return
+        return 0;
+    }
+
+#if defined MSG_ZEROCOPY
+    // The caller copies instead when the kernel can't pin any more pages
+    if (ret == -1 && errno == ENOBUFS && (flags & MSG_ZEROCOPY))
+    {
+        class_stats.recordZeroCopyFallback();
+        return ret;
     }
+#endif
 
-    // Write data
-    int ret = sendto(socket_fd, buffer, size, 0, class_sta, class_sta_size);
+    class_stats.recordWrite(ret);
 
 #if defined DEBUG
     if (ret == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
@@ -197,42 +901,1028 @@ int PosixSocketCommon::write(int                  socket_fd,
 }
 
 //==============================================================================
-// Clears all data out of a socket's receive buffer
+// Writes several datagrams with as few system calls as possible
 //==============================================================================
-void PosixSocketCommon::clearBuffer(int       socket_fd,
-                                    sockaddr* class_rfa,
-                                    socklen_t class_rfa_size)
+int PosixSocketCommon::writeBatch(int                         socket_fd,
+                                  const unsigned char* const* buffers,
+                                  const unsigned int*         sizes,
+                                  unsigned int                count,
+                                  bool                        class_blocking,
+                                  double                      class_ts_bt,
+                                  sockaddr*                   class_sta,
+                                  socklen_t                   class_sta_size,
+                                  SocketStatistics&           class_stats,
+                                  const std::uint64_t*        txtimes)
 {
-    // Interested if data is available
-    pollfd polldata;
-    polldata.fd = socket_fd;
-    polldata.events = POLLIN;
+    if (count == 0)
+    {
+        return 0;
+    }
 
-    unsigned char buf;
+#if defined LINUX
+    mmsghdr msgs[WRITE_BATCH_MAX];
+    iovec   iovs[WRITE_BATCH_MAX];
 
-    while(true)
+#if defined SCM_TXTIME
+    union
     {
-        // Poll the socket and see if there is data
-        if (poll(&polldata, 1, 0) == -1)
-        {
+        char    buf[CMSG_SPACE(sizeof(std::uint64_t))];
+        cmsghdr align;
+    } controls[WRITE_BATCH_MAX];
+#endif
+
+    unsigned int total = 0;
+
+    while (total < count)
+    {
+        unsigned int chunk = count - total;
+        if (chunk > WRITE_BATCH_MAX)
+        {
+            chunk = WRITE_BATCH_MAX;
+        }
+
+        for (unsigned int i = 0; i < chunk; ++i)
+        {
+            // sendmmsg() doesn't write through iov_base but it isn't const
+            iovs[i].iov_base = const_cast<unsigned char*>(buffers[total + i]);
+            iovs[i].iov_len  = sizes[total + i];
+
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_name    = class_sta;
+            msgs[i].msg_hdr.msg_namelen = class_sta_size;
+            msgs[i].msg_hdr.msg_iov     = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen  = 1;
+
+#if defined SCM_TXTIME
+            if (txtimes)
+            {
+                msgs[i].msg_hdr.msg_control    = controls[i].buf;
+                msgs[i].msg_hdr.msg_controllen = sizeof(controls[i].buf);
+
+                cmsghdr* cmsg    = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type  = SCM_TXTIME;
+                cmsg->cmsg_len   = CMSG_LEN(sizeof(std::uint64_t));
+                memcpy(CMSG_DATA(cmsg),
+                       &txtimes[total + i],
+                       sizeof(std::uint64_t));
+            }
+#endif
+        }
+
+        int ret = sendmmsg(
+            socket_fd, msgs, chunk, class_blocking ? 0 : MSG_DONTWAIT);
+        class_stats.recordSyscalls();
+
+        if (ret == -1)
+        {
+            // Whatever made this chunk fail gets reported by the next call
+            if (total > 0)
+            {
+                break;
+            }
+
+            if (checkTimeout(ret, class_blocking, class_ts_bt, class_stats))
+            {
+                return 0;
+            }
+
+            class_stats.recordWrite(ret);
+
 #if defined DEBUG
-            perror("PosixSocketCommon::clearBuffer");
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                perror("PosixSocketCommon::writeBatch");
+            }
 #endif
-            return;
+            return -1;
+        }
+
+        for (int i = 0; i < ret; ++i)
+        {
+            class_stats.recordWrite(msgs[i].msg_len);
+        }
+
+        total += ret;
+
+        // A short chunk means the socket is full or something went wrong
+        if (static_cast<unsigned int>(ret) < chunk)
+        {
+            break;
         }
+    }
+
+    return total;
+#else
+    // No sendmmsg here; write one at a time
+    unsigned int total = 0;
+    for (; total < count; ++total)
+    {
+        int ret = write(socket_fd,
+                        buffers[total],
+                        sizes[total],
+                        class_blocking,
+                        class_ts_bt,
+                        class_sta,
+                        class_sta_size,
+                        class_stats,
+                        0);
+
+        if (ret <= 0)
+        {
+            return total > 0 ? static_cast<int>(total) : ret;
+        }
+    }
+
+    return total;
+#endif
+}
+
+//==============================================================================
+// Writes data along with file descriptors for the peer
+//==============================================================================
+int PosixSocketCommon::writeDescriptors(int                  socket_fd,
+                                        const unsigned char* buffer,
+                                        unsigned int         size,
+                                        const int*           fds,
+                                        unsigned int         fd_count,
+                                        bool                 class_blocking,
+                                        double               class_ts_bt,
+                                        SocketStatistics&    class_stats)
+{
+    // The kernel quietly drops descriptors sent with no data on stream
+    // sockets, so don't let that happen
+    if (size == 0 || fd_count > DESCRIPTORS_MAX)
+    {
+        errno = EINVAL;
+#if defined DEBUG
+        perror("PosixSocketCommon::writeDescriptors");
+#endif
+        return -1;
+    }
+
+    union
+    {
+        char    buf[CMSG_SPACE(sizeof(int) * DESCRIPTORS_MAX)];
+        cmsghdr align;
+    } control;
+
+    iovec iov;
+    iov.iov_base = const_cast<unsigned char*>(buffer);
+    iov.iov_len  = size;
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov    = &iov;
+    msg.msg_iovlen = 1;
+
+    if (fd_count > 0)
+    {
+        msg.msg_control    = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type  = SCM_RIGHTS;
+        cmsg->cmsg_len   = CMSG_LEN(sizeof(int) * fd_count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+    }
+
+    int ret = sendmsg(socket_fd, &msg, class_blocking ? 0 : MSG_DONTWAIT);
+    class_stats.recordSyscalls();
+
+    if (checkTimeout(ret, class_blocking, class_ts_bt, class_stats))
+    {
+        // No room to write, just return
+        return 0;
+    }
+
+    class_stats.recordWrite(ret);
+
+#if defined DEBUG
+    if (ret == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        perror("PosixSocketCommon::writeDescriptors");
+    }
+#endif
+
+    return ret;
+}
+
+//==============================================================================
+// Reads data along with any file descriptors sent with it
+//==============================================================================
+int PosixSocketCommon::readDescriptors(int               socket_fd,
+                                       unsigned char*    buffer,
+                                       unsigned int      size,
+                                       int*              fds,
+                                       unsigned int&     fd_count,
+                                       bool              class_blocking,
+                                       double            class_ts_bt,
+                                       SocketStatistics& class_stats)
+{
+    unsigned int room = fd_count;
+    fd_count = 0;
+
+    // Always make room for as many as the peer could have sent, so extras can
+    // be closed here rather than landing somewhere unexpected
+    union
+    {
+        char    buf[CMSG_SPACE(sizeof(int) * DESCRIPTORS_MAX)];
+        cmsghdr align;
+    } control;
+
+    iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len  = size;
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    int flags = class_blocking ? 0 : MSG_DONTWAIT;
+#if defined MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+    double wait_start = getWaitStart(class_blocking, class_ts_bt);
+
+    int ret = recvmsg(socket_fd, &msg, flags);
+    class_stats.recordSyscalls();
+
+    if (checkTimeout(ret, class_blocking, class_ts_bt, class_stats))
+    {
+        // No data is ready to read
+        return 0;
+    }
+
+    class_stats.recordRead(ret);
+
+    if (ret == -1)
+    {
+#if defined DEBUG
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            perror("PosixSocketCommon::readDescriptors");
+        }
+#endif
+        return ret;
+    }
+
+    if (wait_start > 0.0)
+    {
+        class_stats.recordPollLatency(getMonotonicSeconds() - wait_start);
+    }
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+         cmsg != 0;
+         cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            fd_count += takeDescriptors(cmsg, fds + fd_count, room - fd_count);
+        }
+    }
+
+    return ret;
+}
+
+//==============================================================================
+// Writes several buffers into socket with one system call
+//==============================================================================
+int PosixSocketCommon::writeGather(int                         socket_fd,
+                                   const unsigned char* const* buffers,
+                                   const unsigned int*         sizes,
+                                   unsigned int                count,
+                                   bool                        class_blocking,
+                                   double                      class_ts_bt,
+                                   SocketStatistics&           class_stats)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    if (count > WRITE_GATHER_MAX)
+    {
+        count = WRITE_GATHER_MAX;
+    }
+
+    iovec iovs[WRITE_GATHER_MAX];
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        // sendmsg() doesn't write through iov_base but it isn't const anyway
+        iovs[i].iov_base = const_cast<unsigned char*>(buffers[i]);
+        iovs[i].iov_len  = sizes[i];
+    }
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov    = iovs;
+    msg.msg_iovlen = count;
+
+    // sendmsg() rather than writev() so non-blocking can be asked for per call
+    int ret = sendmsg(socket_fd, &msg, class_blocking ? 0 : MSG_DONTWAIT);
+    class_stats.recordSyscalls();
+
+    if (checkTimeout(ret, class_blocking, class_ts_bt, class_stats))
+    {
+        // No room to write, just return
+        return 0;
+    }
 
-        // If no data available, leave
-        if (polldata.revents == 0)
+    class_stats.recordWrite(ret);
+
+#if defined DEBUG
+    if (ret == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        perror("PosixSocketCommon::writeGather");
+    }
+#endif
+
+    return ret;
+}
+
+//==============================================================================
+// Clears all data out of a socket's receive buffer
+//==============================================================================
+void PosixSocketCommon::clearBuffer(int               socket_fd,
+                                    SocketStatistics& class_stats)
+{
+    // Everything read here is thrown away, so it can all land in one place
+    unsigned char discard[CLEAR_BUFFER_SIZE];
+
+#if defined LINUX
+    // Datagram sockets give up one datagram per receive no matter how big the
+    // buffer is, so take lots of receives per system call.  Stream sockets
+    // just fill the buffer over and over.
+    iovec   iov;
+    mmsghdr msgs[READ_BATCH_MAX];
+
+    iov.iov_base = discard;
+    iov.iov_len  = sizeof(discard);
+
+    memset(msgs, 0, sizeof(msgs));
+    for (unsigned int i = 0; i < READ_BATCH_MAX; ++i)
+    {
+        msgs[i].msg_hdr.msg_iov    = &iov;
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (true)
+    {
+        int ret = recvmmsg(socket_fd, msgs, READ_BATCH_MAX, MSG_DONTWAIT, 0);
+        class_stats.recordSyscalls();
+
+        // Either the queue ran dry or an orderly shutdown was read from a
+        // stream socket, which would otherwise read as empty forever
+        if (ret < static_cast<int>(READ_BATCH_MAX) ||
+            msgs[READ_BATCH_MAX - 1].msg_len == 0)
         {
+#if defined DEBUG
+            if (ret == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                perror("PosixSocketCommon::clearBuffer");
+            }
+#endif
             return;
         }
+    }
+#else
+    while (true)
+    {
+        int ret = recv(socket_fd, discard, sizeof(discard), MSG_DONTWAIT);
+        class_stats.recordSyscalls();
 
-        // Read a byte, leave if error
-        if (read(socket_fd, &buf, 1, 0, class_rfa, class_rfa_size) < 1)
+        if (ret <= 0)
         {
+#if defined DEBUG
+            if (ret == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                perror("PosixSocketCommon::clearBuffer");
+            }
+#endif
             return;
         }
     }
+#endif
+}
+
+//==============================================================================
+// Sets timeouts on blocking reads and writes
+//==============================================================================
+bool PosixSocketCommon::setBlockingTimeout(int socket_fd, double class_ts_bt)
+{
+    // All zeroes means never time out
+    timeval timeout;
+    timeout.tv_sec  = 0;
+    timeout.tv_usec = 0;
+
+    if (class_ts_bt > 0.0)
+    {
+        timeout.tv_sec  = static_cast<time_t>(class_ts_bt);
+        timeout.tv_usec = static_cast<suseconds_t>(
+            (class_ts_bt - timeout.tv_sec) * 1.0e6);
+
+        // Don't let a tiny timeout round down to no timeout at all
+        if (timeout.tv_sec == 0 && timeout.tv_usec == 0)
+        {
+            timeout.tv_usec = 1;
+        }
+    }
+
+    if (setsockopt(socket_fd,
+                   SOL_SOCKET,
+                   SO_RCVTIMEO,
+                   &timeout,
+                   sizeof(timeout)) == -1 ||
+        setsockopt(socket_fd,
+                   SOL_SOCKET,
+                   SO_SNDTIMEO,
+                   &timeout,
+                   sizeof(timeout)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::setBlockingTimeout");
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Has the kernel report drop counts alongside received datagrams
+//==============================================================================
+bool PosixSocketCommon::enableDropReporting(int socket_fd)
+{
+#if defined SO_RXQ_OVFL
+    int enable = 1;
+    if (setsockopt(
+            socket_fd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::enableDropReporting");
+#endif
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Has the kernel timestamp received datagrams
+//==============================================================================
+bool PosixSocketCommon::enableTimestamps(int socket_fd)
+{
+#if defined SO_TIMESTAMPNS
+    int enable = 1;
+    if (setsockopt(socket_fd,
+                   SOL_SOCKET,
+                   SO_TIMESTAMPNS,
+                   &enable,
+                   sizeof(enable)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::enableTimestamps");
+#endif
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Lets the socket send with MSG_ZEROCOPY
+//==============================================================================
+bool PosixSocketCommon::enableZeroCopy(int socket_fd)
+{
+#if defined SO_ZEROCOPY
+    int enable = 1;
+    if (setsockopt(
+            socket_fd, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::enableZeroCopy");
+#endif
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Sets the socket's busy poll time, and asks for busy polling to be preferred
+//==============================================================================
+bool PosixSocketCommon::enableBusyPoll(int socket_fd, double busy_poll_time)
+{
+#if defined SO_BUSY_POLL
+    // The kernel takes microseconds
+    int microseconds = static_cast<int>(busy_poll_time * 1.0e6);
+    if (setsockopt(socket_fd,
+                   SOL_SOCKET,
+                   SO_BUSY_POLL,
+                   &microseconds,
+                   sizeof(microseconds)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::enableBusyPoll");
+#endif
+        return false;
+    }
+
+#if defined SO_PREFER_BUSY_POLL
+    // Older kernels don't have this, and busy polling still works without it
+    int prefer = 1;
+    if (setsockopt(socket_fd,
+                   SOL_SOCKET,
+                   SO_PREFER_BUSY_POLL,
+                   &prefer,
+                   sizeof(prefer)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::enableBusyPoll");
+#endif
+    }
+#endif
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Sets the socket's busy poll time back to zero
+//==============================================================================
+bool PosixSocketCommon::disableBusyPoll(int socket_fd)
+{
+#if defined SO_BUSY_POLL
+#if defined SO_PREFER_BUSY_POLL
+    int prefer = 0;
+    setsockopt(
+        socket_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer));
+#endif
+
+    int microseconds = 0;
+    if (setsockopt(socket_fd,
+                   SOL_SOCKET,
+                   SO_BUSY_POLL,
+                   &microseconds,
+                   sizeof(microseconds)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::disableBusyPoll");
+#endif
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Restricts the calling thread to one core
+//==============================================================================
+bool PosixSocketCommon::pinThread(int core)
+{
+#if defined LINUX
+    if (core < 0 || core >= CPU_SETSIZE)
+    {
+        return false;
+    }
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+
+    if (ret != 0)
+    {
+#if defined DEBUG
+        fprintf(stderr, "PosixSocketCommon::pinThread: %s\n", strerror(ret));
+#endif
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Opens an eventfd for stopping threads with
+//==============================================================================
+int PosixSocketCommon::openStopEvent()
+{
+#if defined LINUX
+    int event_fd = eventfd(0, EFD_CLOEXEC);
+
+    if (event_fd == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::openStopEvent");
+#endif
+    }
+
+    return event_fd;
+#else
+    return -1;
+#endif
+}
+
+//==============================================================================
+// Makes a stop event readable
+//==============================================================================
+bool PosixSocketCommon::signalStopEvent(int event_fd)
+{
+    // Any non-zero value makes the eventfd readable
+    std::uint64_t wake = 1;
+    if (::write(event_fd, &wake, sizeof(wake)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::signalStopEvent");
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Attaches transmit times to datagrams, with drops reported
+//==============================================================================
+bool PosixSocketCommon::enableTransmitTime(int socket_fd, clockid_t clock)
+{
+#if defined LINUX && defined SO_TXTIME
+    sock_txtime txtime;
+    memset(&txtime, 0, sizeof(txtime));
+    txtime.clockid = clock;
+    txtime.flags   = SOF_TXTIME_REPORT_ERRORS;
+
+    if (setsockopt(
+            socket_fd, SOL_SOCKET, SO_TXTIME, &txtime, sizeof(txtime)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::enableTransmitTime");
+#endif
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Asks for numbered software transmit timestamps on the error queue
+//==============================================================================
+bool PosixSocketCommon::enableTransmitTimestamps(int socket_fd)
+{
+#if defined LINUX && defined SO_TIMESTAMPING
+    // Only the timestamp is wanted back, not a copy of the datagram
+    int flags = SOF_TIMESTAMPING_TX_SOFTWARE |
+                SOF_TIMESTAMPING_SOFTWARE |
+                SOF_TIMESTAMPING_OPT_ID |
+                SOF_TIMESTAMPING_OPT_TSONLY;
+
+    // The numbering only starts over when OPT_ID is newly turned on
+    disableTransmitTimestamps(socket_fd);
+
+    if (setsockopt(
+            socket_fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) ==
+        -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::enableTransmitTimestamps");
+#endif
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Stops transmit timestamps
+//==============================================================================
+bool PosixSocketCommon::disableTransmitTimestamps(int socket_fd)
+{
+#if defined LINUX && defined SO_TIMESTAMPING
+    int flags = 0;
+    if (setsockopt(
+            socket_fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) ==
+        -1)
+    {
+#if defined DEBUG
+        perror("PosixSocketCommon::disableTransmitTimestamps");
+#endif
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Reads transmit timestamps and transmit time drops off the error queue
+//==============================================================================
+int PosixSocketCommon::readTransmitReports(int               socket_fd,
+                                           std::uint32_t*    ids,
+                                           PosixTimespec*    times,
+                                           unsigned int      room,
+                                           SocketStatistics& class_stats)
+{
+#if defined LINUX && defined SO_TIMESTAMPING && defined SO_EE_ORIGIN_TXTIME
+    // A timestamp report carries the timestamps and the datagram's number
+    union Control
+    {
+        char    buf[CMSG_SPACE(sizeof(scm_timestamping)) +
+                    CMSG_SPACE(sizeof(sock_extended_err) +
+                               sizeof(sockaddr_in))];
+        cmsghdr align;
+    };
+
+    Control controls[READ_BATCH_MAX];
+    mmsghdr msgs[READ_BATCH_MAX];
+
+    unsigned int stored = 0;
+
+    while (stored < room)
+    {
+        // Every report might be a timestamp, so don't take more than there's
+        // room for
+        unsigned int chunk = room - stored;
+        if (chunk > READ_BATCH_MAX)
+        {
+            chunk = READ_BATCH_MAX;
+        }
+
+        memset(msgs, 0, sizeof(msgs[0]) * chunk);
+        for (unsigned int i = 0; i < chunk; ++i)
+        {
+            msgs[i].msg_hdr.msg_control    = controls[i].buf;
+            msgs[i].msg_hdr.msg_controllen = sizeof(controls[i].buf);
+        }
+
+        // The error queue never blocks; it's either got something or EAGAIN
+        int ret =
+            recvmmsg(socket_fd, msgs, chunk, MSG_ERRQUEUE | MSG_DONTWAIT, 0);
+        class_stats.recordSyscalls();
+
+        if (ret == -1)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return stored;
+            }
+
+#if defined DEBUG
+            perror("PosixSocketCommon::readTransmitReports");
+#endif
+            return -1;
+        }
+
+        for (int i = 0; i < ret; ++i)
+        {
+            bool          have_time = false;
+            bool          have_id   = false;
+            timespec      time;
+            std::uint32_t id = 0;
+
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+                 cmsg != 0;
+                 cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+            {
+                if (cmsg->cmsg_level == SOL_SOCKET &&
+                    cmsg->cmsg_type  == SCM_TIMESTAMPING)
+                {
+                    // Software timestamps come first
+                    scm_timestamping stamps;
+                    memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+                    time      = stamps.ts[0];
+                    have_time = true;
+                }
+                else if (cmsg->cmsg_level == SOL_IP &&
+                         cmsg->cmsg_type  == IP_RECVERR)
+                {
+                    sock_extended_err err;
+                    memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+
+                    if (err.ee_origin == SO_EE_ORIGIN_TXTIME)
+                    {
+                        class_stats.recordPacingDrop();
+                    }
+                    else if (err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING &&
+                             err.ee_info   == SCM_TSTAMP_SND)
+                    {
+                        id      = err.ee_data;
+                        have_id = true;
+                    }
+                }
+            }
+
+            if (have_time && have_id)
+            {
+                ids[stored] = id;
+                times[stored].setTimespec(time);
+                ++stored;
+            }
+        }
+
+        if (static_cast<unsigned int>(ret) < chunk)
+        {
+            break;
+        }
+    }
+
+    return stored;
+#else
+    return 0;
+#endif
+}
+
+//==============================================================================
+// Reads the monotonic clock
+//==============================================================================
+double PosixSocketCommon::getMonotonicSeconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1.0e9;
+}
+
+//==============================================================================
+// Sleeps most of the way to the deadline and spins the rest
+//==============================================================================
+void PosixSocketCommon::sleepUntil(double deadline)
+{
+    double sleep_until = deadline - SLEEP_SPIN_TIME;
+    double now         = getMonotonicSeconds();
+
+    if (now < sleep_until)
+    {
+#if defined LINUX
+        timespec wake;
+        wake.tv_sec  = static_cast<time_t>(sleep_until);
+        wake.tv_nsec = static_cast<long>((sleep_until - wake.tv_sec) * 1.0e9);
+
+        // Restarts after signals with the same absolute deadline
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, 0) ==
+               EINTR)
+        {
+        }
+#else
+        double   wait = sleep_until - now;
+        timespec duration;
+        duration.tv_sec  = static_cast<time_t>(wait);
+        duration.tv_nsec = static_cast<long>((wait - duration.tv_sec) * 1.0e9);
+        nanosleep(&duration, 0);
+#endif
+    }
+
+    while (getMonotonicSeconds() < deadline)
+    {
+    }
+}
+
+//==============================================================================
+// Reads every zero-copy completion notification currently queued
+//==============================================================================
+int PosixSocketCommon::readZeroCopyCompletions(
+    int               socket_fd,
+    std::uint32_t&    completed_through,
+    unsigned long&    copied,
+    SocketStatistics& class_stats)
+{
+#if defined LINUX && defined SO_EE_ORIGIN_ZEROCOPY
+    int completed = 0;
+
+    while (true)
+    {
+        union
+        {
+            char    buf[CMSG_SPACE(sizeof(sock_extended_err) +
+                                   sizeof(sockaddr_in))];
+            cmsghdr align;
+        } control;
+
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control    = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        // The error queue never blocks; it's either got something or EAGAIN
+        class_stats.recordSyscalls();
+        if (recvmsg(socket_fd, &msg, MSG_ERRQUEUE) == -1)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return completed;
+            }
+
+#if defined DEBUG
+            perror("PosixSocketCommon::readZeroCopyCompletions");
+#endif
+            return -1;
+        }
+
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+             cmsg != 0;
+             cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (!((cmsg->cmsg_level == SOL_IP &&
+                   cmsg->cmsg_type  == IP_RECVERR) ||
+                  (cmsg->cmsg_level == SOL_IPV6 &&
+                   cmsg->cmsg_type  == IPV6_RECVERR)))
+            {
+                continue;
+            }
+
+            sock_extended_err err;
+            memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+
+            if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            {
+                continue;
+            }
+
+            // Notifications cover the inclusive range [ee_info, ee_data].
+            // Differences are taken so this all keeps working when the
+            // kernel's 32-bit counter wraps.
+            std::uint32_t next = err.ee_data + 1;
+            std::int32_t  newly =
+                static_cast<std::int32_t>(next - completed_through);
+            if (newly > 0)
+            {
+                completed += newly;
+                completed_through = next;
+            }
+
+            if (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            {
+                copied++;
+            }
+        }
+    }
+#else
+    return 0;
+#endif
+}
+
+//==============================================================================
+// Retrieves queue depths and drop counts from the kernel
+//==============================================================================
+bool PosixSocketCommon::getKernelStatistics(
+    int                     socket_fd,
+    const SocketStatistics& class_stats,
+    SocketKernelStatistics& kernel_stats)
+{
+    kernel_stats.setReceiveDrops(class_stats.getReceiveDrops());
+
+    int receive_queue_bytes = 0;
+    int send_queue_bytes    = 0;
+
+#if defined LINUX
+    // Both of these fail on listening sockets, which have no queues to speak
+    // of anyway
+    if (ioctl(socket_fd, SIOCINQ,  &receive_queue_bytes) == -1 ||
+        ioctl(socket_fd, SIOCOUTQ, &send_queue_bytes)    == -1)
+    {
+        return false;
+    }
+#else
+    if (ioctl(socket_fd, FIONREAD, &receive_queue_bytes) == -1)
+    {
+        return false;
+    }
+#endif
+
+    kernel_stats.setReceiveQueueBytes(receive_queue_bytes);
+    kernel_stats.setSendQueueBytes(send_queue_bytes);
+
+    return true;
 }
 
 //==============================================================================
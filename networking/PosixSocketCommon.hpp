@@ -1,7 +1,18 @@
 // Common POSIX socket operations live here
 
+#if !defined POSIX_SOCKET_COMMON_HPP
+#define POSIX_SOCKET_COMMON_HPP
+
+#include <cstdint>
+#include <netinet/in.h>
+#include <string>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
+
+class PosixTimespec;
+class SocketKernelStatistics;
+class SocketStatistics;
 
 namespace PosixSocketCommon
 {
@@ -16,6 +27,13 @@ namespace PosixSocketCommon
     // block, false otherwise.
     bool isBlockingEnabled(int socket_fd);
 
+    // Sets the timeout (seconds) the kernel applies to blocking reads and
+    // writes on the given file descriptor (SO_RCVTIMEO and SO_SNDTIMEO).  A
+    // non-positive 'class_ts_bt' means reads and writes never time out.
+    // Note that the kernel also applies these to blocking accept() and
+    // connect() calls.
+    bool setBlockingTimeout(int socket_fd, double class_ts_bt);
+
     // Performs a blocking timeout on the given file descriptor.  The block
     // lasts until the events described by 'events' occur, or when the duration
     // of time (seconds) represented by 'class_ts_bt' has passed.
@@ -24,47 +42,330 @@ namespace PosixSocketCommon
     // Associates a name and a port with a newly-created socket
     bool bind(int socket_fd, sockaddr_in& local_address, unsigned int& port);
 
-    // Reads from the given file descriptor, being careful to conduct a blocking
-    // timeout beforehand if instructed to.  A blocking timeout is performed if
-    // 'class_ts_bt' (seconds) represents a positive durations of time.
+    // Fills in 'address' for a Unix domain socket at the given path, and
+    // 'address_size' with the length to pass along with it.  On Linux a path
+    // starting with '@' names a socket in the abstract namespace rather than
+    // the filesystem.  Returns false if the path is too long.
+    bool setLocalAddress(const std::string& path,
+                         sockaddr_un&       address,
+                         socklen_t&         address_size);
+
+    // Returns the path in a Unix domain socket address, written the way
+    // setLocalAddress takes it, or an empty string if the address is unnamed
+    std::string getLocalPath(const sockaddr_un& address);
+
+    // Reads from the given file descriptor with a single system call.
+    // 'class_blocking' is the socket's blocking mode as cached by its owner;
+    // when false the read is made non-blocking with MSG_DONTWAIT.  If the
+    // socket blocks and 'class_ts_bt' (seconds) is positive, the owner is
+    // expected to have given the same timeout to setBlockingTimeout so the
+    // kernel can enforce it; a read that times out returns 0.
     // 'class_rfa' and 'class_rfa_size' vary in purpose depending on the type of
     // socket being dealt with.  When used with packet-based sockets,
     // 'class_rfa' is a buffer into which the address of the sender is written.
     // When used with raw sockets, 'class_rfa' is a buffer containing
     // information about the interface to read from.  In both cases,
-    // 'class_rfa_size' is the length of the 'class_rfa' buffer, in bytes.
-    int read(int            socket_fd,
-             unsigned char* buffer,
-             unsigned int   size,
-             double         class_ts_bt,
-             sockaddr*      class_rfa,
-             socklen_t      class_rfa_size);
-
-    // Writes to the given file descriptor, being careful to conduct a blocking
-    // timeout beforehand if instructed to.  A blocking timeout is performed if
-    // 'class_ts_bt' (seconds) represents a positive durations of time.
-    // 'class_sta' and 'class_sta_size' vary in purpose depending on the type of
-    // socket being dealt with.  When used with packet-based sockets,
-    // 'class_sta' is the address of the destination the data being written is
-    // to be sent to.  When use with raw sockets, 'class_sta' is the interface
-    // to output the data on.  In both cases, 'class_sta_size' represents the
-    // size of the 'class_rfa' buffer, in bytes.
+    // 'class_rfa_size' is the length of the 'class_rfa' buffer, in bytes.  Any
+    // part of 'class_rfa' past the end of the address the kernel wrote is
+    // zeroed, so variable-length addresses (Unix domain socket paths) read
+    // back cleanly.
+    // 'class_stats' is updated to account for the work done.  If the kernel
+    // attaches a drop count to the datagram (see enableDropReporting) it's
+    // stored in 'class_stats' as well.  If the kernel attaches a receive
+    // timestamp (see enableTimestamps) and 'class_rxts' is non-zero, the
+    // timestamp is written to 'class_rxts'.  If 'class_rxss' is non-zero it
+    // receives the size of the segments the data is made of: the segment size
+    // the kernel reports for a coalesced UDP GRO read, or else the length of
+    // the whole read.  Descriptors passed over a Unix domain socket are closed
+    // rather than leaked; use readDescriptors to receive them.
+    int read(int               socket_fd,
+             unsigned char*    buffer,
+             unsigned int      size,
+             bool              class_blocking,
+             double            class_ts_bt,
+             sockaddr*         class_rfa,
+             socklen_t         class_rfa_size,
+             SocketStatistics& class_stats,
+             PosixTimespec*    class_rxts,
+             unsigned int*     class_rxss);
+
+    // Reads up to 'count' datagrams from the given file descriptor, blocking
+    // (subject to the blocking mode and timeout, as with read) only until the
+    // first one arrives.  Datagram i is written to 'buffers[i]', which has room
+    // for 'sizes[i]' bytes; on return 'sizes[i]' holds the length of the
+    // datagram actually read.  If 'timestamps' is non-zero, 'timestamps[i]'
+    // receives the kernel receive timestamp of datagram i.  Likewise
+    // 'segment_sizes[i]', if given, receives its segment size as read would
+    // report it.  'class_rfa' receives the source of the last datagram read,
+    // zeroed past its end as with read.  If 'wire_sizes' is given,
+    // 'wire_sizes[i]' receives the full length of datagram i, which is more
+    // than 'sizes[i]' if it was cut short to fit its buffer.
+    // Returns the number of datagrams read, 0 if the blocking timeout expired,
+    // or -1 on error.  On Linux this costs one recvmmsg() call per
+    // READ_BATCH_MAX datagrams.
+    int readBatch(int               socket_fd,
+                  unsigned char**   buffers,
+                  unsigned int*     sizes,
+                  unsigned int      count,
+                  bool              class_blocking,
+                  double            class_ts_bt,
+                  sockaddr*         class_rfa,
+                  socklen_t         class_rfa_size,
+                  SocketStatistics& class_stats,
+                  PosixTimespec*    timestamps,
+                  unsigned int*     segment_sizes,
+                  unsigned int*     wire_sizes = 0);
+
+    // Largest number of datagrams read by a single system call in readBatch
+    const unsigned int READ_BATCH_MAX = 64;
+
+    // Same as read, except that a blocking socket first spins for up to
+    // 'spin_time' seconds peeking for data, and only blocks (as read would,
+    // timeout and all) if nothing arrives in that time.  Spinning trades a
+    // busy core for not waiting on the scheduler to wake the thread up when
+    // data arrives.  A non-blocking socket, or a 'spin_time' that isn't
+    // positive, reads exactly as read does.  'class_stats' counts the peeks
+    // as spin probes rather than syscalls, whether the spin found data, and
+    // if the kernel timestamped the datagram (see enableTimestamps) how long
+    // after arriving it was handed over.
+    int spinRead(int               socket_fd,
+                 unsigned char*    buffer,
+                 unsigned int      size,
+                 bool              class_blocking,
+                 double            class_ts_bt,
+                 double            spin_time,
+                 sockaddr*         class_rfa,
+                 socklen_t         class_rfa_size,
+                 SocketStatistics& class_stats,
+                 PosixTimespec*    class_rxts,
+                 unsigned int*     class_rxss);
+
+    // Same as readBatch, spinning for the first datagram as spinRead does.
+    // Delivery latency is only measured if 'timestamps' is given.
+    int spinReadBatch(int               socket_fd,
+                      unsigned char**   buffers,
+                      unsigned int*     sizes,
+                      unsigned int      count,
+                      bool              class_blocking,
+                      double            class_ts_bt,
+                      double            spin_time,
+                      sockaddr*         class_rfa,
+                      socklen_t         class_rfa_size,
+                      SocketStatistics& class_stats,
+                      PosixTimespec*    timestamps,
+                      unsigned int*     segment_sizes,
+                      unsigned int*     wire_sizes = 0);
+
+    // Writes to the given file descriptor with a single system call.  The
+    // blocking mode and timeout are handled as with read; a write that times
+    // out returns 0.  'class_sta' and 'class_sta_size' vary in purpose
+    // depending on the type of socket being dealt with.  When used with
+    // packet-based sockets, 'class_sta' is the address of the destination the
+    // data being written is to be sent to.  When use with raw sockets,
+    // 'class_sta' is the interface to output the data on.  In both cases,
+    // 'class_sta_size' represents the size of the 'class_rfa' buffer, in bytes.
+    // 'class_stats' is updated to account for the work done.  'flags' is passed
+    // through to sendto(), with MSG_DONTWAIT added if the socket doesn't block.
+    // A MSG_ZEROCOPY write turned down with ENOBUFS is counted as a zero-copy
+    // fallback rather than an error.
     int write(int                  socket_fd,
               const unsigned char* buffer,
               unsigned int         size,
+              bool                 class_blocking,
               double               class_ts_bt,
               sockaddr*            class_sta,
-              socklen_t            class_sta_size);
+              socklen_t            class_sta_size,
+              SocketStatistics&    class_stats,
+              int                  flags);
+
+    // Writes up to 'count' datagrams to the given file descriptor, datagram i
+    // being 'buffers[i]' and 'sizes[i]' bytes long, all to the destination in
+    // 'class_sta' (see write).  The blocking mode and timeout are handled as
+    // with write.  Returns the number of datagrams written, 0 if the blocking
+    // timeout expired before any were, or -1 on error.  On Linux this costs
+    // one sendmmsg() call per WRITE_BATCH_MAX datagrams.  If 'txtimes' is
+    // non-zero datagram i carries transmit time 'txtimes[i]' (nanoseconds; see
+    // enableTransmitTime).
+    int writeBatch(int                         socket_fd,
+                   const unsigned char* const* buffers,
+                   const unsigned int*         sizes,
+                   unsigned int                count,
+                   bool                        class_blocking,
+                   double                      class_ts_bt,
+                   sockaddr*                   class_sta,
+                   socklen_t                   class_sta_size,
+                   SocketStatistics&           class_stats,
+                   const std::uint64_t*        txtimes = 0);
+
+    // Largest number of datagrams written by a single system call in
+    // writeBatch
+    const unsigned int WRITE_BATCH_MAX = 64;
+
+    // Writes 'size' bytes from 'buffer' to the given connected Unix domain
+    // socket along with copies of the 'fd_count' file descriptors in 'fds'
+    // (SCM_RIGHTS).  At least one byte of data has to go with them.  The
+    // blocking mode and timeout are handled as with write.  Returns the number
+    // of bytes written, 0 if the blocking timeout expired, or -1 on error.
+    int writeDescriptors(int                  socket_fd,
+                         const unsigned char* buffer,
+                         unsigned int         size,
+                         const int*           fds,
+                         unsigned int         fd_count,
+                         bool                 class_blocking,
+                         double               class_ts_bt,
+                         SocketStatistics&    class_stats);
+
+    // Reads from the given Unix domain socket as read does, also receiving any
+    // file descriptors the peer passed along with the data.  'fds' has room
+    // for 'fd_count' descriptors; on return 'fd_count' holds the number
+    // actually received.  Descriptors that don't fit are closed.  Received
+    // descriptors are the caller's to close, and on Linux are close-on-exec.
+    int readDescriptors(int               socket_fd,
+                        unsigned char*    buffer,
+                        unsigned int      size,
+                        int*              fds,
+                        unsigned int&     fd_count,
+                        bool              class_blocking,
+                        double            class_ts_bt,
+                        SocketStatistics& class_stats);
+
+    // Most file descriptors one writeDescriptors or readDescriptors call
+    // handles
+    const unsigned int DESCRIPTORS_MAX = 64;
+
+    // Writes 'count' buffers to the given connected file descriptor with a
+    // single sendmsg() call, buffer i being 'buffers[i]' and 'sizes[i]' bytes
+    // long.  At most WRITE_GATHER_MAX buffers are written per call; any more
+    // are left for the caller to write next time.  The blocking mode and
+    // timeout are handled as with write.  Returns the number of bytes
+    // written, which may end part way through a buffer, 0 if the blocking
+    // timeout expired, or -1 on error.
+    int writeGather(int                         socket_fd,
+                    const unsigned char* const* buffers,
+                    const unsigned int*         sizes,
+                    unsigned int                count,
+                    bool                        class_blocking,
+                    double                      class_ts_bt,
+                    SocketStatistics&           class_stats);
+
+    // Largest number of buffers written by a single call to writeGather
+    const unsigned int WRITE_GATHER_MAX = 64;
+
+    // Clears the receive buffer of the specified socket by reading and
+    // discarding everything in it until it would block.  On Linux up to
+    // READ_BATCH_MAX datagrams (or CLEAR_BUFFER_SIZE bytes each, for stream
+    // sockets) are discarded per system call.  'class_stats' is updated to
+    // account for the system calls made; the discarded data isn't counted as
+    // received.
+    void clearBuffer(int socket_fd, SocketStatistics& class_stats);
 
-    // Clears the receive buffer of the specified socket.  It does this by
-    // iteratively reading single bytes of data from the socket until it would
-    // block.  See the above documentation of the 'read' function for
-    // explanations of the 'class_rfa' and 'class_rfa_size' parameters.
-    void clearBuffer(int       socket_fd,
-                     sockaddr* class_rfa,
-                     socklen_t class_rfa_size);
+    // Size of the scratch buffer clearBuffer reads into
+    const unsigned int CLEAR_BUFFER_SIZE = 65536;
+
+    // Asks the kernel to attach its running count of dropped datagrams to
+    // every datagram received on the given socket (SO_RXQ_OVFL).  Only
+    // meaningful for datagram and raw sockets on Linux; returns false
+    // elsewhere.
+    bool enableDropReporting(int socket_fd);
+
+    // Asks the kernel to attach a nanosecond-resolution timestamp, taken when
+    // the datagram was received, to every datagram received on the given
+    // socket (SO_TIMESTAMPNS).  Returns false if this isn't supported.
+    bool enableTimestamps(int socket_fd);
+
+    // Allows writes on the given socket to be made with MSG_ZEROCOPY
+    // (SO_ZEROCOPY).  Returns false if the kernel doesn't support it.
+    bool enableZeroCopy(int socket_fd);
+
+    // Has the kernel poll the device's receive queue itself for up to
+    // 'busy_poll_time' seconds whenever a read on the given socket finds
+    // nothing queued (SO_BUSY_POLL), rather than waiting on an interrupt, and
+    // keep interrupts off while reads keep coming (SO_PREFER_BUSY_POLL).
+    // Needs CAP_NET_ADMIN to go beyond the net.core.busy_read sysctl.
+    // Returns false if the kernel wouldn't busy poll; preferring it is best
+    // effort.
+    bool enableBusyPoll(int socket_fd, double busy_poll_time);
+
+    // Stops the kernel busy polling for the given socket
+    bool disableBusyPoll(int socket_fd);
+
+    // Restricts the calling thread to running on the given core.  Returns
+    // false if it couldn't be, or this isn't supported.
+    bool pinThread(int core);
+
+    // Opens an event that threads can poll for alongside their sockets to
+    // learn when to stop.  Returns -1 if it couldn't be opened, or this isn't
+    // supported.
+    int openStopEvent();
+
+    // Makes the given stop event readable, waking every thread polling for it;
+    // it stays readable until closed
+    bool signalStopEvent(int event_fd);
+
+    // Lets datagrams written to the given socket carry a transmit time
+    // (SO_TXTIME), nanoseconds on 'clock', which the fq and etf qdiscs hold
+    // them back until.  fq needs CLOCK_MONOTONIC and etf CLOCK_TAI; any other
+    // qdisc sends them straight away.  Datagrams dropped for missing their
+    // time are reported on the error queue.  The kernel has no way to turn
+    // this off again.  Only CLOCK_MONOTONIC is allowed without CAP_NET_ADMIN.
+    // Returns false if this isn't supported.
+    bool enableTransmitTime(int socket_fd, clockid_t clock);
+
+    // Has the kernel report on the given socket's error queue when each
+    // datagram written is handed to the device (SO_TIMESTAMPING, software
+    // transmit timestamps).  Datagrams are numbered from 0 in the order
+    // they're written, starting over every time this is called.  Returns
+    // false if this isn't supported.
+    bool enableTransmitTimestamps(int socket_fd);
+
+    // Stops the kernel reporting transmit timestamps for the given socket
+    bool disableTransmitTimestamps(int socket_fd);
+
+    // Drains the given socket's error queue without blocking.  The number and
+    // CLOCK_REALTIME transmit timestamp of each datagram reported sent (see
+    // enableTransmitTimestamps) are stored in 'ids' and 'times', stopping
+    // once 'room' have been; datagrams dropped for missing their transmit
+    // time are counted in 'class_stats'.  Returns the number of timestamps
+    // stored, or -1 on error.
+    int readTransmitReports(int               socket_fd,
+                            std::uint32_t*    ids,
+                            PosixTimespec*    times,
+                            unsigned int      room,
+                            SocketStatistics& class_stats);
+
+    // Returns the current time on CLOCK_MONOTONIC as seconds
+    double getMonotonicSeconds();
+
+    // Waits until 'deadline' (seconds on CLOCK_MONOTONIC).  Sleeps overshoot
+    // by tens of microseconds, so the last SLEEP_SPIN_TIME seconds are spent
+    // spinning instead.
+    void sleepUntil(double deadline);
+
+    // How long sleepUntil spins for at the end of a wait
+    const double SLEEP_SPIN_TIME = 100.0e-6;
+
+    // Drains zero-copy completion notifications from the given socket's error
+    // queue without blocking.  The kernel numbers zero-copy writes 0, 1, 2 and
+    // so on, and for TCP reports them complete in that order, so progress is
+    // tracked as 'completed_through', one past the newest write known to be
+    // complete.  'copied' is incremented for every notification saying the
+    // kernel fell back to copying the data anyway.  Returns the number of
+    // writes newly known to be complete, or -1 on error.
+    int readZeroCopyCompletions(int               socket_fd,
+                                std::uint32_t&    completed_through,
+                                unsigned long&    copied,
+                                SocketStatistics& class_stats);
+
+    // Fills in the parts of 'kernel_stats' common to all socket types:
+    // receive and send queue depths, plus the latest drop count seen in
+    // 'class_stats'.  Returns false if the queue depths couldn't be retrieved.
+    bool getKernelStatistics(int                     socket_fd,
+                             const SocketStatistics& class_stats,
+                             SocketKernelStatistics& kernel_stats);
 
     // Shuts the given socket down.  First traffic is stopped, then the file
     // descriptor is closed.
     void shutdown(int socket_fd);
 }
+
+#endif
@@ -11,19 +11,32 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#if defined LINUX
+#include <netinet/tcp.h>
+#endif
+
 #if defined DEBUG
 #include <iostream>
 #endif
 
 #include "PosixTCPSocketImpl.hpp"
 
+#include "AddressResolver.hpp"
 #include "PosixSocketCommon.hpp"
+#include "SocketKernelStatistics.hpp"
+#include "TCPSocket.hpp"
 
 //==============================================================================
 // Creates a Posix TCP socket
 //==============================================================================
 PosixTCPSocketImpl::PosixTCPSocketImpl() :
-    blocking_timeout(0.0)
+    blocking_timeout(0.0),
+    is_blocking(true),
+    zerocopy_threshold(0),
+    zerocopy_next_id(0),
+    zerocopy_completed_through(0),
+    last_write_zerocopy(false),
+    zerocopy_copied(0)
 {
     // Create the socket
     socket_fd = socket(AF_INET, SOCK_STREAM, 0);
@@ -44,7 +57,13 @@ PosixTCPSocketImpl::PosixTCPSocketImpl(int          socket_fd,
     socket_fd(socket_fd),
     local_address(local_address),
     peer_address(peer_address),
-    blocking_timeout(blocking_timeout)
+    blocking_timeout(blocking_timeout),
+    is_blocking(PosixSocketCommon::isBlockingEnabled(socket_fd)),
+    zerocopy_threshold(0),
+    zerocopy_next_id(0),
+    zerocopy_completed_through(0),
+    last_write_zerocopy(false),
+    zerocopy_copied(0)
 {
 }
 
@@ -61,7 +80,13 @@ PosixTCPSocketImpl::~PosixTCPSocketImpl()
 //==============================================================================
 bool PosixTCPSocketImpl::enableBlocking()
 {
-    return PosixSocketCommon::enableBlocking(socket_fd);
+    if (!PosixSocketCommon::enableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = true;
+    return true;
 }
 
 //==============================================================================
@@ -69,7 +94,13 @@ bool PosixTCPSocketImpl::enableBlocking()
 //==============================================================================
 bool PosixTCPSocketImpl::disableBlocking()
 {
-    return PosixSocketCommon::disableBlocking(socket_fd);
+    if (!PosixSocketCommon::disableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = false;
+    return true;
 }
 
 //==============================================================================
@@ -77,7 +108,16 @@ bool PosixTCPSocketImpl::disableBlocking()
 //==============================================================================
 bool PosixTCPSocketImpl::isBlockingEnabled()
 {
-    return PosixSocketCommon::isBlockingEnabled(socket_fd);
+    return is_blocking;
+}
+
+//==============================================================================
+// Has the kernel time out blocking reads and writes
+//==============================================================================
+void PosixTCPSocketImpl::setBlockingTimeout(double blocking_timeout)
+{
+    this->blocking_timeout = blocking_timeout;
+    PosixSocketCommon::setBlockingTimeout(socket_fd, blocking_timeout);
 }
 
 //==============================================================================
@@ -91,10 +131,10 @@ bool PosixTCPSocketImpl::bind(unsigned int& port)
 //==============================================================================
 // Flags this socket as one that will listen
 //==============================================================================
-bool PosixTCPSocketImpl::listen()
+bool PosixTCPSocketImpl::listen(int backlog)
 {
     // Start listening on this socket
-    if (::listen(socket_fd, 0) == -1)
+    if (::listen(socket_fd, backlog) == -1)
     {
 #if defined DEBUG
         perror("PosixTCPSocketImpl::listen");
@@ -110,23 +150,12 @@ bool PosixTCPSocketImpl::listen()
 //==============================================================================
 PosixTCPSocketImpl* PosixTCPSocketImpl::accept(bool take_over)
 {
-    // Is a valid timeout set?
-    if (isBlockingEnabled() && blocking_timeout > 0.0)
-    {
-        // Perform the blocking timeout and check if the POLLIN event occurred
-        if (PosixSocketCommon::doBlockingTimeout(
-                socket_fd, POLLIN, blocking_timeout) == 0)
-        {
-            // Accepting now will block, but we've blocked long enough already,
-            // so return instead and let the user try again if they want
-            return 0;
-        }
-    }
-
     // Will hold length of returned sockaddr
     socklen_t addrlen = sizeof(sockaddr_in);
 
-    // Look for an incoming connection
+    // Look for an incoming connection.  Any blocking timeout is handled by the
+    // kernel (SO_RCVTIMEO applies to accept), in which case this fails with
+    // EAGAIN and the user can try again if they want.
     int new_socket_fd =
         ::accept(socket_fd, (sockaddr*)&peer_address, &addrlen);
 
@@ -169,6 +198,16 @@ PosixTCPSocketImpl* PosixTCPSocketImpl::accept(bool take_over)
         PosixSocketCommon::shutdown(socket_fd);
         socket_fd = new_socket_fd;
 
+        // Zero-copy write numbering is per descriptor, so start over
+        zerocopy_next_id           = 0;
+        zerocopy_completed_through = 0;
+        last_write_zerocopy        = false;
+        if (zerocopy_threshold > 0 &&
+            !PosixSocketCommon::enableZeroCopy(socket_fd))
+        {
+            zerocopy_threshold = 0;
+        }
+
         return this;
     }
 
@@ -186,57 +225,37 @@ PosixTCPSocketImpl* PosixTCPSocketImpl::accept(bool take_over)
 bool PosixTCPSocketImpl::connect(const std::string& hostname,
                                  unsigned int       port)
 {
-    // Create some hints for getaddrinfo
-    addrinfo hints = { 0 };
-    hints.ai_family   = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
-    hints.ai_flags    = 0;
-
-    // Will point to the results list
-    addrinfo* results = 0;
-
-    // Look up the provided hostname
-    int ret = getaddrinfo(hostname.c_str(), 0, &hints, &results);
-
-    // If there weren't any results just error and leave
-    if (!results)
+    // Names are resolved once and remembered, and dotted addresses are
+    // parsed without a lookup
+    in_addr resolved;
+    if (!AddressResolver::getShared().resolve(hostname, resolved))
     {
 #if defined DEBUG
-        std::cerr << "PosixTCPSocketImpl::connect: " << gai_strerror(ret)
+        std::cerr << "PosixTCPSocketImpl::connect: Can't resolve " << hostname
                   << "\n";
 #endif
         return false;
     }
 
-    // If anything was found just choose the first one; if anything more
-    // complicated is needed it'll be implemented later
-
-#if defined DEBUG
-    // Warn if we got more than one return
-    if (results->ai_next)
-    {
-        std::cerr << "PosixTCPSocketImpl::connect: Multiple addrinfo results "
-                  << "returned, arbitrarily choosing the first one\n";
-    }
-#endif
-    memcpy(&peer_address, results->ai_addr, sizeof(sockaddr_in));
-    peer_address.sin_port = htons(port);
+    memset(&peer_address, 0, sizeof(peer_address));
+    peer_address.sin_family = AF_INET;
+    peer_address.sin_addr   = resolved;
+    peer_address.sin_port   = htons(port);
 
     // Do the connect
-    ret = ::connect(socket_fd,
-                    reinterpret_cast<sockaddr*>(&peer_address),
-                    sizeof(sockaddr_in));
-
-    // Release addrinfo memory back to the kernel; freeaddrinfo returns nothing
-    // so no need to check for errors here
-    freeaddrinfo(results);
+    int ret = ::connect(socket_fd,
+                        reinterpret_cast<sockaddr*>(&peer_address),
+                        sizeof(sockaddr_in));
 
     // Check for errors from the connect earlier
     if (ret == -1)
     {
 #if defined DEBUG
-        perror("PosixTCPSocketImpl::connect");
+        // A non-blocking connect still under way isn't a problem
+        if (errno != EINPROGRESS)
+        {
+            perror("PosixTCPSocketImpl::connect");
+        }
 #endif
         return false;
     }
@@ -267,7 +286,16 @@ bool PosixTCPSocketImpl::isConnected()
 int PosixTCPSocketImpl::read(unsigned char* buffer, unsigned int size)
 {
     return PosixSocketCommon::read(
-        socket_fd, buffer, size, blocking_timeout, 0, 0);
+        socket_fd,
+        buffer,
+        size,
+        is_blocking,
+        blocking_timeout,
+        0,
+        0,
+        statistics,
+        0,
+        0);
 }
 
 //==============================================================================
@@ -275,8 +303,74 @@ int PosixTCPSocketImpl::read(unsigned char* buffer, unsigned int size)
 //==============================================================================
 int PosixTCPSocketImpl::write(const unsigned char* buffer, unsigned int size)
 {
+    last_write_zerocopy = false;
+
+#if defined MSG_ZEROCOPY
+    if (zerocopy_threshold > 0 && size >= zerocopy_threshold)
+    {
+        int ret = PosixSocketCommon::write(socket_fd,
+                                           buffer,
+                                           size,
+                                           is_blocking,
+                                           blocking_timeout,
+                                           0,
+                                           0,
+                                           statistics,
+                                           MSG_ZEROCOPY);
+
+        if (ret > 0)
+        {
+            // The kernel numbers every zero-copy send that moves any data,
+            // even a partial one
+            zerocopy_next_id++;
+            last_write_zerocopy = true;
+            return ret;
+        }
+
+        // ENOBUFS means too many pages are pinned by writes that haven't
+        // completed yet; copying still works, so do that instead.  The
+        // attempt counts as a fallback rather than an error.
+        if (!(ret == -1 && errno == ENOBUFS))
+        {
+            return ret;
+        }
+    }
+#endif
+
     return PosixSocketCommon::write(
-        socket_fd, buffer, size, blocking_timeout, 0, 0);
+        socket_fd,
+        buffer,
+        size,
+        is_blocking,
+        blocking_timeout,
+        0,
+        0,
+        statistics,
+        0);
+}
+
+//==============================================================================
+// Writes several buffers to socket at once
+//==============================================================================
+int PosixTCPSocketImpl::writeGather(const unsigned char* const* buffers,
+                                    const unsigned int*         sizes,
+                                    unsigned int                count)
+{
+    last_write_zerocopy = false;
+
+    if (count > TCPSocket::WRITE_GATHER_MAX)
+    {
+        count = TCPSocket::WRITE_GATHER_MAX;
+    }
+
+    return PosixSocketCommon::writeGather(
+        socket_fd,
+        buffers,
+        sizes,
+        count,
+        is_blocking,
+        blocking_timeout,
+        statistics);
 }
 
 //==============================================================================
@@ -284,5 +378,68 @@ int PosixTCPSocketImpl::write(const unsigned char* buffer, unsigned int size)
 //==============================================================================
 void PosixTCPSocketImpl::clearBuffer()
 {
-    PosixSocketCommon::clearBuffer(socket_fd, 0, 0);
+    PosixSocketCommon::clearBuffer(socket_fd, statistics);
+}
+
+//==============================================================================
+// Retrieves queue depths and TCP_INFO from the kernel
+//==============================================================================
+bool PosixTCPSocketImpl::getKernelStatistics(
+    SocketKernelStatistics& kernel_statistics)
+{
+    kernel_statistics.reset();
+
+    bool queues_retrieved = PosixSocketCommon::getKernelStatistics(
+        socket_fd, statistics, kernel_statistics);
+
+#if defined LINUX
+    tcp_info info;
+    socklen_t info_len = sizeof(info);
+    if (getsockopt(socket_fd, IPPROTO_TCP, TCP_INFO, &info, &info_len) == -1)
+    {
+#if defined DEBUG
+        perror("PosixTCPSocketImpl::getKernelStatistics");
+#endif
+        return queues_retrieved;
+    }
+
+    // The kernel reports round trip times in microseconds
+    kernel_statistics.setRoundTripTime(info.tcpi_rtt / 1.0e6);
+    kernel_statistics.setRoundTripTimeVariance(info.tcpi_rttvar / 1.0e6);
+    kernel_statistics.setRetransmits(info.tcpi_total_retrans);
+    kernel_statistics.setCongestionWindow(info.tcpi_snd_cwnd);
+
+    return true;
+#else
+    return queues_retrieved;
+#endif
+}
+
+//==============================================================================
+// Turns on zero-copy writes above the given size
+//==============================================================================
+bool PosixTCPSocketImpl::enableZeroCopy(unsigned int threshold)
+{
+#if defined MSG_ZEROCOPY
+    if (!PosixSocketCommon::enableZeroCopy(socket_fd))
+    {
+        return false;
+    }
+
+    // Zero is how this class represents zero-copy being off, so a threshold of
+    // zero is taken to mean every non-empty write
+    zerocopy_threshold = threshold > 0 ? threshold : 1;
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Reads zero-copy completions off the error queue
+//==============================================================================
+int PosixTCPSocketImpl::processZeroCopyCompletions()
+{
+    return PosixSocketCommon::readZeroCopyCompletions(
+        socket_fd, zerocopy_completed_through, zerocopy_copied, statistics);
 }
@@ -2,6 +2,7 @@
 #define POSIX_TCP_SOCKET_IMPL_HPP
 
 #include <arpa/inet.h>
+#include <cstdint>
 #include <netinet/in.h>
 #include <poll.h>
 #include <sys/socket.h>
@@ -13,6 +14,9 @@ class PosixTCPSocketImpl : public TCPSocketImpl
 {
 public:
 
+    // Wraps connections it accepts using the private constructor below
+    friend class ShardedTCPAcceptor;
+
     // Constructs a new Posix TCP socket.
     PosixTCPSocketImpl();
 
@@ -40,8 +44,9 @@ public:
     // argument.
     virtual bool bind(unsigned int& port);
 
-    // Tells this socket to begin listening for incoming connection attempts.
-    virtual bool listen();
+    // Tells this socket to begin listening for incoming connection attempts,
+    // queueing up to 'backlog' of them.
+    virtual bool listen(int backlog);
 
     // Accepts a connection request, should one be pending.  The user can
     // specify if they want this socket to close the old socket descriptor and
@@ -70,12 +75,45 @@ public:
     // buffer.
     virtual int write(const unsigned char* buffer, unsigned int size);
 
+    // Writes several buffers with one writev() call.
+    virtual int writeGather(const unsigned char* const* buffers,
+                            const unsigned int*         sizes,
+                            unsigned int                count);
+
     // Forces this socket to discard any received data.
     virtual void clearBuffer();
 
+    // Asks the kernel for its view of this socket (queue depths, drops, round
+    // trip time, retransmits and congestion window).
+    // Returns false if none of this information could be retrieved.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics);
+
+    // Returns the descriptor for this socket
+    virtual int getDescriptor() const;
+
     // Gets the source IP address of the last received packet
     virtual void getPeerAddress(std::string& peer_address_str) const;
 
+    // Turns on SO_ZEROCOPY and has writes of at least 'threshold' bytes sent
+    // with MSG_ZEROCOPY.  Returns false if the kernel doesn't support this.
+    virtual bool enableZeroCopy(unsigned int threshold);
+
+    // Has all writes copied again
+    virtual void disableZeroCopy();
+
+    // Returns true and the write's id if the last write was sent zero-copy
+    virtual bool getLastZeroCopyId(std::uint32_t& id) const;
+
+    // Drains zero-copy completion notifications from the error queue
+    virtual int processZeroCopyCompletions();
+
+    // Returns true once the zero-copy write with the given id has completed
+    virtual bool isZeroCopyComplete(std::uint32_t id) const;
+
+    // Returns how many zero-copy writes the kernel ended up copying anyway
+    virtual unsigned long getZeroCopyCopiedCount() const;
+
 private:
 
     // A special constructor used during accept; duplicates a socket and assumes
@@ -101,17 +139,32 @@ private:
 
     double blocking_timeout;
 
+    // Whether or not this socket is in blocking mode; kept here so reads and
+    // writes don't have to ask the kernel
+    bool is_blocking;
+
+    // Writes at least this large are sent zero-copy; 0 means zero-copy is off
+    unsigned int zerocopy_threshold;
+
+    // The kernel numbers zero-copy writes in order starting from 0.  This is
+    // the number the next one will get.
+    std::uint32_t zerocopy_next_id;
+
+    // One past the newest zero-copy write known to be complete
+    std::uint32_t zerocopy_completed_through;
+
+    // Whether the last write was sent zero-copy
+    bool last_write_zerocopy;
+
+    // Zero-copy writes the kernel reported copying anyway
+    unsigned long zerocopy_copied;
+
     // Disallow these for now; maybe these could be meaningfully implemented but
     // we'll save that for later
     PosixTCPSocketImpl(const PosixTCPSocketImpl&);
     PosixTCPSocketImpl& operator=(const PosixTCPSocketImpl&);
 };
 
-inline void PosixTCPSocketImpl::setBlockingTimeout(double blocking_timeout)
-{
-    this->blocking_timeout = blocking_timeout;
-}
-
 inline double PosixTCPSocketImpl::getBlockingTimeout() const
 {
     return this->blocking_timeout;
@@ -123,4 +176,31 @@ void PosixTCPSocketImpl::getPeerAddress(std::string& peer_address_str) const
     peer_address_str = inet_ntoa(peer_address.sin_addr);
 }
 
+inline void PosixTCPSocketImpl::disableZeroCopy()
+{
+    zerocopy_threshold = 0;
+}
+
+inline bool PosixTCPSocketImpl::getLastZeroCopyId(std::uint32_t& id) const
+{
+    id = zerocopy_next_id - 1;
+    return last_write_zerocopy;
+}
+
+inline bool PosixTCPSocketImpl::isZeroCopyComplete(std::uint32_t id) const
+{
+    // Compared by difference so this survives the kernel's counter wrapping
+    return static_cast<std::int32_t>(id - zerocopy_completed_through) < 0;
+}
+
+inline unsigned long PosixTCPSocketImpl::getZeroCopyCopiedCount() const
+{
+    return zerocopy_copied;
+}
+
+inline int PosixTCPSocketImpl::getDescriptor() const
+{
+    return socket_fd;
+}
+
 #endif
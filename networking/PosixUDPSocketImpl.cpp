@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <errno.h>
+#include <net/if.h>
 #include <netdb.h>
+#include <netinet/udp.h>
 #include <stdexcept>
 #include <sstream>
 #include <string>
@@ -15,13 +18,34 @@
 
 #include "PosixUDPSocketImpl.hpp"
 
+#include "AddressResolver.hpp"
 #include "PosixSocketCommon.hpp"
+#include "PosixTimespec.hpp"
+#include "SocketKernelStatistics.hpp"
+
+// Returns the time on the given clock as nanoseconds
+static std::int64_t getNanoseconds(clockid_t clock)
+{
+    timespec now;
+    clock_gettime(clock, &now);
+    return static_cast<std::int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
 
 //==============================================================================
 // Initializes platform-specific UDP socket
 //==============================================================================
 PosixUDPSocketImpl::PosixUDPSocketImpl() :
-    blocking_timeout(0.0)
+    blocking_timeout(0.0),
+    is_blocking(true),
+    spin_time(0.0),
+    last_segment_size(0),
+    pacing_rate(0.0),
+    pacing_credit(0.0),
+    pacing_next(0.0),
+    pacing_clock(CLOCK_MONOTONIC),
+    pacing_epoch(0),
+    kernel_pacing(false),
+    pending_first(0)
 {
     // Create the socket
     socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
@@ -42,6 +66,26 @@ PosixUDPSocketImpl::PosixUDPSocketImpl() :
         perror("PosixUDPSocketImpl::PosixUDPSocketImpl");
 #endif
     }
+
+    // Have the kernel tell us about datagrams it drops on our behalf
+    PosixSocketCommon::enableDropReporting(socket_fd);
+
+#if defined LINUX
+    // By default Linux hands a socket multicast traffic for every group any
+    // socket on the host has joined, as long as the port matches.  Only
+    // deliver groups this socket joined itself.
+    int multicast_all = 0;
+    if (setsockopt(socket_fd,
+                   IPPROTO_IP,
+                   IP_MULTICAST_ALL,
+                   &multicast_all,
+                   sizeof(multicast_all)) == -1)
+    {
+#if defined DEBUG
+        perror("PosixUDPSocketImpl::PosixUDPSocketImpl");
+#endif
+    }
+#endif
 }
 
 //==============================================================================
@@ -57,7 +101,13 @@ PosixUDPSocketImpl::~PosixUDPSocketImpl()
 //==============================================================================
 bool PosixUDPSocketImpl::enableBlocking()
 {
-    return PosixSocketCommon::enableBlocking(socket_fd);
+    if (!PosixSocketCommon::enableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = true;
+    return true;
 }
 
 //==============================================================================
@@ -65,7 +115,13 @@ bool PosixUDPSocketImpl::enableBlocking()
 //==============================================================================
 bool PosixUDPSocketImpl::disableBlocking()
 {
-    return PosixSocketCommon::disableBlocking(socket_fd);
+    if (!PosixSocketCommon::disableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = false;
+    return true;
 }
 
 //==============================================================================
@@ -73,7 +129,16 @@ bool PosixUDPSocketImpl::disableBlocking()
 //==============================================================================
 bool PosixUDPSocketImpl::isBlockingEnabled()
 {
-    return PosixSocketCommon::isBlockingEnabled(socket_fd);
+    return is_blocking;
+}
+
+//==============================================================================
+// Has the kernel time out blocking reads and writes
+//==============================================================================
+void PosixUDPSocketImpl::setBlockingTimeout(double blocking_timeout)
+{
+    this->blocking_timeout = blocking_timeout;
+    PosixSocketCommon::setBlockingTimeout(socket_fd, blocking_timeout);
 }
 
 //==============================================================================
@@ -89,13 +154,398 @@ bool PosixUDPSocketImpl::bind(unsigned int& port)
 //==============================================================================
 int PosixUDPSocketImpl::read(unsigned char* buffer, unsigned int size)
 {
-    return PosixSocketCommon::read(
+    return PosixSocketCommon::spinRead(
         socket_fd,
         buffer,
         size,
+        is_blocking,
+        blocking_timeout,
+        spin_time,
+        reinterpret_cast<sockaddr*>(&peer_address),
+        sizeof(sockaddr_in),
+        statistics,
+        &last_timestamp,
+        &last_segment_size);
+}
+
+//==============================================================================
+// Reads as many datagrams as are available, up to 'count'
+//==============================================================================
+int PosixUDPSocketImpl::readBatch(unsigned char** buffers,
+                                  unsigned int*   sizes,
+                                  unsigned int    count,
+                                  PosixTimespec*  timestamps,
+                                  unsigned int*   segment_sizes)
+{
+    int ret = PosixSocketCommon::spinReadBatch(
+        socket_fd,
+        buffers,
+        sizes,
+        count,
+        is_blocking,
         blocking_timeout,
+        spin_time,
         reinterpret_cast<sockaddr*>(&peer_address),
-        sizeof(sockaddr_in));
+        sizeof(sockaddr_in),
+        statistics,
+        timestamps,
+        segment_sizes);
+
+    // Keep getLastTimestamp() and getLastSegmentSize() consistent with single
+    // reads
+    if (ret > 0 && timestamps)
+    {
+        last_timestamp = timestamps[ret - 1];
+    }
+
+    if (ret > 0 && segment_sizes)
+    {
+        last_segment_size = segment_sizes[ret - 1];
+    }
+
+    return ret;
+}
+
+//==============================================================================
+// Pins the calling thread, then turns on everything spinning reads use
+//==============================================================================
+bool PosixUDPSocketImpl::enableBusyPoll(double spin_time, int core)
+{
+    if (spin_time <= 0.0 ||
+        (core >= 0 && !PosixSocketCommon::pinThread(core)))
+    {
+        return false;
+    }
+
+    // Neither of these is essential.  Spinning still works without the kernel
+    // busy polling, and without timestamps only the delivery latency goes
+    // unmeasured.
+    PosixSocketCommon::enableBusyPoll(socket_fd, spin_time);
+    PosixSocketCommon::enableTimestamps(socket_fd);
+
+    this->spin_time = spin_time;
+    return true;
+}
+
+//==============================================================================
+// Leaves the thread pinned and timestamps on; only the spinning stops
+//==============================================================================
+bool PosixUDPSocketImpl::disableBusyPoll()
+{
+    spin_time = 0.0;
+    return PosixSocketCommon::disableBusyPoll(socket_fd);
+}
+
+//==============================================================================
+// Writes several datagrams at once
+//==============================================================================
+int PosixUDPSocketImpl::writeBatch(const unsigned char* const* buffers,
+                                   const unsigned int*         sizes,
+                                   unsigned int                count)
+{
+    if (pacing_rate > 0.0)
+    {
+        return kernel_pacing ? writeKernelPaced(buffers, sizes, count)
+                             : writeUserPaced(buffers, sizes, count);
+    }
+
+    return PosixSocketCommon::writeBatch(
+        socket_fd,
+        buffers,
+        sizes,
+        count,
+        is_blocking,
+        blocking_timeout,
+        reinterpret_cast<sockaddr*>(&sendto_address),
+        sizeof(sockaddr_in),
+        statistics);
+}
+
+//==============================================================================
+// Starts pacing, handing it to the qdisc if asked to and the kernel allows it
+//==============================================================================
+bool PosixUDPSocketImpl::enablePacing(double       rate,
+                                      unsigned int burst,
+                                      bool         kernel_pacing,
+                                      bool         tai)
+{
+    if (rate <= 0.0)
+    {
+        return false;
+    }
+
+    // Start over, collecting anything left from before
+    disablePacing();
+
+    pacing_clock = CLOCK_MONOTONIC;
+
+    if (kernel_pacing && !tai)
+    {
+        this->kernel_pacing =
+            PosixSocketCommon::enableTransmitTime(socket_fd, CLOCK_MONOTONIC);
+    }
+#if defined CLOCK_TAI
+    else if (kernel_pacing &&
+             PosixSocketCommon::enableTransmitTime(socket_fd, CLOCK_TAI))
+    {
+        this->kernel_pacing = true;
+        pacing_clock        = CLOCK_TAI;
+    }
+#endif
+
+    if (this->kernel_pacing)
+    {
+        // Without these the qdisc still paces; it just goes unmeasured
+        PosixSocketCommon::enableTransmitTimestamps(socket_fd);
+        pending_first = 0;
+    }
+
+    // The bucket starts out full, so the first 'burst' bytes go at once
+    pacing_rate   = rate;
+    pacing_credit = burst / rate;
+    pacing_epoch  = getNanoseconds(pacing_clock);
+    pacing_next   = 0.0;
+
+    return true;
+}
+
+//==============================================================================
+// Goes back to unpaced writes
+//==============================================================================
+bool PosixUDPSocketImpl::disablePacing()
+{
+    if (kernel_pacing)
+    {
+        collectTransmitReports();
+        PosixSocketCommon::disableTransmitTimestamps(socket_fd);
+        pending_times.clear();
+        kernel_pacing = false;
+    }
+
+    pacing_rate = 0.0;
+    return true;
+}
+
+//==============================================================================
+// Reads the pacing clock
+//==============================================================================
+double PosixUDPSocketImpl::getPacingTime() const
+{
+    return (getNanoseconds(pacing_clock) - pacing_epoch) / 1.0e9;
+}
+
+//==============================================================================
+// Token bucket: a datagram may go once the schedule is no more than
+// 'pacing_credit' ahead of now, and each one moves the schedule on by its own
+// transmission time
+//==============================================================================
+double PosixUDPSocketImpl::schedule(unsigned int size,
+                                    double       now,
+                                    double&      next) const
+{
+    double due = std::max(now, next - pacing_credit);
+    next       = std::max(next, due) + size / pacing_rate;
+    return due;
+}
+
+//==============================================================================
+// Waits for each datagram's time, then sends it with any others due by then
+//==============================================================================
+int PosixUDPSocketImpl::writeUserPaced(const unsigned char* const* buffers,
+                                       const unsigned int*         sizes,
+                                       unsigned int                count)
+{
+    double due[PosixSocketCommon::WRITE_BATCH_MAX];
+    double next[PosixSocketCommon::WRITE_BATCH_MAX];
+
+    unsigned int total = 0;
+
+    while (total < count)
+    {
+        double now = getPacingTime();
+
+        next[0] = pacing_next;
+        due[0]  = schedule(sizes[total], now, next[0]);
+
+        if (due[0] > now)
+        {
+            // Not due yet is as good as no room to a non-blocking socket
+            if (!is_blocking)
+            {
+                break;
+            }
+
+            PosixSocketCommon::sleepUntil(pacing_epoch / 1.0e9 + due[0]);
+            now = getPacingTime();
+        }
+
+        // Anything else that's due by now goes out in the same system call
+        unsigned int chunk = 1;
+        while (chunk < count - total &&
+               chunk < PosixSocketCommon::WRITE_BATCH_MAX)
+        {
+            next[chunk] = next[chunk - 1];
+            due[chunk]  = schedule(sizes[total + chunk], now, next[chunk]);
+            if (due[chunk] > now)
+            {
+                break;
+            }
+
+            ++chunk;
+        }
+
+        int ret = PosixSocketCommon::writeBatch(
+            socket_fd,
+            buffers + total,
+            sizes + total,
+            chunk,
+            is_blocking,
+            blocking_timeout,
+            reinterpret_cast<sockaddr*>(&sendto_address),
+            sizeof(sockaddr_in),
+            statistics);
+
+        if (ret <= 0)
+        {
+            return total > 0 ? static_cast<int>(total) : ret;
+        }
+
+        // The datagrams are on their way to the device once the call returns
+        double sent = getPacingTime();
+        for (int i = 0; i < ret; ++i)
+        {
+            statistics.recordPacing(sent - due[i]);
+        }
+
+        pacing_next = next[ret - 1];
+        total += ret;
+
+        if (static_cast<unsigned int>(ret) < chunk)
+        {
+            break;
+        }
+    }
+
+    return total;
+}
+
+//==============================================================================
+// Hands datagrams over at once, leaving the qdisc to hold them back
+//==============================================================================
+int PosixUDPSocketImpl::writeKernelPaced(const unsigned char* const* buffers,
+                                         const unsigned int*         sizes,
+                                         unsigned int                count)
+{
+    collectTransmitReports();
+
+    std::uint64_t txtimes[PosixSocketCommon::WRITE_BATCH_MAX];
+    double        due[PosixSocketCommon::WRITE_BATCH_MAX];
+    double        next[PosixSocketCommon::WRITE_BATCH_MAX];
+
+    unsigned int total = 0;
+
+    while (total < count)
+    {
+        unsigned int chunk =
+            std::min(count - total, PosixSocketCommon::WRITE_BATCH_MAX);
+
+        double now      = getPacingTime();
+        double previous = pacing_next;
+        for (unsigned int i = 0; i < chunk; ++i)
+        {
+            next[i]    = previous;
+            due[i]     = schedule(sizes[total + i], now, next[i]);
+            previous   = next[i];
+            txtimes[i] = pacing_epoch +
+                         static_cast<std::int64_t>(due[i] * 1.0e9 + 0.5);
+        }
+
+        int ret = PosixSocketCommon::writeBatch(
+            socket_fd,
+            buffers + total,
+            sizes + total,
+            chunk,
+            is_blocking,
+            blocking_timeout,
+            reinterpret_cast<sockaddr*>(&sendto_address),
+            sizeof(sockaddr_in),
+            statistics,
+            txtimes);
+
+        if (ret <= 0)
+        {
+            return total > 0 ? static_cast<int>(total) : ret;
+        }
+
+        pending_times.insert(pending_times.end(), due, due + ret);
+        pacing_next = next[ret - 1];
+        total += ret;
+
+        if (static_cast<unsigned int>(ret) < chunk)
+        {
+            break;
+        }
+    }
+
+    while (pending_times.size() > PENDING_MAX)
+    {
+        pending_times.pop_front();
+        ++pending_first;
+    }
+
+    return total;
+}
+
+//==============================================================================
+// Transmit timestamps are on CLOCK_REALTIME, so they're moved onto the pacing
+// clock using the difference between the two now
+//==============================================================================
+void PosixUDPSocketImpl::collectTransmitReports()
+{
+    std::uint32_t ids[PosixSocketCommon::READ_BATCH_MAX];
+    PosixTimespec times[PosixSocketCommon::READ_BATCH_MAX];
+
+    std::int64_t offset =
+        getNanoseconds(CLOCK_REALTIME) - getNanoseconds(pacing_clock);
+
+    int ret;
+    do
+    {
+        ret = PosixSocketCommon::readTransmitReports(
+            socket_fd,
+            ids,
+            times,
+            PosixSocketCommon::READ_BATCH_MAX,
+            statistics);
+
+        for (int i = 0; i < ret; ++i)
+        {
+            // Reports come in the order datagrams were written, so anything
+            // older than this one is never going to be reported.  Differences
+            // are taken so this keeps working when the 32-bit numbering
+            // wraps.
+            std::int32_t age =
+                static_cast<std::int32_t>(ids[i] - pending_first);
+            if (age < 0 ||
+                static_cast<std::size_t>(age) >= pending_times.size())
+            {
+                continue;
+            }
+
+            pending_times.erase(pending_times.begin(),
+                                pending_times.begin() + age);
+            pending_first = ids[i];
+
+            std::int64_t sent =
+                static_cast<std::int64_t>(times[i].getSeconds()) * 1000000000 +
+                times[i].getNanoseconds() - offset - pacing_epoch;
+            statistics.recordPacing(sent / 1.0e9 - pending_times.front());
+
+            pending_times.pop_front();
+            ++pending_first;
+        }
+    }
+    while (ret == static_cast<int>(PosixSocketCommon::READ_BATCH_MAX));
 }
 
 //==============================================================================
@@ -103,13 +553,23 @@ int PosixUDPSocketImpl::read(unsigned char* buffer, unsigned int size)
 //==============================================================================
 int PosixUDPSocketImpl::write(const unsigned char* buffer, unsigned int size)
 {
+    if (pacing_rate > 0.0)
+    {
+        // Paced writes all go through the batch path
+        int ret = writeBatch(&buffer, &size, 1);
+        return ret == 1 ? static_cast<int>(size) : ret;
+    }
+
     return PosixSocketCommon::write(
         socket_fd,
         buffer,
         size,
+        is_blocking,
         blocking_timeout,
         reinterpret_cast<sockaddr*>(&sendto_address),
-        sizeof(sockaddr_in));
+        sizeof(sockaddr_in),
+        statistics,
+        0);
 }
 
 //==============================================================================
@@ -117,65 +577,326 @@ int PosixUDPSocketImpl::write(const unsigned char* buffer, unsigned int size)
 //==============================================================================
 bool PosixUDPSocketImpl::sendTo(const std::string& address, unsigned int port)
 {
-    // Create some hints for getaddrinfo
-    addrinfo hints;
-    hints.ai_family   = AF_INET;
-    hints.ai_socktype = SOCK_DGRAM;
-    hints.ai_protocol = IPPROTO_UDP;
-    hints.ai_flags    = 0;
+    // Names are resolved once and remembered, and dotted addresses are
+    // parsed without a lookup, so sending to the same peers over and over
+    // doesn't cost a lookup each time
+    in_addr resolved;
+    if (!AddressResolver::getShared().resolve(address, resolved))
+    {
+#if defined DEBUG
+        std::cerr << "PosixUDPSocketImpl::sendTo: Can't resolve " << address
+                  << "\n";
+#endif
+        return false;
+    }
 
-    // Will point to the results list
-    addrinfo* results = 0;
+    memset(&sendto_address, 0, sizeof(sendto_address));
+    sendto_address.sin_family = AF_INET;
+    sendto_address.sin_addr   = resolved;
+    sendto_address.sin_port   = htons(port);
 
-    // Loop up the provided hostname
-    int ret = getaddrinfo(address.c_str(), 0, &hints, &results);
+    return true;
+}
 
-    // Check for errors
-    if (ret != 0)
+//==============================================================================
+// Clears all the data out of this socket's receive buffer
+//==============================================================================
+void PosixUDPSocketImpl::clearBuffer()
+{
+    PosixSocketCommon::clearBuffer(socket_fd, statistics);
+}
+
+//==============================================================================
+// Retrieves queue depths and drop counts from the kernel
+//==============================================================================
+bool PosixUDPSocketImpl::getKernelStatistics(
+    SocketKernelStatistics& kernel_statistics)
+{
+    kernel_statistics.reset();
+
+    return PosixSocketCommon::getKernelStatistics(
+        socket_fd, statistics, kernel_statistics);
+}
+
+//==============================================================================
+// Has the kernel timestamp received datagrams
+//==============================================================================
+bool PosixUDPSocketImpl::enableTimestamps()
+{
+    return PosixSocketCommon::enableTimestamps(socket_fd);
+}
+
+//==============================================================================
+// Has the kernel split large writes into datagrams of the given size
+//==============================================================================
+bool PosixUDPSocketImpl::enableSegmentation(unsigned int segment_size)
+{
+#if defined UDP_SEGMENT
+    int value = segment_size;
+    if (setsockopt(
+            socket_fd, IPPROTO_UDP, UDP_SEGMENT, &value, sizeof(value)) == -1)
     {
 #if defined DEBUG
-        std::cerr << "PosixUDPSocketImpl::sendTo: " << gai_strerror(ret) << "\n";
+        perror("PosixUDPSocketImpl::enableSegmentation");
 #endif
         return false;
     }
 
-    // If there weren't any results just error and leave
-    if (!results)
+    return true;
+#else
+    return false;
+#endif
+}
+
+//==============================================================================
+// Goes back to sending every write as a single datagram
+//==============================================================================
+bool PosixUDPSocketImpl::disableSegmentation()
+{
+    // A segment size of 0 turns segmentation off
+    return enableSegmentation(0);
+}
+
+//==============================================================================
+// Lets the kernel hand over coalesced datagrams
+//==============================================================================
+bool PosixUDPSocketImpl::enableReceiveCoalescing()
+{
+#if defined UDP_GRO
+    int enable = 1;
+    if (setsockopt(
+            socket_fd, IPPROTO_UDP, UDP_GRO, &enable, sizeof(enable)) == -1)
     {
 #if defined DEBUG
-        std::cerr << "Address not usable\n";
+        perror("PosixUDPSocketImpl::enableReceiveCoalescing");
 #endif
         return false;
     }
 
-    // If anything was found just choose the first one; if anything more
-    // complicated is needed it'll be implemented later
+    return true;
+#else
+    return false;
+#endif
+}
 
+//==============================================================================
+// Lets other sockets bind the same port
+//==============================================================================
+bool PosixUDPSocketImpl::enableAddressReuse()
+{
+    int enable = 1;
+    if (setsockopt(
+            socket_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) == -1)
+    {
 #if defined DEBUG
-    // Warn if we got more than one return
-    if (results->ai_next)
+        perror("PosixUDPSocketImpl::enableAddressReuse");
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Joins a multicast group
+//==============================================================================
+bool PosixUDPSocketImpl::joinGroup(const std::string& group,
+                                   const std::string& interface_name)
+{
+    return changeMembership(MCAST_JOIN_GROUP, group, "", interface_name);
+}
+
+//==============================================================================
+// Leaves a multicast group
+//==============================================================================
+bool PosixUDPSocketImpl::leaveGroup(const std::string& group,
+                                    const std::string& interface_name)
+{
+    return changeMembership(MCAST_LEAVE_GROUP, group, "", interface_name);
+}
+
+//==============================================================================
+// Joins a multicast group for a single source
+//==============================================================================
+bool PosixUDPSocketImpl::joinSourceGroup(const std::string& group,
+                                         const std::string& source,
+                                         const std::string& interface_name)
+{
+    return changeMembership(
+        MCAST_JOIN_SOURCE_GROUP, group, source, interface_name);
+}
+
+//==============================================================================
+// Leaves a multicast group for a single source
+//==============================================================================
+bool PosixUDPSocketImpl::leaveSourceGroup(const std::string& group,
+                                          const std::string& source,
+                                          const std::string& interface_name)
+{
+    return changeMembership(
+        MCAST_LEAVE_SOURCE_GROUP, group, source, interface_name);
+}
+
+//==============================================================================
+// Chooses the interface multicast datagrams go out on
+//==============================================================================
+bool PosixUDPSocketImpl::setMulticastInterface(
+    const std::string& interface_name)
+{
+    unsigned int index = 0;
+    if (!interface_name.empty())
     {
-        std::cerr << "PosixUDPSocketImpl::connect: Multiple addrinfo results "
-                  << "returned, arbitrarily choosing the first one\n";
+        index = if_nametoindex(interface_name.c_str());
+        if (index == 0)
+        {
+#if defined DEBUG
+            perror("PosixUDPSocketImpl::setMulticastInterface");
+#endif
+            return false;
+        }
     }
+
+    // An interface index of 0 means no interface in particular
+#if defined LINUX
+    ip_mreqn request;
+    memset(&request, 0, sizeof(request));
+    request.imr_ifindex = index;
+
+    int ret = setsockopt(
+        socket_fd, IPPROTO_IP, IP_MULTICAST_IF, &request, sizeof(request));
+#else
+    int ret = setsockopt(
+        socket_fd, IPPROTO_IP, IP_MULTICAST_IFINDEX, &index, sizeof(index));
 #endif
-    memcpy(&sendto_address, results->ai_addr, sizeof(sockaddr_in));
-    sendto_address.sin_port = htons(port);
 
-    // Release addrinfo memory back to the kernel; freeaddrinfo returns nothing
-    // so no need to check for errors here
-    freeaddrinfo(results);
+    if (ret == -1)
+    {
+#if defined DEBUG
+        perror("PosixUDPSocketImpl::setMulticastInterface");
+#endif
+        return false;
+    }
 
     return true;
 }
 
 //==============================================================================
-// Clears all the data out of this socket's receive buffer
+// Sets the multicast time-to-live
 //==============================================================================
-void PosixUDPSocketImpl::clearBuffer()
+bool PosixUDPSocketImpl::setMulticastTtl(unsigned int ttl)
 {
-    PosixSocketCommon::clearBuffer(
-        socket_fd,
-        reinterpret_cast<sockaddr*>(&peer_address),
-        sizeof(sockaddr_in));
+    // Linux accepts either an int or an unsigned char here but other platforms
+    // only take an unsigned char
+    unsigned char value = ttl > 255 ? 255 : ttl;
+
+    if (setsockopt(
+            socket_fd, IPPROTO_IP, IP_MULTICAST_TTL, &value, sizeof(value)) ==
+        -1)
+    {
+#if defined DEBUG
+        perror("PosixUDPSocketImpl::setMulticastTtl");
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Turns multicast loopback on or off
+//==============================================================================
+bool PosixUDPSocketImpl::setMulticastLoopback(bool enabled)
+{
+    unsigned char value = enabled ? 1 : 0;
+
+    if (setsockopt(
+            socket_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &value, sizeof(value)) ==
+        -1)
+    {
+#if defined DEBUG
+        perror("PosixUDPSocketImpl::setMulticastLoopback");
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Joins or leaves a multicast group, optionally for a single source
+//==============================================================================
+bool PosixUDPSocketImpl::changeMembership(int                option,
+                                          const std::string& group,
+                                          const std::string& source,
+                                          const std::string& interface_name)
+{
+    unsigned int index = 0;
+    if (!interface_name.empty())
+    {
+        index = if_nametoindex(interface_name.c_str());
+        if (index == 0)
+        {
+#if defined DEBUG
+            perror("PosixUDPSocketImpl::changeMembership");
+#endif
+            return false;
+        }
+    }
+
+    // Both request types carry addresses as sockaddr_storage, so the same
+    // parsing works for either
+    sockaddr_in group_address;
+    memset(&group_address, 0, sizeof(group_address));
+    group_address.sin_family = AF_INET;
+
+    sockaddr_in source_address;
+    memset(&source_address, 0, sizeof(source_address));
+    source_address.sin_family = AF_INET;
+
+    bool source_specific = option == MCAST_JOIN_SOURCE_GROUP ||
+                           option == MCAST_LEAVE_SOURCE_GROUP;
+
+    if (inet_pton(AF_INET, group.c_str(), &group_address.sin_addr) != 1 ||
+        (source_specific &&
+         inet_pton(AF_INET, source.c_str(), &source_address.sin_addr) != 1))
+    {
+#if defined DEBUG
+        std::cerr << "PosixUDPSocketImpl::changeMembership: Address not "
+                  << "usable\n";
+#endif
+        return false;
+    }
+
+    int ret = 0;
+    if (source_specific)
+    {
+        group_source_req request;
+        memset(&request, 0, sizeof(request));
+        request.gsr_interface = index;
+        memcpy(&request.gsr_group,  &group_address,  sizeof(group_address));
+        memcpy(&request.gsr_source, &source_address, sizeof(source_address));
+
+        ret = setsockopt(
+            socket_fd, IPPROTO_IP, option, &request, sizeof(request));
+    }
+    else
+    {
+        group_req request;
+        memset(&request, 0, sizeof(request));
+        request.gr_interface = index;
+        memcpy(&request.gr_group, &group_address, sizeof(group_address));
+
+        ret = setsockopt(
+            socket_fd, IPPROTO_IP, option, &request, sizeof(request));
+    }
+
+    if (ret == -1)
+    {
+#if defined DEBUG
+        perror("PosixUDPSocketImpl::changeMembership");
+#endif
+        return false;
+    }
+
+    return true;
 }
@@ -2,12 +2,17 @@
 #define POSIX_UDP_SOCKET_IMPL_HPP
 
 #include <arpa/inet.h>
+#include <cstdint>
+#include <deque>
 #include <netinet/in.h>
 #include <poll.h>
 #include <sys/socket.h>
+#include <time.h>
 
 #include "UDPSocketImpl.hpp"
 
+#include "PosixTimespec.hpp"
+
 // Defines a socket implementation specific to POSIX
 class PosixUDPSocketImpl : public UDPSocketImpl
 {
@@ -54,11 +59,133 @@ public:
     // Forces this socket to discard all received data
     virtual void clearBuffer();
 
+    // Asks the kernel for its view of this socket (queue depths, drops).
+    // Returns false if none of this information could be retrieved.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics);
+
+    // Returns the descriptor for this socket
+    virtual int getDescriptor() const;
+
     // Gets the source IP address of the last received packet
     virtual void getPeerAddress(std::string& peer_address_str) const;
 
+    // Has the kernel timestamp every datagram as it's received.
+    virtual bool enableTimestamps();
+
+    // Gets the kernel receive timestamp of the last datagram read.
+    virtual void getLastTimestamp(PosixTimespec& timestamp) const;
+
+    // Reads up to 'count' datagrams, waiting only for the first.  See
+    // PosixSocketCommon::readBatch for details.
+    virtual int readBatch(unsigned char** buffers,
+                          unsigned int*   sizes,
+                          unsigned int    count,
+                          PosixTimespec*  timestamps,
+                          unsigned int*   segment_sizes);
+
+    // Sets up spinning reads, SO_BUSY_POLL and receive timestamps.  See
+    // UDPSocket::enableBusyPoll for details.
+    virtual bool enableBusyPoll(double spin_time, int core);
+
+    // Stops spinning and clears SO_BUSY_POLL
+    virtual bool disableBusyPoll();
+
+    // Writes datagrams with sendmmsg() where available.  See
+    // PosixSocketCommon::writeBatch for details.
+    virtual int writeBatch(const unsigned char* const* buffers,
+                           const unsigned int*         sizes,
+                           unsigned int                count);
+
+    // Paces writes here or, with SO_TXTIME, in the qdisc.  See
+    // UDPSocket::enablePacing for details.
+    virtual bool enablePacing(double       rate,
+                              unsigned int burst,
+                              bool         kernel_pacing,
+                              bool         tai);
+
+    // Stops pacing, first collecting what transmit reports there are
+    virtual bool disablePacing();
+
+    // Returns true if datagrams carry transmit times for the qdisc
+    virtual bool isKernelPacing() const;
+
+    // Sets UDP_SEGMENT so the kernel splits writes into datagrams of the
+    // given size
+    virtual bool enableSegmentation(unsigned int segment_size);
+
+    // Clears UDP_SEGMENT
+    virtual bool disableSegmentation();
+
+    // Sets UDP_GRO so the kernel can coalesce received datagrams
+    virtual bool enableReceiveCoalescing();
+
+    // Gets the segment size of the last read
+    virtual unsigned int getLastSegmentSize() const;
+
+    // Sets SO_REUSEADDR so other sockets can bind the same port
+    virtual bool enableAddressReuse();
+
+    // Starts receiving datagrams sent to the given multicast group
+    virtual bool joinGroup(const std::string& group,
+                           const std::string& interface_name);
+
+    // Stops receiving datagrams sent to the given multicast group
+    virtual bool leaveGroup(const std::string& group,
+                            const std::string& interface_name);
+
+    // Starts receiving datagrams sent to the given multicast group by the given
+    // source only
+    virtual bool joinSourceGroup(const std::string& group,
+                                 const std::string& source,
+                                 const std::string& interface_name);
+
+    // Stops receiving datagrams sent to the given multicast group by the given
+    // source
+    virtual bool leaveSourceGroup(const std::string& group,
+                                  const std::string& source,
+                                  const std::string& interface_name);
+
+    // Sets the interface multicast datagrams are sent from
+    virtual bool setMulticastInterface(const std::string& interface_name);
+
+    // Sets the time-to-live of outgoing multicast datagrams
+    virtual bool setMulticastTtl(unsigned int ttl);
+
+    // Sets whether outgoing multicast datagrams are looped back to this host
+    virtual bool setMulticastLoopback(bool enabled);
+
 private:
 
+    // Returns the time on 'pacing_clock' as seconds since 'pacing_epoch'
+    double getPacingTime() const;
+
+    // Works out when a datagram of 'size' bytes may go out if it's sent no
+    // sooner than 'now', and moves 'next' on past it
+    double schedule(unsigned int size, double now, double& next) const;
+
+    // Writes datagrams once they're due, as many at a time as are due
+    int writeUserPaced(const unsigned char* const* buffers,
+                       const unsigned int*         sizes,
+                       unsigned int                count);
+
+    // Writes datagrams straight away, each carrying its transmit time
+    int writeKernelPaced(const unsigned char* const* buffers,
+                         const unsigned int*         sizes,
+                         unsigned int                count);
+
+    // Matches the kernel's transmit timestamps up with the times datagrams
+    // were scheduled for, and accounts for the difference
+    void collectTransmitReports();
+
+    // Makes one of the protocol-independent multicast membership changes
+    // (MCAST_JOIN_GROUP and friends).  'source' is only used by the
+    // source-specific options.
+    bool changeMembership(int                option,
+                          const std::string& group,
+                          const std::string& source,
+                          const std::string& interface_name);
+
     // Descriptor for this socket
     int socket_fd;
 
@@ -74,17 +201,57 @@ private:
 
     double blocking_timeout;
 
+    // Whether or not this socket is in blocking mode; kept here so reads and
+    // writes don't have to ask the kernel
+    bool is_blocking;
+
+    // How long reads spin before blocking; 0 when not busy polling
+    double spin_time;
+
+    // Kernel receive timestamp of the last datagram read
+    PosixTimespec last_timestamp;
+
+    // Segment size of the last read; see PosixSocketCommon::read
+    unsigned int last_segment_size;
+
+    // Bytes per second writes are paced at; 0 when not pacing
+    double pacing_rate;
+
+    // How far (seconds) writes may run ahead of an even spread, which is how
+    // long the burst size takes to send
+    double pacing_credit;
+
+    // When the next datagram would go out if writes so far had been spread
+    // perfectly evenly
+    double pacing_next;
+
+    // Clock schedules are kept on; the one transmit times are on when the
+    // qdisc is pacing
+    clockid_t pacing_clock;
+
+    // Schedules are kept as seconds since this time (nanoseconds on
+    // 'pacing_clock'), since CLOCK_TAI is too far along for a double to hold
+    // it to the nanosecond
+    std::int64_t pacing_epoch;
+
+    bool kernel_pacing;
+
+    // Scheduled times of datagrams handed to the qdisc but not yet reported
+    // sent, oldest first.  The oldest was the 'pending_first'th written since
+    // kernel pacing began.
+    std::deque<double> pending_times;
+    std::uint32_t      pending_first;
+
+    // Most datagrams kept in 'pending_times'; reports of older ones are
+    // ignored
+    static const unsigned int PENDING_MAX = 65536;
+
     // Disallow these for now; maybe these could be meaningfully implemented but
     // we'll save that for later
     PosixUDPSocketImpl(const PosixUDPSocketImpl&);
     PosixUDPSocketImpl& operator=(const PosixUDPSocketImpl&);
 };
 
-inline void PosixUDPSocketImpl::setBlockingTimeout(double blocking_timeout)
-{
-    this->blocking_timeout = blocking_timeout;
-}
-
 inline double PosixUDPSocketImpl::getBlockingTimeout() const
 {
     return this->blocking_timeout;
@@ -96,4 +263,24 @@ void PosixUDPSocketImpl::getPeerAddress(std::string& peer_address_str) const
     peer_address_str = inet_ntoa(peer_address.sin_addr);
 }
 
+inline void PosixUDPSocketImpl::getLastTimestamp(PosixTimespec& timestamp) const
+{
+    timestamp = last_timestamp;
+}
+
+inline unsigned int PosixUDPSocketImpl::getLastSegmentSize() const
+{
+    return last_segment_size;
+}
+
+inline bool PosixUDPSocketImpl::isKernelPacing() const
+{
+    return kernel_pacing;
+}
+
+inline int PosixUDPSocketImpl::getDescriptor() const
+{
+    return socket_fd;
+}
+
 #endif
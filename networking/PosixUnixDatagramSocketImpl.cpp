@@ -0,0 +1,230 @@
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "PosixUnixDatagramSocketImpl.hpp"
+
+#include "PosixSocketCommon.hpp"
+#include "SocketKernelStatistics.hpp"
+
+//==============================================================================
+// Creates a POSIX Unix domain datagram socket
+//==============================================================================
+PosixUnixDatagramSocketImpl::PosixUnixDatagramSocketImpl() :
+    sendto_address_size(0),
+    blocking_timeout(0.0),
+    is_blocking(true)
+{
+    memset(&sendto_address, 0, sizeof(sendto_address));
+    memset(&peer_address,   0, sizeof(peer_address));
+
+    socket_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+
+    if (socket_fd == -1)
+    {
+        throw std::runtime_error(strerror(errno));
+    }
+}
+
+//==============================================================================
+// Shuts down this socket
+//==============================================================================
+PosixUnixDatagramSocketImpl::~PosixUnixDatagramSocketImpl()
+{
+    PosixSocketCommon::shutdown(socket_fd);
+
+    if (!bound_path.empty())
+    {
+        unlink(bound_path.c_str());
+    }
+}
+
+//==============================================================================
+// Enables blocking
+//==============================================================================
+bool PosixUnixDatagramSocketImpl::enableBlocking()
+{
+    if (!PosixSocketCommon::enableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = true;
+    return true;
+}
+
+//==============================================================================
+// Disables blocking
+//==============================================================================
+bool PosixUnixDatagramSocketImpl::disableBlocking()
+{
+    if (!PosixSocketCommon::disableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = false;
+    return true;
+}
+
+//==============================================================================
+// Has the kernel time out blocking reads and writes
+//==============================================================================
+void PosixUnixDatagramSocketImpl::setBlockingTimeout(double blocking_timeout)
+{
+    this->blocking_timeout = blocking_timeout;
+    PosixSocketCommon::setBlockingTimeout(socket_fd, blocking_timeout);
+}
+
+//==============================================================================
+// Binds this socket to a path
+//==============================================================================
+bool PosixUnixDatagramSocketImpl::bind(const std::string& path)
+{
+    sockaddr_un address;
+    socklen_t   address_size;
+
+    if (!PosixSocketCommon::setLocalAddress(path, address, address_size))
+    {
+        return false;
+    }
+
+    if (::bind(socket_fd,
+               reinterpret_cast<sockaddr*>(&address),
+               address_size) == -1)
+    {
+#if defined DEBUG
+        perror("PosixUnixDatagramSocketImpl::bind");
+#endif
+        return false;
+    }
+
+    // Only filesystem paths need cleaning up
+    if (address.sun_path[0] != '\0')
+    {
+        bound_path = path;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Reads data from socket into buffer
+//==============================================================================
+int PosixUnixDatagramSocketImpl::read(unsigned char* buffer, unsigned int size)
+{
+    return PosixSocketCommon::read(
+        socket_fd,
+        buffer,
+        size,
+        is_blocking,
+        blocking_timeout,
+        reinterpret_cast<sockaddr*>(&peer_address),
+        sizeof(sockaddr_un),
+        statistics,
+        0,
+        0);
+}
+
+//==============================================================================
+// Reads as many datagrams as are available, up to 'count'
+//==============================================================================
+int PosixUnixDatagramSocketImpl::readBatch(unsigned char** buffers,
+                                           unsigned int*   sizes,
+                                           unsigned int    count)
+{
+    return PosixSocketCommon::readBatch(
+        socket_fd,
+        buffers,
+        sizes,
+        count,
+        is_blocking,
+        blocking_timeout,
+        reinterpret_cast<sockaddr*>(&peer_address),
+        sizeof(sockaddr_un),
+        statistics,
+        0,
+        0);
+}
+
+//==============================================================================
+// Writes data from buffer into socket
+//==============================================================================
+int PosixUnixDatagramSocketImpl::write(const unsigned char* buffer,
+                                       unsigned int         size)
+{
+    return PosixSocketCommon::write(
+        socket_fd,
+        buffer,
+        size,
+        is_blocking,
+        blocking_timeout,
+        getSendToAddress(),
+        sendto_address_size,
+        statistics,
+        0);
+}
+
+//==============================================================================
+// Writes several datagrams at once
+//==============================================================================
+int PosixUnixDatagramSocketImpl::writeBatch(const unsigned char* const* buffers,
+                                            const unsigned int*         sizes,
+                                            unsigned int                count)
+{
+    return PosixSocketCommon::writeBatch(
+        socket_fd,
+        buffers,
+        sizes,
+        count,
+        is_blocking,
+        blocking_timeout,
+        getSendToAddress(),
+        sendto_address_size,
+        statistics);
+}
+
+//==============================================================================
+// Sets the destination of future writes
+//==============================================================================
+bool PosixUnixDatagramSocketImpl::sendTo(const std::string& path)
+{
+    sockaddr_un address;
+    socklen_t   address_size;
+
+    // Keep the old destination if the new one is no good
+    if (!PosixSocketCommon::setLocalAddress(path, address, address_size))
+    {
+        return false;
+    }
+
+    sendto_address      = address;
+    sendto_address_size = address_size;
+
+    return true;
+}
+
+//==============================================================================
+// Clears all the data out of this socket's receive buffer
+//==============================================================================
+void PosixUnixDatagramSocketImpl::clearBuffer()
+{
+    PosixSocketCommon::clearBuffer(socket_fd, statistics);
+}
+
+//==============================================================================
+// Retrieves queue depths from the kernel
+//==============================================================================
+bool PosixUnixDatagramSocketImpl::getKernelStatistics(
+    SocketKernelStatistics& kernel_statistics)
+{
+    kernel_statistics.reset();
+
+    return PosixSocketCommon::getKernelStatistics(
+        socket_fd, statistics, kernel_statistics);
+}
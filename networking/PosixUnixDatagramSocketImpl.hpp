@@ -0,0 +1,142 @@
+#if !defined POSIX_UNIX_DATAGRAM_SOCKET_IMPL_HPP
+#define POSIX_UNIX_DATAGRAM_SOCKET_IMPL_HPP
+
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "UnixDatagramSocketImpl.hpp"
+
+#include "PosixSocketCommon.hpp"
+
+// Defines a Unix domain datagram socket implementation specific to POSIX
+class PosixUnixDatagramSocketImpl : public UnixDatagramSocketImpl
+{
+public:
+
+    // Constructs a new POSIX Unix domain datagram socket
+    PosixUnixDatagramSocketImpl();
+
+    // Closes the associated socket, removing the path it was bound to if any
+    virtual ~PosixUnixDatagramSocketImpl();
+
+    // Enables blocking on reads and writes.
+    virtual bool enableBlocking();
+
+    // Disable blocking on reads and writes.
+    virtual bool disableBlocking();
+
+    // Returns whether or not this socket blocks.
+    virtual bool isBlockingEnabled();
+
+    // Enables a timeout of the given length (seconds) on blocking operations.
+    // A non-positive timeout value disables the blocking timeout.
+    virtual void setBlockingTimeout(double blocking_timeout);
+
+    // Returns the current blocking timeout (seconds).
+    virtual double getBlockingTimeout() const;
+
+    // Gives this socket the given path
+    virtual bool bind(const std::string& path);
+
+    // Reads the specified amount of data from this socket into the specified
+    // buffer.
+    virtual int read(unsigned char* buffer, unsigned int size);
+
+    // Writes the specified amount of data to this socket from the specified
+    // buffer.
+    virtual int write(const unsigned char* buffer, unsigned int size);
+
+    // Causes outgoing datagrams to be sent to the socket at the given path
+    virtual bool sendTo(const std::string& path);
+
+    // Gets the path of the socket that sent the last datagram read
+    virtual void getPeerPath(std::string& peer_path) const;
+
+    // Reads datagrams with recvmmsg() where available.  See
+    // PosixSocketCommon::readBatch for details.
+    virtual int readBatch(unsigned char** buffers,
+                          unsigned int*   sizes,
+                          unsigned int    count);
+
+    // Writes datagrams with sendmmsg() where available.  See
+    // PosixSocketCommon::writeBatch for details.
+    virtual int writeBatch(const unsigned char* const* buffers,
+                           const unsigned int*         sizes,
+                           unsigned int                count);
+
+    // Forces this socket to discard all received data
+    virtual void clearBuffer();
+
+    // Asks the kernel for its view of this socket (queue depths).  Returns
+    // false if none of this information could be retrieved.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics);
+
+    // Returns the descriptor for this socket
+    virtual int getDescriptor() const;
+
+private:
+
+    // Returns the destination set with sendTo, or 0 if there isn't one
+    sockaddr* getSendToAddress();
+
+    // Descriptor for this socket
+    int socket_fd;
+
+    // Filesystem path this socket was bound to, removed again on destruction;
+    // empty if unbound or bound in the abstract namespace
+    std::string bound_path;
+
+    // Where datagrams are sent with write; set with sendTo
+    sockaddr_un sendto_address;
+    socklen_t   sendto_address_size;
+
+    // Source address of the last datagram read
+    sockaddr_un peer_address;
+
+    double blocking_timeout;
+
+    // Whether or not this socket is in blocking mode; kept here so reads and
+    // writes don't have to ask the kernel
+    bool is_blocking;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    PosixUnixDatagramSocketImpl(const PosixUnixDatagramSocketImpl&);
+    PosixUnixDatagramSocketImpl& operator=(const PosixUnixDatagramSocketImpl&);
+};
+
+//==============================================================================
+inline bool PosixUnixDatagramSocketImpl::isBlockingEnabled()
+{
+    return is_blocking;
+}
+
+//==============================================================================
+inline double PosixUnixDatagramSocketImpl::getBlockingTimeout() const
+{
+    return blocking_timeout;
+}
+
+//==============================================================================
+inline void PosixUnixDatagramSocketImpl::getPeerPath(
+    std::string& peer_path) const
+{
+    peer_path = PosixSocketCommon::getLocalPath(peer_address);
+}
+
+//==============================================================================
+inline sockaddr* PosixUnixDatagramSocketImpl::getSendToAddress()
+{
+    return sendto_address_size > 0 ?
+        reinterpret_cast<sockaddr*>(&sendto_address) : 0;
+}
+
+//==============================================================================
+inline int PosixUnixDatagramSocketImpl::getDescriptor() const
+{
+    return socket_fd;
+}
+
+#endif
@@ -0,0 +1,320 @@
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "PosixUnixStreamSocketImpl.hpp"
+
+#include "PosixSocketCommon.hpp"
+#include "SocketKernelStatistics.hpp"
+
+//==============================================================================
+// Creates a POSIX Unix domain socket of the requested type
+//==============================================================================
+PosixUnixStreamSocketImpl::PosixUnixStreamSocketImpl(bool seqpacket) :
+    blocking_timeout(0.0),
+    is_blocking(true)
+{
+    socket_fd = socket(AF_UNIX, seqpacket ? SOCK_SEQPACKET : SOCK_STREAM, 0);
+
+    if (socket_fd == -1)
+    {
+        throw std::runtime_error(strerror(errno));
+    }
+}
+
+//==============================================================================
+// Wraps a socket returned by accept()
+//==============================================================================
+PosixUnixStreamSocketImpl::PosixUnixStreamSocketImpl(int    socket_fd,
+                                                     double blocking_timeout) :
+    socket_fd(socket_fd),
+    blocking_timeout(blocking_timeout),
+    is_blocking(PosixSocketCommon::isBlockingEnabled(socket_fd))
+{
+    // Accepted Unix domain sockets don't inherit the listener's timeouts
+    if (blocking_timeout > 0.0)
+    {
+        PosixSocketCommon::setBlockingTimeout(socket_fd, blocking_timeout);
+    }
+}
+
+//==============================================================================
+// Shuts this socket down
+//==============================================================================
+PosixUnixStreamSocketImpl::~PosixUnixStreamSocketImpl()
+{
+    PosixSocketCommon::shutdown(socket_fd);
+
+    if (!bound_path.empty())
+    {
+        unlink(bound_path.c_str());
+    }
+}
+
+//==============================================================================
+// Enables blocking
+//==============================================================================
+bool PosixUnixStreamSocketImpl::enableBlocking()
+{
+    if (!PosixSocketCommon::enableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = true;
+    return true;
+}
+
+//==============================================================================
+// Disables blocking
+//==============================================================================
+bool PosixUnixStreamSocketImpl::disableBlocking()
+{
+    if (!PosixSocketCommon::disableBlocking(socket_fd))
+    {
+        return false;
+    }
+
+    is_blocking = false;
+    return true;
+}
+
+//==============================================================================
+// Has the kernel time out blocking reads and writes
+//==============================================================================
+void PosixUnixStreamSocketImpl::setBlockingTimeout(double blocking_timeout)
+{
+    this->blocking_timeout = blocking_timeout;
+    PosixSocketCommon::setBlockingTimeout(socket_fd, blocking_timeout);
+}
+
+//==============================================================================
+// Binds this socket to a path
+//==============================================================================
+bool PosixUnixStreamSocketImpl::bind(const std::string& path)
+{
+    sockaddr_un address;
+    socklen_t   address_size;
+
+    if (!PosixSocketCommon::setLocalAddress(path, address, address_size))
+    {
+        return false;
+    }
+
+    if (::bind(socket_fd,
+               reinterpret_cast<sockaddr*>(&address),
+               address_size) == -1)
+    {
+#if defined DEBUG
+        perror("PosixUnixStreamSocketImpl::bind");
+#endif
+        return false;
+    }
+
+    // Only filesystem paths need cleaning up
+    if (address.sun_path[0] != '\0')
+    {
+        bound_path = path;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Flags this socket as one that will listen
+//==============================================================================
+bool PosixUnixStreamSocketImpl::listen(int backlog)
+{
+    if (::listen(socket_fd, backlog) == -1)
+    {
+#if defined DEBUG
+        perror("PosixUnixStreamSocketImpl::listen");
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Looks for any incoming connections
+//==============================================================================
+PosixUnixStreamSocketImpl* PosixUnixStreamSocketImpl::accept(bool take_over)
+{
+    // Any blocking timeout is handled by the kernel, as with TCP
+    int new_socket_fd = ::accept(socket_fd, 0, 0);
+
+    if (new_socket_fd == -1)
+    {
+#if defined DEBUG
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            perror("PosixUnixStreamSocketImpl::accept");
+        }
+#endif
+        return 0;
+    }
+
+    if (take_over)
+    {
+        // Carry the blocking mode and timeout over to the new descriptor
+        if (!is_blocking)
+        {
+            PosixSocketCommon::disableBlocking(new_socket_fd);
+        }
+
+        if (blocking_timeout > 0.0)
+        {
+            PosixSocketCommon::setBlockingTimeout(new_socket_fd,
+                                                  blocking_timeout);
+        }
+
+        // Start using the new descriptor.  The bound path, if any, is still
+        // removed when this socket goes away.
+        PosixSocketCommon::shutdown(socket_fd);
+        socket_fd = new_socket_fd;
+
+        return this;
+    }
+
+    // Make a new socket and return it; the user is responsible for getting rid
+    // of it
+    return new PosixUnixStreamSocketImpl(new_socket_fd, blocking_timeout);
+}
+
+//==============================================================================
+// Connects to the socket listening at the given path
+//==============================================================================
+bool PosixUnixStreamSocketImpl::connect(const std::string& path)
+{
+    sockaddr_un address;
+    socklen_t   address_size;
+
+    if (!PosixSocketCommon::setLocalAddress(path, address, address_size))
+    {
+        return false;
+    }
+
+    if (::connect(socket_fd,
+                  reinterpret_cast<sockaddr*>(&address),
+                  address_size) == -1)
+    {
+#if defined DEBUG
+        perror("PosixUnixStreamSocketImpl::connect");
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Returns whether or not this socket is connected to another
+//==============================================================================
+bool PosixUnixStreamSocketImpl::isConnected()
+{
+    // Same approach as PosixTCPSocketImpl; peek at a byte without removing it
+    char buf;
+    int ret = recv(socket_fd, &buf, 1, MSG_PEEK | MSG_DONTWAIT);
+
+    return !(ret == 0 || (ret == -1 && errno == ENOTCONN));
+}
+
+//==============================================================================
+// Reads data from socket into buffer
+//==============================================================================
+int PosixUnixStreamSocketImpl::read(unsigned char* buffer, unsigned int size)
+{
+    return PosixSocketCommon::read(
+        socket_fd,
+        buffer,
+        size,
+        is_blocking,
+        blocking_timeout,
+        0,
+        0,
+        statistics,
+        0,
+        0);
+}
+
+//==============================================================================
+// Writes data to socket
+//==============================================================================
+int PosixUnixStreamSocketImpl::write(const unsigned char* buffer,
+                                     unsigned int         size)
+{
+    return PosixSocketCommon::write(
+        socket_fd,
+        buffer,
+        size,
+        is_blocking,
+        blocking_timeout,
+        0,
+        0,
+        statistics,
+        0);
+}
+
+//==============================================================================
+// Writes data along with file descriptors
+//==============================================================================
+int PosixUnixStreamSocketImpl::writeDescriptors(const unsigned char* buffer,
+                                                unsigned int         size,
+                                                const int*           fds,
+                                                unsigned int         fd_count)
+{
+    return PosixSocketCommon::writeDescriptors(
+        socket_fd,
+        buffer,
+        size,
+        fds,
+        fd_count,
+        is_blocking,
+        blocking_timeout,
+        statistics);
+}
+
+//==============================================================================
+// Reads data along with any file descriptors sent with it
+//==============================================================================
+int PosixUnixStreamSocketImpl::readDescriptors(unsigned char* buffer,
+                                               unsigned int   size,
+                                               int*           fds,
+                                               unsigned int&  fd_count)
+{
+    return PosixSocketCommon::readDescriptors(
+        socket_fd,
+        buffer,
+        size,
+        fds,
+        fd_count,
+        is_blocking,
+        blocking_timeout,
+        statistics);
+}
+
+//==============================================================================
+// Clears socket of any received data
+//==============================================================================
+void PosixUnixStreamSocketImpl::clearBuffer()
+{
+    PosixSocketCommon::clearBuffer(socket_fd, statistics);
+}
+
+//==============================================================================
+// Retrieves queue depths from the kernel
+//==============================================================================
+bool PosixUnixStreamSocketImpl::getKernelStatistics(
+    SocketKernelStatistics& kernel_statistics)
+{
+    kernel_statistics.reset();
+
+    return PosixSocketCommon::getKernelStatistics(
+        socket_fd, statistics, kernel_statistics);
+}
@@ -0,0 +1,129 @@
+#if !defined POSIX_UNIX_STREAM_SOCKET_IMPL_HPP
+#define POSIX_UNIX_STREAM_SOCKET_IMPL_HPP
+
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "UnixStreamSocketImpl.hpp"
+
+// Defines a Unix domain stream (or sequenced packet) socket implementation
+// specific to POSIX
+class PosixUnixStreamSocketImpl : public UnixStreamSocketImpl
+{
+public:
+
+    // Creates a SOCK_SEQPACKET socket if 'seqpacket' is true, otherwise a
+    // SOCK_STREAM one
+    explicit PosixUnixStreamSocketImpl(bool seqpacket);
+
+    // Closes the associated socket, removing the path it was bound to if any
+    virtual ~PosixUnixStreamSocketImpl();
+
+    // Enables blocking on reads and writes.
+    virtual bool enableBlocking();
+
+    // Disables blocking on reads and writes.
+    virtual bool disableBlocking();
+
+    // Returns whether or not this socket blocks.
+    virtual bool isBlockingEnabled();
+
+    // Enables a timeout of the given length (seconds) on blocking operations.
+    // A non-positive timeout value disables the blocking timeout.
+    virtual void setBlockingTimeout(double blocking_timeout);
+
+    // Returns the current blocking timeout (seconds).
+    virtual double getBlockingTimeout() const;
+
+    // Gives this socket the given path
+    virtual bool bind(const std::string& path);
+
+    // Tells this socket to begin listening for incoming connection attempts,
+    // queueing up to 'backlog' of them.
+    virtual bool listen(int backlog);
+
+    // Accepts a connection request, should one be pending.  See
+    // TCPSocketImpl::accept for what 'take_over' does.
+    virtual PosixUnixStreamSocketImpl* accept(bool take_over = true);
+
+    // Connects this socket to the listening socket at the given path
+    virtual bool connect(const std::string& path);
+
+    // Returns whether or not this socket is connected to another.
+    virtual bool isConnected();
+
+    // Reads the specified amount of data from this socket into the specified
+    // buffer.
+    virtual int read(unsigned char* buffer, unsigned int size);
+
+    // Writes the specified amount of data to this socket from the specified
+    // buffer.
+    virtual int write(const unsigned char* buffer, unsigned int size);
+
+    // Writes data along with file descriptors (SCM_RIGHTS)
+    virtual int writeDescriptors(const unsigned char* buffer,
+                                 unsigned int         size,
+                                 const int*           fds,
+                                 unsigned int         fd_count);
+
+    // Reads data along with any file descriptors the peer sent
+    virtual int readDescriptors(unsigned char* buffer,
+                                unsigned int   size,
+                                int*           fds,
+                                unsigned int&  fd_count);
+
+    // Forces this socket to discard any received data.
+    virtual void clearBuffer();
+
+    // Asks the kernel for its view of this socket (queue depths).  Returns
+    // false if none of this information could be retrieved.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics);
+
+    // Returns the descriptor for this socket
+    virtual int getDescriptor() const;
+
+private:
+
+    // A special constructor used during accept; wraps a newly-accepted socket
+    PosixUnixStreamSocketImpl(int socket_fd, double blocking_timeout);
+
+    // Descriptor for this socket
+    int socket_fd;
+
+    // Filesystem path this socket was bound to, removed again on destruction;
+    // empty if unbound or bound in the abstract namespace
+    std::string bound_path;
+
+    double blocking_timeout;
+
+    // Whether or not this socket is in blocking mode; kept here so reads and
+    // writes don't have to ask the kernel
+    bool is_blocking;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    PosixUnixStreamSocketImpl(const PosixUnixStreamSocketImpl&);
+    PosixUnixStreamSocketImpl& operator=(const PosixUnixStreamSocketImpl&);
+};
+
+//==============================================================================
+inline bool PosixUnixStreamSocketImpl::isBlockingEnabled()
+{
+    return is_blocking;
+}
+
+//==============================================================================
+inline double PosixUnixStreamSocketImpl::getBlockingTimeout() const
+{
+    return blocking_timeout;
+}
+
+//==============================================================================
+inline int PosixUnixStreamSocketImpl::getDescriptor() const
+{
+    return socket_fd;
+}
+
+#endif
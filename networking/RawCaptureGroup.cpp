@@ -0,0 +1,369 @@
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "RawCaptureGroup.hpp"
+
+#include "PosixSocketCommon.hpp"
+#include "RawCaptureHandler.hpp"
+#include "SocketStatistics.hpp"
+
+const unsigned int RawCaptureGroup::READ_BATCH_SIZE;
+const unsigned int RawCaptureGroup::FRAME_SIZE_MAX;
+
+//==============================================================================
+// Saves the handler; nothing is opened until start()
+//==============================================================================
+RawCaptureGroup::RawCaptureGroup(RawCaptureHandler* handler) :
+    handler(handler),
+    group_id(-1),
+    stop_fd(-1),
+    running(false)
+{
+}
+
+//==============================================================================
+// Stops everything
+//==============================================================================
+RawCaptureGroup::~RawCaptureGroup()
+{
+    stop();
+}
+
+//==============================================================================
+// Opens all the sockets and starts their threads
+//==============================================================================
+bool RawCaptureGroup::start(const std::string&      interface_name,
+                            unsigned int            workers,
+                            Mode                    mode,
+                            const std::vector<int>& cores)
+{
+    if (running || workers == 0)
+    {
+        return false;
+    }
+
+    stop_fd = PosixSocketCommon::openStopEvent();
+    if (stop_fd == -1)
+    {
+        return false;
+    }
+
+    final_frame_counts.clear();
+    final_drop_counts.clear();
+
+    // Every socket is in the group before any thread starts, so the kernel
+    // has settled on how to split frames by the time anything is captured
+    group_id = -1;
+    for (unsigned int i = 0; i < workers; ++i)
+    {
+        Worker* worker = new Worker();
+        worker->socket_fd = -1;
+        worker->frame_count = 0;
+        worker->drop_count = 0;
+        this->workers.push_back(worker);
+
+        if (!openSocket(*worker, interface_name, mode))
+        {
+            stop();
+            return false;
+        }
+    }
+
+    running = true;
+
+    for (unsigned int i = 0; i < workers; ++i)
+    {
+        int core = cores.empty() ? -1 : cores[i % cores.size()];
+        this->workers[i]->thread =
+            std::thread(&RawCaptureGroup::captureLoop, this, i, core);
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Stops all the threads and closes all the sockets
+//==============================================================================
+void RawCaptureGroup::stop()
+{
+    if (stop_fd != -1)
+    {
+        PosixSocketCommon::signalStopEvent(stop_fd);
+    }
+
+    for (unsigned int i = 0; i < workers.size(); ++i)
+    {
+        if (workers[i]->thread.joinable())
+        {
+            workers[i]->thread.join();
+        }
+
+        if (workers[i]->socket_fd != -1)
+        {
+            close(workers[i]->socket_fd);
+        }
+
+        final_frame_counts.push_back(
+            workers[i]->frame_count.load(std::memory_order_relaxed));
+        final_drop_counts.push_back(
+            workers[i]->drop_count.load(std::memory_order_relaxed));
+
+        delete workers[i];
+    }
+
+    workers.clear();
+
+    if (stop_fd != -1)
+    {
+        close(stop_fd);
+        stop_fd = -1;
+    }
+
+    running = false;
+}
+
+//==============================================================================
+// Returns the given worker's frame count, or what it was when stopped
+//==============================================================================
+unsigned long RawCaptureGroup::getFrameCount(unsigned int worker) const
+{
+    if (worker < workers.size())
+    {
+        return workers[worker]->frame_count.load(std::memory_order_relaxed);
+    }
+
+    if (worker < final_frame_counts.size())
+    {
+        return final_frame_counts[worker];
+    }
+
+    return 0;
+}
+
+//==============================================================================
+// Returns the given worker's drop count, or what it was when stopped
+//==============================================================================
+unsigned long RawCaptureGroup::getDropCount(unsigned int worker) const
+{
+    if (worker < workers.size())
+    {
+        return workers[worker]->drop_count.load(std::memory_order_relaxed);
+    }
+
+    if (worker < final_drop_counts.size())
+    {
+        return final_drop_counts[worker];
+    }
+
+    return 0;
+}
+
+//==============================================================================
+// Creates and binds one socket and adds it to the fanout group
+//==============================================================================
+bool RawCaptureGroup::openSocket(Worker&            worker,
+                                 const std::string& interface_name,
+                                 Mode               mode)
+{
+    // Protocol 0 receives nothing until bound.  The kernel only lets a bound
+    // socket join a fanout group though, so frames can still arrive between
+    // bind() and joining; those are thrown away below.
+    worker.socket_fd =
+        socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (worker.socket_fd == -1)
+    {
+#if defined DEBUG
+        perror("RawCaptureGroup::openSocket");
+#endif
+        return false;
+    }
+
+    sockaddr_ll address;
+    memset(&address, 0, sizeof(address));
+    address.sll_family   = AF_PACKET;
+    address.sll_protocol = htons(ETH_P_ALL);
+    address.sll_ifindex  = 0;
+
+    if (!interface_name.empty())
+    {
+        address.sll_ifindex = if_nametoindex(interface_name.c_str());
+        if (address.sll_ifindex == 0)
+        {
+#if defined DEBUG
+            perror("RawCaptureGroup::openSocket");
+#endif
+            return false;
+        }
+    }
+
+    if (bind(worker.socket_fd,
+             reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) == -1)
+    {
+#if defined DEBUG
+        perror("RawCaptureGroup::openSocket");
+#endif
+        return false;
+    }
+
+    // The drop count comes back alongside received frames
+    PosixSocketCommon::enableDropReporting(worker.socket_fd);
+
+    int fanout = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+    if (mode == CPU)
+    {
+        fanout = PACKET_FANOUT_CPU;
+    }
+    else if (mode == LOAD_BALANCE)
+    {
+        fanout = PACKET_FANOUT_LB;
+    }
+
+    // Group IDs are shared by everything in the network namespace, so the
+    // first socket has the kernel pick one nobody else is using and the rest
+    // join that.  The mode goes in the upper 16 bits.
+    int option = fanout << 16;
+    if (group_id == -1)
+    {
+        option |= PACKET_FANOUT_FLAG_UNIQUEID << 16;
+    }
+    else
+    {
+        option |= group_id;
+    }
+
+    if (setsockopt(worker.socket_fd,
+                   SOL_PACKET,
+                   PACKET_FANOUT,
+                   &option,
+                   sizeof(option)) == -1)
+    {
+#if defined DEBUG
+        perror("RawCaptureGroup::openSocket");
+#endif
+        return false;
+    }
+
+    if (group_id == -1)
+    {
+        socklen_t option_size = sizeof(option);
+        if (getsockopt(worker.socket_fd,
+                       SOL_PACKET,
+                       PACKET_FANOUT,
+                       &option,
+                       &option_size) == -1)
+        {
+#if defined DEBUG
+            perror("RawCaptureGroup::openSocket");
+#endif
+            return false;
+        }
+
+        group_id = option & 0xffff;
+    }
+
+    // Anything queued so far came in before the socket joined the group, so
+    // other sockets may see the same frames.  A zero-length read still takes
+    // the whole frame off the queue.
+    while (recv(worker.socket_fd, 0, 0, MSG_DONTWAIT) != -1)
+    {
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Waits for frames and hands them off until told to stop
+//==============================================================================
+void RawCaptureGroup::captureLoop(unsigned int worker_index, int core)
+{
+    // Pinned from in here so nothing runs on the wrong core first
+    if (core >= 0)
+    {
+        PosixSocketCommon::pinThread(core);
+    }
+
+    Worker& worker = *workers[worker_index];
+
+    std::vector<unsigned char> storage(READ_BATCH_SIZE * FRAME_SIZE_MAX);
+    unsigned char*             buffers[READ_BATCH_SIZE];
+    unsigned int               sizes[READ_BATCH_SIZE];
+    SocketStatistics           statistics;
+
+    for (unsigned int i = 0; i < READ_BATCH_SIZE; ++i)
+    {
+        buffers[i] = &storage[i * FRAME_SIZE_MAX];
+    }
+
+    pollfd polldata[2];
+    polldata[0].fd     = worker.socket_fd;
+    polldata[0].events = POLLIN;
+    polldata[1].fd     = stop_fd;
+    polldata[1].events = POLLIN;
+
+    while (true)
+    {
+        if (poll(polldata, 2, -1) == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+#if defined DEBUG
+            perror("RawCaptureGroup::captureLoop");
+#endif
+            return;
+        }
+
+        if (polldata[1].revents != 0)
+        {
+            return;
+        }
+
+        // Take as many frames as are queued, up to a batch, in one system
+        // call before polling again
+        for (unsigned int i = 0; i < READ_BATCH_SIZE; ++i)
+        {
+            sizes[i] = FRAME_SIZE_MAX;
+        }
+
+        int frames = PosixSocketCommon::readBatch(worker.socket_fd,
+                                                  buffers,
+                                                  sizes,
+                                                  READ_BATCH_SIZE,
+                                                  false,
+                                                  0.0,
+                                                  0,
+                                                  0,
+                                                  statistics,
+                                                  0,
+                                                  0);
+
+        if (frames <= 0)
+        {
+            continue;
+        }
+
+        worker.frame_count.fetch_add(frames, std::memory_order_relaxed);
+        worker.drop_count.store(statistics.getReceiveDrops(),
+                                std::memory_order_relaxed);
+
+        for (int i = 0; i < frames; ++i)
+        {
+            handler->handleFrame(buffers[i], sizes[i], worker_index);
+        }
+    }
+}
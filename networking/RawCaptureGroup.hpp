@@ -0,0 +1,134 @@
+#if !defined RAW_CAPTURE_GROUP_HPP
+#define RAW_CAPTURE_GROUP_HPP
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+class RawCaptureHandler;
+
+// Captures frames from one interface using several raw sockets at once.  The
+// sockets are joined into a PACKET_FANOUT group so the kernel splits incoming
+// frames between them, and each is serviced by its own thread, optionally
+// pinned to a CPU core.  Threads drain their socket in batches with recvmmsg()
+// and hand every frame to a RawCaptureHandler.  Needs CAP_NET_RAW.  Linux only.
+class RawCaptureGroup
+{
+public:
+
+    // How the kernel picks a worker for each frame
+    enum Mode
+    {
+        // By a hash of the frame's flow (addresses, ports and protocol), so
+        // every frame of a flow goes to the same worker.  IP fragments are
+        // reassembled before hashing so they follow their flow too.
+        HASH,
+
+        // By the CPU the frame arrived on, which keeps the work on the core
+        // that took the interrupt when workers are pinned to match
+        CPU,
+
+        // Round-robin, for the most even spread when flows don't matter
+        LOAD_BALANCE
+    };
+
+    // Captured frames are given to 'handler', which must outlive this object.
+    explicit RawCaptureGroup(RawCaptureHandler* handler);
+
+    // Calls stop()
+    ~RawCaptureGroup();
+
+    // Opens 'workers' raw sockets on the named interface (empty for every
+    // interface), joins them into a new fanout group and starts a thread for
+    // each.  If 'cores' is non-empty, thread i is pinned to core
+    // cores[i % cores.size()].  Returns false if any socket couldn't be set
+    // up, in which case nothing is left running.
+    bool start(const std::string&      interface_name,
+               unsigned int            workers,
+               Mode                    mode  = HASH,
+               const std::vector<int>& cores = std::vector<int>());
+
+    // Stops all threads and closes all sockets
+    void stop();
+
+    // Returns true between a successful start() and the following stop()
+    bool isRunning() const;
+
+    // Returns the number of workers currently running
+    unsigned int getWorkerCount() const;
+
+    // Returns the number of frames the given worker has captured since the
+    // last start().  Still available after stop().
+    unsigned long getFrameCount(unsigned int worker) const;
+
+    // Returns the number of frames the kernel has dropped because the given
+    // worker's socket was full, as of the last frame the worker captured.
+    // Still available after stop().
+    unsigned long getDropCount(unsigned int worker) const;
+
+    // Most frames captured in one go before a worker goes back to poll()
+    static const unsigned int READ_BATCH_SIZE = 32;
+
+    // Longest frame captured in full; enough for anything the kernel's
+    // receive offloads can build
+    static const unsigned int FRAME_SIZE_MAX = 65536;
+
+private:
+
+    // State owned by each socket and its thread
+    struct Worker
+    {
+        int                        socket_fd;
+        std::thread                thread;
+        std::atomic<unsigned long> frame_count;
+        std::atomic<unsigned long> drop_count;
+    };
+
+    // Creates and binds one socket, adds it to the fanout group and throws
+    // away anything it picked up before joining.  The first call picks the
+    // group ID.
+    bool openSocket(Worker&            worker,
+                    const std::string& interface_name,
+                    Mode               mode);
+
+    // Body of each worker's thread, which first pins itself to 'core' unless
+    // it's negative
+    void captureLoop(unsigned int worker_index, int core);
+
+    RawCaptureHandler* handler;
+
+    // Owned by this class; Worker isn't movable so these are held by pointer
+    std::vector<Worker*> workers;
+
+    // Each worker's counts as stop() found them, for after it's gone
+    std::vector<unsigned long> final_frame_counts;
+    std::vector<unsigned long> final_drop_counts;
+
+    // Fanout group the sockets share, or -1 before the first has joined
+    int group_id;
+
+    // Written to by stop() to wake every thread up
+    int stop_fd;
+
+    bool running;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    RawCaptureGroup(const RawCaptureGroup&);
+    RawCaptureGroup& operator=(const RawCaptureGroup&);
+};
+
+//==============================================================================
+inline bool RawCaptureGroup::isRunning() const
+{
+    return running;
+}
+
+//==============================================================================
+inline unsigned int RawCaptureGroup::getWorkerCount() const
+{
+    return workers.size();
+}
+
+#endif
@@ -0,0 +1,288 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "RawCaptureGroup_test.hpp"
+
+#include "RawCaptureGroup.hpp"
+#include "RawCaptureHandler.hpp"
+#include "RawSocket.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+#include "UDPSocket.hpp"
+
+TEST_PROGRAM_MAIN(RawCaptureGroup_test);
+
+// Notes which worker saw each UDP flow headed for one port.  Loopback frames
+// have an all-zero Ethernet header followed by IPv4.
+class FlowRecorder : public RawCaptureHandler
+{
+public:
+
+    FlowRecorder(unsigned int port, unsigned int workers) :
+        matched(0),
+        port(port),
+        flows(workers)
+    {
+    }
+
+    virtual void handleFrame(const unsigned char* frame,
+                             unsigned int         size,
+                             unsigned int         worker)
+    {
+        // IPv4 carrying UDP
+        if (size < 42 || frame[12] != 0x08 || frame[13] != 0x00 ||
+            frame[23] != 17)
+        {
+            return;
+        }
+
+        unsigned int udp = 14 + (frame[14] & 0x0f) * 4;
+        if (size < udp + 8)
+        {
+            return;
+        }
+
+        unsigned int source      = frame[udp] << 8 | frame[udp + 1];
+        unsigned int destination = frame[udp + 2] << 8 | frame[udp + 3];
+
+        if (destination == port)
+        {
+            // Each worker only ever touches its own set
+            flows[worker].insert(source);
+            ++matched;
+        }
+    }
+
+    std::atomic<unsigned int> matched;
+
+    unsigned int port;
+
+    // Source ports seen by each worker
+    std::vector<std::set<unsigned int> > flows;
+};
+
+//==============================================================================
+void RawCaptureGroup_test::addTestCases()
+{
+    ADD_TEST_CASE(FlowsStayTogether);
+    ADD_TEST_CASE(LoadBalance);
+    ADD_TEST_CASE(StartStop);
+}
+
+//==============================================================================
+// Returns true if raw sockets can be opened here
+//==============================================================================
+static bool rawSocketsPermitted()
+{
+    try
+    {
+        RawSocket raw_socket;
+    }
+    catch (std::runtime_error&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Waits up to two seconds for 'recorder' to have matched 'count' frames
+//==============================================================================
+static void waitForFrames(FlowRecorder& recorder, unsigned int count)
+{
+    for (unsigned int i = 0; i < 200 && recorder.matched < count; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+//==============================================================================
+Test::Result RawCaptureGroup_test::FlowsStayTogether::body()
+{
+    // Capturing needs CAP_NET_RAW
+    SKIP_IF_FALSE(rawSocketsPermitted());
+
+    const unsigned int WORKERS   = 4;
+    const unsigned int FLOWS     = 32;
+    const unsigned int DATAGRAMS = 8;
+
+    unsigned int port = 0;
+    UDPSocket receiver;
+    MUST_BE_TRUE(receiver.bind(port));
+
+    FlowRecorder recorder(port, WORKERS);
+    RawCaptureGroup group(&recorder);
+    MUST_BE_TRUE(group.start("lo", WORKERS, RawCaptureGroup::HASH));
+    MUST_BE_TRUE(group.isRunning());
+    MUST_BE_TRUE(group.getWorkerCount() == WORKERS);
+
+    // Each sender is its own flow
+    std::vector<UDPSocket*> senders;
+    for (unsigned int i = 0; i < FLOWS; ++i)
+    {
+        unsigned int sender_port = 0;
+        senders.push_back(new UDPSocket());
+        MUST_BE_TRUE(senders.back()->bind(sender_port));
+        MUST_BE_TRUE(senders.back()->sendTo("127.0.0.1", port));
+    }
+
+    unsigned char buffer[16] = {0};
+    for (unsigned int i = 0; i < DATAGRAMS; ++i)
+    {
+        for (unsigned int j = 0; j < senders.size(); ++j)
+        {
+            MUST_BE_TRUE(senders[j]->write(buffer, sizeof(buffer)) ==
+                         static_cast<int>(sizeof(buffer)));
+        }
+    }
+
+    // Loopback frames are seen once going out and once coming back in
+    waitForFrames(recorder, FLOWS * DATAGRAMS * 2);
+
+    for (unsigned int i = 0; i < senders.size(); ++i)
+    {
+        delete senders[i];
+    }
+
+    group.stop();
+    MUST_BE_FALSE(group.isRunning());
+
+    // Counts outlive the workers
+    std::vector<unsigned long> frames;
+    std::vector<unsigned long> drops;
+    for (unsigned int i = 0; i < WORKERS; ++i)
+    {
+        frames.push_back(group.getFrameCount(i));
+        drops.push_back(group.getDropCount(i));
+    }
+
+    unsigned long total = 0;
+    unsigned int  busy  = 0;
+    for (unsigned int i = 0; i < WORKERS; ++i)
+    {
+        std::cout << "Worker " << i << " captured " << frames[i]
+                  << " frames (" << recorder.flows[i].size() << " flows), "
+                  << drops[i] << " dropped\n";
+        total += frames[i];
+        busy  += !recorder.flows[i].empty();
+    }
+
+    MUST_BE_TRUE(recorder.matched == FLOWS * DATAGRAMS * 2);
+    MUST_BE_TRUE(total >= FLOWS * DATAGRAMS * 2);
+
+    // No flow was seen by more than one worker
+    std::set<unsigned int> seen;
+    for (unsigned int i = 0; i < WORKERS; ++i)
+    {
+        for (std::set<unsigned int>::const_iterator j =
+                 recorder.flows[i].begin();
+             j != recorder.flows[i].end();
+             ++j)
+        {
+            MUST_BE_TRUE(seen.insert(*j).second);
+        }
+    }
+
+    MUST_BE_TRUE(seen.size() == FLOWS);
+
+    // With this many flows, the odds of them all hashing to one worker are
+    // negligible
+    MUST_BE_TRUE(busy > 1);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result RawCaptureGroup_test::LoadBalance::body()
+{
+    SKIP_IF_FALSE(rawSocketsPermitted());
+
+    const unsigned int WORKERS   = 4;
+    const unsigned int DATAGRAMS = 200;
+
+    unsigned int port = 0;
+    UDPSocket receiver;
+    MUST_BE_TRUE(receiver.bind(port));
+
+    FlowRecorder recorder(port, WORKERS);
+    RawCaptureGroup group(&recorder);
+    MUST_BE_TRUE(group.start("lo", WORKERS, RawCaptureGroup::LOAD_BALANCE));
+
+    // A single flow, which load balancing spreads over every worker anyway
+    unsigned int sender_port = 0;
+    UDPSocket sender;
+    MUST_BE_TRUE(sender.bind(sender_port));
+    MUST_BE_TRUE(sender.sendTo("127.0.0.1", port));
+
+    unsigned char buffer[16] = {0};
+    for (unsigned int i = 0; i < DATAGRAMS; ++i)
+    {
+        MUST_BE_TRUE(sender.write(buffer, sizeof(buffer)) ==
+                     static_cast<int>(sizeof(buffer)));
+    }
+
+    waitForFrames(recorder, DATAGRAMS * 2);
+
+    std::vector<unsigned long> frames;
+    for (unsigned int i = 0; i < WORKERS; ++i)
+    {
+        frames.push_back(group.getFrameCount(i));
+    }
+
+    group.stop();
+
+    // Every worker got a share of the one flow
+    for (unsigned int i = 0; i < WORKERS; ++i)
+    {
+        std::cout << "Worker " << i << " captured " << frames[i]
+                  << " frames\n";
+        MUST_BE_TRUE(recorder.flows[i].size() == 1);
+    }
+
+    MUST_BE_TRUE(recorder.matched == DATAGRAMS * 2);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result RawCaptureGroup_test::StartStop::body()
+{
+    SKIP_IF_FALSE(rawSocketsPermitted());
+
+    FlowRecorder recorder(0, 2);
+    RawCaptureGroup group(&recorder);
+
+    // Zero workers makes no sense, and neither does a missing interface
+    MUST_BE_FALSE(group.start("lo", 0));
+    MUST_BE_FALSE(group.start("no-such-interface", 2));
+    MUST_BE_FALSE(group.isRunning());
+    MUST_BE_TRUE(group.getWorkerCount() == 0);
+
+    // Should be able to go around more than once, pinned or not, and run two
+    // groups side by side without them sharing frames
+    std::vector<int> cores(1, 0);
+    MUST_BE_TRUE(group.start("lo", 2, RawCaptureGroup::CPU, cores));
+    MUST_BE_FALSE(group.start("lo", 2));
+
+    RawCaptureGroup other(&recorder);
+    MUST_BE_TRUE(other.start("", 2));
+    other.stop();
+
+    group.stop();
+
+    MUST_BE_TRUE(group.start("lo", 2));
+    group.stop();
+
+    MUST_BE_TRUE(group.getWorkerCount() == 0);
+    MUST_BE_TRUE(group.getFrameCount(2) == 0);
+    MUST_BE_TRUE(group.getDropCount(2) == 0);
+
+    return Test::PASSED;
+}
@@ -0,0 +1,16 @@
+#if !defined RAW_CAPTURE_GROUP_TEST
+#define RAW_CAPTURE_GROUP_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(RawCaptureGroup_test)
+
+    TEST(FlowsStayTogether)
+    TEST(LoadBalance)
+    TEST(StartStop)
+
+TEST_CASES_END(RawCaptureGroup_test)
+
+#endif
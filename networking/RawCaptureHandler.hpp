@@ -0,0 +1,23 @@
+#if !defined RAW_CAPTURE_HANDLER_HPP
+#define RAW_CAPTURE_HANDLER_HPP
+
+// Receives frames captured by a RawCaptureGroup.  Implementations are called
+// from capture worker threads, several at once, so anything shared between
+// calls must be protected accordingly; anything kept per worker needs no
+// protection since each worker only ever calls in from its own thread.
+class RawCaptureHandler
+{
+public:
+
+    virtual ~RawCaptureHandler() {}
+
+    // Called once for every captured frame.  'frame' starts at the link-layer
+    // header and is only valid until this returns.  Frames longer than
+    // RawCaptureGroup::FRAME_SIZE_MAX are cut short.  'worker' is the index of
+    // the worker that captured the frame.
+    virtual void handleFrame(const unsigned char* frame,
+                             unsigned int         size,
+                             unsigned int         worker) = 0;
+};
+
+#endif
@@ -85,3 +85,89 @@ void RawSocket::getOutputInterface(std::string& interface_name)
         socket_impl->getOutputInterface(interface_name);
     }
 }
+
+//==============================================================================
+// Calls implementation-specific enableTimestamps
+//==============================================================================
+bool RawSocket::enableTimestamps()
+{
+    if (socket_impl)
+    {
+        return socket_impl->enableTimestamps();
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific getLastTimestamp
+//==============================================================================
+void RawSocket::getLastTimestamp(PosixTimespec& timestamp) const
+{
+    if (socket_impl)
+    {
+        socket_impl->getLastTimestamp(timestamp);
+    }
+}
+
+//==============================================================================
+// Calls implementation-specific readBatch
+//==============================================================================
+int RawSocket::readBatch(unsigned char** buffers,
+                        unsigned int*   sizes,
+                        unsigned int    count,
+                        PosixTimespec*  timestamps,
+                        unsigned int*   wire_sizes)
+{
+    if (socket_impl)
+    {
+        return socket_impl->readBatch(buffers,
+                                      sizes,
+                                      count,
+                                      timestamps,
+                                      wire_sizes);
+    }
+
+    return -1;
+}
+
+//==============================================================================
+// Calls implementation-specific enableBusyPoll
+//==============================================================================
+bool RawSocket::enableBusyPoll(double spin_time, int core)
+{
+    if (socket_impl)
+    {
+        return socket_impl->enableBusyPoll(spin_time, core);
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific disableBusyPoll
+//==============================================================================
+bool RawSocket::disableBusyPoll()
+{
+    if (socket_impl)
+    {
+        return socket_impl->disableBusyPoll();
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific writeBatch
+//==============================================================================
+int RawSocket::writeBatch(const unsigned char* const* buffers,
+                          const unsigned int*         sizes,
+                          unsigned int                count)
+{
+    if (socket_impl)
+    {
+        return socket_impl->writeBatch(buffers, sizes, count);
+    }
+
+    return -1;
+}
@@ -5,6 +5,7 @@
 
 #include "Socket.hpp"
 
+class PosixTimespec;
 class RawSocketImpl;
 
 class RawSocket : public Socket
@@ -31,6 +32,59 @@ public:
     // Retrieves the name of the interface data will be sent from
     virtual void getOutputInterface(std::string& interface_name);
 
+    // Has the kernel timestamp every frame as it's received, so that
+    // getLastTimestamp() and readBatch() can report when each frame actually
+    // arrived rather than when it was read.  Returns false if this isn't
+    // supported.
+    bool enableTimestamps();
+
+    // Gets the kernel receive timestamp of the last frame read.  Left
+    // unmodified if timestamps aren't enabled or supported.
+    void getLastTimestamp(PosixTimespec& timestamp) const;
+
+    // Reads up to 'count' frames with as few system calls as possible,
+    // waiting (subject to blocking settings) only for the first.  Frame i
+    // goes into 'buffers[i]', which has room for 'sizes[i]' bytes; on return
+    // 'sizes[i]' holds the length actually read.  If 'timestamps' is non-zero
+    // 'timestamps[i]' receives the kernel receive timestamp of frame i.  If
+    // 'wire_sizes' is non-zero 'wire_sizes[i]' receives the length frame i
+    // had on the wire, which is more than 'sizes[i]' if it was cut short to
+    // fit its buffer.  Returns the number of frames read, 0 on timeout, -1 on
+    // error.
+    int readBatch(unsigned char** buffers,
+                  unsigned int*   sizes,
+                  unsigned int    count,
+                  PosixTimespec*  timestamps = 0,
+                  unsigned int*   wire_sizes = 0);
+
+    // Puts the socket in busy-poll receive mode, for when latency matters
+    // more than CPU time.  Blocking reads first spin on non-blocking reads for
+    // up to 'spin_time' seconds, and only if nothing arrives in that time
+    // block as usual, so an idle socket doesn't keep a core busy; the spin
+    // comes on top of any blocking timeout.  Non-blocking sockets read as
+    // before.  Where it's allowed the kernel also polls the device for data
+    // during reads rather than waiting on an interrupt (SO_BUSY_POLL and
+    // SO_PREFER_BUSY_POLL, which may need CAP_NET_ADMIN).  Receive timestamps
+    // are turned on so the statistics report delivery latency, the time from
+    // a frame arriving to a read handing it over.  If 'core' isn't negative
+    // the calling thread, which should be the one reading, is pinned to that
+    // core.  Returns false if 'spin_time' isn't positive, the thread couldn't
+    // be pinned or busy polling isn't supported.
+    bool enableBusyPoll(double spin_time, int core = -1);
+
+    // Goes back to blocking straight away on reads.  The reading thread stays
+    // pinned.
+    bool disableBusyPoll();
+
+    // Writes up to 'count' frames from the output interface with as few
+    // system calls as possible, frame i being 'buffers[i]' and 'sizes[i]'
+    // bytes long.  Returns the number of frames written, which may be fewer
+    // than 'count' if the interface's queue fills, 0 if the blocking timeout
+    // expired before any were written, or -1 on error.
+    int writeBatch(const unsigned char* const* buffers,
+                   const unsigned int*         sizes,
+                   unsigned int                count);
+
 protected:
 
     // Sets the platform-specific socket implementation to use
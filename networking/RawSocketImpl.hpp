@@ -5,6 +5,8 @@
 
 #include "SocketImpl.hpp"
 
+class PosixTimespec;
+
 class RawSocketImpl : public SocketImpl
 {
 public:
@@ -29,6 +31,41 @@ public:
     // Retrieves the name of the interface data will be sent from
     virtual void getOutputInterface(std::string& interface_name) = 0;
 
+    // Has the kernel timestamp every frame as it's received.  Returns false
+    // if this isn't supported.
+    virtual bool enableTimestamps() = 0;
+
+    // Gets the kernel receive timestamp of the last frame read.  Left
+    // unmodified if timestamps aren't enabled or supported.
+    virtual void getLastTimestamp(PosixTimespec& timestamp) const = 0;
+
+    // Reads up to 'count' frames, waiting only for the first.  Frame i
+    // goes into 'buffers[i]', which has room for 'sizes[i]' bytes; on return
+    // 'sizes[i]' holds the length actually read.  If 'timestamps' is non-zero
+    // 'timestamps[i]' receives the kernel receive timestamp of frame i, and
+    // 'wire_sizes[i]', if given, the length frame i had on the wire.
+    // Returns the number of frames read, 0 on timeout, -1 on error.
+    virtual int readBatch(unsigned char** buffers,
+                          unsigned int*   sizes,
+                          unsigned int    count,
+                          PosixTimespec*  timestamps,
+                          unsigned int*   wire_sizes) = 0;
+
+    // Spins on non-blocking reads for up to 'spin_time' seconds before
+    // blocking, with the kernel busy polling where it's allowed to, and pins
+    // the calling thread to 'core' unless it's negative
+    virtual bool enableBusyPoll(double spin_time, int core) = 0;
+
+    // Goes back to blocking straight away on reads
+    virtual bool disableBusyPoll() = 0;
+
+    // Writes up to 'count' frames with as few system calls as possible, frame
+    // i being 'buffers[i]' and 'sizes[i]' bytes long.  Returns the number of
+    // frames written, 0 on timeout, -1 on error.
+    virtual int writeBatch(const unsigned char* const* buffers,
+                           const unsigned int*         sizes,
+                           unsigned int                count) = 0;
+
 private:
 
     // Disallow these for now; maybe these could be meaningfully implemented but
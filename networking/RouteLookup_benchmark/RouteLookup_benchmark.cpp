@@ -0,0 +1,224 @@
+// Measures how fast Ipv4RoutingTable finds the longest prefix match for an
+// address, one address at a time and in batches, with a linear scan over the
+// same prefixes for comparison at smaller table sizes.  Prefixes are random,
+// with lengths spread roughly as in an Internet routing table: mostly /24s,
+// many /16 to /23s and some longer ones.  Lookups are of random addresses in
+// the space the prefixes cover, so the first level is missed in the cache
+// about as often as it would be with real traffic.  Adding and removing all
+// the prefixes is timed too.
+//
+// Usage: RouteLookup_benchmark [prefix count]
+
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Ipv4Prefix.hpp"
+#include "Ipv4RoutingTable.hpp"
+#include "PosixSocketCommon.hpp"
+
+// Addresses looked up per case, each case run this many times
+static const unsigned int LOOKUPS = 1 << 22;
+static const unsigned int PASSES  = 3;
+
+// Linear scans are only tried up to this many prefixes
+static const unsigned int SCAN_PREFIXES_MAX = 4096;
+
+//==============================================================================
+// Returns a random 32-bit number
+//==============================================================================
+static std::uint32_t random32()
+{
+    return static_cast<std::uint32_t>(rand()) << 16 ^ rand();
+}
+
+//==============================================================================
+// Returns a random prefix length, mostly 24
+//==============================================================================
+static unsigned int randomLength()
+{
+    unsigned int roll = rand() % 100;
+    if (roll < 60)
+    {
+        return 24;
+    }
+    else if (roll < 95)
+    {
+        return 16 + rand() % 8;
+    }
+
+    return 25 + rand() % 8;
+}
+
+//==============================================================================
+// Finds the longest match by looking at every prefix
+//==============================================================================
+static bool scan(const std::vector<Ipv4Prefix>&    prefixes,
+                 const std::vector<std::uint32_t>& values,
+                 std::uint32_t                     address,
+                 std::uint32_t&                    value)
+{
+    int best = -1;
+    for (unsigned int i = 0; i < prefixes.size(); ++i)
+    {
+        if (prefixes[i].contains(address) &&
+            (best < 0 || prefixes[i].getLength() >
+             prefixes[static_cast<unsigned int>(best)].getLength()))
+        {
+            best = static_cast<int>(i);
+        }
+    }
+
+    if (best < 0)
+    {
+        return false;
+    }
+
+    value = values[static_cast<unsigned int>(best)];
+    return true;
+}
+
+//==============================================================================
+// Prints one line of results
+//==============================================================================
+static void report(const std::string& name,
+                   unsigned int       operations,
+                   double             elapsed,
+                   unsigned long      found)
+{
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::fixed << std::setprecision(2)
+              << std::setw(14) << operations / elapsed / 1.0e6
+              << std::setw(14) << elapsed / operations * 1.0e9
+              << std::setw(12) << found << "\n";
+}
+
+//==============================================================================
+// Runs every case against a table of 'count' prefixes
+//==============================================================================
+static void run(unsigned int count)
+{
+    srand(45);
+
+    std::vector<Ipv4Prefix>    prefixes;
+    std::vector<std::uint32_t> values;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        prefixes.push_back(Ipv4Prefix(random32(), randomLength()));
+        values.push_back(i & Ipv4RoutingTable::VALUE_MAX);
+    }
+
+    std::vector<std::uint32_t> addresses(LOOKUPS);
+    for (unsigned int i = 0; i < LOOKUPS; ++i)
+    {
+        addresses[i] = random32();
+    }
+
+    std::cout << "\n" << count << " prefixes\n";
+
+    Ipv4RoutingTable table(65536);
+
+    double start = PosixSocketCommon::getMonotonicSeconds();
+    unsigned int inserted = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        inserted += table.insert(prefixes[i], values[i]);
+    }
+    report("insert",
+           count,
+           PosixSocketCommon::getMonotonicSeconds() - start,
+           inserted);
+
+    // Both kinds of lookup store every result, so they do the same work
+    std::vector<std::uint32_t> results(LOOKUPS);
+
+    double best = 0.0;
+    unsigned long found = 0;
+    for (unsigned int pass = 0; pass < PASSES; ++pass)
+    {
+        found = 0;
+        start = PosixSocketCommon::getMonotonicSeconds();
+        for (unsigned int i = 0; i < LOOKUPS; ++i)
+        {
+            std::uint32_t value;
+            bool hit = table.lookup(addresses[i], value);
+            results[i] = hit ? value : 0;
+            found += hit;
+        }
+
+        double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+        best = pass == 0 || elapsed < best ? elapsed : best;
+    }
+    report("lookup", LOOKUPS, best, found);
+
+    for (unsigned int pass = 0; pass < PASSES; ++pass)
+    {
+        start = PosixSocketCommon::getMonotonicSeconds();
+        found = table.lookup(&addresses[0], &results[0], LOOKUPS, 0);
+
+        double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+        best = pass == 0 || elapsed < best ? elapsed : best;
+    }
+    report("batched lookup", LOOKUPS, best, found);
+
+    if (count <= SCAN_PREFIXES_MAX)
+    {
+        // Scans are slow, so fewer of them
+        unsigned int scans = LOOKUPS / count;
+
+        found = 0;
+        start = PosixSocketCommon::getMonotonicSeconds();
+        for (unsigned int i = 0; i < scans; ++i)
+        {
+            std::uint32_t value;
+            found += scan(prefixes, values, addresses[i], value);
+        }
+        report("linear scan",
+               scans,
+               PosixSocketCommon::getMonotonicSeconds() - start,
+               found);
+    }
+
+    start = PosixSocketCommon::getMonotonicSeconds();
+    unsigned int removed = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        removed += table.remove(prefixes[i]);
+    }
+    report("remove",
+           count,
+           PosixSocketCommon::getMonotonicSeconds() - start,
+           removed);
+}
+
+//==============================================================================
+// Runs the benchmark
+//==============================================================================
+int main(int argc, char** argv)
+{
+    if (argc > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [prefix count]\n";
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(16) << "case" << std::right
+              << std::setw(14) << "Mops/s"
+              << std::setw(14) << "ns/op"
+              << std::setw(12) << "succeeded" << "\n";
+
+    if (argc == 2)
+    {
+        run(atoi(argv[1]));
+        return 0;
+    }
+
+    run(1000);
+    run(100000);
+    run(800000);
+
+    return 0;
+}
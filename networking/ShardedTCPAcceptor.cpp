@@ -0,0 +1,291 @@
+#include <cerrno>
+#include <cstdio>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "ShardedTCPAcceptor.hpp"
+
+#include "PosixSocketCommon.hpp"
+#include "PosixTCPSocketImpl.hpp"
+#include "TCPAcceptHandler.hpp"
+#include "TCPSocket.hpp"
+
+//==============================================================================
+// Saves the handler; nothing is opened until start()
+//==============================================================================
+ShardedTCPAcceptor::ShardedTCPAcceptor(TCPAcceptHandler* handler) :
+    handler(handler),
+    stop_fd(-1),
+    running(false)
+{
+}
+
+//==============================================================================
+// Stops everything
+//==============================================================================
+ShardedTCPAcceptor::~ShardedTCPAcceptor()
+{
+    stop();
+}
+
+//==============================================================================
+// Opens all the listeners and starts their threads
+//==============================================================================
+bool ShardedTCPAcceptor::start(unsigned int&           port,
+                               unsigned int            shards,
+                               int                     backlog,
+                               const std::vector<int>& cores)
+{
+    if (running || shards == 0)
+    {
+        return false;
+    }
+
+    stop_fd = PosixSocketCommon::openStopEvent();
+    if (stop_fd == -1)
+    {
+        return false;
+    }
+
+    // Open every listener before starting any threads so a failure part way
+    // through leaves nothing to clean up but descriptors.  The first listener
+    // picks the port if the user didn't; the rest join it.
+    for (unsigned int i = 0; i < shards; ++i)
+    {
+        Shard* shard = new Shard();
+        shard->listen_fd = -1;
+        shard->accept_count = 0;
+        shard->backoff_count = 0;
+        this->shards.push_back(shard);
+
+        if (!openListener(*shard, port, backlog))
+        {
+            stop();
+            return false;
+        }
+    }
+
+    running = true;
+
+    for (unsigned int i = 0; i < shards; ++i)
+    {
+        int core = cores.empty() ? -1 : cores[i % cores.size()];
+        this->shards[i]->thread =
+            std::thread(&ShardedTCPAcceptor::acceptLoop, this, i, core);
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Stops all the threads and closes all the listeners
+//==============================================================================
+void ShardedTCPAcceptor::stop()
+{
+    if (stop_fd != -1)
+    {
+        PosixSocketCommon::signalStopEvent(stop_fd);
+    }
+
+    for (unsigned int i = 0; i < shards.size(); ++i)
+    {
+        if (shards[i]->thread.joinable())
+        {
+            shards[i]->thread.join();
+        }
+
+        if (shards[i]->listen_fd != -1)
+        {
+            close(shards[i]->listen_fd);
+        }
+
+        delete shards[i];
+    }
+
+    shards.clear();
+
+    if (stop_fd != -1)
+    {
+        close(stop_fd);
+        stop_fd = -1;
+    }
+
+    running = false;
+}
+
+//==============================================================================
+// Returns the given shard's accept count
+//==============================================================================
+unsigned long ShardedTCPAcceptor::getAcceptCount(unsigned int shard) const
+{
+    if (shard >= shards.size())
+    {
+        return 0;
+    }
+
+    return shards[shard]->accept_count.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+// Returns the given shard's backoff count
+//==============================================================================
+unsigned long ShardedTCPAcceptor::getBackoffCount(unsigned int shard) const
+{
+    if (shard >= shards.size())
+    {
+        return 0;
+    }
+
+    return shards[shard]->backoff_count.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+// Creates, binds and starts one listener
+//==============================================================================
+bool ShardedTCPAcceptor::openListener(Shard&        shard,
+                                      unsigned int& port,
+                                      int           backlog)
+{
+    shard.listen_fd =
+        socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (shard.listen_fd == -1)
+    {
+#if defined DEBUG
+        perror("ShardedTCPAcceptor::openListener");
+#endif
+        return false;
+    }
+
+    // SO_REUSEPORT is what lets every shard bind the same port; the kernel
+    // then hashes incoming connections across all of them
+    int enable = 1;
+    if (setsockopt(shard.listen_fd,
+                   SOL_SOCKET,
+                   SO_REUSEPORT,
+                   &enable,
+                   sizeof(enable)) == -1)
+    {
+#if defined DEBUG
+        perror("ShardedTCPAcceptor::openListener");
+#endif
+        return false;
+    }
+
+    if (!PosixSocketCommon::bind(shard.listen_fd, shard.local_address, port))
+    {
+        return false;
+    }
+
+    if (listen(shard.listen_fd, backlog) == -1)
+    {
+#if defined DEBUG
+        perror("ShardedTCPAcceptor::openListener");
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Waits for connections and hands them off until told to stop
+//==============================================================================
+void ShardedTCPAcceptor::acceptLoop(unsigned int shard_index, int core)
+{
+    // Pinned from in here so nothing runs on the wrong core first
+    if (core >= 0)
+    {
+        PosixSocketCommon::pinThread(core);
+    }
+
+    Shard& shard = *shards[shard_index];
+
+    pollfd polldata[2];
+    polldata[0].fd     = shard.listen_fd;
+    polldata[0].events = POLLIN;
+    polldata[1].fd     = stop_fd;
+    polldata[1].events = POLLIN;
+
+    while (true)
+    {
+        if (poll(polldata, 2, -1) == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+#if defined DEBUG
+            perror("ShardedTCPAcceptor::acceptLoop");
+#endif
+            return;
+        }
+
+        if (polldata[1].revents != 0)
+        {
+            return;
+        }
+
+        // Take as many pending connections as we can before polling again;
+        // under a burst this turns one poll per connection into one poll per
+        // batch
+        bool exhausted = false;
+        for (unsigned int i = 0; i < ACCEPT_BATCH_SIZE && !exhausted; ++i)
+        {
+            sockaddr_in peer_address;
+            socklen_t   addrlen = sizeof(peer_address);
+
+            int new_socket_fd = accept4(shard.listen_fd,
+                                        reinterpret_cast<sockaddr*>(
+                                            &peer_address),
+                                        &addrlen,
+                                        SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+            if (new_socket_fd == -1)
+            {
+                // Drained
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    break;
+                }
+
+#if defined DEBUG
+                perror("ShardedTCPAcceptor::acceptLoop");
+#endif
+
+                // Nothing can be accepted until descriptors or memory are
+                // freed up; anything else (a connection reset while it
+                // waited, say) only affects that one connection
+                exhausted = errno == EMFILE || errno == ENFILE ||
+                    errno == ENOBUFS || errno == ENOMEM;
+                continue;
+            }
+
+            shard.accept_count.fetch_add(1, std::memory_order_relaxed);
+
+            TCPSocket* socket = new TCPSocket(
+                new PosixTCPSocketImpl(new_socket_fd,
+                                       shard.local_address,
+                                       peer_address,
+                                       0.0));
+
+            handler->handleConnection(socket, shard_index);
+        }
+
+        // Wait a little before trying again, still listening for stop()
+        if (exhausted)
+        {
+            shard.backoff_count.fetch_add(1, std::memory_order_relaxed);
+
+            if (poll(&polldata[1], 1, BACKOFF_MILLISECONDS) > 0)
+            {
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#if !defined SHARDED_TCP_ACCEPTOR_HPP
+#define SHARDED_TCP_ACCEPTOR_HPP
+
+#include <atomic>
+#include <netinet/in.h>
+#include <thread>
+#include <vector>
+
+#include "TCPSocket.hpp"
+
+class TCPAcceptHandler;
+
+// Accepts TCP connections on one port using several listening sockets at once.
+// Each listener is opened with SO_REUSEPORT so the kernel spreads incoming
+// connections across them, and each is serviced by its own thread, optionally
+// pinned to a CPU core.  Threads drain their listener in batches with
+// accept4() and hand every new connection to a TCPAcceptHandler.  Linux only.
+class ShardedTCPAcceptor
+{
+public:
+
+    // Accepted connections are given to 'handler', which must outlive this
+    // object.
+    explicit ShardedTCPAcceptor(TCPAcceptHandler* handler);
+
+    // Calls stop()
+    ~ShardedTCPAcceptor();
+
+    // Opens 'shards' listeners on 'port' and starts a thread for each.
+    // Specify 0 to request any available port; the chosen port is returned in
+    // place of the argument.  'backlog' is the connection request queue length
+    // of each listener.  If 'cores' is non-empty, thread i is pinned to core
+    // cores[i % cores.size()].  Returns false if any listener couldn't be set
+    // up, in which case nothing is left running.
+    bool start(unsigned int&           port,
+               unsigned int            shards,
+               int                     backlog = TCPSocket::DEFAULT_BACKLOG,
+               const std::vector<int>& cores   = std::vector<int>());
+
+    // Stops all threads and closes all listeners.  Connections already handed
+    // to the handler are unaffected.
+    void stop();
+
+    // Returns true between a successful start() and the following stop()
+    bool isRunning() const;
+
+    // Returns the number of listeners currently open
+    unsigned int getShardCount() const;
+
+    // Returns the number of connections accepted by the given shard since the
+    // last start()
+    unsigned long getAcceptCount(unsigned int shard) const;
+
+    // Returns the number of times the given shard has had to stop accepting
+    // for a while since the last start() because the process or system was
+    // out of descriptors or buffers
+    unsigned long getBackoffCount(unsigned int shard) const;
+
+    // Most connections accepted in one go before a shard goes back to poll()
+    static const unsigned int ACCEPT_BATCH_SIZE = 64;
+
+    // How long a shard stops accepting for when there's no descriptor or
+    // buffer for a new connection.  The listener stays readable while
+    // connections wait, so polling it again straight away would only spin;
+    // the connections wait in the backlog instead.
+    static const int BACKOFF_MILLISECONDS = 10;
+
+private:
+
+    // State owned by each listener and its thread
+    struct Shard
+    {
+        int                        listen_fd;
+        sockaddr_in                local_address;
+        std::thread                thread;
+        std::atomic<unsigned long> accept_count;
+        std::atomic<unsigned long> backoff_count;
+    };
+
+    // Creates, binds and starts one listener
+    bool openListener(Shard& shard, unsigned int& port, int backlog);
+
+    // Body of each shard's thread, which first pins itself to 'core' unless
+    // it's negative
+    void acceptLoop(unsigned int shard_index, int core);
+
+    TCPAcceptHandler* handler;
+
+    // Owned by this class; Shard isn't movable so these are held by pointer
+    std::vector<Shard*> shards;
+
+    // Written to by stop() to wake every thread up
+    int stop_fd;
+
+    bool running;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    ShardedTCPAcceptor(const ShardedTCPAcceptor&);
+    ShardedTCPAcceptor& operator=(const ShardedTCPAcceptor&);
+};
+
+//==============================================================================
+inline bool ShardedTCPAcceptor::isRunning() const
+{
+    return running;
+}
+
+//==============================================================================
+inline unsigned int ShardedTCPAcceptor::getShardCount() const
+{
+    return shards.size();
+}
+
+#endif
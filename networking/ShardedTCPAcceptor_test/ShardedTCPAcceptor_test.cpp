@@ -0,0 +1,258 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "ShardedTCPAcceptor_test.hpp"
+
+#include "ShardedTCPAcceptor.hpp"
+#include "TCPAcceptHandler.hpp"
+#include "TCPSocket.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(ShardedTCPAcceptor_test);
+
+// Returns the CPU time used so far by the whole process
+static double getCpuSeconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+        usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// Counts and immediately closes every connection it's given
+class CountingHandler : public TCPAcceptHandler
+{
+public:
+
+    CountingHandler() : connections(0) {}
+
+    virtual void handleConnection(TCPSocket* socket, unsigned int)
+    {
+        delete socket;
+        ++connections;
+    }
+
+    std::atomic<unsigned int> connections;
+};
+
+// Notes which cores the accepting thread may run on
+class AffinityHandler : public CountingHandler
+{
+public:
+
+    AffinityHandler() : only_core_0(false) {}
+
+    virtual void handleConnection(TCPSocket* socket, unsigned int shard)
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        only_core_0 = pthread_getaffinity_np(
+            pthread_self(), sizeof(cpu_set), &cpu_set) == 0 &&
+            CPU_COUNT(&cpu_set) == 1 && CPU_ISSET(0, &cpu_set);
+
+        CountingHandler::handleConnection(socket, shard);
+    }
+
+    std::atomic<bool> only_core_0;
+};
+
+//==============================================================================
+void ShardedTCPAcceptor_test::addTestCases()
+{
+    ADD_TEST_CASE(AcceptBurst);
+    ADD_TEST_CASE(StartStop);
+    ADD_TEST_CASE(OutOfDescriptors);
+    ADD_TEST_CASE(Pinned);
+}
+
+//==============================================================================
+Test::Result ShardedTCPAcceptor_test::AcceptBurst::body()
+{
+    const unsigned int SHARDS  = 4;
+    const unsigned int CLIENTS = 32;
+
+    CountingHandler handler;
+    ShardedTCPAcceptor acceptor(&handler);
+
+    unsigned int port = 0;  // Use whatever port is available
+    MUST_BE_TRUE(acceptor.start(port, SHARDS, 1024));
+    MUST_BE_TRUE(acceptor.isRunning());
+    MUST_BE_TRUE(acceptor.getShardCount() == SHARDS);
+
+    std::cout << "Using port " << port << "\n";
+
+    // Every client should get through no matter which shard it lands on
+    std::vector<TCPSocket*> clients;
+    for (unsigned int i = 0; i < CLIENTS; ++i)
+    {
+        clients.push_back(new TCPSocket());
+        MUST_BE_TRUE(clients.back()->connect("localhost", port));
+    }
+
+    for (unsigned int i = 0; i < 200 && handler.connections < CLIENTS; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (unsigned int i = 0; i < clients.size(); ++i)
+    {
+        delete clients[i];
+    }
+
+    MUST_BE_TRUE(handler.connections == CLIENTS);
+
+    unsigned long total = 0;
+    for (unsigned int i = 0; i < SHARDS; ++i)
+    {
+        std::cout << "Shard " << i << " accepted "
+                  << acceptor.getAcceptCount(i) << "\n";
+        total += acceptor.getAcceptCount(i);
+    }
+
+    MUST_BE_TRUE(total == CLIENTS);
+
+    acceptor.stop();
+    MUST_BE_FALSE(acceptor.isRunning());
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result ShardedTCPAcceptor_test::StartStop::body()
+{
+    CountingHandler handler;
+    ShardedTCPAcceptor acceptor(&handler);
+
+    // Zero shards makes no sense
+    unsigned int port = 0;
+    MUST_BE_FALSE(acceptor.start(port, 0));
+
+    // Should be able to go around more than once, pinned or not
+    std::vector<int> cores(1, 0);
+    MUST_BE_TRUE(acceptor.start(port, 2, TCPSocket::DEFAULT_BACKLOG, cores));
+    MUST_BE_FALSE(acceptor.start(port, 2));
+    acceptor.stop();
+
+    port = 0;
+    MUST_BE_TRUE(acceptor.start(port, 2));
+    acceptor.stop();
+
+    MUST_BE_TRUE(acceptor.getShardCount() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result ShardedTCPAcceptor_test::OutOfDescriptors::body()
+{
+    const unsigned int CLIENTS = 4;
+
+    CountingHandler handler;
+    ShardedTCPAcceptor acceptor(&handler);
+
+    unsigned int port = 0;
+    MUST_BE_TRUE(acceptor.start(port, 1));
+
+    // The clients need their descriptors before we run out
+    std::vector<TCPSocket*> clients;
+    for (unsigned int i = 0; i < CLIENTS; ++i)
+    {
+        clients.push_back(new TCPSocket());
+    }
+
+    // Leave no descriptor free below the limit so every accept fails with
+    // EMFILE
+    rlimit original;
+    MUST_BE_TRUE(getrlimit(RLIMIT_NOFILE, &original) == 0);
+
+    int lowest_free = dup(0);
+    MUST_BE_TRUE(lowest_free != -1);
+    close(lowest_free);
+
+    rlimit lowered = original;
+    lowered.rlim_cur = lowest_free;
+    MUST_BE_TRUE(setrlimit(RLIMIT_NOFILE, &lowered) == 0);
+
+    // Dotted addresses don't need a lookup, which might want a descriptor
+    for (unsigned int i = 0; i < CLIENTS; ++i)
+    {
+        MUST_BE_TRUE(clients[i]->connect("127.0.0.1", port));
+    }
+
+    // The connections stay readable on the listener, but the shard should
+    // back off rather than spin on them
+    std::chrono::steady_clock::time_point wall_start =
+        std::chrono::steady_clock::now();
+    double cpu_start = getCpuSeconds();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    double cpu_seconds = getCpuSeconds() - cpu_start;
+    double wall_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wall_start).count();
+
+    std::cout << "Used " << cpu_seconds << "s of CPU in " << wall_seconds
+              << "s with " << acceptor.getBackoffCount(0) << " backoffs\n";
+
+    MUST_BE_TRUE(setrlimit(RLIMIT_NOFILE, &original) == 0);
+
+    MUST_BE_TRUE(handler.connections == 0);
+    MUST_BE_TRUE(acceptor.getBackoffCount(0) > 0);
+    MUST_BE_TRUE(cpu_seconds < wall_seconds / 2);
+
+    // Once descriptors are back the waiting connections get through
+    for (unsigned int i = 0; i < 200 && handler.connections < CLIENTS; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (unsigned int i = 0; i < clients.size(); ++i)
+    {
+        delete clients[i];
+    }
+
+    MUST_BE_TRUE(handler.connections == CLIENTS);
+    MUST_BE_TRUE(acceptor.getAcceptCount(0) == CLIENTS);
+
+    acceptor.stop();
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result ShardedTCPAcceptor_test::Pinned::body()
+{
+    AffinityHandler handler;
+    ShardedTCPAcceptor acceptor(&handler);
+
+    unsigned int port = 0;
+    std::vector<int> cores(1, 0);
+    MUST_BE_TRUE(acceptor.start(port, 1, TCPSocket::DEFAULT_BACKLOG, cores));
+
+    TCPSocket client;
+    MUST_BE_TRUE(client.connect("localhost", port));
+
+    for (unsigned int i = 0; i < 200 && handler.connections == 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    acceptor.stop();
+
+    MUST_BE_TRUE(handler.connections == 1);
+    MUST_BE_TRUE(handler.only_core_0);
+
+    return Test::PASSED;
+}
@@ -0,0 +1,17 @@
+#if !defined SHARDED_TCP_ACCEPTOR_TEST
+#define SHARDED_TCP_ACCEPTOR_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(ShardedTCPAcceptor_test)
+
+    TEST(AcceptBurst)
+    TEST(StartStop)
+    TEST(OutOfDescriptors)
+    TEST(Pinned)
+
+TEST_CASES_END(ShardedTCPAcceptor_test)
+
+#endif
@@ -0,0 +1,77 @@
+#include <stdexcept>
+#include <string>
+
+#include "SharedMemorySocket.hpp"
+
+#include "SharedMemorySocketImpl.hpp"
+#include "SocketFactory.hpp"
+
+const unsigned int SharedMemorySocket::DEFAULT_CAPACITY;
+
+//==============================================================================
+// Creates a platform-specific shared memory socket
+//==============================================================================
+SharedMemorySocket::SharedMemorySocket() :
+    Socket()
+{
+    // Get a platform-specific socket
+    socket_impl = SocketFactory::createSharedMemorySocket();
+
+    if (socket_impl)
+    {
+        Socket::setImplementation(socket_impl);
+    }
+    else
+    {
+        // This socket will never work in this case
+        throw std::runtime_error(
+            "Platform-specific shared memory socket could not be created");
+    }
+}
+
+//==============================================================================
+// Destroys socket
+//==============================================================================
+SharedMemorySocket::~SharedMemorySocket()
+{
+    delete socket_impl;
+}
+
+//==============================================================================
+// Calls implementation-specific create
+//==============================================================================
+bool SharedMemorySocket::create(const std::string& name, unsigned int capacity)
+{
+    if (socket_impl)
+    {
+        return socket_impl->create(name, capacity);
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific open
+//==============================================================================
+bool SharedMemorySocket::open(const std::string& name)
+{
+    if (socket_impl)
+    {
+        return socket_impl->open(name);
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific getMaxMessageSize
+//==============================================================================
+unsigned int SharedMemorySocket::getMaxMessageSize() const
+{
+    if (socket_impl)
+    {
+        return socket_impl->getMaxMessageSize();
+    }
+
+    return 0;
+}
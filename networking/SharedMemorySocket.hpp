@@ -0,0 +1,71 @@
+#if !defined SHARED_MEMORY_SOCKET_HPP
+#define SHARED_MEMORY_SOCKET_HPP
+
+#include <string>
+
+#include "Socket.hpp"
+
+class SharedMemorySocketImpl;
+
+// A socket between two processes (or threads) on the same host that passes
+// messages through shared memory instead of the kernel's network stack.  One
+// side creates a named shared memory segment and the other opens it; after
+// that both sides read and write exactly as they would a connected UDP socket.
+// Message boundaries are kept, and a read into a buffer too small for the next
+// message gets only the start of it.  Data goes through one ring buffer in each
+// direction, so reads and writes only make system calls when one side has to
+// wait for the other.
+class SharedMemorySocket : public Socket
+{
+public:
+
+    // Does nothing but call parent constructor.
+    SharedMemorySocket();
+
+    // Detaches from the shared memory segment.  The peer's reads return 0 once
+    // it has read everything already written, and its writes fail.
+    virtual ~SharedMemorySocket();
+
+    // Creates a shared memory segment with the given name and attaches to it.
+    // Each direction can hold up to 'capacity' bytes of messages, which is
+    // rounded up to a power of two.  The name is removed again when this
+    // socket is destroyed.  Returns false if the segment already exists or
+    // couldn't be created.
+    bool create(const std::string& name,
+                unsigned int       capacity = DEFAULT_CAPACITY);
+
+    // Attaches to a shared memory segment made by create() in another socket.
+    // Only one socket can attach to each segment.
+    bool open(const std::string& name);
+
+    // Returns the size of the largest message that can be written, or 0 if
+    // not attached to a segment yet
+    unsigned int getMaxMessageSize() const;
+
+    // Per-direction capacity used when none is given
+    static const unsigned int DEFAULT_CAPACITY = 1048576;
+
+protected:
+
+    // Sets the platform-specific socket implementation to use
+    void setImplementation(SharedMemorySocketImpl* socket_impl);
+
+private:
+
+    // Platform-specific socket implementation
+    SharedMemorySocketImpl* socket_impl;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    SharedMemorySocket(const SharedMemorySocket&);
+    SharedMemorySocket& operator=(const SharedMemorySocket&);
+};
+
+//==============================================================================
+inline void SharedMemorySocket::setImplementation(
+    SharedMemorySocketImpl* socket_impl)
+{
+    this->socket_impl = socket_impl;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#include "SharedMemorySocketImpl.hpp"
+
+//=============================================================================
+// Constructor; does nothing.
+//=============================================================================
+SharedMemorySocketImpl::SharedMemorySocketImpl() :
+    SocketImpl()
+{
+}
+
+//=============================================================================
+// Destructor; does nothing.
+//=============================================================================
+SharedMemorySocketImpl::~SharedMemorySocketImpl()
+{
+}
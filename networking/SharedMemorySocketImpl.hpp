@@ -0,0 +1,36 @@
+#if !defined SHARED_MEMORY_SOCKET_IMPL_HPP
+#define SHARED_MEMORY_SOCKET_IMPL_HPP
+
+#include <string>
+
+#include "SocketImpl.hpp"
+
+class SharedMemorySocketImpl : public SocketImpl
+{
+public:
+
+    // Does nothing but call parent constructor.
+    SharedMemorySocketImpl();
+
+    // Does nothing.
+    virtual ~SharedMemorySocketImpl();
+
+    // Creates a shared memory segment with the given name, with room for
+    // 'capacity' bytes of messages in each direction, and attaches to it
+    virtual bool create(const std::string& name, unsigned int capacity) = 0;
+
+    // Attaches to a shared memory segment made by create()
+    virtual bool open(const std::string& name) = 0;
+
+    // Returns the size of the largest message that can be written
+    virtual unsigned int getMaxMessageSize() const = 0;
+
+private:
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    SharedMemorySocketImpl(const SharedMemorySocketImpl&);
+    SharedMemorySocketImpl& operator=(const SharedMemorySocketImpl&);
+};
+
+#endif
@@ -0,0 +1,369 @@
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "SharedMemorySocket_test.hpp"
+
+#include "SharedMemorySocket.hpp"
+#include "SocketKernelStatistics.hpp"
+#include "SocketStatistics.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(SharedMemorySocket_test);
+
+//==============================================================================
+void SharedMemorySocket_test::addTestCases()
+{
+    ADD_TEST_CASE(SendReceive);
+    ADD_TEST_CASE(WrapAround);
+    ADD_TEST_CASE(Blocking);
+    ADD_TEST_CASE(PeerClosed);
+    ADD_TEST_CASE(TwoProcesses);
+}
+
+//==============================================================================
+// Returns a segment name no other test (or test run) is using
+//==============================================================================
+static std::string getSegmentName(const std::string& test_name)
+{
+    std::ostringstream name;
+    name << "/SharedMemorySocket_test_" << getpid() << "_" << test_name;
+    return name.str();
+}
+
+//==============================================================================
+// Fills 'message' with a pattern that depends on 'seed'
+//==============================================================================
+static void fillMessage(std::vector<unsigned char>& message, unsigned int seed)
+{
+    for (unsigned int i = 0; i < message.size(); ++i)
+    {
+        message[i] = seed * 31 + i;
+    }
+}
+
+//==============================================================================
+Test::Result SharedMemorySocket_test::SendReceive::body()
+{
+    std::string name = getSegmentName("SendReceive");
+
+    SharedMemorySocket socket1;
+    SharedMemorySocket socket2;
+
+    // Nothing works until attached
+    unsigned char byte = 0;
+    MUST_BE_TRUE(socket1.write(&byte, 1) == -1);
+    MUST_BE_TRUE(socket1.getMaxMessageSize() == 0);
+
+    MUST_BE_TRUE(socket1.create(name, 4096));
+    MUST_BE_TRUE(socket2.open(name));
+
+    // Only one of each
+    SharedMemorySocket socket3;
+    MUST_BE_FALSE(socket3.create(name, 4096));
+    MUST_BE_FALSE(socket3.open(name));
+
+    unsigned char send1[]      = {'o',  'n',  'e',  '\0'};
+    unsigned char send1_recv[] = {'\0', '\0', '\0', '\0'};
+    unsigned char send2[]      = {'t',  'w',  'o',  '\0'};
+    unsigned char send2_recv[] = {'\0', '\0', '\0', '\0'};
+    unsigned int send_size = 4;  // Must equal the length of all four arrays
+
+    socket1.resetStatistics();
+    socket2.resetStatistics();
+
+    MUST_BE_TRUE(socket1.write(send1, send_size) ==
+                 static_cast<int>(send_size));
+    MUST_BE_TRUE(socket2.write(send2, send_size) ==
+                 static_cast<int>(send_size));
+
+    MUST_BE_TRUE(socket2.read(send1_recv, send_size) ==
+                 static_cast<int>(send_size));
+    MUST_BE_TRUE(socket1.read(send2_recv, send_size) ==
+                 static_cast<int>(send_size));
+
+    MUST_BE_TRUE(memcmp(send1, send1_recv, send_size) == 0);
+    MUST_BE_TRUE(memcmp(send2, send2_recv, send_size) == 0);
+
+    // Neither side ever had to wait, so neither made a system call
+    SocketStatistics statistics;
+    socket1.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getSyscalls() == 0);
+    MUST_BE_TRUE(statistics.getBytesSent() == send_size);
+    MUST_BE_TRUE(statistics.getBytesReceived() == send_size);
+
+    // Message boundaries are kept, and a short read loses the rest
+    MUST_BE_TRUE(socket1.write(send1, send_size) ==
+                 static_cast<int>(send_size));
+    MUST_BE_TRUE(socket1.write(send2, send_size) ==
+                 static_cast<int>(send_size));
+    MUST_BE_TRUE(socket2.read(send1_recv, 2) == 2);
+    MUST_BE_TRUE(socket2.read(send2_recv, send_size) ==
+                 static_cast<int>(send_size));
+    MUST_BE_TRUE(memcmp(send2, send2_recv, send_size) == 0);
+
+    // Anything bigger than the largest message is refused outright
+    std::vector<unsigned char> big(socket1.getMaxMessageSize() + 1);
+    MUST_BE_TRUE(socket1.write(&big[0], big.size()) == -1);
+    MUST_BE_TRUE(socket1.write(&big[0], big.size() - 1) ==
+                 static_cast<int>(big.size() - 1));
+
+    SocketKernelStatistics kernel_statistics;
+    MUST_BE_TRUE(socket2.getKernelStatistics(kernel_statistics));
+    MUST_BE_TRUE(kernel_statistics.getReceiveQueueBytes() >= big.size() - 1);
+
+    socket2.clearBuffer();
+    MUST_BE_TRUE(socket2.getKernelStatistics(kernel_statistics));
+    MUST_BE_TRUE(kernel_statistics.getReceiveQueueBytes() == 0);
+
+    MUST_BE_TRUE(socket2.disableBlocking());
+    MUST_BE_TRUE(socket2.read(send1_recv, send_size) == -1);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result SharedMemorySocket_test::WrapAround::body()
+{
+    std::string name = getSegmentName("WrapAround");
+
+    SharedMemorySocket socket1;
+    SharedMemorySocket socket2;
+    MUST_BE_TRUE(socket1.create(name, 4096));
+    MUST_BE_TRUE(socket2.open(name));
+    MUST_BE_TRUE(socket1.disableBlocking());
+    MUST_BE_TRUE(socket2.disableBlocking());
+
+    // Messages of awkward sizes, written until the ring fills and then read
+    // back, many times over so they land everywhere including across the end
+    // of the ring
+    unsigned int written = 0;
+    unsigned int read    = 0;
+
+    std::vector<unsigned char> received(socket1.getMaxMessageSize());
+
+    for (unsigned int round = 0; round < 100; ++round)
+    {
+        while (true)
+        {
+            std::vector<unsigned char> message((written * 37) % 700);
+            fillMessage(message, written);
+
+            int ret = socket1.write(message.empty() ? 0 : &message[0],
+                                    message.size());
+            if (ret == -1)
+            {
+                break;
+            }
+
+            MUST_BE_TRUE(ret == static_cast<int>(message.size()));
+            written++;
+        }
+
+        while (true)
+        {
+            int ret = socket2.read(&received[0], received.size());
+            if (ret == -1)
+            {
+                break;
+            }
+
+            std::vector<unsigned char> expected((read * 37) % 700);
+            fillMessage(expected, read);
+
+            MUST_BE_TRUE(ret == static_cast<int>(expected.size()));
+            MUST_BE_TRUE(expected.empty() ||
+                         memcmp(&received[0], &expected[0], ret) == 0);
+            read++;
+        }
+
+        MUST_BE_TRUE(read == written);
+    }
+
+    std::cout << written << " messages passed through a 4096 byte ring\n";
+
+    // Every full ring showed up as a would-block
+    SocketStatistics statistics;
+    socket1.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getWouldBlocks() == 100);
+    MUST_BE_TRUE(statistics.getSyscalls() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result SharedMemorySocket_test::Blocking::body()
+{
+    std::string name = getSegmentName("Blocking");
+
+    SharedMemorySocket socket1;
+    SharedMemorySocket socket2;
+    MUST_BE_TRUE(socket1.create(name, 4096));
+    MUST_BE_TRUE(socket2.open(name));
+
+    // Nothing coming, so this times out
+    socket2.setBlockingTimeout(0.1);
+    unsigned char buffer[1024];
+    MUST_BE_TRUE(socket2.read(buffer, sizeof(buffer)) == 0);
+
+    SocketStatistics statistics;
+    socket2.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getTimeouts() == 1);
+
+    // A producer far faster than the ring is big has to keep waiting for the
+    // consumer, and the consumer for the producer
+    const unsigned int count = 20000;
+
+    socket1.setBlockingTimeout(5.0);
+    socket2.setBlockingTimeout(5.0);
+
+    std::thread producer([&socket1, count]()
+    {
+        std::vector<unsigned char> message(500);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            fillMessage(message, i);
+            if (socket1.write(&message[0], message.size()) !=
+                static_cast<int>(message.size()))
+            {
+                break;
+            }
+        }
+    });
+
+    unsigned int received = 0;
+    std::vector<unsigned char> expected(500);
+    for (; received < count; ++received)
+    {
+        if (socket2.read(buffer, sizeof(buffer)) != 500)
+        {
+            break;
+        }
+
+        fillMessage(expected, received);
+        if (memcmp(buffer, &expected[0], 500) != 0)
+        {
+            break;
+        }
+    }
+
+    producer.join();
+
+    MUST_BE_TRUE(received == count);
+
+    socket1.getStatistics(statistics);
+    std::cout << "Producer made " << statistics.getSyscalls()
+              << " system calls for " << count << " messages\n";
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result SharedMemorySocket_test::PeerClosed::body()
+{
+    std::string name = getSegmentName("PeerClosed");
+
+    SharedMemorySocket socket1;
+    SharedMemorySocket* socket2 = new SharedMemorySocket();
+    MUST_BE_TRUE(socket1.create(name));
+    MUST_BE_TRUE(socket2->open(name));
+
+    unsigned char send[] = {'o', 'n', 'e', '\0'};
+    unsigned char recv[] = {'\0', '\0', '\0', '\0'};
+    unsigned int size = 4;  // Must equal the length of both arrays
+
+    MUST_BE_TRUE(socket2->write(send, size) == static_cast<int>(size));
+
+    // A reader blocked with no timeout has to be woken by the peer leaving
+    std::thread closer([socket2]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        delete socket2;
+    });
+
+    // What was written before the peer left can still be read, then reads
+    // report the end like a closed TCP connection does
+    MUST_BE_TRUE(socket1.read(recv, size) == static_cast<int>(size));
+    MUST_BE_TRUE(socket1.read(recv, size) == 0);
+    MUST_BE_TRUE(socket1.write(send, size) == -1);
+
+    closer.join();
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result SharedMemorySocket_test::TwoProcesses::body()
+{
+    std::string name = getSegmentName("TwoProcesses");
+
+    const unsigned int count = 1000;
+
+    SharedMemorySocket socket1;
+    MUST_BE_TRUE(socket1.create(name, 8192));
+    socket1.setBlockingTimeout(5.0);
+
+    pid_t pid = fork();
+    MUST_BE_TRUE(pid != -1);
+
+    if (pid == 0)
+    {
+        // The child echoes everything back, then leaves
+        int status = 1;
+        {
+            SharedMemorySocket socket2;
+            if (socket2.open(name))
+            {
+                socket2.setBlockingTimeout(5.0);
+
+                unsigned char buffer[256];
+                unsigned int echoed = 0;
+                for (; echoed < count; ++echoed)
+                {
+                    int ret = socket2.read(buffer, sizeof(buffer));
+                    if (ret <= 0 || socket2.write(buffer, ret) != ret)
+                    {
+                        break;
+                    }
+                }
+
+                status = echoed == count ? 0 : 1;
+            }
+        }
+
+        _exit(status);
+    }
+
+    std::vector<unsigned char> message(100);
+    std::vector<unsigned char> echo(256);
+
+    unsigned int matched = 0;
+    for (; matched < count; ++matched)
+    {
+        fillMessage(message, matched);
+
+        if (socket1.write(&message[0], message.size()) !=
+                static_cast<int>(message.size()) ||
+            socket1.read(&echo[0], echo.size()) !=
+                static_cast<int>(message.size()) ||
+            memcmp(&message[0], &echo[0], message.size()) != 0)
+        {
+            break;
+        }
+    }
+
+    int status = 0;
+    MUST_BE_TRUE(waitpid(pid, &status, 0) == pid);
+
+    MUST_BE_TRUE(matched == count);
+    MUST_BE_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    return Test::PASSED;
+}
@@ -0,0 +1,18 @@
+#if !defined SHARED_MEMORY_SOCKET_TEST
+#define SHARED_MEMORY_SOCKET_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(SharedMemorySocket_test)
+
+    TEST(SendReceive)
+    TEST(WrapAround)
+    TEST(Blocking)
+    TEST(PeerClosed)
+    TEST(TwoProcesses)
+
+TEST_CASES_END(SharedMemorySocket_test)
+
+#endif
@@ -0,0 +1,98 @@
+#include <cstdint>
+#include <vector>
+
+#include "SlotTags.hpp"
+
+const unsigned int SlotTags::GROUP_SIZE;
+const std::uint8_t SlotTags::EMPTY;
+const std::uint8_t SlotTags::DELETED;
+
+//==============================================================================
+// Sizes the table to a power of two groups
+//==============================================================================
+SlotTags::SlotTags(unsigned int capacity) :
+    deleted_count(0)
+{
+    unsigned int slot_count = GROUP_SIZE;
+    while (slot_count / 8 * 7 < capacity)
+    {
+        slot_count *= 2;
+    }
+
+    load_max   = slot_count / 8 * 7;
+    group_mask = slot_count / GROUP_SIZE - 1;
+
+    tags.assign(slot_count, EMPTY);
+}
+
+//==============================================================================
+SlotTags::~SlotTags()
+{
+}
+
+//==============================================================================
+// Walks a probe sequence to the first slot a new key could go in
+//==============================================================================
+unsigned int SlotTags::findFree(std::uint64_t hash) const
+{
+    // Triangular-number offsets reach every group when there's a power of two
+    // of them
+    unsigned int group = getFirstGroup(hash);
+    for (unsigned int step = 1; ; ++step)
+    {
+        unsigned int match = matchFree(group);
+        if (match != 0)
+        {
+            return group * GROUP_SIZE + __builtin_ctz(match);
+        }
+
+        group = getNextGroup(group, step);
+    }
+}
+
+//==============================================================================
+// Frees a slot
+//==============================================================================
+void SlotTags::erase(unsigned int index)
+{
+    // A probe only carries on past a group with no empty slots, so if this
+    // group has one no probe can have passed through here on its way to
+    // somewhere else
+    if (matchEmpty(index / GROUP_SIZE) != 0)
+    {
+        tags[index] = EMPTY;
+    }
+    else
+    {
+        tags[index] = DELETED;
+        deleted_count++;
+    }
+}
+
+//==============================================================================
+// Empties every slot
+//==============================================================================
+void SlotTags::clear()
+{
+    tags.assign(tags.size(), EMPTY);
+    deleted_count = 0;
+}
+
+//==============================================================================
+// Swaps what DELETED means for the length of a rehash
+//==============================================================================
+void SlotTags::beginRehash()
+{
+    for (unsigned int i = 0; i < tags.size(); ++i)
+    {
+        tags[i] = isFull(i) ? DELETED : EMPTY;
+    }
+}
+
+//==============================================================================
+// Every key has been put back, so nothing's deleted any more
+//==============================================================================
+void SlotTags::endRehash()
+{
+    deleted_count = 0;
+}
@@ -0,0 +1,271 @@
+#if !defined SLOT_TAGS_HPP
+#define SLOT_TAGS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#if defined __SSE2__
+#include <emmintrin.h>
+#endif
+
+// The slot bookkeeping shared by FlowTable and AddressSet, which are
+// fixed-capacity open-addressing tables.  Each slot has a one-byte tag: the
+// low 7 bits of the hash of the key it holds, or EMPTY or DELETED.  Tags are
+// searched a group of sixteen at a time (with SSE2 where available), so a
+// lookup usually compares one key at most.  Groups are probed at
+// triangular-number offsets from the one the hash picks.
+//
+// This class knows nothing about keys.  The tables keep their keys in their
+// own arrays, indexed as the tags are, and compare them against the slots a
+// Probe turns up.
+class SlotTags
+{
+public:
+
+    // Walks the slots along a hash's probe sequence whose tags match it,
+    // stopping at the first group with an empty slot, since a key that had
+    // been inserted would have gone there
+    class Probe
+    {
+    public:
+
+        Probe(const SlotTags& tags, std::uint64_t hash);
+
+        // Stores the next slot that might hold the key in 'index'.  Returns
+        // false when there are none left.
+        bool next(unsigned int& index);
+
+    private:
+
+        const SlotTags& tags;
+
+        std::uint8_t tag;
+
+        unsigned int group;
+
+        unsigned int step;
+
+        // A bit for every slot in 'group' yet to be visited
+        unsigned int match;
+    };
+
+    // Makes enough slots for 'capacity' keys while keeping at least an eighth
+    // of them free, all EMPTY
+    explicit SlotTags(unsigned int capacity);
+
+    // Does nothing
+    ~SlotTags();
+
+    // Returns the first empty or deleted slot on the given hash's probe
+    // sequence
+    unsigned int findFree(std::uint64_t hash) const;
+
+    // Tags a free slot as holding a key with the given hash
+    void fill(unsigned int index, std::uint64_t hash);
+
+    // Marks a slot empty, or deleted if a probe could have passed through it
+    void erase(unsigned int index);
+
+    // Marks every slot empty
+    void clear();
+
+    // Returns true if the given slot holds a key
+    bool isFull(unsigned int index) const;
+
+    // Returns true if 'size' keys plus the deleted slots have reached the
+    // load limit, past which probes get long; the table should rehash
+    bool isCrowded(unsigned int size) const;
+
+    // Returns the group the given hash's probe sequence starts at
+    unsigned int getFirstGroup(std::uint64_t hash) const;
+
+    // Fetches a group's tags into cache ahead of a probe
+    void prefetchGroup(unsigned int group) const;
+
+    // For rehashing in place: marks every slot holding a key DELETED and
+    // every other slot EMPTY, so that DELETED means a key still to be put
+    // back.  Keys are then moved around with get() and set(), and
+    // endRehash() called once they've all been put back.
+    void beginRehash();
+    void endRehash();
+
+    // Reads or writes a slot's tag directly, between beginRehash() and
+    // endRehash()
+    std::uint8_t get(unsigned int index) const;
+    void set(unsigned int index, std::uint8_t tag);
+
+    // Returns the number of slots
+    unsigned int getSlotCount() const;
+
+    // Tags are searched this many at a time
+    static const unsigned int GROUP_SIZE = 16;
+
+    // Tags for slots without a key.  Both have the high bit set, which no
+    // key's tag does.  A deleted slot may have been passed over by a probe
+    // on its way to a key further along, so unlike an empty slot it can't
+    // end a lookup.
+    static const std::uint8_t EMPTY   = 0x80;
+    static const std::uint8_t DELETED = 0xfe;
+
+private:
+
+    // Returns a bit for every tag in the given group equal to 'tag'
+    unsigned int matchTag(unsigned int group, std::uint8_t tag) const;
+
+    // Returns a bit for every slot in the given group that's empty
+    unsigned int matchEmpty(unsigned int group) const;
+
+    // Returns a bit for every slot in the given group that's empty or deleted
+    unsigned int matchFree(unsigned int group) const;
+
+    // Returns the group a probe visits after 'group' on its 'step'th step
+    unsigned int getNextGroup(unsigned int group, unsigned int step) const;
+
+    std::vector<std::uint8_t> tags;
+
+    unsigned int group_mask;
+
+    // Keys plus deleted slots may not exceed this, so probes always find an
+    // empty slot before long
+    unsigned int load_max;
+
+    unsigned int deleted_count;
+};
+
+//==============================================================================
+inline SlotTags::Probe::Probe(const SlotTags& tags, std::uint64_t hash) :
+    tags(tags),
+    tag(hash & 0x7f),
+    group(tags.getFirstGroup(hash)),
+    step(1),
+    match(tags.matchTag(group, tag))
+{
+}
+
+//==============================================================================
+inline bool SlotTags::Probe::next(unsigned int& index)
+{
+    while (match == 0)
+    {
+        if (tags.matchEmpty(group) != 0)
+        {
+            return false;
+        }
+
+        group = tags.getNextGroup(group, step++);
+        match = tags.matchTag(group, tag);
+    }
+
+    index = group * GROUP_SIZE + __builtin_ctz(match);
+    match &= match - 1;
+    return true;
+}
+
+//==============================================================================
+inline void SlotTags::fill(unsigned int index, std::uint64_t hash)
+{
+    if (tags[index] == DELETED)
+    {
+        deleted_count--;
+    }
+
+    tags[index] = hash & 0x7f;
+}
+
+//==============================================================================
+inline bool SlotTags::isFull(unsigned int index) const
+{
+    return (tags[index] & 0x80) == 0;
+}
+
+//==============================================================================
+inline bool SlotTags::isCrowded(unsigned int size) const
+{
+    return size + deleted_count >= load_max;
+}
+
+//==============================================================================
+inline unsigned int SlotTags::getFirstGroup(std::uint64_t hash) const
+{
+    return (hash >> 7) & group_mask;
+}
+
+//==============================================================================
+inline void SlotTags::prefetchGroup(unsigned int group) const
+{
+    __builtin_prefetch(&tags[group * GROUP_SIZE]);
+}
+
+//==============================================================================
+inline std::uint8_t SlotTags::get(unsigned int index) const
+{
+    return tags[index];
+}
+
+//==============================================================================
+inline void SlotTags::set(unsigned int index, std::uint8_t tag)
+{
+    tags[index] = tag;
+}
+
+//==============================================================================
+inline unsigned int SlotTags::getSlotCount() const
+{
+    return tags.size();
+}
+
+//==============================================================================
+inline unsigned int SlotTags::matchTag(unsigned int group,
+                                       std::uint8_t tag) const
+{
+    const std::uint8_t* group_tags = &tags[group * GROUP_SIZE];
+
+#if defined __SSE2__
+    __m128i loaded =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(group_tags));
+    return _mm_movemask_epi8(
+        _mm_cmpeq_epi8(loaded, _mm_set1_epi8(static_cast<char>(tag))));
+#else
+    unsigned int match = 0;
+    for (unsigned int i = 0; i < GROUP_SIZE; ++i)
+    {
+        match |= static_cast<unsigned int>(group_tags[i] == tag) << i;
+    }
+
+    return match;
+#endif
+}
+
+//==============================================================================
+inline unsigned int SlotTags::matchEmpty(unsigned int group) const
+{
+    return matchTag(group, EMPTY);
+}
+
+//==============================================================================
+inline unsigned int SlotTags::matchFree(unsigned int group) const
+{
+    const std::uint8_t* group_tags = &tags[group * GROUP_SIZE];
+
+#if defined __SSE2__
+    return _mm_movemask_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(group_tags)));
+#else
+    unsigned int match = 0;
+    for (unsigned int i = 0; i < GROUP_SIZE; ++i)
+    {
+        match |= static_cast<unsigned int>(group_tags[i] >> 7) << i;
+    }
+
+    return match;
+#endif
+}
+
+//==============================================================================
+inline unsigned int SlotTags::getNextGroup(unsigned int group,
+                                           unsigned int step) const
+{
+    return (group + step) & group_mask;
+}
+
+#endif
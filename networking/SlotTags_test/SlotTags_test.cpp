@@ -0,0 +1,147 @@
+#include <cstdint>
+#include <vector>
+
+#include "SlotTags_test.hpp"
+
+#include "SlotTags.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(SlotTags_test);
+
+//==============================================================================
+void SlotTags_test::addTestCases()
+{
+    ADD_TEST_CASE(Sizing);
+    ADD_TEST_CASE(Probing);
+    ADD_TEST_CASE(Erasing);
+}
+
+//==============================================================================
+// Returns every slot a probe for the given hash turns up, in order
+//==============================================================================
+static std::vector<unsigned int> probe(const SlotTags& tags,
+                                       std::uint64_t   hash)
+{
+    std::vector<unsigned int> found;
+
+    SlotTags::Probe probe(tags, hash);
+    unsigned int    index;
+    while (probe.next(index))
+    {
+        found.push_back(index);
+    }
+
+    return found;
+}
+
+//==============================================================================
+Test::Result SlotTags_test::Sizing::body()
+{
+    // Whole groups, a power of two of them, with an eighth or more left free
+    MUST_BE_TRUE(SlotTags(1).getSlotCount() == SlotTags::GROUP_SIZE);
+    MUST_BE_TRUE(SlotTags(14).getSlotCount() == 16);
+    MUST_BE_TRUE(SlotTags(15).getSlotCount() == 32);
+    MUST_BE_TRUE(SlotTags(1000).getSlotCount() == 2048);
+
+    SlotTags tags(14);
+    for (unsigned int i = 0; i < tags.getSlotCount(); ++i)
+    {
+        MUST_BE_FALSE(tags.isFull(i));
+    }
+
+    MUST_BE_FALSE(tags.isCrowded(13));
+    MUST_BE_TRUE(tags.isCrowded(14));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result SlotTags_test::Probing::body()
+{
+    // Two groups.  Hashes below 128 all start at the first.
+    SlotTags tags(28);
+    MUST_BE_TRUE(tags.getSlotCount() == 2 * SlotTags::GROUP_SIZE);
+
+    // Same tag twice, and a different one
+    tags.fill(tags.findFree(0x05), 0x05);
+    tags.fill(tags.findFree(0x05), 0x05);
+    tags.fill(tags.findFree(0x06), 0x06);
+
+    std::vector<unsigned int> found = probe(tags, 0x05);
+    MUST_BE_TRUE(found.size() == 2);
+    MUST_BE_TRUE(found[0] == 0);
+    MUST_BE_TRUE(found[1] == 1);
+
+    found = probe(tags, 0x06);
+    MUST_BE_TRUE(found.size() == 1 && found[0] == 2);
+
+    MUST_BE_TRUE(probe(tags, 0x07).empty());
+
+    // The tag's the low 7 bits of the hash and the group comes from above
+    // them, so this belongs in the second group
+    found = probe(tags, 0x85);
+    MUST_BE_TRUE(found.empty());
+    unsigned int index = tags.findFree(0x85);
+    MUST_BE_TRUE(index >= SlotTags::GROUP_SIZE);
+    tags.fill(index, 0x85);
+    found = probe(tags, 0x85);
+    MUST_BE_TRUE(found.size() == 1 && found[0] == index);
+
+    // Once the first group is full, probes carry on into the second
+    for (unsigned int i = 3; i < SlotTags::GROUP_SIZE; ++i)
+    {
+        tags.fill(tags.findFree(0x10), 0x10);
+    }
+
+    index = tags.findFree(0x20);
+    MUST_BE_TRUE(index >= SlotTags::GROUP_SIZE);
+    tags.fill(index, 0x20);
+    found = probe(tags, 0x20);
+    MUST_BE_TRUE(found.size() == 1 && found[0] == index);
+
+    tags.clear();
+    MUST_BE_TRUE(probe(tags, 0x05).empty());
+    MUST_BE_FALSE(tags.isFull(0));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result SlotTags_test::Erasing::body()
+{
+    SlotTags tags(28);
+
+    // In a group with an empty slot no probe can have passed through, so the
+    // slot's simply emptied
+    tags.fill(tags.findFree(0x05), 0x05);
+    tags.erase(0);
+    MUST_BE_FALSE(tags.isFull(0));
+    MUST_BE_FALSE(tags.isCrowded(0));
+    MUST_BE_TRUE(probe(tags, 0x05).empty());
+
+    // Fill the first group and spill one key into the second
+    for (unsigned int i = 0; i < SlotTags::GROUP_SIZE; ++i)
+    {
+        tags.fill(tags.findFree(i), i);
+    }
+
+    unsigned int spilled = tags.findFree(0x40);
+    tags.fill(spilled, 0x40);
+
+    // Emptying a slot in the full group would hide the spilled key, so it's
+    // marked deleted instead, which counts against the load
+    tags.erase(3);
+    MUST_BE_FALSE(tags.isFull(3));
+    std::vector<unsigned int> found = probe(tags, 0x40);
+    MUST_BE_TRUE(found.size() == 1 && found[0] == spilled);
+
+    MUST_BE_FALSE(tags.isCrowded(26));
+    MUST_BE_TRUE(tags.isCrowded(27));
+
+    // Deleted slots are reused
+    MUST_BE_TRUE(tags.findFree(0x03) == 3);
+    tags.fill(3, 0x03);
+    MUST_BE_FALSE(tags.isCrowded(27));
+
+    return Test::PASSED;
+}
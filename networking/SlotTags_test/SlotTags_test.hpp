@@ -0,0 +1,16 @@
+#if !defined SLOT_TAGS_TEST
+#define SLOT_TAGS_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(SlotTags_test)
+
+    TEST(Sizing)
+    TEST(Probing)
+    TEST(Erasing)
+
+TEST_CASES_END(SlotTags_test)
+
+#endif
@@ -3,6 +3,8 @@
 #include "Socket.hpp"
 
 #include "SocketImpl.hpp"
+#include "SocketKernelStatistics.hpp"
+#include "SocketStatistics.hpp"
 
 //=============================================================================
 // Does nothing
@@ -118,3 +120,51 @@ void Socket::clearBuffer()
         socket_impl->clearBuffer();
     }
 }
+
+//=============================================================================
+// Copies out the implementation's counters
+//=============================================================================
+void Socket::getStatistics(SocketStatistics& statistics) const
+{
+    if (socket_impl)
+    {
+        statistics = socket_impl->getStatistics();
+    }
+}
+
+//=============================================================================
+// Resets the implementation's counters
+//=============================================================================
+void Socket::resetStatistics()
+{
+    if (socket_impl)
+    {
+        socket_impl->resetStatistics();
+    }
+}
+
+//=============================================================================
+// Calls implementation-specific getKernelStatistics
+//=============================================================================
+bool Socket::getKernelStatistics(SocketKernelStatistics& statistics)
+{
+    if (socket_impl)
+    {
+        return socket_impl->getKernelStatistics(statistics);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific getDescriptor
+//=============================================================================
+int Socket::getDescriptor() const
+{
+    if (socket_impl)
+    {
+        return socket_impl->getDescriptor();
+    }
+
+    return -1;
+}
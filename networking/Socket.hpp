@@ -3,7 +3,10 @@
 
 #include <string>
 
+#include "SocketStatistics.hpp"
+
 class SocketImpl;
+class SocketKernelStatistics;
 
 // This is the base class for all abstract socket classes.
 class Socket
@@ -40,6 +43,26 @@ public:
     // Forces this socket to discard all received data.
     void clearBuffer();
 
+    // Copies out the counters this socket maintains on every read and write
+    // (bytes, datagrams, system calls, would-blocks, timeouts, poll-to-data
+    // latency, for busy-polling reads spins and delivery latency, and for
+    // paced writes how far actual send times strayed from scheduled ones).
+    void getStatistics(SocketStatistics& statistics) const;
+
+    // Sets all the counters maintained by this socket back to zero.
+    void resetStatistics();
+
+    // Queries the kernel for its view of this socket: queue depths, drop
+    // counts, and for TCP round trip time, retransmits and congestion window.
+    // Returns false if nothing could be retrieved.
+    bool getKernelStatistics(SocketKernelStatistics& statistics);
+
+    // Returns the operating system descriptor underneath this socket, for
+    // waiting on it with poll() or epoll alongside other descriptors, or -1 if
+    // there isn't one (there never is on Windows).  Reading, writing or
+    // closing it directly will confuse this object.
+    int getDescriptor() const;
+
 protected:
 
     // Constructs a new socket that will use the given protocol.  This class
@@ -0,0 +1,250 @@
+// Measures how quickly connections can be set up and torn down across
+// loopback.  One thread connects new sockets one after another while another
+// accepts them, and both sides close each connection straight away.  TCP is
+// also timed connecting PARALLEL_CONNECTS sockets at a time with a
+// TCPConnector.
+//
+// TCP connections closed this way linger in TIME_WAIT and tie up an ephemeral
+// port each for a minute or so; asking for many more connections than there
+// are ephemeral ports (see /proc/sys/net/ipv4/ip_local_port_range) will make
+// the TCP case fail partway through.
+//
+// Usage: SocketConnect_benchmark [connections]
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "PosixSocketCommon.hpp"
+#include "TCPConnector.hpp"
+#include "TCPSocket.hpp"
+#include "UnixStreamSocket.hpp"
+
+// Pending connections the listener can hold; plenty to keep the connecting
+// side from ever waiting on the accepting side
+static const int BACKLOG = 1024;
+
+// Connections a TCPConnector is given at once
+static const unsigned int PARALLEL_CONNECTS = 64;
+
+//==============================================================================
+// Prints one line of results
+//==============================================================================
+static void report(const std::string& name,
+                   unsigned int       connected,
+                   unsigned int       accepted,
+                   unsigned int       connections,
+                   double             elapsed)
+{
+    std::cout << std::left << std::setw(16) << name << std::right;
+
+    if (connected < connections || accepted < connections)
+    {
+        std::cout << "failed after " << connected << " connects and "
+                  << accepted << " accepts\n";
+        return;
+    }
+
+    std::cout << std::setw(14) << std::fixed << std::setprecision(0)
+              << connections / elapsed << std::setw(12)
+              << std::setprecision(2) << elapsed / connections * 1.0e6
+              << "\n";
+}
+
+//==============================================================================
+// Connects and accepts TCP connections
+//==============================================================================
+static void tcpConnectRate(unsigned int connections)
+{
+    unsigned int port = 0;
+
+    TCPSocket listener;
+    if (!listener.bind(port) || !listener.listen(BACKLOG))
+    {
+        std::cout << "TCP setup failed, skipping\n";
+        return;
+    }
+
+    // Don't wait forever if the connecting side gives up
+    listener.setBlockingTimeout(1.0);
+
+    unsigned int accepted = 0;
+    std::thread acceptor([&listener, &accepted, connections]()
+    {
+        for (unsigned int i = 0; i < connections; ++i)
+        {
+            TCPSocket* socket = listener.accept(false);
+            if (!socket)
+            {
+                return;
+            }
+
+            delete socket;
+            accepted++;
+        }
+    });
+
+    unsigned int connected = 0;
+    double       start     = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < connections; ++i)
+    {
+        TCPSocket socket;
+        if (!socket.connect("localhost", port))
+        {
+            break;
+        }
+
+        connected++;
+    }
+
+    acceptor.join();
+    double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    report("TCP", connected, accepted, connections, elapsed);
+}
+
+//==============================================================================
+// Connects TCP connections in groups, all of a group at once, and accepts them
+//==============================================================================
+static void tcpParallelConnectRate(unsigned int connections)
+{
+    unsigned int port = 0;
+
+    TCPSocket listener;
+    if (!listener.bind(port) || !listener.listen(BACKLOG))
+    {
+        std::cout << "TCP parallel setup failed, skipping\n";
+        return;
+    }
+
+    listener.setBlockingTimeout(1.0);
+
+    unsigned int accepted = 0;
+    std::thread acceptor([&listener, &accepted, connections]()
+    {
+        for (unsigned int i = 0; i < connections; ++i)
+        {
+            TCPSocket* socket = listener.accept(false);
+            if (!socket)
+            {
+                return;
+            }
+
+            delete socket;
+            accepted++;
+        }
+    });
+
+    TCPConnector connector;
+    unsigned int connected = 0;
+    double       start     = PosixSocketCommon::getMonotonicSeconds();
+    while (connected < connections)
+    {
+        unsigned int group = connections - connected;
+        if (group > PARALLEL_CONNECTS)
+        {
+            group = PARALLEL_CONNECTS;
+        }
+
+        for (unsigned int i = 0; i < group; ++i)
+        {
+            connector.add("127.0.0.1", port);
+        }
+
+        unsigned int group_connected = connector.connectAll();
+        connected += group_connected;
+        connector.clear();
+
+        if (group_connected < group)
+        {
+            break;
+        }
+    }
+
+    acceptor.join();
+    double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    report("TCP parallel", connected, accepted, connections, elapsed);
+}
+
+//==============================================================================
+// Connects and accepts Unix domain stream connections
+//==============================================================================
+static void unixStreamConnectRate(unsigned int connections)
+{
+    std::ostringstream path;
+    path << "/tmp/SocketConnect_benchmark_" << getpid();
+
+    UnixStreamSocket listener;
+    if (!listener.bind(path.str()) || !listener.listen(BACKLOG))
+    {
+        std::cout << "Unix stream setup failed, skipping\n";
+        return;
+    }
+
+    listener.setBlockingTimeout(1.0);
+
+    unsigned int accepted = 0;
+    std::thread acceptor([&listener, &accepted, connections]()
+    {
+        for (unsigned int i = 0; i < connections; ++i)
+        {
+            UnixStreamSocket* socket = listener.accept(false);
+            if (!socket)
+            {
+                return;
+            }
+
+            delete socket;
+            accepted++;
+        }
+    });
+
+    unsigned int connected = 0;
+    double       start     = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < connections; ++i)
+    {
+        UnixStreamSocket socket;
+        if (!socket.connect(path.str()))
+        {
+            break;
+        }
+
+        connected++;
+    }
+
+    acceptor.join();
+    double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    report("Unix stream", connected, accepted, connections, elapsed);
+}
+
+//==============================================================================
+int main(int argc, char** argv)
+{
+    unsigned int connections = 10000;
+    if (argc > 1)
+    {
+        connections = std::strtoul(argv[1], 0, 10);
+    }
+
+    if (connections == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [connections]\n";
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(16) << "Socket" << std::right
+              << std::setw(14) << "Conns/s" << std::setw(12) << "us/conn"
+              << "\n";
+
+    tcpConnectRate(connections);
+    tcpParallelConnectRate(connections);
+    unixStreamConnectRate(connections);
+
+    return 0;
+}
@@ -7,8 +7,11 @@
 #else
 #include "PosixTCPSocketImpl.hpp"
 #include "PosixUDPSocketImpl.hpp"
+#include "PosixUnixDatagramSocketImpl.hpp"
+#include "PosixUnixStreamSocketImpl.hpp"
 #if defined LINUX
 #include "LinuxRawSocketImpl.hpp"
+#include "LinuxSharedMemorySocketImpl.hpp"
 #endif // LINUX
 #endif // WINDOWS
 
@@ -44,6 +47,36 @@ RawSocketImpl* SocketFactory::createRawSocket()
 #endif
 }
 
+//=============================================================================
+SharedMemorySocketImpl* SocketFactory::createSharedMemorySocket()
+{
+#if defined LINUX
+    return new LinuxSharedMemorySocketImpl();
+#else
+    return 0;  // Only implemented on Linux for now
+#endif
+}
+
+//=============================================================================
+UnixStreamSocketImpl* SocketFactory::createUnixStreamSocket(bool seqpacket)
+{
+#if defined WINDOWS
+    return 0;  // WindowsUnixStreamSocketImpl not yet implemented
+#else
+    return new PosixUnixStreamSocketImpl(seqpacket);
+#endif
+}
+
+//=============================================================================
+UnixDatagramSocketImpl* SocketFactory::createUnixDatagramSocket()
+{
+#if defined WINDOWS
+    return 0;  // Windows has no Unix domain datagram sockets
+#else
+    return new PosixUnixDatagramSocketImpl();
+#endif
+}
+
 //=============================================================================
 SocketFactory::SocketFactory()
 {
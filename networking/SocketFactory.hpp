@@ -2,8 +2,11 @@
 #define SOCKET_FACTORY_HPP
 
 #include "RawSocketImpl.hpp"
+#include "SharedMemorySocketImpl.hpp"
 #include "TCPSocketImpl.hpp"
 #include "UDPSocketImpl.hpp"
+#include "UnixDatagramSocketImpl.hpp"
+#include "UnixStreamSocketImpl.hpp"
 
 // Provides a platform-independent way of acquiring platform-specific socket
 // implementations.
@@ -20,6 +23,18 @@ public:
     // The interface through which platform-specific UDP sockets are acquired.
     static UDPSocketImpl* createUDPSocket();
 
+    // The interface through which platform-specific shared memory sockets are
+    // acquired.
+    static SharedMemorySocketImpl* createSharedMemorySocket();
+
+    // The interface through which platform-specific Unix domain stream
+    // sockets are acquired.  SOCK_SEQPACKET is used if 'seqpacket' is true.
+    static UnixStreamSocketImpl* createUnixStreamSocket(bool seqpacket);
+
+    // The interface through which platform-specific Unix domain datagram
+    // sockets are acquired.
+    static UnixDatagramSocketImpl* createUnixDatagramSocket();
+
 private:
 
     // Creating objects of this class should not be allowed.
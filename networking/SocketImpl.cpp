@@ -13,3 +13,11 @@ SocketImpl::SocketImpl()
 SocketImpl::~SocketImpl()
 {
 }
+
+//=============================================================================
+// Returns -1; implementations with a descriptor return it instead.
+//=============================================================================
+int SocketImpl::getDescriptor() const
+{
+    return -1;
+}
@@ -4,6 +4,10 @@
 #include <cstdint>
 #include <string>
 
+#include "SocketStatistics.hpp"
+
+class SocketKernelStatistics;
+
 // This is the base class for all socket implementations.
 class SocketImpl
 {
@@ -42,6 +46,27 @@ public:
     // Forces this socket to discard all received data.
     virtual void clearBuffer() = 0;
 
+    // Retrieves the counters this socket has been maintaining.
+    const SocketStatistics& getStatistics() const;
+
+    // Resets the counters this socket has been maintaining.
+    void resetStatistics();
+
+    // Asks the kernel for its view of this socket (queue depths, drops, and
+    // for TCP round trip time, retransmits and congestion window).  Returns
+    // false if none of this information could be retrieved.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics) = 0;
+
+    // Returns the operating system descriptor underneath this socket, or -1
+    // if there isn't one that fits in an int.
+    virtual int getDescriptor() const;
+
+protected:
+
+    // Implementations update this as they do work
+    SocketStatistics statistics;
+
 private:
 
     // Disallow these for now; maybe these could be meaningfully implemented but
@@ -50,4 +75,16 @@ private:
     SocketImpl& operator=(const SocketImpl&);
 };
 
+//==============================================================================
+inline const SocketStatistics& SocketImpl::getStatistics() const
+{
+    return statistics;
+}
+
+//==============================================================================
+inline void SocketImpl::resetStatistics()
+{
+    statistics.reset();
+}
+
 #endif
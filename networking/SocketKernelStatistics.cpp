@@ -0,0 +1,30 @@
+#include "SocketKernelStatistics.hpp"
+
+//==============================================================================
+// Initializes everything to zero
+//==============================================================================
+SocketKernelStatistics::SocketKernelStatistics()
+{
+    reset();
+}
+
+//==============================================================================
+// Does nothing
+//==============================================================================
+SocketKernelStatistics::~SocketKernelStatistics()
+{
+}
+
+//==============================================================================
+// Sets everything back to zero
+//==============================================================================
+void SocketKernelStatistics::reset()
+{
+    receive_queue_bytes      = 0;
+    send_queue_bytes         = 0;
+    receive_drops            = 0;
+    round_trip_time          = 0.0;
+    round_trip_time_variance = 0.0;
+    retransmits              = 0;
+    congestion_window        = 0;
+}
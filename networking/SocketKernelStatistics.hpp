@@ -0,0 +1,148 @@
+#if !defined SOCKET_KERNEL_STATISTICS_HPP
+#define SOCKET_KERNEL_STATISTICS_HPP
+
+#include <cstdint>
+
+// Holds a snapshot of what the kernel knows about a socket.  Unlike
+// SocketStatistics nothing in here is maintained continuously; it's all
+// gathered from the kernel on demand by Socket::getKernelStatistics().  Values
+// the kernel can't provide for a given kind of socket are left at zero.
+class SocketKernelStatistics
+{
+public:
+
+    // Initializes everything to zero by calling reset()
+    SocketKernelStatistics();
+
+    // Does nothing
+    ~SocketKernelStatistics();
+
+    // Sets everything back to zero
+    void reset();
+
+    // Bytes waiting in the receive queue to be read
+    std::uint32_t getReceiveQueueBytes() const;
+    void setReceiveQueueBytes(std::uint32_t receive_queue_bytes);
+
+    // Bytes in the send queue not yet sent (or, for TCP, not yet acknowledged)
+    std::uint32_t getSendQueueBytes() const;
+    void setSendQueueBytes(std::uint32_t send_queue_bytes);
+
+    // Datagrams dropped by the kernel because the receive queue was full
+    std::uint32_t getReceiveDrops() const;
+    void setReceiveDrops(std::uint32_t receive_drops);
+
+    // TCP only; smoothed round trip time and its variance (seconds)
+    double getRoundTripTime() const;
+    void setRoundTripTime(double round_trip_time);
+    double getRoundTripTimeVariance() const;
+    void setRoundTripTimeVariance(double round_trip_time_variance);
+
+    // TCP only; total segments retransmitted over the life of the connection
+    std::uint32_t getRetransmits() const;
+    void setRetransmits(std::uint32_t retransmits);
+
+    // TCP only; current congestion window (segments)
+    std::uint32_t getCongestionWindow() const;
+    void setCongestionWindow(std::uint32_t congestion_window);
+
+private:
+
+    std::uint32_t receive_queue_bytes;
+    std::uint32_t send_queue_bytes;
+    std::uint32_t receive_drops;
+    double        round_trip_time;
+    double        round_trip_time_variance;
+    std::uint32_t retransmits;
+    std::uint32_t congestion_window;
+};
+
+//==============================================================================
+inline std::uint32_t SocketKernelStatistics::getReceiveQueueBytes() const
+{
+    return receive_queue_bytes;
+}
+
+//==============================================================================
+inline void
+SocketKernelStatistics::setReceiveQueueBytes(std::uint32_t receive_queue_bytes)
+{
+    this->receive_queue_bytes = receive_queue_bytes;
+}
+
+//==============================================================================
+inline std::uint32_t SocketKernelStatistics::getSendQueueBytes() const
+{
+    return send_queue_bytes;
+}
+
+//==============================================================================
+inline void
+SocketKernelStatistics::setSendQueueBytes(std::uint32_t send_queue_bytes)
+{
+    this->send_queue_bytes = send_queue_bytes;
+}
+
+//==============================================================================
+inline std::uint32_t SocketKernelStatistics::getReceiveDrops() const
+{
+    return receive_drops;
+}
+
+//==============================================================================
+inline void SocketKernelStatistics::setReceiveDrops(std::uint32_t receive_drops)
+{
+    this->receive_drops = receive_drops;
+}
+
+//==============================================================================
+inline double SocketKernelStatistics::getRoundTripTime() const
+{
+    return round_trip_time;
+}
+
+//==============================================================================
+inline void SocketKernelStatistics::setRoundTripTime(double round_trip_time)
+{
+    this->round_trip_time = round_trip_time;
+}
+
+//==============================================================================
+inline double SocketKernelStatistics::getRoundTripTimeVariance() const
+{
+    return round_trip_time_variance;
+}
+
+//==============================================================================
+inline void SocketKernelStatistics::setRoundTripTimeVariance(
+    double round_trip_time_variance)
+{
+    this->round_trip_time_variance = round_trip_time_variance;
+}
+
+//==============================================================================
+inline std::uint32_t SocketKernelStatistics::getRetransmits() const
+{
+    return retransmits;
+}
+
+//==============================================================================
+inline void SocketKernelStatistics::setRetransmits(std::uint32_t retransmits)
+{
+    this->retransmits = retransmits;
+}
+
+//==============================================================================
+inline std::uint32_t SocketKernelStatistics::getCongestionWindow() const
+{
+    return congestion_window;
+}
+
+//==============================================================================
+inline void
+SocketKernelStatistics::setCongestionWindow(std::uint32_t congestion_window)
+{
+    this->congestion_window = congestion_window;
+}
+
+#endif
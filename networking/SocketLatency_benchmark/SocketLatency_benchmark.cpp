@@ -0,0 +1,277 @@
+// Measures round-trip latency across loopback: one thread sends a small
+// message and waits for it to come back from a second thread that echoes
+// everything it reads.  Every round trip is timed and the distribution
+// reported as percentiles, since the tail usually matters more than the mean.
+// UDP is timed a second time with both ends in busy-poll receive mode, which
+// only makes sense with a core free for each of them.
+//
+// Usage: SocketLatency_benchmark [round trips]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "PosixSocketCommon.hpp"
+#include "Socket.hpp"
+#include "SocketStatistics.hpp"
+#include "TCPSocket.hpp"
+#include "UDPSocket.hpp"
+#include "UnixDatagramSocket.hpp"
+#include "UnixStreamSocket.hpp"
+
+// Size of every message
+static const unsigned int PAYLOAD_SIZE = 64;
+
+// How long busy-polling reads spin before blocking
+static const double SPIN_TIME = 0.001;
+
+// Round trips made before timing starts, to get caches and the scheduler
+// settled
+static const unsigned int WARMUP = 1000;
+
+//==============================================================================
+// Reads exactly 'size' bytes, or one whole message for message-oriented
+// sockets; returns false on error or timeout
+//==============================================================================
+static bool readFully(Socket& socket, unsigned char* buffer, unsigned int size)
+{
+    unsigned int received = 0;
+    while (received < size)
+    {
+        int ret = socket.read(buffer + received, size - received);
+        if (ret <= 0)
+        {
+            return false;
+        }
+        received += ret;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Sorts the round-trip times and prints their percentiles in microseconds
+//==============================================================================
+static void report(const std::string& name, std::vector<double>& times)
+{
+    std::cout << std::left << std::setw(16) << name << std::right;
+
+    if (times.empty())
+    {
+        std::cout << "failed\n";
+        return;
+    }
+
+    std::sort(times.begin(), times.end());
+
+    const double percentiles[] = {50.0, 90.0, 99.0, 99.9};
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        unsigned int index = percentiles[i] / 100.0 * (times.size() - 1);
+        std::cout << std::setw(10) << std::fixed << std::setprecision(2)
+                  << times[index] * 1.0e6;
+    }
+
+    std::cout << std::setw(10) << times.back() * 1.0e6 << "\n";
+}
+
+//==============================================================================
+// Bounces messages off 'echo' from 'client' and reports the round-trip times.
+// Both sockets must already be connected to each other.
+//==============================================================================
+static void pingPong(const std::string& name,
+                     Socket&            client,
+                     Socket&            echo,
+                     unsigned int       round_trips)
+{
+    // Neither side waits forever if something goes wrong
+    client.setBlockingTimeout(1.0);
+    echo.setBlockingTimeout(1.0);
+
+    unsigned int total = WARMUP + round_trips;
+
+    std::thread echoer([&echo, total]()
+    {
+        unsigned char buffer[PAYLOAD_SIZE];
+        for (unsigned int i = 0; i < total; ++i)
+        {
+            if (!readFully(echo, buffer, PAYLOAD_SIZE) ||
+                echo.write(buffer, PAYLOAD_SIZE) !=
+                    static_cast<int>(PAYLOAD_SIZE))
+            {
+                return;
+            }
+        }
+    });
+
+    std::vector<double> times;
+    times.reserve(round_trips);
+
+    unsigned char buffer[PAYLOAD_SIZE] = {0};
+    for (unsigned int i = 0; i < total; ++i)
+    {
+        double start = PosixSocketCommon::getMonotonicSeconds();
+        if (client.write(buffer, PAYLOAD_SIZE) !=
+                static_cast<int>(PAYLOAD_SIZE) ||
+            !readFully(client, buffer, PAYLOAD_SIZE))
+        {
+            times.clear();
+            break;
+        }
+
+        if (i >= WARMUP)
+        {
+            times.push_back(PosixSocketCommon::getMonotonicSeconds() - start);
+        }
+    }
+
+    echoer.join();
+
+    report(name, times);
+}
+
+//==============================================================================
+// UDP datagrams
+//==============================================================================
+static void udpLatency(unsigned int round_trips)
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+
+    UDPSocket client;
+    UDPSocket echo;
+    if (!client.bind(port1) || !echo.bind(port2) ||
+        !client.sendTo("localhost", port2) || !echo.sendTo("localhost", port1))
+    {
+        std::cout << "UDP setup failed, skipping\n";
+        return;
+    }
+
+    pingPong("UDP", client, echo, round_trips);
+}
+
+//==============================================================================
+// UDP datagrams with both ends spinning rather than sleeping while they wait
+//==============================================================================
+static void udpBusyPollLatency(unsigned int round_trips)
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+
+    UDPSocket client;
+    UDPSocket echo;
+    if (!client.bind(port1) || !echo.bind(port2) ||
+        !client.sendTo("localhost", port2) ||
+        !echo.sendTo("localhost", port1) ||
+        !client.enableBusyPoll(SPIN_TIME) || !echo.enableBusyPoll(SPIN_TIME))
+    {
+        std::cout << "UDP busy-poll setup failed, skipping\n";
+        return;
+    }
+
+    pingPong("UDP busy-poll", client, echo, round_trips);
+
+    SocketStatistics statistics;
+    echo.getStatistics(statistics);
+    std::cout << "  echo spins found data " << statistics.getSpinHits()
+              << " times, blocked " << statistics.getSpinFallbacks()
+              << " times; mean delivery latency " << std::setprecision(2)
+              << statistics.getDeliveryLatencyMean() * 1.0e6 << " us\n";
+}
+
+//==============================================================================
+// A TCP connection
+//==============================================================================
+static void tcpLatency(unsigned int round_trips)
+{
+    unsigned int port = 0;
+
+    TCPSocket client;
+    TCPSocket echo;
+    if (!echo.bind(port) || !echo.listen() ||
+        !client.connect("localhost", port) || !echo.accept())
+    {
+        std::cout << "TCP setup failed, skipping\n";
+        return;
+    }
+
+    pingPong("TCP", client, echo, round_trips);
+}
+
+//==============================================================================
+// A Unix domain stream connection
+//==============================================================================
+static void unixStreamLatency(unsigned int round_trips)
+{
+    std::ostringstream path;
+    path << "/tmp/SocketLatency_benchmark_" << getpid();
+
+    UnixStreamSocket client;
+    UnixStreamSocket echo;
+    if (!echo.bind(path.str()) || !echo.listen() ||
+        !client.connect(path.str()) || !echo.accept())
+    {
+        std::cout << "Unix stream setup failed, skipping\n";
+        return;
+    }
+
+    pingPong("Unix stream", client, echo, round_trips);
+}
+
+//==============================================================================
+// Unix domain datagrams
+//==============================================================================
+static void unixDatagramLatency(unsigned int round_trips)
+{
+    std::ostringstream path;
+    path << "/tmp/SocketLatency_benchmark_" << getpid();
+
+    UnixDatagramSocket client;
+    UnixDatagramSocket echo;
+    if (!client.bind(path.str() + "_client") ||
+        !echo.bind(path.str() + "_echo") ||
+        !client.sendTo(path.str() + "_echo") ||
+        !echo.sendTo(path.str() + "_client"))
+    {
+        std::cout << "Unix datagram setup failed, skipping\n";
+        return;
+    }
+
+    pingPong("Unix datagram", client, echo, round_trips);
+}
+
+//==============================================================================
+int main(int argc, char** argv)
+{
+    unsigned int round_trips = 100000;
+    if (argc > 1)
+    {
+        round_trips = std::strtoul(argv[1], 0, 10);
+    }
+
+    if (round_trips == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [round trips]\n";
+        return 1;
+    }
+
+    std::cout << "Round-trip times in microseconds\n"
+              << std::left << std::setw(16) << "Socket" << std::right
+              << std::setw(10) << "p50" << std::setw(10) << "p90"
+              << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+              << std::setw(10) << "max" << "\n";
+
+    udpLatency(round_trips);
+    udpBusyPollLatency(round_trips);
+    tcpLatency(round_trips);
+    unixStreamLatency(round_trips);
+    unixDatagramLatency(round_trips);
+
+    return 0;
+}
@@ -0,0 +1,589 @@
+#include <cerrno>
+#include <coroutine>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "SocketScheduler.hpp"
+
+#include "Socket.hpp"
+#include "SocketTask.hpp"
+#include "TCPSocket.hpp"
+#include "UDPSocket.hpp"
+
+const unsigned int SocketScheduler::EVENTS_MAX;
+
+//==============================================================================
+// Tells the scheduler a spawned task has finished
+//==============================================================================
+void SocketTaskPromiseBase::taskFinished(SocketScheduler* scheduler,
+                                         void*            address)
+{
+    scheduler->taskFinished(address);
+}
+
+//==============================================================================
+// Creates the epoll set
+//==============================================================================
+SocketScheduler::SocketScheduler() :
+    parked(0),
+    stopped(false)
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    if (epoll_fd == -1)
+    {
+        throw std::runtime_error(strerror(errno));
+    }
+}
+
+//==============================================================================
+// Destroys unfinished tasks and closes the epoll set
+//==============================================================================
+SocketScheduler::~SocketScheduler()
+{
+    // Destroying a task destroys whatever tasks it's awaiting along with it
+    for (std::unordered_set<void*>::iterator i = tasks.begin();
+         i != tasks.end();
+         ++i)
+    {
+        std::coroutine_handle<>::from_address(*i).destroy();
+    }
+
+    close(epoll_fd);
+}
+
+//==============================================================================
+// Takes over a task and queues it to run
+//==============================================================================
+void SocketScheduler::spawn(SocketTask<> task)
+{
+    std::coroutine_handle<SocketTask<>::promise_type> handle = task.handle;
+    task.handle = nullptr;
+
+    handle.promise().scheduler = this;
+
+    tasks.insert(handle.address());
+    ready.push_back(handle);
+}
+
+//==============================================================================
+// Runs tasks until they're all done
+//==============================================================================
+void SocketScheduler::run()
+{
+    epoll_event events[EVENTS_MAX];
+
+    while (!stopped && !tasks.empty())
+    {
+        while (!ready.empty() && !stopped)
+        {
+            std::coroutine_handle<> handle = ready.front();
+            ready.pop_front();
+            handle.resume();
+        }
+
+        if (stopped || tasks.empty() || !ready.empty())
+        {
+            continue;
+        }
+
+        // Nothing's waiting on a socket, so nothing can ever wake up
+        if (parked == 0)
+        {
+            break;
+        }
+
+        int count = epoll_wait(epoll_fd, events, EVENTS_MAX, -1);
+
+        if (count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+#if defined DEBUG
+            perror("SocketScheduler::run");
+#endif
+            break;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            handleEvent(events[i].data.fd, events[i].events);
+        }
+    }
+
+    stopped = false;
+}
+
+//==============================================================================
+// Stops watching a socket that's about to go away
+//==============================================================================
+void SocketScheduler::forget(Socket& socket)
+{
+    int fd = socket.getDescriptor();
+
+    std::unordered_map<int, Registration>::iterator i = registrations.find(fd);
+    if (i == registrations.end())
+    {
+        return;
+    }
+
+    Registration registration = i->second;
+    registrations.erase(i);
+
+    // The descriptor is still open, so epoll would keep reporting on it, and
+    // under its number if the number went to some new socket after all
+    if (registration.added && epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, 0) == -1)
+    {
+#if defined DEBUG
+        perror("SocketScheduler::forget");
+#endif
+    }
+
+    if (registration.reader)
+    {
+        abandon(registration.reader);
+    }
+
+    if (registration.writer)
+    {
+        abandon(registration.writer);
+    }
+}
+
+//==============================================================================
+// Waits for the socket to become ready for the operation
+//==============================================================================
+bool SocketScheduler::park(Operation* operation)
+{
+    Registration& registration = registrations[operation->fd];
+
+    Operation*& slot =
+        operation->for_write ? registration.writer : registration.reader;
+
+    // Only one task can wait to read (or write) a socket at a time
+    if (slot)
+    {
+        errno = EBUSY;
+        return false;
+    }
+
+    slot = operation;
+
+    if (!arm(operation->fd, registration))
+    {
+        slot = 0;
+        return false;
+    }
+
+    parked++;
+    return true;
+}
+
+//==============================================================================
+// Tells epoll what to report for a descriptor
+//==============================================================================
+bool SocketScheduler::arm(int fd, Registration& registration)
+{
+    // One-shot, so nothing more is heard about a descriptor until something
+    // is waiting on it again
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events  = EPOLLONESHOT;
+    event.data.fd = fd;
+
+    if (registration.reader)
+    {
+        event.events |= EPOLLIN | EPOLLRDHUP;
+    }
+
+    if (registration.writer)
+    {
+        event.events |= EPOLLOUT;
+    }
+
+    if (registration.added)
+    {
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0)
+        {
+            return true;
+        }
+
+        // Closing a descriptor takes it out of the epoll set, so this may be a
+        // new socket that was given the same number; add it below
+        if (errno != ENOENT)
+        {
+#if defined DEBUG
+            perror("SocketScheduler::arm");
+#endif
+            return false;
+        }
+    }
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+    {
+#if defined DEBUG
+        perror("SocketScheduler::arm");
+#endif
+        return false;
+    }
+
+    registration.added = true;
+    return true;
+}
+
+//==============================================================================
+// Finishes whatever operations a ready descriptor allows
+//==============================================================================
+void SocketScheduler::handleEvent(int fd, unsigned int events)
+{
+    Registration& registration = registrations[fd];
+
+    // Errors and hangups are reported to both sides; the retried operation
+    // will come back with whatever the problem is
+    const unsigned int problems = EPOLLERR | EPOLLHUP;
+
+    Operation* operations[2] = {0, 0};
+
+    if (registration.reader &&
+        (events & (EPOLLIN | EPOLLRDHUP | problems)) &&
+        registration.reader->attempt())
+    {
+        operations[0] = registration.reader;
+        registration.reader = 0;
+    }
+
+    if (registration.writer &&
+        (events & (EPOLLOUT | problems)) &&
+        registration.writer->attempt())
+    {
+        operations[1] = registration.writer;
+        registration.writer = 0;
+    }
+
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        if (operations[i])
+        {
+            parked--;
+            ready.push_back(operations[i]->waiting);
+        }
+    }
+
+    // Anything still waiting needs epoll to keep watching
+    if ((registration.reader || registration.writer) &&
+        !arm(fd, registration))
+    {
+        Operation* remaining[2] = {registration.reader, registration.writer};
+        registration.reader = 0;
+        registration.writer = 0;
+
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            if (remaining[i])
+            {
+                abandon(remaining[i]);
+            }
+        }
+    }
+}
+
+//==============================================================================
+// Gives up on a parked operation
+//==============================================================================
+void SocketScheduler::abandon(Operation* operation)
+{
+    parked--;
+    operation->fail();
+    ready.push_back(operation->waiting);
+}
+
+//==============================================================================
+// Forgets a task that has finished
+//==============================================================================
+void SocketScheduler::taskFinished(void* address)
+{
+    tasks.erase(address);
+}
+
+//==============================================================================
+// Reads from a TCP socket
+//==============================================================================
+SocketScheduler::IoOperation SocketScheduler::read(TCPSocket&     socket,
+                                                   unsigned char* buffer,
+                                                   unsigned int   size)
+{
+    return IoOperation(*this, socket.getDescriptor(), socket, buffer, 0, size);
+}
+
+//==============================================================================
+// Reads from a UDP socket
+//==============================================================================
+SocketScheduler::IoOperation SocketScheduler::read(UDPSocket&     socket,
+                                                   unsigned char* buffer,
+                                                   unsigned int   size)
+{
+    return IoOperation(*this, socket.getDescriptor(), socket, buffer, 0, size);
+}
+
+//==============================================================================
+// Writes to a TCP socket
+//==============================================================================
+SocketScheduler::IoOperation SocketScheduler::write(
+    TCPSocket&           socket,
+    const unsigned char* buffer,
+    unsigned int         size)
+{
+    return IoOperation(*this, socket.getDescriptor(), socket, 0, buffer, size);
+}
+
+//==============================================================================
+// Writes to a UDP socket
+//==============================================================================
+SocketScheduler::IoOperation SocketScheduler::write(
+    UDPSocket&           socket,
+    const unsigned char* buffer,
+    unsigned int         size)
+{
+    return IoOperation(*this, socket.getDescriptor(), socket, 0, buffer, size);
+}
+
+//==============================================================================
+// Accepts a connection
+//==============================================================================
+SocketScheduler::AcceptOperation SocketScheduler::accept(TCPSocket& listener)
+{
+    return AcceptOperation(*this, listener.getDescriptor(), listener);
+}
+
+//==============================================================================
+// Connects a TCP socket
+//==============================================================================
+SocketScheduler::ConnectOperation SocketScheduler::connect(
+    TCPSocket&         socket,
+    const std::string& hostname,
+    unsigned int       port)
+{
+    return ConnectOperation(
+        *this, socket.getDescriptor(), socket, hostname, port);
+}
+
+//==============================================================================
+// Remembers what the operation is for
+//==============================================================================
+SocketScheduler::Operation::Operation(SocketScheduler& scheduler,
+                                      int              fd,
+                                      bool             for_write) :
+    scheduler(scheduler),
+    fd(fd),
+    for_write(for_write)
+{
+}
+
+//==============================================================================
+// Does nothing
+//==============================================================================
+SocketScheduler::Operation::~Operation()
+{
+}
+
+//==============================================================================
+// Tries the operation right away
+//==============================================================================
+bool SocketScheduler::Operation::await_ready()
+{
+    return attempt();
+}
+
+//==============================================================================
+// Parks the awaiting task
+//==============================================================================
+bool SocketScheduler::Operation::await_suspend(std::coroutine_handle<> handle)
+{
+    waiting = handle;
+
+    if (!scheduler.park(this))
+    {
+        fail();
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Checks whether the last attempt failed only because it would have blocked
+//==============================================================================
+bool SocketScheduler::Operation::wouldBlock()
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+//==============================================================================
+// Sets up a read or write; the socket is made non-blocking if it isn't already
+//==============================================================================
+SocketScheduler::IoOperation::IoOperation(SocketScheduler&     scheduler,
+                                          int                  fd,
+                                          Socket&              socket,
+                                          unsigned char*       read_buffer,
+                                          const unsigned char* write_buffer,
+                                          unsigned int         size) :
+    Operation(scheduler, fd, write_buffer != 0),
+    socket(socket),
+    read_buffer(read_buffer),
+    write_buffer(write_buffer),
+    size(size),
+    result(-1)
+{
+    if (socket.isBlockingEnabled())
+    {
+        socket.disableBlocking();
+    }
+}
+
+//==============================================================================
+// Reads or writes without blocking
+//==============================================================================
+bool SocketScheduler::IoOperation::attempt()
+{
+    if (write_buffer)
+    {
+        result = socket.write(write_buffer, size);
+    }
+    else
+    {
+        result = socket.read(read_buffer, size);
+    }
+
+    return !(result == -1 && wouldBlock());
+}
+
+//==============================================================================
+// Reports an error
+//==============================================================================
+void SocketScheduler::IoOperation::fail()
+{
+    result = -1;
+}
+
+//==============================================================================
+// Gives the read or write result
+//==============================================================================
+int SocketScheduler::IoOperation::await_resume()
+{
+    return result;
+}
+
+//==============================================================================
+// Sets up an accept; the listener is made non-blocking if it isn't already
+//==============================================================================
+SocketScheduler::AcceptOperation::AcceptOperation(SocketScheduler& scheduler,
+                                                  int              fd,
+                                                  TCPSocket&       listener) :
+    Operation(scheduler, fd, false),
+    listener(listener),
+    result(0)
+{
+    if (listener.isBlockingEnabled())
+    {
+        listener.disableBlocking();
+    }
+}
+
+//==============================================================================
+// Accepts without blocking
+//==============================================================================
+bool SocketScheduler::AcceptOperation::attempt()
+{
+    result = listener.accept(false);
+    return result || !wouldBlock();
+}
+
+//==============================================================================
+// Reports an error
+//==============================================================================
+void SocketScheduler::AcceptOperation::fail()
+{
+    result = 0;
+}
+
+//==============================================================================
+// Gives the accepted connection
+//==============================================================================
+TCPSocket* SocketScheduler::AcceptOperation::await_resume()
+{
+    return result;
+}
+
+//==============================================================================
+// Sets up a connect; the socket is made non-blocking if it isn't already
+//==============================================================================
+SocketScheduler::ConnectOperation::ConnectOperation(
+    SocketScheduler&   scheduler,
+    int                fd,
+    TCPSocket&         socket,
+    const std::string& hostname,
+    unsigned int       port) :
+    Operation(scheduler, fd, true),
+    socket(socket),
+    hostname(hostname),
+    port(port),
+    started(false),
+    result(false)
+{
+    if (socket.isBlockingEnabled())
+    {
+        socket.disableBlocking();
+    }
+}
+
+//==============================================================================
+// Starts connecting, or checks how connecting went
+//==============================================================================
+bool SocketScheduler::ConnectOperation::attempt()
+{
+    if (!started)
+    {
+        started = true;
+        result  = socket.connect(hostname, port);
+
+        // A non-blocking connect that can't finish immediately carries on in
+        // the background, and the socket becomes writable when it's done
+        return result || errno != EINPROGRESS;
+    }
+
+    int       error = 0;
+    socklen_t size  = sizeof(error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) == -1)
+    {
+        error = errno;
+    }
+
+    result = error == 0;
+    errno  = error;
+
+    return true;
+}
+
+//==============================================================================
+// Reports an error
+//==============================================================================
+void SocketScheduler::ConnectOperation::fail()
+{
+    result = false;
+}
+
+//==============================================================================
+// Gives the result of the connect
+//==============================================================================
+bool SocketScheduler::ConnectOperation::await_resume()
+{
+    return result;
+}
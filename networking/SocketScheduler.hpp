@@ -0,0 +1,326 @@
+#if !defined SOCKET_SCHEDULER_HPP
+#define SOCKET_SCHEDULER_HPP
+
+#if __cplusplus < 202002L
+#error "SocketScheduler needs C++20; configure with the CXX20 option"
+#endif
+
+#include <coroutine>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "SocketTask.hpp"
+
+class Socket;
+class TCPSocket;
+class UDPSocket;
+
+// Runs SocketTask coroutines on a single thread.  Tasks do their socket work by
+// awaiting the operations below, which make the socket non-blocking and try
+// the operation right away; only if it would block is the task parked, with
+// the socket registered in an epoll set, while other tasks run.  When epoll
+// reports the socket ready the operation is retried and the task resumed with
+// the result.  This lets one thread serve many connections with straight-line
+// code:
+//
+//     SocketTask<> echo(SocketScheduler& scheduler, TCPSocket* socket)
+//     {
+//         unsigned char buffer[1024];
+//         int ret;
+//         while ((ret = co_await scheduler.read(*socket, buffer, 1024)) > 0)
+//         {
+//             co_await scheduler.write(*socket, buffer, ret);
+//         }
+//         delete socket;
+//     }
+//
+// A socket a task may be waiting on must be passed to forget() before it's
+// closed or deleted; otherwise the waiting task is never resumed, and run()
+// may wait forever on it.
+//
+// Blocking timeouts set on the sockets don't apply to awaited operations.
+// Everything here is single-threaded: the scheduler and the sockets its tasks
+// use must only be touched from the thread calling run().  Linux only.
+class SocketScheduler
+{
+public:
+
+    // Creates the epoll set; throws std::runtime_error if that fails
+    SocketScheduler();
+
+    // Destroys any spawned tasks that haven't finished
+    ~SocketScheduler();
+
+    // Takes ownership of 'task' and has it start running the next time run()
+    // gets to it.  The task is destroyed when it finishes.  An exception
+    // escaping a spawned task terminates the program.
+    void spawn(SocketTask<> task);
+
+    // Runs tasks until all spawned tasks have finished or stop() is called.
+    // Also returns if every remaining task is waiting on something other than
+    // a socket, since then nothing would ever wake them.
+    void run();
+
+    // Has run() return once the task calling this next suspends (or, if
+    // called from outside any task, as soon as run() is next entered).
+    void stop();
+
+    // Stops watching the given socket, which must be done before closing or
+    // deleting a socket a task may be waiting on.  Any task waiting on it is
+    // resumed with the operation failed (-1, 0 or false), as it would be for
+    // a socket that couldn't be waited on.  Does nothing if nothing was ever
+    // waiting on the socket.
+    void forget(Socket& socket);
+
+    // Returns the number of spawned tasks that haven't finished
+    unsigned int getTaskCount() const;
+
+    // Base for everything a task can await here
+    class Operation
+    {
+    public:
+
+        // Returns true (so the task keeps going without suspending) if the
+        // operation could be done right away
+        bool await_ready();
+
+        // Parks the task until the socket is ready.  Returns false (resuming
+        // the task immediately) if the socket can't be waited on, in which
+        // case the operation reports failure.
+        bool await_suspend(std::coroutine_handle<> handle);
+
+    protected:
+
+        Operation(SocketScheduler& scheduler, int fd, bool for_write);
+
+        virtual ~Operation();
+
+        // Tries the operation without blocking.  Returns false if it would
+        // have blocked.
+        virtual bool attempt() = 0;
+
+        // Records that the socket couldn't be waited on
+        virtual void fail() = 0;
+
+        // Returns true if errno says the last attempt would have blocked
+        static bool wouldBlock();
+
+    private:
+
+        // Parks and resumes operations
+        friend class SocketScheduler;
+
+        SocketScheduler& scheduler;
+
+        int fd;
+
+        // Whether this waits for room to write rather than data to read
+        bool for_write;
+
+        // Task to resume once the operation is done
+        std::coroutine_handle<> waiting;
+
+        Operation(const Operation&) = delete;
+        Operation& operator=(const Operation&) = delete;
+    };
+
+    // A read or write; gives what Socket::read or Socket::write would have
+    class IoOperation : public Operation
+    {
+    public:
+
+        int await_resume();
+
+    protected:
+
+        virtual bool attempt();
+
+        virtual void fail();
+
+    private:
+
+        // Made by SocketScheduler::read and SocketScheduler::write
+        friend class SocketScheduler;
+
+        IoOperation(SocketScheduler&     scheduler,
+                    int                  fd,
+                    Socket&              socket,
+                    unsigned char*       read_buffer,
+                    const unsigned char* write_buffer,
+                    unsigned int         size);
+
+        Socket& socket;
+
+        // Exactly one of these is set
+        unsigned char*       read_buffer;
+        const unsigned char* write_buffer;
+
+        unsigned int size;
+
+        int result;
+    };
+
+    // Gives the accepted connection, or 0 on error
+    class AcceptOperation : public Operation
+    {
+    public:
+
+        TCPSocket* await_resume();
+
+    protected:
+
+        virtual bool attempt();
+
+        virtual void fail();
+
+    private:
+
+        // Made by SocketScheduler::accept
+        friend class SocketScheduler;
+
+        AcceptOperation(SocketScheduler& scheduler,
+                        int              fd,
+                        TCPSocket&       listener);
+
+        TCPSocket& listener;
+
+        TCPSocket* result;
+    };
+
+    // Gives true once connected, or false on error
+    class ConnectOperation : public Operation
+    {
+    public:
+
+        bool await_resume();
+
+    protected:
+
+        virtual bool attempt();
+
+        virtual void fail();
+
+    private:
+
+        // Made by SocketScheduler::connect
+        friend class SocketScheduler;
+
+        ConnectOperation(SocketScheduler&   scheduler,
+                         int                fd,
+                         TCPSocket&         socket,
+                         const std::string& hostname,
+                         unsigned int       port);
+
+        TCPSocket& socket;
+
+        std::string hostname;
+
+        unsigned int port;
+
+        // Whether connect() has been called yet
+        bool started;
+
+        bool result;
+    };
+
+    // Reads from the given socket, waiting as long as it takes for data.
+    // Awaiting this gives what read() would.
+    IoOperation read(TCPSocket&     socket,
+                     unsigned char* buffer,
+                     unsigned int   size);
+    IoOperation read(UDPSocket&     socket,
+                     unsigned char* buffer,
+                     unsigned int   size);
+
+    // Writes to the given socket, waiting as long as it takes for room.
+    // Awaiting this gives what write() would; like write() that may be less
+    // than 'size' for a TCP socket.
+    IoOperation write(TCPSocket&           socket,
+                      const unsigned char* buffer,
+                      unsigned int         size);
+    IoOperation write(UDPSocket&           socket,
+                      const unsigned char* buffer,
+                      unsigned int         size);
+
+    // Accepts a connection on the given listening socket, waiting as long as
+    // it takes for one.  Awaiting this gives a new socket for the connection
+    // (as with TCPSocket::accept(false)), which the task owns, or 0 on error.
+    AcceptOperation accept(TCPSocket& listener);
+
+    // Connects the given socket, waiting as long as the connection takes to
+    // set up.  Awaiting this gives true once connected.  Note that looking up
+    // 'hostname' still blocks the whole thread.
+    ConnectOperation connect(TCPSocket&         socket,
+                             const std::string& hostname,
+                             unsigned int       port);
+
+    // Most epoll events handled per epoll_wait() call
+    static const unsigned int EVENTS_MAX = 256;
+
+private:
+
+    // Lets finished tasks be cleaned up
+    friend class SocketTaskPromiseBase;
+
+    // The operations waiting on one descriptor
+    struct Registration
+    {
+        Operation* reader;
+        Operation* writer;
+
+        // Whether the descriptor has been added to the epoll set
+        bool added;
+    };
+
+    // Registers interest in the operation's descriptor.  Returns false if
+    // epoll won't take it.
+    bool park(Operation* operation);
+
+    // Points epoll at whatever the given registration is waiting for
+    bool arm(int fd, Registration& registration);
+
+    // Retries the operations waiting on a descriptor epoll reported ready
+    void handleEvent(int fd, unsigned int events);
+
+    // Resumes the given operation, which was parked, as failed
+    void abandon(Operation* operation);
+
+    // Forgets a finished spawned task
+    void taskFinished(void* address);
+
+    int epoll_fd;
+
+    // Tasks ready to run
+    std::deque<std::coroutine_handle<> > ready;
+
+    // Frame addresses of every unfinished spawned task
+    std::unordered_set<void*> tasks;
+
+    std::unordered_map<int, Registration> registrations;
+
+    // Number of operations currently parked
+    unsigned int parked;
+
+    bool stopped;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    SocketScheduler(const SocketScheduler&);
+    SocketScheduler& operator=(const SocketScheduler&);
+};
+
+//==============================================================================
+inline unsigned int SocketScheduler::getTaskCount() const
+{
+    return tasks.size();
+}
+
+//==============================================================================
+inline void SocketScheduler::stop()
+{
+    stopped = true;
+}
+
+#endif
@@ -0,0 +1,453 @@
+#include <stdexcept>
+#include <string>
+
+#include "SocketScheduler_test.hpp"
+
+#include "SocketScheduler.hpp"
+#include "SocketTask.hpp"
+#include "TCPSocket.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+#include "UDPSocket.hpp"
+
+TEST_PROGRAM_MAIN(SocketScheduler_test);
+
+// Size of every message sent in these tests
+static const unsigned int MESSAGE_SIZE = 64;
+
+//==============================================================================
+void SocketScheduler_test::addTestCases()
+{
+    ADD_TEST_CASE(Echo);
+    ADD_TEST_CASE(Datagrams);
+    ADD_TEST_CASE(NestedTasks);
+    ADD_TEST_CASE(Stop);
+    ADD_TEST_CASE(Forget);
+}
+
+//==============================================================================
+// Fills 'message' with a pattern that depends on 'seed'
+//==============================================================================
+static void fillMessage(unsigned char* message, unsigned int seed)
+{
+    for (unsigned int i = 0; i < MESSAGE_SIZE; ++i)
+    {
+        message[i] = seed * 31 + i;
+    }
+}
+
+//==============================================================================
+// Sends back everything received on 'socket' until the peer closes it
+//==============================================================================
+static SocketTask<> echo(SocketScheduler& scheduler, TCPSocket* socket)
+{
+    unsigned char buffer[MESSAGE_SIZE];
+    int ret;
+    while ((ret = co_await scheduler.read(*socket, buffer, MESSAGE_SIZE)) > 0)
+    {
+        int sent = 0;
+        while (sent < ret)
+        {
+            int written =
+                co_await scheduler.write(*socket, buffer + sent, ret - sent);
+            if (written <= 0)
+            {
+                break;
+            }
+            sent += written;
+        }
+    }
+
+    delete socket;
+}
+
+//==============================================================================
+// Accepts 'connections' connections and echoes each in its own task
+//==============================================================================
+static SocketTask<> serve(SocketScheduler& scheduler,
+                          TCPSocket&       listener,
+                          unsigned int     connections)
+{
+    for (unsigned int i = 0; i < connections; ++i)
+    {
+        TCPSocket* socket = co_await scheduler.accept(listener);
+        if (!socket)
+        {
+            co_return;
+        }
+
+        scheduler.spawn(echo(scheduler, socket));
+    }
+}
+
+//==============================================================================
+// Connects, sends one message and counts it in 'echoed' if it comes back intact
+//==============================================================================
+static SocketTask<> client(SocketScheduler& scheduler,
+                           unsigned int     port,
+                           unsigned int     seed,
+                           unsigned int&    echoed)
+{
+    TCPSocket socket;
+    if (!(co_await scheduler.connect(socket, "localhost", port)))
+    {
+        co_return;
+    }
+
+    unsigned char send[MESSAGE_SIZE];
+    fillMessage(send, seed);
+
+    unsigned int sent = 0;
+    while (sent < MESSAGE_SIZE)
+    {
+        int ret =
+            co_await scheduler.write(socket, send + sent, MESSAGE_SIZE - sent);
+        if (ret <= 0)
+        {
+            co_return;
+        }
+        sent += ret;
+    }
+
+    unsigned char recv[MESSAGE_SIZE];
+    unsigned int received = 0;
+    while (received < MESSAGE_SIZE)
+    {
+        int ret = co_await scheduler.read(
+            socket, recv + received, MESSAGE_SIZE - received);
+        if (ret <= 0)
+        {
+            co_return;
+        }
+        received += ret;
+    }
+
+    for (unsigned int i = 0; i < MESSAGE_SIZE; ++i)
+    {
+        if (recv[i] != send[i])
+        {
+            co_return;
+        }
+    }
+
+    echoed++;
+}
+
+//==============================================================================
+Test::Result SocketScheduler_test::Echo::body()
+{
+    // Enough connections that serving them one at a time with blocking calls
+    // would be hopeless
+    const unsigned int connections = 200;
+
+    unsigned int port = 0;
+    TCPSocket listener;
+    MUST_BE_TRUE(listener.bind(port));
+    MUST_BE_TRUE(listener.listen());
+
+    SocketScheduler scheduler;
+    scheduler.spawn(serve(scheduler, listener, connections));
+
+    unsigned int echoed = 0;
+    for (unsigned int i = 0; i < connections; ++i)
+    {
+        scheduler.spawn(client(scheduler, port, i, echoed));
+    }
+
+    MUST_BE_TRUE(scheduler.getTaskCount() == connections + 1);
+
+    scheduler.run();
+
+    MUST_BE_TRUE(echoed == connections);
+    MUST_BE_TRUE(scheduler.getTaskCount() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+// Reads 'count' datagrams and counts the ones that arrive in order
+//==============================================================================
+static SocketTask<> receiveDatagrams(SocketScheduler& scheduler,
+                                     UDPSocket&       socket,
+                                     unsigned int     count,
+                                     unsigned int&    in_order)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned char recv[MESSAGE_SIZE];
+        int ret = co_await scheduler.read(socket, recv, MESSAGE_SIZE);
+        if (ret != static_cast<int>(MESSAGE_SIZE))
+        {
+            co_return;
+        }
+
+        unsigned char expected[MESSAGE_SIZE];
+        fillMessage(expected, i);
+
+        bool same = true;
+        for (unsigned int j = 0; j < MESSAGE_SIZE; ++j)
+        {
+            same = same && recv[j] == expected[j];
+        }
+
+        if (same)
+        {
+            in_order++;
+        }
+    }
+}
+
+//==============================================================================
+// Sends 'count' datagrams
+//==============================================================================
+static SocketTask<> sendDatagrams(SocketScheduler& scheduler,
+                                  UDPSocket&       socket,
+                                  unsigned int     count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned char send[MESSAGE_SIZE];
+        fillMessage(send, i);
+        co_await scheduler.write(socket, send, MESSAGE_SIZE);
+    }
+}
+
+//==============================================================================
+Test::Result SocketScheduler_test::Datagrams::body()
+{
+    const unsigned int count = 100;
+
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+    UDPSocket socket1;
+    UDPSocket socket2;
+    MUST_BE_TRUE(socket1.bind(port1));
+    MUST_BE_TRUE(socket2.bind(port2));
+    MUST_BE_TRUE(socket1.sendTo("localhost", port2));
+
+    SocketScheduler scheduler;
+
+    // The receiver goes first so it has to wait for the sender
+    unsigned int in_order = 0;
+    scheduler.spawn(receiveDatagrams(scheduler, socket2, count, in_order));
+    scheduler.spawn(sendDatagrams(scheduler, socket1, count));
+
+    scheduler.run();
+
+    MUST_BE_TRUE(in_order == count);
+    MUST_BE_TRUE(scheduler.getTaskCount() == 0);
+
+    // The scheduler left the sockets non-blocking
+    MUST_BE_FALSE(socket1.isBlockingEnabled());
+    MUST_BE_FALSE(socket2.isBlockingEnabled());
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+// Returns the sum right away
+//==============================================================================
+static SocketTask<int> add(int a, int b)
+{
+    co_return a + b;
+}
+
+//==============================================================================
+// Waits for a datagram and returns its size
+//==============================================================================
+static SocketTask<int> waitForDatagram(SocketScheduler& scheduler,
+                                       UDPSocket&       socket)
+{
+    unsigned char buffer[MESSAGE_SIZE];
+    co_return co_await scheduler.read(socket, buffer, MESSAGE_SIZE);
+}
+
+//==============================================================================
+// Throws out of a task
+//==============================================================================
+static SocketTask<std::string> fail()
+{
+    throw std::runtime_error("failed");
+    co_return std::string();
+}
+
+//==============================================================================
+// Awaits each of the tasks above and records what came of them
+//==============================================================================
+static SocketTask<> awaitAll(SocketScheduler& scheduler,
+                             UDPSocket&       socket,
+                             int&             sum,
+                             int&             size,
+                             bool&            caught)
+{
+    sum  = co_await add(2, 3);
+    size = co_await waitForDatagram(scheduler, socket);
+
+    try
+    {
+        co_await fail();
+    }
+    catch (std::runtime_error& e)
+    {
+        caught = std::string(e.what()) == "failed";
+    }
+}
+
+//==============================================================================
+// Sends one datagram
+//==============================================================================
+static SocketTask<> sendOne(SocketScheduler& scheduler, UDPSocket& socket)
+{
+    unsigned char buffer[MESSAGE_SIZE] = {0};
+    co_await scheduler.write(socket, buffer, 10);
+}
+
+//==============================================================================
+Test::Result SocketScheduler_test::NestedTasks::body()
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+    UDPSocket socket1;
+    UDPSocket socket2;
+    MUST_BE_TRUE(socket1.bind(port1));
+    MUST_BE_TRUE(socket2.bind(port2));
+    MUST_BE_TRUE(socket1.sendTo("localhost", port2));
+
+    SocketScheduler scheduler;
+
+    int  sum    = 0;
+    int  size   = 0;
+    bool caught = false;
+    scheduler.spawn(awaitAll(scheduler, socket2, sum, size, caught));
+    scheduler.spawn(sendOne(scheduler, socket1));
+
+    scheduler.run();
+
+    MUST_BE_TRUE(sum == 5);
+    MUST_BE_TRUE(size == 10);
+    MUST_BE_TRUE(caught);
+    MUST_BE_TRUE(scheduler.getTaskCount() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+// Stops the scheduler, then waits for a datagram
+//==============================================================================
+static SocketTask<> stopThenWait(SocketScheduler& scheduler,
+                                 UDPSocket&       socket,
+                                 bool&            received)
+{
+    scheduler.stop();
+
+    unsigned char buffer[MESSAGE_SIZE];
+    received = co_await scheduler.read(socket, buffer, MESSAGE_SIZE) > 0;
+}
+
+//==============================================================================
+Test::Result SocketScheduler_test::Stop::body()
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+    UDPSocket socket1;
+    UDPSocket socket2;
+    MUST_BE_TRUE(socket1.bind(port1));
+    MUST_BE_TRUE(socket2.bind(port2));
+    MUST_BE_TRUE(socket1.sendTo("localhost", port2));
+
+    bool received1 = false;
+    bool received2 = false;
+
+    {
+        SocketScheduler scheduler;
+        scheduler.spawn(stopThenWait(scheduler, socket2, received1));
+
+        // Returns with the task still waiting
+        scheduler.run();
+        MUST_BE_TRUE(scheduler.getTaskCount() == 1);
+        MUST_BE_FALSE(received1);
+
+        // Picks up where it left off
+        unsigned char buffer[MESSAGE_SIZE] = {0};
+        MUST_BE_TRUE(socket1.write(buffer, MESSAGE_SIZE) ==
+                     static_cast<int>(MESSAGE_SIZE));
+        scheduler.run();
+        MUST_BE_TRUE(scheduler.getTaskCount() == 0);
+        MUST_BE_TRUE(received1);
+
+        // Stopped again and left waiting; destroying the scheduler cleans it up
+        scheduler.spawn(stopThenWait(scheduler, socket2, received2));
+        scheduler.run();
+        MUST_BE_TRUE(scheduler.getTaskCount() == 1);
+    }
+
+    MUST_BE_FALSE(received2);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+// Waits for a datagram and records the result of the read
+//==============================================================================
+static SocketTask<> readOne(SocketScheduler& scheduler,
+                            UDPSocket&       socket,
+                            int&             result)
+{
+    unsigned char buffer[MESSAGE_SIZE];
+    result = co_await scheduler.read(socket, buffer, MESSAGE_SIZE);
+}
+
+//==============================================================================
+// Deletes a socket another task is waiting on
+//==============================================================================
+static SocketTask<> closeSocket(SocketScheduler& scheduler, UDPSocket* socket)
+{
+    scheduler.forget(*socket);
+    delete socket;
+    co_return;
+}
+
+//==============================================================================
+Test::Result SocketScheduler_test::Forget::body()
+{
+    unsigned int port = 0;
+    UDPSocket* socket = new UDPSocket();
+    MUST_BE_TRUE(socket->bind(port));
+    int fd = socket->getDescriptor();
+
+    SocketScheduler scheduler;
+
+    // The reader parks first, then its socket is closed from under it; it
+    // has to be woken up with an error rather than left waiting forever
+    int result = 0;
+    scheduler.spawn(readOne(scheduler, *socket, result));
+    scheduler.spawn(closeSocket(scheduler, socket));
+
+    scheduler.run();
+    MUST_BE_TRUE(result == -1);
+    MUST_BE_TRUE(scheduler.getTaskCount() == 0);
+
+    // A new socket given the same descriptor can be waited on as usual
+    UDPSocket reused;
+    UDPSocket other;
+    MUST_BE_TRUE(reused.getDescriptor() == fd);
+
+    unsigned int reused_port = 0;
+    unsigned int other_port  = 0;
+    MUST_BE_TRUE(reused.bind(reused_port));
+    MUST_BE_TRUE(other.bind(other_port));
+    MUST_BE_TRUE(other.sendTo("localhost", reused_port));
+
+    scheduler.spawn(readOne(scheduler, reused, result));
+    scheduler.spawn(sendOne(scheduler, other));
+
+    scheduler.run();
+    MUST_BE_TRUE(result == 10);
+    MUST_BE_TRUE(scheduler.getTaskCount() == 0);
+
+    // Forgetting a socket nothing waits on does nothing
+    scheduler.forget(other);
+
+    return Test::PASSED;
+}
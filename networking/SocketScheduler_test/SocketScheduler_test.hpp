@@ -0,0 +1,18 @@
+#if !defined SOCKET_SCHEDULER_TEST
+#define SOCKET_SCHEDULER_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(SocketScheduler_test)
+
+    TEST(Echo)
+    TEST(Datagrams)
+    TEST(NestedTasks)
+    TEST(Stop)
+    TEST(Forget)
+
+TEST_CASES_END(SocketScheduler_test)
+
+#endif
@@ -0,0 +1,46 @@
+#include "SocketStatistics.hpp"
+
+//==============================================================================
+// Initializes all counters to zero
+//==============================================================================
+SocketStatistics::SocketStatistics()
+{
+    reset();
+}
+
+//==============================================================================
+// Does nothing
+//==============================================================================
+SocketStatistics::~SocketStatistics()
+{
+}
+
+//==============================================================================
+// Sets all counters back to zero
+//==============================================================================
+void SocketStatistics::reset()
+{
+    bytes_received           = 0;
+    bytes_sent               = 0;
+    datagrams_received       = 0;
+    datagrams_sent           = 0;
+    syscalls                 = 0;
+    would_blocks             = 0;
+    errors                   = 0;
+    timeouts                 = 0;
+    receive_drops            = 0;
+    poll_latency_count       = 0;
+    poll_latency_total       = 0.0;
+    poll_latency_maximum     = 0.0;
+    spin_hits                = 0;
+    spin_fallbacks           = 0;
+    spin_probes              = 0;
+    zerocopy_fallbacks       = 0;
+    delivery_latency_count   = 0;
+    delivery_latency_total   = 0.0;
+    delivery_latency_maximum = 0.0;
+    paced_count              = 0;
+    pacing_lateness_total    = 0.0;
+    pacing_lateness_maximum  = 0.0;
+    pacing_drops             = 0;
+}
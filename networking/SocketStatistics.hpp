@@ -0,0 +1,455 @@
+#if !defined SOCKET_STATISTICS_HPP
+#define SOCKET_STATISTICS_HPP
+
+#include <cerrno>
+#include <cstdint>
+
+// Counts what a socket has been doing since it was created (or since the last
+// call to reset()).  Every socket implementation owns one of these and updates
+// it from its read and write paths.  Updates are plain integer increments on
+// memory only the owning socket touches, so they're cheap enough to leave on
+// permanently.  Like the sockets themselves this class is not thread-safe.
+class SocketStatistics
+{
+public:
+
+    // Initializes all counters to zero by calling reset()
+    SocketStatistics();
+
+    // Does nothing
+    ~SocketStatistics();
+
+    // Sets all counters back to zero
+    void reset();
+
+    // Accounts for the result of a single receive system call.  Positive
+    // results count as received data, -1 counts as either a would-block or an
+    // error depending on errno.
+    void recordRead(int ret);
+
+    // Accounts for the result of a single send system call.  Positive results
+    // count as sent data, -1 counts as either a would-block or an error
+    // depending on errno.
+    void recordWrite(int ret);
+
+    // Accounts for system calls made by the socket
+    void recordSyscalls(unsigned int syscalls = 1);
+
+    // Accounts for a blocking timeout that expired before the socket became
+    // ready
+    void recordTimeout();
+
+    // Accounts for the time (seconds) spent waiting in a blocking timeout
+    // before data became available
+    void recordPollLatency(double latency);
+
+    // Accounts for a busy-polling read that either found data while spinning
+    // or gave up spinning and fell back to blocking
+    void recordSpin(bool found_data);
+
+    // Accounts for one check for data made while spinning.  These aren't
+    // counted as syscalls or would-blocks, which would otherwise be swamped
+    // by them.
+    void recordSpinProbe();
+
+    // Accounts for a zero-copy write (MSG_ZEROCOPY) the kernel turned down for
+    // lack of room to pin its pages, which is retried by copying rather than
+    // counted as an error
+    void recordZeroCopyFallback();
+
+    // Accounts for the time (seconds) from the kernel timestamping a datagram
+    // as it arrived to a busy-polling read handing it over
+    void recordDeliveryLatency(double latency);
+
+    // Accounts for a paced datagram going out 'lateness' seconds after the
+    // time it was scheduled for (negative if it went out early)
+    void recordPacing(double lateness);
+
+    // Accounts for a paced datagram the kernel dropped rather than send after
+    // its scheduled time had passed
+    void recordPacingDrop();
+
+    // Stores the kernel's running count of datagrams dropped before they could
+    // be queued on this socket (see SO_RXQ_OVFL in socket(7))
+    void setReceiveDrops(std::uint32_t receive_drops);
+
+    // Bytes successfully read from and written to the socket
+    std::uint64_t getBytesReceived() const;
+    std::uint64_t getBytesSent() const;
+
+    // Reads and writes that transferred data.  For datagram-oriented sockets
+    // this is the number of datagrams received and sent.
+    std::uint64_t getDatagramsReceived() const;
+    std::uint64_t getDatagramsSent() const;
+
+    // Total system calls made on behalf of socket operations
+    std::uint64_t getSyscalls() const;
+
+    // Operations that failed with EAGAIN or EWOULDBLOCK
+    std::uint64_t getWouldBlocks() const;
+
+    // Operations that failed with any other error
+    std::uint64_t getErrors() const;
+
+    // Blocking timeouts that expired without the socket becoming ready
+    std::uint64_t getTimeouts() const;
+
+    // Last kernel-reported count of dropped datagrams; always 0 for sockets
+    // the kernel doesn't report this for
+    std::uint32_t getReceiveDrops() const;
+
+    // Busy-polling reads that found data while spinning, and ones that gave
+    // up spinning and blocked
+    std::uint64_t getSpinHits() const;
+    std::uint64_t getSpinFallbacks() const;
+
+    // Checks for data made while spinning
+    std::uint64_t getSpinProbes() const;
+
+    // Zero-copy writes that were turned down and copied instead
+    std::uint64_t getZeroCopyFallbacks() const;
+
+    // Number of delivery latency samples taken; only busy-polling reads of
+    // timestamped datagrams take them
+    std::uint64_t getDeliveryLatencyCount() const;
+
+    // Mean and maximum arrival-to-delivery latency (seconds)
+    double getDeliveryLatencyMean() const;
+    double getDeliveryLatencyMaximum() const;
+
+    // Number of paced datagrams whose actual send time is known
+    std::uint64_t getPacedCount() const;
+
+    // Mean and maximum time (seconds) paced datagrams went out after the time
+    // they were scheduled for
+    double getPacingLatenessMean() const;
+    double getPacingLatenessMaximum() const;
+
+    // Paced datagrams dropped for missing their scheduled time
+    std::uint64_t getPacingDrops() const;
+
+    // Number of poll-to-data latency samples taken
+    std::uint64_t getPollLatencyCount() const;
+
+    // Mean and maximum poll-to-data latency (seconds)
+    double getPollLatencyMean() const;
+    double getPollLatencyMaximum() const;
+
+private:
+
+    std::uint64_t bytes_received;
+    std::uint64_t bytes_sent;
+    std::uint64_t datagrams_received;
+    std::uint64_t datagrams_sent;
+    std::uint64_t syscalls;
+    std::uint64_t would_blocks;
+    std::uint64_t errors;
+    std::uint64_t timeouts;
+
+    std::uint32_t receive_drops;
+
+    // Running sum and maximum are kept instead of an OnlineStatistics so that
+    // the hot path stays at an add and a compare
+    std::uint64_t poll_latency_count;
+    double        poll_latency_total;
+    double        poll_latency_maximum;
+
+    std::uint64_t spin_hits;
+    std::uint64_t spin_fallbacks;
+    std::uint64_t spin_probes;
+
+    std::uint64_t zerocopy_fallbacks;
+
+    std::uint64_t delivery_latency_count;
+    double        delivery_latency_total;
+    double        delivery_latency_maximum;
+
+    std::uint64_t paced_count;
+    double        pacing_lateness_total;
+    double        pacing_lateness_maximum;
+    std::uint64_t pacing_drops;
+};
+
+//==============================================================================
+inline void SocketStatistics::recordRead(int ret)
+{
+    if (ret > 0)
+    {
+        bytes_received += static_cast<std::uint64_t>(ret);
+        ++datagrams_received;
+    }
+    else if (ret == -1)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            ++would_blocks;
+        }
+        else
+        {
+            ++errors;
+        }
+    }
+}
+
+//==============================================================================
+inline void SocketStatistics::recordWrite(int ret)
+{
+    if (ret > 0)
+    {
+        bytes_sent += static_cast<std::uint64_t>(ret);
+        ++datagrams_sent;
+    }
+    else if (ret == -1)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            ++would_blocks;
+        }
+        else
+        {
+            ++errors;
+        }
+    }
+}
+
+//==============================================================================
+inline void SocketStatistics::recordSyscalls(unsigned int syscalls)
+{
+    this->syscalls += syscalls;
+}
+
+//==============================================================================
+inline void SocketStatistics::recordTimeout()
+{
+    ++timeouts;
+}
+
+//==============================================================================
+inline void SocketStatistics::recordPollLatency(double latency)
+{
+    ++poll_latency_count;
+    poll_latency_total += latency;
+
+    if (latency > poll_latency_maximum)
+    {
+        poll_latency_maximum = latency;
+    }
+}
+
+//==============================================================================
+inline void SocketStatistics::recordSpin(bool found_data)
+{
+    if (found_data)
+    {
+        ++spin_hits;
+    }
+    else
+    {
+        ++spin_fallbacks;
+    }
+}
+
+//==============================================================================
+inline void SocketStatistics::recordSpinProbe()
+{
+    ++spin_probes;
+}
+
+//==============================================================================
+inline void SocketStatistics::recordZeroCopyFallback()
+{
+    ++zerocopy_fallbacks;
+}
+
+//==============================================================================
+inline void SocketStatistics::recordDeliveryLatency(double latency)
+{
+    ++delivery_latency_count;
+    delivery_latency_total += latency;
+
+    if (latency > delivery_latency_maximum)
+    {
+        delivery_latency_maximum = latency;
+    }
+}
+
+//==============================================================================
+inline void SocketStatistics::recordPacing(double lateness)
+{
+    // The maximum starts out at the first sample, since lateness can be
+    // negative
+    if (paced_count == 0 || lateness > pacing_lateness_maximum)
+    {
+        pacing_lateness_maximum = lateness;
+    }
+
+    ++paced_count;
+    pacing_lateness_total += lateness;
+}
+
+//==============================================================================
+inline void SocketStatistics::recordPacingDrop()
+{
+    ++pacing_drops;
+}
+
+//==============================================================================
+inline void SocketStatistics::setReceiveDrops(std::uint32_t receive_drops)
+{
+    this->receive_drops = receive_drops;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getBytesReceived() const
+{
+    return bytes_received;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getBytesSent() const
+{
+    return bytes_sent;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getDatagramsReceived() const
+{
+    return datagrams_received;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getDatagramsSent() const
+{
+    return datagrams_sent;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getSyscalls() const
+{
+    return syscalls;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getWouldBlocks() const
+{
+    return would_blocks;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getErrors() const
+{
+    return errors;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getTimeouts() const
+{
+    return timeouts;
+}
+
+//==============================================================================
+inline std::uint32_t SocketStatistics::getReceiveDrops() const
+{
+    return receive_drops;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getSpinHits() const
+{
+    return spin_hits;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getSpinFallbacks() const
+{
+    return spin_fallbacks;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getSpinProbes() const
+{
+    return spin_probes;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getZeroCopyFallbacks() const
+{
+    return zerocopy_fallbacks;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getDeliveryLatencyCount() const
+{
+    return delivery_latency_count;
+}
+
+//==============================================================================
+inline double SocketStatistics::getDeliveryLatencyMean() const
+{
+    if (delivery_latency_count == 0)
+    {
+        return 0.0;
+    }
+
+    return delivery_latency_total / delivery_latency_count;
+}
+
+//==============================================================================
+inline double SocketStatistics::getDeliveryLatencyMaximum() const
+{
+    return delivery_latency_maximum;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getPacedCount() const
+{
+    return paced_count;
+}
+
+//==============================================================================
+inline double SocketStatistics::getPacingLatenessMean() const
+{
+    if (paced_count == 0)
+    {
+        return 0.0;
+    }
+
+    return pacing_lateness_total / paced_count;
+}
+
+//==============================================================================
+inline double SocketStatistics::getPacingLatenessMaximum() const
+{
+    return pacing_lateness_maximum;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getPacingDrops() const
+{
+    return pacing_drops;
+}
+
+//==============================================================================
+inline std::uint64_t SocketStatistics::getPollLatencyCount() const
+{
+    return poll_latency_count;
+}
+
+//==============================================================================
+inline double SocketStatistics::getPollLatencyMean() const
+{
+    if (poll_latency_count == 0)
+    {
+        return 0.0;
+    }
+
+    return poll_latency_total / poll_latency_count;
+}
+
+//==============================================================================
+inline double SocketStatistics::getPollLatencyMaximum() const
+{
+    return poll_latency_maximum;
+}
+
+#endif
@@ -0,0 +1,425 @@
+// Measures how many system calls the socket classes make per operation, and
+// how long each operation takes, for the common read and write patterns.  All
+// traffic goes over loopback.  System calls are counted by the sockets
+// themselves (see SocketStatistics).
+//
+// Usage: SocketSyscalls_benchmark [operations]
+
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "PosixSocketCommon.hpp"
+#include "SharedMemorySocket.hpp"
+#include "SocketStatistics.hpp"
+#include "TCPSocket.hpp"
+#include "UDPSocket.hpp"
+
+// Size of every datagram or TCP write
+static const unsigned int PAYLOAD_SIZE = 64;
+
+//==============================================================================
+// Prints one line of results
+//==============================================================================
+static void report(const std::string&      name,
+                   const SocketStatistics& statistics,
+                   unsigned int            operations,
+                   double                  elapsed)
+{
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(2)
+              << static_cast<double>(statistics.getSyscalls()) / operations
+              << std::setw(12) << std::setprecision(0)
+              << elapsed / operations * 1.0e9 << "\n";
+}
+
+//==============================================================================
+// Sends and receives datagrams one at a time, with or without a blocking
+// timeout on both ends
+//==============================================================================
+static void udpPingPong(unsigned int operations, double blocking_timeout)
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+    socket1.bind(port1);
+    socket2.bind(port2);
+    socket1.sendTo("localhost", port2);
+    socket1.setBlockingTimeout(blocking_timeout);
+    socket2.setBlockingTimeout(blocking_timeout);
+
+    unsigned char buffer[PAYLOAD_SIZE] = {0};
+
+    double start = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < operations; ++i)
+    {
+        socket1.write(buffer, PAYLOAD_SIZE);
+        socket2.read(buffer, PAYLOAD_SIZE);
+    }
+    double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    SocketStatistics statistics;
+
+    socket1.getStatistics(statistics);
+    report(blocking_timeout > 0.0 ? "UDP write, blocking with timeout" :
+                                    "UDP write, blocking",
+           statistics,
+           operations,
+           elapsed / 2);
+
+    socket2.getStatistics(statistics);
+    report(blocking_timeout > 0.0 ? "UDP read, blocking with timeout" :
+                                    "UDP read, blocking",
+           statistics,
+           operations,
+           elapsed / 2);
+}
+
+//==============================================================================
+// Switches a socket between destinations, by host name and by dotted address.
+// Names are looked up once and remembered, so neither should make a system
+// call.
+//==============================================================================
+static void udpSendTo(unsigned int operations)
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+    socket1.bind(port1);
+    socket2.bind(port2);
+    socket1.sendTo("localhost", port2);
+    socket1.resetStatistics();
+
+    double start = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < operations; ++i)
+    {
+        socket1.sendTo("localhost", i % 2 ? port1 : port2);
+    }
+    double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    SocketStatistics statistics;
+    socket1.getStatistics(statistics);
+    report("UDP sendTo, host name", statistics, operations, elapsed);
+
+    socket1.resetStatistics();
+
+    start = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < operations; ++i)
+    {
+        socket1.sendTo("127.0.0.1", i % 2 ? port1 : port2);
+    }
+    elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    socket1.getStatistics(statistics);
+    report("UDP sendTo, dotted address", statistics, operations, elapsed);
+}
+
+//==============================================================================
+// Reads datagrams that are already waiting from a non-blocking socket, then
+// tries reading an empty one
+//==============================================================================
+static void udpNonBlocking(unsigned int operations)
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+    socket1.bind(port1);
+    socket2.bind(port2);
+    socket1.sendTo("localhost", port2);
+    socket2.disableBlocking();
+    socket2.resetStatistics();
+
+    unsigned char buffer[PAYLOAD_SIZE] = {0};
+
+    // Go in rounds small enough that the receive queue never overflows
+    const unsigned int round = 256;
+
+    double elapsed = 0.0;
+    for (unsigned int done = 0; done < operations; done += round)
+    {
+        for (unsigned int i = 0; i < round; ++i)
+        {
+            socket1.write(buffer, PAYLOAD_SIZE);
+        }
+
+        double start = PosixSocketCommon::getMonotonicSeconds();
+        for (unsigned int i = 0; i < round; ++i)
+        {
+            socket2.read(buffer, PAYLOAD_SIZE);
+        }
+        elapsed += PosixSocketCommon::getMonotonicSeconds() - start;
+    }
+
+    SocketStatistics statistics;
+    socket2.getStatistics(statistics);
+    unsigned int rounded = (operations + round - 1) / round * round;
+    report("UDP read, non-blocking", statistics, rounded, elapsed);
+
+    socket2.resetStatistics();
+
+    double start = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < operations; ++i)
+    {
+        socket2.read(buffer, PAYLOAD_SIZE);
+    }
+    elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    socket2.getStatistics(statistics);
+    report("UDP read, non-blocking, nothing there", statistics, operations,
+           elapsed);
+}
+
+//==============================================================================
+// Discards a receive queue full of datagrams
+//==============================================================================
+static void udpClearBuffer(unsigned int operations)
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+    socket1.bind(port1);
+    socket2.bind(port2);
+    socket1.sendTo("localhost", port2);
+
+    unsigned char buffer[PAYLOAD_SIZE] = {0};
+
+    const unsigned int round = 256;
+
+    double   elapsed = 0.0;
+    SocketStatistics total;
+    std::uint64_t    syscalls = 0;
+    for (unsigned int done = 0; done < operations; done += round)
+    {
+        for (unsigned int i = 0; i < round; ++i)
+        {
+            socket1.write(buffer, PAYLOAD_SIZE);
+        }
+
+        socket2.resetStatistics();
+        double start = PosixSocketCommon::getMonotonicSeconds();
+        socket2.clearBuffer();
+        elapsed += PosixSocketCommon::getMonotonicSeconds() - start;
+
+        socket2.getStatistics(total);
+        syscalls += total.getSyscalls();
+    }
+
+    unsigned int rounded = (operations + round - 1) / round * round;
+    std::cout << std::left << std::setw(40) << "UDP clearBuffer, per datagram"
+              << std::right << std::setw(10) << std::fixed
+              << std::setprecision(2)
+              << static_cast<double>(syscalls) / rounded
+              << std::setw(12) << std::setprecision(0)
+              << elapsed / rounded * 1.0e9 << "\n";
+}
+
+//==============================================================================
+// Sends and receives datagrams SEGMENTS at a time using segmentation and
+// receive coalescing, reporting costs per datagram
+//==============================================================================
+static void udpSegmented(unsigned int operations)
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+    socket1.bind(port1);
+    socket2.bind(port2);
+    socket1.sendTo("localhost", port2);
+    socket2.setBlockingTimeout(1.0);
+
+    const unsigned int segment_size = 1400;
+    const unsigned int segments     = 32;
+
+    if (!socket1.enableSegmentation(segment_size) ||
+        !socket2.enableReceiveCoalescing())
+    {
+        std::cout << "UDP segmentation not supported, skipping\n";
+        return;
+    }
+
+    std::vector<unsigned char> send(segment_size * segments);
+    std::vector<unsigned char> recv(65536);
+
+    unsigned int writes = (operations + segments - 1) / segments;
+
+    double start = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < writes; ++i)
+    {
+        socket1.write(&send[0], send.size());
+
+        unsigned int received = 0;
+        while (received < send.size())
+        {
+            int ret = socket2.read(&recv[0], recv.size());
+            if (ret <= 0)
+            {
+                break;
+            }
+            received += ret;
+        }
+    }
+    double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    SocketStatistics statistics;
+
+    socket1.getStatistics(statistics);
+    report("UDP write, segmented, per datagram",
+           statistics,
+           writes * segments,
+           elapsed / 2);
+
+    socket2.getStatistics(statistics);
+    report("UDP read, coalesced, per datagram",
+           statistics,
+           writes * segments,
+           elapsed / 2);
+}
+
+//==============================================================================
+// Streams fixed-size writes across a TCP connection and reads them back, with
+// a blocking timeout on both ends
+//==============================================================================
+static void tcpPingPong(unsigned int operations)
+{
+    unsigned int port = 0;
+
+    TCPSocket socket1;
+    TCPSocket socket2;
+    socket2.bind(port);
+    socket2.listen();
+    socket1.connect("localhost", port);
+    socket2.accept();
+    socket1.setBlockingTimeout(1.0);
+    socket2.setBlockingTimeout(1.0);
+    socket1.resetStatistics();
+    socket2.resetStatistics();
+
+    unsigned char buffer[PAYLOAD_SIZE] = {0};
+
+    double start = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < operations; ++i)
+    {
+        socket1.write(buffer, PAYLOAD_SIZE);
+
+        unsigned int received = 0;
+        while (received < PAYLOAD_SIZE)
+        {
+            int ret = socket2.read(buffer + received, PAYLOAD_SIZE - received);
+            if (ret <= 0)
+            {
+                break;
+            }
+            received += ret;
+        }
+    }
+    double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    SocketStatistics statistics;
+
+    socket1.getStatistics(statistics);
+    report("TCP write, blocking with timeout", statistics, operations,
+           elapsed / 2);
+
+    socket2.getStatistics(statistics);
+    report("TCP read, blocking with timeout", statistics, operations,
+           elapsed / 2);
+}
+
+//==============================================================================
+// Sends messages one at a time through shared memory and reads them back
+//==============================================================================
+static void sharedMemoryPingPong(unsigned int operations)
+{
+    SharedMemorySocket* socket1 = 0;
+    SharedMemorySocket* socket2 = 0;
+
+    try
+    {
+        socket1 = new SharedMemorySocket();
+        socket2 = new SharedMemorySocket();
+    }
+    catch (std::runtime_error&)
+    {
+        std::cout << "Shared memory sockets not supported, skipping\n";
+        delete socket1;
+        return;
+    }
+
+    std::ostringstream name;
+    name << "/SocketSyscalls_benchmark_" << getpid();
+
+    socket1->create(name.str());
+    socket2->open(name.str());
+    socket1->setBlockingTimeout(1.0);
+    socket2->setBlockingTimeout(1.0);
+
+    unsigned char buffer[PAYLOAD_SIZE] = {0};
+
+    double start = PosixSocketCommon::getMonotonicSeconds();
+    for (unsigned int i = 0; i < operations; ++i)
+    {
+        socket1->write(buffer, PAYLOAD_SIZE);
+        socket2->read(buffer, PAYLOAD_SIZE);
+    }
+    double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+    SocketStatistics statistics;
+
+    socket1->getStatistics(statistics);
+    report("Shared memory write, blocking", statistics, operations,
+           elapsed / 2);
+
+    socket2->getStatistics(statistics);
+    report("Shared memory read, blocking", statistics, operations,
+           elapsed / 2);
+
+    delete socket1;
+    delete socket2;
+}
+
+//==============================================================================
+int main(int argc, char** argv)
+{
+    unsigned int operations = 100000;
+    if (argc > 1)
+    {
+        operations = std::strtoul(argv[1], 0, 10);
+    }
+
+    if (operations == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [operations]\n";
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(40) << "Operation" << std::right
+              << std::setw(10) << "Syscalls" << std::setw(12) << "ns/op"
+              << "\n";
+
+    udpPingPong(operations, 0.0);
+    udpPingPong(operations, 1.0);
+    udpSendTo(operations);
+    udpNonBlocking(operations);
+    udpClearBuffer(operations);
+    udpSegmented(operations);
+    tcpPingPong(operations);
+    sharedMemoryPingPong(operations);
+
+    return 0;
+}
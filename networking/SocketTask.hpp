@@ -0,0 +1,328 @@
+#if !defined SOCKET_TASK_HPP
+#define SOCKET_TASK_HPP
+
+#if __cplusplus < 202002L
+#error "SocketTask needs C++20; configure with the CXX20 option"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+class SocketScheduler;
+
+template <typename T> class SocketTask;
+
+// Everything a SocketTask coroutine keeps track of no matter what it returns
+class SocketTaskPromiseBase
+{
+public:
+
+    // Task bodies don't run until they're awaited or spawned
+    std::suspend_always initial_suspend() noexcept
+    {
+        return std::suspend_always();
+    }
+
+    // Hands control back to whoever was waiting on the task
+    class FinalAwaiter
+    {
+    public:
+
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<Promise> handle) noexcept
+        {
+            SocketTaskPromiseBase& promise = handle.promise();
+
+            if (promise.continuation)
+            {
+                return promise.continuation;
+            }
+
+            // Nobody's waiting on a spawned task, so it cleans up after itself
+            if (promise.scheduler)
+            {
+                SocketScheduler* scheduler = promise.scheduler;
+                void*            address   = handle.address();
+                handle.destroy();
+                taskFinished(scheduler, address);
+            }
+
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept
+        {
+        }
+    };
+
+    FinalAwaiter final_suspend() noexcept
+    {
+        return FinalAwaiter();
+    }
+
+    // Exceptions are passed on to the awaiting coroutine.  A spawned task has
+    // nowhere to pass them, so that's treated like an exception escaping a
+    // std::thread.
+    void unhandled_exception()
+    {
+        if (scheduler)
+        {
+            std::terminate();
+        }
+
+        exception = std::current_exception();
+    }
+
+    // Coroutine to resume when this one finishes, if it's being awaited
+    std::coroutine_handle<> continuation;
+
+    // Scheduler that owns this task, if it was spawned rather than awaited
+    SocketScheduler* scheduler = 0;
+
+    std::exception_ptr exception;
+
+private:
+
+    // Tells the scheduler the spawned task at 'address' is done
+    static void taskFinished(SocketScheduler* scheduler, void* address);
+};
+
+// A coroutine returning a T (or nothing).  Tasks start out suspended and run
+// when awaited from another task, or when handed to SocketScheduler::spawn()
+// to run on their own.  Awaiting a task gives its return value, or rethrows
+// whatever exception escaped it.  Tasks are move-only.
+template <typename T = void>
+class SocketTask
+{
+public:
+
+    class promise_type : public SocketTaskPromiseBase
+    {
+    public:
+
+        SocketTask get_return_object()
+        {
+            return SocketTask(
+                std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        void return_value(T value)
+        {
+            this->value = std::move(value);
+        }
+
+        std::optional<T> value;
+    };
+
+    SocketTask(SocketTask&& other) noexcept;
+
+    SocketTask& operator=(SocketTask&& other) noexcept;
+
+    // Destroys the coroutine if it hasn't been handed off to a scheduler
+    ~SocketTask();
+
+    // Starts the task and suspends the awaiting coroutine until it's done
+    class Awaiter
+    {
+    public:
+
+        explicit Awaiter(std::coroutine_handle<promise_type> handle) :
+            handle(handle)
+        {
+        }
+
+        bool await_ready() noexcept
+        {
+            return !handle || handle.done();
+        }
+
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<> awaiting) noexcept
+        {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume()
+        {
+            if (handle.promise().exception)
+            {
+                std::rethrow_exception(handle.promise().exception);
+            }
+
+            return std::move(*handle.promise().value);
+        }
+
+    private:
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    Awaiter operator co_await() noexcept
+    {
+        return Awaiter(handle);
+    }
+
+private:
+
+    // Hands over ownership of the coroutine
+    friend class SocketScheduler;
+
+    explicit SocketTask(std::coroutine_handle<promise_type> handle) :
+        handle(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle;
+
+    SocketTask(const SocketTask&) = delete;
+    SocketTask& operator=(const SocketTask&) = delete;
+};
+
+// The same, for tasks that don't return anything
+template <>
+class SocketTask<void>
+{
+public:
+
+    class promise_type : public SocketTaskPromiseBase
+    {
+    public:
+
+        SocketTask get_return_object()
+        {
+            return SocketTask(
+                std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        void return_void()
+        {
+        }
+    };
+
+    SocketTask(SocketTask&& other) noexcept :
+        handle(std::exchange(other.handle, nullptr))
+    {
+    }
+
+    SocketTask& operator=(SocketTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+
+            handle = std::exchange(other.handle, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~SocketTask()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    class Awaiter
+    {
+    public:
+
+        explicit Awaiter(std::coroutine_handle<promise_type> handle) :
+            handle(handle)
+        {
+        }
+
+        bool await_ready() noexcept
+        {
+            return !handle || handle.done();
+        }
+
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<> awaiting) noexcept
+        {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        void await_resume()
+        {
+            if (handle && handle.promise().exception)
+            {
+                std::rethrow_exception(handle.promise().exception);
+            }
+        }
+
+    private:
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    Awaiter operator co_await() noexcept
+    {
+        return Awaiter(handle);
+    }
+
+private:
+
+    // Takes ownership of spawned tasks
+    friend class SocketScheduler;
+
+    explicit SocketTask(std::coroutine_handle<promise_type> handle) :
+        handle(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle;
+
+    SocketTask(const SocketTask&) = delete;
+    SocketTask& operator=(const SocketTask&) = delete;
+};
+
+//==============================================================================
+template <typename T>
+SocketTask<T>::SocketTask(SocketTask&& other) noexcept :
+    handle(std::exchange(other.handle, nullptr))
+{
+}
+
+//==============================================================================
+template <typename T>
+SocketTask<T>& SocketTask<T>::operator=(SocketTask&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+
+        handle = std::exchange(other.handle, nullptr);
+    }
+
+    return *this;
+}
+
+//==============================================================================
+template <typename T>
+SocketTask<T>::~SocketTask()
+{
+    if (handle)
+    {
+        handle.destroy();
+    }
+}
+
+#endif
@@ -0,0 +1,290 @@
+// Measures how many messages per second, and how many bits per second, the
+// socket classes can push across loopback for a range of message sizes.  One
+// thread writes as fast as it can for a fixed time while another reads.  UDP
+// receive rates and losses are as seen by the reader; raw sockets are measured
+// at the writer only, since the loopback interface hands a raw reader a copy
+// of every frame on its way out as well as on its way back in.  Raw socket
+// cases need CAP_NET_RAW and are skipped without it.
+//
+// Usage: SocketThroughput_benchmark [seconds per case]
+
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PosixSocketCommon.hpp"
+#include "RawSocket.hpp"
+#include "TCPSocket.hpp"
+#include "UDPSocket.hpp"
+
+// Message sizes to try; the last UDP size is close to the largest datagram
+// IPv4 allows, and the raw sizes are whole Ethernet frames
+static const unsigned int UDP_SIZES[] = {64, 512, 1472, 8192, 65000};
+static const unsigned int TCP_SIZES[] = {64, 512, 1472, 8192, 65536};
+static const unsigned int RAW_SIZES[] = {64, 512, 1514};
+
+// Ethertype reserved for local experiments, so nothing else claims the frames
+static const std::uint16_t RAW_ETHERTYPE = 0x88b5;
+
+//==============================================================================
+// Prints one line of results; 'received' is ignored if 'sent' is the only
+// side measured
+//==============================================================================
+static void report(const std::string& name,
+                   unsigned int       size,
+                   std::uint64_t      sent,
+                   std::uint64_t      received,
+                   bool               has_received,
+                   double             elapsed)
+{
+    std::uint64_t delivered = has_received ? received : sent;
+
+    std::cout << std::left << std::setw(8) << name << std::right
+              << std::setw(8) << size << std::fixed << std::setprecision(0)
+              << std::setw(14) << sent / elapsed;
+
+    if (has_received)
+    {
+        std::cout << std::setw(14) << received / elapsed;
+    }
+    else
+    {
+        std::cout << std::setw(14) << "-";
+    }
+
+    std::cout << std::setw(10) << std::setprecision(2)
+              << delivered * size * 8.0 / elapsed / 1.0e9;
+
+    if (has_received && sent > 0)
+    {
+        std::cout << std::setw(9) << std::setprecision(1)
+                  << 100.0 * (sent - received) / sent;
+    }
+    else
+    {
+        std::cout << std::setw(9) << "-";
+    }
+
+    std::cout << "\n";
+}
+
+//==============================================================================
+// Sends datagrams of the given size for 'duration' seconds while another
+// thread receives them
+//==============================================================================
+static void udpThroughput(unsigned int size, double duration)
+{
+    unsigned int port1 = 0;
+    unsigned int port2 = 0;
+
+    UDPSocket sender;
+    UDPSocket receiver;
+    if (!sender.bind(port1) || !receiver.bind(port2) ||
+        !sender.sendTo("localhost", port2))
+    {
+        std::cout << "UDP setup failed, skipping\n";
+        return;
+    }
+
+    // The reader gives up once datagrams stop arriving
+    receiver.setBlockingTimeout(0.5);
+
+    std::uint64_t received = 0;
+    double        last     = 0.0;
+
+    std::thread reader([&receiver, &received, &last, size]()
+    {
+        std::vector<unsigned char> buffer(size);
+        while (receiver.read(&buffer[0], size) > 0)
+        {
+            received++;
+            last = PosixSocketCommon::getMonotonicSeconds();
+        }
+    });
+
+    std::vector<unsigned char> message(size);
+
+    std::uint64_t sent  = 0;
+    double        start = PosixSocketCommon::getMonotonicSeconds();
+    double        end   = start;
+    while (end - start < duration)
+    {
+        // Only look at the clock now and then, it isn't free
+        for (unsigned int i = 0; i < 64; ++i)
+        {
+            if (sender.write(&message[0], size) == static_cast<int>(size))
+            {
+                sent++;
+            }
+        }
+
+        end = PosixSocketCommon::getMonotonicSeconds();
+    }
+
+    reader.join();
+
+    // Rate at which datagrams kept up with the writer, or fell behind it
+    double elapsed = last > end ? last - start : end - start;
+    report("UDP", size, sent, received, true, elapsed);
+}
+
+//==============================================================================
+// Streams writes of the given size for 'duration' seconds while another thread
+// reads them
+//==============================================================================
+static void tcpThroughput(unsigned int size, double duration)
+{
+    unsigned int port = 0;
+
+    TCPSocket* sender = new TCPSocket();
+    TCPSocket  receiver;
+    if (!receiver.bind(port) || !receiver.listen() ||
+        !sender->connect("localhost", port) || !receiver.accept())
+    {
+        std::cout << "TCP setup failed, skipping\n";
+        delete sender;
+        return;
+    }
+
+    std::uint64_t received = 0;
+    double        last     = 0.0;
+
+    // Reads until the writer closes its end
+    std::thread reader([&receiver, &received, &last]()
+    {
+        std::vector<unsigned char> buffer(256 * 1024);
+        int ret;
+        while ((ret = receiver.read(&buffer[0], buffer.size())) > 0)
+        {
+            received += ret;
+        }
+        last = PosixSocketCommon::getMonotonicSeconds();
+    });
+
+    std::vector<unsigned char> message(size);
+
+    std::uint64_t sent  = 0;
+    double        start = PosixSocketCommon::getMonotonicSeconds();
+    double        end   = start;
+    while (end - start < duration)
+    {
+        for (unsigned int i = 0; i < 16; ++i)
+        {
+            int ret = sender->write(&message[0], size);
+            if (ret > 0)
+            {
+                sent += ret;
+            }
+        }
+
+        end = PosixSocketCommon::getMonotonicSeconds();
+    }
+
+    delete sender;
+    reader.join();
+
+    report("TCP", size, sent / size, received / size, true, last - start);
+}
+
+//==============================================================================
+// Returns true if this process may open raw sockets
+//==============================================================================
+static bool rawSocketsPermitted()
+{
+    try
+    {
+        RawSocket socket;
+    }
+    catch (std::runtime_error&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Writes frames of the given size onto the loopback interface for 'duration'
+// seconds
+//==============================================================================
+static void rawThroughput(unsigned int size, double duration)
+{
+    RawSocket sender;
+    if (!sender.setOutputInterface("lo"))
+    {
+        std::cout << "Raw socket setup failed, skipping\n";
+        return;
+    }
+
+    // Zero addresses and an experimental ethertype
+    std::vector<unsigned char> frame(size);
+    frame[12] = RAW_ETHERTYPE >> 8;
+    frame[13] = RAW_ETHERTYPE & 0xff;
+
+    std::uint64_t sent  = 0;
+    double        start = PosixSocketCommon::getMonotonicSeconds();
+    double        end   = start;
+    while (end - start < duration)
+    {
+        for (unsigned int i = 0; i < 64; ++i)
+        {
+            if (sender.write(&frame[0], size) == static_cast<int>(size))
+            {
+                sent++;
+            }
+        }
+
+        end = PosixSocketCommon::getMonotonicSeconds();
+    }
+
+    report("Raw", size, sent, 0, false, end - start);
+}
+
+//==============================================================================
+int main(int argc, char** argv)
+{
+    double duration = 1.0;
+    if (argc > 1)
+    {
+        duration = std::strtod(argv[1], 0);
+    }
+
+    if (duration <= 0.0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [seconds per case]\n";
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(8) << "Socket" << std::right
+              << std::setw(8) << "Bytes" << std::setw(14) << "Sent msg/s"
+              << std::setw(14) << "Recv msg/s" << std::setw(10) << "Gb/s"
+              << std::setw(9) << "Loss %" << "\n";
+
+    for (unsigned int i = 0; i < sizeof(UDP_SIZES) / sizeof(*UDP_SIZES); ++i)
+    {
+        udpThroughput(UDP_SIZES[i], duration);
+    }
+
+    for (unsigned int i = 0; i < sizeof(TCP_SIZES) / sizeof(*TCP_SIZES); ++i)
+    {
+        tcpThroughput(TCP_SIZES[i], duration);
+    }
+
+    if (!rawSocketsPermitted())
+    {
+        std::cout << "Raw sockets need CAP_NET_RAW, skipping\n";
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < sizeof(RAW_SIZES) / sizeof(*RAW_SIZES); ++i)
+    {
+        rawThroughput(RAW_SIZES[i], duration);
+    }
+
+    return 0;
+}
@@ -0,0 +1,21 @@
+#if !defined TCP_ACCEPT_HANDLER_HPP
+#define TCP_ACCEPT_HANDLER_HPP
+
+class TCPSocket;
+
+// Receives connections accepted by a ShardedTCPAcceptor.  Implementations are
+// called from acceptor threads, possibly several at once, so anything shared
+// between calls must be protected accordingly.
+class TCPAcceptHandler
+{
+public:
+
+    virtual ~TCPAcceptHandler() {}
+
+    // Called once for every accepted connection.  'socket' is non-blocking and
+    // belongs to the handler, which must eventually delete it.  'shard' is the
+    // index of the listener the connection arrived on.
+    virtual void handleConnection(TCPSocket* socket, unsigned int shard) = 0;
+};
+
+#endif
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+#if defined DEBUG
+#include <iostream>
+#endif
+
+#include "TCPConnector.hpp"
+
+#include "AddressResolver.hpp"
+#include "PosixSocketCommon.hpp"
+#include "TCPSocket.hpp"
+
+const double TCPConnector::DEFAULT_TIMEOUT = 5.0;
+
+//==============================================================================
+// Starts out empty
+//==============================================================================
+TCPConnector::TCPConnector() :
+    first_new(0)
+{
+}
+
+//==============================================================================
+// Deletes whatever sockets are still here
+//==============================================================================
+TCPConnector::~TCPConnector()
+{
+    clear();
+}
+
+//==============================================================================
+// Adds a peer for the next connectAll()
+//==============================================================================
+unsigned int TCPConnector::add(const std::string& hostname,
+                               unsigned int       port,
+                               double             timeout)
+{
+    Peer peer;
+    peer.hostname     = hostname;
+    peer.port         = port;
+    peer.timeout      = timeout;
+    peer.status       = NOT_STARTED;
+    peer.error        = 0;
+    peer.connect_time = 0.0;
+    peer.socket       = 0;
+
+    peers.push_back(peer);
+    return peers.size() - 1;
+}
+
+//==============================================================================
+// Starts every new connect, then polls them all until each is settled
+//==============================================================================
+unsigned int TCPConnector::connectAll()
+{
+    double begin = PosixSocketCommon::getMonotonicSeconds();
+
+    unsigned int first = first_new;
+    first_new          = peers.size();
+
+    // Peers still connecting, and the descriptors to poll for them
+    std::vector<unsigned int> waiting;
+    std::vector<pollfd>       fds;
+
+    for (unsigned int i = first; i < peers.size(); ++i)
+    {
+        // Names are often shared by many peers (several ports on one host);
+        // the shared resolver only looks each one up once
+        std::string address;
+        if (!resolve(peers[i].hostname, address))
+        {
+            finish(peers[i], UNRESOLVED, 0, begin);
+        }
+        else if (start(peers[i], address, begin))
+        {
+            pollfd fd;
+            fd.fd      = peers[i].socket->getDescriptor();
+            fd.events  = POLLOUT;
+            fd.revents = 0;
+
+            waiting.push_back(i);
+            fds.push_back(fd);
+        }
+    }
+
+    while (!waiting.empty())
+    {
+        // Wake up in time for the earliest deadline
+        double now      = PosixSocketCommon::getMonotonicSeconds();
+        double deadline = begin + peers[waiting[0]].timeout;
+        for (unsigned int i = 1; i < waiting.size(); ++i)
+        {
+            deadline = std::min(deadline, begin + peers[waiting[i]].timeout);
+        }
+
+        int timeout_ms =
+            now < deadline
+                ? static_cast<int>(std::ceil((deadline - now) * 1000.0))
+                : 0;
+
+        if (poll(&fds[0], fds.size(), timeout_ms) == -1 && errno != EINTR)
+        {
+#if defined DEBUG
+            perror("TCPConnector::connectAll");
+#endif
+            // Nothing can be waited on any more, so whatever's left fails
+            int error = errno;
+            for (unsigned int i = 0; i < waiting.size(); ++i)
+            {
+                finish(peers[waiting[i]], FAILED, error, begin);
+            }
+            break;
+        }
+
+        now = PosixSocketCommon::getMonotonicSeconds();
+
+        // Settle every peer that's done or out of time, keeping the rest
+        unsigned int kept = 0;
+        for (unsigned int i = 0; i < waiting.size(); ++i)
+        {
+            Peer& peer = peers[waiting[i]];
+
+            if (fds[i].revents != 0)
+            {
+                // Writable means the connect is over one way or the other
+                int       error = 0;
+                socklen_t size  = sizeof(error);
+                if (getsockopt(
+                        fds[i].fd, SOL_SOCKET, SO_ERROR, &error, &size) == -1)
+                {
+                    error = errno;
+                }
+
+                finish(peer, error == 0 ? CONNECTED : FAILED, error, begin);
+                continue;
+            }
+
+            if (now >= begin + peer.timeout)
+            {
+                finish(peer, TIMED_OUT, ETIMEDOUT, begin);
+                continue;
+            }
+
+            waiting[kept] = waiting[i];
+            fds[kept]     = fds[i];
+            ++kept;
+        }
+
+        waiting.resize(kept);
+        fds.resize(kept);
+    }
+
+    unsigned int connected = 0;
+    for (unsigned int i = first; i < peers.size(); ++i)
+    {
+        connected += peers[i].status == CONNECTED;
+    }
+
+    return connected;
+}
+
+//==============================================================================
+// Gives up ownership of a connected socket
+//==============================================================================
+TCPSocket* TCPConnector::takeSocket(unsigned int peer)
+{
+    TCPSocket* socket = peers[peer].socket;
+    peers[peer].socket = 0;
+    return socket;
+}
+
+//==============================================================================
+// Deletes every socket not taken and forgets every peer
+//==============================================================================
+void TCPConnector::clear()
+{
+    for (unsigned int i = 0; i < peers.size(); ++i)
+    {
+        delete peers[i].socket;
+    }
+
+    peers.clear();
+    first_new = 0;
+}
+
+//==============================================================================
+// Looks a host name up, IPv4 only like the rest of the TCP code
+//==============================================================================
+bool TCPConnector::resolve(const std::string& hostname, std::string& address)
+{
+    in_addr resolved;
+    if (!AddressResolver::getShared().resolve(hostname, resolved))
+    {
+#if defined DEBUG
+        std::cerr << "TCPConnector::resolve: Can't resolve " << hostname
+                  << "\n";
+#endif
+        return false;
+    }
+
+    char buffer[INET_ADDRSTRLEN];
+    if (!inet_ntop(AF_INET, &resolved, buffer, sizeof(buffer)))
+    {
+        return false;
+    }
+
+    address = buffer;
+    return true;
+}
+
+//==============================================================================
+// Opens a non-blocking socket and gets its connect going
+//==============================================================================
+bool TCPConnector::start(Peer& peer, const std::string& address, double begin)
+{
+    try
+    {
+        peer.socket = new TCPSocket();
+    }
+    catch (std::exception&)
+    {
+        // Most likely out of descriptors
+        finish(peer, FAILED, errno, begin);
+        return false;
+    }
+
+    if (!peer.socket->disableBlocking())
+    {
+        finish(peer, FAILED, errno, begin);
+        return false;
+    }
+
+    if (peer.socket->connect(address, peer.port))
+    {
+        // Sometimes a connect over loopback finishes straight away
+        finish(peer, CONNECTED, 0, begin);
+        return false;
+    }
+
+    if (errno != EINPROGRESS)
+    {
+        finish(peer, FAILED, errno, begin);
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Settles a peer; only connected peers keep their sockets
+//==============================================================================
+void TCPConnector::finish(Peer& peer, Status status, int error, double begin)
+{
+    peer.status       = status;
+    peer.error        = error;
+    peer.connect_time = PosixSocketCommon::getMonotonicSeconds() - begin;
+
+    if (status == CONNECTED)
+    {
+        peer.socket->enableBlocking();
+    }
+    else
+    {
+        delete peer.socket;
+        peer.socket = 0;
+    }
+}
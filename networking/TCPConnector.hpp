@@ -0,0 +1,165 @@
+#if !defined TCP_CONNECTOR_HPP
+#define TCP_CONNECTOR_HPP
+
+#include <string>
+#include <vector>
+
+class TCPSocket;
+
+// Connects TCP sockets to many peers at once, so a peer that's down costs its
+// own timeout rather than holding up everyone after it.  Every connect is
+// started non-blocking, then all of them are waited on together in one poll()
+// loop until each has connected, failed or run out of time.  Each peer gets
+// its own timeout, and its own result to look at afterwards:
+//
+//     TCPConnector connector;
+//     for (unsigned int i = 0; i < hosts.size(); ++i)
+//     {
+//         connector.add(hosts[i], port, 2.0);
+//     }
+//
+//     connector.connectAll();
+//
+//     for (unsigned int i = 0; i < connector.getPeerCount(); ++i)
+//     {
+//         if (connector.getStatus(i) == TCPConnector::CONNECTED)
+//         {
+//             peers.push_back(connector.takeSocket(i));
+//         }
+//     }
+//
+// Host names are resolved before any connect starts, through the resolver
+// the sockets share, so each distinct name is looked up at most once until
+// its answer expires; lookups that do happen still block.  Like the sockets
+// this class is not thread-safe.
+class TCPConnector
+{
+public:
+
+    // Where a peer's connect stands
+    enum Status
+    {
+        // Added, but connectAll() hasn't been called since
+        NOT_STARTED,
+
+        CONNECTED,
+
+        // The host name couldn't be resolved
+        UNRESOLVED,
+
+        // Refused, unreachable or otherwise failed; see getError()
+        FAILED,
+
+        // Still not connected when the peer's timeout ran out
+        TIMED_OUT
+    };
+
+    // Has no peers to start with
+    TCPConnector();
+
+    // Deletes any sockets not taken with takeSocket()
+    ~TCPConnector();
+
+    // Adds a peer to connect to on the next connectAll(), giving up on it
+    // 'timeout' seconds after connectAll() starts.  Returns the number the
+    // peer's results are looked up by, which counts up from 0.
+    unsigned int add(const std::string& hostname,
+                     unsigned int       port,
+                     double             timeout = DEFAULT_TIMEOUT);
+
+    // Connects to every peer added since the last call at once, and returns
+    // once each has connected, failed or timed out.  Connected sockets are
+    // left blocking, as a newly-connected TCPSocket would be.  Returns the
+    // number of peers that connected this time.
+    unsigned int connectAll();
+
+    // Returns the number of peers added
+    unsigned int getPeerCount() const;
+
+    // Returns where the given peer's connect stands
+    Status getStatus(unsigned int peer) const;
+
+    // Returns the errno value the given peer's connect failed with, or 0
+    int getError(unsigned int peer) const;
+
+    // Returns how long (seconds) the given peer took to connect, fail or time
+    // out, counted from the start of connectAll()
+    double getConnectTime(unsigned int peer) const;
+
+    // Hands over the given peer's connected socket, which the caller must
+    // delete.  Returns 0 if the peer isn't connected or its socket was
+    // already taken.
+    TCPSocket* takeSocket(unsigned int peer);
+
+    // Forgets every peer, deleting any sockets not taken
+    void clear();
+
+    // Seconds add() gives a peer to connect when no timeout is given
+    static const double DEFAULT_TIMEOUT;
+
+private:
+
+    // Everything known about one peer
+    struct Peer
+    {
+        std::string  hostname;
+        unsigned int port;
+        double       timeout;
+        Status       status;
+        int          error;
+        double       connect_time;
+
+        // Owned by this class until taken; 0 once taken or if the peer
+        // didn't connect
+        TCPSocket* socket;
+    };
+
+    // Resolves the given host name to a dotted IPv4 address.  Returns false
+    // if it couldn't be resolved.
+    static bool resolve(const std::string& hostname, std::string& address);
+
+    // Creates the given peer's socket and starts it connecting to 'address'.
+    // Returns true if the connect is under way; otherwise the peer's status
+    // says how it ended.
+    bool start(Peer& peer, const std::string& address, double begin);
+
+    // Records how the given peer's connect ended, deleting its socket unless
+    // it connected
+    void finish(Peer& peer, Status status, int error, double begin);
+
+    std::vector<Peer> peers;
+
+    // Peers before this one have already been through connectAll()
+    unsigned int first_new;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    TCPConnector(const TCPConnector&);
+    TCPConnector& operator=(const TCPConnector&);
+};
+
+//==============================================================================
+inline unsigned int TCPConnector::getPeerCount() const
+{
+    return peers.size();
+}
+
+//==============================================================================
+inline TCPConnector::Status TCPConnector::getStatus(unsigned int peer) const
+{
+    return peers[peer].status;
+}
+
+//==============================================================================
+inline int TCPConnector::getError(unsigned int peer) const
+{
+    return peers[peer].error;
+}
+
+//==============================================================================
+inline double TCPConnector::getConnectTime(unsigned int peer) const
+{
+    return peers[peer].connect_time;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include <cerrno>
+#include <iostream>
+#include <vector>
+
+#include "TCPConnector_test.hpp"
+
+#include "TCPConnector.hpp"
+#include "TCPSocket.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(TCPConnector_test);
+
+//==============================================================================
+void TCPConnector_test::addTestCases()
+{
+    ADD_TEST_CASE(ConnectMany);
+    ADD_TEST_CASE(Timeout);
+    ADD_TEST_CASE(TakeSocket);
+}
+
+//==============================================================================
+Test::Result TCPConnector_test::ConnectMany::body()
+{
+    const unsigned int PEERS = 16;
+
+    unsigned int port = 0;  // Use whatever port is available
+    TCPSocket listener;
+    MUST_BE_TRUE(listener.bind(port));
+    MUST_BE_TRUE(listener.listen());
+
+    // Bound but not listening, so connects to it are refused
+    unsigned int closed_port = 0;
+    TCPSocket closed;
+    MUST_BE_TRUE(closed.bind(closed_port));
+
+    TCPConnector connector;
+    for (unsigned int i = 0; i < PEERS; ++i)
+    {
+        MUST_BE_TRUE(connector.add("localhost", port) == i);
+    }
+
+    unsigned int refused    = connector.add("127.0.0.1", closed_port);
+    unsigned int unresolved = connector.add("no-such-host.invalid", port);
+    MUST_BE_TRUE(connector.getStatus(refused) == TCPConnector::NOT_STARTED);
+
+    MUST_BE_TRUE(connector.connectAll() == PEERS);
+    MUST_BE_TRUE(connector.getPeerCount() == PEERS + 2);
+
+    for (unsigned int i = 0; i < PEERS; ++i)
+    {
+        MUST_BE_TRUE(connector.getStatus(i) == TCPConnector::CONNECTED);
+        MUST_BE_TRUE(connector.getError(i) == 0);
+        MUST_BE_TRUE(connector.getConnectTime(i) < 1.0);
+    }
+
+    MUST_BE_TRUE(connector.getStatus(refused) == TCPConnector::FAILED);
+    MUST_BE_TRUE(connector.getError(refused) == ECONNREFUSED);
+    MUST_BE_TRUE(connector.getStatus(unresolved) == TCPConnector::UNRESOLVED);
+    MUST_BE_TRUE(connector.takeSocket(refused) == 0);
+
+    // Every connection really is there to be accepted
+    for (unsigned int i = 0; i < PEERS; ++i)
+    {
+        TCPSocket* accepted = listener.accept(false);
+        MUST_BE_TRUE(accepted != 0);
+        delete accepted;
+    }
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TCPConnector_test::Timeout::body()
+{
+    unsigned int port = 0;  // Use whatever port is available
+    TCPSocket listener;
+    MUST_BE_TRUE(listener.bind(port));
+
+    // Linux queues one connection beyond a backlog of 0 and silently drops
+    // handshakes after that, so later connects hang until they time out
+    MUST_BE_TRUE(listener.listen(0));
+
+    TCPConnector connector;
+    connector.add("localhost", port, 0.2);
+    connector.add("localhost", port, 0.2);
+    connector.add("localhost", port, 0.4);
+
+    MUST_BE_TRUE(connector.connectAll() == 1);
+    MUST_BE_TRUE(connector.getStatus(0) == TCPConnector::CONNECTED);
+    MUST_BE_TRUE(connector.getStatus(1) == TCPConnector::TIMED_OUT);
+    MUST_BE_TRUE(connector.getStatus(2) == TCPConnector::TIMED_OUT);
+    MUST_BE_TRUE(connector.getError(1) == ETIMEDOUT);
+
+    // Each peer gets its own timeout, and they run at the same time rather
+    // than one after the other
+    MUST_BE_TRUE(connector.getConnectTime(1) >= 0.2);
+    MUST_BE_TRUE(connector.getConnectTime(1) < 0.35);
+    MUST_BE_TRUE(connector.getConnectTime(2) >= 0.4);
+    MUST_BE_TRUE(connector.getConnectTime(2) < 0.55);
+
+    std::cout << "Timed out after " << connector.getConnectTime(1) << " s and "
+              << connector.getConnectTime(2) << " s\n";
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TCPConnector_test::TakeSocket::body()
+{
+    unsigned int port = 0;  // Use whatever port is available
+    TCPSocket listener;
+    MUST_BE_TRUE(listener.bind(port));
+    MUST_BE_TRUE(listener.listen());
+    listener.setBlockingTimeout(1.0);
+
+    TCPConnector connector;
+    connector.add("localhost", port);
+    MUST_BE_TRUE(connector.connectAll() == 1);
+
+    // Only peers added since the last call are connected again
+    connector.add("localhost", port);
+    MUST_BE_TRUE(connector.connectAll() == 1);
+    MUST_BE_TRUE(connector.getStatus(0) == TCPConnector::CONNECTED);
+    MUST_BE_TRUE(connector.getStatus(1) == TCPConnector::CONNECTED);
+
+    TCPSocket* accepted1 = listener.accept(false);
+    TCPSocket* accepted2 = listener.accept(false);
+    MUST_BE_TRUE(accepted1 != 0);
+    MUST_BE_TRUE(accepted2 != 0);
+    MUST_BE_TRUE(listener.accept(false) == 0);
+
+    // A taken socket is connected, blocking and the caller's to keep
+    TCPSocket* socket = connector.takeSocket(0);
+    MUST_BE_TRUE(socket != 0);
+    MUST_BE_TRUE(connector.takeSocket(0) == 0);
+    MUST_BE_TRUE(socket->isBlockingEnabled());
+
+    unsigned char send[] = {'h', 'i'};
+    unsigned char recv[] = {0, 0};
+    MUST_BE_TRUE(socket->write(send, 2) == 2);
+    accepted1->setBlockingTimeout(1.0);
+    MUST_BE_TRUE(accepted1->read(recv, 2) == 2);
+    MUST_BE_TRUE(recv[0] == 'h' && recv[1] == 'i');
+
+    // Clearing closes the socket not taken, which its peer sees
+    connector.clear();
+    MUST_BE_TRUE(connector.getPeerCount() == 0);
+    accepted2->setBlockingTimeout(1.0);
+    MUST_BE_TRUE(accepted2->read(recv, 2) == 0);
+
+    delete socket;
+    delete accepted1;
+    delete accepted2;
+
+    return Test::PASSED;
+}
@@ -0,0 +1,16 @@
+#if !defined TCP_CONNECTOR_TEST
+#define TCP_CONNECTOR_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(TCPConnector_test)
+
+    TEST(ConnectMany)
+    TEST(Timeout)
+    TEST(TakeSocket)
+
+TEST_CASES_END(TCPConnector_test)
+
+#endif
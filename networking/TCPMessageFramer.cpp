@@ -0,0 +1,265 @@
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "TCPMessageFramer.hpp"
+
+#include "TCPSocket.hpp"
+
+const unsigned int TCPMessageFramer::DEFAULT_BUFFER_SIZE;
+const unsigned int TCPMessageFramer::PREFIX_SIZE;
+
+//==============================================================================
+// Sets up for length-prefixed framing
+//==============================================================================
+TCPMessageFramer::TCPMessageFramer(TCPSocket*   socket,
+                                   unsigned int buffer_size) :
+    socket(socket),
+    framing(LENGTH_PREFIXED),
+    delimiter(0),
+    receive_buffer(buffer_size),
+    read_position(0),
+    write_position(0),
+    scan_position(0),
+    first_piece(0),
+    queued_bytes(0)
+{
+}
+
+//==============================================================================
+// Sets up for delimiter-based framing
+//==============================================================================
+TCPMessageFramer::TCPMessageFramer(TCPSocket*   socket,
+                                   char         delimiter,
+                                   unsigned int buffer_size) :
+    socket(socket),
+    framing(DELIMITED),
+    delimiter(delimiter),
+    receive_buffer(buffer_size),
+    read_position(0),
+    write_position(0),
+    scan_position(0),
+    first_piece(0),
+    queued_bytes(0)
+{
+}
+
+//==============================================================================
+// Does nothing
+//==============================================================================
+TCPMessageFramer::~TCPMessageFramer()
+{
+}
+
+//==============================================================================
+// Reads whatever the socket has into the receive buffer
+//==============================================================================
+int TCPMessageFramer::receive()
+{
+    if (read_position == write_position)
+    {
+        // Everything's been handed out; starting over at the front is free
+        read_position  = 0;
+        write_position = 0;
+        scan_position  = 0;
+    }
+    else if (write_position == receive_buffer.size() && !compact())
+    {
+        // One message fills the whole buffer and still isn't complete
+        return -1;
+    }
+
+    int ret = socket->read(&receive_buffer[write_position],
+                           receive_buffer.size() - write_position);
+
+    if (ret > 0)
+    {
+        write_position += ret;
+    }
+
+    return ret;
+}
+
+//==============================================================================
+// Hands out the next complete message, if there is one
+//==============================================================================
+bool TCPMessageFramer::nextMessage(const unsigned char*& message,
+                                   unsigned int&         size)
+{
+    unsigned int available = write_position - read_position;
+
+    if (framing == LENGTH_PREFIXED)
+    {
+        if (available < PREFIX_SIZE)
+        {
+            return false;
+        }
+
+        const unsigned char* prefix = &receive_buffer[read_position];
+        std::uint32_t length = (static_cast<std::uint32_t>(prefix[0]) << 24) |
+                               (static_cast<std::uint32_t>(prefix[1]) << 16) |
+                               (static_cast<std::uint32_t>(prefix[2]) << 8)  |
+                                static_cast<std::uint32_t>(prefix[3]);
+
+        if (available - PREFIX_SIZE < length)
+        {
+            return false;
+        }
+
+        message = prefix + PREFIX_SIZE;
+        size    = length;
+        read_position += PREFIX_SIZE + length;
+
+        return true;
+    }
+
+    // Only look at data that hasn't already been searched
+    const unsigned char* found = static_cast<const unsigned char*>(
+        memchr(&receive_buffer[scan_position],
+               delimiter,
+               write_position - scan_position));
+
+    if (!found)
+    {
+        scan_position = write_position;
+        return false;
+    }
+
+    unsigned int end = found - &receive_buffer[0];
+
+    message = &receive_buffer[read_position];
+    size    = end - read_position;
+    read_position = end + 1;
+    scan_position = read_position;
+
+    return true;
+}
+
+//==============================================================================
+// Adds a message to the outgoing queue
+//==============================================================================
+void TCPMessageFramer::queueMessage(const unsigned char* message,
+                                    unsigned int         size)
+{
+    if (framing == LENGTH_PREFIXED)
+    {
+        // Stored already in network byte order so the prefix can be written
+        // straight out of this storage
+        unsigned char prefix[PREFIX_SIZE] =
+            {static_cast<unsigned char>(size >> 24),
+             static_cast<unsigned char>(size >> 16),
+             static_cast<unsigned char>(size >> 8),
+             static_cast<unsigned char>(size)};
+
+        std::uint32_t stored;
+        memcpy(&stored, prefix, PREFIX_SIZE);
+        prefixes.push_back(stored);
+
+        piece_buffers.push_back(
+            reinterpret_cast<const unsigned char*>(&prefixes.back()));
+        piece_sizes.push_back(PREFIX_SIZE);
+        queued_bytes += PREFIX_SIZE;
+    }
+
+    piece_buffers.push_back(message);
+    piece_sizes.push_back(size);
+    queued_bytes += size;
+
+    if (framing == DELIMITED)
+    {
+        piece_buffers.push_back(&delimiter);
+        piece_sizes.push_back(1);
+        queued_bytes += 1;
+    }
+}
+
+//==============================================================================
+// Writes out as much of the queue as the socket will take
+//==============================================================================
+int TCPMessageFramer::flush()
+{
+    int total = 0;
+
+    while (first_piece < piece_buffers.size())
+    {
+        unsigned int count = piece_buffers.size() - first_piece;
+        if (count > TCPSocket::WRITE_GATHER_MAX)
+        {
+            count = TCPSocket::WRITE_GATHER_MAX;
+        }
+
+        unsigned long requested = 0;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            requested += piece_sizes[first_piece + i];
+        }
+
+        int ret = socket->writeGather(
+            &piece_buffers[first_piece], &piece_sizes[first_piece], count);
+
+        if (ret <= 0)
+        {
+            // Report the error only if nothing at all got written
+            return total > 0 ? total : ret;
+        }
+
+        total        += ret;
+        queued_bytes -= ret;
+
+        // Skip past everything written, adjusting the piece it ended in
+        unsigned int written = ret;
+        while (written > 0)
+        {
+            if (written >= piece_sizes[first_piece])
+            {
+                written -= piece_sizes[first_piece];
+                first_piece++;
+            }
+            else
+            {
+                piece_buffers[first_piece] += written;
+                piece_sizes[first_piece]   -= written;
+                written = 0;
+            }
+        }
+
+        // A short write means the socket is full; trying again right away
+        // would only cost another system call
+        if (static_cast<unsigned long>(ret) < requested)
+        {
+            return total;
+        }
+    }
+
+    piece_buffers.clear();
+    piece_sizes.clear();
+    prefixes.clear();
+    first_piece = 0;
+
+    return total;
+}
+
+//==============================================================================
+// Moves unconsumed data to the front of the receive buffer
+//==============================================================================
+bool TCPMessageFramer::compact()
+{
+    if (read_position == 0)
+    {
+        return false;
+    }
+
+    unsigned int remaining = write_position - read_position;
+    memmove(&receive_buffer[0], &receive_buffer[read_position], remaining);
+
+    if (framing == DELIMITED)
+    {
+        scan_position -= read_position;
+    }
+
+    write_position = remaining;
+    read_position  = 0;
+
+    return true;
+}
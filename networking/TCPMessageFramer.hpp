@@ -0,0 +1,151 @@
+#if !defined TCP_MESSAGE_FRAMER_HPP
+#define TCP_MESSAGE_FRAMER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class TCPSocket;
+
+// Splits the byte stream of a TCPSocket into messages and joins messages back
+// into it.  Two framings are supported: every message preceded by its length
+// as a 32-bit big-endian integer, or every message followed by a delimiter
+// byte.
+//
+// Received data is read into one large buffer, as much as the socket has each
+// time, so at high message rates a single read yields many messages.  Complete
+// messages are handed out as pointers into that buffer rather than copied.
+// When the end of the buffer is reached, whatever partial message is left is
+// moved back to the front, so messages never wrap around and are always
+// contiguous.
+//
+// Outgoing messages are queued by reference and written together by flush()
+// using TCPSocket::writeGather(), so a whole batch of messages costs one
+// system call.
+//
+// Like the sockets themselves this class is not thread-safe.
+class TCPMessageFramer
+{
+public:
+
+    // How messages are separated in the byte stream
+    enum Framing
+    {
+        LENGTH_PREFIXED,
+        DELIMITED
+    };
+
+    // Frames messages on 'socket', which must outlive this object, using
+    // length prefixes.  'buffer_size' is the size of the receive buffer and so
+    // limits the largest message (plus its prefix) that can be received.
+    explicit TCPMessageFramer(TCPSocket*   socket,
+                              unsigned int buffer_size = DEFAULT_BUFFER_SIZE);
+
+    // Frames messages on 'socket', which must outlive this object, by ending
+    // each with 'delimiter'.  Messages can't contain the delimiter.
+    // 'buffer_size' is the size of the receive buffer and so limits the
+    // largest message (plus its delimiter) that can be received.
+    TCPMessageFramer(TCPSocket*   socket,
+                     char         delimiter,
+                     unsigned int buffer_size = DEFAULT_BUFFER_SIZE);
+
+    // Does nothing; anything still queued is not written
+    ~TCPMessageFramer();
+
+    // Returns the framing in use
+    Framing getFraming() const;
+
+    // Does one read from the socket, as much as will fit in the receive
+    // buffer.  Messages previously returned by nextMessage() may be moved or
+    // overwritten by this, so be done with them before calling it.  Returns
+    // the socket's read result: the number of bytes read, 0 if the blocking
+    // timeout expired or the peer closed the connection, or -1 on error.  Also
+    // returns -1 if the receive buffer is completely taken up by a single
+    // message too large to ever fit.
+    int receive();
+
+    // If a complete message has been received, points 'message' at it, sets
+    // 'size' to its length (not counting framing) and returns true.  The
+    // message is left in the receive buffer and stays valid until the next
+    // call to receive().  Returns false if no complete message is available.
+    // Never touches the socket.
+    bool nextMessage(const unsigned char*& message, unsigned int& size);
+
+    // Queues a message to be written by the next flush().  Only a reference to
+    // 'message' is kept, so it must be left alone until getQueuedBytes()
+    // returns 0.
+    void queueMessage(const unsigned char* message, unsigned int size);
+
+    // Writes queued messages to the socket, as many as it will take, in as
+    // few system calls as possible.  Returns the number of bytes written
+    // (including framing), 0 if nothing could be written, or -1 on error.
+    int flush();
+
+    // Returns the number of bytes queued but not yet written, including
+    // framing
+    unsigned long getQueuedBytes() const;
+
+    // Receive buffer size used when none is given
+    static const unsigned int DEFAULT_BUFFER_SIZE = 1048576;
+
+    // Length of the prefix used by LENGTH_PREFIXED framing
+    static const unsigned int PREFIX_SIZE = 4;
+
+private:
+
+    // Moves unconsumed data to the front of the receive buffer.  Returns false
+    // if there's nothing that can be moved to make room.
+    bool compact();
+
+    TCPSocket* socket;
+
+    Framing framing;
+
+    // Only used by DELIMITED framing
+    unsigned char delimiter;
+
+    // Received data lives in [read_position, write_position) of this;
+    // everything before read_position has already been handed out
+    std::vector<unsigned char> receive_buffer;
+    unsigned int read_position;
+    unsigned int write_position;
+
+    // DELIMITED framing only; everything before this (and after
+    // read_position) is known not to contain the delimiter, so searches can
+    // pick up where they left off
+    unsigned int scan_position;
+
+    // Pieces waiting to be written, in order; parallel arrays so they can be
+    // handed straight to writeGather().  Pieces before first_piece have been
+    // written.  The first unwritten piece may have been partially written, in
+    // which case its entries here are adjusted to cover only the rest of it.
+    std::vector<const unsigned char*> piece_buffers;
+    std::vector<unsigned int>         piece_sizes;
+    unsigned int                      first_piece;
+
+    // Storage for the length prefixes referenced from piece_buffers.  A deque
+    // never moves existing elements when it grows, so those references stay
+    // valid.
+    std::deque<std::uint32_t> prefixes;
+
+    unsigned long queued_bytes;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    TCPMessageFramer(const TCPMessageFramer&);
+    TCPMessageFramer& operator=(const TCPMessageFramer&);
+};
+
+//==============================================================================
+inline TCPMessageFramer::Framing TCPMessageFramer::getFraming() const
+{
+    return framing;
+}
+
+//==============================================================================
+inline unsigned long TCPMessageFramer::getQueuedBytes() const
+{
+    return queued_bytes;
+}
+
+#endif
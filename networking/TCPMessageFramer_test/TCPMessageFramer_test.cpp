@@ -0,0 +1,290 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TCPMessageFramer_test.hpp"
+
+#include "SocketStatistics.hpp"
+#include "TCPMessageFramer.hpp"
+#include "TCPSocket.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(TCPMessageFramer_test);
+
+//==============================================================================
+void TCPMessageFramer_test::addTestCases()
+{
+    ADD_TEST_CASE(LengthPrefixed);
+    ADD_TEST_CASE(Delimited);
+    ADD_TEST_CASE(PartialMessage);
+    ADD_TEST_CASE(Compaction);
+    ADD_TEST_CASE(SyscallsPerMessage);
+}
+
+//==============================================================================
+// Connects 'client' to 'server' over localhost; 'server' takes over the
+// accepted connection
+//==============================================================================
+static bool connectPair(TCPSocket& client, TCPSocket& server)
+{
+    unsigned int port = 0;  // Use whatever port is available
+
+    if (!server.bind(port) ||
+        !server.listen() ||
+        !client.connect("localhost", port) ||
+        !server.accept())
+    {
+        return false;
+    }
+
+    // Nothing here should ever have to wait long
+    client.setBlockingTimeout(1.0);
+    server.setBlockingTimeout(1.0);
+
+    return true;
+}
+
+//==============================================================================
+// Receives messages until 'count' have arrived, appending them to 'messages'.
+// Returns false if the socket stops producing data first.
+//==============================================================================
+static bool receiveMessages(TCPMessageFramer&         framer,
+                            unsigned int              count,
+                            std::vector<std::string>& messages)
+{
+    while (messages.size() < count)
+    {
+        const unsigned char* message = 0;
+        unsigned int         size    = 0;
+
+        if (framer.nextMessage(message, size))
+        {
+            messages.push_back(
+                std::string(reinterpret_cast<const char*>(message), size));
+        }
+        else if (framer.receive() <= 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+Test::Result TCPMessageFramer_test::LengthPrefixed::body()
+{
+    TCPSocket socket1;
+    TCPSocket socket2;
+    MUST_BE_TRUE(connectPair(socket1, socket2));
+
+    TCPMessageFramer sender(&socket1);
+    TCPMessageFramer receiver(&socket2);
+    MUST_BE_TRUE(sender.getFraming() == TCPMessageFramer::LENGTH_PREFIXED);
+
+    // Length prefixing doesn't care what's in the message, including empty
+    // messages
+    const unsigned char one[]   = {'o', 'n', 'e'};
+    const unsigned char two[]   = {'\n', '\0', 't', 'w', 'o'};
+    const unsigned char three[] = {0};
+
+    sender.queueMessage(one,   sizeof(one));
+    sender.queueMessage(two,   sizeof(two));
+    sender.queueMessage(three, 0);
+
+    const unsigned int expected =
+        3 * TCPMessageFramer::PREFIX_SIZE + sizeof(one) + sizeof(two);
+    MUST_BE_TRUE(sender.getQueuedBytes() == expected);
+    MUST_BE_TRUE(sender.flush() == static_cast<int>(expected));
+    MUST_BE_TRUE(sender.getQueuedBytes() == 0);
+
+    std::vector<std::string> messages;
+    MUST_BE_TRUE(receiveMessages(receiver, 3, messages));
+
+    MUST_BE_TRUE(messages[0] ==
+                 std::string(reinterpret_cast<const char*>(one), sizeof(one)));
+    MUST_BE_TRUE(messages[1] ==
+                 std::string(reinterpret_cast<const char*>(two), sizeof(two)));
+    MUST_BE_TRUE(messages[2].empty());
+
+    const unsigned char* message = 0;
+    unsigned int         size    = 0;
+    MUST_BE_FALSE(receiver.nextMessage(message, size));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TCPMessageFramer_test::Delimited::body()
+{
+    TCPSocket socket1;
+    TCPSocket socket2;
+    MUST_BE_TRUE(connectPair(socket1, socket2));
+
+    TCPMessageFramer sender(&socket1, '\n');
+    TCPMessageFramer receiver(&socket2, '\n');
+    MUST_BE_TRUE(receiver.getFraming() == TCPMessageFramer::DELIMITED);
+
+    std::string one   = "first line";
+    std::string two   = "";
+    std::string three = "third line";
+
+    sender.queueMessage(reinterpret_cast<const unsigned char*>(one.data()),
+                        one.size());
+    sender.queueMessage(reinterpret_cast<const unsigned char*>(two.data()),
+                        two.size());
+    sender.queueMessage(reinterpret_cast<const unsigned char*>(three.data()),
+                        three.size());
+
+    const unsigned int expected = one.size() + two.size() + three.size() + 3;
+    MUST_BE_TRUE(sender.flush() == static_cast<int>(expected));
+
+    std::vector<std::string> messages;
+    MUST_BE_TRUE(receiveMessages(receiver, 3, messages));
+
+    MUST_BE_TRUE(messages[0] == one);
+    MUST_BE_TRUE(messages[1] == two);
+    MUST_BE_TRUE(messages[2] == three);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TCPMessageFramer_test::PartialMessage::body()
+{
+    TCPSocket socket1;
+    TCPSocket socket2;
+    MUST_BE_TRUE(connectPair(socket1, socket2));
+
+    TCPMessageFramer receiver(&socket2);
+
+    // A prefix saying 5 bytes are coming, then only some of them
+    const unsigned char first[]  = {0, 0, 0, 5, 'h', 'e'};
+    const unsigned char second[] = {'l', 'l', 'o'};
+
+    MUST_BE_TRUE(socket1.write(first, sizeof(first)) ==
+                 static_cast<int>(sizeof(first)));
+    MUST_BE_TRUE(receiver.receive() == static_cast<int>(sizeof(first)));
+
+    const unsigned char* message = 0;
+    unsigned int         size    = 0;
+    MUST_BE_FALSE(receiver.nextMessage(message, size));
+
+    MUST_BE_TRUE(socket1.write(second, sizeof(second)) ==
+                 static_cast<int>(sizeof(second)));
+    MUST_BE_TRUE(receiver.receive() == static_cast<int>(sizeof(second)));
+
+    MUST_BE_TRUE(receiver.nextMessage(message, size));
+    MUST_BE_TRUE(size == 5);
+    MUST_BE_TRUE(memcmp(message, "hello", 5) == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TCPMessageFramer_test::Compaction::body()
+{
+    TCPSocket socket1;
+    TCPSocket socket2;
+    MUST_BE_TRUE(connectPair(socket1, socket2));
+
+    // A receive buffer that holds a few messages at most forces partial
+    // messages to be moved back to the front over and over
+    const unsigned int buffer_size = 32;
+    const unsigned int count       = 200;
+
+    TCPMessageFramer sender(&socket1, ';');
+    TCPMessageFramer receiver(&socket2, ';', buffer_size);
+
+    std::vector<std::string> sent;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        sent.push_back("message " + std::to_string(i));
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        sender.queueMessage(
+            reinterpret_cast<const unsigned char*>(sent[i].data()),
+            sent[i].size());
+    }
+
+    while (sender.getQueuedBytes() > 0)
+    {
+        MUST_BE_TRUE(sender.flush() > 0);
+    }
+
+    std::vector<std::string> received;
+    MUST_BE_TRUE(receiveMessages(receiver, count, received));
+    MUST_BE_TRUE(received == sent);
+
+    // A message that can never fit is reported rather than waited on forever
+    std::string too_big(buffer_size * 2, 'x');
+    sender.queueMessage(
+        reinterpret_cast<const unsigned char*>(too_big.data()), too_big.size());
+    MUST_BE_TRUE(sender.flush() == static_cast<int>(too_big.size() + 1));
+
+    int ret = 0;
+    while ((ret = receiver.receive()) > 0)
+    {
+    }
+    MUST_BE_TRUE(ret == -1);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TCPMessageFramer_test::SyscallsPerMessage::body()
+{
+    TCPSocket socket1;
+    TCPSocket socket2;
+    MUST_BE_TRUE(connectPair(socket1, socket2));
+
+    const unsigned int count = 1000;
+
+    TCPMessageFramer sender(&socket1);
+    TCPMessageFramer receiver(&socket2);
+
+    unsigned char payload[16];
+    memset(payload, 'p', sizeof(payload));
+
+    socket1.resetStatistics();
+    socket2.resetStatistics();
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        sender.queueMessage(payload, sizeof(payload));
+    }
+
+    while (sender.getQueuedBytes() > 0)
+    {
+        MUST_BE_TRUE(sender.flush() > 0);
+    }
+
+    std::vector<std::string> messages;
+    MUST_BE_TRUE(receiveMessages(receiver, count, messages));
+
+    SocketStatistics send_statistics;
+    SocketStatistics receive_statistics;
+    socket1.getStatistics(send_statistics);
+    socket2.getStatistics(receive_statistics);
+
+    double send_per_message =
+        static_cast<double>(send_statistics.getSyscalls()) / count;
+    double receive_per_message =
+        static_cast<double>(receive_statistics.getSyscalls()) / count;
+
+    std::cout << "Send system calls per message: " << send_per_message << "\n"
+              << "Receive system calls per message: " << receive_per_message
+              << "\n";
+
+    // Writing or reading messages one at a time would cost at least one
+    // system call each
+    MUST_BE_TRUE(send_per_message < 0.25);
+    MUST_BE_TRUE(receive_per_message < 0.25);
+
+    return Test::PASSED;
+}
@@ -0,0 +1,18 @@
+#if !defined TCP_MESSAGE_FRAMER_TEST
+#define TCP_MESSAGE_FRAMER_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(TCPMessageFramer_test)
+
+    TEST(LengthPrefixed)
+    TEST(Delimited)
+    TEST(PartialMessage)
+    TEST(Compaction)
+    TEST(SyscallsPerMessage)
+
+TEST_CASES_END(TCPMessageFramer_test)
+
+#endif
@@ -60,11 +60,11 @@ bool TCPSocket::bind(unsigned int& port)
 //=============================================================================
 // Calls the implementation-specific listen
 //=============================================================================
-bool TCPSocket::listen()
+bool TCPSocket::listen(int backlog)
 {
     if (socket_impl)
     {
-        return socket_impl->listen();
+        return socket_impl->listen(backlog);
     }
 
     return false;
@@ -132,3 +132,94 @@ void TCPSocket::getPeerAddress(std::string& peer_address_str) const
         socket_impl->getPeerAddress(peer_address_str);
     }
 }
+
+//=============================================================================
+// Calls the implementation-specific writeGather
+//=============================================================================
+int TCPSocket::writeGather(const unsigned char* const* buffers,
+                           const unsigned int*         sizes,
+                           unsigned int                count)
+{
+    if (socket_impl)
+    {
+        return socket_impl->writeGather(buffers, sizes, count);
+    }
+
+    return -1;
+}
+
+//=============================================================================
+// Calls the implementation-specific enableZeroCopy
+//=============================================================================
+bool TCPSocket::enableZeroCopy(unsigned int threshold)
+{
+    if (socket_impl)
+    {
+        return socket_impl->enableZeroCopy(threshold);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls the implementation-specific disableZeroCopy
+//=============================================================================
+void TCPSocket::disableZeroCopy()
+{
+    if (socket_impl)
+    {
+        socket_impl->disableZeroCopy();
+    }
+}
+
+//=============================================================================
+// Calls the implementation-specific getLastZeroCopyId
+//=============================================================================
+bool TCPSocket::getLastZeroCopyId(std::uint32_t& id) const
+{
+    if (socket_impl)
+    {
+        return socket_impl->getLastZeroCopyId(id);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls the implementation-specific processZeroCopyCompletions
+//=============================================================================
+int TCPSocket::processZeroCopyCompletions()
+{
+    if (socket_impl)
+    {
+        return socket_impl->processZeroCopyCompletions();
+    }
+
+    return -1;
+}
+
+//=============================================================================
+// Calls the implementation-specific isZeroCopyComplete
+//=============================================================================
+bool TCPSocket::isZeroCopyComplete(std::uint32_t id) const
+{
+    if (socket_impl)
+    {
+        return socket_impl->isZeroCopyComplete(id);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls the implementation-specific getZeroCopyCopiedCount
+//=============================================================================
+unsigned long TCPSocket::getZeroCopyCopiedCount() const
+{
+    if (socket_impl)
+    {
+        return socket_impl->getZeroCopyCopiedCount();
+    }
+
+    return 0;
+}
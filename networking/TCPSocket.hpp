@@ -1,6 +1,8 @@
 #if !defined TCP_SOCKET_HPP
 #define TCP_SOCKET_HPP
 
+#include <cstdint>
+
 #include "Socket.hpp"
 
 class TCPSocketImpl;
@@ -9,6 +11,9 @@ class TCPSocket : public Socket
 {
 public:
 
+    // Wraps connections it accepts using the private constructor below
+    friend class ShardedTCPAcceptor;
+
     // Does nothing but call parent constructor.
     TCPSocket();
 
@@ -20,9 +25,11 @@ public:
     // argument.
     bool bind(unsigned int& port);
 
-    // Instructs this socket to begin listening for incoming traffic.  Must
-    // call 'bind' prior to this.
-    bool listen();
+    // Instructs this socket to begin listening for incoming traffic.  Up to
+    // 'backlog' connection requests are queued by the kernel while waiting to
+    // be accepted (the kernel may silently cap this).  Must call 'bind' prior
+    // to this.
+    bool listen(int backlog = DEFAULT_BACKLOG);
 
     // Accepts a connection request, should one be pending.  The user can
     // specify if they want this socket to close the old socket descriptor and
@@ -46,6 +53,60 @@ public:
     // Gets the source IP address of the last received packet
     void getPeerAddress(std::string& peer_address_str) const;
 
+    // Writes 'count' buffers, buffer i being 'buffers[i]' and 'sizes[i]' bytes
+    // long, as if they were one contiguous buffer.  At most WRITE_GATHER_MAX
+    // buffers are written per call.  Returns the number of bytes written,
+    // which like write() may be fewer than requested (ending part way through
+    // a buffer), 0 if the blocking timeout expired, or -1 on error.  Costs one
+    // system call where the platform supports it.
+    int writeGather(const unsigned char* const* buffers,
+                    const unsigned int*         sizes,
+                    unsigned int                count);
+
+    // Opts in to zero-copy transmission (MSG_ZEROCOPY) for writes of at least
+    // 'threshold' bytes; smaller writes are copied as usual since pinning
+    // pages and collecting a completion costs more than copying a few
+    // kilobytes.  A buffer written zero-copy is still in use by the kernel
+    // after write() returns and must not be modified or freed until its write
+    // is complete.  Use getLastZeroCopyId() right after a write to get its id,
+    // then processZeroCopyCompletions() and isZeroCopyComplete() to find out
+    // when the buffer can be reused.  Returns false if zero-copy isn't
+    // supported here, in which case all writes keep copying.
+    bool enableZeroCopy(unsigned int threshold = ZEROCOPY_THRESHOLD_DEFAULT);
+
+    // Goes back to copying every write.  Writes already sent zero-copy still
+    // complete as usual.
+    void disableZeroCopy();
+
+    // If the last write was sent zero-copy, returns true and the id of that
+    // write in 'id'.  Returns false if it was copied.
+    bool getLastZeroCopyId(std::uint32_t& id) const;
+
+    // Collects whatever zero-copy completion notifications the kernel has
+    // queued, without blocking.  Returns the number of writes newly known to
+    // be complete, or -1 on error.
+    int processZeroCopyCompletions();
+
+    // Returns true if the zero-copy write with the given id is known to be
+    // complete, meaning its buffer may be reused.  Only as current as the
+    // last call to processZeroCopyCompletions().
+    bool isZeroCopyComplete(std::uint32_t id) const;
+
+    // Returns the number of zero-copy writes the kernel reported having copied
+    // anyway (always the case over loopback, for example).  If this tracks the
+    // number of zero-copy writes, zero-copy is only adding overhead.
+    unsigned long getZeroCopyCopiedCount() const;
+
+    // Connection request queue length used by listen() when none is given
+    static const int DEFAULT_BACKLOG = 128;
+
+    // Most buffers writeGather() will write in one call
+    static const unsigned int WRITE_GATHER_MAX = 64;
+
+    // Write size at and above which zero-copy is used when no threshold is
+    // given to enableZeroCopy().  Below about this size copying is cheaper.
+    static const unsigned int ZEROCOPY_THRESHOLD_DEFAULT = 16384;
+
 protected:
 
     // Sets the platform-specific socket implementation to use
@@ -1,6 +1,8 @@
 #if !defined TCP_SOCKET_IMPL_HPP
 #define TCP_SOCKET_IMPL_HPP
 
+#include <cstdint>
+
 #include "SocketImpl.hpp"
 
 class TCPSocketImpl : public SocketImpl
@@ -18,9 +20,9 @@ public:
     // argument.
     virtual bool bind(unsigned int& port) = 0;
 
-    // Instructs this socket to begin listening for incoming traffic.  Must call
-    // 'bind' prior to this.
-    virtual bool listen() = 0;
+    // Instructs this socket to begin listening for incoming traffic, queueing
+    // up to 'backlog' connection requests.  Must call 'bind' prior to this.
+    virtual bool listen(int backlog) = 0;
 
     // Accepts a connection request, should one be pending.  Used only with
     // connection-oriented protocols (like TCP).  The user can specify if they
@@ -45,6 +47,32 @@ public:
     // Gets the source IP address of the last received packet
     virtual void getPeerAddress(std::string& peer_address_str) const = 0;
 
+    // Writes several buffers with as few system calls as possible.  See
+    // TCPSocket for details.
+    virtual int writeGather(const unsigned char* const* buffers,
+                            const unsigned int*         sizes,
+                            unsigned int                count) = 0;
+
+    // Has writes of at least 'threshold' bytes sent without copying the
+    // buffer into the kernel.  See TCPSocket for details.
+    virtual bool enableZeroCopy(unsigned int threshold) = 0;
+
+    // Goes back to copying every write
+    virtual void disableZeroCopy() = 0;
+
+    // Returns true and the write's id if the last write was sent zero-copy
+    virtual bool getLastZeroCopyId(std::uint32_t& id) const = 0;
+
+    // Collects completion notifications for zero-copy writes; returns the
+    // number of writes newly completed or -1 on error
+    virtual int processZeroCopyCompletions() = 0;
+
+    // Returns true once the zero-copy write with the given id has completed
+    virtual bool isZeroCopyComplete(std::uint32_t id) const = 0;
+
+    // Returns how many zero-copy writes the kernel ended up copying anyway
+    virtual unsigned long getZeroCopyCopiedCount() const = 0;
+
 private:
 
     // Disallow these for now; maybe these could be meaningfully implemented but
@@ -1,8 +1,13 @@
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 #include "TCPSocket_test.hpp"
 
+#include "PosixTimespec.hpp"
+#include "SocketKernelStatistics.hpp"
+#include "SocketStatistics.hpp"
 #include "TCPSocket.hpp"
 #include "Test.hpp"
 #include "TestCases.hpp"
@@ -15,6 +20,8 @@ void TCPSocket_test::addTestCases()
 {
     ADD_TEST_CASE(SendReceive_TwoSockets);
     ADD_TEST_CASE(SendReceive_TwoSockets_AcceptSpawn);
+    ADD_TEST_CASE(KernelStatistics);
+    ADD_TEST_CASE(ZeroCopy);
 }
 
 //==============================================================================
@@ -166,3 +173,128 @@ Test::Result TCPSocket_test::SendReceive_TwoSockets_AcceptSpawn::body()
 
     return Test::PASSED;
 }
+
+//==============================================================================
+Test::Result TCPSocket_test::KernelStatistics::body()
+{
+    unsigned int port = 0;  // Use whatever port is available
+
+    unsigned char send[] = {'a', 'b', 'c', '\0'};
+    unsigned char recv[] = {'\0', '\0', '\0', '\0'};
+    unsigned int send_size = 4;  // Must equal the length of both arrays
+
+    TCPSocket socket1;
+    TCPSocket socket2;
+
+    MUST_BE_TRUE(socket2.bind(port));
+    MUST_BE_TRUE(socket2.listen());
+    MUST_BE_TRUE(socket1.connect("localhost", port));
+    MUST_BE_TRUE(socket2.accept());
+
+    MUST_BE_TRUE(socket1.write(send, send_size) ==
+                 static_cast<int>(send_size));
+
+    // The kernel should know about the connection round trip by now, and the
+    // data we just sent should be waiting on the other end
+    SocketKernelStatistics kernel_statistics;
+    MUST_BE_TRUE(socket1.getKernelStatistics(kernel_statistics));
+    MUST_BE_TRUE(kernel_statistics.getRoundTripTime() > 0.0);
+    MUST_BE_TRUE(kernel_statistics.getCongestionWindow() > 0);
+
+    MUST_BE_TRUE(socket2.getKernelStatistics(kernel_statistics));
+    MUST_BE_TRUE(kernel_statistics.getReceiveQueueBytes() == send_size);
+
+    MUST_BE_TRUE(socket2.read(recv, send_size) == static_cast<int>(send_size));
+
+    SocketStatistics statistics;
+    socket2.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getBytesReceived() == send_size);
+    MUST_BE_TRUE(statistics.getDatagramsReceived() == 1);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TCPSocket_test::ZeroCopy::body()
+{
+    unsigned int port = 0;  // Use whatever port is available
+
+    const unsigned int threshold  = 4096;
+    const unsigned int large_size = 65536;
+    const unsigned int small_size = 64;
+
+    std::vector<unsigned char> send(large_size);
+    std::vector<unsigned char> recv(large_size);
+    for (unsigned int i = 0; i < large_size; ++i)
+    {
+        send[i] = i % 251;
+    }
+
+    TCPSocket socket1;
+    TCPSocket socket2;
+
+    MUST_BE_TRUE(socket2.bind(port));
+    MUST_BE_TRUE(socket2.listen());
+    MUST_BE_TRUE(socket1.connect("localhost", port));
+    MUST_BE_TRUE(socket2.accept());
+
+    SKIP_IF_FALSE(socket1.enableZeroCopy(threshold));
+
+    // Small writes are copied
+    MUST_BE_TRUE(socket1.write(&send[0], small_size) ==
+                 static_cast<int>(small_size));
+    std::uint32_t id = 0;
+    MUST_BE_FALSE(socket1.getLastZeroCopyId(id));
+
+    unsigned int received = 0;
+    while (received < small_size)
+    {
+        int ret = socket2.read(&recv[received], small_size - received);
+        MUST_BE_TRUE(ret > 0);
+        received += ret;
+    }
+
+    // Large writes aren't.  Nothing has been read yet so this can't have
+    // completed.
+    int sent = socket1.write(&send[0], large_size);
+    MUST_BE_TRUE(sent > 0);
+    MUST_BE_TRUE(socket1.getLastZeroCopyId(id));
+    MUST_BE_TRUE(id == 0);
+
+    received = 0;
+    while (received < static_cast<unsigned int>(sent))
+    {
+        int ret = socket2.read(&recv[received], sent - received);
+        MUST_BE_TRUE(ret > 0);
+        received += ret;
+    }
+
+    MUST_BE_TRUE(memcmp(&send[0], &recv[0], sent) == 0);
+
+    // Once the other end has everything the kernel lets go of the buffer,
+    // though the notification may take a moment to show up
+    timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    PosixTimespec deadline = PosixTimespec(now_ts) + 1.0;
+
+    while (!socket1.isZeroCopyComplete(id))
+    {
+        MUST_BE_TRUE(socket1.processZeroCopyCompletions() >= 0);
+
+        clock_gettime(CLOCK_MONOTONIC, &now_ts);
+        MUST_BE_TRUE(PosixTimespec(now_ts) < deadline);
+    }
+
+    // Loopback never really does zero-copy; the kernel should own up to that
+    std::cout << "Copied anyway: " << socket1.getZeroCopyCopiedCount() << "\n";
+    MUST_BE_FALSE(socket1.isZeroCopyComplete(id + 1));
+
+    // Any write the kernel wouldn't pin pages for was copied, not failed
+    SocketStatistics statistics;
+    socket1.getStatistics(statistics);
+    std::cout << "Zero-copy fallbacks: " << statistics.getZeroCopyFallbacks()
+              << "\n";
+    MUST_BE_TRUE(statistics.getErrors() == 0);
+
+    return Test::PASSED;
+}
@@ -9,6 +9,8 @@ TEST_CASES_BEGIN(TCPSocket_test)
 
     TEST(SendReceive_TwoSockets)
     TEST(SendReceive_TwoSockets_AcceptSpawn)
+    TEST(KernelStatistics)
+    TEST(ZeroCopy)
 
 TEST_CASES_END(TCPSocket_test)
 
@@ -0,0 +1,61 @@
+#include <cstdint>
+
+#include "TcpHeader.hpp"
+#include "misc.hpp"
+
+//==============================================================================
+// Initializes data offset to 5 (no options), everything else to 0
+//==============================================================================
+TcpHeader::TcpHeader() :
+    DataPacket(1), // always aligned on 1 byte (no alignment)
+    source_port(0),
+    destination_port(0),
+    sequence_number(0),
+    acknowledgement_number(0),
+    data_offset_flags(0x5000),
+    window_size(0),
+    checksum(0),
+    urgent_pointer(0)
+{
+    addDataFields();
+}
+
+//==============================================================================
+// Initializes ports, defaults for the rest
+//==============================================================================
+TcpHeader::TcpHeader(std::uint16_t source_port,
+                     std::uint16_t destination_port) :
+    TcpHeader()
+{
+    // cppcheck-suppress useInitializationList
+    this->source_port      = source_port;
+    this->destination_port = destination_port;
+}
+
+//==============================================================================
+// Constructs a TcpHeader by calling readRaw() on the provided buffer.
+// Byteswapping is performed if needed.
+//==============================================================================
+TcpHeader::TcpHeader(const std::uint8_t* buffer) :
+    TcpHeader()
+{
+    readRaw(buffer, misc::ENDIAN_BIG);
+}
+
+//==============================================================================
+TcpHeader::~TcpHeader()
+{
+}
+
+//==============================================================================
+void TcpHeader::addDataFields()
+{
+    addDataField(&source_port);
+    addDataField(&destination_port);
+    addDataField(&sequence_number);
+    addDataField(&acknowledgement_number);
+    addDataField(&data_offset_flags);
+    addDataField(&window_size);
+    addDataField(&checksum);
+    addDataField(&urgent_pointer);
+}
@@ -0,0 +1,208 @@
+#if !defined TCP_HEADER_HPP
+#define TCP_HEADER_HPP
+
+#include <cstdint>
+
+#include "DataPacket.hpp"
+
+#include "SimpleDataField.hpp"
+#include "misc.hpp"
+
+// Represents a TCP header.  Options aren't represented; getDataOffset() says
+// how far past the start of the header the payload begins when there are any.
+// The data offset and flag bits share two bytes on the wire and are stored
+// together that way, split apart with masks and shifts by the accessors.  See
+// TcpHeaderView for reading headers in place in a receive buffer without
+// copying them.
+class TcpHeader : public DataPacket
+{
+public:
+
+    // Flag bits as returned by getFlags(); combine with |
+    enum Flag
+    {
+        FIN = 0x001,
+        SYN = 0x002,
+        RST = 0x004,
+        PSH = 0x008,
+        ACK = 0x010,
+        URG = 0x020,
+        ECE = 0x040,
+        CWR = 0x080,
+        NS  = 0x100
+    };
+
+    // Initializes data offset to 5 (no options), everything else to 0
+    TcpHeader();
+
+    // Initializes ports, defaults for the rest
+    TcpHeader(std::uint16_t source_port, std::uint16_t destination_port);
+
+    // Constructs a TcpHeader by calling readRaw() on the provided buffer.  TCP
+    // headers are big endian on the wire so byteswapping is performed if
+    // needed.
+    explicit TcpHeader(const std::uint8_t* buffer);
+
+    // Does nothing
+    virtual ~TcpHeader();
+
+    std::uint16_t getSourcePort() const;
+    void setSourcePort(std::uint16_t source_port);
+
+    std::uint16_t getDestinationPort() const;
+    void setDestinationPort(std::uint16_t destination_port);
+
+    std::uint32_t getSequenceNumber() const;
+    void setSequenceNumber(std::uint32_t sequence_number);
+
+    std::uint32_t getAcknowledgementNumber() const;
+    void setAcknowledgementNumber(std::uint32_t acknowledgement_number);
+
+    // Header length in 32-bit words
+    std::uint8_t getDataOffset() const;
+    void setDataOffset(std::uint8_t data_offset);
+
+    // Header length in bytes
+    unsigned int getDataOffsetBytes() const;
+
+    // All nine flag bits; see Flag
+    std::uint16_t getFlags() const;
+    void setFlags(std::uint16_t flags);
+
+    // True if every one of the given flags is set
+    bool hasFlags(std::uint16_t flags) const;
+
+    std::uint16_t getWindowSize() const;
+    void setWindowSize(std::uint16_t window_size);
+
+    std::uint16_t getChecksum() const;
+    void setChecksum(std::uint16_t checksum);
+
+    std::uint16_t getUrgentPointer() const;
+    void setUrgentPointer(std::uint16_t urgent_pointer);
+
+    // TCP headers without options are always exactly this size
+    static const unsigned short LENGTH_BYTES = 20;
+
+private:
+
+    void addDataFields();
+
+    SimpleDataField<std::uint16_t> source_port;
+    SimpleDataField<std::uint16_t> destination_port;
+    SimpleDataField<std::uint32_t> sequence_number;
+    SimpleDataField<std::uint32_t> acknowledgement_number;
+    SimpleDataField<std::uint16_t> data_offset_flags;
+    SimpleDataField<std::uint16_t> window_size;
+    SimpleDataField<std::uint16_t> checksum;
+    SimpleDataField<std::uint16_t> urgent_pointer;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    TcpHeader(const TcpHeader&);
+    TcpHeader& operator=(const TcpHeader&);
+};
+
+inline std::uint16_t TcpHeader::getSourcePort() const
+{
+    return source_port;
+}
+
+inline void TcpHeader::setSourcePort(std::uint16_t source_port)
+{
+    this->source_port = source_port;
+}
+
+inline std::uint16_t TcpHeader::getDestinationPort() const
+{
+    return destination_port;
+}
+
+inline void TcpHeader::setDestinationPort(std::uint16_t destination_port)
+{
+    this->destination_port = destination_port;
+}
+
+inline std::uint32_t TcpHeader::getSequenceNumber() const
+{
+    return sequence_number;
+}
+
+inline void TcpHeader::setSequenceNumber(std::uint32_t sequence_number)
+{
+    this->sequence_number = sequence_number;
+}
+
+inline std::uint32_t TcpHeader::getAcknowledgementNumber() const
+{
+    return acknowledgement_number;
+}
+
+inline void
+TcpHeader::setAcknowledgementNumber(std::uint32_t acknowledgement_number)
+{
+    this->acknowledgement_number = acknowledgement_number;
+}
+
+inline std::uint8_t TcpHeader::getDataOffset() const
+{
+    return data_offset_flags >> 12;
+}
+
+inline void TcpHeader::setDataOffset(std::uint8_t data_offset)
+{
+    data_offset_flags =
+        (data_offset_flags & 0x0fff) | ((data_offset & 0x0f) << 12);
+}
+
+inline unsigned int TcpHeader::getDataOffsetBytes() const
+{
+    return getDataOffset() * 4;
+}
+
+inline std::uint16_t TcpHeader::getFlags() const
+{
+    return data_offset_flags & 0x01ff;
+}
+
+inline void TcpHeader::setFlags(std::uint16_t flags)
+{
+    data_offset_flags = (data_offset_flags & 0xfe00) | (flags & 0x01ff);
+}
+
+inline bool TcpHeader::hasFlags(std::uint16_t flags) const
+{
+    return (data_offset_flags & flags) == flags;
+}
+
+inline std::uint16_t TcpHeader::getWindowSize() const
+{
+    return window_size;
+}
+
+inline void TcpHeader::setWindowSize(std::uint16_t window_size)
+{
+    this->window_size = window_size;
+}
+
+inline std::uint16_t TcpHeader::getChecksum() const
+{
+    return checksum;
+}
+
+inline void TcpHeader::setChecksum(std::uint16_t checksum)
+{
+    this->checksum = checksum;
+}
+
+inline std::uint16_t TcpHeader::getUrgentPointer() const
+{
+    return urgent_pointer;
+}
+
+inline void TcpHeader::setUrgentPointer(std::uint16_t urgent_pointer)
+{
+    this->urgent_pointer = urgent_pointer;
+}
+
+#endif
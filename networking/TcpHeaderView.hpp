@@ -0,0 +1,126 @@
+#if !defined TCP_HEADER_VIEW_HPP
+#define TCP_HEADER_VIEW_HPP
+
+#include <cstdint>
+
+// Reads the fields of a TCP header in place, straight out of a receive buffer,
+// the same way Ipv4HeaderView does for IPv4.  Flag values are the ones defined
+// by TcpHeader::Flag.  The buffer must hold at least TcpHeader::LENGTH_BYTES
+// bytes and outlive the view.
+class TcpHeaderView
+{
+public:
+
+    // Views the header starting at 'buffer'
+    explicit TcpHeaderView(const std::uint8_t* buffer);
+
+    std::uint16_t getSourcePort() const;
+    std::uint16_t getDestinationPort() const;
+    std::uint32_t getSequenceNumber() const;
+    std::uint32_t getAcknowledgementNumber() const;
+    std::uint8_t  getDataOffset() const;
+    unsigned int  getDataOffsetBytes() const;
+    std::uint16_t getFlags() const;
+    bool          hasFlags(std::uint16_t flags) const;
+    std::uint16_t getWindowSize() const;
+    std::uint16_t getChecksum() const;
+    std::uint16_t getUrgentPointer() const;
+
+    // Where the header starts
+    const std::uint8_t* getBuffer() const;
+
+    // Where the payload starts, going by the data offset field
+    const std::uint8_t* getPayload() const;
+
+private:
+
+    std::uint16_t read16(unsigned int offset) const;
+    std::uint32_t read32(unsigned int offset) const;
+
+    const std::uint8_t* buffer;
+};
+
+inline TcpHeaderView::TcpHeaderView(const std::uint8_t* buffer) :
+    buffer(buffer)
+{
+}
+
+inline std::uint16_t TcpHeaderView::getSourcePort() const
+{
+    return read16(0);
+}
+
+inline std::uint16_t TcpHeaderView::getDestinationPort() const
+{
+    return read16(2);
+}
+
+inline std::uint32_t TcpHeaderView::getSequenceNumber() const
+{
+    return read32(4);
+}
+
+inline std::uint32_t TcpHeaderView::getAcknowledgementNumber() const
+{
+    return read32(8);
+}
+
+inline std::uint8_t TcpHeaderView::getDataOffset() const
+{
+    return buffer[12] >> 4;
+}
+
+inline unsigned int TcpHeaderView::getDataOffsetBytes() const
+{
+    return getDataOffset() * 4;
+}
+
+inline std::uint16_t TcpHeaderView::getFlags() const
+{
+    return read16(12) & 0x01ff;
+}
+
+inline bool TcpHeaderView::hasFlags(std::uint16_t flags) const
+{
+    return (getFlags() & flags) == flags;
+}
+
+inline std::uint16_t TcpHeaderView::getWindowSize() const
+{
+    return read16(14);
+}
+
+inline std::uint16_t TcpHeaderView::getChecksum() const
+{
+    return read16(16);
+}
+
+inline std::uint16_t TcpHeaderView::getUrgentPointer() const
+{
+    return read16(18);
+}
+
+inline const std::uint8_t* TcpHeaderView::getBuffer() const
+{
+    return buffer;
+}
+
+inline const std::uint8_t* TcpHeaderView::getPayload() const
+{
+    return buffer + getDataOffsetBytes();
+}
+
+inline std::uint16_t TcpHeaderView::read16(unsigned int offset) const
+{
+    return static_cast<std::uint16_t>(buffer[offset] << 8 | buffer[offset + 1]);
+}
+
+inline std::uint32_t TcpHeaderView::read32(unsigned int offset) const
+{
+    return static_cast<std::uint32_t>(buffer[offset])     << 24 |
+           static_cast<std::uint32_t>(buffer[offset + 1]) << 16 |
+           static_cast<std::uint32_t>(buffer[offset + 2]) << 8  |
+           static_cast<std::uint32_t>(buffer[offset + 3]);
+}
+
+#endif
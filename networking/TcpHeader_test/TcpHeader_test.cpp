@@ -0,0 +1,132 @@
+#include <cstdint>
+
+#include "TcpHeader_test.hpp"
+
+#include "TcpHeader.hpp"
+#include "TcpHeaderView.hpp"
+
+#include "TestMacros.hpp"
+#include "misc.hpp"
+
+TEST_PROGRAM_MAIN(TcpHeader_test);
+
+// A SYN from port 55000 to port 80, with ECE and CWR set (an ECN-setup SYN) and
+// 20 bytes of options
+static const std::uint8_t HEADER_RAW[TcpHeader::LENGTH_BYTES] =
+{
+    0xd6, 0xd8, 0x00, 0x50, 0x12, 0x34, 0x56, 0x78, 0x00, 0x00,
+    0x00, 0x00, 0xa0, 0xc2, 0xfa, 0xf0, 0x7e, 0x5d, 0x00, 0x00
+};
+
+//==============================================================================
+void TcpHeader_test::addTestCases()
+{
+    ADD_TEST_CASE(Length);
+    ADD_TEST_CASE(ReadRaw);
+    ADD_TEST_CASE(PackedFields);
+    ADD_TEST_CASE(View);
+}
+
+//==============================================================================
+Test::Result TcpHeader_test::Length::body()
+{
+    TcpHeader tcp_header(55000, 80);
+    MUST_BE_TRUE(tcp_header.getLengthBytes() == TcpHeader::LENGTH_BYTES);
+    MUST_BE_TRUE(tcp_header.getDataOffsetBytes() == TcpHeader::LENGTH_BYTES);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpHeader_test::ReadRaw::body()
+{
+    TcpHeader tcp_header(HEADER_RAW);
+
+    MUST_BE_TRUE(tcp_header.getSourcePort() == 55000);
+    MUST_BE_TRUE(tcp_header.getDestinationPort() == 80);
+    MUST_BE_TRUE(tcp_header.getSequenceNumber() == 0x12345678);
+    MUST_BE_TRUE(tcp_header.getAcknowledgementNumber() == 0);
+    MUST_BE_TRUE(tcp_header.getDataOffset() == 10);
+    MUST_BE_TRUE(tcp_header.getFlags() ==
+                 (TcpHeader::SYN | TcpHeader::ECE | TcpHeader::CWR));
+    MUST_BE_TRUE(tcp_header.hasFlags(TcpHeader::SYN | TcpHeader::ECE));
+    MUST_BE_FALSE(tcp_header.hasFlags(TcpHeader::SYN | TcpHeader::ACK));
+    MUST_BE_TRUE(tcp_header.getWindowSize() == 64240);
+    MUST_BE_TRUE(tcp_header.getChecksum() == 0x7e5d);
+    MUST_BE_TRUE(tcp_header.getUrgentPointer() == 0);
+
+    // Should come back out exactly as it went in
+    std::uint8_t header_raw[TcpHeader::LENGTH_BYTES];
+    tcp_header.writeRaw(header_raw, misc::ENDIAN_BIG);
+    for (unsigned int i = 0; i < TcpHeader::LENGTH_BYTES; ++i)
+    {
+        MUST_BE_TRUE(header_raw[i] == HEADER_RAW[i]);
+    }
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpHeader_test::PackedFields::body()
+{
+    TcpHeader tcp_header;
+
+    // Data offset and flags share two bytes; neither should disturb the other
+    tcp_header.setFlags(0xffff);
+    MUST_BE_TRUE(tcp_header.getFlags() == 0x01ff);
+    MUST_BE_TRUE(tcp_header.getDataOffset() == 5);
+
+    tcp_header.setDataOffset(15);
+    tcp_header.setFlags(TcpHeader::NS | TcpHeader::FIN);
+    MUST_BE_TRUE(tcp_header.getDataOffset() == 15);
+    MUST_BE_TRUE(tcp_header.getDataOffsetBytes() == 60);
+    MUST_BE_TRUE(tcp_header.hasFlags(TcpHeader::NS));
+    MUST_BE_TRUE(tcp_header.hasFlags(TcpHeader::FIN));
+    MUST_BE_FALSE(tcp_header.hasFlags(TcpHeader::ACK));
+
+    std::uint8_t header_raw[TcpHeader::LENGTH_BYTES];
+    tcp_header.writeRaw(header_raw, misc::ENDIAN_BIG);
+    MUST_BE_TRUE(header_raw[12] == 0xf1);
+    MUST_BE_TRUE(header_raw[13] == 0x01);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpHeader_test::View::body()
+{
+    TcpHeaderView view(HEADER_RAW);
+
+    MUST_BE_TRUE(view.getSourcePort() == 55000);
+    MUST_BE_TRUE(view.getDestinationPort() == 80);
+    MUST_BE_TRUE(view.getSequenceNumber() == 0x12345678);
+    MUST_BE_TRUE(view.getAcknowledgementNumber() == 0);
+    MUST_BE_TRUE(view.getDataOffset() == 10);
+    MUST_BE_TRUE(view.getDataOffsetBytes() == 40);
+    MUST_BE_TRUE(view.getFlags() ==
+                 (TcpHeader::SYN | TcpHeader::ECE | TcpHeader::CWR));
+    MUST_BE_TRUE(view.hasFlags(TcpHeader::SYN));
+    MUST_BE_FALSE(view.hasFlags(TcpHeader::RST));
+    MUST_BE_TRUE(view.getWindowSize() == 64240);
+    MUST_BE_TRUE(view.getChecksum() == 0x7e5d);
+    MUST_BE_TRUE(view.getUrgentPointer() == 0);
+    MUST_BE_TRUE(view.getPayload() == HEADER_RAW + 40);
+
+    // The NS bit lives in the byte with the data offset
+    TcpHeader tcp_header(1, 2);
+    tcp_header.setFlags(TcpHeader::NS | TcpHeader::ACK | TcpHeader::PSH);
+    tcp_header.setSequenceNumber(0xfedcba98);
+    tcp_header.setAcknowledgementNumber(0x01234567);
+
+    std::uint8_t header_raw[TcpHeader::LENGTH_BYTES];
+    tcp_header.writeRaw(header_raw, misc::ENDIAN_BIG);
+
+    TcpHeaderView written_view(header_raw);
+    MUST_BE_TRUE(written_view.getFlags() ==
+                 (TcpHeader::NS | TcpHeader::ACK | TcpHeader::PSH));
+    MUST_BE_TRUE(written_view.getDataOffset() == 5);
+    MUST_BE_TRUE(written_view.getSequenceNumber() == 0xfedcba98);
+    MUST_BE_TRUE(written_view.getAcknowledgementNumber() == 0x01234567);
+
+    return Test::PASSED;
+}
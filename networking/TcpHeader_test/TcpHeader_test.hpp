@@ -0,0 +1,17 @@
+#if !defined TCP_HEADER_TEST
+#define TCP_HEADER_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(TcpHeader_test)
+
+    TEST(Length)
+    TEST(ReadRaw)
+    TEST(PackedFields)
+    TEST(View)
+
+TEST_CASES_END(TcpHeader_test)
+
+#endif
@@ -0,0 +1,633 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "TcpReassembler.hpp"
+
+#include "EthernetIIHeader.hpp"
+#include "Ipv4Header.hpp"
+#include "Ipv4HeaderView.hpp"
+#include "TcpHeader.hpp"
+#include "TcpHeaderView.hpp"
+#include "TcpStreamHandler.hpp"
+
+const unsigned int TcpReassembler::STREAMS_MAX_DEFAULT;
+const unsigned int TcpReassembler::MEMORY_MAX_DEFAULT;
+const unsigned int TcpReassembler::WINDOW_DEFAULT;
+const unsigned int TcpReassembler::BUFFER_SIZE;
+
+//==============================================================================
+// Returns how far 'sequence' lies past 'base', negative if it lies before;
+// sequence numbers wrap, so this is only meaningful within 2^31 either way
+//==============================================================================
+static std::int32_t distance(std::uint32_t base, std::uint32_t sequence)
+{
+    return static_cast<std::int32_t>(sequence - base);
+}
+
+//==============================================================================
+// Allocates everything up front
+//==============================================================================
+TcpReassembler::TcpReassembler(TcpStreamHandler* handler,
+                               unsigned int      streams_max,
+                               unsigned int      memory_max,
+                               unsigned int      window,
+                               double            timeout) :
+    handler(handler),
+    active_head(-1),
+    active_tail(-1),
+    free_connections(-1),
+    window(window),
+    timeout(timeout),
+    stream_count(0),
+    delivered_bytes(0),
+    gap_bytes(0),
+    duplicate_bytes(0),
+    evicted_count(0),
+    rejected_count(0)
+{
+    if (streams_max == 0 || memory_max < BUFFER_SIZE || window == 0 ||
+        window > 0x40000000 || !(timeout > 0.0))
+    {
+        throw std::invalid_argument(
+            "Reassembler limits must leave room for at least one stream");
+    }
+
+    connections.resize(streams_max);
+    for (unsigned int i = streams_max; i > 0; --i)
+    {
+        connections[i - 1].active_next = free_connections;
+        free_connections = i - 1;
+    }
+
+    // Keep chains short even when every stream is open
+    unsigned int bucket_count = 1;
+    while (bucket_count < streams_max * 2)
+    {
+        bucket_count *= 2;
+    }
+
+    buckets.assign(bucket_count, -1);
+
+    unsigned int buffer_count = memory_max / BUFFER_SIZE;
+    buffers.resize(buffer_count);
+    buffer_memory.resize(buffer_count * BUFFER_SIZE);
+    free_buffers.reserve(buffer_count);
+    for (unsigned int i = buffer_count; i > 0; --i)
+    {
+        free_buffers.push_back(i - 1);
+    }
+}
+
+//==============================================================================
+TcpReassembler::~TcpReassembler()
+{
+}
+
+//==============================================================================
+// Handles one Ethernet II frame
+//==============================================================================
+bool TcpReassembler::addFrame(const std::uint8_t* frame,
+                              unsigned int        size,
+                              double              now)
+{
+    if (size < EthernetIIHeader::LENGTH_BYTES ||
+        (frame[12] << 8 | frame[13]) != EthernetIIHeader::IPV4)
+    {
+        rejected_count++;
+        return false;
+    }
+
+    return addPacket(frame + EthernetIIHeader::LENGTH_BYTES,
+                     size - EthernetIIHeader::LENGTH_BYTES,
+                     now);
+}
+
+//==============================================================================
+// Handles one IPv4 packet
+//==============================================================================
+bool TcpReassembler::addPacket(const std::uint8_t* packet,
+                               unsigned int        size,
+                               double              now)
+{
+    if (size < Ipv4Header::LENGTH_BYTES)
+    {
+        rejected_count++;
+        return false;
+    }
+
+    Ipv4HeaderView ip(packet);
+    unsigned int header_length = ip.getHeaderLengthBytes();
+    unsigned int total_length  = ip.getTotalLength();
+
+    if (ip.getVersion() != 4 ||
+        header_length < Ipv4Header::LENGTH_BYTES ||
+        total_length < header_length + TcpHeader::LENGTH_BYTES ||
+        total_length > size ||
+        ip.getProtocol() != Ipv4Header::TCP ||
+        ip.isFragment())
+    {
+        rejected_count++;
+        return false;
+    }
+
+    TcpHeaderView tcp(ip.getPayload());
+    unsigned int segment_length = total_length - header_length;
+    unsigned int data_offset    = tcp.getDataOffsetBytes();
+
+    if (data_offset < TcpHeader::LENGTH_BYTES || data_offset > segment_length)
+    {
+        rejected_count++;
+        return false;
+    }
+
+    addSegment(ip.getSource(),
+               ip.getDestination(),
+               tcp.getSourcePort(),
+               tcp.getDestinationPort(),
+               tcp.getSequenceNumber(),
+               tcp.getFlags(),
+               tcp.getPayload(),
+               segment_length - data_offset,
+               now);
+
+    return true;
+}
+
+//==============================================================================
+// Handles one segment
+//==============================================================================
+void TcpReassembler::addSegment(std::uint32_t       source,
+                                std::uint32_t       destination,
+                                std::uint16_t       source_port,
+                                std::uint16_t       destination_port,
+                                std::uint32_t       sequence,
+                                std::uint16_t       flags,
+                                const std::uint8_t* data,
+                                unsigned int        size,
+                                double              now)
+{
+    expire(now);
+
+    std::int32_t index =
+        find(source, destination, source_port, destination_port);
+
+    if (flags & TcpHeader::RST)
+    {
+        if (index != -1)
+        {
+            close(index);
+        }
+
+        return;
+    }
+
+    // The SYN takes up a sequence number of its own, ahead of any data
+    bool          syn          = (flags & TcpHeader::SYN) != 0;
+    std::uint32_t syn_sequence = sequence;
+    if (syn)
+    {
+        sequence++;
+    }
+
+    // A SYN other than a retransmission of the one that opened the stream
+    // means the ports have been reused by a new connection before the old one
+    // was seen to end, which happens often enough in real captures
+    if (syn && index != -1 &&
+        (!connections[index].syn_seen ||
+         connections[index].syn != syn_sequence))
+    {
+        close(index);
+        index = -1;
+    }
+
+    if (index == -1)
+    {
+        // Bare acknowledgements and FINs can't start a stream; there'd be
+        // nothing to hand on
+        if (!syn && size == 0)
+        {
+            return;
+        }
+
+        index = open(source, destination, source_port, destination_port,
+                     sequence);
+
+        connections[index].syn      = syn_sequence;
+        connections[index].syn_seen = syn;
+    }
+
+    touch(index, now);
+
+    Connection& connection = connections[index];
+
+    if ((flags & TcpHeader::FIN) && !connection.fin_seen)
+    {
+        connection.fin      = sequence + size;
+        connection.fin_seen = true;
+    }
+
+    if (size > 0)
+    {
+        deliver(connection, sequence, data, size);
+    }
+
+    if (connection.fin_seen && distance(connection.fin, connection.next) >= 0)
+    {
+        close(index);
+    }
+}
+
+//==============================================================================
+// Ends everything that's timed out
+//==============================================================================
+void TcpReassembler::expire(double now)
+{
+    while (active_head != -1 &&
+           now - connections[active_head].last_active >= timeout)
+    {
+        close(active_head);
+    }
+}
+
+//==============================================================================
+// Ends everything
+//==============================================================================
+void TcpReassembler::flush()
+{
+    while (active_head != -1)
+    {
+        close(active_head);
+    }
+}
+
+//==============================================================================
+// Finds an open stream
+//==============================================================================
+std::int32_t TcpReassembler::find(std::uint32_t source,
+                                  std::uint32_t destination,
+                                  std::uint16_t source_port,
+                                  std::uint16_t destination_port) const
+{
+    for (std::int32_t i =
+             buckets[getBucket(source, destination, source_port,
+                               destination_port)];
+         i != -1;
+         i = connections[i].bucket_next)
+    {
+        const Stream& stream = connections[i].stream;
+        if (stream.source == source &&
+            stream.destination == destination &&
+            stream.source_port == source_port &&
+            stream.destination_port == destination_port)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//==============================================================================
+// Starts a new stream
+//==============================================================================
+std::int32_t TcpReassembler::open(std::uint32_t source,
+                                  std::uint32_t destination,
+                                  std::uint16_t source_port,
+                                  std::uint16_t destination_port,
+                                  std::uint32_t next)
+{
+    if (free_connections == -1)
+    {
+        close(active_head);
+        evicted_count++;
+    }
+
+    std::int32_t index = free_connections;
+    Connection&  connection = connections[index];
+    free_connections = connection.active_next;
+
+    connection.stream.source           = source;
+    connection.stream.destination      = destination;
+    connection.stream.source_port      = source_port;
+    connection.stream.destination_port = destination_port;
+    connection.stream.context          = 0;
+    connection.next                    = next;
+    connection.fin                     = 0;
+    connection.fin_seen                = false;
+    connection.buffers_head            = -1;
+    connection.buffers_tail            = -1;
+
+    unsigned int bucket =
+        getBucket(source, destination, source_port, destination_port);
+    connection.bucket_next = buckets[bucket];
+    buckets[bucket] = index;
+
+    connection.active_previous = active_tail;
+    connection.active_next     = -1;
+    if (active_tail == -1)
+    {
+        active_head = index;
+    }
+    else
+    {
+        connections[active_tail].active_next = index;
+    }
+    active_tail = index;
+
+    stream_count++;
+    return index;
+}
+
+//==============================================================================
+// Hands on or stores one segment's data
+//==============================================================================
+void TcpReassembler::deliver(Connection&         connection,
+                             std::uint32_t       sequence,
+                             const std::uint8_t* data,
+                             unsigned int        size)
+{
+    while (true)
+    {
+        std::int32_t offset = distance(connection.next, sequence);
+
+        if (offset <= 0)
+        {
+            // In order, or partly or wholly retransmitted; whatever's new goes
+            // straight from the packet to the handler
+            std::uint32_t seen = connection.next - sequence;
+            if (seen >= size)
+            {
+                duplicate_bytes += size;
+                return;
+            }
+
+            duplicate_bytes += seen;
+            handler->handleData(connection.stream, data + seen, size - seen);
+            delivered_bytes += size - seen;
+            connection.next += size - seen;
+
+            drain(connection);
+            return;
+        }
+
+        if (static_cast<std::uint64_t>(offset) + size <= window &&
+            store(connection, sequence, data, size))
+        {
+            return;
+        }
+
+        // No room to wait for what's missing.  Give up on it up to this
+        // segment if nothing stored comes before it, so it's handed on
+        // rather than lost, or else up to the earliest stored data, and try
+        // again.
+        if (connection.buffers_head == -1 ||
+            offset < distance(connection.next,
+                              buffers[connection.buffers_head].sequence))
+        {
+            handler->handleGap(connection.stream, offset);
+            gap_bytes += offset;
+            connection.next = sequence;
+        }
+        else
+        {
+            skip(connection);
+        }
+    }
+}
+
+//==============================================================================
+// Copies early data into buffers, kept in sequence order
+//==============================================================================
+bool TcpReassembler::store(Connection&         connection,
+                           std::uint32_t       sequence,
+                           const std::uint8_t* data,
+                           unsigned int        size)
+{
+    if (free_buffers.size() < (size + BUFFER_SIZE - 1) / BUFFER_SIZE)
+    {
+        return false;
+    }
+
+    for (unsigned int position = 0; position < size; position += BUFFER_SIZE)
+    {
+        std::uint32_t piece_sequence = sequence + position;
+        unsigned int  piece_size     = std::min(BUFFER_SIZE, size - position);
+        std::int32_t  piece_offset   =
+            distance(connection.next, piece_sequence);
+
+        // Find the last buffer starting no later than this piece, going
+        // straight to the end in the usual case of data arriving in order
+        // after a hole
+        std::int32_t previous = connection.buffers_tail;
+        if (previous != -1 &&
+            distance(connection.next, buffers[previous].sequence) >
+                piece_offset)
+        {
+            previous = -1;
+            for (std::int32_t i = connection.buffers_head;
+                 i != -1 &&
+                     distance(connection.next, buffers[i].sequence) <=
+                         piece_offset;
+                 i = buffers[i].next)
+            {
+                previous = i;
+            }
+        }
+
+        // Retransmits of stored data needn't be stored twice
+        if (previous != -1 &&
+            buffers[previous].sequence == piece_sequence &&
+            buffers[previous].size >= piece_size)
+        {
+            duplicate_bytes += piece_size;
+            continue;
+        }
+
+        std::int32_t index = free_buffers.back();
+        free_buffers.pop_back();
+
+        Buffer& buffer  = buffers[index];
+        buffer.sequence = piece_sequence;
+        buffer.size     = piece_size;
+        memcpy(&buffer_memory[index * BUFFER_SIZE], data + position,
+               piece_size);
+
+        if (previous == -1)
+        {
+            buffer.next = connection.buffers_head;
+            connection.buffers_head = index;
+        }
+        else
+        {
+            buffer.next = buffers[previous].next;
+            buffers[previous].next = index;
+        }
+
+        if (buffer.next == -1)
+        {
+            connection.buffers_tail = index;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Hands on stored data that's now next in line, trimming overlaps
+//==============================================================================
+void TcpReassembler::drain(Connection& connection)
+{
+    while (connection.buffers_head != -1)
+    {
+        std::int32_t index  = connection.buffers_head;
+        Buffer&      buffer = buffers[index];
+
+        if (distance(connection.next, buffer.sequence) > 0)
+        {
+            return;
+        }
+
+        std::uint32_t seen = connection.next - buffer.sequence;
+        if (seen < buffer.size)
+        {
+            handler->handleData(connection.stream,
+                                &buffer_memory[index * BUFFER_SIZE + seen],
+                                buffer.size - seen);
+            delivered_bytes += buffer.size - seen;
+            duplicate_bytes += seen;
+            connection.next += buffer.size - seen;
+        }
+        else
+        {
+            duplicate_bytes += buffer.size;
+        }
+
+        connection.buffers_head = buffer.next;
+        if (buffer.next == -1)
+        {
+            connection.buffers_tail = -1;
+        }
+
+        free_buffers.push_back(index);
+    }
+}
+
+//==============================================================================
+// Gives up on missing data up to the earliest stored data
+//==============================================================================
+void TcpReassembler::skip(Connection& connection)
+{
+    std::uint32_t first = buffers[connection.buffers_head].sequence;
+    std::uint32_t gap   = first - connection.next;
+
+    handler->handleGap(connection.stream, gap);
+    gap_bytes += gap;
+    connection.next = first;
+
+    drain(connection);
+}
+
+//==============================================================================
+// Ends a stream
+//==============================================================================
+void TcpReassembler::close(std::int32_t index)
+{
+    Connection& connection = connections[index];
+
+    drain(connection);
+    while (connection.buffers_head != -1)
+    {
+        skip(connection);
+    }
+
+    handler->handleClose(connection.stream);
+
+    const Stream& stream = connection.stream;
+    std::int32_t* link = &buckets[getBucket(stream.source,
+                                            stream.destination,
+                                            stream.source_port,
+                                            stream.destination_port)];
+    while (*link != index)
+    {
+        link = &connections[*link].bucket_next;
+    }
+    *link = connection.bucket_next;
+
+    if (connection.active_previous == -1)
+    {
+        active_head = connection.active_next;
+    }
+    else
+    {
+        connections[connection.active_previous].active_next =
+            connection.active_next;
+    }
+
+    if (connection.active_next == -1)
+    {
+        active_tail = connection.active_previous;
+    }
+    else
+    {
+        connections[connection.active_next].active_previous =
+            connection.active_previous;
+    }
+
+    connection.active_next = free_connections;
+    free_connections = index;
+
+    stream_count--;
+}
+
+//==============================================================================
+// Moves a stream to the most recently active end of the chain
+//==============================================================================
+void TcpReassembler::touch(std::int32_t index, double now)
+{
+    Connection& connection = connections[index];
+    connection.last_active = now;
+
+    if (index == active_tail)
+    {
+        return;
+    }
+
+    if (connection.active_previous == -1)
+    {
+        active_head = connection.active_next;
+    }
+    else
+    {
+        connections[connection.active_previous].active_next =
+            connection.active_next;
+    }
+    connections[connection.active_next].active_previous =
+        connection.active_previous;
+
+    connection.active_previous = active_tail;
+    connection.active_next     = -1;
+    connections[active_tail].active_next = index;
+    active_tail = index;
+}
+
+//==============================================================================
+// Mixes the key into a bucket index
+//==============================================================================
+unsigned int TcpReassembler::getBucket(std::uint32_t source,
+                                       std::uint32_t destination,
+                                       std::uint16_t source_port,
+                                       std::uint16_t destination_port) const
+{
+    std::uint32_t hash = source ^ destination * 0x9e3779b1 ^
+        (static_cast<std::uint32_t>(source_port) << 16 | destination_port) *
+        0x85ebca6b;
+
+    hash ^= hash >> 16;
+    hash *= 0x7feb352d;
+    hash ^= hash >> 15;
+
+    return hash & (buckets.size() - 1);
+}
@@ -0,0 +1,277 @@
+#if !defined TCP_REASSEMBLER_HPP
+#define TCP_REASSEMBLER_HPP
+
+#include <cstdint>
+#include <vector>
+
+class TcpStreamHandler;
+
+// Puts the byte streams carried by captured TCP segments back in order, for
+// analysing application protocols in traffic from a RawSocket or a pcap file.
+// Each direction of each connection is its own stream, keyed by source and
+// destination address and port.  Streams start at a SYN, or at the first
+// segment carrying data when a capture picks a connection up part way through,
+// and end at a FIN or RST, when they've been idle for the timeout, when room
+// is needed for a new one or when a new SYN shows the ports have been reused
+// by another connection.
+//
+// Data arriving in order is handed to a TcpStreamHandler straight out of the
+// packet it came in, without being copied.  Data arriving early is copied into
+// fixed-size buffers taken from a pool allocated up front, and handed on once
+// whatever comes before it turns up.  Retransmitted and overlapping data is
+// trimmed so every byte of a stream is handed on once; where two copies of a
+// byte disagree, the one handed on is the one already handed on or, failing
+// that, the one from the segment starting earliest.  Rather than
+// wait forever on data that was never captured, a stream gives up on it and
+// reports a gap when its early data would reach past the window or the buffer
+// pool runs dry.  Nothing is allocated after construction.
+//
+// IPv4 fragments are turned away; put them through an Ipv4Reassembler first.
+class TcpReassembler
+{
+public:
+
+    // One direction of one connection.  Addresses are in host byte order.
+    struct Stream
+    {
+        std::uint32_t source;
+        std::uint32_t destination;
+        std::uint16_t source_port;
+        std::uint16_t destination_port;
+
+        // Free for the handler to use, say for per-stream parser state; zero
+        // when the stream starts
+        void* context;
+    };
+
+    // Hands streams to 'handler', which must outlive this object.  Room is
+    // made for 'streams_max' streams and 'memory_max' bytes of early data at
+    // once.  A stream holds early data at most 'window' bytes past what it has
+    // handed on, and is ended after 'timeout' seconds without a segment.
+    // Throws std::invalid_argument if any of these leave no room for
+    // anything.
+    explicit TcpReassembler(TcpStreamHandler* handler,
+                            unsigned int      streams_max = STREAMS_MAX_DEFAULT,
+                            unsigned int      memory_max = MEMORY_MAX_DEFAULT,
+                            unsigned int      window = WINDOW_DEFAULT,
+                            double            timeout = 120.0);
+
+    // Does nothing; call flush() first to have open streams ended properly
+    ~TcpReassembler();
+
+    // Handles an Ethernet II frame.  'now' is the time in seconds on whatever
+    // clock the caller likes, capture timestamps for instance, as long as it's
+    // the same one every call; streams that have timed out as of 'now' are
+    // ended before the segment is handled.  Returns false if the frame isn't
+    // a well-formed IPv4 TCP segment.
+    bool addFrame(const std::uint8_t* frame, unsigned int size, double now);
+
+    // Same as above for a packet starting with its IPv4 header
+    bool addPacket(const std::uint8_t* packet, unsigned int size, double now);
+
+    // Handles one segment given directly.  'flags' are TcpHeader::Flag bits.
+    void addSegment(std::uint32_t       source,
+                    std::uint32_t       destination,
+                    std::uint16_t       source_port,
+                    std::uint16_t       destination_port,
+                    std::uint32_t       sequence,
+                    std::uint16_t       flags,
+                    const std::uint8_t* data,
+                    unsigned int        size,
+                    double              now);
+
+    // Ends streams that have timed out as of 'now', for callers that want
+    // them gone even when no segments are arriving
+    void expire(double now);
+
+    // Ends every stream, handing on whatever early data each holds with gaps
+    // for what's missing; for the end of a capture
+    void flush();
+
+    // Returns the number of streams open
+    unsigned int getStreamCount() const;
+
+    // Returns the number of bytes handed on, and reported as gaps
+    std::uint64_t getDeliveredBytes() const;
+    std::uint64_t getGapBytes() const;
+
+    // Returns the number of bytes thrown away as copies of ones already seen
+    std::uint64_t getDuplicateBytes() const;
+
+    // Returns the number of streams ended to make room for others
+    unsigned long getEvictedCount() const;
+
+    // Returns the number of packets addFrame() and addPacket() returned false
+    // for
+    unsigned long getRejectedCount() const;
+
+    static const unsigned int STREAMS_MAX_DEFAULT = 4096;
+    static const unsigned int MEMORY_MAX_DEFAULT  = 8 * 1024 * 1024;
+    static const unsigned int WINDOW_DEFAULT      = 1024 * 1024;
+
+    // Early data is stored in pieces of this size, enough for a whole
+    // Ethernet-sized segment; the memory limit is rounded down to a multiple
+    // of it
+    static const unsigned int BUFFER_SIZE = 2048;
+
+private:
+
+    // Early data waiting its turn, chained in sequence order through indices
+    // into 'buffers'
+    struct Buffer
+    {
+        std::uint32_t sequence;
+        unsigned int  size;
+        std::int32_t  next;
+    };
+
+    // One stream and everything needed to reassemble it.  Streams are chained
+    // together through indices into 'connections': one chain per hash bucket,
+    // and one from least to most recently active (which doubles as the chain
+    // of unused streams).
+    struct Connection
+    {
+        Stream stream;
+
+        // Sequence number of the next byte to hand on
+        std::uint32_t next;
+
+        // Sequence number the FIN sits at, once it's been seen
+        std::uint32_t fin;
+        bool          fin_seen;
+
+        // Sequence number of the SYN that opened the stream, if it was seen
+        std::uint32_t syn;
+        bool          syn_seen;
+
+        // First and last early data buffers, or -1
+        std::int32_t buffers_head;
+        std::int32_t buffers_tail;
+
+        double last_active;
+
+        std::int32_t bucket_next;
+        std::int32_t active_previous;
+        std::int32_t active_next;
+    };
+
+    // Finds the given stream; returns -1 if it isn't open
+    std::int32_t find(std::uint32_t source,
+                      std::uint32_t destination,
+                      std::uint16_t source_port,
+                      std::uint16_t destination_port) const;
+
+    // Opens a stream whose next byte is at 'next', ending the least recently
+    // active one if there's no room
+    std::int32_t open(std::uint32_t source,
+                      std::uint32_t destination,
+                      std::uint16_t source_port,
+                      std::uint16_t destination_port,
+                      std::uint32_t next);
+
+    // Hands on a segment's data or stores it for later, giving up on missing
+    // data if there's no room to store it
+    void deliver(Connection&         connection,
+                 std::uint32_t       sequence,
+                 const std::uint8_t* data,
+                 unsigned int        size);
+
+    // Copies early data into buffers; returns false if there aren't enough
+    bool store(Connection&         connection,
+               std::uint32_t       sequence,
+               const std::uint8_t* data,
+               unsigned int        size);
+
+    // Hands on whatever stored data has become next in line
+    void drain(Connection& connection);
+
+    // Gives up on the missing data before the earliest stored data
+    void skip(Connection& connection);
+
+    // Hands on everything stored, ends the stream and returns it to the
+    // unused pool
+    void close(std::int32_t index);
+
+    // Makes a stream the most recently active
+    void touch(std::int32_t index, double now);
+
+    // Returns the hash bucket for the given key
+    unsigned int getBucket(std::uint32_t source,
+                           std::uint32_t destination,
+                           std::uint16_t source_port,
+                           std::uint16_t destination_port) const;
+
+    TcpStreamHandler* handler;
+
+    std::vector<Connection> connections;
+
+    // Head of each bucket's chain
+    std::vector<std::int32_t> buckets;
+
+    // Least and most recently active open streams, and the first unused one
+    std::int32_t active_head;
+    std::int32_t active_tail;
+    std::int32_t free_connections;
+
+    std::vector<Buffer>       buffers;
+    std::vector<std::uint8_t> buffer_memory;
+
+    // Indices of unused buffers
+    std::vector<std::int32_t> free_buffers;
+
+    unsigned int window;
+
+    double timeout;
+
+    unsigned int stream_count;
+
+    std::uint64_t delivered_bytes;
+    std::uint64_t gap_bytes;
+    std::uint64_t duplicate_bytes;
+
+    unsigned long evicted_count;
+    unsigned long rejected_count;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    TcpReassembler(const TcpReassembler&);
+    TcpReassembler& operator=(const TcpReassembler&);
+};
+
+//==============================================================================
+inline unsigned int TcpReassembler::getStreamCount() const
+{
+    return stream_count;
+}
+
+//==============================================================================
+inline std::uint64_t TcpReassembler::getDeliveredBytes() const
+{
+    return delivered_bytes;
+}
+
+//==============================================================================
+inline std::uint64_t TcpReassembler::getGapBytes() const
+{
+    return gap_bytes;
+}
+
+//==============================================================================
+inline std::uint64_t TcpReassembler::getDuplicateBytes() const
+{
+    return duplicate_bytes;
+}
+
+//==============================================================================
+inline unsigned long TcpReassembler::getEvictedCount() const
+{
+    return evicted_count;
+}
+
+//==============================================================================
+inline unsigned long TcpReassembler::getRejectedCount() const
+{
+    return rejected_count;
+}
+
+#endif
@@ -0,0 +1,560 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "TcpReassembler_test.hpp"
+
+#include "EthernetIIHeader.hpp"
+#include "Ipv4Header.hpp"
+#include "TcpHeader.hpp"
+#include "TcpReassembler.hpp"
+#include "TcpStreamHandler.hpp"
+
+#include "TestMacros.hpp"
+#include "misc.hpp"
+
+TEST_PROGRAM_MAIN(TcpReassembler_test);
+
+//==============================================================================
+void TcpReassembler_test::addTestCases()
+{
+    ADD_TEST_CASE(InOrder);
+    ADD_TEST_CASE(OutOfOrder);
+    ADD_TEST_CASE(Retransmit);
+    ADD_TEST_CASE(PortReuse);
+    ADD_TEST_CASE(Gaps);
+    ADD_TEST_CASE(EarlierThanStored);
+    ADD_TEST_CASE(Lifetime);
+    ADD_TEST_CASE(Packets);
+    ADD_TEST_CASE(Shuffled);
+}
+
+// Every stream in these tests runs between these two addresses, and is told
+// apart from the others by its source port
+static const std::uint32_t SOURCE      = 0x0a000001;
+static const std::uint32_t DESTINATION = 0x0a000002;
+
+// Everything handed on for one stream
+struct Record
+{
+    Record() :
+        gap_bytes(0),
+        closes(0),
+        starts(0)
+    {
+    }
+
+    std::string  data;
+    unsigned int gap_bytes;
+    unsigned int closes;
+
+    // Number of times the stream's context was found unset
+    unsigned int starts;
+};
+
+// Keeps a Record for every stream it's given, by source port
+class RecordingHandler : public TcpStreamHandler
+{
+public:
+
+    RecordingHandler() :
+        last_data(0)
+    {
+    }
+
+    virtual void handleData(TcpReassembler::Stream& stream,
+                            const unsigned char*    data,
+                            unsigned int            size)
+    {
+        Record& record = records[stream.source_port];
+        record.data.append(reinterpret_cast<const char*>(data), size);
+        last_data = data;
+
+        // The context should stick with the stream from here on
+        if (stream.context == 0)
+        {
+            stream.context = &record;
+            record.starts++;
+        }
+    }
+
+    virtual void handleGap(TcpReassembler::Stream& stream, unsigned int size)
+    {
+        records[stream.source_port].gap_bytes += size;
+    }
+
+    virtual void handleClose(TcpReassembler::Stream& stream)
+    {
+        records[stream.source_port].closes++;
+    }
+
+    std::map<std::uint16_t, Record> records;
+
+    const unsigned char* last_data;
+};
+
+//==============================================================================
+// Gives the reassembler one segment of the stream from 'port'
+//==============================================================================
+static void send(TcpReassembler&    reassembler,
+                 std::uint16_t      port,
+                 std::uint32_t      sequence,
+                 const std::string& data,
+                 std::uint16_t      flags = TcpHeader::ACK,
+                 double             now = 0.0)
+{
+    reassembler.addSegment(
+        SOURCE, DESTINATION, port, 80, sequence, flags,
+        reinterpret_cast<const std::uint8_t*>(data.data()), data.size(), now);
+}
+
+//==============================================================================
+// Builds an IPv4 packet carrying a TCP segment
+//==============================================================================
+static std::vector<std::uint8_t> makePacket(std::uint16_t      port,
+                                            std::uint32_t      sequence,
+                                            std::uint16_t      flags,
+                                            const std::string& data)
+{
+    unsigned int length =
+        Ipv4Header::LENGTH_BYTES + TcpHeader::LENGTH_BYTES + data.size();
+
+    Ipv4Header ip(Ipv4Header::TCP);
+    ip.setTotalLength(length);
+    ip.setTtl(64);
+    *ip.getSource()      = "10.0.0.1";
+    *ip.getDestination() = "10.0.0.2";
+
+    TcpHeader tcp(port, 80);
+    tcp.setSequenceNumber(sequence);
+    tcp.setFlags(flags);
+
+    std::vector<std::uint8_t> packet(length);
+    ip.writeRaw(&packet[0], misc::ENDIAN_BIG);
+    tcp.writeRaw(&packet[Ipv4Header::LENGTH_BYTES], misc::ENDIAN_BIG);
+    std::copy(data.begin(),
+              data.end(),
+              packet.begin() + Ipv4Header::LENGTH_BYTES +
+                  TcpHeader::LENGTH_BYTES);
+
+    return packet;
+}
+
+//==============================================================================
+// Returns a string of the given size that's unlikely to be mistaken for any
+// other
+//==============================================================================
+static std::string makeData(unsigned int size, unsigned int seed)
+{
+    std::string data(size, 0);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<char>(i * 7 + seed + i / 251);
+    }
+
+    return data;
+}
+
+//==============================================================================
+Test::Result TcpReassembler_test::InOrder::body()
+{
+    RecordingHandler handler;
+    TcpReassembler   reassembler(&handler);
+
+    // A bare acknowledgement doesn't start a stream
+    send(reassembler, 1, 500, "");
+    MUST_BE_TRUE(reassembler.getStreamCount() == 0);
+
+    send(reassembler, 1, 1000, "", TcpHeader::SYN);
+    MUST_BE_TRUE(reassembler.getStreamCount() == 1);
+
+    send(reassembler, 1, 1001, "hello");
+    send(reassembler, 1, 1006, " world");
+    MUST_BE_TRUE(handler.records[1].data == "hello world");
+    MUST_BE_TRUE(handler.records[1].closes == 0);
+
+    send(reassembler, 1, 1012, "", TcpHeader::FIN | TcpHeader::ACK);
+    MUST_BE_TRUE(handler.records[1].closes == 1);
+    MUST_BE_TRUE(reassembler.getStreamCount() == 0);
+
+    // Data can ride along with the SYN and the FIN, and sequence numbers wrap
+    send(reassembler, 2, 0xfffffffd, "ab", TcpHeader::SYN);
+    send(reassembler, 2, 0x00000000, "cdef");
+    send(reassembler, 2, 0x00000004, "gh", TcpHeader::FIN);
+    MUST_BE_TRUE(handler.records[2].data == "abcdefgh");
+    MUST_BE_TRUE(handler.records[2].closes == 1);
+
+    // Captures can start part way through a connection
+    send(reassembler, 3, 123456, "middle");
+    send(reassembler, 3, 123462, " and end");
+    MUST_BE_TRUE(handler.records[3].data == "middle and end");
+
+    MUST_BE_TRUE(reassembler.getDeliveredBytes() == 11 + 8 + 14);
+    MUST_BE_TRUE(reassembler.getGapBytes() == 0);
+    MUST_BE_TRUE(reassembler.getDuplicateBytes() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpReassembler_test::OutOfOrder::body()
+{
+    RecordingHandler handler;
+    TcpReassembler   reassembler(&handler);
+
+    send(reassembler, 1, 0, "", TcpHeader::SYN);
+    send(reassembler, 1, 12, "!");
+    send(reassembler, 1, 7, "world");
+    MUST_BE_TRUE(handler.records[1].data.empty());
+
+    send(reassembler, 1, 1, "hello ");
+    MUST_BE_TRUE(handler.records[1].data == "hello world!");
+
+    // Early data bigger than a buffer is split across several
+    std::string big = makeData(TcpReassembler::BUFFER_SIZE * 2 + 100, 1);
+    send(reassembler, 1, 13 + 10, big);
+    send(reassembler, 1, 13, "0123456789");
+    MUST_BE_TRUE(handler.records[1].data == "hello world!0123456789" + big);
+
+    // A FIN arriving early waits for the data before it
+    send(reassembler, 1, 13 + 10 + big.size() + 3, "", TcpHeader::FIN);
+    MUST_BE_TRUE(handler.records[1].closes == 0);
+    send(reassembler, 1, 13 + 10 + big.size(), "end");
+    MUST_BE_TRUE(handler.records[1].closes == 1);
+    MUST_BE_TRUE(handler.records[1].gap_bytes == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpReassembler_test::Retransmit::body()
+{
+    RecordingHandler handler;
+    TcpReassembler   reassembler(&handler);
+
+    send(reassembler, 1, 0, "", TcpHeader::SYN);
+    send(reassembler, 1, 1, "hello");
+    send(reassembler, 1, 1, "hello");
+    MUST_BE_TRUE(handler.records[1].data == "hello");
+    MUST_BE_TRUE(reassembler.getDuplicateBytes() == 5);
+
+    // Only the part not seen before is handed on, and what was handed on
+    // first stands
+    send(reassembler, 1, 4, "XX wor");
+    MUST_BE_TRUE(handler.records[1].data == "hello wor");
+
+    // Early data stored twice is stored once, and overlaps between stored
+    // data are trimmed as it's handed on
+    send(reassembler, 1, 19, "uvwxyz");
+    send(reassembler, 1, 19, "uvwxyz");
+    send(reassembler, 1, 14, "pqrstuv");
+    send(reassembler, 1, 10, "ld, ");
+    MUST_BE_TRUE(handler.records[1].data == "hello world, pqrstuvwxyz");
+    MUST_BE_TRUE(reassembler.getDuplicateBytes() == 5 + 2 + 6 + 2);
+    MUST_BE_TRUE(reassembler.getGapBytes() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpReassembler_test::PortReuse::body()
+{
+    RecordingHandler handler;
+    TcpReassembler   reassembler(&handler);
+
+    send(reassembler, 1, 1000, "", TcpHeader::SYN);
+    send(reassembler, 1, 1001, "first");
+
+    // A retransmitted SYN is still the same connection
+    send(reassembler, 1, 1000, "", TcpHeader::SYN);
+    send(reassembler, 1, 1006, " one");
+    MUST_BE_TRUE(handler.records[1].data == "first one");
+    MUST_BE_TRUE(handler.records[1].closes == 0);
+
+    // The ports are reused before the first connection is seen to end, with
+    // a sequence number behind the old one's and then one far ahead of it;
+    // each time the old stream is ended and the new one starts afresh
+    send(reassembler, 1, 500, "", TcpHeader::SYN);
+    MUST_BE_TRUE(handler.records[1].closes == 1);
+    send(reassembler, 1, 501, ", second");
+
+    send(reassembler, 1, 0x80000000, "", TcpHeader::SYN);
+    MUST_BE_TRUE(handler.records[1].closes == 2);
+    send(reassembler, 1, 0x80000001, ", third");
+
+    MUST_BE_TRUE(handler.records[1].data == "first one, second, third");
+    MUST_BE_TRUE(handler.records[1].starts == 3);
+    MUST_BE_TRUE(reassembler.getStreamCount() == 1);
+    MUST_BE_TRUE(reassembler.getDuplicateBytes() == 0);
+    MUST_BE_TRUE(reassembler.getGapBytes() == 0);
+
+    // A stream picked up part way through has no SYN of its own, so any SYN
+    // starts a new one
+    send(reassembler, 2, 123456, "middle");
+    send(reassembler, 2, 9000, "", TcpHeader::SYN);
+    send(reassembler, 2, 9001, " new");
+    MUST_BE_TRUE(handler.records[2].data == "middle new");
+    MUST_BE_TRUE(handler.records[2].closes == 1);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpReassembler_test::Gaps::body()
+{
+    RecordingHandler handler;
+    TcpReassembler   reassembler(&handler, 16, 2 * TcpReassembler::BUFFER_SIZE,
+                                 100);
+
+    // Data reaching past the window gives up on what's missing before it
+    send(reassembler, 1, 0, "", TcpHeader::SYN);
+    send(reassembler, 1, 51, "abc");
+    MUST_BE_TRUE(handler.records[1].data.empty());
+    send(reassembler, 1, 200, "def");
+    MUST_BE_TRUE(handler.records[1].data == "abcdef");
+    MUST_BE_TRUE(handler.records[1].gap_bytes == 50 + 146);
+
+    // So does running out of buffers.  The stream holding them keeps them,
+    // and the one that needs more gives up.
+    send(reassembler, 2, 0, "", TcpHeader::SYN);
+    send(reassembler, 2, 11, "x");
+    send(reassembler, 2, 21, "y");
+    send(reassembler, 3, 0, "", TcpHeader::SYN);
+    send(reassembler, 3, 6, "z");
+    MUST_BE_TRUE(handler.records[3].data == "z");
+    MUST_BE_TRUE(handler.records[3].gap_bytes == 5);
+    MUST_BE_TRUE(handler.records[2].data.empty());
+
+    // A stream that needs a buffer when it's holding some itself gives up on
+    // its own missing data up to what it holds, freeing those
+    send(reassembler, 2, 31, "w");
+    MUST_BE_TRUE(handler.records[2].data == "x");
+    MUST_BE_TRUE(handler.records[2].gap_bytes == 10);
+    send(reassembler, 2, 12, "012345678");
+    MUST_BE_TRUE(handler.records[2].data == "x012345678y");
+
+    reassembler.flush();
+    MUST_BE_TRUE(handler.records[2].data == "x012345678yw");
+    MUST_BE_TRUE(handler.records[2].gap_bytes == 10 + 9);
+
+    MUST_BE_TRUE(reassembler.getGapBytes() == 50 + 146 + 5 + 19);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpReassembler_test::EarlierThanStored::body()
+{
+    RecordingHandler handler;
+    TcpReassembler   reassembler(&handler, 16, TcpReassembler::BUFFER_SIZE,
+                                 1000);
+
+    // The only buffer holds data from further on, so this segment can't be
+    // stored.  It comes before the stored data, so it's handed on after a
+    // gap up to it rather than being skipped over.
+    send(reassembler, 1, 0, "", TcpHeader::SYN);
+    send(reassembler, 1, 500, "later");
+    send(reassembler, 1, 200, "earlier");
+    MUST_BE_TRUE(handler.records[1].data == "earlier");
+    MUST_BE_TRUE(handler.records[1].gap_bytes == 199);
+
+    reassembler.flush();
+    MUST_BE_TRUE(handler.records[1].data == "earlierlater");
+    MUST_BE_TRUE(handler.records[1].gap_bytes == 199 + 293);
+
+    MUST_BE_TRUE(reassembler.getGapBytes() == 199 + 293);
+    MUST_BE_TRUE(reassembler.getDuplicateBytes() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpReassembler_test::Lifetime::body()
+{
+    RecordingHandler handler;
+    TcpReassembler   reassembler(&handler, 2, TcpReassembler::BUFFER_SIZE * 4,
+                                 TcpReassembler::WINDOW_DEFAULT, 10.0);
+
+    // Resets end streams straight away
+    send(reassembler, 1, 0, "", TcpHeader::SYN, 0.0);
+    send(reassembler, 1, 1, "abc", TcpHeader::ACK, 0.0);
+    send(reassembler, 1, 4, "def", TcpHeader::ACK, 0.0);
+    send(reassembler, 1, 0, "", TcpHeader::RST, 0.0);
+    MUST_BE_TRUE(handler.records[1].closes == 1);
+    MUST_BE_TRUE(reassembler.getStreamCount() == 0);
+
+    // Handlers can keep their own state with each stream
+    MUST_BE_TRUE(handler.records[1].starts == 1);
+
+    // Streams left idle end, handing on what they've stored first
+    send(reassembler, 2, 0, "", TcpHeader::SYN, 1.0);
+    send(reassembler, 2, 5, "late", TcpHeader::ACK, 1.0);
+    send(reassembler, 3, 0, "", TcpHeader::SYN, 5.0);
+    reassembler.expire(10.5);
+    MUST_BE_TRUE(handler.records[2].closes == 0);
+    reassembler.expire(11.0);
+    MUST_BE_TRUE(handler.records[2].closes == 1);
+    MUST_BE_TRUE(handler.records[2].gap_bytes == 4);
+    MUST_BE_TRUE(handler.records[2].data == "late");
+    MUST_BE_TRUE(handler.records[3].closes == 0);
+
+    // Opening a stream with no room ends the least recently active one
+    send(reassembler, 4, 0, "", TcpHeader::SYN, 12.0);
+    send(reassembler, 3, 1, "a", TcpHeader::ACK, 13.0);
+    send(reassembler, 5, 0, "", TcpHeader::SYN, 14.0);
+    MUST_BE_TRUE(handler.records[4].closes == 1);
+    MUST_BE_TRUE(handler.records[3].closes == 0);
+    MUST_BE_TRUE(reassembler.getEvictedCount() == 1);
+    MUST_BE_TRUE(reassembler.getStreamCount() == 2);
+
+    reassembler.flush();
+    MUST_BE_TRUE(handler.records[3].closes == 1);
+    MUST_BE_TRUE(handler.records[5].closes == 1);
+    MUST_BE_TRUE(reassembler.getStreamCount() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpReassembler_test::Packets::body()
+{
+    RecordingHandler handler;
+    TcpReassembler   reassembler(&handler);
+
+    std::vector<std::uint8_t> syn = makePacket(1, 99, TcpHeader::SYN, "");
+    MUST_BE_TRUE(reassembler.addPacket(&syn[0], syn.size(), 0.0));
+
+    // Data in order is handed on straight out of the packet
+    std::vector<std::uint8_t> packet =
+        makePacket(1, 100, TcpHeader::ACK | TcpHeader::PSH, "GET / HTTP/1.1");
+    MUST_BE_TRUE(reassembler.addPacket(&packet[0], packet.size(), 0.0));
+    MUST_BE_TRUE(handler.records[1].data == "GET / HTTP/1.1");
+    MUST_BE_TRUE(handler.last_data ==
+                 &packet[Ipv4Header::LENGTH_BYTES + TcpHeader::LENGTH_BYTES]);
+
+    // Frames work the same way
+    EthernetIIHeader ethernet;
+    ethernet.setEthertype(EthernetIIHeader::IPV4);
+    std::vector<std::uint8_t> next = makePacket(1, 114, TcpHeader::ACK, "\r\n");
+    std::vector<std::uint8_t> frame(EthernetIIHeader::LENGTH_BYTES);
+    ethernet.writeRaw(&frame[0], misc::ENDIAN_BIG);
+    frame.insert(frame.end(), next.begin(), next.end());
+    MUST_BE_TRUE(reassembler.addFrame(&frame[0], frame.size(), 0.0));
+    MUST_BE_TRUE(handler.records[1].data == "GET / HTTP/1.1\r\n");
+
+    // Anything that isn't an unfragmented, well-formed TCP segment is turned
+    // away
+    std::vector<std::uint8_t> bad = packet;
+    bad[9] = Ipv4Header::UDP;
+    MUST_BE_FALSE(reassembler.addPacket(&bad[0], bad.size(), 0.0));
+
+    bad = packet;
+    bad[6] = 0x20;
+    MUST_BE_FALSE(reassembler.addPacket(&bad[0], bad.size(), 0.0));
+
+    bad = packet;
+    bad[Ipv4Header::LENGTH_BYTES + 12] = 0xf0;
+    MUST_BE_FALSE(reassembler.addPacket(&bad[0], bad.size(), 0.0));
+
+    MUST_BE_FALSE(reassembler.addPacket(&packet[0], packet.size() - 1, 0.0));
+    MUST_BE_FALSE(reassembler.addFrame(&frame[0], 10, 0.0));
+
+    MUST_BE_TRUE(reassembler.getRejectedCount() == 5);
+    MUST_BE_TRUE(handler.records[1].data == "GET / HTTP/1.1\r\n");
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result TcpReassembler_test::Shuffled::body()
+{
+    const unsigned int STREAMS = 8;
+    const unsigned int SIZE    = 200000;
+
+    struct Segment
+    {
+        std::uint16_t port;
+        std::uint32_t sequence;
+        std::string   data;
+    };
+
+    srand(43);
+
+    // Cut every stream into segments of random size, resend some of them
+    // whole and some overlapping their neighbours, then swap segments around
+    // locally the way a network might
+    std::vector<std::string>   streams;
+    std::vector<std::uint32_t> initials;
+    std::vector<Segment>       segments;
+    for (unsigned int i = 0; i < STREAMS; ++i)
+    {
+        initials.push_back(rand() * 2654435761u);
+        Segment syn = {static_cast<std::uint16_t>(i), initials[i], ""};
+        segments.push_back(syn);
+    }
+
+    for (unsigned int i = 0; i < STREAMS; ++i)
+    {
+        streams.push_back(makeData(SIZE, i));
+        std::uint32_t initial = initials[i];
+
+        for (unsigned int position = 0; position < SIZE;)
+        {
+            unsigned int size = std::min(SIZE - position,
+                                         1u + rand() % 3000);
+            Segment segment = {static_cast<std::uint16_t>(i),
+                               initial + 1 + position,
+                               streams[i].substr(position, size)};
+            segments.push_back(segment);
+
+            if (rand() % 10 == 0)
+            {
+                segments.push_back(segment);
+            }
+
+            if (rand() % 10 == 0 && position >= 100)
+            {
+                Segment overlap = {static_cast<std::uint16_t>(i),
+                                   initial + 1 + position - 100,
+                                   streams[i].substr(position - 100, 200)};
+                segments.push_back(overlap);
+            }
+
+            position += size;
+        }
+    }
+
+    // SYNs stay first so every stream starts at the beginning
+    for (unsigned int i = STREAMS; i + 8 < segments.size(); ++i)
+    {
+        std::swap(segments[i], segments[i + rand() % 8]);
+    }
+
+    RecordingHandler handler;
+    TcpReassembler   reassembler(&handler);
+
+    for (unsigned int i = 0; i < segments.size(); ++i)
+    {
+        send(reassembler,
+             segments[i].port,
+             segments[i].sequence,
+             segments[i].data,
+             segments[i].data.empty() ? TcpHeader::SYN : TcpHeader::ACK);
+    }
+
+    reassembler.flush();
+
+    for (unsigned int i = 0; i < STREAMS; ++i)
+    {
+        MUST_BE_TRUE(handler.records[i].data == streams[i]);
+        MUST_BE_TRUE(handler.records[i].gap_bytes == 0);
+        MUST_BE_TRUE(handler.records[i].closes == 1);
+    }
+
+    MUST_BE_TRUE(reassembler.getDeliveredBytes() == STREAMS * SIZE);
+
+    return Test::PASSED;
+}
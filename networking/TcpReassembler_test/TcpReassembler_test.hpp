@@ -0,0 +1,22 @@
+#if !defined TCP_REASSEMBLER_TEST
+#define TCP_REASSEMBLER_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(TcpReassembler_test)
+
+    TEST(InOrder)
+    TEST(OutOfOrder)
+    TEST(Retransmit)
+    TEST(PortReuse)
+    TEST(Gaps)
+    TEST(EarlierThanStored)
+    TEST(Lifetime)
+    TEST(Packets)
+    TEST(Shuffled)
+
+TEST_CASES_END(TcpReassembler_test)
+
+#endif
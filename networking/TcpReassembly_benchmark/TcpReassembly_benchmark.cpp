@@ -0,0 +1,359 @@
+// Measures how fast TcpReassembler puts streams back together.  Frames are
+// loaded into memory up front, either from a pcap file of Ethernet frames or
+// built here as a large capture of many connections interleaved, and then fed
+// to the reassembler as fast as it'll take them, so the figures are for
+// reassembly alone with no disk or network involved.  The built captures are
+// tried once in order and once with some segments swapped and resent, which
+// exercises the copying paths.
+//
+// Usage: TcpReassembly_benchmark [pcap file]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "EthernetIIHeader.hpp"
+#include "Ipv4Header.hpp"
+#include "PosixSocketCommon.hpp"
+#include "TcpHeader.hpp"
+#include "TcpReassembler.hpp"
+#include "TcpStreamHandler.hpp"
+#include "misc.hpp"
+
+// Shape of the built captures
+static const unsigned int CONNECTIONS      = 64;
+static const unsigned int CONNECTION_BYTES = 1024 * 1024;
+static const unsigned int SEGMENT_SIZE     = 1448;
+
+// Times each capture is fed through, each time to a fresh reassembler
+static const unsigned int PASSES = 5;
+
+// A capture held in memory
+struct Capture
+{
+    std::vector<std::uint8_t> bytes;
+
+    // Where each frame starts and how long it is
+    std::vector<std::size_t>  offsets;
+    std::vector<unsigned int> sizes;
+    std::vector<double>       times;
+};
+
+// Counts what it's handed, looking at every byte so the data is really read
+class CountingHandler : public TcpStreamHandler
+{
+public:
+
+    CountingHandler() :
+        bytes(0),
+        streams(0),
+        sum(0)
+    {
+    }
+
+    virtual void handleData(TcpReassembler::Stream& /* stream */,
+                            const unsigned char*    data,
+                            unsigned int            size)
+    {
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            sum += data[i];
+        }
+
+        bytes += size;
+    }
+
+    virtual void handleClose(TcpReassembler::Stream& /* stream */)
+    {
+        streams++;
+    }
+
+    std::uint64_t bytes;
+    unsigned long streams;
+    std::uint64_t sum;
+};
+
+//==============================================================================
+// Appends one frame carrying a TCP segment to 'capture'
+//==============================================================================
+static void addFrame(Capture&            capture,
+                     unsigned int        connection,
+                     std::uint32_t       sequence,
+                     std::uint16_t       flags,
+                     const std::uint8_t* data,
+                     unsigned int        size)
+{
+    static const unsigned int HEADERS_SIZE = EthernetIIHeader::LENGTH_BYTES +
+                                             Ipv4Header::LENGTH_BYTES +
+                                             TcpHeader::LENGTH_BYTES;
+
+    EthernetIIHeader ethernet;
+    ethernet.setEthertype(EthernetIIHeader::IPV4);
+
+    Ipv4Header ip(Ipv4Header::TCP);
+    ip.setTotalLength(Ipv4Header::LENGTH_BYTES + TcpHeader::LENGTH_BYTES +
+                      size);
+    ip.setTtl(64);
+    *ip.getSource()      = "10.0.0.1";
+    *ip.getDestination() = "10.0.0.2";
+
+    TcpHeader tcp(static_cast<std::uint16_t>(10000 + connection), 80);
+    tcp.setSequenceNumber(sequence);
+    tcp.setFlags(flags);
+
+    std::size_t offset = capture.bytes.size();
+    capture.bytes.resize(offset + HEADERS_SIZE + size);
+
+    std::uint8_t* frame = &capture.bytes[offset];
+    ethernet.writeRaw(frame, misc::ENDIAN_BIG);
+    ip.writeRaw(frame + EthernetIIHeader::LENGTH_BYTES, misc::ENDIAN_BIG);
+    tcp.writeRaw(frame + EthernetIIHeader::LENGTH_BYTES +
+                     Ipv4Header::LENGTH_BYTES,
+                 misc::ENDIAN_BIG);
+    if (size > 0)
+    {
+        memcpy(frame + HEADERS_SIZE, data, size);
+    }
+
+    capture.offsets.push_back(offset);
+    capture.sizes.push_back(HEADERS_SIZE + size);
+    capture.times.push_back(capture.times.size() * 1.0e-6);
+}
+
+//==============================================================================
+// Builds a capture of CONNECTIONS connections sending CONNECTION_BYTES each,
+// their segments interleaved.  If 'disorder' is set, about one segment in
+// fifty swaps places with the one after it and about one in a hundred is sent
+// twice.
+//==============================================================================
+static void buildCapture(Capture& capture, bool disorder)
+{
+    srand(44);
+
+    std::vector<std::uint8_t> data(CONNECTION_BYTES);
+    for (unsigned int i = 0; i < CONNECTION_BYTES; ++i)
+    {
+        data[i] = static_cast<std::uint8_t>(rand());
+    }
+
+    std::vector<std::uint32_t> initials(CONNECTIONS);
+    for (unsigned int i = 0; i < CONNECTIONS; ++i)
+    {
+        initials[i] = rand() * 2654435761u;
+        addFrame(capture, i, initials[i], TcpHeader::SYN, 0, 0);
+    }
+
+    for (unsigned int position = 0; position < CONNECTION_BYTES;
+         position += SEGMENT_SIZE)
+    {
+        unsigned int size = std::min(SEGMENT_SIZE, CONNECTION_BYTES - position);
+        for (unsigned int i = 0; i < CONNECTIONS; ++i)
+        {
+            std::uint32_t sequence = initials[i] + 1 + position;
+
+            // Swapping a segment with the one after it from the same
+            // connection means holding it back a connection's round
+            if (disorder && rand() % 50 == 0 &&
+                position + SEGMENT_SIZE < CONNECTION_BYTES)
+            {
+                unsigned int next_size =
+                    std::min(SEGMENT_SIZE,
+                             CONNECTION_BYTES - position - SEGMENT_SIZE);
+                addFrame(capture, i, sequence + SEGMENT_SIZE, TcpHeader::ACK,
+                         &data[position + SEGMENT_SIZE], next_size);
+                addFrame(capture, i, sequence, TcpHeader::ACK,
+                         &data[position], size);
+
+                // The swapped segment comes round again as a retransmit
+                continue;
+            }
+
+            addFrame(capture, i, sequence, TcpHeader::ACK, &data[position],
+                     size);
+
+            if (disorder && rand() % 100 == 0)
+            {
+                addFrame(capture, i, sequence, TcpHeader::ACK,
+                         &data[position], size);
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < CONNECTIONS; ++i)
+    {
+        addFrame(capture, i, initials[i] + 1 + CONNECTION_BYTES,
+                 TcpHeader::FIN | TcpHeader::ACK, 0, 0);
+    }
+}
+
+//==============================================================================
+// Reads a whole pcap file of Ethernet frames into 'capture'; returns false if
+// it can't be read or isn't one
+//==============================================================================
+static bool loadCapture(Capture& capture, const std::string& path)
+{
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::vector<std::uint8_t> contents((std::istreambuf_iterator<char>(file)),
+                                       std::istreambuf_iterator<char>());
+    if (!file.good() && !file.eof())
+    {
+        return false;
+    }
+
+    if (contents.size() < 24)
+    {
+        return false;
+    }
+
+    // The magic number says which byte order the file was written in and
+    // whether timestamps are in micro- or nanoseconds
+    std::uint32_t magic;
+    memcpy(&magic, &contents[0], sizeof(magic));
+
+    bool   swapped;
+    double fraction;
+    switch (magic)
+    {
+    case 0xa1b2c3d4: swapped = false; fraction = 1.0e-6; break;
+    case 0xd4c3b2a1: swapped = true;  fraction = 1.0e-6; break;
+    case 0xa1b23c4d: swapped = false; fraction = 1.0e-9; break;
+    case 0x4d3cb2a1: swapped = true;  fraction = 1.0e-9; break;
+    default: return false;
+    }
+
+    std::uint32_t fields[4];
+    for (std::size_t offset = 24; offset + 16 <= contents.size();)
+    {
+        memcpy(fields, &contents[offset], sizeof(fields));
+        for (unsigned int i = 0; i < 4 && swapped; ++i)
+        {
+            misc::byteswap(fields[i]);
+        }
+
+        offset += 16;
+        if (fields[2] > contents.size() - offset)
+        {
+            break;
+        }
+
+        capture.offsets.push_back(offset);
+        capture.sizes.push_back(fields[2]);
+        capture.times.push_back(fields[0] + fields[1] * fraction);
+        offset += fields[2];
+    }
+
+    std::uint32_t link_type;
+    memcpy(&link_type, &contents[20], sizeof(link_type));
+    if (swapped)
+    {
+        misc::byteswap(link_type);
+    }
+
+    if (link_type != 1)
+    {
+        std::cerr << path << " doesn't hold Ethernet frames\n";
+        return false;
+    }
+
+    capture.bytes.swap(contents);
+    return true;
+}
+
+//==============================================================================
+// Feeds a capture through fresh reassemblers and reports the best pass
+//==============================================================================
+static void run(const std::string& name, const Capture& capture)
+{
+    double best = 0.0;
+    std::uint64_t bytes = 0;
+    unsigned long streams = 0;
+    std::uint64_t gaps = 0;
+    std::uint64_t duplicates = 0;
+    unsigned long rejected = 0;
+
+    for (unsigned int pass = 0; pass < PASSES; ++pass)
+    {
+        CountingHandler handler;
+        TcpReassembler  reassembler(&handler);
+
+        double start = PosixSocketCommon::getMonotonicSeconds();
+        for (std::size_t i = 0; i < capture.offsets.size(); ++i)
+        {
+            reassembler.addFrame(&capture.bytes[capture.offsets[i]],
+                                 capture.sizes[i],
+                                 capture.times[i]);
+        }
+        reassembler.flush();
+        double elapsed = PosixSocketCommon::getMonotonicSeconds() - start;
+
+        if (pass == 0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+
+        bytes      = handler.bytes;
+        streams    = handler.streams;
+        gaps       = reassembler.getGapBytes();
+        duplicates = reassembler.getDuplicateBytes();
+        rejected   = reassembler.getRejectedCount();
+    }
+
+    std::cout << std::left << std::setw(12) << name << std::right
+              << std::fixed << std::setprecision(2)
+              << std::setw(10) << capture.offsets.size() / best / 1.0e6
+              << std::setw(10) << bytes / best / (1024.0 * 1024.0)
+              << std::setw(10) << streams
+              << std::setw(12) << gaps
+              << std::setw(12) << duplicates
+              << std::setw(10) << rejected << "\n";
+}
+
+//==============================================================================
+// Runs the benchmark
+//==============================================================================
+int main(int argc, char** argv)
+{
+    if (argc > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [pcap file]\n";
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(12) << "capture" << std::right
+              << std::setw(10) << "Mframes/s"
+              << std::setw(10) << "MiB/s"
+              << std::setw(10) << "streams"
+              << std::setw(12) << "gap bytes"
+              << std::setw(12) << "dup bytes"
+              << std::setw(10) << "rejected" << "\n";
+
+    if (argc == 2)
+    {
+        Capture capture;
+        if (!loadCapture(capture, argv[1]))
+        {
+            std::cerr << "Couldn't load " << argv[1] << "\n";
+            return 1;
+        }
+
+        run("file", capture);
+        return 0;
+    }
+
+    Capture in_order;
+    buildCapture(in_order, false);
+    run("in order", in_order);
+
+    Capture disordered;
+    buildCapture(disordered, true);
+    run("disordered", disordered);
+
+    return 0;
+}
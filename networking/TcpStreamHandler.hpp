@@ -0,0 +1,36 @@
+#if !defined TCP_STREAM_HANDLER_HPP
+#define TCP_STREAM_HANDLER_HPP
+
+#include "TcpReassembler.hpp"
+
+// Receives the byte streams put back together by a TcpReassembler.  Every call
+// is made from inside whichever TcpReassembler function was given the segment
+// that caused it, and must not call back into that TcpReassembler.
+class TcpStreamHandler
+{
+public:
+
+    virtual ~TcpStreamHandler() {}
+
+    // Called with the next 'size' bytes of a stream, in order.  'data' may
+    // point straight into the packet given to the reassembler and is only
+    // valid until this returns.
+    virtual void handleData(TcpReassembler::Stream& stream,
+                            const unsigned char*    data,
+                            unsigned int            size) = 0;
+
+    // Called in place of handleData() for 'size' bytes of a stream that were
+    // never seen and that the reassembler has given up waiting for
+    virtual void handleGap(TcpReassembler::Stream& /* stream */,
+                           unsigned int            /* size */)
+    {
+    }
+
+    // Called once when a stream ends, after everything it carried has been
+    // passed on.  The stream is forgotten once this returns.
+    virtual void handleClose(TcpReassembler::Stream& /* stream */)
+    {
+    }
+};
+
+#endif
@@ -9,6 +9,8 @@
 
 #include "SocketFactory.hpp"
 
+const unsigned int UDPSocket::SEGMENTS_MAX;
+
 //=============================================================================
 // Creates a platform-specific UDP socket
 //=============================================================================
@@ -73,3 +75,288 @@ void UDPSocket::getPeerAddress(std::string& peer_address_str) const
         socket_impl->getPeerAddress(peer_address_str);
     }
 }
+
+//=============================================================================
+// Calls implementation-specific enableTimestamps
+//=============================================================================
+bool UDPSocket::enableTimestamps()
+{
+    if (socket_impl)
+    {
+        return socket_impl->enableTimestamps();
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific getLastTimestamp
+//=============================================================================
+void UDPSocket::getLastTimestamp(PosixTimespec& timestamp) const
+{
+    if (socket_impl)
+    {
+        socket_impl->getLastTimestamp(timestamp);
+    }
+}
+
+//=============================================================================
+// Calls implementation-specific readBatch
+//=============================================================================
+int UDPSocket::readBatch(unsigned char** buffers,
+                        unsigned int*   sizes,
+                        unsigned int    count,
+                        PosixTimespec*  timestamps,
+                        unsigned int*   segment_sizes)
+{
+    if (socket_impl)
+    {
+        return socket_impl->readBatch(
+            buffers, sizes, count, timestamps, segment_sizes);
+    }
+
+    return -1;
+}
+
+//=============================================================================
+// Calls implementation-specific enableBusyPoll
+//=============================================================================
+bool UDPSocket::enableBusyPoll(double spin_time, int core)
+{
+    if (socket_impl)
+    {
+        return socket_impl->enableBusyPoll(spin_time, core);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific disableBusyPoll
+//=============================================================================
+bool UDPSocket::disableBusyPoll()
+{
+    if (socket_impl)
+    {
+        return socket_impl->disableBusyPoll();
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific writeBatch
+//=============================================================================
+int UDPSocket::writeBatch(const unsigned char* const* buffers,
+                          const unsigned int*         sizes,
+                          unsigned int                count)
+{
+    if (socket_impl)
+    {
+        return socket_impl->writeBatch(buffers, sizes, count);
+    }
+
+    return -1;
+}
+
+//=============================================================================
+// Calls implementation-specific enablePacing
+//=============================================================================
+bool UDPSocket::enablePacing(double rate, Pacing pacing, unsigned int burst)
+{
+    if (socket_impl)
+    {
+        return socket_impl->enablePacing(
+            rate, burst, pacing != USER_PACING, pacing == ETF_PACING);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific disablePacing
+//=============================================================================
+bool UDPSocket::disablePacing()
+{
+    if (socket_impl)
+    {
+        return socket_impl->disablePacing();
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific isKernelPacing
+//=============================================================================
+bool UDPSocket::isKernelPacing() const
+{
+    if (socket_impl)
+    {
+        return socket_impl->isKernelPacing();
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific enableSegmentation
+//=============================================================================
+bool UDPSocket::enableSegmentation(unsigned int segment_size)
+{
+    if (socket_impl)
+    {
+        return socket_impl->enableSegmentation(segment_size);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific disableSegmentation
+//=============================================================================
+bool UDPSocket::disableSegmentation()
+{
+    if (socket_impl)
+    {
+        return socket_impl->disableSegmentation();
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific enableReceiveCoalescing
+//=============================================================================
+bool UDPSocket::enableReceiveCoalescing()
+{
+    if (socket_impl)
+    {
+        return socket_impl->enableReceiveCoalescing();
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific getLastSegmentSize
+//=============================================================================
+unsigned int UDPSocket::getLastSegmentSize() const
+{
+    if (socket_impl)
+    {
+        return socket_impl->getLastSegmentSize();
+    }
+
+    return 0;
+}
+
+//=============================================================================
+// Calls implementation-specific enableAddressReuse
+//=============================================================================
+bool UDPSocket::enableAddressReuse()
+{
+    if (socket_impl)
+    {
+        return socket_impl->enableAddressReuse();
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific joinGroup
+//=============================================================================
+bool UDPSocket::joinGroup(const std::string& group,
+                          const std::string& interface_name)
+{
+    if (socket_impl)
+    {
+        return socket_impl->joinGroup(group, interface_name);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific leaveGroup
+//=============================================================================
+bool UDPSocket::leaveGroup(const std::string& group,
+                           const std::string& interface_name)
+{
+    if (socket_impl)
+    {
+        return socket_impl->leaveGroup(group, interface_name);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific joinSourceGroup
+//=============================================================================
+bool UDPSocket::joinSourceGroup(const std::string& group,
+                                const std::string& source,
+                                const std::string& interface_name)
+{
+    if (socket_impl)
+    {
+        return socket_impl->joinSourceGroup(group, source, interface_name);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific leaveSourceGroup
+//=============================================================================
+bool UDPSocket::leaveSourceGroup(const std::string& group,
+                                 const std::string& source,
+                                 const std::string& interface_name)
+{
+    if (socket_impl)
+    {
+        return socket_impl->leaveSourceGroup(group, source, interface_name);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific setMulticastInterface
+//=============================================================================
+bool UDPSocket::setMulticastInterface(const std::string& interface_name)
+{
+    if (socket_impl)
+    {
+        return socket_impl->setMulticastInterface(interface_name);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific setMulticastTtl
+//=============================================================================
+bool UDPSocket::setMulticastTtl(unsigned int ttl)
+{
+    if (socket_impl)
+    {
+        return socket_impl->setMulticastTtl(ttl);
+    }
+
+    return false;
+}
+
+//=============================================================================
+// Calls implementation-specific setMulticastLoopback
+//=============================================================================
+bool UDPSocket::setMulticastLoopback(bool enabled)
+{
+    if (socket_impl)
+    {
+        return socket_impl->setMulticastLoopback(enabled);
+    }
+
+    return false;
+}
@@ -3,6 +3,7 @@
 
 #include "Socket.hpp"
 
+class PosixTimespec;
 class UDPSocketImpl;
 
 class UDPSocket : public Socket
@@ -26,6 +27,170 @@ public:
     // Gets the source IP address of the last received packet
     void getPeerAddress(std::string& peer_address_str) const;
 
+    // Has the kernel timestamp every datagram as it's received, so that
+    // getLastTimestamp() and readBatch() can report when each datagram actually
+    // arrived rather than when it was read.  Returns false if this isn't
+    // supported.
+    bool enableTimestamps();
+
+    // Gets the kernel receive timestamp of the last datagram read.  Left
+    // unmodified if timestamps aren't enabled or supported.
+    void getLastTimestamp(PosixTimespec& timestamp) const;
+
+    // Reads up to 'count' datagrams with as few system calls as possible,
+    // waiting (subject to blocking settings) only for the first.  Datagram i
+    // goes into 'buffers[i]', which has room for 'sizes[i]' bytes; on return
+    // 'sizes[i]' holds the length actually read.  If 'timestamps' is non-zero
+    // 'timestamps[i]' receives the kernel receive timestamp of datagram i.
+    // If 'segment_sizes' is non-zero 'segment_sizes[i]' receives what
+    // getLastSegmentSize() would report for datagram i.  Returns the number of
+    // datagrams read, 0 on timeout, -1 on error.
+    int readBatch(unsigned char** buffers,
+                  unsigned int*   sizes,
+                  unsigned int    count,
+                  PosixTimespec*  timestamps    = 0,
+                  unsigned int*   segment_sizes = 0);
+
+    // Puts the socket in busy-poll receive mode, for when latency matters
+    // more than CPU time.  Blocking reads first spin on non-blocking reads for
+    // up to 'spin_time' seconds, and only if nothing arrives in that time
+    // block as usual, so an idle socket doesn't keep a core busy; the spin
+    // comes on top of any blocking timeout.  Non-blocking sockets read as
+    // before.  Where it's allowed the kernel also polls the device for data
+    // during reads rather than waiting on an interrupt (SO_BUSY_POLL and
+    // SO_PREFER_BUSY_POLL, which may need CAP_NET_ADMIN).  Receive timestamps
+    // are turned on so the statistics report delivery latency, the time from
+    // a datagram arriving to a read handing it over.  If 'core' isn't negative
+    // the calling thread, which should be the one reading, is pinned to that
+    // core.  Returns false if 'spin_time' isn't positive, the thread couldn't
+    // be pinned or busy polling isn't supported.
+    bool enableBusyPoll(double spin_time, int core = -1);
+
+    // Goes back to blocking straight away on reads.  The reading thread stays
+    // pinned.
+    bool disableBusyPoll();
+
+    // Writes up to 'count' datagrams to the sendTo() destination with as few
+    // system calls as possible, datagram i being 'buffers[i]' and 'sizes[i]'
+    // bytes long.  Returns the number of datagrams written, which may be fewer
+    // than 'count' if the send queue fills, 0 if the blocking timeout expired
+    // before any were written, or -1 on error.
+    int writeBatch(const unsigned char* const* buffers,
+                   const unsigned int*         sizes,
+                   unsigned int                count);
+
+    // What holds paced datagrams back until they're due
+    enum Pacing
+    {
+        // This socket: write() and writeBatch() wait until each datagram is
+        // due before sending it, sleeping most of the way and spinning the
+        // rest.  A non-blocking socket doesn't wait; writes that aren't due
+        // yet return 0 as if the send queue were full.
+        USER_PACING,
+
+        // The fq qdisc on the outgoing interface, which holds each datagram
+        // back until the transmit time it carries (SO_TXTIME on
+        // CLOCK_MONOTONIC), so writes return straight away
+        FQ_PACING,
+
+        // The etf qdisc, likewise but on CLOCK_TAI.  Needs CAP_NET_ADMIN.
+        ETF_PACING
+    };
+
+    // Spreads datagrams written from now on evenly over time, at 'rate'
+    // bytes per second, so a burst of writes doesn't overrun a slower
+    // receiver.  Up to 'burst' bytes may go out back to back after a quiet
+    // spell; 0 keeps every datagram to its slot.  A write that segmentation
+    // splits up is paced as a whole.  If the kernel can't attach transmit
+    // times for FQ_PACING or ETF_PACING, this socket paces writes itself as
+    // with USER_PACING; see isKernelPacing().  With kernel pacing the qdisc
+    // must really be fq or etf, or datagrams go straight out unpaced.  Waiting
+    // for a datagram's time doesn't count against the blocking timeout.  The
+    // statistics report how late datagrams actually went out; with kernel
+    // pacing they're brought up to date by later writes and disablePacing().
+    // Returns false if 'rate' isn't positive or pacing isn't supported.
+    bool enablePacing(double       rate,
+                      Pacing       pacing = USER_PACING,
+                      unsigned int burst  = 0);
+
+    // Goes back to sending datagrams as soon as they're written.  The kernel
+    // can't be told to stop looking for transmit times, so after kernel
+    // pacing etf drops anything this socket writes.
+    bool disablePacing();
+
+    // Returns true if the qdisc rather than this socket is pacing writes
+    bool isKernelPacing() const;
+
+    // Has the kernel split every write into datagrams of 'segment_size' bytes
+    // (UDP generic segmentation offload), so one write of up to
+    // SEGMENTS_MAX * 'segment_size' bytes sends many datagrams.  Every
+    // datagram but the last is exactly 'segment_size' bytes.  Writes no larger
+    // than 'segment_size' go out as a single datagram as usual.  A single
+    // write still can't exceed the 64 KiB limit on UDP datagrams.  Returns
+    // false if this isn't supported.
+    bool enableSegmentation(unsigned int segment_size);
+
+    // Goes back to sending every write as a single datagram
+    bool disableSegmentation();
+
+    // Lets the kernel hand over several datagrams from the same source at once
+    // (UDP generic receive offload), back to back in one read.  Every
+    // datagram but the last in such a read is getLastSegmentSize() bytes long,
+    // so the read can be split back up.  Read buffers need to be large enough
+    // to hold coalesced datagrams (64 KiB covers any).  Returns false if this
+    // isn't supported.
+    bool enableReceiveCoalescing();
+
+    // Gets the size of the datagrams the last read was made of.  For a
+    // coalesced read this is the size of every datagram in it but the last;
+    // otherwise it's the size of the whole read.
+    unsigned int getLastSegmentSize() const;
+
+    // Most datagrams one write can be split into when segmentation is enabled
+    static const unsigned int SEGMENTS_MAX = 64;
+
+    // Lets other sockets bind the same port as this one, so that several
+    // sockets on this host can all receive a multicast group's traffic.  Must
+    // be called before bind(), and by every socket sharing the port.
+    bool enableAddressReuse();
+
+    // Starts receiving datagrams sent to the given multicast group (a dotted
+    // IPv4 address) on the given interface (by name, like "eth0").  An empty
+    // interface name lets the kernel choose.  The socket must also be bound to
+    // the port the group's traffic is sent to.
+    bool joinGroup(const std::string& group,
+                   const std::string& interface_name = "");
+
+    // Stops receiving datagrams sent to the given multicast group on the given
+    // interface
+    bool leaveGroup(const std::string& group,
+                    const std::string& interface_name = "");
+
+    // Like joinGroup, but only datagrams sent to the group by the given source
+    // (a dotted IPv4 address) are received.  Can be called once per source to
+    // receive from several.
+    bool joinSourceGroup(const std::string& group,
+                         const std::string& source,
+                         const std::string& interface_name = "");
+
+    // Stops receiving datagrams sent to the given multicast group by the given
+    // source
+    bool leaveSourceGroup(const std::string& group,
+                          const std::string& source,
+                          const std::string& interface_name = "");
+
+    // Sets the interface multicast datagrams are sent from.  An empty
+    // interface name goes back to letting the kernel choose.
+    bool setMulticastInterface(const std::string& interface_name);
+
+    // Sets how many routers multicast datagrams sent from this socket may
+    // cross; 0 keeps them on this host, 1 (the default) on the local network
+    bool setMulticastTtl(unsigned int ttl);
+
+    // Sets whether multicast datagrams sent from this socket are also
+    // delivered to group members on this host (the default)
+    bool setMulticastLoopback(bool enabled);
+
 protected:
 
     // Sets the platform-specific socket implementation to use
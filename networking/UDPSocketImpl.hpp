@@ -3,6 +3,8 @@
 
 #include "SocketImpl.hpp"
 
+class PosixTimespec;
+
 class UDPSocketImpl : public SocketImpl
 {
 public:
@@ -24,6 +26,106 @@ public:
     // Gets the source IP address of the last received packet
     virtual void getPeerAddress(std::string& peer_address_str) const = 0;
 
+    // Has the kernel timestamp every datagram as it's received.  Returns false
+    // if this isn't supported.
+    virtual bool enableTimestamps() = 0;
+
+    // Gets the kernel receive timestamp of the last datagram read.  Left
+    // unmodified if timestamps aren't enabled or supported.
+    virtual void getLastTimestamp(PosixTimespec& timestamp) const = 0;
+
+    // Reads up to 'count' datagrams, waiting only for the first.  Datagram i
+    // goes into 'buffers[i]', which has room for 'sizes[i]' bytes; on return
+    // 'sizes[i]' holds the length actually read.  If 'timestamps' is non-zero
+    // 'timestamps[i]' receives the kernel receive timestamp of datagram i.
+    // If 'segment_sizes' is non-zero 'segment_sizes[i]' receives the segment
+    // size of datagram i.  Returns the number of datagrams read, 0 on timeout,
+    // -1 on error.
+    virtual int readBatch(unsigned char** buffers,
+                          unsigned int*   sizes,
+                          unsigned int    count,
+                          PosixTimespec*  timestamps,
+                          unsigned int*   segment_sizes) = 0;
+
+    // Spins on non-blocking reads for up to 'spin_time' seconds before
+    // blocking, with the kernel busy polling where it's allowed to, and pins
+    // the calling thread to 'core' unless it's negative
+    virtual bool enableBusyPoll(double spin_time, int core) = 0;
+
+    // Goes back to blocking straight away on reads
+    virtual bool disableBusyPoll() = 0;
+
+    // Writes up to 'count' datagrams with as few system calls as possible,
+    // datagram i being 'buffers[i]' and 'sizes[i]' bytes long.  Returns the
+    // number of datagrams written, 0 on timeout, -1 on error.
+    virtual int writeBatch(const unsigned char* const* buffers,
+                           const unsigned int*         sizes,
+                           unsigned int                count) = 0;
+
+    // Spreads writes out to 'rate' bytes per second, up to 'burst' bytes at a
+    // time.  If 'kernel_pacing' is set the qdisc holds datagrams back until
+    // transmit times on CLOCK_TAI ('tai') or CLOCK_MONOTONIC, where the
+    // kernel allows it; otherwise writes wait until datagrams are due.
+    virtual bool enablePacing(double       rate,
+                              unsigned int burst,
+                              bool         kernel_pacing,
+                              bool         tai) = 0;
+
+    // Goes back to sending datagrams as soon as they're written
+    virtual bool disablePacing() = 0;
+
+    // Returns true if the qdisc is pacing writes
+    virtual bool isKernelPacing() const = 0;
+
+    // Has the kernel split every write into datagrams of 'segment_size' bytes
+    virtual bool enableSegmentation(unsigned int segment_size) = 0;
+
+    // Goes back to sending every write as a single datagram
+    virtual bool disableSegmentation() = 0;
+
+    // Lets the kernel hand over several received datagrams from the same
+    // source at once
+    virtual bool enableReceiveCoalescing() = 0;
+
+    // Gets the size of the datagrams the last read was made of
+    virtual unsigned int getLastSegmentSize() const = 0;
+
+    // Lets other sockets bind the same port as this one.  Must be called
+    // before bind().
+    virtual bool enableAddressReuse() = 0;
+
+    // Starts receiving datagrams sent to the given multicast group on the given
+    // interface; an empty interface name lets the kernel choose
+    virtual bool joinGroup(const std::string& group,
+                           const std::string& interface_name) = 0;
+
+    // Stops receiving datagrams sent to the given multicast group on the given
+    // interface
+    virtual bool leaveGroup(const std::string& group,
+                            const std::string& interface_name) = 0;
+
+    // Starts receiving datagrams sent to the given multicast group by the given
+    // source only
+    virtual bool joinSourceGroup(const std::string& group,
+                                 const std::string& source,
+                                 const std::string& interface_name) = 0;
+
+    // Stops receiving datagrams sent to the given multicast group by the given
+    // source
+    virtual bool leaveSourceGroup(const std::string& group,
+                                  const std::string& source,
+                                  const std::string& interface_name) = 0;
+
+    // Sets the interface multicast datagrams are sent from; an empty interface
+    // name lets the kernel choose
+    virtual bool setMulticastInterface(const std::string& interface_name) = 0;
+
+    // Sets the time-to-live of outgoing multicast datagrams
+    virtual bool setMulticastTtl(unsigned int ttl) = 0;
+
+    // Sets whether outgoing multicast datagrams are looped back to this host
+    virtual bool setMulticastLoopback(bool enabled) = 0;
+
 private:
 
     // Disallow these for now; maybe these could be meaningfully implemented but
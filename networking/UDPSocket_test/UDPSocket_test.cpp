@@ -1,19 +1,47 @@
 #include <iostream>
+#include <chrono>
 #include <string.h>
+#include <thread>
+#include <time.h>
+#include <vector>
 
 #include "UDPSocket_test.hpp"
 
+#include "OnlineStatistics.hpp"
+#include "PosixTimespec.hpp"
+#include "SocketKernelStatistics.hpp"
+#include "SocketStatistics.hpp"
 #include "UDPSocket.hpp"
+#include "miscNetworking.hpp"
 #include "Test.hpp"
 #include "TestCases.hpp"
 #include "TestMacros.hpp"
 
 TEST_PROGRAM_MAIN(UDPSocket_test);
 
+// Multicast tests all run over the loopback interface
+#if defined MACOS
+static const std::string LOOPBACK_INTERFACE = "lo0";
+#else
+static const std::string LOOPBACK_INTERFACE = "lo";
+#endif
+
+// An administratively-scoped group, so nothing here leaves this host anyway
+static const std::string MULTICAST_GROUP = "239.255.42.99";
+
 //==============================================================================
 void UDPSocket_test::addTestCases()
 {
     ADD_TEST_CASE(SendReceive_TwoSockets);
+    ADD_TEST_CASE(Statistics);
+    ADD_TEST_CASE(ReadBatch_Timestamps);
+    ADD_TEST_CASE(BlockingTimeout);
+    ADD_TEST_CASE(Multicast);
+    ADD_TEST_CASE(Multicast_SourceSpecific);
+    ADD_TEST_CASE(Segmentation);
+    ADD_TEST_CASE(ReceiveCoalescing);
+    ADD_TEST_CASE(BusyPoll);
+    ADD_TEST_CASE(Pacing);
 }
 
 //==============================================================================
@@ -64,3 +92,638 @@ Test::Result UDPSocket_test::SendReceive_TwoSockets::body()
 
     return Test::PASSED;
 }
+
+//==============================================================================
+Test::Result UDPSocket_test::Statistics::body()
+{
+    unsigned int port1 = 0;  // Use whatever port is available
+    unsigned int port2 = 0;  // Use whatever port is available
+
+    unsigned char send[] = {'o', 'n', 'e', '\0'};
+    unsigned char recv[] = {'\0', '\0', '\0', '\0'};
+    unsigned int send_size = 4;  // Must equal the length of both arrays
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+
+    MUST_BE_TRUE(socket1.bind(port1));
+    MUST_BE_TRUE(socket2.bind(port2));
+    MUST_BE_TRUE(socket1.sendTo("localhost", port2));
+
+    // Send two datagrams and leave them sitting in the receive queue so the
+    // kernel has something to report
+    MUST_BE_TRUE(socket1.write(send, send_size) ==
+                 static_cast<int>(send_size));
+    MUST_BE_TRUE(socket1.write(send, send_size) ==
+                 static_cast<int>(send_size));
+
+    SocketKernelStatistics kernel_statistics;
+    MUST_BE_TRUE(socket2.getKernelStatistics(kernel_statistics));
+    MUST_BE_TRUE(kernel_statistics.getReceiveQueueBytes() > 0);
+    MUST_BE_TRUE(kernel_statistics.getReceiveDrops() == 0);
+
+    // Read both, then try for a third that isn't there
+    socket2.setBlockingTimeout(0.1);
+    MUST_BE_TRUE(socket2.read(recv, send_size) == static_cast<int>(send_size));
+    MUST_BE_TRUE(socket2.read(recv, send_size) == static_cast<int>(send_size));
+    MUST_BE_TRUE(socket2.read(recv, send_size) == 0);
+
+    SocketStatistics statistics;
+
+    socket1.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getBytesSent() == 2 * send_size);
+    MUST_BE_TRUE(statistics.getDatagramsSent() == 2);
+    MUST_BE_TRUE(statistics.getBytesReceived() == 0);
+    MUST_BE_TRUE(statistics.getSyscalls() == 2);
+
+    socket2.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getBytesReceived() == 2 * send_size);
+    MUST_BE_TRUE(statistics.getDatagramsReceived() == 2);
+    MUST_BE_TRUE(statistics.getTimeouts() == 1);
+    MUST_BE_TRUE(statistics.getPollLatencyCount() == 2);
+    MUST_BE_TRUE(statistics.getErrors() == 0);
+
+    // A non-blocking read with nothing available should count as a
+    // would-block rather than an error
+    socket2.disableBlocking();
+    MUST_BE_TRUE(socket2.read(recv, send_size) == -1);
+    socket2.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getWouldBlocks() == 1);
+
+    socket2.resetStatistics();
+    socket2.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getBytesReceived() == 0);
+    MUST_BE_TRUE(statistics.getSyscalls() == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UDPSocket_test::ReadBatch_Timestamps::body()
+{
+    unsigned int port1 = 0;  // Use whatever port is available
+    unsigned int port2 = 0;  // Use whatever port is available
+
+    const unsigned int count = 16;
+    unsigned char send[] = {'o', 'n', 'e', '\0'};
+    unsigned char recv[count][4];
+    unsigned int send_size = 4;  // Must equal the length of both arrays
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+
+    MUST_BE_TRUE(socket1.bind(port1));
+    MUST_BE_TRUE(socket2.bind(port2));
+    MUST_BE_TRUE(socket1.sendTo("localhost", port2));
+    MUST_BE_TRUE(socket2.enableTimestamps());
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        MUST_BE_TRUE(socket1.write(send, send_size) ==
+                     static_cast<int>(send_size));
+    }
+
+    unsigned char* buffers[count];
+    unsigned int   sizes[count];
+    PosixTimespec  timestamps[count];
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        buffers[i] = recv[i];
+        sizes[i]   = send_size;
+    }
+
+    // Everything's already queued up, so one call should get it all
+    socket2.setBlockingTimeout(1.0);
+    MUST_BE_TRUE(socket2.readBatch(buffers, sizes, count, timestamps) ==
+                 static_cast<int>(count));
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        MUST_BE_TRUE(sizes[i] == send_size);
+        MUST_BE_TRUE(memcmp(send, recv[i], send_size) == 0);
+        MUST_BE_TRUE(timestamps[i] > PosixTimespec());
+    }
+
+    // Timestamps come out in arrival order, and the last one is remembered
+    for (unsigned int i = 1; i < count; ++i)
+    {
+        MUST_BE_TRUE(timestamps[i] >= timestamps[i - 1]);
+    }
+
+    PosixTimespec last_timestamp;
+    socket2.getLastTimestamp(last_timestamp);
+    MUST_BE_TRUE(last_timestamp == timestamps[count - 1]);
+
+    OnlineStatistics latency;
+    miscNetworking::updateReceiveLatency(timestamps, count, latency);
+    MUST_BE_TRUE(latency.getSampleCount() == count);
+    MUST_BE_TRUE(latency.getMinimumSample() >= 0.0);
+
+    // The whole batch should have come in with one receive call, plus
+    // whatever the blocking timeout costs
+    SocketStatistics statistics;
+    socket2.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getDatagramsReceived() == count);
+    MUST_BE_TRUE(statistics.getSyscalls() < count);
+
+    // Nothing left
+    MUST_BE_TRUE(socket2.readBatch(buffers, sizes, count) == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UDPSocket_test::BlockingTimeout::body()
+{
+    unsigned int port = 0;  // Use whatever port is available
+
+    unsigned char recv[] = {'\0', '\0', '\0', '\0'};
+    unsigned int recv_size = 4;  // Must equal the length of the array
+
+    const double timeout = 0.1;
+
+    UDPSocket socket;
+    MUST_BE_TRUE(socket.bind(port));
+    MUST_BE_TRUE(socket.isBlockingEnabled());
+
+    socket.setBlockingTimeout(timeout);
+    MUST_BE_TRUE(socket.getBlockingTimeout() == timeout);
+
+    timespec start_ts;
+    clock_gettime(CLOCK_MONOTONIC, &start_ts);
+
+    // Nothing's coming, so this should wait out the timeout in one system
+    // call and then report that nothing was read
+    MUST_BE_TRUE(socket.read(recv, recv_size) == 0);
+
+    timespec end_ts;
+    clock_gettime(CLOCK_MONOTONIC, &end_ts);
+    double elapsed = (end_ts - PosixTimespec(start_ts)).toDouble();
+    std::cout << "Timed out after " << elapsed << " seconds\n";
+    MUST_BE_TRUE(elapsed >= timeout * 0.9);
+
+    SocketStatistics statistics;
+    socket.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getSyscalls() == 1);
+    MUST_BE_TRUE(statistics.getTimeouts() == 1);
+    MUST_BE_TRUE(statistics.getWouldBlocks() == 0);
+
+    // Without blocking the timeout doesn't apply and the read fails at once
+    MUST_BE_TRUE(socket.disableBlocking());
+    MUST_BE_FALSE(socket.isBlockingEnabled());
+    MUST_BE_TRUE(socket.read(recv, recv_size) == -1);
+
+    socket.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getSyscalls() == 2);
+    MUST_BE_TRUE(statistics.getTimeouts() == 1);
+    MUST_BE_TRUE(statistics.getWouldBlocks() == 1);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+// Sets up 'sender' to send multicast to 'port' over the loopback interface
+//==============================================================================
+static bool setUpMulticastSender(UDPSocket& sender, unsigned int port)
+{
+    unsigned int sender_port = 0;
+
+    return sender.bind(sender_port) &&
+           sender.setMulticastInterface(LOOPBACK_INTERFACE) &&
+           sender.setMulticastTtl(0) &&
+           sender.sendTo(MULTICAST_GROUP, port);
+}
+
+//==============================================================================
+Test::Result UDPSocket_test::Multicast::body()
+{
+    unsigned int port = 0;  // Use whatever port is available
+
+    unsigned char send[] = {'o',  'n',  'e',  '\0'};
+    unsigned char recv[] = {'\0', '\0', '\0', '\0'};
+    unsigned int size = 4;  // Must equal the length of both arrays
+
+    // Two subscribers sharing a port, as two processes on one host would
+    UDPSocket receiver1;
+    UDPSocket receiver2;
+    MUST_BE_TRUE(receiver1.enableAddressReuse());
+    MUST_BE_TRUE(receiver2.enableAddressReuse());
+    MUST_BE_TRUE(receiver1.bind(port));
+    MUST_BE_TRUE(receiver2.bind(port));
+    MUST_BE_TRUE(receiver1.joinGroup(MULTICAST_GROUP, LOOPBACK_INTERFACE));
+    MUST_BE_TRUE(receiver2.joinGroup(MULTICAST_GROUP, LOOPBACK_INTERFACE));
+    receiver1.setBlockingTimeout(1.0);
+    receiver2.setBlockingTimeout(1.0);
+
+    // Loopback can be turned off, though the loopback interface delivers
+    // locally regardless, so there's no testing the effect of that here
+    UDPSocket sender;
+    MUST_BE_TRUE(setUpMulticastSender(sender, port));
+    MUST_BE_TRUE(sender.setMulticastLoopback(false));
+    MUST_BE_TRUE(sender.setMulticastLoopback(true));
+
+    // One send reaches both
+    MUST_BE_TRUE(sender.write(send, size) == static_cast<int>(size));
+
+    MUST_BE_TRUE(receiver1.read(recv, size) == static_cast<int>(size));
+    MUST_BE_TRUE(memcmp(send, recv, size) == 0);
+
+    memset(recv, 0, size);
+    MUST_BE_TRUE(receiver2.read(recv, size) == static_cast<int>(size));
+    MUST_BE_TRUE(memcmp(send, recv, size) == 0);
+
+    // Once one leaves only the other hears the next send
+    MUST_BE_TRUE(receiver1.leaveGroup(MULTICAST_GROUP, LOOPBACK_INTERFACE));
+    MUST_BE_TRUE(sender.write(send, size) == static_cast<int>(size));
+
+    MUST_BE_TRUE(receiver2.read(recv, size) == static_cast<int>(size));
+
+    MUST_BE_TRUE(receiver1.disableBlocking());
+    MUST_BE_TRUE(receiver1.read(recv, size) == -1);
+
+    // Leaving twice is an error
+    MUST_BE_FALSE(receiver1.leaveGroup(MULTICAST_GROUP, LOOPBACK_INTERFACE));
+
+    // Only multicast addresses can be joined
+    MUST_BE_FALSE(receiver1.joinGroup("127.0.0.1", LOOPBACK_INTERFACE));
+    MUST_BE_FALSE(receiver1.joinGroup("not an address", LOOPBACK_INTERFACE));
+    MUST_BE_FALSE(receiver1.joinGroup(MULTICAST_GROUP, "no such interface"));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UDPSocket_test::Multicast_SourceSpecific::body()
+{
+    unsigned int port = 0;  // Use whatever port is available
+
+    unsigned char send[] = {'o',  'n',  'e',  '\0'};
+    unsigned char recv[] = {'\0', '\0', '\0', '\0'};
+    unsigned int size = 4;  // Must equal the length of both arrays
+
+    UDPSocket wanted;
+    UDPSocket unwanted;
+    MUST_BE_TRUE(wanted.enableAddressReuse());
+    MUST_BE_TRUE(unwanted.enableAddressReuse());
+    MUST_BE_TRUE(wanted.bind(port));
+    MUST_BE_TRUE(unwanted.bind(port));
+    wanted.setBlockingTimeout(1.0);
+    unwanted.setBlockingTimeout(0.1);
+
+    UDPSocket sender;
+    MUST_BE_TRUE(setUpMulticastSender(sender, port));
+
+    // The kernel picks the sender's source address, so find out what it is
+    // with an any-source join first
+    MUST_BE_TRUE(wanted.joinGroup(MULTICAST_GROUP, LOOPBACK_INTERFACE));
+    MUST_BE_TRUE(sender.write(send, size) == static_cast<int>(size));
+    MUST_BE_TRUE(wanted.read(recv, size) == static_cast<int>(size));
+    MUST_BE_TRUE(wanted.leaveGroup(MULTICAST_GROUP, LOOPBACK_INTERFACE));
+
+    std::string source;
+    wanted.getPeerAddress(source);
+    std::string other_source =
+        source == "127.0.0.2" ? "127.0.0.3" : "127.0.0.2";
+
+    // Now one socket should hear the sender and the other shouldn't
+    MUST_BE_TRUE(wanted.joinSourceGroup(
+                     MULTICAST_GROUP, source, LOOPBACK_INTERFACE));
+    MUST_BE_TRUE(unwanted.joinSourceGroup(
+                     MULTICAST_GROUP, other_source, LOOPBACK_INTERFACE));
+
+    memset(recv, 0, size);
+    MUST_BE_TRUE(sender.write(send, size) == static_cast<int>(size));
+
+    MUST_BE_TRUE(wanted.read(recv, size) == static_cast<int>(size));
+    MUST_BE_TRUE(memcmp(send, recv, size) == 0);
+
+    MUST_BE_TRUE(unwanted.read(recv, size) == 0);
+
+    MUST_BE_TRUE(wanted.leaveSourceGroup(
+                     MULTICAST_GROUP, source, LOOPBACK_INTERFACE));
+    MUST_BE_FALSE(wanted.leaveSourceGroup(
+                      MULTICAST_GROUP, source, LOOPBACK_INTERFACE));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+// Fills 'buffer' so every 'segment_size' bytes holds a different value
+//==============================================================================
+static void fillSegments(std::vector<unsigned char>& buffer,
+                         unsigned int                segment_size)
+{
+    for (unsigned int i = 0; i < buffer.size(); ++i)
+    {
+        buffer[i] = i / segment_size;
+    }
+}
+
+//==============================================================================
+Test::Result UDPSocket_test::Segmentation::body()
+{
+    unsigned int port1 = 0;  // Use whatever port is available
+    unsigned int port2 = 0;  // Use whatever port is available
+
+    // Nine whole segments and a short one at the end
+    const unsigned int segment_size = 100;
+    const unsigned int segments     = 10;
+    std::vector<unsigned char> send(segment_size * segments - 50);
+    fillSegments(send, segment_size);
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+    MUST_BE_TRUE(socket1.bind(port1));
+    MUST_BE_TRUE(socket2.bind(port2));
+    MUST_BE_TRUE(socket1.sendTo("localhost", port2));
+    socket2.setBlockingTimeout(1.0);
+
+    SKIP_IF_FALSE(socket1.enableSegmentation(segment_size));
+    socket1.resetStatistics();
+
+    MUST_BE_TRUE(socket1.write(&send[0], send.size()) ==
+                 static_cast<int>(send.size()));
+
+    SocketStatistics statistics;
+    socket1.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getSyscalls() == 1);
+
+    // Without coalescing the receiver sees ordinary datagrams
+    std::vector<unsigned char> recv(segment_size * segments * 2);
+    unsigned char* buffers[segments * 2];
+    unsigned int   sizes[segments * 2];
+    unsigned int   segment_sizes[segments * 2];
+    for (unsigned int i = 0; i < segments * 2; ++i)
+    {
+        buffers[i] = &recv[i * segment_size];
+        sizes[i]   = segment_size;
+    }
+
+    unsigned int received = 0;
+    while (received < segments)
+    {
+        int ret = socket2.readBatch(buffers + received,
+                                    sizes + received,
+                                    segments * 2 - received,
+                                    0,
+                                    segment_sizes + received);
+        MUST_BE_TRUE(ret > 0);
+        received += ret;
+    }
+
+    MUST_BE_TRUE(received == segments);
+
+    for (unsigned int i = 0; i < segments; ++i)
+    {
+        unsigned int expected = i < segments - 1 ? segment_size : 50;
+        MUST_BE_TRUE(sizes[i] == expected);
+        MUST_BE_TRUE(segment_sizes[i] == expected);
+        MUST_BE_TRUE(
+            memcmp(buffers[i], &send[i * segment_size], expected) == 0);
+    }
+
+    MUST_BE_TRUE(socket2.getLastSegmentSize() == 50);
+
+    // Writes no bigger than a segment aren't affected
+    MUST_BE_TRUE(socket1.write(&send[0], segment_size) ==
+                 static_cast<int>(segment_size));
+    MUST_BE_TRUE(socket2.read(&recv[0], recv.size()) ==
+                 static_cast<int>(segment_size));
+
+    // And with segmentation off a big write is one big datagram again
+    MUST_BE_TRUE(socket1.disableSegmentation());
+    MUST_BE_TRUE(socket1.write(&send[0], send.size()) ==
+                 static_cast<int>(send.size()));
+    MUST_BE_TRUE(socket2.read(&recv[0], recv.size()) ==
+                 static_cast<int>(send.size()));
+    MUST_BE_TRUE(socket2.getLastSegmentSize() == send.size());
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UDPSocket_test::ReceiveCoalescing::body()
+{
+    unsigned int port1 = 0;  // Use whatever port is available
+    unsigned int port2 = 0;  // Use whatever port is available
+
+    const unsigned int segment_size = 100;
+    const unsigned int segments     = 10;
+    std::vector<unsigned char> send(segment_size * segments - 50);
+    fillSegments(send, segment_size);
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+    MUST_BE_TRUE(socket1.bind(port1));
+    MUST_BE_TRUE(socket2.bind(port2));
+    MUST_BE_TRUE(socket1.sendTo("localhost", port2));
+    socket2.setBlockingTimeout(1.0);
+
+    SKIP_IF_FALSE(socket1.enableSegmentation(segment_size));
+    SKIP_IF_FALSE(socket2.enableReceiveCoalescing());
+
+    MUST_BE_TRUE(socket1.write(&send[0], send.size()) ==
+                 static_cast<int>(send.size()));
+
+    // Over loopback the segmented write arrives in one piece, and the segment
+    // size says how to split it back up
+    std::vector<unsigned char> recv(65536);
+    unsigned int received = 0;
+    while (received < send.size())
+    {
+        int ret = socket2.read(&recv[received], recv.size() - received);
+        MUST_BE_TRUE(ret > 0);
+
+        unsigned int segment = socket2.getLastSegmentSize();
+        std::cout << "Read " << ret << " bytes in segments of " << segment
+                  << "\n";
+        MUST_BE_TRUE(segment == segment_size ||
+                     (segment == static_cast<unsigned int>(ret) &&
+                      segment <= segment_size));
+
+        received += ret;
+    }
+
+    MUST_BE_TRUE(received == send.size());
+    MUST_BE_TRUE(memcmp(&recv[0], &send[0], send.size()) == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UDPSocket_test::BusyPoll::body()
+{
+    unsigned int port1 = 0;  // Use whatever port is available
+    unsigned int port2 = 0;  // Use whatever port is available
+
+    unsigned char send[] = {'o', 'n', 'e', '\0'};
+    unsigned char recv[] = {'\0', '\0', '\0', '\0'};
+    unsigned int send_size = 4;  // Must equal the length of both arrays
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+
+    MUST_BE_TRUE(socket1.bind(port1));
+    MUST_BE_TRUE(socket2.bind(port2));
+    MUST_BE_TRUE(socket1.sendTo("localhost", port2));
+
+    MUST_BE_FALSE(socket2.enableBusyPoll(0.0));
+    MUST_BE_TRUE(socket2.enableBusyPoll(0.5, 0));
+    socket2.setBlockingTimeout(0.01);
+
+    // Sent while the read is spinning, well before the spin runs out
+    std::thread sender([&socket1, &send, send_size]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        socket1.write(send, send_size);
+    });
+    MUST_BE_TRUE(socket2.read(recv, send_size) == static_cast<int>(send_size));
+    sender.join();
+
+    // Batched reads spin the same way
+    MUST_BE_TRUE(socket1.write(send, send_size) ==
+                 static_cast<int>(send_size));
+    MUST_BE_TRUE(socket1.write(send, send_size) ==
+                 static_cast<int>(send_size));
+
+    unsigned char  recv_batch[2][4];
+    unsigned char* buffers[]    = {recv_batch[0], recv_batch[1]};
+    unsigned int   sizes[]      = {send_size, send_size};
+    PosixTimespec  timestamps[2];
+    MUST_BE_TRUE(socket2.readBatch(buffers, sizes, 2, timestamps) == 2);
+
+    // Nothing comes, so the spin gives up and the blocking read times out
+    MUST_BE_TRUE(socket2.enableBusyPoll(0.01));
+    MUST_BE_TRUE(socket2.read(recv, send_size) == 0);
+
+    SocketStatistics statistics;
+    socket2.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getSpinHits() == 2);
+    MUST_BE_TRUE(statistics.getSpinFallbacks() == 1);
+    MUST_BE_TRUE(statistics.getTimeouts() == 1);
+
+    // Checks made while spinning aren't counted as reads that would block
+    MUST_BE_TRUE(statistics.getSpinProbes() > 0);
+    MUST_BE_TRUE(statistics.getWouldBlocks() == 0);
+    MUST_BE_TRUE(statistics.getSyscalls() == 3);
+    MUST_BE_TRUE(statistics.getDeliveryLatencyCount() == 3);
+    MUST_BE_TRUE(statistics.getDeliveryLatencyMaximum() > 0.0);
+    MUST_BE_TRUE(statistics.getDeliveryLatencyMaximum() < 1.0);
+
+    std::cout << "Mean delivery latency "
+              << statistics.getDeliveryLatencyMean() * 1.0e6 << " us\n";
+
+    // With busy polling off reads block straight away
+    MUST_BE_TRUE(socket2.disableBusyPoll());
+    MUST_BE_TRUE(socket2.read(recv, send_size) == 0);
+    socket2.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getSpinFallbacks() == 1);
+    MUST_BE_TRUE(statistics.getTimeouts() == 2);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UDPSocket_test::Pacing::body()
+{
+    unsigned int port1 = 0;  // Use whatever port is available
+    unsigned int port2 = 0;  // Use whatever port is available
+
+    UDPSocket socket1;
+    UDPSocket socket2;
+
+    MUST_BE_TRUE(socket1.bind(port1));
+    MUST_BE_TRUE(socket2.bind(port2));
+    MUST_BE_TRUE(socket1.sendTo("localhost", port2));
+    socket2.setBlockingTimeout(1.0);
+
+    // At 100 kB/s each of these takes 10 ms
+    const unsigned int datagram_size = 1000;
+    const unsigned int count         = 16;
+
+    std::vector<unsigned char> send(datagram_size * count, 'p');
+    std::vector<unsigned char> recv(datagram_size);
+
+    std::vector<const unsigned char*> buffers;
+    std::vector<unsigned int>         sizes(count, datagram_size);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        buffers.push_back(&send[i * datagram_size]);
+    }
+
+    MUST_BE_FALSE(socket1.enablePacing(0.0));
+    MUST_BE_TRUE(socket1.enablePacing(100000.0));
+    MUST_BE_FALSE(socket1.isKernelPacing());
+
+    // The first datagram goes straight away and the rest follow at 10 ms
+    // intervals
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    MUST_BE_TRUE(socket1.writeBatch(&buffers[0], &sizes[0], count) ==
+                 static_cast<int>(count));
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start).count();
+    MUST_BE_TRUE(elapsed > 0.145);
+    MUST_BE_TRUE(elapsed < 1.0);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        MUST_BE_TRUE(socket2.read(&recv[0], datagram_size) ==
+                     static_cast<int>(datagram_size));
+    }
+
+    SocketStatistics statistics;
+    socket1.getStatistics(statistics);
+    MUST_BE_TRUE(statistics.getPacedCount() == count);
+    MUST_BE_TRUE(statistics.getPacingLatenessMean() >= 0.0);
+    MUST_BE_TRUE(statistics.getPacingLatenessMaximum() < 0.1);
+
+    std::cout << "Mean pacing lateness "
+              << statistics.getPacingLatenessMean() * 1.0e6 << " us\n";
+
+    // A 5 kB burst lets six datagrams go at once
+    MUST_BE_TRUE(socket1.enablePacing(100000.0, UDPSocket::USER_PACING, 5000));
+    start = std::chrono::steady_clock::now();
+    MUST_BE_TRUE(socket1.writeBatch(&buffers[0], &sizes[0], 6) == 6);
+    elapsed = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start).count();
+    MUST_BE_TRUE(elapsed < 0.01);
+
+    // A non-blocking socket doesn't wait for the next datagram's time
+    MUST_BE_TRUE(socket1.disableBlocking());
+    MUST_BE_TRUE(socket1.write(&send[0], datagram_size) == 0);
+    MUST_BE_TRUE(socket1.enableBlocking());
+
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        MUST_BE_TRUE(socket2.read(&recv[0], datagram_size) ==
+                     static_cast<int>(datagram_size));
+    }
+
+    // Loopback has no fq qdisc, so kernel pacing can be set up but nothing
+    // holds the datagrams back
+    if (socket1.enablePacing(100000.0, UDPSocket::FQ_PACING))
+    {
+        MUST_BE_TRUE(socket1.isKernelPacing());
+        MUST_BE_TRUE(socket1.writeBatch(&buffers[0], &sizes[0], count) ==
+                     static_cast<int>(count));
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            MUST_BE_TRUE(socket2.read(&recv[0], datagram_size) ==
+                         static_cast<int>(datagram_size));
+        }
+    }
+
+    // Unpaced writes go straight out again
+    MUST_BE_TRUE(socket1.disablePacing());
+    MUST_BE_FALSE(socket1.isKernelPacing());
+    start = std::chrono::steady_clock::now();
+    MUST_BE_TRUE(socket1.writeBatch(&buffers[0], &sizes[0], count) ==
+                 static_cast<int>(count));
+    elapsed = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start).count();
+    MUST_BE_TRUE(elapsed < 0.05);
+
+    return Test::PASSED;
+}
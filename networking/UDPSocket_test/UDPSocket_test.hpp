@@ -8,6 +8,15 @@
 TEST_CASES_BEGIN(UDPSocket_test)
 
     TEST(SendReceive_TwoSockets)
+    TEST(Statistics)
+    TEST(ReadBatch_Timestamps)
+    TEST(BlockingTimeout)
+    TEST(Multicast)
+    TEST(Multicast_SourceSpecific)
+    TEST(Segmentation)
+    TEST(ReceiveCoalescing)
+    TEST(BusyPoll)
+    TEST(Pacing)
 
 TEST_CASES_END(UDPSocket_test)
 
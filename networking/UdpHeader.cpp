@@ -0,0 +1,53 @@
+#include <cstdint>
+
+#include "UdpHeader.hpp"
+#include "misc.hpp"
+
+//==============================================================================
+// Initializes everything to 0
+//==============================================================================
+UdpHeader::UdpHeader() :
+    DataPacket(1), // always aligned on 1 byte (no alignment)
+    source_port(0),
+    destination_port(0),
+    length(0),
+    checksum(0)
+{
+    addDataFields();
+}
+
+//==============================================================================
+// Initializes ports, defaults for the rest
+//==============================================================================
+UdpHeader::UdpHeader(std::uint16_t source_port,
+                     std::uint16_t destination_port) :
+    UdpHeader()
+{
+    // cppcheck-suppress useInitializationList
+    this->source_port      = source_port;
+    this->destination_port = destination_port;
+}
+
+//==============================================================================
+// Constructs a UdpHeader by calling readRaw() on the provided buffer.
+// Byteswapping is performed if needed.
+//==============================================================================
+UdpHeader::UdpHeader(const std::uint8_t* buffer) :
+    UdpHeader()
+{
+    readRaw(buffer, misc::ENDIAN_BIG);
+}
+
+//==============================================================================
+UdpHeader::~UdpHeader()
+{
+}
+
+//==============================================================================
+void UdpHeader::addDataFields()
+{
+    addDataField(&source_port);
+    addDataField(&destination_port);
+    addDataField(&length);
+    addDataField(&checksum);
+}
@@ -0,0 +1,102 @@
+#if !defined UDP_HEADER_HPP
+#define UDP_HEADER_HPP
+
+#include <cstdint>
+
+#include "DataPacket.hpp"
+
+#include "SimpleDataField.hpp"
+#include "misc.hpp"
+
+// Represents a UDP header.  See UdpHeaderView for reading headers in place in a
+// receive buffer without copying them.
+class UdpHeader : public DataPacket
+{
+public:
+
+    // Initializes everything to 0
+    UdpHeader();
+
+    // Initializes ports, defaults for the rest
+    UdpHeader(std::uint16_t source_port, std::uint16_t destination_port);
+
+    // Constructs a UdpHeader by calling readRaw() on the provided buffer.  UDP
+    // headers are big endian on the wire so byteswapping is performed if
+    // needed.
+    explicit UdpHeader(const std::uint8_t* buffer);
+
+    // Does nothing
+    virtual ~UdpHeader();
+
+    std::uint16_t getSourcePort() const;
+    void setSourcePort(std::uint16_t source_port);
+
+    std::uint16_t getDestinationPort() const;
+    void setDestinationPort(std::uint16_t destination_port);
+
+    // Length of the header plus payload in bytes
+    std::uint16_t getLength() const;
+    void setLength(std::uint16_t length);
+
+    std::uint16_t getChecksum() const;
+    void setChecksum(std::uint16_t checksum);
+
+    // UDP headers are always exactly this size
+    static const unsigned short LENGTH_BYTES = 8;
+
+private:
+
+    void addDataFields();
+
+    SimpleDataField<std::uint16_t> source_port;
+    SimpleDataField<std::uint16_t> destination_port;
+    SimpleDataField<std::uint16_t> length;
+    SimpleDataField<std::uint16_t> checksum;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    UdpHeader(const UdpHeader&);
+    UdpHeader& operator=(const UdpHeader&);
+};
+
+inline std::uint16_t UdpHeader::getSourcePort() const
+{
+    return source_port;
+}
+
+inline void UdpHeader::setSourcePort(std::uint16_t source_port)
+{
+    this->source_port = source_port;
+}
+
+inline std::uint16_t UdpHeader::getDestinationPort() const
+{
+    return destination_port;
+}
+
+inline void UdpHeader::setDestinationPort(std::uint16_t destination_port)
+{
+    this->destination_port = destination_port;
+}
+
+inline std::uint16_t UdpHeader::getLength() const
+{
+    return length;
+}
+
+inline void UdpHeader::setLength(std::uint16_t length)
+{
+    this->length = length;
+}
+
+inline std::uint16_t UdpHeader::getChecksum() const
+{
+    return checksum;
+}
+
+inline void UdpHeader::setChecksum(std::uint16_t checksum)
+{
+    this->checksum = checksum;
+}
+
+#endif
@@ -0,0 +1,74 @@
+#if !defined UDP_HEADER_VIEW_HPP
+#define UDP_HEADER_VIEW_HPP
+
+#include <cstdint>
+
+// Reads the fields of a UDP header in place, straight out of a receive buffer,
+// the same way Ipv4HeaderView does for IPv4.  The buffer must hold at least
+// UdpHeader::LENGTH_BYTES bytes and outlive the view.
+class UdpHeaderView
+{
+public:
+
+    // Views the header starting at 'buffer'
+    explicit UdpHeaderView(const std::uint8_t* buffer);
+
+    std::uint16_t getSourcePort() const;
+    std::uint16_t getDestinationPort() const;
+    std::uint16_t getLength() const;
+    std::uint16_t getChecksum() const;
+
+    // Where the header starts
+    const std::uint8_t* getBuffer() const;
+
+    // Where the payload starts
+    const std::uint8_t* getPayload() const;
+
+private:
+
+    std::uint16_t read16(unsigned int offset) const;
+
+    const std::uint8_t* buffer;
+};
+
+inline UdpHeaderView::UdpHeaderView(const std::uint8_t* buffer) :
+    buffer(buffer)
+{
+}
+
+inline std::uint16_t UdpHeaderView::getSourcePort() const
+{
+    return read16(0);
+}
+
+inline std::uint16_t UdpHeaderView::getDestinationPort() const
+{
+    return read16(2);
+}
+
+inline std::uint16_t UdpHeaderView::getLength() const
+{
+    return read16(4);
+}
+
+inline std::uint16_t UdpHeaderView::getChecksum() const
+{
+    return read16(6);
+}
+
+inline const std::uint8_t* UdpHeaderView::getBuffer() const
+{
+    return buffer;
+}
+
+inline const std::uint8_t* UdpHeaderView::getPayload() const
+{
+    return buffer + 8;
+}
+
+inline std::uint16_t UdpHeaderView::read16(unsigned int offset) const
+{
+    return static_cast<std::uint16_t>(buffer[offset] << 8 | buffer[offset + 1]);
+}
+
+#endif
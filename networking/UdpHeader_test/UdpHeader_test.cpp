@@ -0,0 +1,72 @@
+#include <cstdint>
+
+#include "UdpHeader_test.hpp"
+
+#include "UdpHeader.hpp"
+#include "UdpHeaderView.hpp"
+
+#include "TestMacros.hpp"
+#include "misc.hpp"
+
+TEST_PROGRAM_MAIN(UdpHeader_test);
+
+//==============================================================================
+void UdpHeader_test::addTestCases()
+{
+    ADD_TEST_CASE(Length);
+    ADD_TEST_CASE(WriteRaw);
+    ADD_TEST_CASE(View);
+}
+
+//==============================================================================
+Test::Result UdpHeader_test::Length::body()
+{
+    UdpHeader udp_header(1234, 53);
+    MUST_BE_TRUE(udp_header.getLengthBytes() == UdpHeader::LENGTH_BYTES);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UdpHeader_test::WriteRaw::body()
+{
+    UdpHeader udp_header(0x1234, 53);
+    udp_header.setLength(0x0108);
+    udp_header.setChecksum(0xbeef);
+
+    std::uint8_t header_raw[UdpHeader::LENGTH_BYTES];
+    udp_header.writeRaw(header_raw, misc::ENDIAN_BIG);
+
+    // Everything is big endian on the wire
+    const std::uint8_t expected[UdpHeader::LENGTH_BYTES] =
+        {0x12, 0x34, 0x00, 0x35, 0x01, 0x08, 0xbe, 0xef};
+    for (unsigned int i = 0; i < UdpHeader::LENGTH_BYTES; ++i)
+    {
+        MUST_BE_TRUE(header_raw[i] == expected[i]);
+    }
+
+    UdpHeader read_header(expected);
+    MUST_BE_TRUE(read_header.getSourcePort() == 0x1234);
+    MUST_BE_TRUE(read_header.getDestinationPort() == 53);
+    MUST_BE_TRUE(read_header.getLength() == 0x0108);
+    MUST_BE_TRUE(read_header.getChecksum() == 0xbeef);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UdpHeader_test::View::body()
+{
+    const std::uint8_t header_raw[UdpHeader::LENGTH_BYTES] =
+        {0xc3, 0x50, 0x00, 0x35, 0x00, 0x1c, 0x12, 0x0f};
+
+    UdpHeaderView view(header_raw);
+    MUST_BE_TRUE(view.getSourcePort() == 50000);
+    MUST_BE_TRUE(view.getDestinationPort() == 53);
+    MUST_BE_TRUE(view.getLength() == 28);
+    MUST_BE_TRUE(view.getChecksum() == 0x120f);
+    MUST_BE_TRUE(view.getBuffer() == header_raw);
+    MUST_BE_TRUE(view.getPayload() == header_raw + UdpHeader::LENGTH_BYTES);
+
+    return Test::PASSED;
+}
@@ -0,0 +1,16 @@
+#if !defined UDP_HEADER_TEST
+#define UDP_HEADER_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(UdpHeader_test)
+
+    TEST(Length)
+    TEST(WriteRaw)
+    TEST(View)
+
+TEST_CASES_END(UdpHeader_test)
+
+#endif
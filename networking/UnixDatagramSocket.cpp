@@ -0,0 +1,102 @@
+#include <stdexcept>
+#include <string>
+
+#include "UnixDatagramSocket.hpp"
+
+#include "SocketFactory.hpp"
+#include "UnixDatagramSocketImpl.hpp"
+
+//==============================================================================
+// Creates a platform-specific Unix domain datagram socket
+//==============================================================================
+UnixDatagramSocket::UnixDatagramSocket() :
+    Socket()
+{
+    // Get a platform-specific socket
+    socket_impl = SocketFactory::createUnixDatagramSocket();
+
+    if (socket_impl)
+    {
+        Socket::setImplementation(socket_impl);
+    }
+    else
+    {
+        throw std::runtime_error(
+            "Platform-specific Unix datagram socket could not be created");
+    }
+}
+
+//==============================================================================
+// Destroys socket
+//==============================================================================
+UnixDatagramSocket::~UnixDatagramSocket()
+{
+    delete socket_impl;
+}
+
+//==============================================================================
+// Calls implementation-specific bind
+//==============================================================================
+bool UnixDatagramSocket::bind(const std::string& path)
+{
+    if (socket_impl)
+    {
+        return socket_impl->bind(path);
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific sendTo
+//==============================================================================
+bool UnixDatagramSocket::sendTo(const std::string& path)
+{
+    if (socket_impl)
+    {
+        return socket_impl->sendTo(path);
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific getPeerPath
+//==============================================================================
+void UnixDatagramSocket::getPeerPath(std::string& peer_path) const
+{
+    if (socket_impl)
+    {
+        socket_impl->getPeerPath(peer_path);
+    }
+}
+
+//==============================================================================
+// Calls implementation-specific readBatch
+//==============================================================================
+int UnixDatagramSocket::readBatch(unsigned char** buffers,
+                                  unsigned int*   sizes,
+                                  unsigned int    count)
+{
+    if (socket_impl)
+    {
+        return socket_impl->readBatch(buffers, sizes, count);
+    }
+
+    return -1;
+}
+
+//==============================================================================
+// Calls implementation-specific writeBatch
+//==============================================================================
+int UnixDatagramSocket::writeBatch(const unsigned char* const* buffers,
+                                   const unsigned int*         sizes,
+                                   unsigned int                count)
+{
+    if (socket_impl)
+    {
+        return socket_impl->writeBatch(buffers, sizes, count);
+    }
+
+    return -1;
+}
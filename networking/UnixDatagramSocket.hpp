@@ -0,0 +1,81 @@
+#if !defined UNIX_DATAGRAM_SOCKET_HPP
+#define UNIX_DATAGRAM_SOCKET_HPP
+
+#include <string>
+
+#include "Socket.hpp"
+
+class UnixDatagramSocketImpl;
+
+// A connectionless Unix domain socket, for exchanging datagrams with other
+// processes on the same host without going through the IP stack.  Used just
+// like a UDPSocket, except that sockets are named by path instead of by address
+// and port.  On Linux a path starting with '@' is a name in the abstract
+// namespace, which never appears in the filesystem.  Unlike UDP, delivery is
+// reliable and in order; a writer blocks (or gets EAGAIN) when the receiver
+// falls behind instead of its datagrams being dropped.  On Linux that happens
+// once only net.unix.max_dgram_qlen (10 by default) datagrams are queued.
+class UnixDatagramSocket : public Socket
+{
+public:
+
+    // Does nothing but call parent constructor.
+    UnixDatagramSocket();
+
+    // Closes the socket.  If this socket bound a filesystem path, the path is
+    // removed.
+    virtual ~UnixDatagramSocket();
+
+    // Gives this socket the given path so other sockets can send to it.
+    // Fails if something already exists at the path.
+    bool bind(const std::string& path);
+
+    // Causes outgoing datagrams to be sent to the socket at the given path
+    bool sendTo(const std::string& path);
+
+    // Gets the path of the socket that sent the last datagram read; empty if
+    // the sender wasn't bound to a path (in which case it can't be replied to)
+    void getPeerPath(std::string& peer_path) const;
+
+    // Reads up to 'count' datagrams with as few system calls as possible,
+    // waiting (subject to blocking settings) only for the first.  Datagram i
+    // goes into 'buffers[i]', which has room for 'sizes[i]' bytes; on return
+    // 'sizes[i]' holds the length actually read.  Returns the number of
+    // datagrams read, 0 on timeout, -1 on error.
+    int readBatch(unsigned char** buffers,
+                  unsigned int*   sizes,
+                  unsigned int    count);
+
+    // Writes up to 'count' datagrams to the sendTo() destination with as few
+    // system calls as possible, datagram i being 'buffers[i]' and 'sizes[i]'
+    // bytes long.  Returns the number of datagrams written, which may be fewer
+    // than 'count' if the receiver's queue fills, 0 if the blocking timeout
+    // expired before any were written, or -1 on error.
+    int writeBatch(const unsigned char* const* buffers,
+                   const unsigned int*         sizes,
+                   unsigned int                count);
+
+protected:
+
+    // Sets the platform-specific socket implementation to use
+    void setImplementation(UnixDatagramSocketImpl* socket_impl);
+
+private:
+
+    // Platform-specific socket implementation
+    UnixDatagramSocketImpl* socket_impl;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    UnixDatagramSocket(const UnixDatagramSocket&);
+    UnixDatagramSocket& operator=(const UnixDatagramSocket&);
+};
+
+//==============================================================================
+inline void UnixDatagramSocket::setImplementation(
+    UnixDatagramSocketImpl* socket_impl)
+{
+    this->socket_impl = socket_impl;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#include "UnixDatagramSocketImpl.hpp"
+
+//=============================================================================
+// Constructor; does nothing.
+//=============================================================================
+UnixDatagramSocketImpl::UnixDatagramSocketImpl() :
+    SocketImpl()
+{
+}
+
+//=============================================================================
+// Destructor; does nothing.
+//=============================================================================
+UnixDatagramSocketImpl::~UnixDatagramSocketImpl()
+{
+}
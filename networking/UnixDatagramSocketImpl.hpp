@@ -0,0 +1,47 @@
+#if !defined UNIX_DATAGRAM_SOCKET_IMPL_HPP
+#define UNIX_DATAGRAM_SOCKET_IMPL_HPP
+
+#include <string>
+
+#include "SocketImpl.hpp"
+
+class UnixDatagramSocketImpl : public SocketImpl
+{
+public:
+
+    // Does nothing but call parent constructor.
+    UnixDatagramSocketImpl();
+
+    // Does nothing.
+    virtual ~UnixDatagramSocketImpl();
+
+    // Gives this socket the given path
+    virtual bool bind(const std::string& path) = 0;
+
+    // Causes outgoing datagrams to be sent to the socket at the given path
+    virtual bool sendTo(const std::string& path) = 0;
+
+    // Gets the path of the socket that sent the last datagram read
+    virtual void getPeerPath(std::string& peer_path) const = 0;
+
+    // Reads several datagrams with as few system calls as possible.  See
+    // UnixDatagramSocket for details.
+    virtual int readBatch(unsigned char** buffers,
+                          unsigned int*   sizes,
+                          unsigned int    count) = 0;
+
+    // Writes several datagrams with as few system calls as possible.  See
+    // UnixDatagramSocket for details.
+    virtual int writeBatch(const unsigned char* const* buffers,
+                           const unsigned int*         sizes,
+                           unsigned int                count) = 0;
+
+private:
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    UnixDatagramSocketImpl(const UnixDatagramSocketImpl&);
+    UnixDatagramSocketImpl& operator=(const UnixDatagramSocketImpl&);
+};
+
+#endif
@@ -0,0 +1,227 @@
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "UnixDatagramSocket_test.hpp"
+
+#include "SocketStatistics.hpp"
+#include "UnixDatagramSocket.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(UnixDatagramSocket_test);
+
+//==============================================================================
+void UnixDatagramSocket_test::addTestCases()
+{
+    ADD_TEST_CASE(SendReceive);
+    ADD_TEST_CASE(AbstractNamespace);
+    ADD_TEST_CASE(Batch);
+}
+
+//==============================================================================
+// Returns a socket path no other test (or test run) is using
+//==============================================================================
+static std::string getSocketPath(const std::string& name)
+{
+    std::ostringstream path;
+    path << "/tmp/UnixDatagramSocket_test_" << getpid() << "_" << name;
+    return path.str();
+}
+
+//==============================================================================
+// Returns true if something exists at the given path
+//==============================================================================
+static bool pathExists(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+//==============================================================================
+Test::Result UnixDatagramSocket_test::SendReceive::body()
+{
+    std::string path1 = getSocketPath("SendReceive1");
+    std::string path2 = getSocketPath("SendReceive2");
+
+    UnixDatagramSocket* socket1 = new UnixDatagramSocket();
+    UnixDatagramSocket  socket2;
+    UnixDatagramSocket  unbound;
+
+    MUST_BE_TRUE(socket1->bind(path1));
+    MUST_BE_TRUE(socket2.bind(path2));
+    MUST_BE_TRUE(pathExists(path1));
+
+    socket1->setBlockingTimeout(1.0);
+    socket2.setBlockingTimeout(1.0);
+
+    // There's nowhere to send to yet
+    const unsigned char message[] = "datagram";
+    MUST_BE_TRUE(socket1->write(message, sizeof(message)) == -1);
+
+    MUST_BE_TRUE(socket1->sendTo(path2));
+    MUST_BE_TRUE(socket1->write(message, sizeof(message)) ==
+                 static_cast<int>(sizeof(message)));
+
+    unsigned char buffer[64];
+    MUST_BE_TRUE(socket2.read(buffer, sizeof(buffer)) ==
+                 static_cast<int>(sizeof(message)));
+    MUST_BE_TRUE(memcmp(buffer, message, sizeof(message)) == 0);
+
+    // The receiver can see where that came from and reply
+    std::string peer_path;
+    socket2.getPeerPath(peer_path);
+    MUST_BE_TRUE(peer_path == path1);
+
+    MUST_BE_TRUE(socket2.sendTo(peer_path));
+    MUST_BE_TRUE(socket2.write(message, 4) == 4);
+    MUST_BE_TRUE(socket1->read(buffer, sizeof(buffer)) == 4);
+
+    // Datagrams from unbound sockets have no return address
+    MUST_BE_TRUE(unbound.sendTo(path2));
+    MUST_BE_TRUE(unbound.write(message, sizeof(message)) ==
+                 static_cast<int>(sizeof(message)));
+    MUST_BE_TRUE(socket2.read(buffer, sizeof(buffer)) ==
+                 static_cast<int>(sizeof(message)));
+    socket2.getPeerPath(peer_path);
+    MUST_BE_TRUE(peer_path.empty());
+
+    // Paths go away with the sockets that bound them
+    delete socket1;
+    MUST_BE_FALSE(pathExists(path1));
+
+    // Paths that can't fit in an address are refused
+    MUST_BE_FALSE(socket2.sendTo(std::string(200, 'x')));
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UnixDatagramSocket_test::AbstractNamespace::body()
+{
+#if defined LINUX
+    std::string name1 = "@" + getSocketPath("AbstractNamespace1");
+    std::string name2 = "@" + getSocketPath("AbstractNamespace2");
+
+    UnixDatagramSocket socket1;
+    UnixDatagramSocket socket2;
+
+    MUST_BE_TRUE(socket1.bind(name1));
+    MUST_BE_TRUE(socket2.bind(name2));
+
+    // Nothing shows up in the filesystem
+    MUST_BE_FALSE(pathExists(name1.substr(1)));
+
+    socket2.setBlockingTimeout(1.0);
+
+    const unsigned char message[] = "abstract";
+    MUST_BE_TRUE(socket1.sendTo(name2));
+    MUST_BE_TRUE(socket1.write(message, sizeof(message)) ==
+                 static_cast<int>(sizeof(message)));
+
+    unsigned char buffer[64];
+    MUST_BE_TRUE(socket2.read(buffer, sizeof(buffer)) ==
+                 static_cast<int>(sizeof(message)));
+
+    std::string peer_path;
+    socket2.getPeerPath(peer_path);
+    MUST_BE_TRUE(peer_path == name1);
+
+    return Test::PASSED;
+#else
+    // Only Linux has the abstract namespace
+    return Test::SKIPPED;
+#endif
+}
+
+//==============================================================================
+Test::Result UnixDatagramSocket_test::Batch::body()
+{
+    UnixDatagramSocket sender;
+    UnixDatagramSocket receiver;
+
+    std::string path = getSocketPath("Batch");
+    MUST_BE_TRUE(receiver.bind(path));
+    MUST_BE_TRUE(sender.sendTo(path));
+    receiver.setBlockingTimeout(1.0);
+
+    // The kernel only queues a handful of Unix datagrams per socket (see
+    // net.unix.max_dgram_qlen on Linux), so the sender goes non-blocking and
+    // the two sides take turns
+    sender.disableBlocking();
+
+    const unsigned int count = 200;
+
+    std::vector<std::vector<unsigned char> > sent(count);
+    std::vector<const unsigned char*>        send_buffers(count);
+    std::vector<unsigned int>                send_sizes(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        sent[i].assign(i % 32 + 1, static_cast<unsigned char>(i));
+        send_buffers[i] = &sent[i][0];
+        send_sizes[i]   = sent[i].size();
+    }
+
+    std::vector<std::vector<unsigned char> > received(
+        count, std::vector<unsigned char>(64));
+    std::vector<unsigned char*> receive_buffers(count);
+    std::vector<unsigned int>   receive_sizes(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        receive_buffers[i] = &received[i][0];
+        receive_sizes[i]   = received[i].size();
+    }
+
+    unsigned int total_sent     = 0;
+    unsigned int total_received = 0;
+    while (total_received < count)
+    {
+        if (total_sent < count)
+        {
+            int ret = sender.writeBatch(&send_buffers[total_sent],
+                                        &send_sizes[total_sent],
+                                        count - total_sent);
+            MUST_BE_TRUE(ret > 0);
+            total_sent += ret;
+        }
+
+        int ret = receiver.readBatch(&receive_buffers[total_received],
+                                     &receive_sizes[total_received],
+                                     count - total_received);
+        MUST_BE_TRUE(ret > 0);
+        total_received += ret;
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        MUST_BE_TRUE(receive_sizes[i] == sent[i].size());
+        MUST_BE_TRUE(memcmp(&received[i][0], &sent[i][0], sent[i].size()) ==
+                     0);
+    }
+
+    SocketStatistics send_statistics;
+    SocketStatistics receive_statistics;
+    sender.getStatistics(send_statistics);
+    receiver.getStatistics(receive_statistics);
+
+    MUST_BE_TRUE(send_statistics.getDatagramsSent() == count);
+    MUST_BE_TRUE(receive_statistics.getDatagramsReceived() == count);
+
+    std::cout << "Send system calls: " << send_statistics.getSyscalls()
+              << "\nReceive system calls: " << receive_statistics.getSyscalls()
+              << "\n";
+
+#if defined LINUX
+    // Every system call moves as many datagrams as the queue allows, rather
+    // than just one
+    MUST_BE_TRUE(send_statistics.getSyscalls() < count / 2);
+    MUST_BE_TRUE(receive_statistics.getSyscalls() < count / 2);
+#endif
+
+    return Test::PASSED;
+}
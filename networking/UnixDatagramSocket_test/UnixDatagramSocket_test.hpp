@@ -0,0 +1,16 @@
+#if !defined UNIX_DATAGRAM_SOCKET_TEST
+#define UNIX_DATAGRAM_SOCKET_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(UnixDatagramSocket_test)
+
+    TEST(SendReceive)
+    TEST(AbstractNamespace)
+    TEST(Batch)
+
+TEST_CASES_END(UnixDatagramSocket_test)
+
+#endif
@@ -0,0 +1,163 @@
+#include <stdexcept>
+#include <string>
+
+#include "UnixStreamSocket.hpp"
+
+#include "SocketFactory.hpp"
+#include "UnixStreamSocketImpl.hpp"
+
+const int          UnixStreamSocket::DEFAULT_BACKLOG;
+const unsigned int UnixStreamSocket::DESCRIPTORS_MAX;
+
+//==============================================================================
+// Creates a platform-specific Unix domain stream socket
+//==============================================================================
+UnixStreamSocket::UnixStreamSocket(Type type) :
+    Socket(),
+    type(type)
+{
+    // Get a platform-specific socket
+    socket_impl = SocketFactory::createUnixStreamSocket(type == SEQPACKET);
+
+    if (socket_impl)
+    {
+        Socket::setImplementation(socket_impl);
+    }
+    else
+    {
+        throw std::runtime_error(
+            "Platform-specific Unix stream socket could not be created");
+    }
+}
+
+//==============================================================================
+// Special constructor used during accept; wraps an already-created
+// implementation-specific socket
+//==============================================================================
+UnixStreamSocket::UnixStreamSocket(UnixStreamSocketImpl* socket_impl,
+                                   Type                  type) :
+    Socket(),
+    socket_impl(socket_impl),
+    type(type)
+{
+    Socket::setImplementation(socket_impl);
+}
+
+//==============================================================================
+// Destroys socket
+//==============================================================================
+UnixStreamSocket::~UnixStreamSocket()
+{
+    delete socket_impl;
+}
+
+//==============================================================================
+// Calls implementation-specific bind
+//==============================================================================
+bool UnixStreamSocket::bind(const std::string& path)
+{
+    if (socket_impl)
+    {
+        return socket_impl->bind(path);
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific listen
+//==============================================================================
+bool UnixStreamSocket::listen(int backlog)
+{
+    if (socket_impl)
+    {
+        return socket_impl->listen(backlog);
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific accept
+//==============================================================================
+UnixStreamSocket* UnixStreamSocket::accept(bool take_over)
+{
+    if (socket_impl)
+    {
+        UnixStreamSocketImpl* new_socket_impl = socket_impl->accept(take_over);
+
+        if (!new_socket_impl)
+        {
+            return 0;
+        }
+        else if (new_socket_impl != socket_impl)
+        {
+            return new UnixStreamSocket(new_socket_impl, type);
+        }
+        else
+        {
+            return this;
+        }
+    }
+
+    return 0;
+}
+
+//==============================================================================
+// Calls implementation-specific connect
+//==============================================================================
+bool UnixStreamSocket::connect(const std::string& path)
+{
+    if (socket_impl)
+    {
+        return socket_impl->connect(path);
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific isConnected
+//==============================================================================
+bool UnixStreamSocket::isConnected()
+{
+    if (socket_impl)
+    {
+        return socket_impl->isConnected();
+    }
+
+    return false;
+}
+
+//==============================================================================
+// Calls implementation-specific writeDescriptors
+//==============================================================================
+int UnixStreamSocket::writeDescriptors(const unsigned char* buffer,
+                                       unsigned int         size,
+                                       const int*           fds,
+                                       unsigned int         fd_count)
+{
+    if (socket_impl)
+    {
+        return socket_impl->writeDescriptors(buffer, size, fds, fd_count);
+    }
+
+    return -1;
+}
+
+//==============================================================================
+// Calls implementation-specific readDescriptors
+//==============================================================================
+int UnixStreamSocket::readDescriptors(unsigned char* buffer,
+                                      unsigned int   size,
+                                      int*           fds,
+                                      unsigned int&  fd_count)
+{
+    if (socket_impl)
+    {
+        return socket_impl->readDescriptors(buffer, size, fds, fd_count);
+    }
+
+    fd_count = 0;
+    return -1;
+}
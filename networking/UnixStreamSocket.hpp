@@ -0,0 +1,120 @@
+#if !defined UNIX_STREAM_SOCKET_HPP
+#define UNIX_STREAM_SOCKET_HPP
+
+#include <string>
+
+#include "Socket.hpp"
+
+class UnixStreamSocketImpl;
+
+// A connection-oriented Unix domain socket, for talking to other processes on
+// the same host without going through the IP stack.  Used just like a
+// TCPSocket, except that sockets are named by path instead of by address and
+// port.  On Linux a path starting with '@' is a name in the abstract namespace,
+// which never appears in the filesystem.  A SEQPACKET socket keeps message
+// boundaries like a datagram socket while still being connected and reliable.
+// Either kind can pass open file descriptors to its peer.
+class UnixStreamSocket : public Socket
+{
+public:
+
+    // Byte stream (SOCK_STREAM) or sequenced messages (SOCK_SEQPACKET)
+    enum Type
+    {
+        STREAM,
+        SEQPACKET
+    };
+
+    // Creates a socket of the given type.
+    explicit UnixStreamSocket(Type type = STREAM);
+
+    // Closes the socket.  If this socket bound a filesystem path, the path is
+    // removed.
+    virtual ~UnixStreamSocket();
+
+    // Gives this socket the given path.  Fails if something already exists at
+    // the path, including one left behind by a process that exited without
+    // cleaning up.
+    bool bind(const std::string& path);
+
+    // Instructs this socket to begin listening for incoming connections.  Up
+    // to 'backlog' connection requests are queued by the kernel while waiting
+    // to be accepted.  Must call 'bind' prior to this.
+    bool listen(int backlog = DEFAULT_BACKLOG);
+
+    // Accepts a connection request, should one be pending.  Works just like
+    // TCPSocket::accept.
+    UnixStreamSocket* accept(bool take_over = true);
+
+    // Connects this socket to the listening socket at the given path
+    bool connect(const std::string& path);
+
+    // Returns whether or not this socket is connected to another
+    bool isConnected();
+
+    // Returns the kind of socket this is
+    Type getType() const;
+
+    // Writes 'size' bytes from 'buffer' along with copies of the 'fd_count'
+    // open file descriptors in 'fds', which the peer receives with
+    // readDescriptors().  The descriptors stay open here too.  At least one
+    // byte must be written, and at most DESCRIPTORS_MAX descriptors.  Returns
+    // the number of bytes written, 0 if the blocking timeout expired, or -1 on
+    // error.
+    int writeDescriptors(const unsigned char* buffer,
+                         unsigned int         size,
+                         const int*           fds,
+                         unsigned int         fd_count);
+
+    // Reads like read(), also receiving any file descriptors the peer sent
+    // with the data.  'fds' has room for 'fd_count' descriptors; on return
+    // 'fd_count' holds the number received.  Descriptors arrive with the first
+    // byte written alongside them, and any that don't fit in 'fds' are closed.
+    // The caller is responsible for closing the ones received.
+    int readDescriptors(unsigned char* buffer,
+                        unsigned int   size,
+                        int*           fds,
+                        unsigned int&  fd_count);
+
+    // Connection request queue length used by listen() when none is given
+    static const int DEFAULT_BACKLOG = 128;
+
+    // Most descriptors one writeDescriptors() or readDescriptors() handles
+    static const unsigned int DESCRIPTORS_MAX = 64;
+
+protected:
+
+    // Sets the platform-specific socket implementation to use
+    void setImplementation(UnixStreamSocketImpl* socket_impl);
+
+private:
+
+    // This is a special constructor used during calls to accept.  It wraps an
+    // existing platform-specific socket in an instance of this class.
+    UnixStreamSocket(UnixStreamSocketImpl* socket_impl, Type type);
+
+    // Platform-specific socket implementation to use
+    UnixStreamSocketImpl* socket_impl;
+
+    Type type;
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    UnixStreamSocket(const UnixStreamSocket&);
+    UnixStreamSocket& operator=(const UnixStreamSocket&);
+};
+
+//==============================================================================
+inline UnixStreamSocket::Type UnixStreamSocket::getType() const
+{
+    return type;
+}
+
+//==============================================================================
+inline void UnixStreamSocket::setImplementation(
+    UnixStreamSocketImpl* socket_impl)
+{
+    this->socket_impl = socket_impl;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#include "UnixStreamSocketImpl.hpp"
+
+//=============================================================================
+// Constructor; does nothing.
+//=============================================================================
+UnixStreamSocketImpl::UnixStreamSocketImpl() :
+    SocketImpl()
+{
+}
+
+//=============================================================================
+// Destructor; does nothing.
+//=============================================================================
+UnixStreamSocketImpl::~UnixStreamSocketImpl()
+{
+}
@@ -0,0 +1,58 @@
+#if !defined UNIX_STREAM_SOCKET_IMPL_HPP
+#define UNIX_STREAM_SOCKET_IMPL_HPP
+
+#include <string>
+
+#include "SocketImpl.hpp"
+
+class UnixStreamSocketImpl : public SocketImpl
+{
+public:
+
+    // Does nothing but call parent constructor.
+    UnixStreamSocketImpl();
+
+    // Does nothing.
+    virtual ~UnixStreamSocketImpl();
+
+    // Gives this socket the given path
+    virtual bool bind(const std::string& path) = 0;
+
+    // Instructs this socket to begin listening for incoming connections,
+    // queueing up to 'backlog' connection requests.  Must call 'bind' prior to
+    // this.
+    virtual bool listen(int backlog) = 0;
+
+    // Accepts a connection request, should one be pending.  See
+    // TCPSocketImpl::accept for what 'take_over' does.
+    virtual UnixStreamSocketImpl* accept(bool take_over = true) = 0;
+
+    // Connects this socket to the listening socket at the given path
+    virtual bool connect(const std::string& path) = 0;
+
+    // Returns whether or not this socket is connected to another
+    virtual bool isConnected() = 0;
+
+    // Writes data along with file descriptors for the peer.  See
+    // UnixStreamSocket for details.
+    virtual int writeDescriptors(const unsigned char* buffer,
+                                 unsigned int         size,
+                                 const int*           fds,
+                                 unsigned int         fd_count) = 0;
+
+    // Reads data along with any file descriptors the peer sent.  See
+    // UnixStreamSocket for details.
+    virtual int readDescriptors(unsigned char* buffer,
+                                unsigned int   size,
+                                int*           fds,
+                                unsigned int&  fd_count) = 0;
+
+private:
+
+    // Disallow these for now; maybe these could be meaningfully implemented but
+    // we'll save that for later
+    UnixStreamSocketImpl(const UnixStreamSocketImpl&);
+    UnixStreamSocketImpl& operator=(const UnixStreamSocketImpl&);
+};
+
+#endif
@@ -0,0 +1,256 @@
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "UnixStreamSocket_test.hpp"
+
+#include "UnixStreamSocket.hpp"
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_PROGRAM_MAIN(UnixStreamSocket_test);
+
+//==============================================================================
+void UnixStreamSocket_test::addTestCases()
+{
+    ADD_TEST_CASE(ConnectReadWrite);
+    ADD_TEST_CASE(SequencedPackets);
+    ADD_TEST_CASE(DescriptorPassing);
+}
+
+//==============================================================================
+// Returns a socket path no other test (or test run) is using
+//==============================================================================
+static std::string getSocketPath(const std::string& test_name)
+{
+    std::ostringstream path;
+    path << "/tmp/UnixStreamSocket_test_" << getpid() << "_" << test_name;
+    return path.str();
+}
+
+//==============================================================================
+// Returns true if something exists at the given path
+//==============================================================================
+static bool pathExists(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+//==============================================================================
+// Connects 'client' to a new listener at 'path', which accepts the connection
+// as 'server'.  Returns false if any of that fails.
+//==============================================================================
+static bool connectPair(const std::string& path,
+                        UnixStreamSocket&  client,
+                        UnixStreamSocket&  server)
+{
+    if (!server.bind(path) ||
+        !server.listen() ||
+        !client.connect(path) ||
+        !server.accept())
+    {
+        return false;
+    }
+
+    // Nothing here should ever have to wait long
+    client.setBlockingTimeout(1.0);
+    server.setBlockingTimeout(1.0);
+
+    return true;
+}
+
+//==============================================================================
+Test::Result UnixStreamSocket_test::ConnectReadWrite::body()
+{
+    std::string path = getSocketPath("ConnectReadWrite");
+
+    UnixStreamSocket* listener = new UnixStreamSocket();
+    MUST_BE_TRUE(listener->getType() == UnixStreamSocket::STREAM);
+    MUST_BE_TRUE(listener->bind(path));
+    MUST_BE_TRUE(pathExists(path));
+
+    // Nobody else can have the same path
+    UnixStreamSocket other;
+    MUST_BE_FALSE(other.bind(path));
+
+    MUST_BE_TRUE(listener->listen());
+
+    UnixStreamSocket client;
+    MUST_BE_TRUE(client.connect(path));
+
+    UnixStreamSocket* server = listener->accept(false);
+    MUST_BE_TRUE(server != 0);
+    MUST_BE_TRUE(server != listener);
+    MUST_BE_TRUE(server->isConnected());
+
+    server->setBlockingTimeout(1.0);
+
+    const unsigned char message[] = "local traffic";
+    MUST_BE_TRUE(client.write(message, sizeof(message)) ==
+                 static_cast<int>(sizeof(message)));
+
+    unsigned char buffer[64];
+    MUST_BE_TRUE(server->read(buffer, sizeof(buffer)) ==
+                 static_cast<int>(sizeof(message)));
+    MUST_BE_TRUE(memcmp(buffer, message, sizeof(message)) == 0);
+
+    // The listener owns the path and takes it with it
+    delete listener;
+    MUST_BE_FALSE(pathExists(path));
+
+    // Accepted connections keep working without it
+    MUST_BE_TRUE(server->write(message, sizeof(message)) ==
+                 static_cast<int>(sizeof(message)));
+    MUST_BE_TRUE(client.read(buffer, sizeof(buffer)) ==
+                 static_cast<int>(sizeof(message)));
+
+    delete server;
+    MUST_BE_FALSE(client.isConnected());
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UnixStreamSocket_test::SequencedPackets::body()
+{
+    // Not every platform has Unix domain sequenced packet sockets
+    UnixStreamSocket* client = 0;
+    try
+    {
+        client = new UnixStreamSocket(UnixStreamSocket::SEQPACKET);
+    }
+    catch (std::runtime_error&)
+    {
+    }
+    SKIP_IF_TRUE(client == 0);
+
+    UnixStreamSocket server(UnixStreamSocket::SEQPACKET);
+    bool connected =
+        connectPair(getSocketPath("SequencedPackets"), *client, server);
+    if (!connected)
+    {
+        delete client;
+    }
+    MUST_BE_TRUE(connected);
+
+    const unsigned char one[] = {'o', 'n', 'e'};
+    const unsigned char two[] = {'t', 'w', 'o', '!', '!'};
+
+    int ret1 = client->write(one, sizeof(one));
+    int ret2 = client->write(two, sizeof(two));
+    delete client;
+
+    MUST_BE_TRUE(ret1 == static_cast<int>(sizeof(one)));
+    MUST_BE_TRUE(ret2 == static_cast<int>(sizeof(two)));
+
+    // Each write comes out as a separate message, and a short read takes only
+    // the start of a message and discards the rest
+    unsigned char buffer[64];
+    MUST_BE_TRUE(server.read(buffer, sizeof(buffer)) ==
+                 static_cast<int>(sizeof(one)));
+    MUST_BE_TRUE(memcmp(buffer, one, sizeof(one)) == 0);
+
+    MUST_BE_TRUE(server.read(buffer, 2) == 2);
+    MUST_BE_TRUE(memcmp(buffer, two, 2) == 0);
+
+    // All that's left is the peer going away
+    MUST_BE_TRUE(server.read(buffer, sizeof(buffer)) == 0);
+
+    return Test::PASSED;
+}
+
+//==============================================================================
+Test::Result UnixStreamSocket_test::DescriptorPassing::body()
+{
+    UnixStreamSocket client;
+    UnixStreamSocket server;
+    MUST_BE_TRUE(
+        connectPair(getSocketPath("DescriptorPassing"), client, server));
+
+    // Hand over the read end of a pipe and make sure it's the same pipe on the
+    // other side
+    int pipe_fds[2];
+    MUST_BE_TRUE(pipe(pipe_fds) == 0);
+
+    const unsigned char tag = 'p';
+    int ret = server.writeDescriptors(&tag, 1, &pipe_fds[0], 1);
+    close(pipe_fds[0]);
+    MUST_BE_TRUE(ret == 1);
+
+    unsigned char buffer[16];
+    int          received[UnixStreamSocket::DESCRIPTORS_MAX];
+    unsigned int received_count = UnixStreamSocket::DESCRIPTORS_MAX;
+
+    MUST_BE_TRUE(client.readDescriptors(
+                     buffer, sizeof(buffer), received, received_count) == 1);
+    MUST_BE_TRUE(buffer[0] == tag);
+    MUST_BE_TRUE(received_count == 1);
+
+    const char through_pipe[] = "piped";
+    ret = ::write(pipe_fds[1], through_pipe, sizeof(through_pipe));
+    close(pipe_fds[1]);
+    MUST_BE_TRUE(ret == static_cast<int>(sizeof(through_pipe)));
+
+    char pipe_buffer[16];
+    ret = ::read(received[0], pipe_buffer, sizeof(pipe_buffer));
+    close(received[0]);
+    MUST_BE_TRUE(ret == static_cast<int>(sizeof(through_pipe)));
+    MUST_BE_TRUE(memcmp(pipe_buffer, through_pipe, sizeof(through_pipe)) == 0);
+
+    // Descriptors that don't fit are dropped, and the data still arrives
+    int fds[3];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        fds[i] = dup(STDIN_FILENO);
+    }
+
+    ret = server.writeDescriptors(&tag, 1, fds, 3);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        close(fds[i]);
+    }
+    MUST_BE_TRUE(ret == 1);
+
+    received_count = 1;
+    MUST_BE_TRUE(client.readDescriptors(
+                     buffer, sizeof(buffer), received, received_count) == 1);
+    MUST_BE_TRUE(received_count == 1);
+    close(received[0]);
+
+    // Descriptors can't be sent without data to go with them
+    MUST_BE_TRUE(server.writeDescriptors(&tag, 0, fds, 1) == -1);
+
+#if defined LINUX
+    // A memory-backed file is how a large buffer gets handed over without
+    // copying it through the socket
+    int memfd = memfd_create("UnixStreamSocket_test", 0);
+    MUST_BE_TRUE(memfd != -1);
+
+    const char contents[] = "shared buffer contents";
+    ret = ::write(memfd, contents, sizeof(contents));
+    MUST_BE_TRUE(ret == static_cast<int>(sizeof(contents)));
+
+    ret = server.writeDescriptors(&tag, 1, &memfd, 1);
+    close(memfd);
+    MUST_BE_TRUE(ret == 1);
+
+    received_count = UnixStreamSocket::DESCRIPTORS_MAX;
+    MUST_BE_TRUE(client.readDescriptors(
+                     buffer, sizeof(buffer), received, received_count) == 1);
+    MUST_BE_TRUE(received_count == 1);
+
+    char file_buffer[sizeof(contents)];
+    ret = pread(received[0], file_buffer, sizeof(file_buffer), 0);
+    close(received[0]);
+    MUST_BE_TRUE(ret == static_cast<int>(sizeof(contents)));
+    MUST_BE_TRUE(memcmp(file_buffer, contents, sizeof(contents)) == 0);
+#endif
+
+    return Test::PASSED;
+}
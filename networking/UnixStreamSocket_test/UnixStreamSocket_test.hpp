@@ -0,0 +1,16 @@
+#if !defined UNIX_STREAM_SOCKET_TEST
+#define UNIX_STREAM_SOCKET_TEST
+
+#include "Test.hpp"
+#include "TestCases.hpp"
+#include "TestMacros.hpp"
+
+TEST_CASES_BEGIN(UnixStreamSocket_test)
+
+    TEST(ConnectReadWrite)
+    TEST(SequencedPackets)
+    TEST(DescriptorPassing)
+
+TEST_CASES_END(UnixStreamSocket_test)
+
+#endif
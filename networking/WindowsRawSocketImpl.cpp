@@ -240,3 +240,81 @@ void WindowsRawSocketImpl::clearBuffer()
         sizeof(sockaddr_in),
         is_blocking);
 }
+
+//=============================================================================
+bool WindowsRawSocketImpl::getKernelStatistics(
+    SocketKernelStatistics& kernel_statistics)
+{
+    return WindowsSocketCommon::getKernelStatistics(socket_fd,
+                                                    kernel_statistics);
+}
+
+//=============================================================================
+bool WindowsRawSocketImpl::enableTimestamps()
+{
+    return false;
+}
+
+//=============================================================================
+void WindowsRawSocketImpl::getLastTimestamp(PosixTimespec& timestamp) const
+{
+}
+
+//=============================================================================
+int WindowsRawSocketImpl::readBatch(std::uint8_t** buffers,
+                                    unsigned int*  sizes,
+                                    unsigned int   count,
+                                    PosixTimespec* timestamps,
+                                    unsigned int*  wire_sizes)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    int ret = read(buffers[0], sizes[0]);
+    if (ret <= 0)
+    {
+        return ret;
+    }
+
+    sizes[0] = ret;
+
+    if (wire_sizes)
+    {
+        wire_sizes[0] = ret;
+    }
+
+    return 1;
+}
+
+//=============================================================================
+bool WindowsRawSocketImpl::enableBusyPoll(double spin_time, int core)
+{
+    return false;
+}
+
+//=============================================================================
+bool WindowsRawSocketImpl::disableBusyPoll()
+{
+    return false;
+}
+
+//=============================================================================
+int WindowsRawSocketImpl::writeBatch(const std::uint8_t* const* buffers,
+                                     const unsigned int*        sizes,
+                                     unsigned int               count)
+{
+    unsigned int total = 0;
+    for (; total < count; ++total)
+    {
+        int ret = write(buffers[total], sizes[total]);
+        if (ret <= 0)
+        {
+            // Report what went wrong only if nothing was written
+            return total > 0 ? static_cast<int>(total) : ret;
+        }
+    }
+
+    return total;
+}
@@ -76,6 +76,39 @@ public:
     // Forces this socket to discard any received data.
     virtual void clearBuffer();
 
+    // Kernel receive timestamps aren't supported on Windows; always returns
+    // false.
+    virtual bool enableTimestamps();
+
+    // Does nothing; kernel receive timestamps aren't supported on Windows.
+    virtual void getLastTimestamp(PosixTimespec& timestamp) const;
+
+    // Windows has no batched receive, so this reads a single frame into
+    // 'buffers[0]'.  'timestamps' is ignored, and 'wire_sizes[0]' gets the
+    // length read.
+    virtual int readBatch(std::uint8_t** buffers,
+                          unsigned int*  sizes,
+                          unsigned int   count,
+                          PosixTimespec* timestamps,
+                          unsigned int*  wire_sizes);
+
+    // Busy polling isn't supported on Windows; always returns false
+    virtual bool enableBusyPoll(double spin_time, int core);
+
+    // Busy polling isn't supported on Windows; always returns false
+    virtual bool disableBusyPoll();
+
+    // Windows has no batched send, so this writes one frame at a time,
+    // stopping at the first that fails
+    virtual int writeBatch(const std::uint8_t* const* buffers,
+                           const unsigned int*        sizes,
+                           unsigned int               count);
+
+    // Asks the kernel for its view of this socket.  Only the receive queue
+    // depth is available on Windows.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics);
+
 private:
 
     // Descriptor for this socket
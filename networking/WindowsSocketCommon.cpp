@@ -12,6 +12,8 @@
 
 #include "WindowsSocketCommon.hpp"
 
+#include "SocketKernelStatistics.hpp"
+
 //=============================================================================
 bool WindowsSocketCommon::enableBlocking(SOCKET socket_fd,
                                          bool&  is_blocking)
@@ -278,6 +280,25 @@ void WindowsSocketCommon::clearBuffer(SOCKET    socket_fd,
     }
 }
 
+//=============================================================================
+bool WindowsSocketCommon::getKernelStatistics(
+    SOCKET                  socket_fd,
+    SocketKernelStatistics& kernel_stats)
+{
+    kernel_stats.reset();
+
+    u_long receive_queue_bytes = 0;
+    if (ioctlsocket(socket_fd, FIONREAD, &receive_queue_bytes) != NO_ERROR)
+    {
+        printErrorMessage("WindowsSocketCommon::getKernelStatistics");
+        return false;
+    }
+
+    kernel_stats.setReceiveQueueBytes(receive_queue_bytes);
+
+    return true;
+}
+
 //=============================================================================
 void WindowsSocketCommon::shutdown(SOCKET socket_fd)
 {
@@ -7,6 +7,8 @@
 #include <cstdint>
 #include <string>
 
+class SocketKernelStatistics;
+
 namespace WindowsSocketCommon
 {
     // Enables blocking on reads and writes using the specified file descriptor.
@@ -87,6 +89,12 @@ namespace WindowsSocketCommon
                      int       class_rfa_size,
                      bool      class_ba);
 
+    // Fills in what Windows is willing to tell us about the given socket, which
+    // is only the receive queue depth.  Returns false if that couldn't be
+    // retrieved.
+    bool getKernelStatistics(SOCKET                  socket_fd,
+                             SocketKernelStatistics& kernel_stats);
+
     // Shuts the given socket down.  First traffic is stopped, then the file
     // descriptor is closed.
     void shutdown(SOCKET socket_fd);
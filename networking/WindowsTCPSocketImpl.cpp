@@ -6,6 +6,7 @@
 
 #include "WindowsTCPSocketImpl.hpp"
 
+#include "TCPSocket.hpp"
 #include "WindowsSocketCommon.hpp"
 
 //=============================================================================
@@ -103,10 +104,10 @@ bool WindowsTCPSocketImpl::bind(unsigned int& port)
 }
 
 //=============================================================================
-bool WindowsTCPSocketImpl::listen()
+bool WindowsTCPSocketImpl::listen(int backlog)
 {
     // Do the listen
-    if (::listen(socket_fd, 1) == SOCKET_ERROR)
+    if (::listen(socket_fd, backlog) == SOCKET_ERROR)
     {
         WindowsSocketCommon::printErrorMessage("WindowsTCPSocketImpl::listen");
         return false;
@@ -282,6 +283,42 @@ int WindowsTCPSocketImpl::write(const std::uint8_t* buffer, unsigned int size)
                                       is_blocking);
 }
 
+//=============================================================================
+int WindowsTCPSocketImpl::writeGather(const std::uint8_t* const* buffers,
+                                      const unsigned int*        sizes,
+                                      unsigned int               count)
+{
+    int total = 0;
+
+    if (count > TCPSocket::WRITE_GATHER_MAX)
+    {
+        count = TCPSocket::WRITE_GATHER_MAX;
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        int ret = write(buffers[i], sizes[i]);
+
+        if (ret == -1 && total == 0)
+        {
+            return -1;
+        }
+        else if (ret <= 0)
+        {
+            break;
+        }
+
+        total += ret;
+
+        if (static_cast<unsigned int>(ret) < sizes[i])
+        {
+            break;
+        }
+    }
+
+    return total;
+}
+
 //=============================================================================
 void WindowsTCPSocketImpl::clearBuffer()
 {
@@ -291,3 +328,11 @@ void WindowsTCPSocketImpl::clearBuffer()
         sizeof(sockaddr_in),
         is_blocking);
 }
+
+//=============================================================================
+bool WindowsTCPSocketImpl::getKernelStatistics(
+    SocketKernelStatistics& kernel_statistics)
+{
+    return WindowsSocketCommon::getKernelStatistics(socket_fd,
+                                                    kernel_statistics);
+}
@@ -38,8 +38,9 @@ public:
     // argument.
     virtual bool bind(unsigned int& port);
 
-    // Sets the socket's blocking/non-blocking state.
-    virtual bool listen();
+    // Tells this socket to begin listening for incoming connection attempts,
+    // queueing up to 'backlog' of them.
+    virtual bool listen(int backlog);
 
     // Accepts a connection request, should one be pending.  Used only with
     // connection-oriented protocols (like TCP).  The user can specify
@@ -70,12 +71,32 @@ public:
     // buffer.
     virtual int write(const std::uint8_t* buffer, unsigned int size);
 
+    // Writes several buffers one after the other, stopping at the first one
+    // that can't be written in full.
+    virtual int writeGather(const std::uint8_t* const* buffers,
+                            const unsigned int*        sizes,
+                            unsigned int               count);
+
     // Gets the source IP address of the last received packet
     virtual void getPeerAddress(std::string& peer_address_str) const;
 
     // Forces this socket to discard any received data.
     virtual void clearBuffer();
 
+    // Asks the kernel for its view of this socket.  Only the receive queue
+    // depth is available on Windows.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics);
+
+    // Zero-copy transmission isn't available on Windows; enableZeroCopy()
+    // always fails and every write is copied
+    virtual bool enableZeroCopy(unsigned int threshold);
+    virtual void disableZeroCopy();
+    virtual bool getLastZeroCopyId(std::uint32_t& id) const;
+    virtual int processZeroCopyCompletions();
+    virtual bool isZeroCopyComplete(std::uint32_t id) const;
+    virtual unsigned long getZeroCopyCopiedCount() const;
+
 private:
 
     // A special constructor used during accept; duplicates a socket and assumes
@@ -108,6 +129,35 @@ private:
     WindowsTCPSocketImpl& operator=(const WindowsTCPSocketImpl&);
 };
 
+inline bool WindowsTCPSocketImpl::enableZeroCopy(unsigned int threshold)
+{
+    return false;
+}
+
+inline void WindowsTCPSocketImpl::disableZeroCopy()
+{
+}
+
+inline bool WindowsTCPSocketImpl::getLastZeroCopyId(std::uint32_t& id) const
+{
+    return false;
+}
+
+inline int WindowsTCPSocketImpl::processZeroCopyCompletions()
+{
+    return 0;
+}
+
+inline bool WindowsTCPSocketImpl::isZeroCopyComplete(std::uint32_t id) const
+{
+    return false;
+}
+
+inline unsigned long WindowsTCPSocketImpl::getZeroCopyCopiedCount() const
+{
+    return 0;
+}
+
 inline
 void WindowsTCPSocketImpl::getPeerAddress(std::string& peer_address_str) const
 {
@@ -2,6 +2,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <winsock2.h>
+#include <ws2tcpip.h>
 
 #include "WindowsUDPSocketImpl.hpp"
 
@@ -10,7 +11,8 @@
 //=============================================================================
 WindowsUDPSocketImpl::WindowsUDPSocketImpl() :
     UDPSocketImpl(),
-    is_blocking(false)
+    is_blocking(false),
+    last_segment_size(0)
 {
     // Initialize the addresses to track
     memset(&local_address,  0, sizeof(sockaddr_in));
@@ -99,7 +101,7 @@ bool WindowsUDPSocketImpl::bind(unsigned int& port)
 //=============================================================================
 int WindowsUDPSocketImpl::read(std::uint8_t* buffer, unsigned int size)
 {
-    return WindowsSocketCommon::read(
+    int ret = WindowsSocketCommon::read(
         socket_fd,
         buffer,
         size,
@@ -108,6 +110,13 @@ int WindowsUDPSocketImpl::read(std::uint8_t* buffer, unsigned int size)
         reinterpret_cast<sockaddr*>(&peer_address),
         sizeof(sockaddr_in),
         is_blocking);
+
+    if (ret > 0)
+    {
+        last_segment_size = ret;
+    }
+
+    return ret;
 }
 
 //=============================================================================
@@ -145,3 +154,264 @@ void WindowsUDPSocketImpl::clearBuffer()
         sizeof(sockaddr_in),
         is_blocking);
 }
+
+//=============================================================================
+bool WindowsUDPSocketImpl::getKernelStatistics(
+    SocketKernelStatistics& kernel_statistics)
+{
+    return WindowsSocketCommon::getKernelStatistics(socket_fd,
+                                                    kernel_statistics);
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::enableTimestamps()
+{
+    return false;
+}
+
+//=============================================================================
+void WindowsUDPSocketImpl::getLastTimestamp(PosixTimespec& timestamp) const
+{
+}
+
+//=============================================================================
+int WindowsUDPSocketImpl::readBatch(std::uint8_t** buffers,
+                                    unsigned int*  sizes,
+                                    unsigned int   count,
+                                    PosixTimespec* timestamps,
+                                    unsigned int*  segment_sizes)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    int ret = read(buffers[0], sizes[0]);
+    if (ret <= 0)
+    {
+        return ret;
+    }
+
+    sizes[0] = ret;
+
+    if (segment_sizes)
+    {
+        segment_sizes[0] = ret;
+    }
+
+    return 1;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::enableBusyPoll(double spin_time, int core)
+{
+    return false;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::disableBusyPoll()
+{
+    return false;
+}
+
+//=============================================================================
+int WindowsUDPSocketImpl::writeBatch(const std::uint8_t* const* buffers,
+                                     const unsigned int*        sizes,
+                                     unsigned int               count)
+{
+    unsigned int total = 0;
+    for (; total < count; ++total)
+    {
+        int ret = write(buffers[total], sizes[total]);
+        if (ret <= 0)
+        {
+            // Report what went wrong only if nothing was written
+            return total > 0 ? static_cast<int>(total) : ret;
+        }
+    }
+
+    return total;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::enablePacing(double       rate,
+                                        unsigned int burst,
+                                        bool         kernel_pacing,
+                                        bool         tai)
+{
+    return false;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::disablePacing()
+{
+    return false;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::isKernelPacing() const
+{
+    return false;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::enableSegmentation(unsigned int segment_size)
+{
+    return false;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::disableSegmentation()
+{
+    return false;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::enableReceiveCoalescing()
+{
+    return false;
+}
+
+//=============================================================================
+unsigned int WindowsUDPSocketImpl::getLastSegmentSize() const
+{
+    return last_segment_size;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::enableAddressReuse()
+{
+    BOOL enable = TRUE;
+    return setsockopt(socket_fd,
+                      SOL_SOCKET,
+                      SO_REUSEADDR,
+                      reinterpret_cast<char*>(&enable),
+                      sizeof(enable)) == 0;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::joinGroup(const std::string& group,
+                                     const std::string& interface_name)
+{
+    ip_mreq request;
+    memset(&request, 0, sizeof(request));
+
+    if (!interface_name.empty() ||
+        inet_pton(AF_INET, group.c_str(), &request.imr_multiaddr) != 1)
+    {
+        return false;
+    }
+
+    request.imr_interface.s_addr = htonl(INADDR_ANY);
+
+    return setsockopt(socket_fd,
+                      IPPROTO_IP,
+                      IP_ADD_MEMBERSHIP,
+                      reinterpret_cast<char*>(&request),
+                      sizeof(request)) == 0;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::leaveGroup(const std::string& group,
+                                      const std::string& interface_name)
+{
+    ip_mreq request;
+    memset(&request, 0, sizeof(request));
+
+    if (!interface_name.empty() ||
+        inet_pton(AF_INET, group.c_str(), &request.imr_multiaddr) != 1)
+    {
+        return false;
+    }
+
+    request.imr_interface.s_addr = htonl(INADDR_ANY);
+
+    return setsockopt(socket_fd,
+                      IPPROTO_IP,
+                      IP_DROP_MEMBERSHIP,
+                      reinterpret_cast<char*>(&request),
+                      sizeof(request)) == 0;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::joinSourceGroup(const std::string& group,
+                                           const std::string& source,
+                                           const std::string& interface_name)
+{
+    ip_mreq_source request;
+    memset(&request, 0, sizeof(request));
+
+    if (!interface_name.empty() ||
+        inet_pton(AF_INET, group.c_str(), &request.imr_multiaddr) != 1 ||
+        inet_pton(AF_INET, source.c_str(), &request.imr_sourceaddr) != 1)
+    {
+        return false;
+    }
+
+    request.imr_interface.s_addr = htonl(INADDR_ANY);
+
+    return setsockopt(socket_fd,
+                      IPPROTO_IP,
+                      IP_ADD_SOURCE_MEMBERSHIP,
+                      reinterpret_cast<char*>(&request),
+                      sizeof(request)) == 0;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::leaveSourceGroup(const std::string& group,
+                                            const std::string& source,
+                                            const std::string& interface_name)
+{
+    ip_mreq_source request;
+    memset(&request, 0, sizeof(request));
+
+    if (!interface_name.empty() ||
+        inet_pton(AF_INET, group.c_str(), &request.imr_multiaddr) != 1 ||
+        inet_pton(AF_INET, source.c_str(), &request.imr_sourceaddr) != 1)
+    {
+        return false;
+    }
+
+    request.imr_interface.s_addr = htonl(INADDR_ANY);
+
+    return setsockopt(socket_fd,
+                      IPPROTO_IP,
+                      IP_DROP_SOURCE_MEMBERSHIP,
+                      reinterpret_cast<char*>(&request),
+                      sizeof(request)) == 0;
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::setMulticastInterface(
+    const std::string& interface_name)
+{
+    if (!interface_name.empty())
+    {
+        return false;
+    }
+
+    // An address of INADDR_ANY goes back to the default interface
+    return setIpOption(IP_MULTICAST_IF, htonl(INADDR_ANY));
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::setMulticastTtl(unsigned int ttl)
+{
+    return setIpOption(IP_MULTICAST_TTL, ttl);
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::setMulticastLoopback(bool enabled)
+{
+    return setIpOption(IP_MULTICAST_LOOP, enabled ? 1 : 0);
+}
+
+//=============================================================================
+bool WindowsUDPSocketImpl::setIpOption(int option, DWORD value)
+{
+    return setsockopt(socket_fd,
+                      IPPROTO_IP,
+                      option,
+                      reinterpret_cast<char*>(&value),
+                      sizeof(value)) == 0;
+}
@@ -54,8 +54,104 @@ public:
     // Forces this socket to discard all received data
     virtual void clearBuffer();
 
+    // Kernel receive timestamps aren't supported on Windows; always returns
+    // false.
+    virtual bool enableTimestamps();
+
+    // Does nothing; kernel receive timestamps aren't supported on Windows.
+    virtual void getLastTimestamp(PosixTimespec& timestamp) const;
+
+    // Windows has no batched receive, so this reads a single datagram into
+    // 'buffers[0]'.  'timestamps' is ignored.  Datagrams are never coalesced
+    // here, so 'segment_sizes[0]', if given, is the size of the datagram.
+    virtual int readBatch(std::uint8_t** buffers,
+                          unsigned int*  sizes,
+                          unsigned int   count,
+                          PosixTimespec* timestamps,
+                          unsigned int*  segment_sizes);
+
+    // Busy polling isn't supported on Windows; always returns false
+    virtual bool enableBusyPoll(double spin_time, int core);
+
+    // Busy polling isn't supported on Windows; always returns false
+    virtual bool disableBusyPoll();
+
+    // Windows has no batched send, so this writes one datagram at a time,
+    // stopping at the first that fails
+    virtual int writeBatch(const std::uint8_t* const* buffers,
+                           const unsigned int*        sizes,
+                           unsigned int               count);
+
+    // Pacing isn't supported on Windows; always returns false
+    virtual bool enablePacing(double       rate,
+                              unsigned int burst,
+                              bool         kernel_pacing,
+                              bool         tai);
+
+    // Pacing isn't supported on Windows; always returns false
+    virtual bool disablePacing();
+
+    // Always returns false
+    virtual bool isKernelPacing() const;
+
+    // Segmentation offload isn't supported here; always returns false
+    virtual bool enableSegmentation(unsigned int segment_size);
+
+    // Segmentation offload isn't supported here; always returns false
+    virtual bool disableSegmentation();
+
+    // Receive coalescing isn't supported here; always returns false
+    virtual bool enableReceiveCoalescing();
+
+    // Datagrams are never coalesced here, so this is the size of the last
+    // datagram read
+    virtual unsigned int getLastSegmentSize() const;
+
+    // Asks the kernel for its view of this socket.  Only the receive queue
+    // depth is available on Windows.
+    virtual bool getKernelStatistics(
+        SocketKernelStatistics& kernel_statistics);
+
+    // Sets SO_REUSEADDR so other sockets can bind the same port
+    virtual bool enableAddressReuse();
+
+    // Starts receiving datagrams sent to the given multicast group.  Windows
+    // doesn't name interfaces the way POSIX systems do, so only an empty
+    // interface name (any interface) is supported.
+    virtual bool joinGroup(const std::string& group,
+                           const std::string& interface_name);
+
+    // Stops receiving datagrams sent to the given multicast group.  Only an
+    // empty interface name is supported.
+    virtual bool leaveGroup(const std::string& group,
+                            const std::string& interface_name);
+
+    // Starts receiving datagrams sent to the given multicast group by the given
+    // source only.  Only an empty interface name is supported.
+    virtual bool joinSourceGroup(const std::string& group,
+                                 const std::string& source,
+                                 const std::string& interface_name);
+
+    // Stops receiving datagrams sent to the given multicast group by the given
+    // source.  Only an empty interface name is supported.
+    virtual bool leaveSourceGroup(const std::string& group,
+                                  const std::string& source,
+                                  const std::string& interface_name);
+
+    // Only an empty interface name (the default interface) is supported
+    virtual bool setMulticastInterface(const std::string& interface_name);
+
+    // Sets the time-to-live of outgoing multicast datagrams
+    virtual bool setMulticastTtl(unsigned int ttl);
+
+    // Sets whether outgoing multicast datagrams are looped back to this host
+    virtual bool setMulticastLoopback(bool enabled);
+
 private:
 
+    // Sets an IPPROTO_IP level option to a DWORD value
+    bool setIpOption(int option, DWORD value);
+
     // Descriptor for this socket
     SOCKET socket_fd;
 
@@ -71,6 +167,9 @@ private:
     // Whether or not this socket is in blocking mode
     bool is_blocking;
 
+    // Size of the last datagram read
+    unsigned int last_segment_size;
+
     // User-given blocking timeout length
     double blocking_timeout;
 
@@ -2,9 +2,11 @@
 #define MISC_NETWORKING_HPP
 
 #include <string>
+#include <time.h>
 
 #include "Ipv4Address.hpp"
 #include "MacAddress.hpp"
+#include "PosixTimespec.hpp"
 
 namespace miscNetworking
 {
@@ -15,6 +17,45 @@ namespace miscNetworking
     // Retrieves an IP address corresponding to the given interface name
     bool getIpv4Address(const std::string& interface_name,
                         Ipv4Address&       ipv4_address);
+
+    // Feeds the time elapsed (seconds) between each of the given kernel
+    // receive timestamps and now into 'latency', which may be an
+    // OnlineStatistics or anything else with an update(double) member
+    // function.  The clock is read once for the whole batch.  Kernel receive
+    // timestamps are taken from CLOCK_REALTIME so that's what's used here.
+    template <class Accumulator>
+    void updateReceiveLatency(const PosixTimespec* timestamps,
+                              unsigned int         count,
+                              Accumulator&         latency);
+
+    // Single-timestamp version of the above
+    template <class Accumulator>
+    void updateReceiveLatency(const PosixTimespec& timestamp,
+                              Accumulator&         latency);
+}
+
+//==============================================================================
+template <class Accumulator>
+void miscNetworking::updateReceiveLatency(const PosixTimespec* timestamps,
+                                          unsigned int         count,
+                                          Accumulator&         latency)
+{
+    timespec now_ts;
+    clock_gettime(CLOCK_REALTIME, &now_ts);
+    PosixTimespec now(now_ts);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        latency.update((now - timestamps[i]).toDouble());
+    }
+}
+
+//==============================================================================
+template <class Accumulator>
+void miscNetworking::updateReceiveLatency(const PosixTimespec& timestamp,
+                                          Accumulator&         latency)
+{
+    updateReceiveLatency(&timestamp, 1, latency);
 }
 
 #endif